@@ -4,13 +4,19 @@
 #include <theia/sfm/reconstruction.h>
 #include <theia/sfm/reconstruction_estimator_options.h>
 #include <theia/sfm/reconstruction_builder.h>
+#include <theia/sfm/tune_reconstruction_builder_options.h>
 #include <theia/matching/create_feature_matcher.h>
 #include <theia/io/read_calibration.h>
 #include <theia/io/write_ply_file.h>
 #include <theia/io/reconstruction_writer.h>
 #include <theia/util/filesystem.h>
+#include <theia/util/progress_reporter.h>
 #include <theia/util/stringprintf.h>
+#include <theia/util/threadpool.h>
 #include <theia/sfm/colorize_reconstruction.h>
+#include <condition_variable>
+#include <deque>
+#include <future>
 #include <GSLAM/core/GSLAM.h>
 #include <GSLAM/core/HashMap.h>
 
@@ -184,6 +190,11 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions(GSLAM::Svar& var) {
   ReconstructionBuilderOptions options;
   options.num_threads = var.GetInt("num_threads",1);
   options.output_matches_file = var.GetString("output_matches_file","./matches.matches");
+  options.enable_tracing = var.GetInt("enable_tracing",0);
+  options.output_trace_file = var.GetString("output_trace_file","");
+  options.max_memory_usage_in_bytes =
+      static_cast<int64_t>(var.GetInt("max_memory_usage_in_mb",0)) * 1024 * 1024;
+  options.deterministic = var.GetInt("deterministic",0);
 
   options.descriptor_type = StringToDescriptorExtractorType(var.GetString("descriptor","SIFT"));
   options.feature_density = StringToFeatureDensity(var.GetString("feature_density","NORMAL"));
@@ -224,7 +235,11 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions(GSLAM::Svar& var) {
   reconstruction_estimator_options.intrinsics_to_optimize =
     StringToOptimizeIntrinsicsType(var.GetString("intrinsics_to_optimize","NONE"));
   options.reconstruct_largest_connected_component =var.GetInt("reconstruct_largest_connected_component",0);
+  options.reconstruct_components_in_parallel =
+      var.GetInt("reconstruct_components_in_parallel",0);
   options.only_calibrated_views = var.GetInt("only_calibrated_views",0);
+  options.use_undistortion_lookup_tables =
+      var.GetInt("use_undistortion_lookup_tables",0);
   reconstruction_estimator_options.max_reprojection_error_in_pixels =
       var.GetDouble("max_reprojection_error_pixels",4.);
 
@@ -235,6 +250,8 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions(GSLAM::Svar& var) {
   // Global SfM Options.
   reconstruction_estimator_options.global_rotation_estimator_type =
       StringToRotationEstimatorType(var.GetString("global_rotation_estimator","ROBUST_L1L2"));
+  reconstruction_estimator_options.initialize_rotations_with_chordal_l2 =
+      var.GetInt("initialize_rotations_with_chordal_l2",0);
   reconstruction_estimator_options.global_position_estimator_type =
       StringToPositionEstimatorType(var.GetString("global_position_estimator","NONLINEAR"));
   reconstruction_estimator_options.num_retriangulation_iterations =
@@ -255,6 +272,16 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions(GSLAM::Svar& var) {
   reconstruction_estimator_options
       .refine_camera_positions_and_points_after_position_estimation =
       var.GetInt("refine_camera_positions_and_points_after_position_estimation",1);
+  reconstruction_estimator_options.max_num_views_per_partition =
+      var.GetInt("max_num_views_per_partition",0);
+  reconstruction_estimator_options.num_overlapping_views_per_partition =
+      var.GetInt("num_overlapping_views_per_partition",10);
+  reconstruction_estimator_options.use_position_priors =
+      var.GetInt("use_position_priors",0);
+  reconstruction_estimator_options.position_prior_weight =
+      var.GetDouble("position_prior_weight",0.1);
+  reconstruction_estimator_options.position_prior_alignment_threshold_meters =
+      var.GetDouble("position_prior_alignment_threshold",10.);
 
   // Incremental SfM Options.
   reconstruction_estimator_options
@@ -267,6 +294,9 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions(GSLAM::Svar& var) {
       var.GetDouble("full_bundle_adjustment_growth_percent",5.);
   reconstruction_estimator_options.partial_bundle_adjustment_num_views =
       var.GetInt("partial_bundle_adjustment_num_views",20);
+  reconstruction_estimator_options
+      .localize_views_in_parallel_with_known_orientation =
+      var.GetInt("localize_views_in_parallel_with_known_orientation",0);
 
   // Triangulation options (used by all SfM pipelines).
   reconstruction_estimator_options.min_triangulation_angle_degrees =
@@ -293,6 +323,11 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions(GSLAM::Svar& var) {
       var.GetInt("track_selection_image_grid_cell_size_pixels",100);
   reconstruction_estimator_options.min_num_optimized_tracks_per_view =
       var.GetInt("min_num_optimized_tracks_per_view",100);
+  reconstruction_estimator_options.subsample_tracks_before_triangulation =
+      var.GetInt("subsample_tracks_before_triangulation",0);
+  reconstruction_estimator_options
+      .max_num_tracks_per_grid_cell_before_triangulation =
+      var.GetInt("max_num_tracks_per_grid_cell_before_triangulation",2);
   return options;
 }
 
@@ -314,9 +349,27 @@ public:
         });
 
         _pubMap=messenger.advertise<GSLAM::MapPtr>("theia/map");
+
+        // Progress of every stage is published as a human readable line, e.g.
+        // "MatchImages: 120/500 (24.0%), elapsed 12.0s, remaining 38.0s".
+        // Publishing a bool to theia/cancel stops the running stage.
+        _pubProgress=messenger.advertise<std::string>("theia/progress");
+        _subCancel=messenger.subscribe("theia/cancel",[this](bool){
+            this->cancel();
+        });
+
+        _progressReporter=std::make_shared<theia::ProgressReporter>();
+        _progressReporter->SetMinCallbackIntervalInSeconds(
+                    svar.GetDouble("progress_interval",0.5));
+        _progressReporter->SetCallback(
+                    [this](const theia::ProgressReporter::Progress& progress){
+            _pubProgress.publish(ProgressToString(progress));
+        });
     }
 
     virtual ~TheiaSfM(){
+        // Stop a running reconstruction instead of waiting for it to finish.
+        cancel();
         GSLAM::WriteMutex lock(procMutex);
     }
 
@@ -324,6 +377,30 @@ public:
 
     virtual void  call(const std::string& command,void* arg=NULL){
         if(command=="finalize") finalize();
+        else if(command=="cancel") cancel();
+    }
+
+    void cancel(){
+        LOG(INFO)<<"Cancelling the reconstruction.";
+        _progressReporter->Cancel();
+    }
+
+    static std::string ProgressToString(
+            const theia::ProgressReporter::Progress& progress){
+        std::string str=progress.stage;
+        if(!progress.step.empty()) str+=" ("+progress.step+")";
+        if(progress.num_total>0){
+            str+=theia::StringPrintf(": %lld/%lld (%.1f%%)",
+                                     static_cast<long long>(progress.num_completed),
+                                     static_cast<long long>(progress.num_total),
+                                     100.0*progress.num_completed/progress.num_total);
+        }
+        str+=theia::StringPrintf(", elapsed %.1fs",progress.elapsed_time_in_seconds);
+        if(progress.estimated_remaining_time_in_seconds>=0){
+            str+=theia::StringPrintf(", remaining %.1fs",
+                                     progress.estimated_remaining_time_in_seconds);
+        }
+        return str;
     }
 
     virtual bool valid()const{return true;}
@@ -350,26 +427,62 @@ public:
 
         imageFolder=getFolderPath(imagePath);
 
+        // The options are tuned on all images once the dataset is finished.
+        if(svar.GetInt("auto_tune",0)){
+            _imagePaths.push_back(imagePath);
+            return true;
+        }
+
         if(!_reconstruction_builder)
-        {
-            const ReconstructionBuilderOptions options =SetReconstructionBuilderOptions(svar);
-            _reconstruction_builder=std::shared_ptr<theia::ReconstructionBuilder>(new theia::ReconstructionBuilder(options));
-
-            std::string FLAGS_calibration_file=svar.GetString("calibration_file","");
-            if (FLAGS_calibration_file.size() != 0) {
-              CHECK(theia::ReadCalibration(FLAGS_calibration_file,
-                                           &camera_intrinsics_prior))
-                  << "Could not read calibration file.";
-            }
+            createReconstructionBuilder(SetReconstructionBuilderOptions(svar));
+        return addImage(imagePath);
+    }
 
-            // Add images with possible calibration. When the intrinsics group id is
-            // invalid, the reconstruction builder will assume that the view does not
-            // share its intrinsics with any other views.
-            bool FLAGS_shared_calibration=svar.GetInt("shared_calibration",0);
-            if (FLAGS_shared_calibration) {
-              intrinsics_group_id = 0;
-            }
+    void createReconstructionBuilder(ReconstructionBuilderOptions options){
+        options.progress_reporter=_progressReporter;
+        options.reconstruction_callback=[this](Reconstruction* reconstruction){
+            std::unique_lock<std::mutex> lock(_componentsMutex);
+            _components.push_back(reconstruction);
+            _componentsCondition.notify_one();
+        };
+        _reconstruction_builder=std::shared_ptr<theia::ReconstructionBuilder>(new theia::ReconstructionBuilder(options));
+
+        std::string FLAGS_calibration_file=svar.GetString("calibration_file","");
+        if (FLAGS_calibration_file.size() != 0) {
+          CHECK(theia::ReadCalibration(FLAGS_calibration_file,
+                                       &camera_intrinsics_prior))
+              << "Could not read calibration file.";
+        }
+
+        // Add images with possible calibration. When the intrinsics group id is
+        // invalid, the reconstruction builder will assume that the view does not
+        // share its intrinsics with any other views.
+        bool FLAGS_shared_calibration=svar.GetInt("shared_calibration",0);
+        if (FLAGS_shared_calibration) {
+          intrinsics_group_id = 0;
+        }
+    }
+
+    // Chooses the options from short calibration passes on the collected
+    // images so that the predicted running time meets target_wall_time.
+    ReconstructionBuilderOptions tuneReconstructionBuilderOptions(){
+        ReconstructionBuilderOptions options=SetReconstructionBuilderOptions(svar);
+        theia::TuneReconstructionBuilderOptionsOptions tuning_options;
+        tuning_options.target_wall_time_in_seconds=
+                svar.GetDouble("target_wall_time",0.);
+        tuning_options.rng=options.rng;
+        theia::TuneReconstructionBuilderOptionsSummary tuning_summary;
+        if(theia::TuneReconstructionBuilderOptions(tuning_options,_imagePaths,
+                                                   &options,&tuning_summary)){
+            LOG(INFO)<<"Tuned options:\n"<<tuning_summary.ToString();
+        }
+        else{
+            LOG(WARNING)<<"Could not tune the options. Using the default options.";
         }
+        return options;
+    }
+
+    bool addImage(const std::string& imagePath){
         std::string image_filename;
         CHECK(theia::GetFilenameFromFilepath(imagePath, true, &image_filename));
 
@@ -387,8 +500,8 @@ public:
     class MapPoint : public GSLAM::MapPoint
     {
     public:
-        MapPoint(const theia::Track& track)
-            : GSLAM::MapPoint(svar.GetInt("PointID")++,hnormalized(track.Point())){
+        MapPoint(GSLAM::PointID id,const theia::Track& track)
+            : GSLAM::MapPoint(id,hnormalized(track.Point())){
             color=track.Color();
         }
 
@@ -405,8 +518,8 @@ public:
     class MapFrame : public GSLAM::MapFrame
     {
     public:
-        MapFrame(const theia::View& view)
-            :GSLAM::MapFrame(svar.GetInt("FrameID")++,0){
+        MapFrame(GSLAM::FrameID id,const theia::View& view)
+            :GSLAM::MapFrame(id,0){
             GSLAM::Point3d r=view.Camera().GetOrientationAsAngleAxis();
             GSLAM::Point3d t=view.Camera().GetPosition();
 
@@ -418,60 +531,201 @@ public:
         double _depth=-1;
     };
 
-    virtual bool finalize(){
-        GSLAM::WriteMutex lock(procMutex);
-        // Extract and match features.
-        CHECK(_reconstruction_builder->ExtractAndMatchFeatures());
-        std::vector<Reconstruction*> reconstructions;
-        CHECK(_reconstruction_builder->BuildReconstruction(&reconstructions))
-            << "Could not create a reconstruction.";
-
-        GSLAM::MapPtr map(new GSLAM::HashMap());
-        for (int i = 0; i < reconstructions.size(); i++) {
-          const std::string output_file =
-              theia::StringPrintf("%s-%d", svar.GetString("output_reconstruction","reconstruction").c_str(), i);
-          LOG(INFO) << "Writing reconstruction " << i << " to " << output_file;
-          Reconstruction& reconstruction=*reconstructions[i];
-          theia::ColorizeReconstruction(imageFolder+"/",
-                                        svar.GetInt("num_threads",1),
-                                        &reconstruction);
-          CHECK(theia::WriteReconstruction(*reconstructions[i], output_file))
-              << "Could not write reconstruction to file.";
-          CHECK(WritePlyFile(output_file+".ply",
-                             *reconstructions[i],
-                             svar.GetInt("min_num_observations_per_point",3)))
-              << "Could not write out PLY file.";
-
-          for (const TrackId track_id : reconstruction.TrackIds()) {
-            const Track& track = *reconstruction.Track(track_id);
-            if(track.NumViews()>=3)
-                map->insertMapPoint(GSLAM::PointPtr(new MapPoint(track)));
-          }
-          for (const ViewId view_id : reconstruction.ViewIds()) {
-            const View& view = *reconstruction.View(view_id);
-            if (!view.IsEstimated()) {
-              continue;
-            }
-            std::shared_ptr<MapFrame> frame(new MapFrame(view));
-            map->insertMapFrame(frame);
+    // Writes the reconstruction and its PLY file to output_file(.ply).
+    static bool writeReconstruction(const Reconstruction& reconstruction,
+                                    const std::string& output_file,
+                                    int min_num_observations_per_point){
+        LOG(INFO)<<"Writing reconstruction to "<<output_file;
+        if(!theia::WriteReconstruction(reconstruction,output_file)){
+            LOG(ERROR)<<"Could not write reconstruction to file "<<output_file;
+            return false;
+        }
+        if(!WritePlyFile(output_file+".ply",reconstruction,
+                         min_num_observations_per_point)){
+            LOG(ERROR)<<"Could not write out PLY file "<<output_file<<".ply";
+            return false;
+        }
+        return true;
+    }
 
+    // Splits the items into a few blocks per thread so that the load stays
+    // balanced when the work per item varies.
+    static int numParallelBlocks(int num_threads,int num_items){
+        return std::max(1,std::min(num_items,4*num_threads));
+    }
+
+    // Converts the reconstruction into map points and frames. The ids are
+    // reserved from the global PointID and FrameID counters once per
+    // reconstruction, and the objects and the median depths of the frames are
+    // computed in parallel.
+    static void convertReconstruction(const Reconstruction& reconstruction,
+                                      int num_threads,
+                                      std::vector<GSLAM::PointPtr>* points,
+                                      std::vector<GSLAM::FramePtr>* frames){
+        num_threads=std::max(1,num_threads);
+        std::vector<const theia::Track*> tracks;
+        tracks.reserve(reconstruction.NumTracks());
+        for(const TrackId track_id:reconstruction.TrackIds()){
+            const Track* track=reconstruction.Track(track_id);
+            if(track->NumViews()>=3) tracks.push_back(track);
+        }
+        std::vector<const theia::View*> views;
+        views.reserve(reconstruction.NumViews());
+        for(const ViewId view_id:reconstruction.ViewIds()){
+            const View* view=reconstruction.View(view_id);
+            if(view->IsEstimated()) views.push_back(view);
+        }
 
-            std::vector<TrackId> ids=view.TrackIds();
-            std::vector<double>  depths;
-            for(TrackId id:ids){
-                Eigen::Vector3d p3d=reconstruction.Track(id)->Point().hnormalized();
-                GSLAM::Point3d  p=frame->getPose().inverse()*p3d;
-                depths.push_back(p.z);
+        int& point_id=svar.GetInt("PointID");
+        int& frame_id=svar.GetInt("FrameID");
+        const GSLAM::PointID first_point_id=point_id;
+        const GSLAM::FrameID first_frame_id=frame_id;
+        point_id+=tracks.size();
+        frame_id+=views.size();
+
+        const size_t points_offset=points->size();
+        points->resize(points_offset+tracks.size());
+        theia::ParallelFor(num_threads,numParallelBlocks(num_threads,tracks.size()),
+                           tracks.size(),[&](int,int start,int end){
+            for(int i=start;i<end;i++){
+                (*points)[points_offset+i]=GSLAM::PointPtr(
+                            new MapPoint(first_point_id+i,*tracks[i]));
             }
+        });
 
-            std::sort(depths.begin(),depths.end());
+        const size_t frames_offset=frames->size();
+        frames->resize(frames_offset+views.size());
+        theia::ParallelFor(num_threads,numParallelBlocks(num_threads,views.size()),
+                           views.size(),[&](int,int start,int end){
+            std::vector<double> depths;
+            for(int i=start;i<end;i++){
+                const View& view=*views[i];
+                std::shared_ptr<MapFrame> frame(
+                            new MapFrame(first_frame_id+i,view));
+                const GSLAM::SE3 world_to_frame=frame->getPose().inverse();
+
+                depths.clear();
+                for(TrackId id:view.TrackIds()){
+                    Eigen::Vector3d p3d=reconstruction.Track(id)->Point().hnormalized();
+                    GSLAM::Point3d  p=world_to_frame*p3d;
+                    depths.push_back(p.z);
+                }
+                if(depths.size()){
+                    std::nth_element(depths.begin(),
+                                     depths.begin()+depths.size()/2,
+                                     depths.end());
+                    frame->setDepth(depths[depths.size()/2]);
+                }
+                (*frames)[frames_offset+i]=frame;
+            }
+        });
+    }
 
-            if(depths.size()) frame->setDepth(depths[depths.size()/2]);
+    virtual bool finalize(){
+        GSLAM::WriteMutex lock(procMutex);
+        // A cancellation of a previous run does not apply to this one.
+        _progressReporter->Reset();
+        if(!_imagePaths.empty()){
+            createReconstructionBuilder(tuneReconstructionBuilderOptions());
+            for(const std::string& imagePath:_imagePaths) addImage(imagePath);
+            _imagePaths.clear();
+        }
+        if(!_reconstruction_builder){
+            LOG(ERROR)<<"No images were added.";
+            return false;
+        }
+        // Extract and match features.
+        if(!_reconstruction_builder->ExtractAndMatchFeatures()){
+            LOG(WARNING)<<"Feature extraction and matching was cancelled.";
+            return false;
+        }
+        const int num_threads=svar.GetInt("num_threads",1);
+        const int min_num_observations_per_point=
+                svar.GetInt("min_num_observations_per_point",3);
+        const std::string output_reconstruction=
+                svar.GetString("output_reconstruction","reconstruction");
+        const std::string image_folder=imageFolder+"/";
+        const int preview_stride=svar.GetInt("map_preview_stride",0);
+        {
+            std::unique_lock<std::mutex> lock(_componentsMutex);
+            _components.clear();
+            _componentsDone=false;
+        }
+
+        // The builder hands every component to the callback as soon as it is
+        // estimated. A worker colorizes, writes, converts and publishes the
+        // components in this order while the builder estimates the rest.
+        // Every component is added to the same map, which is published again
+        // after each component. With map_preview_stride=N (N > 1) the frames
+        // and every N-th point of a component are published before the rest.
+        std::future<std::vector<std::future<bool> > > publisher=
+                std::async(std::launch::async,[&](){
+            std::vector<std::future<bool> > writes;
+            GSLAM::MapPtr map(new GSLAM::HashMap());
+            for(int i=0;;i++){
+                Reconstruction* reconstruction=nullptr;
+                {
+                    std::unique_lock<std::mutex> lock(_componentsMutex);
+                    _componentsCondition.wait(lock,[this](){
+                        return _componentsDone||!_components.empty();
+                    });
+                    if(_components.empty()) break;
+                    reconstruction=_components.front();
+                    _components.pop_front();
+                }
+
+                theia::ColorizeReconstruction(image_folder,num_threads,
+                                              reconstruction);
+                const std::string output_file=theia::StringPrintf(
+                            "%s-%d",output_reconstruction.c_str(),i);
+                writes.push_back(std::async(std::launch::async,[=](){
+                    return writeReconstruction(*reconstruction,output_file,
+                                               min_num_observations_per_point);
+                }));
+
+                std::vector<GSLAM::PointPtr> points;
+                std::vector<GSLAM::FramePtr> frames;
+                convertReconstruction(*reconstruction,num_threads,
+                                      &points,&frames);
+
+                for(const GSLAM::FramePtr& frame:frames)
+                    map->insertMapFrame(frame);
+                if(preview_stride>1&&
+                   points.size()>static_cast<size_t>(preview_stride)){
+                    for(size_t j=0;j<points.size();j+=preview_stride)
+                        map->insertMapPoint(points[j]);
+                    _pubMap.publish(map);
+                    for(size_t j=0;j<points.size();j++)
+                        if(j%preview_stride) map->insertMapPoint(points[j]);
+                }
+                else{
+                    for(const GSLAM::PointPtr& point:points)
+                        map->insertMapPoint(point);
+                }
+                _pubMap.publish(map);
+            }
+            return writes;
+        });
 
-          }
+        std::vector<Reconstruction*> reconstructions;
+        const bool built=
+                _reconstruction_builder->BuildReconstruction(&reconstructions);
+        {
+            std::unique_lock<std::mutex> lock(_componentsMutex);
+            _componentsDone=true;
+            _componentsCondition.notify_one();
         }
 
-        _pubMap.publish(map);
+        bool written=true;
+        for(std::future<bool>& write:publisher.get()) written&=write.get();
+        if(!built){
+            LOG(ERROR)<<"Could not create a reconstruction.";
+            return false;
+        }
+        if(!written){
+            LOG(ERROR)<<"Could not write out the reconstructions.";
+            return false;
+        }
         return true;
     }
 
@@ -481,13 +735,21 @@ public:
         camera_intrinsics_prior;
     theia::CameraIntrinsicsGroupId intrinsics_group_id =
         theia::kInvalidCameraIntrinsicsGroupId;
+    std::vector<std::string>   _imagePaths;
     std::shared_ptr<theia::ReconstructionBuilder> _reconstruction_builder;
+    std::shared_ptr<theia::ProgressReporter>      _progressReporter;
 
     std::mutex procMutex;
 
+    // Components handed over by the builder while it is still running.
+    std::mutex                   _componentsMutex;
+    std::condition_variable      _componentsCondition;
+    std::deque<Reconstruction*>  _components;
+    bool                         _componentsDone=false;
+
     GSLAM::Svar _config;
-    GSLAM::Subscriber _subDataset,_subStatus;
-    GSLAM::Publisher  _pubMap;
+    GSLAM::Subscriber _subDataset,_subStatus,_subCancel;
+    GSLAM::Publisher  _pubMap,_pubProgress;
 };
 
 int run_theia(GSLAM::Svar config){
@@ -0,0 +1,432 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+#include <gflags/gflags.h>
+#include <stdio.h>
+#include <theia/theia.h>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "applications/command_line_helpers.h"
+
+// Measures the scalability of the reconstruction pipeline without the need for
+// real imagery. A synthetic scene is generated and its two view matches are
+// input to the ReconstructionBuilder, which then estimates the reconstruction
+// with the chosen estimator. The time spent in each stage of the pipeline, the
+// peak memory usage, and the accuracy of the reconstruction w.r.t. the ground
+// truth are reported.
+//
+// Since the peak memory usage is measured for the whole process, only a single
+// configuration is run per invocation. Results may be appended to a CSV file to
+// compare configurations, e.g.:
+//
+//   for n in 100 1000 10000 50000; do
+//     for estimator in GLOBAL INCREMENTAL HYBRID; do
+//       ./bin/benchmark_synthetic_reconstruction --num_views=$n
+//           --reconstruction_estimator=$estimator --output_csv=results.csv
+//     done
+//   done
+
+// Synthetic scene options.
+DEFINE_int32(num_views, 100, "Number of views in the synthetic scene.");
+DEFINE_int32(num_points_per_view, 200,
+             "The number of 3D points in the scene is this value times the "
+             "number of views so that the density of the scene is constant.");
+DEFINE_string(point_layout, "RANDOM",
+              "Layout of the 3D points. Options are RANDOM and CITY_GRID.");
+DEFINE_string(trajectory, "LAWNMOWER",
+              "Trajectory of the cameras. Options are LAWNMOWER and ORBIT.");
+DEFINE_double(pixel_noise, 0.5,
+              "Standard deviation of the noise added to the features.");
+DEFINE_double(outlier_ratio, 0.05,
+              "Fraction of the correspondences of each view pair that are "
+              "outliers.");
+DEFINE_double(relative_rotation_noise_degrees, 0.5,
+              "Standard deviation of the noise added to relative rotations.");
+DEFINE_double(relative_translation_noise_degrees, 1.0,
+              "Standard deviation of the noise added to the direction of "
+              "relative translations.");
+DEFINE_int32(max_num_matched_views, 10,
+             "Each view is matched to at most this many other views.");
+DEFINE_int32(seed, 59, "Seed of the random number generator.");
+
+// Reconstruction options.
+DEFINE_string(reconstruction_estimator, "GLOBAL",
+              "Type of SfM reconstruction estimation to use. Options are "
+              "GLOBAL, INCREMENTAL, and HYBRID.");
+DEFINE_int32(num_threads, 1, "Number of threads to use.");
+DEFINE_string(intrinsics_to_optimize, "NONE",
+              "Set to control which intrinsics parameters are optimized during "
+              "bundle adjustment. The synthetic scene uses known calibration.");
+DEFINE_bool(enable_tracing, false,
+            "Set to true to log a detailed per-stage breakdown of the time "
+            "spent in BuildReconstruction.");
+DEFINE_string(output_trace_file, "",
+              "If tracing is enabled, the trace is written to this file in the "
+              "Chrome trace event format.");
+
+// Output options.
+DEFINE_string(output_csv, "",
+              "If set, a row with the results is appended to this file.");
+DEFINE_string(output_matches_file, "",
+              "If set, the synthetic matches are written to this file so that "
+              "they can be used with build_reconstruction.");
+DEFINE_string(output_ground_truth_reconstruction, "",
+              "If set, the ground truth reconstruction is written to this "
+              "file.");
+
+using theia::Reconstruction;
+using theia::ReconstructionBuilder;
+using theia::ReconstructionBuilderOptions;
+using theia::ReconstructionEstimatorSummary;
+using theia::SyntheticSceneOptions;
+using theia::SyntheticScenePointLayout;
+using theia::SyntheticSceneTrajectory;
+using theia::ViewId;
+
+// The results of a single run of the benchmark.
+struct BenchmarkResults {
+  double scene_generation_time = 0.0;
+  double add_matches_time = 0.0;
+  double build_reconstruction_time = 0.0;
+  ReconstructionEstimatorSummary estimator_times;
+  int64_t scene_peak_rss_bytes = 0;
+  int64_t peak_rss_bytes = 0;
+
+  int num_views = 0;
+  int num_view_pairs = 0;
+  int num_reconstructions = 0;
+  int num_estimated_views = 0;
+  int num_estimated_tracks = 0;
+  double median_rotation_error_degrees = 0.0;
+  double median_position_error = 0.0;
+  double mean_position_error = 0.0;
+};
+
+SyntheticScenePointLayout StringToPointLayout(const std::string& layout) {
+  if (layout == "RANDOM") {
+    return SyntheticScenePointLayout::RANDOM;
+  } else if (layout == "CITY_GRID") {
+    return SyntheticScenePointLayout::CITY_GRID;
+  }
+  LOG(FATAL) << "Invalid point layout: " << layout;
+  return SyntheticScenePointLayout::RANDOM;
+}
+
+SyntheticSceneTrajectory StringToTrajectory(const std::string& trajectory) {
+  if (trajectory == "LAWNMOWER") {
+    return SyntheticSceneTrajectory::LAWNMOWER;
+  } else if (trajectory == "ORBIT") {
+    return SyntheticSceneTrajectory::ORBIT;
+  }
+  LOG(FATAL) << "Invalid trajectory: " << trajectory;
+  return SyntheticSceneTrajectory::LAWNMOWER;
+}
+
+SyntheticSceneOptions SetSyntheticSceneOptions() {
+  SyntheticSceneOptions options;
+  options.rng = std::make_shared<theia::RandomNumberGenerator>(FLAGS_seed);
+  options.point_layout = StringToPointLayout(FLAGS_point_layout);
+  options.trajectory = StringToTrajectory(FLAGS_trajectory);
+  options.num_views = FLAGS_num_views;
+  options.num_points = FLAGS_num_points_per_view * FLAGS_num_views;
+  options.pixel_noise = FLAGS_pixel_noise;
+  options.outlier_ratio = FLAGS_outlier_ratio;
+  options.relative_rotation_noise_degrees =
+      FLAGS_relative_rotation_noise_degrees;
+  options.relative_translation_noise_degrees =
+      FLAGS_relative_translation_noise_degrees;
+  options.max_num_matched_views = FLAGS_max_num_matched_views;
+  return options;
+}
+
+ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
+  ReconstructionBuilderOptions options;
+  options.rng = std::make_shared<theia::RandomNumberGenerator>(FLAGS_seed);
+  options.num_threads = FLAGS_num_threads;
+  options.enable_tracing = FLAGS_enable_tracing;
+  options.output_trace_file = FLAGS_output_trace_file;
+  options.reconstruction_estimator_options.rng = options.rng;
+  options.reconstruction_estimator_options.num_threads = FLAGS_num_threads;
+  options.reconstruction_estimator_options.reconstruction_estimator_type =
+      StringToReconstructionEstimatorType(FLAGS_reconstruction_estimator);
+  options.reconstruction_estimator_options.intrinsics_to_optimize =
+      StringToOptimizeIntrinsicsType(FLAGS_intrinsics_to_optimize);
+  return options;
+}
+
+double Median(std::vector<double>* values) {
+  if (values->empty()) {
+    return 0.0;
+  }
+  std::nth_element(values->begin(),
+                   values->begin() + values->size() / 2,
+                   values->end());
+  return (*values)[values->size() / 2];
+}
+
+// Aligns the reconstruction to the ground truth and computes the errors of the
+// camera poses.
+void EvaluateAccuracy(const Reconstruction& ground_truth,
+                      Reconstruction* reconstruction,
+                      BenchmarkResults* results) {
+  theia::AlignReconstructions(ground_truth, reconstruction);
+
+  std::vector<double> rotation_errors, position_errors;
+  for (const ViewId view_id : reconstruction->ViewIds()) {
+    const theia::View* view = reconstruction->View(view_id);
+    const ViewId ground_truth_view_id =
+        ground_truth.ViewIdFromName(view->Name());
+    if (!view->IsEstimated() || ground_truth_view_id == theia::kInvalidViewId) {
+      continue;
+    }
+
+    const theia::Camera& camera = view->Camera();
+    const theia::Camera& ground_truth_camera =
+        ground_truth.View(ground_truth_view_id)->Camera();
+    const Eigen::Matrix3d relative_rotation =
+        camera.GetOrientationAsRotationMatrix() *
+        ground_truth_camera.GetOrientationAsRotationMatrix().transpose();
+    rotation_errors.emplace_back(theia::RadToDeg(
+        Eigen::AngleAxisd(relative_rotation).angle()));
+    position_errors.emplace_back(
+        (camera.GetPosition() - ground_truth_camera.GetPosition()).norm());
+  }
+
+  if (position_errors.empty()) {
+    return;
+  }
+  results->mean_position_error =
+      std::accumulate(position_errors.begin(), position_errors.end(), 0.0) /
+      position_errors.size();
+  results->median_rotation_error_degrees = Median(&rotation_errors);
+  results->median_position_error = Median(&position_errors);
+}
+
+void PrintResults(const BenchmarkResults& results) {
+  const ReconstructionEstimatorSummary& times = results.estimator_times;
+  // Everything in BuildReconstruction that is not part of the estimation, i.e.,
+  // building the tracks and splitting off estimated reconstructions.
+  const double other_time =
+      results.build_reconstruction_time - times.total_time;
+  const std::string message = theia::StringPrintf(
+      "\nSynthetic reconstruction benchmark (%s, %d views, %d view pairs, "
+      "%d threads):"
+      "\n\tScene generation time = %.3f s"
+      "\n\tAdd matches time = %.3f s"
+      "\n\tTrack building and other time = %.3f s"
+      "\n\tCamera intrinsics calibration time = %.3f s"
+      "\n\tPose estimation time = %.3f s"
+      "\n\tTriangulation time = %.3f s"
+      "\n\tBundle adjustment time = %.3f s"
+      "\n\tTotal reconstruction time = %.3f s"
+      "\n\tPeak RSS after scene generation = %.1f MB"
+      "\n\tPeak RSS = %.1f MB"
+      "\n\tNum reconstructions = %d"
+      "\n\tNum estimated views in largest reconstruction = %d"
+      "\n\tNum estimated tracks in largest reconstruction = %d"
+      "\n\tMedian rotation error = %.4f degrees"
+      "\n\tMedian position error = %.4f m"
+      "\n\tMean position error = %.4f m",
+      FLAGS_reconstruction_estimator.c_str(),
+      results.num_views,
+      results.num_view_pairs,
+      FLAGS_num_threads,
+      results.scene_generation_time,
+      results.add_matches_time,
+      other_time,
+      times.camera_intrinsics_calibration_time,
+      times.pose_estimation_time,
+      times.triangulation_time,
+      times.bundle_adjustment_time,
+      results.add_matches_time + results.build_reconstruction_time,
+      results.scene_peak_rss_bytes / (1024.0 * 1024.0),
+      results.peak_rss_bytes / (1024.0 * 1024.0),
+      results.num_reconstructions,
+      results.num_estimated_views,
+      results.num_estimated_tracks,
+      results.median_rotation_error_degrees,
+      results.median_position_error,
+      results.mean_position_error);
+  LOG(INFO) << message;
+
+  if (FLAGS_output_csv.empty()) {
+    return;
+  }
+  const bool write_header = !theia::FileExists(FLAGS_output_csv);
+  FILE* file = fopen(FLAGS_output_csv.c_str(), "a");
+  CHECK(file != nullptr) << "Could not open " << FLAGS_output_csv;
+  if (write_header) {
+    fprintf(file,
+            "estimator,trajectory,point_layout,num_views,num_view_pairs,"
+            "num_threads,scene_generation_time,add_matches_time,other_time,"
+            "calibration_time,pose_estimation_time,triangulation_time,"
+            "bundle_adjustment_time,total_time,scene_peak_rss_mb,peak_rss_mb,"
+            "num_reconstructions,num_estimated_views,num_estimated_tracks,"
+            "median_rotation_error_degrees,median_position_error,"
+            "mean_position_error\n");
+  }
+  fprintf(file,
+          "%s,%s,%s,%d,%d,%d,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%d,%d,%f,%f,%f\n",
+          FLAGS_reconstruction_estimator.c_str(),
+          FLAGS_trajectory.c_str(),
+          FLAGS_point_layout.c_str(),
+          results.num_views,
+          results.num_view_pairs,
+          FLAGS_num_threads,
+          results.scene_generation_time,
+          results.add_matches_time,
+          other_time,
+          times.camera_intrinsics_calibration_time,
+          times.pose_estimation_time,
+          times.triangulation_time,
+          times.bundle_adjustment_time,
+          results.add_matches_time + results.build_reconstruction_time,
+          results.scene_peak_rss_bytes / (1024.0 * 1024.0),
+          results.peak_rss_bytes / (1024.0 * 1024.0),
+          results.num_reconstructions,
+          results.num_estimated_views,
+          results.num_estimated_tracks,
+          results.median_rotation_error_degrees,
+          results.median_position_error,
+          results.mean_position_error);
+  fclose(file);
+}
+
+int main(int argc, char* argv[]) {
+  THEIA_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+
+  BenchmarkResults results;
+  theia::Timer timer;
+
+  // Generate the synthetic scene.
+  std::vector<std::string> view_names;
+  std::vector<theia::CameraIntrinsicsPrior> camera_intrinsics_priors;
+  std::vector<theia::ImagePairMatch> matches;
+  Reconstruction ground_truth;
+  theia::GenerateSyntheticScene(SetSyntheticSceneOptions(),
+                                &view_names,
+                                &camera_intrinsics_priors,
+                                &matches,
+                                &ground_truth);
+  results.scene_generation_time = timer.ElapsedTimeInSeconds();
+  results.scene_peak_rss_bytes = theia::PeakResidentSetSizeInBytes();
+  results.num_views = view_names.size();
+  results.num_view_pairs = matches.size();
+
+  if (!FLAGS_output_matches_file.empty()) {
+    CHECK(theia::WriteMatchesAndGeometry(FLAGS_output_matches_file,
+                                         view_names,
+                                         camera_intrinsics_priors,
+                                         matches))
+        << "Could not write the matches to " << FLAGS_output_matches_file;
+  }
+  if (!FLAGS_output_ground_truth_reconstruction.empty()) {
+    CHECK(theia::WriteReconstruction(ground_truth,
+                                     FLAGS_output_ground_truth_reconstruction))
+        << "Could not write the ground truth reconstruction to "
+        << FLAGS_output_ground_truth_reconstruction;
+  }
+
+  // Add the views and matches to the reconstruction builder.
+  timer.Reset();
+  ReconstructionBuilder reconstruction_builder(
+      SetReconstructionBuilderOptions());
+  for (int i = 0; i < view_names.size(); i++) {
+    CHECK(reconstruction_builder.AddImageWithCameraIntrinsicsPrior(
+        view_names[i], camera_intrinsics_priors[i]));
+  }
+  for (const theia::ImagePairMatch& match : matches) {
+    CHECK(reconstruction_builder.AddTwoViewMatch(match.image1,
+                                                 match.image2,
+                                                 match));
+  }
+  results.add_matches_time = timer.ElapsedTimeInSeconds();
+
+  // Free the matches since the reconstruction builder has its own copy.
+  std::vector<theia::ImagePairMatch>().swap(matches);
+
+  // Estimate the reconstruction.
+  timer.Reset();
+  std::vector<Reconstruction*> reconstructions;
+  std::vector<ReconstructionEstimatorSummary> summaries;
+  const bool success =
+      reconstruction_builder.BuildReconstruction(&reconstructions, &summaries);
+  results.build_reconstruction_time = timer.ElapsedTimeInSeconds();
+  results.peak_rss_bytes = theia::PeakResidentSetSizeInBytes();
+  if (!success) {
+    LOG(WARNING) << "Could not create a reconstruction.";
+  }
+
+  for (const ReconstructionEstimatorSummary& summary : summaries) {
+    ReconstructionEstimatorSummary& times = results.estimator_times;
+    times.camera_intrinsics_calibration_time +=
+        summary.camera_intrinsics_calibration_time;
+    times.pose_estimation_time += summary.pose_estimation_time;
+    times.triangulation_time += summary.triangulation_time;
+    times.bundle_adjustment_time += summary.bundle_adjustment_time;
+    times.total_time += summary.total_time;
+  }
+
+  // Evaluate the accuracy of the largest reconstruction.
+  results.num_reconstructions = reconstructions.size();
+  Reconstruction* largest_reconstruction = nullptr;
+  for (Reconstruction* reconstruction : reconstructions) {
+    if (largest_reconstruction == nullptr ||
+        reconstruction->NumViews() > largest_reconstruction->NumViews()) {
+      largest_reconstruction = reconstruction;
+    }
+  }
+  if (largest_reconstruction != nullptr) {
+    results.num_estimated_views = largest_reconstruction->NumViews();
+    results.num_estimated_tracks = largest_reconstruction->NumTracks();
+    EvaluateAccuracy(ground_truth, largest_reconstruction, &results);
+  }
+
+  PrintResults(results);
+
+  for (Reconstruction* reconstruction : reconstructions) {
+    delete reconstruction;
+  }
+  return 0;
+}
@@ -57,6 +57,12 @@ DEFINE_string(
     output_reconstruction, "",
     "Filename to write reconstruction to. The filename will be appended with "
     "the reconstruction number if multiple reconstructions are created.");
+DEFINE_bool(enable_tracing, false,
+            "Set to true to log the time spent in each stage of the pipeline "
+            "along with counters such as RANSAC iterations.");
+DEFINE_string(output_trace_file, "",
+              "If tracing is enabled, the trace is written to this file in the "
+              "Chrome trace event format (viewable with chrome://tracing).");
 
 // Multithreading.
 DEFINE_int32(num_threads, 1,
@@ -84,6 +90,22 @@ DEFINE_int32(matching_max_num_images_in_cache, 128,
              "Maximum number of images to store in the LRU cache during "
              "feature matching. The higher this number is the more memory is "
              "consumed during matching.");
+DEFINE_int64(max_memory_usage_in_mb, 0,
+             "Approximate memory budget for feature matching and track "
+             "building in megabytes. Set to 0 for no limit.");
+DEFINE_bool(deterministic, false,
+            "Set to true to make feature matching and translation filtering "
+            "independent of the number of threads and repeatable across runs. "
+            "The full reconstruction is only repeatable with one thread.");
+DEFINE_bool(auto_tune, false,
+            "Set to true to choose the feature cache capacity, geometric "
+            "verification, and bundle adjustment schedule from short "
+            "calibration passes on a sample of the images. Only used when "
+            "reconstructing from images.");
+DEFINE_double(target_wall_time_in_seconds, 0.0,
+              "If auto tuning, the options are chosen so that the predicted "
+              "running time is below this value. Set to 0 to only tune the "
+              "memory related options.");
 DEFINE_double(lowes_ratio, 0.8, "Lowes ratio used for feature matching.");
 DEFINE_double(max_sampson_error_for_verified_match, 4.0,
               "Maximum sampson error for a match to be considered "
@@ -106,6 +128,13 @@ DEFINE_bool(reconstruct_largest_connected_component, false,
             "If set to true, only the single largest connected component is "
             "reconstructed. Otherwise, as many models as possible are "
             "estimated.");
+DEFINE_bool(reconstruct_components_in_parallel, false,
+            "If set to true, the connected components of the view graph are "
+            "reconstructed concurrently.");
+DEFINE_bool(use_undistortion_lookup_tables, false,
+            "If set to true, pixels are undistorted with precomputed lookup "
+            "tables instead of iteratively. This is faster for fisheye and "
+            "other strongly distorted lenses.");
 DEFINE_bool(shared_calibration, false,
             "Set to true if all camera intrinsic parameters should be shared "
             "as a single set of intrinsics. This is useful, for instance, if "
@@ -127,6 +156,9 @@ DEFINE_double(max_reprojection_error_pixels, 4.0,
 // Global SfM options.
 DEFINE_string(global_rotation_estimator, "ROBUST_L1L2",
               "Type of global rotation estimation to use for global SfM.");
+DEFINE_bool(initialize_rotations_with_chordal_l2, false,
+            "Initialize global rotation estimation with chordal L2 rotation "
+            "averaging instead of the maximum spanning tree.");
 DEFINE_string(global_position_estimator, "NONLINEAR",
               "Type of global position estimation to use for global SfM.");
 DEFINE_bool(refine_relative_translations_after_rotation_estimation, true,
@@ -149,6 +181,22 @@ DEFINE_bool(refine_camera_positions_and_points_after_position_estimation, true,
             "intrinsics and rotations constant. This often improves the "
             "stability of bundle adjustment when the camera intrinsics are "
             "inaccurate.");
+DEFINE_int32(max_num_views_per_partition, 0,
+             "If greater than 0, global SfM reconstructs the camera poses of "
+             "overlapping partitions of the view graph with at most this many "
+             "views in parallel and merges them before bundle adjustment. "
+             "Values below 10 are raised to 10.");
+DEFINE_int32(num_overlapping_views_per_partition, 10,
+             "Number of views shared by neighboring view graph partitions.");
+DEFINE_bool(use_position_priors, false,
+            "Use the GPS or position priors of the views to initialize global "
+            "position estimation and as residuals in bundle adjustment.");
+DEFINE_double(position_prior_weight, 0.1,
+              "Weight of the position prior residuals in bundle adjustment, "
+              "roughly the inverse of the prior noise in meters.");
+DEFINE_double(position_prior_alignment_threshold, 10.0,
+              "RANSAC inlier threshold in meters for aligning the estimated "
+              "camera positions to the position priors.");
 DEFINE_int32(num_retriangulation_iterations, 1,
              "Number of times to retriangulate any unestimated tracks. Bundle "
              "adjustment is performed after retriangulation.");
@@ -176,6 +224,10 @@ DEFINE_double(full_bundle_adjustment_growth_percent, 5.0,
 DEFINE_int32(partial_bundle_adjustment_num_views, 20,
              "When full BA is not being run, partial BA is executed on a "
              "constant number of views specified by this parameter.");
+DEFINE_bool(localize_views_in_parallel_with_known_orientation, false,
+            "Hybrid SfM localizes the candidate views of each round in "
+            "parallel with their known orientations and runs a single bundle "
+            "adjustment per round.");
 
 // Triangulation options.
 DEFINE_double(min_triangulation_angle_degrees, 4.0,
@@ -215,6 +267,13 @@ DEFINE_int32(track_selection_image_grid_cell_size_pixels, 100,
 DEFINE_int32(min_num_optimized_tracks_per_view, 100,
              "When track subsampling is enabled, tracks are selected such that "
              "each view observes a minimum number of optimized tracks.");
+DEFINE_bool(subsample_tracks_before_triangulation, false,
+            "Global SfM only triangulates and bundle adjusts the best "
+            "connected tracks in each image grid cell. The remaining tracks "
+            "are triangulated after the final bundle adjustment.");
+DEFINE_int32(max_num_tracks_per_grid_cell_before_triangulation, 2,
+             "Number of tracks kept in each image grid cell when subsampling "
+             "tracks before triangulation.");
 
 using theia::Reconstruction;
 using theia::ReconstructionBuilder;
@@ -227,6 +286,11 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
   ReconstructionBuilderOptions options;
   options.num_threads = FLAGS_num_threads;
   options.output_matches_file = FLAGS_output_matches_file;
+  options.enable_tracing = FLAGS_enable_tracing;
+  options.output_trace_file = FLAGS_output_trace_file;
+  options.max_memory_usage_in_bytes =
+      FLAGS_max_memory_usage_in_mb * 1024 * 1024;
+  options.deterministic = FLAGS_deterministic;
 
   options.descriptor_type = StringToDescriptorExtractorType(FLAGS_descriptor);
   options.feature_density = StringToFeatureDensity(FLAGS_feature_density);
@@ -268,7 +332,11 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
     StringToOptimizeIntrinsicsType(FLAGS_intrinsics_to_optimize);
   options.reconstruct_largest_connected_component =
       FLAGS_reconstruct_largest_connected_component;
+  options.reconstruct_components_in_parallel =
+      FLAGS_reconstruct_components_in_parallel;
   options.only_calibrated_views = FLAGS_only_calibrated_views;
+  options.use_undistortion_lookup_tables =
+      FLAGS_use_undistortion_lookup_tables;
   reconstruction_estimator_options.max_reprojection_error_in_pixels =
       FLAGS_max_reprojection_error_pixels;
 
@@ -279,6 +347,8 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
   // Global SfM Options.
   reconstruction_estimator_options.global_rotation_estimator_type =
       StringToRotationEstimatorType(FLAGS_global_rotation_estimator);
+  reconstruction_estimator_options.initialize_rotations_with_chordal_l2 =
+      FLAGS_initialize_rotations_with_chordal_l2;
   reconstruction_estimator_options.global_position_estimator_type =
       StringToPositionEstimatorType(FLAGS_global_position_estimator);
   reconstruction_estimator_options.num_retriangulation_iterations =
@@ -299,6 +369,16 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
   reconstruction_estimator_options
       .refine_camera_positions_and_points_after_position_estimation =
       FLAGS_refine_camera_positions_and_points_after_position_estimation;
+  reconstruction_estimator_options.max_num_views_per_partition =
+      FLAGS_max_num_views_per_partition;
+  reconstruction_estimator_options.num_overlapping_views_per_partition =
+      FLAGS_num_overlapping_views_per_partition;
+  reconstruction_estimator_options.use_position_priors =
+      FLAGS_use_position_priors;
+  reconstruction_estimator_options.position_prior_weight =
+      FLAGS_position_prior_weight;
+  reconstruction_estimator_options.position_prior_alignment_threshold_meters =
+      FLAGS_position_prior_alignment_threshold;
 
   // Incremental SfM Options.
   reconstruction_estimator_options
@@ -311,6 +391,9 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
       FLAGS_full_bundle_adjustment_growth_percent;
   reconstruction_estimator_options.partial_bundle_adjustment_num_views =
       FLAGS_partial_bundle_adjustment_num_views;
+  reconstruction_estimator_options
+      .localize_views_in_parallel_with_known_orientation =
+      FLAGS_localize_views_in_parallel_with_known_orientation;
 
   // Triangulation options (used by all SfM pipelines).
   reconstruction_estimator_options.min_triangulation_angle_degrees =
@@ -337,6 +420,11 @@ ReconstructionBuilderOptions SetReconstructionBuilderOptions() {
       FLAGS_track_selection_image_grid_cell_size_pixels;
   reconstruction_estimator_options.min_num_optimized_tracks_per_view =
       FLAGS_min_num_optimized_tracks_per_view;
+  reconstruction_estimator_options.subsample_tracks_before_triangulation =
+      FLAGS_subsample_tracks_before_triangulation;
+  reconstruction_estimator_options
+      .max_num_tracks_per_grid_cell_before_triangulation =
+      FLAGS_max_num_tracks_per_grid_cell_before_triangulation;
   return options;
 }
 
@@ -459,8 +547,24 @@ int main(int argc, char *argv[]) {
   CHECK_GT(FLAGS_output_reconstruction.size(), 0)
       << "Must specify a filepath to output the reconstruction.";
 
-  const ReconstructionBuilderOptions options =
-      SetReconstructionBuilderOptions();
+  ReconstructionBuilderOptions options = SetReconstructionBuilderOptions();
+  if (FLAGS_auto_tune && FLAGS_matches_file.size() == 0 &&
+      FLAGS_images.size() != 0) {
+    std::vector<std::string> image_files;
+    CHECK(theia::GetFilepathsFromWildcard(FLAGS_images, &image_files))
+        << "Could not find images that matched the filepath: " << FLAGS_images;
+    theia::TuneReconstructionBuilderOptionsOptions tuning_options;
+    tuning_options.target_wall_time_in_seconds =
+        FLAGS_target_wall_time_in_seconds;
+    tuning_options.rng = options.rng;
+    theia::TuneReconstructionBuilderOptionsSummary tuning_summary;
+    if (theia::TuneReconstructionBuilderOptions(tuning_options, image_files,
+                                                &options, &tuning_summary)) {
+      LOG(INFO) << "Tuned options:\n" << tuning_summary.ToString();
+    } else {
+      LOG(WARNING) << "Could not tune the options. Using the default options.";
+    }
+  }
 
   ReconstructionBuilder reconstruction_builder(options);
   // If matches are provided, load matches otherwise load images.
@@ -317,7 +317,7 @@ int main(int argc, char *argv[]) {
 
     // Print the final reconstruction statistics so the user may assess the
     // quality of the calibration.
-    PrintReprojectionErrors(*reconstructions[0]);
+    PrintReprojectionErrors(*reconstructions[0], FLAGS_num_threads);
     PrintTrackLengthHistogram(*reconstructions[0]);
 
     // Print the output camera parameters.
@@ -44,6 +44,8 @@
 #include "print_reconstruction_statistics.h"
 
 DEFINE_string(reconstruction, "", "Reconstruction file");
+DEFINE_int32(num_threads, 1,
+             "Number of threads used to compute the reprojection errors.");
 
 int main(int argc, char* argv[]) {
   google::InitGoogleLogging(argv[0]);
@@ -60,7 +62,7 @@ int main(int argc, char* argv[]) {
             << "\nNum 3D points: " << reconstruction->NumTracks();
 
   // Check that the reprojection errors are sane.
-  PrintReprojectionErrors(*reconstruction);
+  PrintReprojectionErrors(*reconstruction, FLAGS_num_threads);
 
   // Compute track length statistics.
   PrintTrackLengthHistogram(*reconstruction);
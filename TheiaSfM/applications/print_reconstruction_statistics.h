@@ -40,30 +40,32 @@
 #include <theia/theia.h>
 
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <string>
 #include <vector>
 
 inline void PrintReprojectionErrors(
-    const theia::Reconstruction& reconstruction) {
+    const theia::Reconstruction& reconstruction, const int num_threads) {
+  // Compute the reprojection error of every observation in parallel.
+  theia::TrackReprojectionStatisticsOptions options;
+  options.num_threads = num_threads;
+  std::vector<theia::TrackReprojectionStatistics> statistics;
   std::vector<double> reprojection_errors;
-  int num_projections_behind_camera = 0;
-  for (const theia::TrackId track_id : reconstruction.TrackIds()) {
-    const theia::Track* track = CHECK_NOTNULL(reconstruction.Track(track_id));
-    for (const theia::ViewId view_id : track->ViewIds()) {
-      const theia::Feature* feature =
-        reconstruction.View(view_id)->GetFeature(track_id);
-
-      // Reproject the observations.
-      Eigen::Vector2d projection;
-      if (reconstruction.View(view_id)
-              ->Camera().ProjectPoint(track->Point(), &projection) < 0) {
-        ++num_projections_behind_camera;
-      }
+  theia::ComputeTrackReprojectionStatistics(options,
+                                            reconstruction,
+                                            reconstruction.TrackIds(),
+                                            &statistics,
+                                            &reprojection_errors);
+  for (double& reprojection_error : reprojection_errors) {
+    reprojection_error = std::sqrt(reprojection_error);
+  }
 
-      // Compute reprojection error.
-      const double reprojection_error = (*feature - projection).norm();
-      reprojection_errors.emplace_back(reprojection_error);
-    }
+  int num_projections_behind_camera = 0;
+  for (const theia::TrackReprojectionStatistics& track_statistics :
+       statistics) {
+    num_projections_behind_camera +=
+        track_statistics.num_observations_behind_camera;
   }
 
   if (reprojection_errors.size() == 0) {
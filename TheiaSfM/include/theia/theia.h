@@ -81,7 +81,9 @@
 #include "theia/math/constrained_l1_solver.h"
 #include "theia/math/distribution.h"
 #include "theia/math/find_polynomial_roots_companion_matrix.h"
+#include "theia/math/find_polynomial_roots_fixed_degree.h"
 #include "theia/math/find_polynomial_roots_jenkins_traub.h"
+#include "theia/math/find_polynomial_roots_sturm.h"
 #include "theia/math/graph/connected_components.h"
 #include "theia/math/graph/minimum_spanning_tree.h"
 #include "theia/math/graph/normalized_graph_cut.h"
@@ -106,6 +108,7 @@
 #include "theia/sfm/bundle_adjustment/create_loss_function.h"
 #include "theia/sfm/bundle_adjustment/optimize_relative_position_with_known_rotation.h"
 #include "theia/sfm/bundle_adjustment/orthogonal_vector_error.h"
+#include "theia/sfm/bundle_adjustment/position_prior_error.h"
 #include "theia/sfm/bundle_adjustment/unit_norm_three_vector_parameterization.h"
 #include "theia/sfm/camera/camera.h"
 #include "theia/sfm/camera/camera_intrinsics_model.h"
@@ -118,6 +121,7 @@
 #include "theia/sfm/camera/pinhole_radial_tangential_camera_model.h"
 #include "theia/sfm/camera/projection_matrix_utils.h"
 #include "theia/sfm/camera/reprojection_error.h"
+#include "theia/sfm/camera/undistortion_lookup_table.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
 #include "theia/sfm/colorize_reconstruction.h"
 #include "theia/sfm/estimate_track.h"
@@ -151,6 +155,7 @@
 #include "theia/sfm/global_pose_estimation/linear_rotation_estimator.h"
 #include "theia/sfm/global_pose_estimation/nonlinear_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/nonlinear_rotation_estimator.h"
+#include "theia/sfm/global_pose_estimation/orientations_from_chordal_l2.h"
 #include "theia/sfm/global_pose_estimation/pairwise_rotation_error.h"
 #include "theia/sfm/global_pose_estimation/pairwise_translation_and_scale_error.h"
 #include "theia/sfm/global_pose_estimation/pairwise_translation_error.h"
@@ -161,6 +166,7 @@
 #include "theia/sfm/gps_converter.h"
 #include "theia/sfm/incremental_reconstruction_estimator.h"
 #include "theia/sfm/localize_view_to_reconstruction.h"
+#include "theia/sfm/memory_accounting.h"
 #include "theia/sfm/pose/dls_impl.h"
 #include "theia/sfm/pose/dls_pnp.h"
 #include "theia/sfm/pose/eight_point_fundamental_matrix.h"
@@ -182,6 +188,7 @@
 #include "theia/sfm/pose/two_point_pose_partial_rotation.h"
 #include "theia/sfm/pose/util.h"
 #include "theia/sfm/pose_error.h"
+#include "theia/sfm/position_priors.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/reconstruction_builder.h"
 #include "theia/sfm/reconstruction_estimator.h"
@@ -191,20 +198,25 @@
 #include "theia/sfm/set_camera_intrinsics_from_priors.h"
 #include "theia/sfm/set_outlier_tracks_to_unestimated.h"
 #include "theia/sfm/similarity_transformation.h"
+#include "theia/sfm/synthetic_scene.h"
 #include "theia/sfm/track.h"
 #include "theia/sfm/track_builder.h"
+#include "theia/sfm/track_reprojection_statistics.h"
 #include "theia/sfm/transformation/align_point_clouds.h"
 #include "theia/sfm/transformation/align_reconstructions.h"
 #include "theia/sfm/transformation/align_rotations.h"
 #include "theia/sfm/transformation/gdls_similarity_transform.h"
+#include "theia/sfm/transformation/merge_reconstructions.h"
 #include "theia/sfm/transformation/transform_reconstruction.h"
 #include "theia/sfm/triangulation/triangulation.h"
+#include "theia/sfm/tune_reconstruction_builder_options.h"
 #include "theia/sfm/two_view_match_geometric_verification.h"
 #include "theia/sfm/twoview_info.h"
 #include "theia/sfm/types.h"
 #include "theia/sfm/undistort_image.h"
 #include "theia/sfm/view.h"
 #include "theia/sfm/view_graph/orientations_from_maximum_spanning_tree.h"
+#include "theia/sfm/view_graph/partition_view_graph.h"
 #include "theia/sfm/view_graph/remove_disconnected_view_pairs.h"
 #include "theia/sfm/view_graph/view_graph.h"
 #include "theia/sfm/visibility_pyramid.h"
@@ -229,12 +241,15 @@
 #include "theia/util/hash.h"
 #include "theia/util/lru_cache.h"
 #include "theia/util/map_util.h"
+#include "theia/util/memory_usage.h"
 #include "theia/util/mutable_priority_queue.h"
+#include "theia/util/progress_reporter.h"
 #include "theia/util/random.h"
 #include "theia/util/string.h"
 #include "theia/util/stringprintf.h"
 #include "theia/util/threadpool.h"
 #include "theia/util/timer.h"
+#include "theia/util/trace.h"
 #include "theia/util/util.h"
 
 #endif  // THEIA_THEIA_H_
@@ -0,0 +1,137 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "theia/matching/cascade_hasher.h"
+#include "theia/matching/indexed_feature_match.h"
+#include "theia/test/benchmark.h"
+#include "theia/util/random.h"
+
+namespace theia {
+namespace {
+
+using Eigen::VectorXf;
+
+static const int kNumDescriptorDimensions = 128;
+static const float kDescriptorNoise = 0.05;
+
+// Generates a pair of images with num_descriptors unit norm SIFT-like
+// descriptors each. The descriptors of the second image are noisy, shuffled
+// copies of the first so that most features have a true match. A fixed seed
+// is used so that every run of the benchmark uses the same data.
+void GenerateDescriptorPair(const int num_descriptors,
+                            std::vector<VectorXf>* descriptors1,
+                            std::vector<VectorXf>* descriptors2) {
+  RandomNumberGenerator rng(59);
+  descriptors1->resize(num_descriptors);
+  descriptors2->resize(num_descriptors);
+  for (int i = 0; i < num_descriptors; i++) {
+    VectorXf& descriptor = (*descriptors1)[i];
+    descriptor.resize(kNumDescriptorDimensions);
+    for (int j = 0; j < kNumDescriptorDimensions; j++) {
+      descriptor(j) = static_cast<float>(rng.RandDouble(0.0, 1.0));
+    }
+    descriptor.normalize();
+  }
+
+  std::vector<int> permutation(num_descriptors);
+  for (int i = 0; i < num_descriptors; i++) {
+    permutation[i] = i;
+  }
+  for (int i = num_descriptors - 1; i > 0; i--) {
+    std::swap(permutation[i], permutation[rng.RandInt(0, i)]);
+  }
+
+  for (int i = 0; i < num_descriptors; i++) {
+    VectorXf& descriptor = (*descriptors2)[i];
+    descriptor = (*descriptors1)[permutation[i]];
+    for (int j = 0; j < kNumDescriptorDimensions; j++) {
+      descriptor(j) += kDescriptorNoise * rng.RandGaussian(0.0, 1.0);
+    }
+    descriptor.normalize();
+  }
+}
+
+// Matches a pair of images with the given number of features. Hashing the
+// descriptors is done once per image by the cascade hashing matcher, so only
+// the matching is timed here. Throughput is reported in image pairs per second.
+void BM_CascadeHasherMatchImages(benchmark::State& state) {
+  std::vector<VectorXf> descriptors1, descriptors2;
+  GenerateDescriptorPair(state.range(0), &descriptors1, &descriptors2);
+
+  CascadeHasher cascade_hasher(std::make_shared<RandomNumberGenerator>(59));
+  CHECK(cascade_hasher.Initialize(kNumDescriptorDimensions));
+  const HashedImage hashed_image1 =
+      cascade_hasher.CreateHashedSiftDescriptors(descriptors1);
+  const HashedImage hashed_image2 =
+      cascade_hasher.CreateHashedSiftDescriptors(descriptors2);
+
+  std::vector<IndexedFeatureMatch> matches;
+  while (state.KeepRunning()) {
+    matches.clear();
+    cascade_hasher.MatchImages(hashed_image1, descriptors1,
+                               hashed_image2, descriptors2,
+                               0.8, &matches);
+    benchmark::DoNotOptimize(matches.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(std::to_string(matches.size()) + " matches");
+}
+BENCHMARK(BM_CascadeHasherMatchImages)->Arg(1000)->Arg(4000)->Arg(16000);
+
+// Hashing the descriptors of a single image.
+void BM_CascadeHasherCreateHashedSiftDescriptors(benchmark::State& state) {
+  std::vector<VectorXf> descriptors1, descriptors2;
+  GenerateDescriptorPair(state.range(0), &descriptors1, &descriptors2);
+
+  CascadeHasher cascade_hasher(std::make_shared<RandomNumberGenerator>(59));
+  CHECK(cascade_hasher.Initialize(kNumDescriptorDimensions));
+  while (state.KeepRunning()) {
+    const HashedImage hashed_image =
+        cascade_hasher.CreateHashedSiftDescriptors(descriptors1);
+    benchmark::DoNotOptimize(hashed_image.hashed_desc.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CascadeHasherCreateHashedSiftDescriptors)->Arg(1000)->Arg(4000);
+
+}  // namespace
+}  // namespace theia
@@ -49,6 +49,7 @@
 #include "theia/matching/indexed_feature_match.h"
 #include "theia/util/lru_cache.h"
 #include "theia/util/map_util.h"
+#include "theia/util/random.h"
 #include "theia/util/threadpool.h"
 #include "theia/util/util.h"
 
@@ -89,7 +90,14 @@ void CascadeHashingFeatureMatcher::InitializeCascadeHasher(
     int descriptor_dimension) {
   // Initialize the cascade hasher if needed.
   if (cascade_hasher_.get() == nullptr && descriptor_dimension > 0) {
-    cascade_hasher_.reset(new CascadeHasher());
+    // The hash projections are random, so they must be seeded for the matches
+    // to be deterministic.
+    if (options_.deterministic) {
+      cascade_hasher_.reset(new CascadeHasher(
+          std::make_shared<RandomNumberGenerator>(deterministic_seed_)));
+    } else {
+      cascade_hasher_.reset(new CascadeHasher());
+    }
     CHECK(cascade_hasher_->Initialize(descriptor_dimension))
         << "Could not initialize the cascade hasher.";
   }
@@ -103,10 +111,8 @@ void CascadeHashingFeatureMatcher::AddImage(
   // cache.
   FeatureMatcher::AddImage(image, keypoints, descriptors);
 
-  if (cascade_hasher_.get() == nullptr && descriptors.size() > 0) {
-    cascade_hasher_.reset(new CascadeHasher());
-    CHECK(cascade_hasher_->Initialize(descriptors[0].size()))
-        << "Could not initialize the cascade hasher.";
+  if (descriptors.size() > 0) {
+    InitializeCascadeHasher(descriptors[0].size());
   }
 
   // Create the hashing information.
@@ -126,10 +132,8 @@ void CascadeHashingFeatureMatcher::AddImage(
   // cache.
   FeatureMatcher::AddImage(image, keypoints, descriptors, intrinsics);
 
-  if (cascade_hasher_.get() == nullptr && descriptors.size() > 0) {
-    cascade_hasher_.reset(new CascadeHasher());
-    CHECK(cascade_hasher_->Initialize(descriptors[0].size()))
-        << "Could not initialize the cascade hasher.";
+  if (descriptors.size() > 0) {
+    InitializeCascadeHasher(descriptors[0].size());
   }
 
   // Create the hashing information.
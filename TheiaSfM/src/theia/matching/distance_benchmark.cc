@@ -0,0 +1,85 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <vector>
+
+#include "theia/matching/distance.h"
+#include "theia/test/benchmark.h"
+#include "theia/util/random.h"
+
+namespace theia {
+namespace {
+
+using Eigen::VectorXf;
+
+static const int kNumDescriptors = 1024;
+
+// Generates unit norm descriptors of the given dimension with a fixed seed.
+std::vector<VectorXf> GenerateDescriptors(const int num_dimensions) {
+  RandomNumberGenerator rng(59);
+  std::vector<VectorXf> descriptors(kNumDescriptors);
+  for (VectorXf& descriptor : descriptors) {
+    descriptor.resize(num_dimensions);
+    for (int i = 0; i < num_dimensions; i++) {
+      descriptor(i) = static_cast<float>(rng.RandDouble(0.0, 1.0));
+    }
+    descriptor.normalize();
+  }
+  return descriptors;
+}
+
+// Computes the distance from one descriptor to all others, which is the inner
+// loop of brute force matching. Throughput is reported in descriptor pairs per
+// second.
+void BM_L2(benchmark::State& state) {
+  const std::vector<VectorXf> descriptors = GenerateDescriptors(state.range(0));
+  const L2 distance;
+  int i = 0;
+  while (state.KeepRunning()) {
+    const VectorXf& query = descriptors[i++ % kNumDescriptors];
+    float min_distance = distance(query, descriptors[0]);
+    for (int j = 1; j < kNumDescriptors; j++) {
+      min_distance = std::min(min_distance, distance(query, descriptors[j]));
+    }
+    benchmark::DoNotOptimize(min_distance);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumDescriptors);
+}
+BENCHMARK(BM_L2)->Arg(64)->Arg(128);
+
+}  // namespace
+}  // namespace theia
@@ -36,11 +36,17 @@
 
 #include <glog/logging.h>
 
+#include <cereal/archives/portable_binary.hpp>
+#include <stdio.h>
+
 #include <algorithm>
+#include <fstream>  // NOLINT
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -53,17 +59,21 @@
 #include "theia/matching/image_pair_match.h"
 #include "theia/matching/keypoints_and_descriptors.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/memory_accounting.h"
 #include "theia/sfm/two_view_match_geometric_verification.h"
 #include "theia/util/filesystem.h"
 #include "theia/util/lru_cache.h"
 #include "theia/util/map_util.h"
+#include "theia/util/progress_reporter.h"
+#include "theia/util/random.h"
 #include "theia/util/threadpool.h"
+#include "theia/util/trace.h"
 #include "theia/util/util.h"
 
 namespace theia {
 
 FeatureMatcher::FeatureMatcher(const FeatureMatcherOptions& options)
-    : options_(options) {
+    : options_(options), matches_size_in_bytes_(0), deterministic_seed_(0) {
   if (options_.match_out_of_core) {
     CHECK_GT(options_.cache_capacity, 2)
         << "The cache capacity must be greater than 2 in order to perform out "
@@ -79,7 +89,29 @@ FeatureMatcher::FeatureMatcher(const FeatureMatcherOptions& options)
   } else {
     // If we want to perform all-in-memory matching then set the cache size to
     // the maximum.
+    CHECK_EQ(options_.max_matches_size_in_bytes, 0)
+        << "Spilling matches to disk requires out of core matching.";
     options_.cache_capacity = std::numeric_limits<int>::max();
+    options_.max_cache_size_in_bytes = 0;
+  }
+
+  // In deterministic mode each image pair reseeds the verification rng from a
+  // base seed, so the rng must exist and be shared by all pairs.
+  if (options_.deterministic) {
+#ifndef THEIA_HAS_THREAD_LOCAL_KEYWORD
+    LOG(WARNING) << "Deterministic matching requires thread-local random "
+                    "number generators, which are not supported by this "
+                    "compiler. The matches may still depend on the threads.";
+#endif  // THEIA_HAS_THREAD_LOCAL_KEYWORD
+    std::shared_ptr<RandomNumberGenerator>& rng =
+        options_.geometric_verification_options.estimate_twoview_info_options
+            .rng;
+    if (rng == nullptr) {
+      rng = std::make_shared<RandomNumberGenerator>(deterministic_seed_);
+    } else {
+      deterministic_seed_ = static_cast<unsigned>(
+          rng->RandInt(0, std::numeric_limits<int>::max()));
+    }
   }
 
   // Because the function that defines how the cache fetches features from disk
@@ -94,8 +126,21 @@ FeatureMatcher::FeatureMatcher(const FeatureMatcherOptions& options)
   // Initialize the LRU cache. NOTE: even though the Fetch method will be set up
   // to retreive files from disk, it will only do so if
   // options_.match_out_of_core is set to true.
-  keypoints_and_descriptors_cache_.reset(new KeypointAndDescriptorCache(
-      fetch_features_from_cache, options_.cache_capacity));
+  if (options_.max_cache_size_in_bytes > 0) {
+    const std::function<int64_t(const std::shared_ptr<KeypointsAndDescriptors>&)>
+        features_size_in_bytes =
+            [](const std::shared_ptr<KeypointsAndDescriptors>& features) {
+              return EstimateMemoryUsage(*features);
+            };
+    keypoints_and_descriptors_cache_.reset(
+        new KeypointAndDescriptorCache(fetch_features_from_cache,
+                                       options_.cache_capacity,
+                                       features_size_in_bytes,
+                                       options_.max_cache_size_in_bytes));
+  } else {
+    keypoints_and_descriptors_cache_.reset(new KeypointAndDescriptorCache(
+        fetch_features_from_cache, options_.cache_capacity));
+  }
 }
 
 void FeatureMatcher::AddImage(const std::string& image_name,
@@ -180,6 +225,7 @@ void FeatureMatcher::SetImagePairsToMatch(
 }
 
 void FeatureMatcher::MatchImages(std::vector<ImagePairMatch>* matches) {
+  ScopedTraceSpan span("MatchImages");
   // If SetImagePairsToMatch has not been called, match all image-to-image
   // pairs.
   if (pairs_to_match_.size() == 0) {
@@ -188,6 +234,11 @@ void FeatureMatcher::MatchImages(std::vector<ImagePairMatch>* matches) {
         image_names_.size() * (image_names_.size() - 1) / 2;
     matches->reserve(num_pairs_to_match);
 
+    // Images may have been added by several threads in any order.
+    if (options_.deterministic) {
+      std::sort(image_names_.begin(), image_names_.end());
+    }
+
     pairs_to_match_.reserve(num_pairs_to_match);
     // Create a list of all possible image pairs.
     for (int i = 0; i < image_names_.size(); i++) {
@@ -202,8 +253,14 @@ void FeatureMatcher::MatchImages(std::vector<ImagePairMatch>* matches) {
   // sort of like OpenMP's dynamic schedule in that it is able to balance
   // threads fairly efficiently.
   const int num_matches = pairs_to_match_.size();
+  const int num_cache_hits = keypoints_and_descriptors_cache_->NumCacheHits();
+  const int num_cache_misses =
+      keypoints_and_descriptors_cache_->NumCacheMisses();
   const int num_threads =
       std::min(options_.num_threads, static_cast<int>(num_matches));
+  if (options_.progress_reporter != nullptr) {
+    options_.progress_reporter->BeginStage("MatchImages", num_matches);
+  }
   std::unique_ptr<ThreadPool> pool(new ThreadPool(num_threads));
   const int interval_step =
       std::min(this->kMaxThreadingStepSize_, num_matches / num_threads);
@@ -218,6 +275,34 @@ void FeatureMatcher::MatchImages(std::vector<ImagePairMatch>* matches) {
   // Wait for all threads to finish.
   pool.reset(nullptr);
 
+  if (!spilled_matches_files_.empty()) {
+    ReadSpilledMatchesFromDisk(matches);
+  }
+
+  // Order the matches by their image names rather than by the order in which
+  // the threads completed them.
+  if (options_.deterministic) {
+    std::sort(matches->begin(),
+              matches->end(),
+              [](const ImagePairMatch& lhs, const ImagePairMatch& rhs) {
+                return std::tie(lhs.image1, lhs.image2) <
+                       std::tie(rhs.image1, rhs.image2);
+              });
+  }
+
+  if (options_.progress_reporter != nullptr &&
+      options_.progress_reporter->IsCancelled()) {
+    LOG(INFO) << "Matching was cancelled after matching " << matches->size()
+              << " image pairs.";
+  }
+
+  IncrementTraceCounter("image_pairs_verified", matches->size());
+  IncrementTraceCounter(
+      "feature_cache_hits",
+      keypoints_and_descriptors_cache_->NumCacheHits() - num_cache_hits);
+  IncrementTraceCounter(
+      "feature_cache_misses",
+      keypoints_and_descriptors_cache_->NumCacheMisses() - num_cache_misses);
   VLOG(1) << "Matched " << matches->size() << " image pairs out of "
           << num_matches << " possible image pairs.";
 }
@@ -226,74 +311,171 @@ void FeatureMatcher::MatchAndVerifyImagePairs(
     const int start_index,
     const int end_index,
     std::vector<ImagePairMatch>* matches) {
+  ProgressReporter* progress_reporter = options_.progress_reporter.get();
   for (int i = start_index; i < end_index; i++) {
-    const std::string image1_name = pairs_to_match_[i].first;
-    const std::string image2_name = pairs_to_match_[i].second;
-
-    // Match the image pair. If the pair fails to match then continue to the
-    // next match.
-    ImagePairMatch image_pair_match;
-    image_pair_match.image1 = image1_name;
-    image_pair_match.image2 = image2_name;
-
-    // Get the keypoints and descriptors from the cache. By using a shared_ptr
-    // here we ensure that keypoints and descriptors will live in the cache as
-    // long as they are currently being used in a matching thread, so the cache
-    // will never evict these entries while they are still being used.
-    std::shared_ptr<KeypointsAndDescriptors> features1 =
-        keypoints_and_descriptors_cache_->Fetch(
-            FeatureFilenameFromImage(image1_name));
-    features1->image_name = image1_name;
-    std::shared_ptr<KeypointsAndDescriptors> features2 =
-        keypoints_and_descriptors_cache_->Fetch(
-            FeatureFilenameFromImage(image2_name));
-    features2->image_name = image2_name;
-
-    // Compute the visual matches from feature descriptors.
-    std::vector<IndexedFeatureMatch> putative_matches;
-    if (!MatchImagePair(*features1, *features2, &putative_matches)) {
-      VLOG(2)
-          << "Could not match a sufficient number of features between images "
-          << image1_name << " and " << image2_name;
-      continue;
+    if (progress_reporter != nullptr && progress_reporter->IsCancelled()) {
+      return;
     }
+    MatchAndVerifyImagePair(i, matches);
+    if (progress_reporter != nullptr) {
+      progress_reporter->Increment();
+    }
+  }
+}
 
-    // Perform geometric verification if applicable.
-    if (options_.perform_geometric_verification) {
-      // If geometric verification fails, do not add the match to the output.
-      if (!GeometricVerification(
-              *features1, *features2, putative_matches, &image_pair_match)) {
-        VLOG(2) << "Geometric verification between images " << image1_name
-                << " and " << image2_name << " failed.";
-        continue;
-      }
-    } else {
-      // If no geometric verification is performed then the putative matches are
-      // output.
-      image_pair_match.correspondences.reserve(putative_matches.size());
-      for (int i = 0; i < putative_matches.size(); i++) {
-        const Keypoint& keypoint1 =
-            features1->keypoints[putative_matches[i].feature1_ind];
-        const Keypoint& keypoint2 =
-            features2->keypoints[putative_matches[i].feature2_ind];
-        image_pair_match.correspondences.emplace_back(
-            Feature(keypoint1.x(), keypoint1.y()),
-            Feature(keypoint2.x(), keypoint2.y()));
+void FeatureMatcher::MatchAndVerifyImagePair(
+    const int index, std::vector<ImagePairMatch>* matches) {
+  ScopedTraceSpan span("MatchAndVerifyImagePair");
+  const std::string image1_name = pairs_to_match_[index].first;
+  const std::string image2_name = pairs_to_match_[index].second;
+
+  // Reseed the random number generator of this thread so that the random
+  // numbers used for this pair do not depend on which thread verifies it or on
+  // the pairs that thread verified before.
+  if (options_.deterministic) {
+    options_.geometric_verification_options.estimate_twoview_info_options.rng
+        ->Seed(DeriveSeed(deterministic_seed_, index));
+  }
+
+  // Match the image pair. If the pair fails to match then it is not added to
+  // the output.
+  ImagePairMatch image_pair_match;
+  image_pair_match.image1 = image1_name;
+  image_pair_match.image2 = image2_name;
+
+  // Get the keypoints and descriptors from the cache. By using a shared_ptr
+  // here we ensure that keypoints and descriptors will live in the cache as
+  // long as they are currently being used in a matching thread, so the cache
+  // will never evict these entries while they are still being used.
+  std::shared_ptr<KeypointsAndDescriptors> features1 =
+      keypoints_and_descriptors_cache_->Fetch(
+          FeatureFilenameFromImage(image1_name));
+  features1->image_name = image1_name;
+  std::shared_ptr<KeypointsAndDescriptors> features2 =
+      keypoints_and_descriptors_cache_->Fetch(
+          FeatureFilenameFromImage(image2_name));
+  features2->image_name = image2_name;
+
+  // Compute the visual matches from feature descriptors.
+  std::vector<IndexedFeatureMatch> putative_matches;
+  if (!MatchImagePair(*features1, *features2, &putative_matches)) {
+    VLOG(2)
+        << "Could not match a sufficient number of features between images "
+        << image1_name << " and " << image2_name;
+    return;
+  }
+  IncrementTraceCounter("image_pairs_matched");
+  IncrementTraceCounter("putative_matches", putative_matches.size());
+
+  // Perform geometric verification if applicable.
+  if (options_.perform_geometric_verification) {
+    // If geometric verification fails, do not add the match to the output.
+    if (!GeometricVerification(
+            *features1, *features2, putative_matches, &image_pair_match)) {
+      VLOG(2) << "Geometric verification between images " << image1_name
+              << " and " << image2_name << " failed.";
+      return;
+    }
+  } else {
+    // If no geometric verification is performed then the putative matches are
+    // output.
+    image_pair_match.correspondences.reserve(putative_matches.size());
+    for (int i = 0; i < putative_matches.size(); i++) {
+      const Keypoint& keypoint1 =
+          features1->keypoints[putative_matches[i].feature1_ind];
+      const Keypoint& keypoint2 =
+          features2->keypoints[putative_matches[i].feature2_ind];
+      image_pair_match.correspondences.emplace_back(
+          Feature(keypoint1.x(), keypoint1.y()),
+          Feature(keypoint2.x(), keypoint2.y()));
+    }
+  }
+
+  // Log information about the matching results.
+  VLOG(1) << "Images " << image1_name << " and " << image2_name
+          << " were matched with " << image_pair_match.correspondences.size()
+          << " verified matches and "
+          << image_pair_match.twoview_info.num_homography_inliers
+          << " homography matches out of " << putative_matches.size()
+          << " putative matches.";
+  // When the matches exceed the budget they are moved out while holding the
+  // lock and written to disk afterwards so that the other threads do not wait
+  // on the disk.
+  std::vector<ImagePairMatch> matches_to_spill;
+  std::string spilled_matches_file;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    matches->push_back(image_pair_match);
+    if (options_.max_matches_size_in_bytes > 0) {
+      matches_size_in_bytes_ +=
+          sizeof(ImagePairMatch) + EstimateMemoryUsage(matches->back());
+      if (matches_size_in_bytes_ > options_.max_matches_size_in_bytes) {
+        spilled_matches_file = NextSpilledMatchesFile();
+        VLOG(1) << "Spilling " << matches->size() << " matches ("
+                << matches_size_in_bytes_ / (1024 * 1024) << " MB) to "
+                << spilled_matches_file;
+        matches_to_spill.swap(*matches);
+        matches_size_in_bytes_ = 0;
       }
     }
+  }
+  if (!matches_to_spill.empty()) {
+    SpillMatchesToDisk(spilled_matches_file, matches_to_spill);
+  }
+}
+
+std::string FeatureMatcher::NextSpilledMatchesFile() {
+  std::string output_dir = options_.keypoints_and_descriptors_output_dir;
+  if (output_dir.back() != '/') {
+    output_dir = output_dir + "/";
+  }
+  const std::string spilled_matches_file =
+      output_dir + "spilled_matches_" +
+      std::to_string(spilled_matches_files_.size()) + ".bin";
+  spilled_matches_files_.emplace_back(spilled_matches_file);
+  return spilled_matches_file;
+}
 
-    // Log information about the matching results.
-    VLOG(1) << "Images " << image1_name << " and " << image2_name
-            << " were matched with " << image_pair_match.correspondences.size()
-            << " verified matches and "
-            << image_pair_match.twoview_info.num_homography_inliers
-            << " homography matches out of " << putative_matches.size()
-            << " putative matches.";
+void FeatureMatcher::SpillMatchesToDisk(
+    const std::string& spilled_matches_file,
+    const std::vector<ImagePairMatch>& matches) {
+  std::ofstream writer(spilled_matches_file,
+                       std::ios::out | std::ios::binary);
+  CHECK(writer.is_open()) << "Could not open " << spilled_matches_file
+                          << " for spilling matches to disk.";
+  cereal::PortableBinaryOutputArchive output_archive(writer);
+  output_archive(matches);
+  IncrementTraceCounter("matches_spilled_to_disk", matches.size());
+}
+
+void FeatureMatcher::ReadSpilledMatchesFromDisk(
+    std::vector<ImagePairMatch>* matches) {
+  // The features are stored on disk so they can be dropped to make room for
+  // the matches.
+  keypoints_and_descriptors_cache_->Clear();
+
+  std::vector<ImagePairMatch> unspilled_matches;
+  unspilled_matches.swap(*matches);
+  for (const std::string& spilled_matches_file : spilled_matches_files_) {
+    std::vector<ImagePairMatch> spilled_matches;
     {
-      std::lock_guard<std::mutex> lock(mutex_);
-      matches->push_back(image_pair_match);
+      std::ifstream reader(spilled_matches_file,
+                           std::ios::in | std::ios::binary);
+      CHECK(reader.is_open()) << "Could not read the spilled matches from "
+                              << spilled_matches_file;
+      cereal::PortableBinaryInputArchive input_archive(reader);
+      input_archive(spilled_matches);
     }
+    remove(spilled_matches_file.c_str());
+    matches->insert(matches->end(),
+                    std::make_move_iterator(spilled_matches.begin()),
+                    std::make_move_iterator(spilled_matches.end()));
   }
+  matches->insert(matches->end(),
+                  std::make_move_iterator(unspilled_matches.begin()),
+                  std::make_move_iterator(unspilled_matches.end()));
+  spilled_matches_files_.clear();
+  matches_size_in_bytes_ = 0;
 }
 
 bool FeatureMatcher::GeometricVerification(
@@ -301,6 +483,7 @@ bool FeatureMatcher::GeometricVerification(
     const KeypointsAndDescriptors& features2,
     const std::vector<IndexedFeatureMatch>& putative_matches,
     ImagePairMatch* image_pair_match) {
+  ScopedTraceSpan span("GeometricVerification");
   const CameraIntrinsicsPrior intrinsics1 = FindWithDefault(
       intrinsics_, features1.image_name, CameraIntrinsicsPrior());
   const CameraIntrinsicsPrior intrinsics2 = FindWithDefault(
@@ -141,6 +141,11 @@ class FeatureMatcher {
                                         const int end_index,
                                         std::vector<ImagePairMatch>* matches);
 
+  // Matches and verifies a single pair of pairs_to_match_. The match is added
+  // to the output only if it passes matching and geometric verification.
+  void MatchAndVerifyImagePair(const int index,
+                               std::vector<ImagePairMatch>* matches);
+
   // Performs geometric verification. By making this a virtual method, derived
   // classes may implement custom verification methods (e.g., if rotations are
   // known then custom solvers can be used to solve for only the relative
@@ -159,6 +164,20 @@ class FeatureMatcher {
   // Returns the filepath of the feature file given the image name.
   std::string FeatureFilenameFromImage(const std::string& image);
 
+  // Returns the path of a new file in the features directory for spilled
+  // matches and records it. This method is not thread-safe and must be called
+  // while holding mutex_.
+  std::string NextSpilledMatchesFile();
+
+  // Writes the matches to the spilled matches file. This is called without
+  // holding mutex_ so that other threads keep matching during the write.
+  void SpillMatchesToDisk(const std::string& spilled_matches_file,
+                          const std::vector<ImagePairMatch>& matches);
+
+  // Clears the feature cache then reads all spilled matches back from disk and
+  // adds them to the matches.
+  void ReadSpilledMatchesFromDisk(std::vector<ImagePairMatch>* matches);
+
   // Each Threadpool worker will perform matching on this many image pairs.  It
   // is more efficient to let each thread compute multiple matches at a time
   // than add each matching task to the pool. This is sort of like OpenMP's
@@ -179,6 +198,15 @@ class FeatureMatcher {
   std::vector<std::pair<std::string, std::string> > pairs_to_match_;
   std::mutex mutex_;
 
+  // The estimated size of the matches held in memory and the files that the
+  // matches have been spilled to. See max_matches_size_in_bytes.
+  int64_t matches_size_in_bytes_;
+  std::vector<std::string> spilled_matches_files_;
+
+  // The base seed of the random streams of each image pair in deterministic
+  // mode.
+  unsigned deterministic_seed_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(FeatureMatcher);
 };
@@ -35,9 +35,12 @@
 #ifndef THEIA_MATCHING_FEATURE_MATCHER_OPTIONS_H_
 #define THEIA_MATCHING_FEATURE_MATCHER_OPTIONS_H_
 
+#include <stdint.h>
+#include <memory>
 #include <string>
 
 #include "theia/sfm/two_view_match_geometric_verification.h"
+#include "theia/util/progress_reporter.h"
 
 namespace theia {
 
@@ -63,6 +66,20 @@ struct FeatureMatcherOptions {
   // perform image-to-image matching.
   int cache_capacity = 128;
 
+  // If greater than 0, the cache additionally holds at most this many bytes of
+  // keypoints and descriptors. This bounds the memory of the cache regardless
+  // of how many features each image has. It is only used for out-of-core
+  // matching since the evicted features must be read back from disk.
+  int64_t max_cache_size_in_bytes = 0;
+
+  // If greater than 0, the verified matches are written to disk in
+  // keypoints_and_descriptors_output_dir whenever the matches held in memory
+  // exceed this many bytes. The spilled matches are read back once all image
+  // pairs are matched and the feature cache has been cleared, so features and
+  // matches are never held in memory at the same time beyond the budgets. This
+  // requires out-of-core matching.
+  int64_t max_matches_size_in_bytes = 0;
+
   // Only symmetric matches are kept.
   bool keep_only_symmetric_matches = true;
 
@@ -85,6 +102,18 @@ struct FeatureMatcherOptions {
   // Only images that contain more feature matches than this number will be
   // returned.
   int min_num_feature_matches = 30;
+
+  // If true, the output does not depend on the number of threads or on thread
+  // scheduling: all image pairs are matched in the order of the image names,
+  // the random numbers used to verify each pair are drawn from a stream seeded
+  // by the index of the pair, and the matches are sorted by image names. The
+  // streams are derived from a seed drawn from the geometric verification rng,
+  // which should be seeded for the results to be reproducible across runs.
+  bool deterministic = false;
+
+  // If set, the matching progress is reported for each image pair and matching
+  // stops early (returning the pairs matched so far) when it is cancelled.
+  std::shared_ptr<ProgressReporter> progress_reporter;
 };
 
 }  // namespace theia
@@ -40,6 +40,7 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "theia/math/matrix/sparse_cholesky_llt.h"
 #include "theia/util/stringprintf.h"
@@ -52,12 +53,15 @@ ConstrainedL1Solver::ConstrainedL1Solver(
     const Eigen::VectorXd& b,
     const Eigen::SparseMatrix<double>& geq_mat,
     const Eigen::VectorXd& geq_vec)
-    : options_(options),
-      num_l1_residuals_(b.size()),
-      num_inequality_constraints_(geq_vec.size()) {
+    : options_(options), num_l1_residuals_(0), num_inequality_constraints_(0) {
+  CHECK_GT(options_.rho, 0.0);
+  CHECK_GT(options_.penalty_residual_ratio, 1.0);
+  CHECK_GT(options_.penalty_scale, 1.0);
   CHECK_EQ(A.cols(), geq_mat.cols());
   CHECK_EQ(A.rows(), b.rows());
   CHECK_EQ(geq_mat.rows(), geq_vec.rows());
+  num_l1_residuals_ = b.size();
+  num_inequality_constraints_ = geq_vec.size();
 
   // Allocate matrix A.
   A_.resize(A.rows() + geq_mat.rows(), A.cols());
@@ -81,7 +85,7 @@ ConstrainedL1Solver::ConstrainedL1Solver(
 
   Eigen::SparseMatrix<double> spd_mat(A.cols(), A.cols());
   spd_mat.selfadjointView<Eigen::Upper>().rankUpdate(A_.transpose());
-
+  spd_mat.makeCompressed();
   linear_solver_.Compute(spd_mat);
   CHECK_EQ(linear_solver_.Info(), Eigen::Success);
 
@@ -109,13 +113,25 @@ ConstrainedL1Solver::ConstrainedL1Solver(
 // where A = [B;C] and d=[b;c] (where ; is the "stack" operation like matlab)
 // This can now be solved in the same form as the L1 minimization, with a
 // slightly different z update.
-void ConstrainedL1Solver::Solve(Eigen::VectorXd* solution) {
-  CHECK_NOTNULL(solution)->resize(A_.cols());
-  Eigen::VectorXd& x = *solution;
+ConstrainedL1Solver::Summary ConstrainedL1Solver::Solve(
+    Eigen::VectorXd* solution) {
+  CHECK_NOTNULL(solution);
+  Summary summary;
   Eigen::VectorXd z(A_.rows()), u(A_.rows());
-  z.setZero();
   u.setZero();
 
+  // Warm start from the given solution by setting z to the feasible residuals
+  // of the solution. The first x-update then returns the given solution.
+  if (solution->size() == A_.cols()) {
+    z.noalias() = A_ * (*solution) - b_;
+    z.tail(num_inequality_constraints_) =
+        z.tail(num_inequality_constraints_).cwiseMax(0.0);
+  } else {
+    solution->setZero(A_.cols());
+    z.setZero();
+  }
+  Eigen::VectorXd& x = *solution;
+
   Eigen::VectorXd a_times_x(A_.rows()), z_old(z.size()), ax_hat(A_.rows());
   // Precompute some convergence terms.
   const double rhs_norm = b_.norm();
@@ -124,18 +140,19 @@ void ConstrainedL1Solver::Solve(Eigen::VectorXd* solution) {
   const double dual_abs_tolerance_eps =
       std::sqrt(A_.cols()) * options_.absolute_tolerance;
   VLOG(2) << "Iteration   R norm          S norm          Primal eps      "
-             "Dual eps";
+             "Dual eps        Rho";
   const std::string row_format =
-      "  % 4d     % 4.4e     % 4.4e     % 4.4e     % 4.4e";
+      "  % 4d     % 4.4e     % 4.4e     % 4.4e     % 4.4e     % 4.4e";
 
-  // qp_options.max_num_iterations = 100;
+  double rho = options_.rho;
+  summary.iterations.reserve(options_.max_num_iterations);
   for (int i = 0; i < options_.max_num_iterations; i++) {
     x.noalias() = linear_solver_.Solve(A_.transpose() * (b_ + z - u));
 
     if (linear_solver_.Info() != Eigen::Success) {
       LOG(ERROR) << "L1 Minimization failed. Could not solve the sparse "
                     "linear system with Cholesky Decomposition";
-      return;
+      return summary;
     }
 
     a_times_x.noalias() = A_ * x;
@@ -144,34 +161,66 @@ void ConstrainedL1Solver::Solve(Eigen::VectorXd* solution) {
 
     // Update z and set z_old.
     std::swap(z, z_old);
-    z.noalias() = ModifiedShrinkage(ax_hat - b_ + u, 1.0 / options_.rho);
+    ModifiedShrinkage(ax_hat - b_ + u, 1.0 / rho, &z);
 
     // Update u.
     u.noalias() += ax_hat - z - b_;
 
     // Compute the convergence terms.
-    const double r_norm = (a_times_x - z - b_).norm();
-    const double s_norm = (-options_.rho * A_.transpose() * (z - z_old)).norm();
+    IterationSummary iteration_summary;
+    iteration_summary.rho = rho;
+    iteration_summary.primal_residual_norm = (a_times_x - z - b_).norm();
+    iteration_summary.dual_residual_norm =
+        (-rho * A_.transpose() * (z - z_old)).norm();
     const double max_norm = std::max({a_times_x.norm(), z.norm(), rhs_norm});
-    const double primal_eps =
+    iteration_summary.primal_tolerance =
         primal_abs_tolerance_eps + options_.relative_tolerance * max_norm;
-    const double dual_eps = dual_abs_tolerance_eps +
-                            options_.relative_tolerance *
-                                (options_.rho * A_.transpose() * u).norm();
+    iteration_summary.dual_tolerance =
+        dual_abs_tolerance_eps +
+        options_.relative_tolerance * (rho * A_.transpose() * u).norm();
+    summary.iterations.emplace_back(iteration_summary);
+    summary.num_iterations = i + 1;
 
     // Log the result to the screen.
-    VLOG(2) << theia::StringPrintf(
-        row_format.c_str(), i, r_norm, s_norm, primal_eps, dual_eps);
+    VLOG(2) << theia::StringPrintf(row_format.c_str(),
+                                   i,
+                                   iteration_summary.primal_residual_norm,
+                                   iteration_summary.dual_residual_norm,
+                                   iteration_summary.primal_tolerance,
+                                   iteration_summary.dual_tolerance,
+                                   rho);
     // Determine if the minimizer has converged.
-    if (r_norm < primal_eps && s_norm < dual_eps) {
+    if (iteration_summary.primal_residual_norm <
+            iteration_summary.primal_tolerance &&
+        iteration_summary.dual_residual_norm <
+            iteration_summary.dual_tolerance) {
+      summary.converged = true;
       break;
     }
+
+    // Balance the primal and dual residuals by adapting rho. The scaled dual
+    // variable u must be rescaled accordingly.
+    if (options_.adaptive_penalty) {
+      if (iteration_summary.primal_residual_norm >
+          options_.penalty_residual_ratio *
+              iteration_summary.dual_residual_norm) {
+        rho *= options_.penalty_scale;
+        u /= options_.penalty_scale;
+      } else if (iteration_summary.dual_residual_norm >
+                 options_.penalty_residual_ratio *
+                     iteration_summary.primal_residual_norm) {
+        rho /= options_.penalty_scale;
+        u *= options_.penalty_scale;
+      }
+    }
   }
+  return summary;
 }
 
-Eigen::VectorXd ConstrainedL1Solver::ModifiedShrinkage(
-    const Eigen::VectorXd& vec, const double kappa) {
-  Eigen::VectorXd output(num_l1_residuals_ + num_inequality_constraints_);
+void ConstrainedL1Solver::ModifiedShrinkage(const Eigen::VectorXd& vec,
+                                            const double kappa,
+                                            Eigen::VectorXd* output) {
+  output->resize(num_l1_residuals_ + num_inequality_constraints_);
 
   // Get an array for the subset of l1 terms in the input vec.
   Eigen::Map<const Eigen::ArrayXd> l1_array(vec.data(), num_l1_residuals_);
@@ -179,11 +228,11 @@ Eigen::VectorXd ConstrainedL1Solver::ModifiedShrinkage(
       vec.data() + num_l1_residuals_, num_inequality_constraints_);
 
   // Compute the L1 proximal operator on the L1 terms.
-  output.head(num_l1_residuals_).array() =
+  output->head(num_l1_residuals_).array() =
       (l1_array - kappa).max(0.0) - (-l1_array - kappa).max(0.0);
   // Project the inequality constraints such that geq_mat * x - geq_vec > 0
-  output.tail(num_inequality_constraints_).array() = inequality_array.max(0.0);
-  return output;
+  output->tail(num_inequality_constraints_).array() =
+      inequality_array.max(0.0);
 }
 
 }  // namespace theia
@@ -38,6 +38,7 @@
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
 #include <glog/logging.h>
+#include <vector>
 
 #include "theia/math/matrix/sparse_cholesky_llt.h"
 
@@ -68,11 +69,36 @@ class ConstrainedL1Solver {
     // Alpha is the over-relaxation parameters (typically between 1.0 and 1.8).
     double alpha = 1.2;
 
+    // If true, rho is adapted during the optimization to keep the primal and
+    // dual residuals within a factor of penalty_residual_ratio of each other
+    // by scaling rho by penalty_scale. Since the linear system does not depend
+    // on rho, this does not require a new factorization.
+    bool adaptive_penalty = true;
+    double penalty_residual_ratio = 10.0;
+    double penalty_scale = 2.0;
+
     // Stopping criteria.
     double absolute_tolerance = 1e-4;
     double relative_tolerance = 1e-2;
   };
 
+  // The convergence terms of a single ADMM iteration.
+  struct IterationSummary {
+    double primal_residual_norm = 0.0;
+    double dual_residual_norm = 0.0;
+    double primal_tolerance = 0.0;
+    double dual_tolerance = 0.0;
+    double rho = 0.0;
+  };
+
+  struct Summary {
+    // True if the primal and dual residuals fell below their tolerances.
+    bool converged = false;
+    int num_iterations = 0;
+    // The convergence terms of each iteration.
+    std::vector<IterationSummary> iterations;
+  };
+
   // The linear system along with the equality and inequality constraints.
   ConstrainedL1Solver(const Options& options,
                       const Eigen::SparseMatrix<double>& A,
@@ -80,8 +106,10 @@ class ConstrainedL1Solver {
                       const Eigen::SparseMatrix<double>& geq_mat,
                       const Eigen::VectorXd& geq_vec);
 
-  // Solve the constrained L1 minimization above.
-  void Solve(Eigen::VectorXd* solution);
+  // Solve the constrained L1 minimization above. If solution has as many
+  // entries as the number of columns of A then it is used to warm start the
+  // solver, otherwise the solver starts from x = 0.
+  Summary Solve(Eigen::VectorXd* solution);
 
  private:
   // This method is used for the z-update, which is conveniently an element-wise
@@ -89,12 +117,13 @@ class ConstrainedL1Solver {
   // update the values with the L1 proximal mapping (Shrinkage) operator. The
   // terms corresponding to the inequality constraints are constrained to be
   // greater than zero as vec = max(vec, 0).
-  Eigen::VectorXd ModifiedShrinkage(const Eigen::VectorXd& vec,
-                                    const double kappa);
+  void ModifiedShrinkage(const Eigen::VectorXd& vec,
+                         const double kappa,
+                         Eigen::VectorXd* output);
 
   const Options options_;
-  const int num_l1_residuals_;
-  const int num_inequality_constraints_;
+  int num_l1_residuals_;
+  int num_inequality_constraints_;
 
   // Matrix A where || Ax - b ||_1 is the problem we are solving.
   Eigen::SparseMatrix<double> A_;
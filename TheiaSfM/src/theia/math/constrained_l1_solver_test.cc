@@ -0,0 +1,124 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "theia/math/constrained_l1_solver.h"
+
+namespace theia {
+
+namespace {
+
+// Sets up the problem:
+//
+//   minimize    |x - b_0| + |x - b_1| + |x - b_2|
+//   subject to: x - lower_bound > 0
+void SetupProblem(const Eigen::Vector3d& b_values,
+                  const double lower_bound,
+                  Eigen::SparseMatrix<double>* A,
+                  Eigen::VectorXd* b,
+                  Eigen::SparseMatrix<double>* geq_mat,
+                  Eigen::VectorXd* geq_vec) {
+  A->resize(3, 1);
+  std::vector<Eigen::Triplet<double> > triplets;
+  for (int i = 0; i < 3; i++) {
+    triplets.emplace_back(i, 0, 1.0);
+  }
+  A->setFromTriplets(triplets.begin(), triplets.end());
+  *b = b_values;
+
+  geq_mat->resize(1, 1);
+  geq_mat->insert(0, 0) = 1.0;
+  geq_vec->resize(1);
+  (*geq_vec)(0) = lower_bound;
+}
+
+ConstrainedL1Solver::Options GetOptions(const bool adaptive_penalty) {
+  ConstrainedL1Solver::Options options;
+  options.max_num_iterations = 5000;
+  options.absolute_tolerance = 1e-8;
+  options.relative_tolerance = 1e-8;
+  options.adaptive_penalty = adaptive_penalty;
+  return options;
+}
+
+}  // namespace
+
+// The unconstrained minimum is the median of b, which is infeasible. The
+// constrained minimum is at the lower bound since the cost increases past it.
+TEST(ConstrainedL1Solver, SmallProblem) {
+  static const double kTolerance = 1e-4;
+  Eigen::SparseMatrix<double> A, geq_mat;
+  Eigen::VectorXd b, geq_vec;
+  SetupProblem(Eigen::Vector3d(1.0, 2.0, 10.0), 5.0, &A, &b, &geq_mat,
+               &geq_vec);
+
+  for (const bool adaptive_penalty : {false, true}) {
+    ConstrainedL1Solver solver(GetOptions(adaptive_penalty), A, b, geq_mat,
+                               geq_vec);
+    Eigen::VectorXd solution;
+    const ConstrainedL1Solver::Summary summary = solver.Solve(&solution);
+    EXPECT_TRUE(summary.converged);
+    EXPECT_EQ(summary.num_iterations, summary.iterations.size());
+    ASSERT_EQ(solution.size(), 1);
+    EXPECT_NEAR(solution(0), 5.0, kTolerance);
+  }
+}
+
+// A warm start at the solution should converge faster than a cold start.
+TEST(ConstrainedL1Solver, WarmStart) {
+  static const double kTolerance = 1e-4;
+  Eigen::SparseMatrix<double> A, geq_mat;
+  Eigen::VectorXd b, geq_vec;
+  SetupProblem(Eigen::Vector3d(1.0, 2.0, 10.0), 5.0, &A, &b, &geq_mat,
+               &geq_vec);
+
+  ConstrainedL1Solver solver(GetOptions(true), A, b, geq_mat, geq_vec);
+  Eigen::VectorXd cold_solution;
+  const ConstrainedL1Solver::Summary cold_summary =
+      solver.Solve(&cold_solution);
+
+  Eigen::VectorXd warm_solution(1);
+  warm_solution(0) = 5.0;
+  const ConstrainedL1Solver::Summary warm_summary =
+      solver.Solve(&warm_solution);
+  EXPECT_TRUE(warm_summary.converged);
+  EXPECT_LT(warm_summary.num_iterations, cold_summary.num_iterations);
+  EXPECT_NEAR(warm_solution(0), 5.0, kTolerance);
+}
+
+}  // namespace theia
@@ -0,0 +1,519 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#ifndef THEIA_MATH_FIND_POLYNOMIAL_ROOTS_FIXED_DEGREE_H_
+#define THEIA_MATH_FIND_POLYNOMIAL_ROOTS_FIXED_DEGREE_H_
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#include "theia/math/closed_form_polynomial_solver.h"
+#include "theia/math/util.h"
+
+namespace theia {
+
+// Root finding for polynomials whose degree is known at compile time. These
+// functions are drop-in replacements for FindPolynomialRoots inside of minimal
+// solvers: all storage is fixed-size so no memory is allocated. Polynomials are
+// given as N + 1 coefficients in decreasing degree order, matching the
+// convention of theia/math/polynomial.h:
+//
+//   sum_{i=0}^N polynomial[i] x^{N-i}.
+//
+// Polynomials of degree 1 and 2 are solved in closed form. Cubics and quartics
+// are solved in closed form and then polished with Aberth-Ehrlich iterations,
+// which also repairs the degenerate cases of Cardano's and Ferrari's methods.
+// Higher degrees are solved with Aberth-Ehrlich iterations from scratch. If only
+// the real roots of a higher degree polynomial are needed, SturmChain in
+// theia/math/find_polynomial_roots_sturm.h is usually faster.
+
+// Computes all (complex) roots of the polynomial. Leading zero coefficients
+// reduce the degree of the polynomial. If real is not NULL, the real parts of
+// the roots are written to it, and likewise for imaginary. Both arrays must
+// have room for N entries. Returns the number of roots, which is the degree of
+// the polynomial after leading zeros are removed.
+template <int N>
+int FindPolynomialRootsFixedDegree(const double* polynomial,
+                                   double* real,
+                                   double* imaginary);
+
+// The number of polynomials that FindPolynomialRootsBatched solves together in
+// SIMD registers.
+static const int kPolynomialBatchLanes = 4;
+
+// Computes the roots of num_polynomials polynomials of degree N at once. The
+// coefficients of polynomial i are polynomials[i * (N + 1) ... i * (N + 1) + N],
+// and its roots are written to real[i * N ...] and imaginary[i * N ...] (either
+// of which may be NULL), with the number of roots written to num_roots[i].
+// Groups of kPolynomialBatchLanes polynomials are solved with Aberth-Ehrlich
+// iterations in lockstep so that every arithmetic operation is vectorized
+// across the group. Polynomials with a zero leading coefficient fall back to
+// FindPolynomialRootsFixedDegree.
+template <int N>
+void FindPolynomialRootsBatched(const double* polynomials,
+                                const int num_polynomials,
+                                double* real,
+                                double* imaginary,
+                                int* num_roots);
+
+// ---------------------------- Implementation ------------------------------
+
+namespace fixed_degree_internal {
+
+// Relative size of an Aberth correction at which a root is considered
+// converged.
+static const double kAberthTolerance = 1e-15;
+
+// Relative size of the polynomial at which a root is considered converged.
+static const double kResidualTolerance = 1e-14;
+
+static const int kMaxAberthIterations = 100;
+
+// Runs Aberth-Ehrlich iterations on kLanes monic polynomials of degree N in
+// lockstep. monic[i] holds coefficient i of every polynomial and monic[0] is
+// implicitly one. The real and imaginary parts of the roots must be initialized
+// with distinct guesses.
+template <int N, int kLanes>
+void AberthEhrlich(const Eigen::Array<double, kLanes, 1>* monic,
+                   Eigen::Array<double, kLanes, 1>* real,
+                   Eigen::Array<double, kLanes, 1>* imaginary) {
+  typedef Eigen::Array<double, kLanes, 1> Lanes;
+  for (int iteration = 0; iteration < kMaxAberthIterations; ++iteration) {
+    bool converged = true;
+    for (int k = 0; k < N; ++k) {
+      const Lanes& zr = real[k];
+      const Lanes& zi = imaginary[k];
+
+      // Evaluate the polynomial p and its derivative dp at z_k with the Horner
+      // scheme. The polynomial with absolute coefficients evaluated at |z_k|
+      // bounds the rounding error of the evaluation.
+      const Lanes z_abs = (zr * zr + zi * zi).sqrt();
+      Lanes pr = Lanes::Ones();
+      Lanes pi = Lanes::Zero();
+      Lanes dpr = Lanes::Zero();
+      Lanes dpi = Lanes::Zero();
+      Lanes error_bound = Lanes::Ones();
+      for (int i = 1; i <= N; ++i) {
+        const Lanes next_dpr = dpr * zr - dpi * zi + pr;
+        const Lanes next_dpi = dpr * zi + dpi * zr + pi;
+        const Lanes next_pr = pr * zr - pi * zi + monic[i];
+        pi = pr * zi + pi * zr;
+        pr = next_pr;
+        dpr = next_dpr;
+        dpi = next_dpi;
+        error_bound = error_bound * z_abs + monic[i].abs();
+      }
+
+      // The Newton correction w = p / dp.
+      const Lanes dp_norm = dpr * dpr + dpi * dpi;
+      const Lanes wr = (pr * dpr + pi * dpi) / dp_norm;
+      const Lanes wi = (pi * dpr - pr * dpi) / dp_norm;
+
+      // The repulsion from the other roots: sum_{j != k} 1 / (z_k - z_j).
+      Lanes sr = Lanes::Zero();
+      Lanes si = Lanes::Zero();
+      for (int j = 0; j < N; ++j) {
+        if (j == k) {
+          continue;
+        }
+        const Lanes dr = zr - real[j];
+        const Lanes di = zi - imaginary[j];
+        const Lanes d_norm = dr * dr + di * di;
+        sr += dr / d_norm;
+        si -= di / d_norm;
+      }
+
+      // The Aberth correction w / (1 - w * s).
+      const Lanes denominator_r = 1.0 - (wr * sr - wi * si);
+      const Lanes denominator_i = -(wr * si + wi * sr);
+      const Lanes denominator_norm =
+          denominator_r * denominator_r + denominator_i * denominator_i;
+      Lanes cr = (wr * denominator_r + wi * denominator_i) / denominator_norm;
+      Lanes ci = (wi * denominator_r - wr * denominator_i) / denominator_norm;
+
+      // Roots that are exact (p = 0) or at a critical point of the polynomial
+      // produce non-finite corrections and are left in place.
+      const auto finite = cr.isFinite() && ci.isFinite();
+      cr = finite.select(cr, 0.0);
+      ci = finite.select(ci, 0.0);
+      real[k] -= cr;
+      imaginary[k] -= ci;
+
+      // A root has converged once the correction is negligible or the
+      // polynomial vanishes to within rounding error. The latter terminates
+      // the slow convergence to multiple roots.
+      const Lanes correction_norm = cr * cr + ci * ci;
+      const Lanes root_norm =
+          real[k] * real[k] + imaginary[k] * imaginary[k];
+      const Lanes residual = (pr * pr + pi * pi).sqrt();
+      if (((correction_norm >
+            kAberthTolerance * kAberthTolerance * root_norm) &&
+           (residual > kResidualTolerance * error_bound)).any()) {
+        converged = false;
+      }
+    }
+    if (converged) {
+      return;
+    }
+  }
+}
+
+// Initializes the roots of monic polynomials on a circle whose radius bounds
+// the magnitude of the roots. The circle is rotated off of the real axis so that
+// no initial guess is real, which would otherwise prevent it from converging to
+// a complex root.
+template <int N, int kLanes>
+void InitializeAberthRoots(const Eigen::Array<double, kLanes, 1>* monic,
+                           Eigen::Array<double, kLanes, 1>* real,
+                           Eigen::Array<double, kLanes, 1>* imaginary) {
+  typedef Eigen::Array<double, kLanes, 1> Lanes;
+  Lanes radius = Lanes::Constant(1e-3);
+  for (int i = 1; i <= N; ++i) {
+    radius = radius.max(monic[i].abs().pow(1.0 / i));
+  }
+  for (int k = 0; k < N; ++k) {
+    const double angle = (2.0 * M_PI * k + 0.5 * M_PI) / N + 0.1;
+    real[k] = radius * std::cos(angle);
+    imaginary[k] = radius * std::sin(angle);
+  }
+}
+
+// Computes closed form roots of a polynomial with a non-zero leading
+// coefficient. If kIsExact is true the roots are final, otherwise they are
+// used to seed the Aberth-Ehrlich iterations. Returns false if there is no
+// closed form solution for the degree.
+template <int N>
+struct ClosedFormRoots {
+  static const bool kIsExact = false;
+  static bool Solve(const double* polynomial, std::complex<double>* roots) {
+    return false;
+  }
+};
+
+template <>
+struct ClosedFormRoots<1> {
+  static const bool kIsExact = true;
+  static bool Solve(const double* polynomial, std::complex<double>* roots) {
+    roots[0] = -polynomial[1] / polynomial[0];
+    return true;
+  }
+};
+
+template <>
+struct ClosedFormRoots<2> {
+  static const bool kIsExact = true;
+  static bool Solve(const double* polynomial, std::complex<double>* roots) {
+    return SolveQuadratic(polynomial[0], polynomial[1], polynomial[2],
+                          roots) == 2;
+  }
+};
+
+// Solves the monic cubic x^3 + b x^2 + c x + d = 0 with Cardano's method, or
+// with the trigonometric method when all three roots are real.
+inline void SolveMonicCubic(const double b,
+                            const double c,
+                            const double d,
+                            std::complex<double>* roots) {
+  // Reduce to the depressed cubic t^3 + p t + q = 0 with x = t - b / 3.
+  const double shift = -b / 3.0;
+  const double p = c - b * b / 3.0;
+  const double q = (2.0 * b * b * b - 9.0 * b * c) / 27.0 + d;
+  const double discriminant = 0.25 * q * q + p * p * p / 27.0;
+  if (discriminant > 0.0) {
+    // One real root and a complex conjugate pair. The cube roots are computed
+    // so that no cancellation occurs.
+    const double a = -std::cbrt(std::abs(0.5 * q) + std::sqrt(discriminant)) *
+                     (q >= 0.0 ? 1.0 : -1.0);
+    const double a_conjugate = a == 0.0 ? 0.0 : -p / (3.0 * a);
+    const double real_part = -0.5 * (a + a_conjugate) + shift;
+    const double imaginary_part = 0.5 * std::sqrt(3.0) * (a - a_conjugate);
+    roots[0] = a + a_conjugate + shift;
+    roots[1] = std::complex<double>(real_part, imaginary_part);
+    roots[2] = std::complex<double>(real_part, -imaginary_part);
+  } else {
+    // Three real roots.
+    const double r = std::sqrt(std::max(-p / 3.0, 0.0));
+    const double cos_phi =
+        r == 0.0 ? 0.0 : std::max(-1.0, std::min(1.0, -0.5 * q / (r * r * r)));
+    const double phi = std::acos(cos_phi);
+    for (int k = 0; k < 3; ++k) {
+      roots[k] = 2.0 * r * std::cos((phi + 2.0 * M_PI * k) / 3.0) + shift;
+    }
+  }
+}
+
+// Solves the monic quartic x^4 + a x^3 + b x^2 + c x + d = 0 with Ferrari's
+// method.
+inline void SolveMonicQuartic(const double a,
+                              const double b,
+                              const double c,
+                              const double d,
+                              std::complex<double>* roots) {
+  // Reduce to the depressed quartic y^4 + p y^2 + q y + r = 0 with
+  // x = y - a / 4.
+  const double shift = -0.25 * a;
+  const double a2 = a * a;
+  const double p = b - 0.375 * a2;
+  const double q = c - 0.5 * a * b + 0.125 * a2 * a;
+  const double r = d - 0.25 * a * c + a2 * b / 16.0 - 3.0 * a2 * a2 / 256.0;
+
+  // The quartic is biquadratic if q vanishes.
+  if (q == 0.0) {
+    const std::complex<double> sqrt_discriminant =
+        std::sqrt(std::complex<double>(0.25 * p * p - r));
+    const std::complex<double> z1 = -0.5 * p + sqrt_discriminant;
+    const std::complex<double> z2 = -0.5 * p - sqrt_discriminant;
+    roots[0] = std::sqrt(z1) + shift;
+    roots[1] = -std::sqrt(z1) + shift;
+    roots[2] = std::sqrt(z2) + shift;
+    roots[3] = -std::sqrt(z2) + shift;
+    return;
+  }
+
+  // The resolvent cubic m^3 + p m^2 + (p^2 / 4 - r) m - q^2 / 8 = 0 has a
+  // positive real root, which factors the quartic into two quadratics.
+  std::complex<double> resolvent_roots[3];
+  SolveMonicCubic(p, 0.25 * p * p - r, -0.125 * q * q, resolvent_roots);
+  double m = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(resolvent_roots[i].imag()) == 0.0) {
+      m = std::max(m, resolvent_roots[i].real());
+    }
+  }
+  if (m <= 0.0) {
+    m = std::max(std::max(resolvent_roots[0].real(),
+                          resolvent_roots[1].real()),
+                 resolvent_roots[2].real());
+  }
+
+  // y^2 +- sqrt(2m) y + (p / 2 + m -+ q / (2 sqrt(2m))) = 0.
+  const double sqrt_2m = std::sqrt(std::max(2.0 * m, 0.0));
+  const double offset = sqrt_2m == 0.0 ? 0.0 : q / (2.0 * sqrt_2m);
+  for (int sign = 0; sign < 2; ++sign) {
+    const double linear = sign == 0 ? sqrt_2m : -sqrt_2m;
+    const double constant = 0.5 * p + m - (sign == 0 ? offset : -offset);
+    const std::complex<double> sqrt_discriminant =
+        std::sqrt(std::complex<double>(0.25 * linear * linear - constant));
+    roots[2 * sign] = -0.5 * linear + sqrt_discriminant + shift;
+    roots[2 * sign + 1] = -0.5 * linear - sqrt_discriminant + shift;
+  }
+}
+
+template <>
+struct ClosedFormRoots<3> {
+  static const bool kIsExact = false;
+  static bool Solve(const double* polynomial, std::complex<double>* roots) {
+    SolveMonicCubic(polynomial[1] / polynomial[0],
+                    polynomial[2] / polynomial[0],
+                    polynomial[3] / polynomial[0],
+                    roots);
+    return true;
+  }
+};
+
+template <>
+struct ClosedFormRoots<4> {
+  static const bool kIsExact = false;
+  static bool Solve(const double* polynomial, std::complex<double>* roots) {
+    SolveMonicQuartic(polynomial[1] / polynomial[0],
+                      polynomial[2] / polynomial[0],
+                      polynomial[3] / polynomial[0],
+                      polynomial[4] / polynomial[0],
+                      roots);
+    return true;
+  }
+};
+
+// Replaces the initial guesses of a lane with the closed form roots if they are
+// available. The roots are perturbed so that equal roots (e.g., a double root)
+// remain distinct, which the Aberth-Ehrlich iterations require. Returns true if
+// the lane was seeded.
+template <int N, int kLanes>
+bool SeedWithClosedFormRoots(const double* polynomial,
+                             const int lane,
+                             Eigen::Array<double, kLanes, 1>* real,
+                             Eigen::Array<double, kLanes, 1>* imaginary) {
+  std::complex<double> roots[N];
+  if (!ClosedFormRoots<N>::Solve(polynomial, roots)) {
+    return false;
+  }
+  for (int k = 0; k < N; ++k) {
+    if (!std::isfinite(roots[k].real()) || !std::isfinite(roots[k].imag())) {
+      return false;
+    }
+  }
+
+  const double kPerturbation = 1e-10;
+  for (int k = 0; k < N; ++k) {
+    real[k](lane) =
+        roots[k].real() + kPerturbation * std::max(1.0, std::abs(roots[k]));
+    imaginary[k](lane) = roots[k].imag() + kPerturbation * (k + 1);
+  }
+  return true;
+}
+
+// Writes the roots out of the lane of a batch.
+template <int N, int kLanes>
+void CopyRootsFromLane(const Eigen::Array<double, kLanes, 1>* lane_real,
+                       const Eigen::Array<double, kLanes, 1>* lane_imaginary,
+                       const int lane,
+                       double* real,
+                       double* imaginary) {
+  for (int k = 0; k < N; ++k) {
+    if (real != NULL) {
+      real[k] = lane_real[k](lane);
+    }
+    if (imaginary != NULL) {
+      imaginary[k] = lane_imaginary[k](lane);
+    }
+  }
+}
+
+}  // namespace fixed_degree_internal
+
+template <int N>
+int FindPolynomialRootsFixedDegree(const double* polynomial,
+                                   double* real,
+                                   double* imaginary) {
+  // Remove leading zeros by solving the polynomial of lower degree.
+  if (polynomial[0] == 0.0) {
+    return FindPolynomialRootsFixedDegree<N - 1>(polynomial + 1, real,
+                                                 imaginary);
+  }
+
+  typedef fixed_degree_internal::ClosedFormRoots<N> ClosedForm;
+  std::complex<double> roots[N];
+  if (ClosedForm::kIsExact) {
+    ClosedForm::Solve(polynomial, roots);
+  } else {
+    typedef Eigen::Array<double, 1, 1> Lane;
+    Lane monic[N + 1];
+    for (int i = 0; i <= N; ++i) {
+      monic[i](0) = polynomial[i] / polynomial[0];
+    }
+
+    Lane roots_real[N];
+    Lane roots_imaginary[N];
+    if (!fixed_degree_internal::SeedWithClosedFormRoots<N, 1>(
+            polynomial, 0, roots_real, roots_imaginary)) {
+      fixed_degree_internal::InitializeAberthRoots<N, 1>(monic, roots_real,
+                                                         roots_imaginary);
+    }
+    fixed_degree_internal::AberthEhrlich<N, 1>(monic, roots_real,
+                                               roots_imaginary);
+    for (int k = 0; k < N; ++k) {
+      roots[k] = std::complex<double>(roots_real[k](0), roots_imaginary[k](0));
+    }
+  }
+
+  for (int k = 0; k < N; ++k) {
+    if (real != NULL) {
+      real[k] = roots[k].real();
+    }
+    if (imaginary != NULL) {
+      imaginary[k] = roots[k].imag();
+    }
+  }
+  return N;
+}
+
+// A constant polynomial has no roots.
+template <>
+inline int FindPolynomialRootsFixedDegree<0>(const double* polynomial,
+                                             double* real,
+                                             double* imaginary) {
+  return 0;
+}
+
+template <int N>
+void FindPolynomialRootsBatched(const double* polynomials,
+                                const int num_polynomials,
+                                double* real,
+                                double* imaginary,
+                                int* num_roots) {
+  typedef Eigen::Array<double, kPolynomialBatchLanes, 1> Lanes;
+  for (int first = 0; first < num_polynomials;
+       first += kPolynomialBatchLanes) {
+    const int num_lanes =
+        std::min(kPolynomialBatchLanes, num_polynomials - first);
+
+    // Gather the monic coefficients into lanes. Unused lanes of the final batch
+    // and lanes with a zero leading coefficient solve a dummy polynomial.
+    Lanes monic[N + 1];
+    bool solved_in_batch[kPolynomialBatchLanes];
+    for (int lane = 0; lane < kPolynomialBatchLanes; ++lane) {
+      const double* polynomial = polynomials + (first + lane) * (N + 1);
+      solved_in_batch[lane] = lane < num_lanes && polynomial[0] != 0.0;
+      for (int i = 0; i <= N; ++i) {
+        monic[i](lane) =
+            solved_in_batch[lane] ? polynomial[i] / polynomial[0] : 1.0;
+      }
+    }
+
+    Lanes roots_real[N];
+    Lanes roots_imaginary[N];
+    fixed_degree_internal::InitializeAberthRoots<N, kPolynomialBatchLanes>(
+        monic, roots_real, roots_imaginary);
+    for (int lane = 0; lane < num_lanes; ++lane) {
+      if (solved_in_batch[lane]) {
+        fixed_degree_internal::SeedWithClosedFormRoots<N,
+                                                       kPolynomialBatchLanes>(
+            polynomials + (first + lane) * (N + 1), lane, roots_real,
+            roots_imaginary);
+      }
+    }
+    fixed_degree_internal::AberthEhrlich<N, kPolynomialBatchLanes>(
+        monic, roots_real, roots_imaginary);
+
+    for (int lane = 0; lane < num_lanes; ++lane) {
+      const int index = first + lane;
+      double* lane_real = real == NULL ? NULL : real + index * N;
+      double* lane_imaginary = imaginary == NULL ? NULL : imaginary + index * N;
+      if (solved_in_batch[lane]) {
+        fixed_degree_internal::CopyRootsFromLane<N, kPolynomialBatchLanes>(
+            roots_real, roots_imaginary, lane, lane_real, lane_imaginary);
+        num_roots[index] = N;
+      } else {
+        num_roots[index] = FindPolynomialRootsFixedDegree<N>(
+            polynomials + index * (N + 1), lane_real, lane_imaginary);
+      }
+    }
+  }
+}
+
+}  // namespace theia
+
+#endif  // THEIA_MATH_FIND_POLYNOMIAL_ROOTS_FIXED_DEGREE_H_
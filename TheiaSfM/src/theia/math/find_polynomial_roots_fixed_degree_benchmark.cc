@@ -0,0 +1,134 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "theia/math/find_polynomial_roots_fixed_degree.h"
+#include "theia/math/find_polynomial_roots_sturm.h"
+#include "theia/math/polynomial.h"
+#include "theia/test/benchmark.h"
+#include "theia/util/random.h"
+
+namespace theia {
+namespace {
+
+static const int kNumPolynomials = 1024;
+
+// Generates random polynomials of degree N with a fixed seed so that every run
+// of the benchmark uses the same data. The coefficients of polynomial i are
+// stored at i * (N + 1).
+template <int N>
+std::vector<double> GeneratePolynomials() {
+  RandomNumberGenerator rng(59);
+  std::vector<double> polynomials(kNumPolynomials * (N + 1));
+  for (double& coefficient : polynomials) {
+    coefficient = rng.RandDouble(-1.0, 1.0);
+  }
+  return polynomials;
+}
+
+// The dynamically sized companion matrix solver used by FindPolynomialRoots.
+template <int N>
+void BM_FindPolynomialRoots(benchmark::State& state) {
+  const std::vector<double> polynomials = GeneratePolynomials<N>();
+  int i = 0;
+  while (state.KeepRunning()) {
+    const Eigen::Map<const Eigen::VectorXd> polynomial(
+        &polynomials[(i++ % kNumPolynomials) * (N + 1)], N + 1);
+    Eigen::VectorXd real, imaginary;
+    FindPolynomialRoots(polynomial, &real, &imaginary);
+    benchmark::DoNotOptimize(real.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindPolynomialRoots<3>);
+BENCHMARK(BM_FindPolynomialRoots<4>);
+BENCHMARK(BM_FindPolynomialRoots<10>);
+
+template <int N>
+void BM_FindPolynomialRootsFixedDegree(benchmark::State& state) {
+  const std::vector<double> polynomials = GeneratePolynomials<N>();
+  double real[N], imaginary[N];
+  int i = 0;
+  while (state.KeepRunning()) {
+    const int num_roots = FindPolynomialRootsFixedDegree<N>(
+        &polynomials[(i++ % kNumPolynomials) * (N + 1)], real, imaginary);
+    benchmark::DoNotOptimize(num_roots);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindPolynomialRootsFixedDegree<3>);
+BENCHMARK(BM_FindPolynomialRootsFixedDegree<4>);
+BENCHMARK(BM_FindPolynomialRootsFixedDegree<10>);
+
+// Solves all polynomials in one call. Items are polynomials, so the throughput
+// is directly comparable with the scalar solvers.
+template <int N>
+void BM_FindPolynomialRootsBatched(benchmark::State& state) {
+  const std::vector<double> polynomials = GeneratePolynomials<N>();
+  std::vector<double> real(kNumPolynomials * N);
+  std::vector<double> imaginary(kNumPolynomials * N);
+  std::vector<int> num_roots(kNumPolynomials);
+  while (state.KeepRunning()) {
+    FindPolynomialRootsBatched<N>(polynomials.data(), kNumPolynomials,
+                                  real.data(), imaginary.data(),
+                                  num_roots.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPolynomials);
+}
+BENCHMARK(BM_FindPolynomialRootsBatched<3>);
+BENCHMARK(BM_FindPolynomialRootsBatched<4>);
+BENCHMARK(BM_FindPolynomialRootsBatched<10>);
+
+// Only the real roots with a Sturm sequence, for comparison.
+template <int N>
+void BM_FindRealPolynomialRootsSturm(benchmark::State& state) {
+  const std::vector<double> polynomials = GeneratePolynomials<N>();
+  double roots[N];
+  int i = 0;
+  while (state.KeepRunning()) {
+    const int num_roots = FindRealPolynomialRootsSturm<N>(
+        &polynomials[(i++ % kNumPolynomials) * (N + 1)], roots);
+    benchmark::DoNotOptimize(num_roots);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FindRealPolynomialRootsSturm<10>);
+
+}  // namespace
+}  // namespace theia
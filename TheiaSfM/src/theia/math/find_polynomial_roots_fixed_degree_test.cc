@@ -0,0 +1,217 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "theia/math/find_polynomial_roots_fixed_degree.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+RandomNumberGenerator rng(59);
+
+// Builds the coefficients of c * prod_i (x - roots[i]) in decreasing degree
+// order from complex roots that come in conjugate pairs.
+template <int N>
+void PolynomialFromRoots(const std::complex<double>* roots,
+                         const double leading_coefficient,
+                         double* polynomial) {
+  std::complex<double> complex_polynomial[N + 1];
+  std::fill(complex_polynomial, complex_polynomial + N + 1, 0.0);
+  complex_polynomial[0] = leading_coefficient;
+  for (int i = 0; i < N; ++i) {
+    for (int j = i + 1; j > 0; --j) {
+      complex_polynomial[j] -= roots[i] * complex_polynomial[j - 1];
+    }
+  }
+  for (int i = 0; i <= N; ++i) {
+    polynomial[i] = complex_polynomial[i].real();
+  }
+}
+
+// Expects that every expected root is matched by one of the found roots.
+void ExpectRootsMatch(const int num_roots,
+                      const std::complex<double>* expected_roots,
+                      const double* real,
+                      const double* imaginary,
+                      const double epsilon) {
+  for (int i = 0; i < num_roots; ++i) {
+    double min_distance = std::numeric_limits<double>::max();
+    for (int j = 0; j < num_roots; ++j) {
+      min_distance =
+          std::min(min_distance,
+                   std::abs(expected_roots[i] -
+                            std::complex<double>(real[j], imaginary[j])));
+    }
+    EXPECT_LT(min_distance, epsilon * std::max(1.0, std::abs(expected_roots[i])))
+        << "Root " << expected_roots[i] << " was not found.";
+  }
+}
+
+template <int N>
+void RunRootsTest(const std::complex<double>* roots, const double epsilon) {
+  double polynomial[N + 1];
+  PolynomialFromRoots<N>(roots, 1.23, polynomial);
+
+  double real[N], imaginary[N];
+  EXPECT_EQ(FindPolynomialRootsFixedDegree<N>(polynomial, real, imaginary), N);
+  ExpectRootsMatch(N, roots, real, imaginary, epsilon);
+}
+
+// Generates polynomials with random real roots and complex conjugate pairs.
+template <int N>
+void RandomRoots(std::complex<double>* roots) {
+  int i = 0;
+  for (; i + 1 < N && rng.RandDouble(0.0, 1.0) < 0.5; i += 2) {
+    roots[i] = std::complex<double>(rng.RandDouble(-5.0, 5.0),
+                                    rng.RandDouble(0.1, 5.0));
+    roots[i + 1] = std::conj(roots[i]);
+  }
+  for (; i < N; ++i) {
+    roots[i] = rng.RandDouble(-5.0, 5.0);
+  }
+}
+
+}  // namespace
+
+TEST(FindPolynomialRootsFixedDegree, ConstantPolynomialReturnsNoRoots) {
+  const double polynomial[1] = { 1.23 };
+  double roots[1];
+  EXPECT_EQ(FindPolynomialRootsFixedDegree<0>(polynomial, roots, NULL), 0);
+}
+
+TEST(FindPolynomialRootsFixedDegree, LinearPolynomial) {
+  const std::complex<double> roots[1] = { 42.42 };
+  RunRootsTest<1>(roots, 1e-12);
+}
+
+TEST(FindPolynomialRootsFixedDegree, QuadraticPolynomial) {
+  const std::complex<double> roots[2] = { 1.0, -4.2 };
+  RunRootsTest<2>(roots, 1e-12);
+}
+
+TEST(FindPolynomialRootsFixedDegree, QuadraticPolynomialWithComplexRoots) {
+  const std::complex<double> roots[2] = { { 1.0, 2.0 }, { 1.0, -2.0 } };
+  RunRootsTest<2>(roots, 1e-12);
+}
+
+TEST(FindPolynomialRootsFixedDegree, CubicPolynomial) {
+  const std::complex<double> roots[3] = { 1.0, -2.5, 3.75 };
+  RunRootsTest<3>(roots, 1e-12);
+}
+
+TEST(FindPolynomialRootsFixedDegree, CubicPolynomialWithTripleRoot) {
+  // Cardano's method only returns one root for (x - 2)^3.
+  const std::complex<double> roots[3] = { 2.0, 2.0, 2.0 };
+  RunRootsTest<3>(roots, 1e-4);
+}
+
+TEST(FindPolynomialRootsFixedDegree, QuarticPolynomial) {
+  const std::complex<double> roots[4] = { 1.23e-4, 1.23e-1, 1.23e+2, 1.23e+5 };
+  RunRootsTest<4>(roots, 1e-10);
+}
+
+TEST(FindPolynomialRootsFixedDegree, QuarticPolynomialWithDoubleRoots) {
+  const std::complex<double> roots[4] = { 1.0, 1.0, -3.0, -3.0 };
+  RunRootsTest<4>(roots, 1e-6);
+}
+
+TEST(FindPolynomialRootsFixedDegree, LeadingZerosAreIgnored) {
+  // 0 * x^3 + 0 * x^2 + 2 * x - 4 has the single root 2.
+  const double polynomial[4] = { 0.0, 0.0, 2.0, -4.0 };
+  double real[3], imaginary[3];
+  EXPECT_EQ(FindPolynomialRootsFixedDegree<3>(polynomial, real, imaginary), 1);
+  EXPECT_NEAR(real[0], 2.0, 1e-12);
+  EXPECT_EQ(imaginary[0], 0.0);
+}
+
+TEST(FindPolynomialRootsFixedDegree, RandomPolynomials) {
+  static const int kNumTrials = 100;
+  for (int trial = 0; trial < kNumTrials; ++trial) {
+    std::complex<double> roots[10];
+    RandomRoots<10>(roots);
+    RunRootsTest<10>(roots, 1e-6);
+
+    RandomRoots<4>(roots);
+    RunRootsTest<4>(roots, 1e-8);
+
+    RandomRoots<3>(roots);
+    RunRootsTest<3>(roots, 1e-8);
+  }
+}
+
+TEST(FindPolynomialRootsFixedDegree, BatchedMatchesScalar) {
+  // An odd number of polynomials so that the final batch is partially full,
+  // and one polynomial with a zero leading coefficient.
+  static const int kNumPolynomials = 11;
+  static const int kDegree = 6;
+  std::vector<double> polynomials(kNumPolynomials * (kDegree + 1));
+  std::vector<std::complex<double> > roots(kNumPolynomials * kDegree);
+  for (int i = 0; i < kNumPolynomials; ++i) {
+    RandomRoots<kDegree>(&roots[i * kDegree]);
+    PolynomialFromRoots<kDegree>(&roots[i * kDegree], rng.RandDouble(1.0, 2.0),
+                                 &polynomials[i * (kDegree + 1)]);
+  }
+  polynomials[5 * (kDegree + 1)] = 0.0;
+
+  std::vector<double> real(kNumPolynomials * kDegree);
+  std::vector<double> imaginary(kNumPolynomials * kDegree);
+  std::vector<int> num_roots(kNumPolynomials);
+  FindPolynomialRootsBatched<kDegree>(polynomials.data(), kNumPolynomials,
+                                      real.data(), imaginary.data(),
+                                      num_roots.data());
+
+  for (int i = 0; i < kNumPolynomials; ++i) {
+    double expected_real[kDegree], expected_imaginary[kDegree];
+    const int expected_num_roots = FindPolynomialRootsFixedDegree<kDegree>(
+        &polynomials[i * (kDegree + 1)], expected_real, expected_imaginary);
+    ASSERT_EQ(num_roots[i], expected_num_roots);
+    std::complex<double> expected_roots[kDegree];
+    for (int j = 0; j < expected_num_roots; ++j) {
+      expected_roots[j] =
+          std::complex<double>(expected_real[j], expected_imaginary[j]);
+    }
+    ExpectRootsMatch(expected_num_roots, expected_roots, &real[i * kDegree],
+                     &imaginary[i * kDegree], 1e-8);
+  }
+}
+
+}  // namespace theia
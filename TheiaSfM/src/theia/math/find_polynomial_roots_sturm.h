@@ -0,0 +1,446 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#ifndef THEIA_MATH_FIND_POLYNOMIAL_ROOTS_STURM_H_
+#define THEIA_MATH_FIND_POLYNOMIAL_ROOTS_STURM_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace theia {
+
+// Isolates and refines the real roots of a polynomial of degree at most N using
+// a Sturm sequence. The polynomial is given as N + 1 coefficients in decreasing
+// degree order, matching the convention of theia/math/polynomial.h:
+//
+//   sum_{i=0}^N polynomial[i] x^{N-i}.
+//
+// Leading zero coefficients are allowed, in which case the actual degree of the
+// polynomial is lower than N. All storage is fixed-size so that the chain may
+// be built inside of tight loops (e.g., minimal solvers in RANSAC) without any
+// heap allocation.
+//
+// Only distinct real roots are reported. A root of even multiplicity does not
+// produce a sign change of the polynomial and is located by bisection on the
+// Sturm sequence alone.
+template <int N>
+class SturmChain {
+ public:
+  explicit SturmChain(const double* polynomial);
+
+  // The degree of the polynomial after leading zeros have been removed.
+  int degree() const { return degrees_[0]; }
+
+  // The number of sign changes of the Sturm sequence evaluated at x.
+  int NumSignChanges(const double x) const;
+
+  // Returns the number of distinct real roots in the half-open interval
+  // (lower, upper].
+  int NumRootsInInterval(const double lower, const double upper) const {
+    return NumSignChanges(lower) - NumSignChanges(upper);
+  }
+
+  // Cauchy bound on the magnitude of all (real and complex) roots.
+  double RootBound() const;
+
+  // Finds all distinct real roots in (lower, upper] and writes them into roots
+  // in increasing order. The roots array must have room for degree() entries.
+  // Returns the number of roots found.
+  int FindRealRoots(const double lower,
+                    const double upper,
+                    double* roots) const;
+
+  // Finds all distinct real roots of the polynomial.
+  int FindRealRoots(double* roots) const {
+    const double bound = RootBound();
+    return FindRealRoots(-bound, bound, roots);
+  }
+
+ private:
+  // Evaluates the i-th polynomial of the chain at x.
+  double EvaluateChain(const int i, const double x) const;
+
+  // Refines the single root contained in (lower, upper] with a Newton iteration
+  // safeguarded by bisection. The bracket around the root shrinks with every
+  // iteration, so the returned value always lies within (lower, upper].
+  double RefineRoot(double lower, double upper) const;
+
+  // The input polynomial with leading zeros removed. This is kept unscaled so
+  // that Newton steps use the true derivative.
+  double polynomial_[N + 1];
+
+  // The Sturm sequence. Each entry is normalized by the magnitude of its
+  // leading coefficient, which does not change the signs used for counting.
+  double chain_[N + 1][N + 1];
+  int degrees_[N + 1];
+  int length_;
+};
+
+// Convenience wrapper that finds all distinct real roots of the degree N
+// polynomial. The roots are written in increasing order into the caller
+// provided array, which must have room for N entries. Returns the number of
+// real roots found.
+template <int N>
+int FindRealPolynomialRootsSturm(const double* polynomial, double* roots) {
+  const SturmChain<N> sturm_chain(polynomial);
+  return sturm_chain.FindRealRoots(roots);
+}
+
+// ------------------------- Implementation details ------------------------- //
+
+namespace sturm_internal {
+
+// Relative magnitude under which a coefficient of a remainder is considered to
+// be zero. Remainders below this magnitude indicate a common factor between the
+// polynomial and its derivative, i.e. a multiple root.
+static const double kZeroTolerance = 1e-13;
+
+// Relative width at which interval refinement stops.
+static const double kRootTolerance = 1e-14;
+
+// Bisection alone needs about 100 iterations to shrink the widest intervals
+// given by the root bound down to kRootTolerance.
+static const int kMaxRefineIterations = 200;
+
+// Evaluates a polynomial in decreasing degree order with the Horner scheme.
+inline double EvaluateHorner(const double* polynomial,
+                             const int degree,
+                             const double x) {
+  double value = polynomial[0];
+  for (int i = 1; i <= degree; ++i) {
+    value = value * x + polynomial[i];
+  }
+  return value;
+}
+
+// Evaluates the polynomial and its derivative at x.
+inline void EvaluateHornerWithDerivative(const double* polynomial,
+                                         const int degree,
+                                         const double x,
+                                         double* value,
+                                         double* derivative) {
+  double p = polynomial[0];
+  double dp = 0.0;
+  for (int i = 1; i <= degree; ++i) {
+    dp = dp * x + p;
+    p = p * x + polynomial[i];
+  }
+  *value = p;
+  *derivative = dp;
+}
+
+// Returns an upper bound on the rounding error of the Horner evaluation of the
+// polynomial at x. A value whose magnitude is below this bound cannot be told
+// apart from zero.
+inline double HornerRoundingErrorBound(const double* polynomial,
+                                       const int degree,
+                                       const double x) {
+  const double abs_x = std::abs(x);
+  double bound = std::abs(polynomial[0]);
+  for (int i = 1; i <= degree; ++i) {
+    bound = bound * abs_x + std::abs(polynomial[i]);
+  }
+  return 2.0 * degree * std::numeric_limits<double>::epsilon() * bound;
+}
+
+// Returns true if the interval is narrow enough to report its midpoint.
+inline bool IsIntervalConverged(const double lower, const double upper) {
+  return upper - lower <=
+         kRootTolerance * (1.0 + std::max(std::abs(lower), std::abs(upper)));
+}
+
+// Scales the polynomial so that its leading coefficient has unit magnitude.
+inline void NormalizeLeadingCoefficient(const int degree, double* polynomial) {
+  const double scale = 1.0 / std::abs(polynomial[0]);
+  for (int i = 0; i <= degree; ++i) {
+    polynomial[i] *= scale;
+  }
+}
+
+}  // namespace sturm_internal
+
+template <int N>
+SturmChain<N>::SturmChain(const double* polynomial) : length_(0) {
+  // Remove leading zeros.
+  int start = 0;
+  while (start < N && polynomial[start] == 0.0) {
+    ++start;
+  }
+  const int degree = N - start;
+  for (int i = 0; i <= degree; ++i) {
+    polynomial_[i] = polynomial[start + i];
+  }
+
+  // A zero polynomial or a constant has no roots and a chain of length one.
+  degrees_[0] = degree;
+  std::copy(polynomial_, polynomial_ + degree + 1, chain_[0]);
+  length_ = 1;
+  if (degree == 0 || polynomial_[0] == 0.0) {
+    return;
+  }
+  sturm_internal::NormalizeLeadingCoefficient(degree, chain_[0]);
+
+  // The second element of the chain is the derivative.
+  degrees_[1] = degree - 1;
+  for (int i = 0; i < degree; ++i) {
+    chain_[1][i] = chain_[0][i] * (degree - i);
+  }
+  sturm_internal::NormalizeLeadingCoefficient(degrees_[1], chain_[1]);
+  length_ = 2;
+
+  // Every following element is the negated remainder of the division of the
+  // two previous elements.
+  double remainder[N + 1];
+  while (degrees_[length_ - 1] > 0) {
+    const double* dividend = chain_[length_ - 2];
+    const double* divisor = chain_[length_ - 1];
+    const int dividend_degree = degrees_[length_ - 2];
+    const int divisor_degree = degrees_[length_ - 1];
+
+    std::copy(dividend, dividend + dividend_degree + 1, remainder);
+    double max_coefficient = 0.0;
+    for (int i = 0; i <= dividend_degree; ++i) {
+      max_coefficient = std::max(max_coefficient, std::abs(dividend[i]));
+    }
+    for (int i = 0; i <= dividend_degree - divisor_degree; ++i) {
+      const double quotient = remainder[i] / divisor[0];
+      for (int j = 0; j <= divisor_degree; ++j) {
+        remainder[i + j] -= quotient * divisor[j];
+      }
+    }
+
+    // The remainder occupies the trailing divisor_degree coefficients. Strip
+    // its leading coefficients that vanished due to cancellation.
+    const double* remainder_begin =
+        remainder + dividend_degree - divisor_degree + 1;
+    int remainder_degree = divisor_degree - 1;
+    const double zero_threshold =
+        sturm_internal::kZeroTolerance * max_coefficient;
+    while (remainder_degree >= 0 &&
+           std::abs(remainder_begin[0]) <= zero_threshold) {
+      ++remainder_begin;
+      --remainder_degree;
+    }
+
+    // A vanishing remainder means the chain has ended with the greatest common
+    // divisor of the polynomial and its derivative.
+    if (remainder_degree < 0) {
+      break;
+    }
+
+    for (int i = 0; i <= remainder_degree; ++i) {
+      chain_[length_][i] = -remainder_begin[i];
+    }
+    degrees_[length_] = remainder_degree;
+    sturm_internal::NormalizeLeadingCoefficient(remainder_degree,
+                                                chain_[length_]);
+    ++length_;
+  }
+}
+
+template <int N>
+double SturmChain<N>::EvaluateChain(const int i, const double x) const {
+  return sturm_internal::EvaluateHorner(chain_[i], degrees_[i], x);
+}
+
+template <int N>
+int SturmChain<N>::NumSignChanges(const double x) const {
+  int num_sign_changes = 0;
+  double previous = 0.0;
+  for (int i = 0; i < length_; ++i) {
+    const double value = EvaluateChain(i, x);
+    if (value == 0.0) {
+      continue;
+    }
+    if ((previous < 0.0 && value > 0.0) || (previous > 0.0 && value < 0.0)) {
+      ++num_sign_changes;
+    }
+    previous = value;
+  }
+  return num_sign_changes;
+}
+
+template <int N>
+double SturmChain<N>::RootBound() const {
+  const int degree = degrees_[0];
+  if (degree == 0 || polynomial_[0] == 0.0) {
+    return 0.0;
+  }
+  double max_ratio = 0.0;
+  for (int i = 1; i <= degree; ++i) {
+    max_ratio =
+        std::max(max_ratio, std::abs(polynomial_[i] / polynomial_[0]));
+  }
+  return 1.0 + max_ratio;
+}
+
+template <int N>
+double SturmChain<N>::RefineRoot(double lower, double upper) const {
+  const int degree = degrees_[0];
+  double value_lower =
+      sturm_internal::EvaluateHorner(polynomial_, degree, lower);
+  const double value_upper =
+      sturm_internal::EvaluateHorner(polynomial_, degree, upper);
+  if (value_upper == 0.0) {
+    return upper;
+  }
+
+  // Roots of even multiplicity do not change the sign of the polynomial, and
+  // neither does a root at the excluded lower end of the interval. In these
+  // cases the Sturm sequence must be used to decide which half contains the
+  // root.
+  if (value_lower == 0.0 || (value_lower < 0.0) == (value_upper < 0.0)) {
+    for (int i = 0; i < sturm_internal::kMaxRefineIterations &&
+                    !sturm_internal::IsIntervalConverged(lower, upper);
+         ++i) {
+      const double mid = 0.5 * (lower + upper);
+      if (NumRootsInInterval(lower, mid) > 0) {
+        upper = mid;
+      } else {
+        lower = mid;
+      }
+    }
+    return 0.5 * (lower + upper);
+  }
+
+  // Newton iteration within the sign changing bracket. A Newton step is only
+  // taken if it lands strictly inside the bracket and is less than half of the
+  // step before the previous one, otherwise the iteration has stalled and the
+  // bracket is bisected instead. The iteration converges once the bracket is
+  // narrow enough, or once the polynomial cannot be told apart from zero and
+  // the Newton step is below the tolerance.
+  double x = 0.5 * (lower + upper);
+  double step = upper - lower;
+  double previous_step = step;
+  for (int i = 0; i < sturm_internal::kMaxRefineIterations; ++i) {
+    double value, derivative;
+    sturm_internal::EvaluateHornerWithDerivative(polynomial_, degree, x,
+                                                 &value, &derivative);
+    // The value alone is not enough near clustered roots, where the
+    // polynomial is numerically zero over a much wider range than the
+    // tolerance, so the Newton step must be negligible as well.
+    if (value == 0.0 ||
+        (std::abs(value) <= sturm_internal::HornerRoundingErrorBound(
+                                polynomial_, degree, x) &&
+         std::abs(value) <= sturm_internal::kRootTolerance *
+                                (1.0 + std::abs(x)) * std::abs(derivative))) {
+      return x;
+    }
+
+    // Shrink the bracket around the root.
+    if ((value < 0.0) == (value_lower < 0.0)) {
+      lower = x;
+      value_lower = value;
+    } else {
+      upper = x;
+    }
+    if (sturm_internal::IsIntervalConverged(lower, upper)) {
+      return x;
+    }
+
+    const double newton_x = x - value / derivative;
+    const bool take_newton_step =
+        newton_x > lower && newton_x < upper &&
+        std::abs(2.0 * value) <= std::abs(previous_step * derivative);
+    previous_step = step;
+    if (take_newton_step) {
+      step = x - newton_x;
+      x = newton_x;
+    } else {
+      step = 0.5 * (upper - lower);
+      x = lower + step;
+    }
+  }
+  return x;
+}
+
+template <int N>
+int SturmChain<N>::FindRealRoots(const double lower,
+                                 const double upper,
+                                 double* roots) const {
+  if (degrees_[0] == 0 || polynomial_[0] == 0.0) {
+    return 0;
+  }
+
+  // Intervals that contain at least one root. Since the intervals are disjoint
+  // there can never be more than N of them on the stack at once.
+  struct Interval {
+    double lower, upper;
+    int lower_sign_changes, upper_sign_changes;
+  };
+  Interval stack[N + 1];
+  int stack_size = 0;
+
+  int num_roots = 0;
+  stack[stack_size++] = {lower, upper, NumSignChanges(lower),
+                         NumSignChanges(upper)};
+  while (stack_size > 0) {
+    const Interval interval = stack[--stack_size];
+    const int num_roots_in_interval =
+        interval.lower_sign_changes - interval.upper_sign_changes;
+    if (num_roots_in_interval <= 0) {
+      continue;
+    }
+
+    if (num_roots_in_interval == 1) {
+      roots[num_roots++] = RefineRoot(interval.lower, interval.upper);
+      continue;
+    }
+
+    // Several roots that cannot be separated at machine precision are reported
+    // as a single root.
+    const double mid = 0.5 * (interval.lower + interval.upper);
+    if (sturm_internal::IsIntervalConverged(interval.lower, interval.upper)) {
+      roots[num_roots++] = mid;
+      continue;
+    }
+
+    // Push the upper half first so that roots are reported in increasing order.
+    const int mid_sign_changes = NumSignChanges(mid);
+    if (mid_sign_changes != interval.upper_sign_changes) {
+      stack[stack_size++] = {mid, interval.upper, mid_sign_changes,
+                             interval.upper_sign_changes};
+    }
+    if (interval.lower_sign_changes != mid_sign_changes) {
+      stack[stack_size++] = {interval.lower, mid, interval.lower_sign_changes,
+                             mid_sign_changes};
+    }
+  }
+  return num_roots;
+}
+
+}  // namespace theia
+
+#endif  // THEIA_MATH_FIND_POLYNOMIAL_ROOTS_STURM_H_
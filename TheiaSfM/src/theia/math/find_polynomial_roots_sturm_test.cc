@@ -0,0 +1,254 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "theia/math/find_polynomial_roots_sturm.h"
+#include "theia/test/test_utils.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+RandomNumberGenerator rng(59);
+
+const double kEpsilon = 1e-10;
+
+// Builds the coefficients of c * prod_i (x - roots[i]) in decreasing degree
+// order.
+template <int N>
+void PolynomialFromRealRoots(const double (&roots)[N],
+                             const double leading_coefficient,
+                             double* polynomial) {
+  std::fill(polynomial, polynomial + N + 1, 0.0);
+  polynomial[0] = leading_coefficient;
+  for (int i = 0; i < N; ++i) {
+    for (int j = i + 1; j > 0; --j) {
+      polynomial[j] -= roots[i] * polynomial[j - 1];
+    }
+  }
+}
+
+template <int N>
+void RunRealRootsTest(double (&roots)[N], const double epsilon) {
+  double polynomial[N + 1];
+  PolynomialFromRealRoots(roots, 1.23, polynomial);
+
+  double found_roots[N];
+  const int num_roots = FindRealPolynomialRootsSturm<N>(polynomial,
+                                                        found_roots);
+  EXPECT_EQ(num_roots, N);
+
+  std::sort(roots, roots + N);
+  test::ExpectArraysNear(N, found_roots, roots, epsilon);
+}
+
+// Checks the roots of a degree 10 polynomial against reference roots (computed
+// in quadruple precision) with a tolerance relative to their magnitude.
+void RunDeterminantRootsTest(const double (&polynomial)[11],
+                             const std::vector<double>& expected_roots,
+                             const double relative_tolerance) {
+  double roots[10];
+  const int num_roots = FindRealPolynomialRootsSturm<10>(polynomial, roots);
+  ASSERT_EQ(num_roots, expected_roots.size());
+  for (int i = 0; i < num_roots; ++i) {
+    EXPECT_NEAR(roots[i], expected_roots[i],
+                relative_tolerance * (1.0 + std::abs(expected_roots[i])));
+  }
+}
+
+}  // namespace
+
+TEST(FindPolynomialRootsSturm, ConstantPolynomialReturnsNoRoots) {
+  const double polynomial[1] = { 1.23 };
+  double roots[1];
+  EXPECT_EQ(FindRealPolynomialRootsSturm<0>(polynomial, roots), 0);
+}
+
+TEST(FindPolynomialRootsSturm, LinearPolynomial) {
+  double roots[1] = { 42.42 };
+  RunRealRootsTest(roots, kEpsilon);
+}
+
+TEST(FindPolynomialRootsSturm, QuadraticPolynomial) {
+  double roots[2] = { 1.0, -4.2 };
+  RunRealRootsTest(roots, kEpsilon);
+}
+
+TEST(FindPolynomialRootsSturm, QuadraticPolynomialWithComplexRoots) {
+  // x^2 + 1 has no real roots.
+  const double polynomial[3] = { 1.0, 0.0, 1.0 };
+  double roots[2];
+  EXPECT_EQ(FindRealPolynomialRootsSturm<2>(polynomial, roots), 0);
+}
+
+TEST(FindPolynomialRootsSturm, LeadingZerosAreIgnored) {
+  // 0 * x^3 + 0 * x^2 + 2 * x - 4 has the single root 2.
+  const double polynomial[4] = { 0.0, 0.0, 2.0, -4.0 };
+  double roots[3];
+  const SturmChain<3> sturm_chain(polynomial);
+  EXPECT_EQ(sturm_chain.degree(), 1);
+  EXPECT_EQ(sturm_chain.FindRealRoots(roots), 1);
+  EXPECT_NEAR(roots[0], 2.0, kEpsilon);
+}
+
+TEST(FindPolynomialRootsSturm, QuarticPolynomial) {
+  double roots[4] = { 1.23e-4, 1.23e-1, 1.23e+2, 1.23e+5 };
+  RunRealRootsTest(roots, 1e-7);
+}
+
+TEST(FindPolynomialRootsSturm, RepeatedRootIsReportedOnce) {
+  // (x - 1)^2 (x + 2).
+  const double polynomial[4] = { 1.0, 0.0, -3.0, 2.0 };
+  double roots[3];
+  const int num_roots = FindRealPolynomialRootsSturm<3>(polynomial, roots);
+  ASSERT_EQ(num_roots, 2);
+  EXPECT_NEAR(roots[0], -2.0, kEpsilon);
+  EXPECT_NEAR(roots[1], 1.0, 1e-6);
+}
+
+TEST(FindPolynomialRootsSturm, MixedRealAndComplexRoots) {
+  // (x - 0.5) (x + 3) (x^2 + 2x + 5).
+  const double polynomial[5] = { 1.0, 4.5, 8.5, 9.5, -7.5 };
+  double roots[4];
+  const int num_roots = FindRealPolynomialRootsSturm<4>(polynomial, roots);
+  ASSERT_EQ(num_roots, 2);
+  EXPECT_NEAR(roots[0], -3.0, kEpsilon);
+  EXPECT_NEAR(roots[1], 0.5, kEpsilon);
+}
+
+TEST(FindPolynomialRootsSturm, NumRootsInInterval) {
+  double roots[3] = { -1.0, 2.0, 5.0 };
+  double polynomial[4];
+  PolynomialFromRealRoots(roots, -0.7, polynomial);
+  const SturmChain<3> sturm_chain(polynomial);
+  EXPECT_EQ(sturm_chain.NumRootsInInterval(-10.0, 10.0), 3);
+  EXPECT_EQ(sturm_chain.NumRootsInInterval(0.0, 3.0), 1);
+  EXPECT_EQ(sturm_chain.NumRootsInInterval(2.5, 4.5), 0);
+}
+
+TEST(FindPolynomialRootsSturm, RandomDegreeTenPolynomials) {
+  static const int kNumTrials = 100;
+  for (int i = 0; i < kNumTrials; ++i) {
+    // Keep the roots reasonably separated so that the test measures the root
+    // finder rather than the conditioning of the polynomial.
+    double roots[10];
+    for (int j = 0; j < 10; ++j) {
+      roots[j] = -1.0 + 0.2 * j + rng.RandDouble(0.0, 0.1);
+    }
+    RunRealRootsTest(roots, 1e-8);
+  }
+}
+
+// The following polynomials are determinants of the five point solver for
+// noise-free minimal samples on which the root refinement used to fail.
+
+TEST(FindPolynomialRootsSturm, FivePointDeterminantWithWideRootBound) {
+  // The root bound is about 2e5 and 9e7, while the roots are small.
+  const double polynomial1[11] = {
+    0.011765202319311885, -0.21471143518021996, -1.3587976548482508,
+    -13.644960876477452, -104.15928134635179, -455.09411564500903,
+    -1312.736354072083, -2484.3428824381954, -2385.3948106632579,
+    -260.52381377371648, -28.676951157258699 };
+  RunDeterminantRootsTest(polynomial1,
+                          { -2.8502830116602329, 25.285224787151897 },
+                          1e-12);
+
+  const double polynomial2[11] = {
+    -0.0010140157614566393, -0.022270122645689609, -0.10518605410580414,
+    0.95752997372409032, 7.5318492421816856, -14.568898376331333,
+    -102.64596017703377, -302.85565653485764, -8546.785086161357,
+    -17682.849996932164, 89538.830764198399 };
+  RunDeterminantRootsTest(polynomial2,
+                          { -7.7322673176746139, 2.2611160985669474 },
+                          1e-12);
+}
+
+TEST(FindPolynomialRootsSturm, FivePointDeterminantWithLargeRoots) {
+  const double polynomial1[11] = {
+    9.5866384984377717e-05, -0.31676622200237148, -6.3369988657086083,
+    101.76385596377119, 91.793613472027346, -196.1948157654063,
+    -422.8059199868801, -101.43720260714008, 648.69652294691332,
+    233.17596757249976, -362.54131509214449 };
+  RunDeterminantRootsTest(polynomial1,
+                          { -30.072725059238241, 0.85480336931285883,
+                            0.90347701872348807, 1.4532559655919601,
+                            11.018950368956617, 3324.0371573896559 },
+                          1e-12);
+
+  // The root bound is about 9e11.
+  const double polynomial2[11] = {
+    -2.1858998247246404e-06, -0.00082876172644074015, -0.061108665098889348,
+    1.3646718264378599, 120.62353150243312, -2428.4061205523135,
+    26869.404035360181, -216171.47516699391, 1944016.0914596408,
+    573143.8344132062, 18140.719401421025 };
+  RunDeterminantRootsTest(polynomial2,
+                          { -270.09744179003633, -94.494814379860614,
+                            -68.878385888204235, -0.25036026164591529,
+                            -0.036085887578238211, 35.649127100277234 },
+                          1e-12);
+}
+
+TEST(FindPolynomialRootsSturm, FivePointDeterminantWithClusteredRoots) {
+  const double polynomial1[11] = {
+    -0.083628362855116212, 0.11782250437768482, 28.390048380045698,
+    -464.80402855106786, 3605.5619838792545, -16226.156674142212,
+    45753.224581545881, -85226.252674221585, 107094.30887063604,
+    -83668.064902887098, 29329.747937858803 };
+  RunDeterminantRootsTest(polynomial1,
+                          { -24.770233375190788, 1.0535838025570188,
+                            2.151486490268256, 2.5590184724599871,
+                            3.3027461008069361, 6.0556807449313821 },
+                          1e-11);
+
+  // The two smallest roots are only 4.5e-5 apart, which limits the accuracy
+  // with which they are determined by the coefficients.
+  const double polynomial2[11] = {
+    73.027823795490505, 204.80913762310661, 60.460057136724117,
+    -444.34286983553852, -909.03509809241814, -346.69788473942208,
+    2439.7737295402439, 5547.7626925111426, 5238.8159586687452,
+    2353.8935835515513, 412.38318632578557 };
+  RunDeterminantRootsTest(polynomial2,
+                          { -1.146343530613491, -1.1462990706406468,
+                            -0.81744470728600549, -0.62311515689529728 },
+                          1e-8);
+}
+
+}  // namespace theia
@@ -237,6 +237,7 @@ class NormalizedGraphCut {
   // Create a mapping of node ids to indices that are used for the matrices
   // i.e., which row a particular node id corresponds to.
   void IndexNodeIds(const std::unordered_map<std::pair<T, T>, double>& edges) {
+    node_to_index_map_.clear();
     for (const auto& edge : edges) {
       InsertIfNotPresent(
           &node_to_index_map_, edge.first.first, node_to_index_map_.size());
@@ -43,16 +43,46 @@
 
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/bundle_adjustment/create_loss_function.h"
+#include "theia/sfm/bundle_adjustment/position_prior_error.h"
 #include "theia/sfm/camera/camera.h"
 #include "theia/sfm/camera/create_reprojection_error_cost_function.h"
+#include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/memory_accounting.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/reconstruction_estimator_utils.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
+#include "theia/util/progress_reporter.h"
+#include "theia/util/stringprintf.h"
 #include "theia/util/timer.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 namespace {
+
+// Reports each iteration of the solver to the progress reporter and aborts the
+// solver if the reporter has been cancelled.
+class ProgressReporterCallback : public ceres::IterationCallback {
+ public:
+  explicit ProgressReporterCallback(ProgressReporter* progress_reporter)
+      : progress_reporter_(progress_reporter) {}
+
+  ceres::CallbackReturnType operator()(
+      const ceres::IterationSummary& summary) {
+    if (progress_reporter_->IsCancelled()) {
+      return ceres::SOLVER_ABORT;
+    }
+    progress_reporter_->SetStep(
+        StringPrintf("Bundle adjustment iteration %d, cost = %g",
+                     summary.iteration,
+                     summary.cost));
+    return ceres::SOLVER_CONTINUE;
+  }
+
+ private:
+  ProgressReporter* progress_reporter_;
+};
+
 // Set the solver options to defaults.
 void SetSolverOptions(const BundleAdjustmentOptions& options,
                       ceres::Solver::Options* solver_options) {
@@ -122,6 +152,13 @@ void BundleAdjuster::AddView(const ViewId view_id) {
   // Fetch the camera that will be optimized.
   Camera* camera = view->MutableCamera();
 
+  // Constrain the camera position to its prior if desired.
+  const Prior<3>& position_prior = view->CameraIntrinsicsPrior().position;
+  if (options_.position_prior_weight > 0.0 && position_prior.is_set) {
+    AddPositionPriorResidual(
+        Eigen::Map<const Eigen::Vector3d>(position_prior.value), camera);
+  }
+
   // Add residuals for all tracks in the view.
   for (const TrackId track_id : view->TrackIds()) {
     const Feature* feature = CHECK_NOTNULL(view->GetFeature(track_id));
@@ -181,6 +218,7 @@ void BundleAdjuster::AddTrack(const TrackId track_id) {
 }
 
 BundleAdjustmentSummary BundleAdjuster::Optimize() {
+  ScopedTraceSpan span("SolveBundleAdjustment");
   // Set extrinsics parameterization of the camera poses. This will set
   // orientation and/or positions as constant if desired.
   SetCameraExtrinsicsParameterization();
@@ -200,11 +238,29 @@ BundleAdjustmentSummary BundleAdjuster::Optimize() {
     solver_options_.inner_iteration_ordering->Reverse();
   }
 
+  VLOG(1) << "Estimated memory usage of the bundle adjustment problem: "
+          << EstimateBundleAdjustmentMemoryUsage(problem_->NumResidualBlocks(),
+                                                 problem_->NumResiduals(),
+                                                 problem_->NumParameters()) /
+                 (1024.0 * 1024.0)
+          << " MB";
+
   // Solve the problem.
   const double internal_setup_time = timer_.ElapsedTimeInSeconds();
   ceres::Solver::Summary solver_summary;
-  ceres::Solve(solver_options_, problem_.get(), &solver_summary);
+  if (options_.progress_reporter != nullptr) {
+    ProgressReporterCallback callback(options_.progress_reporter.get());
+    solver_options_.callbacks.push_back(&callback);
+    ceres::Solve(solver_options_, problem_.get(), &solver_summary);
+    solver_options_.callbacks.pop_back();
+  } else {
+    ceres::Solve(solver_options_, problem_.get(), &solver_summary);
+  }
   LOG_IF(INFO, options_.verbose) << solver_summary.FullReport();
+  IncrementTraceCounter("bundle_adjustment_residuals",
+                        solver_summary.num_residuals);
+  IncrementTraceCounter("bundle_adjustment_iterations",
+                        solver_summary.iterations.size());
 
   // Set the BundleAdjustmentSummary.
   BundleAdjustmentSummary summary;
@@ -386,4 +442,13 @@ void BundleAdjuster::AddReprojectionErrorResidual(const Feature& feature,
       track->MutablePoint()->data());
 }
 
+void BundleAdjuster::AddPositionPriorResidual(
+    const Eigen::Vector3d& position_prior, Camera* camera) {
+  problem_->AddResidualBlock(
+      PositionPriorError::Create<Camera::kExtrinsicsSize>(
+          position_prior, options_.position_prior_weight),
+      nullptr,
+      camera->mutable_extrinsics());
+}
+
 }  // namespace theia
@@ -37,6 +37,7 @@
 
 #include <ceres/ceres.h>
 #include <ceres/types.h>
+#include <Eigen/Core>
 #include <unordered_set>
 
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
@@ -101,6 +102,10 @@ class BundleAdjuster {
                                             Camera* camera,
                                             Track* track);
 
+  // Add the residual between the camera position and its prior to the problem.
+  virtual void AddPositionPriorResidual(const Eigen::Vector3d& position_prior,
+                                        Camera* camera);
+
   const BundleAdjustmentOptions options_;
   Reconstruction* reconstruction_;
   Timer timer_;
@@ -36,11 +36,13 @@
 #define THEIA_SFM_BUNDLE_ADJUSTMENT_BUNDLE_ADJUSTMENT_H_
 
 #include <ceres/types.h>
+#include <memory>
 #include <unordered_set>
 
 #include "theia/sfm/bundle_adjustment/create_loss_function.h"
 #include "theia/sfm/types.h"
 #include "theia/util/enable_enum_bitmask_operators.h"
+#include "theia/util/progress_reporter.h"
 
 namespace theia {
 
@@ -97,6 +99,13 @@ struct BundleAdjustmentOptions {
   bool constant_camera_orientation = false;
   bool constant_camera_position = false;
 
+  // If greater than zero, a residual weight * (position - prior) is added for
+  // each optimized view with a position prior in its CameraIntrinsicsPrior
+  // (e.g., from GPS). The priors must be in the coordinate frame of the
+  // reconstruction, so this should only be used once the reconstruction has
+  // been aligned to the priors.
+  double position_prior_weight = 0.0;
+
   // Indicates which intrinsics should be optimized as part of bundle
   // adjustment. By default, we do not optimize skew and aspect ratio since
   // these are almost universally constant.
@@ -119,6 +128,11 @@ struct BundleAdjustmentOptions {
   double gradient_tolerance = 1e-10;
   double parameter_tolerance = 1e-8;
   double max_trust_region_radius = 1e12;
+
+  // If set, each solver iteration is reported as a step of the current stage
+  // and the solver is aborted (so that the optimization fails) as soon as the
+  // reporter is cancelled.
+  std::shared_ptr<ProgressReporter> progress_reporter;
 };
 
 // Some important metrics for analyzing bundle adjustment results.
@@ -36,6 +36,7 @@
 
 #include <ceres/rotation.h>
 #include <Eigen/Core>
+#include <Eigen/SVD>
 #include <glog/logging.h>
 #include <algorithm>
 #include <vector>
@@ -47,23 +48,15 @@
 namespace theia {
 namespace {
 
-// Creates the constraint matrix such that ||A * t|| is minimized, where A is
-// R_i * f_i x R_j * f_j. Given known rotations, we can solve for the
-// relative translation from this constraint matrix.
-void CreateConstraintMatrix(
+// Creates the constraints a_i such that sum_i |a_i^T * t| is minimized, where
+// a_i is R_i * f_i x R_j * f_j. Given known rotations, we can solve for the
+// relative translation from these constraints.
+void CreateConstraints(
     const std::vector<FeatureCorrespondence>& correspondences,
-    const Eigen::Vector3d& rotation1,
-    const Eigen::Vector3d& rotation2,
-    Eigen::MatrixXd* constraint_matrix) {
-  constraint_matrix->resize(3, correspondences.size());
-
-  Eigen::Matrix3d rotation_matrix1;
-  ceres::AngleAxisToRotationMatrix(
-      rotation1.data(), ceres::ColumnMajorAdapter3x3(rotation_matrix1.data()));
-  Eigen::Matrix3d rotation_matrix2;
-  ceres::AngleAxisToRotationMatrix(
-      rotation2.data(), ceres::ColumnMajorAdapter3x3(rotation_matrix2.data()));
-
+    const Eigen::Matrix3d& rotation_matrix1,
+    const Eigen::Matrix3d& rotation_matrix2,
+    std::vector<Eigen::Vector3d>* constraints) {
+  constraints->resize(correspondences.size());
   for (int i = 0; i < correspondences.size(); i++) {
     const Eigen::Vector3d rotated_feature1 =
         rotation_matrix1.transpose() *
@@ -72,9 +65,8 @@ void CreateConstraintMatrix(
         rotation_matrix2.transpose() *
         correspondences[i].feature2.homogeneous();
 
-    constraint_matrix->col(i) =
-        rotated_feature2.cross(rotated_feature1).transpose() *
-        rotation_matrix1.transpose();
+    (*constraints)[i] =
+        rotation_matrix1 * rotated_feature2.cross(rotated_feature1);
   }
 }
 
@@ -84,15 +76,10 @@ void CreateConstraintMatrix(
 // otherwise.
 bool MajorityOfPointsInFrontOfCameras(
     const std::vector<FeatureCorrespondence>& correspondences,
-    const Eigen::Vector3d& rotation1,
-    const Eigen::Vector3d& rotation2,
+    const Eigen::Matrix3d& rotation_matrix1,
+    const Eigen::Matrix3d& rotation_matrix2,
     const Eigen::Vector3d& relative_position) {
   // Compose the relative rotation.
-  Eigen::Matrix3d rotation_matrix1, rotation_matrix2;
-  ceres::AngleAxisToRotationMatrix(
-      rotation1.data(), ceres::ColumnMajorAdapter3x3(rotation_matrix1.data()));
-  ceres::AngleAxisToRotationMatrix(
-      rotation2.data(), ceres::ColumnMajorAdapter3x3(rotation_matrix2.data()));
   const Eigen::Matrix3d relative_rotation_matrix =
       rotation_matrix2 * rotation_matrix1.transpose();
 
@@ -119,11 +106,22 @@ bool OptimizeRelativePositionWithKnownRotation(
     const Eigen::Vector3d& rotation1,
     const Eigen::Vector3d& rotation2,
     Eigen::Vector3d* relative_position) {
-  CHECK_NOTNULL(relative_position);
+  RelativePositionOptimizationWorkspace workspace;
+  return OptimizeRelativePositionWithKnownRotation(correspondences,
+                                                   rotation1,
+                                                   rotation2,
+                                                   &workspace,
+                                                   relative_position);
+}
 
-  // Set the initial relative position to random. This helps avoid a bad local
-  // minima that is achieved from poor initialization.
-  relative_position->setRandom();
+bool OptimizeRelativePositionWithKnownRotation(
+    const std::vector<FeatureCorrespondence>& correspondences,
+    const Eigen::Vector3d& rotation1,
+    const Eigen::Vector3d& rotation2,
+    RelativePositionOptimizationWorkspace* workspace,
+    Eigen::Vector3d* relative_position) {
+  CHECK_NOTNULL(workspace);
+  CHECK_NOTNULL(relative_position);
 
   // Constants used for the IRLS solving.
   const double eps = 1e-5;
@@ -131,42 +129,52 @@ bool OptimizeRelativePositionWithKnownRotation(
   const int kMaxInnerIterations = 10;
   const double kMinWeight = 1e-7;
 
-  // Create the constraint matrix from the known correspondences and rotations.
-  Eigen::MatrixXd constraint_matrix;
-  CreateConstraintMatrix(correspondences,
-                         rotation1,
-                         rotation2,
-                         &constraint_matrix);
+  Eigen::Matrix3d rotation_matrix1, rotation_matrix2;
+  ceres::AngleAxisToRotationMatrix(
+      rotation1.data(), ceres::ColumnMajorAdapter3x3(rotation_matrix1.data()));
+  ceres::AngleAxisToRotationMatrix(
+      rotation2.data(), ceres::ColumnMajorAdapter3x3(rotation_matrix2.data()));
 
-  // Initialize the weighting terms for each correspondence.
-  Eigen::VectorXd weights(correspondences.size());
-  weights.setConstant(1.0);
+  // Create the constraints from the known correspondences and rotations.
+  std::vector<Eigen::Vector3d>& constraints = workspace->constraints;
+  CreateConstraints(correspondences,
+                    rotation_matrix1,
+                    rotation_matrix2,
+                    &constraints);
 
-  // Solve for the relative positions using a robust IRLS.
+  // Initialize the weighting terms for each correspondence.
+  std::vector<double>& weights = workspace->weights;
+  weights.assign(correspondences.size(), 1.0);
+
+  // Solve for the relative positions using a robust IRLS. Each iteration
+  // minimizes the weighted constraints over the unit sphere, which has a closed
+  // form solution as the null vector of a 3x3 system. The first iteration uses
+  // unit weights, so no initial position is needed.
+  relative_position->setZero();
   double cost = 0;
   int num_inner_iterations = 0;
   for (int i = 0;
        i < kMaxIterations && num_inner_iterations < kMaxInnerIterations;
        i++) {
-    // Limit the minimum weight at kMinWeight.
-    weights = (weights.array() < kMinWeight).select(kMinWeight, weights);
-
-    // Apply the weights to the constraint matrix.
-    const Eigen::Matrix3d lhs = constraint_matrix *
-                                weights.asDiagonal().inverse() *
-                                constraint_matrix.transpose();
+    // Accumulate the weighted constraints, limiting the minimum weight at
+    // kMinWeight.
+    Eigen::Matrix3d lhs = Eigen::Matrix3d::Zero();
+    for (int j = 0; j < constraints.size(); j++) {
+      lhs.noalias() += constraints[j] * constraints[j].transpose() /
+                       std::max(weights[j], kMinWeight);
+    }
 
     // Solve for the relative position which is the null vector of the weighted
     // constraints.
     const Eigen::Vector3d new_relative_position =
         lhs.jacobiSvd(Eigen::ComputeFullU).matrixU().rightCols<1>();
 
-    // Update the weights based on the current errors.
-    weights =
-        (new_relative_position.transpose() * constraint_matrix).array().abs();
-
-    // Compute the new cost.
-    const double new_cost = weights.sum();
+    // Update the weights based on the current errors and compute the new cost.
+    double new_cost = 0;
+    for (int j = 0; j < constraints.size(); j++) {
+      weights[j] = std::abs(new_relative_position.dot(constraints[j]));
+      new_cost += weights[j];
+    }
 
     // Check for convergence.
     const double delta = std::max(std::abs(cost - new_cost),
@@ -187,8 +195,8 @@ bool OptimizeRelativePositionWithKnownRotation(
   // position. We can determine the sign by choosing the sign that puts the most
   // points in front of the camera.
   if (!MajorityOfPointsInFrontOfCameras(correspondences,
-                                        rotation1,
-                                        rotation2,
+                                        rotation_matrix1,
+                                        rotation_matrix2,
                                         *relative_position)) {
     *relative_position *= -1.0;
   }
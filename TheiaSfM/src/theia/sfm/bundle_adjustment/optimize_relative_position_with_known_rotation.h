@@ -41,6 +41,14 @@
 namespace theia {
 struct FeatureCorrespondence;
 
+// Scratch memory used by OptimizeRelativePositionWithKnownRotation. Reusing a
+// single workspace when refining many view pairs (e.g. one per thread) avoids
+// allocating the constraints and IRLS weights for every pair.
+struct RelativePositionOptimizationWorkspace {
+  std::vector<Eigen::Vector3d> constraints;
+  std::vector<double> weights;
+};
+
 // Using known relative rotations, optimize the relative position that minimizes
 // the epipolar constraint x2' * [t]_x * R * x1 = 0 for all
 // correspondences. NOTE: the position is -R' * t and the rotations correspond
@@ -55,6 +63,16 @@ bool OptimizeRelativePositionWithKnownRotation(
     const Eigen::Vector3d& rotation2,
     Eigen::Vector3d* relative_position);
 
+// Same as above, but the IRLS buffers are taken from the workspace so that no
+// memory is allocated once the workspace has grown to the number of
+// correspondences.
+bool OptimizeRelativePositionWithKnownRotation(
+    const std::vector<FeatureCorrespondence>& correspondences,
+    const Eigen::Vector3d& rotation1,
+    const Eigen::Vector3d& rotation2,
+    RelativePositionOptimizationWorkspace* workspace,
+    Eigen::Vector3d* relative_position);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_BUNDLE_ADJUSTMENT_OPTIMIZE_RELATIVE_POSITION_WITH_KNOWN_ROTATION_H_
@@ -218,4 +218,55 @@ TEST(OptimizeRelativePositionWithKnownRotationTest, PixelAndTranslationNoise) {
                    kTolerance);
 }
 
+TEST(OptimizeRelativePositionWithKnownRotationTest, ReusedWorkspace) {
+  static const double kPixelNoise = 1.0;
+  static const int kNumPoints = 100;
+  static const int kNumViewPairs = 5;
+
+  // Refine several view pairs with a single workspace and verify that the
+  // results match those computed with a fresh workspace.
+  RelativePositionOptimizationWorkspace workspace;
+  for (int i = 0; i < kNumViewPairs; i++) {
+    const Camera camera1 = RandomCamera();
+    Camera camera2 = RandomCamera();
+    camera2.SetPosition(camera2.GetPosition().normalized());
+
+    // Use a different number of points per pair so that the workspace has to
+    // shrink and grow.
+    std::vector<FeatureCorrespondence> matches;
+    for (int j = 0; j < kNumPoints + 10 * (i % 2 == 0 ? i : -i); j++) {
+      const Eigen::Vector4d point(rng.RandDouble(-2.0, 2.0),
+                                  rng.RandDouble(-2.0, 2.0),
+                                  rng.RandDouble(8.0, 10.0),
+                                  1.0);
+      FeatureCorrespondence match;
+      camera1.ProjectPoint(point, &match.feature1);
+      camera2.ProjectPoint(point, &match.feature2);
+      AddNoiseToProjection(kPixelNoise, &rng, &match.feature1);
+      AddNoiseToProjection(kPixelNoise, &rng, &match.feature2);
+      match.feature1 =
+          camera1.PixelToNormalizedCoordinates(match.feature1).hnormalized();
+      match.feature2 =
+          camera2.PixelToNormalizedCoordinates(match.feature2).hnormalized();
+      matches.emplace_back(match);
+    }
+
+    Eigen::Vector3d relative_position, expected_relative_position;
+    EXPECT_TRUE(OptimizeRelativePositionWithKnownRotation(
+        matches,
+        camera1.GetOrientationAsAngleAxis(),
+        camera2.GetOrientationAsAngleAxis(),
+        &expected_relative_position));
+    EXPECT_TRUE(OptimizeRelativePositionWithKnownRotation(
+        matches,
+        camera1.GetOrientationAsAngleAxis(),
+        camera2.GetOrientationAsAngleAxis(),
+        &workspace,
+        &relative_position));
+    EXPECT_EQ(workspace.constraints.size(), matches.size());
+    EXPECT_DOUBLE_EQ((relative_position - expected_relative_position).norm(),
+                     0.0);
+  }
+}
+
 }  // namespace theia
@@ -0,0 +1,77 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#ifndef THEIA_SFM_BUNDLE_ADJUSTMENT_POSITION_PRIOR_ERROR_H_
+#define THEIA_SFM_BUNDLE_ADJUSTMENT_POSITION_PRIOR_ERROR_H_
+
+#include <ceres/ceres.h>
+
+#include <Eigen/Core>
+
+namespace theia {
+
+// The weighted difference between a camera position and its prior (e.g., from
+// GPS). The position is given by the first three entries of the parameter
+// block, so the error may be used with position parameter blocks as well as
+// camera extrinsics parameter blocks.
+struct PositionPriorError {
+ public:
+  PositionPriorError(const Eigen::Vector3d& position_prior, const double weight)
+      : position_prior_(position_prior), weight_(weight) {}
+
+  template <typename T>
+  bool operator()(const T* position, T* residual) const {
+    residual[0] = T(weight_) * (position[0] - T(position_prior_[0]));
+    residual[1] = T(weight_) * (position[1] - T(position_prior_[1]));
+    residual[2] = T(weight_) * (position[2] - T(position_prior_[2]));
+    return true;
+  }
+
+  template <int kParameterSize>
+  static ceres::CostFunction* Create(const Eigen::Vector3d& position_prior,
+                                     const double weight) {
+    return new ceres::AutoDiffCostFunction<PositionPriorError,
+                                           3,
+                                           kParameterSize>(
+        new PositionPriorError(position_prior, weight));
+  }
+
+ private:
+  const Eigen::Vector3d position_prior_;
+  const double weight_;
+};
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_BUNDLE_ADJUSTMENT_POSITION_PRIOR_ERROR_H_
@@ -39,6 +39,7 @@
 #include <Eigen/Geometry>
 #include <glog/logging.h>
 #include <algorithm>
+#include <vector>
 
 #include "theia/sfm/camera_intrinsics_prior.h"
 #include "theia/sfm/camera/camera_intrinsics_model.h"
@@ -226,6 +227,68 @@ Vector3d Camera::PixelToNormalizedCoordinates(const Vector2d& pixel) const {
   return camera_intrinsics_->ImageToCameraCoordinates(pixel);
 }
 
+void Camera::ProjectPoints(const std::vector<Vector4d>& points,
+                           std::vector<Vector2d>* pixels,
+                           std::vector<double>* depths) const {
+  // Points are transformed into the camera coordinate system in fixed-size
+  // blocks on the stack so that the intrinsics are applied to contiguous memory
+  // without allocating a temporary of the size of the input.
+  static const int kBlockSize = 256;
+  CHECK_NOTNULL(pixels)->resize(points.size());
+  if (depths != nullptr) {
+    depths->resize(points.size());
+  }
+
+  const Matrix3d rotation = GetOrientationAsRotationMatrix();
+  const Vector3d position = GetPosition();
+  const int num_points = points.size();
+  Vector3d points_in_camera[kBlockSize];
+  for (int block_start = 0; block_start < num_points;
+       block_start += kBlockSize) {
+    const int block_size = std::min(kBlockSize, num_points - block_start);
+    for (int i = 0; i < block_size; i++) {
+      const Vector4d& point = points[block_start + i];
+      points_in_camera[i].noalias() =
+          rotation * (point.head<3>() - point[3] * position);
+      if (depths != nullptr) {
+        (*depths)[block_start + i] = points_in_camera[i][2] / point[3];
+      }
+    }
+    camera_intrinsics_->CameraToImageCoordinates(
+        block_size, points_in_camera, pixels->data() + block_start);
+  }
+}
+
+void Camera::PixelsToUnitDepthRays(const std::vector<Vector2d>& pixels,
+                                   std::vector<Vector3d>* rays) const {
+  // Remove the effect of calibration.
+  PixelsToNormalizedCoordinates(pixels, rays);
+
+  // Apply rotation.
+  const Matrix3d rotation_transpose =
+      GetOrientationAsRotationMatrix().transpose();
+  for (Vector3d& ray : *rays) {
+    ray = rotation_transpose * ray;
+  }
+}
+
+void Camera::PixelsToNormalizedCoordinates(
+    const std::vector<Vector2d>& pixels,
+    std::vector<Vector3d>* normalized_pixels) const {
+  CHECK_NOTNULL(normalized_pixels)->resize(pixels.size());
+  camera_intrinsics_->ImageToCameraCoordinates(
+      pixels.size(), pixels.data(), normalized_pixels->data());
+}
+
+void Camera::EnableUndistortionLookupTable() {
+  CHECK_GT(ImageWidth(), 0) << "The image size must be set to build the "
+                               "undistortion lookup table.";
+  CHECK_GT(ImageHeight(), 0) << "The image size must be set to build the "
+                                "undistortion lookup table.";
+  camera_intrinsics_->EnableUndistortionLookupTable(ImageWidth(),
+                                                    ImageHeight());
+}
+
 void Camera::PrintCameraIntrinsics() const {
   camera_intrinsics_->PrintIntrinsics();
 }
@@ -146,6 +146,27 @@ class Camera {
   Eigen::Vector3d PixelToNormalizedCoordinates(
       const Eigen::Vector2d& pixel) const;
 
+  // Batch versions of ProjectPoint, PixelToUnitDepthRay and
+  // PixelToNormalizedCoordinates. The rotation matrix is computed once per
+  // batch and the camera intrinsics model is dispatched once per batch instead
+  // of once per point, so these should be preferred when many points are
+  // observed by the same camera. The outputs are resized to the number of input
+  // points. The depths are optional and may be NULL.
+  void ProjectPoints(const std::vector<Eigen::Vector4d>& points,
+                     std::vector<Eigen::Vector2d>* pixels,
+                     std::vector<double>* depths) const;
+  void PixelsToUnitDepthRays(const std::vector<Eigen::Vector2d>& pixels,
+                             std::vector<Eigen::Vector3d>* rays) const;
+  void PixelsToNormalizedCoordinates(
+      const std::vector<Eigen::Vector2d>& pixels,
+      std::vector<Eigen::Vector3d>* normalized_pixels) const;
+
+  // Builds a lookup table to speed up the undistortion of pixels within the
+  // image of this camera. The camera intrinsics are shared by all cameras in
+  // the same intrinsics group, so the table is shared by the group as well. See
+  // CameraIntrinsicsModel::EnableUndistortionLookupTable for details.
+  void EnableUndistortionLookupTable();
+
   // Print the camera intrinsics values in a human-readable format.
   void PrintCameraIntrinsics() const;
 
@@ -42,6 +42,7 @@
 #include "theia/sfm/camera/fov_camera_model.h"
 #include "theia/sfm/camera/pinhole_camera_model.h"
 #include "theia/sfm/camera/pinhole_radial_tangential_camera_model.h"
+#include "theia/sfm/camera/undistortion_lookup_table.h"
 
 namespace theia {
 
@@ -135,6 +136,11 @@ Eigen::Vector2d CameraIntrinsicsModel::CameraToImageCoordinates(
 Eigen::Vector3d CameraIntrinsicsModel::ImageToCameraCoordinates(
     const Eigen::Vector2d& pixel) const {
   Eigen::Vector3d point;
+  if (undistortion_lookup_table_ != nullptr &&
+      undistortion_lookup_table_->IsValidFor(*this) &&
+      undistortion_lookup_table_->ImageToCameraCoordinates(pixel, &point)) {
+    return point;
+  }
 
 // Define the functions that we want to execute in every case of the switch
 // statement. CameraModel will be filled in with the appropriate derived
@@ -151,6 +157,59 @@ Eigen::Vector3d CameraIntrinsicsModel::ImageToCameraCoordinates(
   return point;
 }
 
+void CameraIntrinsicsModel::CameraToImageCoordinates(
+    const int num_points,
+    const Eigen::Vector3d* points,
+    Eigen::Vector2d* pixels) const {
+  const double* intrinsics = parameters();
+
+// Define the functions that we want to execute in every case of the switch
+// statement. CameraModel will be filled in with the appropriate derived
+// class.
+#define CAMERA_MODEL_CASE_BODY(CameraModel)                    \
+  for (int i = 0; i < num_points; i++) {                       \
+    CameraModel::CameraToPixelCoordinates(                     \
+        intrinsics, points[i].data(), pixels[i].data());       \
+  }
+
+  // Execute the switch statement.
+  CAMERA_MODEL_SWITCH_STATEMENT
+
+#undef CAMERA_MODEL_CASE_BODY
+}
+
+void CameraIntrinsicsModel::ImageToCameraCoordinates(
+    const int num_points,
+    const Eigen::Vector2d* pixels,
+    Eigen::Vector3d* points) const {
+  const double* intrinsics = parameters();
+
+  // Use the lookup table where possible and only undistort the remaining
+  // pixels iteratively.
+  const UndistortionLookupTable* lookup_table =
+      (undistortion_lookup_table_ != nullptr &&
+       undistortion_lookup_table_->IsValidFor(*this))
+          ? undistortion_lookup_table_.get()
+          : nullptr;
+
+// Define the functions that we want to execute in every case of the switch
+// statement. CameraModel will be filled in with the appropriate derived
+// class.
+#define CAMERA_MODEL_CASE_BODY(CameraModel)                                  \
+  for (int i = 0; i < num_points; i++) {                                     \
+    if (lookup_table == nullptr ||                                           \
+        !lookup_table->ImageToCameraCoordinates(pixels[i], &points[i])) {    \
+      CameraModel::PixelToCameraCoordinates(                                 \
+          intrinsics, pixels[i].data(), points[i].data());                   \
+    }                                                                        \
+  }
+
+  // Execute the switch statement.
+  CAMERA_MODEL_SWITCH_STATEMENT
+
+#undef CAMERA_MODEL_CASE_BODY
+}
+
 Eigen::Vector2d CameraIntrinsicsModel::DistortPoint(
     const Eigen::Vector2d& undistorted_point) const {
   Eigen::Vector2d distorted_point;
@@ -189,6 +248,34 @@ Eigen::Vector2d CameraIntrinsicsModel::UndistortPoint(
   return undistorted_point;
 }
 
+void CameraIntrinsicsModel::EnableUndistortionLookupTable(
+    const int image_width, const int image_height) {
+  if (undistortion_lookup_table_ != nullptr &&
+      undistortion_lookup_table_->IsValidFor(*this, image_width, image_height)) {
+    return;
+  }
+
+  // Remove the old table first so that the new one is built from the exact
+  // undistortion.
+  undistortion_lookup_table_.reset();
+  std::shared_ptr<UndistortionLookupTable> lookup_table =
+      std::make_shared<UndistortionLookupTable>();
+  lookup_table->Build(*this,
+                      image_width,
+                      image_height,
+                      UndistortionLookupTable::kDefaultGridCellSizePixels);
+  undistortion_lookup_table_ = lookup_table;
+}
+
+void CameraIntrinsicsModel::DisableUndistortionLookupTable() {
+  undistortion_lookup_table_.reset();
+}
+
+void CameraIntrinsicsModel::SetUndistortionLookupTable(
+    const std::shared_ptr<const UndistortionLookupTable>& lookup_table) {
+  undistortion_lookup_table_ = lookup_table;
+}
+
 void CameraIntrinsicsModel::SetFocalLength(const double focal_length) {
   // Define the functions that we want to execute in every case of the switch
   // statement. CameraModel will be filled in with the appropriate derived
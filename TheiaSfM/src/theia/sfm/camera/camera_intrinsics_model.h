@@ -48,6 +48,7 @@
 #include "theia/sfm/camera_intrinsics_prior.h"
 
 namespace theia {
+class UndistortionLookupTable;
 
 // This class encapsulates the camera lens model used for projecting points in
 // space onto the pixels in images. We utilize two coordinate systems:
@@ -180,6 +181,39 @@ class CameraIntrinsicsModel {
   virtual Eigen::Vector3d ImageToCameraCoordinates(
       const Eigen::Vector2d& pixel) const;
 
+  // Batch versions of the two methods above. The camera model is dispatched
+  // once per batch rather than once per point so that the static projection
+  // methods of the derived class are inlined into a tight loop over the points.
+  // This is considerably faster when many points are observed by one camera.
+  void CameraToImageCoordinates(const int num_points,
+                                const Eigen::Vector3d* points,
+                                Eigen::Vector2d* pixels) const;
+  void ImageToCameraCoordinates(const int num_points,
+                                const Eigen::Vector2d* pixels,
+                                Eigen::Vector3d* points) const;
+
+  // Builds a lookup table of the undistorted coordinates of pixels in an image
+  // of the given size. ImageToCameraCoordinates then undistorts pixels within
+  // the image from the table and a single Newton step rather than iteratively
+  // (see undistortion_lookup_table.h). This is worthwhile for models with an
+  // iterative undistortion (e.g. fisheye) when many pixels are converted. Since
+  // cameras in the same intrinsics group share their intrinsics, the table is
+  // shared by the group.
+  //
+  // The table is only used while the parameters are the ones it was built
+  // with. Once the parameters change (e.g. after bundle adjustment), pixels are
+  // undistorted iteratively until this method is called again. Calling it with
+  // unchanged parameters and image size is a no-op.
+  void EnableUndistortionLookupTable(const int image_width,
+                                     const int image_height);
+  void DisableUndistortionLookupTable();
+
+  // Uses a lookup table that was built elsewhere, e.g. by an
+  // UndistortionLookupTableCache. As above, it is only used while it is valid
+  // for the parameters.
+  void SetUndistortionLookupTable(
+      const std::shared_ptr<const UndistortionLookupTable>& lookup_table);
+
   // Apply or remove radial distortion to the given point. Points should be
   // given in *normalized* coordinates such that the effects of camera
   // intrinsics are not present.
@@ -209,6 +243,10 @@ class CameraIntrinsicsModel {
  protected:
   std::vector<double> parameters_;
 
+  // Optional lookup table used to initialize the undistortion. The table is not
+  // modified once built so that it may be used by many threads at once.
+  std::shared_ptr<const UndistortionLookupTable> undistortion_lookup_table_;
+
   // Templated method for disk I/O with cereal. This method tells cereal which
   // data members should be used when reading/writing to/from disk.
   friend class cereal::access;
@@ -242,4 +242,56 @@ TEST(Camera, SetCameraIntrinsicsModelType) {
             CameraIntrinsicsModelType::PINHOLE);
 }
 
+TEST(Camera, BatchProjectionMatchesSinglePoint) {
+  static const double kTolerance = 1e-8;
+  // More points than the block size used by ProjectPoints.
+  static const int kNumPoints = 1000;
+  const CameraIntrinsicsModelType camera_model_types[] = {
+    CameraIntrinsicsModelType::PINHOLE,
+    CameraIntrinsicsModelType::PINHOLE_RADIAL_TANGENTIAL,
+    CameraIntrinsicsModelType::FISHEYE,
+    CameraIntrinsicsModelType::FOV,
+    CameraIntrinsicsModelType::DIVISION_UNDISTORTION
+  };
+
+  for (const CameraIntrinsicsModelType camera_model_type : camera_model_types) {
+    Camera camera(camera_model_type);
+    camera.SetFocalLength(800.0);
+    camera.SetPrincipalPoint(400.0, 300.0);
+    camera.SetImageSize(800, 600);
+    camera.SetOrientationFromAngleAxis(0.2 * rng.RandVector3d());
+    camera.SetPosition(rng.RandVector3d());
+
+    std::vector<Vector4d> points(kNumPoints);
+    for (int i = 0; i < kNumPoints; i++) {
+      const Vector3d point_in_camera(rng.RandDouble(-1.0, 1.0),
+                                     rng.RandDouble(-1.0, 1.0),
+                                     rng.RandDouble(2.0, 10.0));
+      points[i] = (camera.GetOrientationAsRotationMatrix().transpose() *
+                       point_in_camera +
+                   camera.GetPosition()).homogeneous();
+    }
+
+    std::vector<Vector2d> pixels;
+    std::vector<double> depths;
+    camera.ProjectPoints(points, &pixels, &depths);
+    ASSERT_EQ(pixels.size(), kNumPoints);
+    ASSERT_EQ(depths.size(), kNumPoints);
+
+    std::vector<Vector3d> rays;
+    camera.PixelsToUnitDepthRays(pixels, &rays);
+    ASSERT_EQ(rays.size(), kNumPoints);
+
+    for (int i = 0; i < kNumPoints; i++) {
+      Vector2d pixel;
+      const double depth = camera.ProjectPoint(points[i], &pixel);
+      EXPECT_NEAR(depth, depths[i], kTolerance);
+      EXPECT_LT((pixel - pixels[i]).norm(), kTolerance);
+
+      const Vector3d ray = camera.PixelToUnitDepthRay(pixels[i]);
+      EXPECT_LT((ray - rays[i]).norm(), kTolerance);
+    }
+  }
+}
+
 }  // namespace theia
@@ -0,0 +1,205 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include <ceres/ceres.h>
+#include <Eigen/Core>
+#include <memory>
+#include <vector>
+
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/camera_intrinsics_model_type.h"
+#include "theia/sfm/camera/create_reprojection_error_cost_function.h"
+#include "theia/sfm/feature.h"
+#include "theia/test/benchmark.h"
+#include "theia/util/random.h"
+
+namespace theia {
+namespace {
+
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+using Eigen::Vector4d;
+
+static const int kNumObservations = 1024;
+static const int kResidualSize = 2;
+static const int kPointSize = 4;
+
+// The reprojection error cost functions of points observed by a single camera
+// along with the parameters they are evaluated at.
+struct ReprojectionErrorProblem {
+  Camera camera;
+  std::vector<Vector4d> points;
+  std::vector<std::unique_ptr<ceres::CostFunction> > cost_functions;
+};
+
+// Creates a camera of the given model and observations of random points in
+// front of it. A fixed seed is used so that every run of the benchmark uses the
+// same data.
+void GenerateReprojectionErrorProblem(
+    const CameraIntrinsicsModelType& camera_model_type,
+    ReprojectionErrorProblem* problem) {
+  RandomNumberGenerator rng(59);
+  Camera& camera = problem->camera;
+  camera.SetCameraIntrinsicsModelType(camera_model_type);
+  camera.SetFocalLength(1000.0);
+  camera.SetPrincipalPoint(500.0, 500.0);
+  camera.SetOrientationFromAngleAxis(0.1 * rng.RandVector3d());
+  camera.SetPosition(rng.RandVector3d());
+
+  problem->points.resize(kNumObservations);
+  problem->cost_functions.resize(kNumObservations);
+  for (int i = 0; i < kNumObservations; i++) {
+    const Vector3d point_in_camera(rng.RandDouble(-1.0, 1.0),
+                                   rng.RandDouble(-1.0, 1.0),
+                                   rng.RandDouble(2.0, 10.0));
+    problem->points[i] =
+        (camera.GetOrientationAsRotationMatrix().transpose() * point_in_camera +
+         camera.GetPosition()).homogeneous();
+
+    Feature feature;
+    camera.ProjectPoint(problem->points[i], &feature);
+    feature += 0.5 * Vector2d(rng.RandGaussian(0.0, 1.0),
+                              rng.RandGaussian(0.0, 1.0));
+    problem->cost_functions[i].reset(
+        CreateReprojectionErrorCostFunction(camera_model_type, feature));
+  }
+}
+
+// Evaluates the reprojection error of every observation, optionally with the
+// jacobians w.r.t. the extrinsics, intrinsics and point as during bundle
+// adjustment. Throughput is reported in residuals per second.
+void RunReprojectionError(const bool compute_jacobians,
+                          benchmark::State* state) {
+  const CameraIntrinsicsModelType camera_model_type =
+      static_cast<CameraIntrinsicsModelType>(state->range(0));
+  ReprojectionErrorProblem problem;
+  GenerateReprojectionErrorProblem(camera_model_type, &problem);
+
+  const int num_intrinsics =
+      problem.camera.CameraIntrinsics()->NumParameters();
+  std::vector<double> extrinsics_jacobian(kResidualSize *
+                                          Camera::kExtrinsicsSize);
+  std::vector<double> intrinsics_jacobian(kResidualSize * num_intrinsics);
+  std::vector<double> point_jacobian(kResidualSize * kPointSize);
+  double* jacobians[3] = { extrinsics_jacobian.data(),
+                           intrinsics_jacobian.data(),
+                           point_jacobian.data() };
+
+  const double* parameters[3] = { problem.camera.parameters(),
+                                  problem.camera.intrinsics(),
+                                  nullptr };
+  double residuals[kResidualSize];
+  while (state->KeepRunning()) {
+    for (int i = 0; i < kNumObservations; i++) {
+      parameters[2] = problem.points[i].data();
+      const bool success = problem.cost_functions[i]->Evaluate(
+          parameters, residuals, compute_jacobians ? jacobians : nullptr);
+      benchmark::DoNotOptimize(success);
+    }
+    benchmark::ClobberMemory();
+  }
+  state->SetItemsProcessed(state->iterations() * kNumObservations);
+}
+
+void BM_ReprojectionErrorResiduals(benchmark::State& state) {
+  RunReprojectionError(false, &state);
+}
+BENCHMARK(BM_ReprojectionErrorResiduals)
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::PINHOLE))
+    ->Arg(static_cast<int>(
+        CameraIntrinsicsModelType::PINHOLE_RADIAL_TANGENTIAL))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FISHEYE))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FOV))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::DIVISION_UNDISTORTION));
+
+void BM_ReprojectionErrorJacobians(benchmark::State& state) {
+  RunReprojectionError(true, &state);
+}
+BENCHMARK(BM_ReprojectionErrorJacobians)
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::PINHOLE))
+    ->Arg(static_cast<int>(
+        CameraIntrinsicsModelType::PINHOLE_RADIAL_TANGENTIAL))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FISHEYE))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FOV))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::DIVISION_UNDISTORTION));
+
+// Projects every point with the single point and the batch projection methods
+// of the camera. Throughput is reported in points per second.
+void RunProjection(const bool use_batch, benchmark::State* state) {
+  const CameraIntrinsicsModelType camera_model_type =
+      static_cast<CameraIntrinsicsModelType>(state->range(0));
+  ReprojectionErrorProblem problem;
+  GenerateReprojectionErrorProblem(camera_model_type, &problem);
+
+  std::vector<Vector2d> pixels(kNumObservations);
+  std::vector<double> depths(kNumObservations);
+  while (state->KeepRunning()) {
+    if (use_batch) {
+      problem.camera.ProjectPoints(problem.points, &pixels, &depths);
+    } else {
+      for (int i = 0; i < kNumObservations; i++) {
+        depths[i] = problem.camera.ProjectPoint(problem.points[i], &pixels[i]);
+      }
+    }
+    benchmark::DoNotOptimize(pixels.data());
+    benchmark::ClobberMemory();
+  }
+  state->SetItemsProcessed(state->iterations() * kNumObservations);
+}
+
+void BM_ProjectPoint(benchmark::State& state) {
+  RunProjection(false, &state);
+}
+BENCHMARK(BM_ProjectPoint)
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::PINHOLE))
+    ->Arg(static_cast<int>(
+        CameraIntrinsicsModelType::PINHOLE_RADIAL_TANGENTIAL))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FISHEYE))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FOV))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::DIVISION_UNDISTORTION));
+
+void BM_ProjectPoints(benchmark::State& state) {
+  RunProjection(true, &state);
+}
+BENCHMARK(BM_ProjectPoints)
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::PINHOLE))
+    ->Arg(static_cast<int>(
+        CameraIntrinsicsModelType::PINHOLE_RADIAL_TANGENTIAL))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FISHEYE))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::FOV))
+    ->Arg(static_cast<int>(CameraIntrinsicsModelType::DIVISION_UNDISTORTION));
+
+}  // namespace
+}  // namespace theia
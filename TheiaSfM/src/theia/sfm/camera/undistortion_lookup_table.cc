@@ -0,0 +1,241 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+
+#include "theia/sfm/camera/undistortion_lookup_table.h"
+
+#include <ceres/jet.h>
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "theia/sfm/camera/camera_intrinsics_model.h"
+#include "theia/sfm/camera/division_undistortion_camera_model.h"
+#include "theia/sfm/camera/fisheye_camera_model.h"
+#include "theia/sfm/camera/fov_camera_model.h"
+#include "theia/sfm/camera/pinhole_camera_model.h"
+#include "theia/sfm/camera/pinhole_radial_tangential_camera_model.h"
+
+namespace theia {
+namespace {
+
+// The largest number of intrinsic parameters of any camera model.
+static const int kMaxNumIntrinsics = 16;
+
+// Refines the undistorted point with one Newton step on the projection of the
+// camera model, i.e. such that CameraToPixelCoordinates(undistorted_point)
+// matches the pixel. The jacobian of the projection is computed with Jets.
+// Returns false if the jacobian is singular.
+template <class CameraModel>
+bool RefineUndistortedPoint(const std::vector<double>& parameters,
+                            const Eigen::Vector2d& pixel,
+                            Eigen::Vector2d* undistorted_point) {
+  typedef ceres::Jet<double, 2> JetT;
+  JetT jet_parameters[kMaxNumIntrinsics];
+  for (int i = 0; i < parameters.size(); i++) {
+    jet_parameters[i] = JetT(parameters[i]);
+  }
+  const JetT point[3] = { JetT(undistorted_point->x(), 0),
+                          JetT(undistorted_point->y(), 1),
+                          JetT(1.0) };
+  JetT projection[2];
+  CameraModel::CameraToPixelCoordinates(jet_parameters, point, projection);
+
+  Eigen::Matrix2d jacobian;
+  jacobian.row(0) = projection[0].v.transpose();
+  jacobian.row(1) = projection[1].v.transpose();
+  const double determinant = jacobian.determinant();
+  if (std::abs(determinant) < 1e-12) {
+    return false;
+  }
+  const Eigen::Vector2d residual(projection[0].a - pixel.x(),
+                                 projection[1].a - pixel.y());
+  *undistorted_point -= jacobian.inverse() * residual;
+  return std::isfinite(undistorted_point->x()) &&
+         std::isfinite(undistorted_point->y());
+}
+
+}  // namespace
+
+void UndistortionLookupTable::Build(const CameraIntrinsicsModel& intrinsics,
+                                    const int image_width,
+                                    const int image_height,
+                                    const int grid_cell_size_pixels) {
+  CHECK_GT(image_width, 0);
+  CHECK_GT(image_height, 0);
+  CHECK_GT(grid_cell_size_pixels, 0);
+  CHECK_LE(intrinsics.NumParameters(), kMaxNumIntrinsics);
+
+  type_ = intrinsics.Type();
+  parameters_.assign(intrinsics.parameters(),
+                     intrinsics.parameters() + intrinsics.NumParameters());
+  image_width_ = image_width;
+  image_height_ = image_height;
+  grid_cell_size_ = grid_cell_size_pixels;
+  inv_grid_cell_size_ = 1.0 / grid_cell_size_;
+
+  // Cover the full image such that the last grid cells end at or beyond the
+  // image border.
+  num_grid_cols_ =
+      (image_width + grid_cell_size_pixels - 1) / grid_cell_size_pixels + 1;
+  num_grid_rows_ =
+      (image_height + grid_cell_size_pixels - 1) / grid_cell_size_pixels + 1;
+
+  // Undistort the grid points exactly.
+  std::vector<Eigen::Vector2d> grid_pixels;
+  grid_pixels.reserve(num_grid_cols_ * num_grid_rows_);
+  for (int y = 0; y < num_grid_rows_; y++) {
+    for (int x = 0; x < num_grid_cols_; x++) {
+      grid_pixels.emplace_back(x * grid_cell_size_, y * grid_cell_size_);
+    }
+  }
+  std::vector<Eigen::Vector3d> grid_points(grid_pixels.size());
+  intrinsics.ImageToCameraCoordinates(
+      grid_pixels.size(), grid_pixels.data(), grid_points.data());
+
+  undistorted_points_.resize(grid_points.size());
+  for (int i = 0; i < grid_points.size(); i++) {
+    undistorted_points_[i] = grid_points[i].hnormalized();
+  }
+}
+
+bool UndistortionLookupTable::IsValidFor(
+    const CameraIntrinsicsModel& intrinsics) const {
+  return type_ == intrinsics.Type() &&
+         parameters_.size() == intrinsics.NumParameters() &&
+         std::equal(parameters_.begin(),
+                    parameters_.end(),
+                    intrinsics.parameters());
+}
+
+bool UndistortionLookupTable::IsValidFor(
+    const CameraIntrinsicsModel& intrinsics,
+    const int image_width,
+    const int image_height) const {
+  return image_width_ == image_width && image_height_ == image_height &&
+         IsValidFor(intrinsics);
+}
+
+bool UndistortionLookupTable::ImageToCameraCoordinates(
+    const Eigen::Vector2d& pixel, Eigen::Vector3d* point) const {
+  if (!(pixel.x() >= 0.0 && pixel.x() <= image_width_ && pixel.y() >= 0.0 &&
+        pixel.y() <= image_height_)) {
+    return false;
+  }
+
+  // Bilinearly interpolate the undistorted points of the enclosing grid cell.
+  const double grid_x = pixel.x() * inv_grid_cell_size_;
+  const double grid_y = pixel.y() * inv_grid_cell_size_;
+  const int col = std::min(static_cast<int>(grid_x), num_grid_cols_ - 2);
+  const int row = std::min(static_cast<int>(grid_y), num_grid_rows_ - 2);
+  const double dx = grid_x - col;
+  const double dy = grid_y - row;
+  const Eigen::Vector2d* top = &undistorted_points_[row * num_grid_cols_ + col];
+  const Eigen::Vector2d* bottom = top + num_grid_cols_;
+  Eigen::Vector2d undistorted_point =
+      (1.0 - dy) * ((1.0 - dx) * top[0] + dx * top[1]) +
+      dy * ((1.0 - dx) * bottom[0] + dx * bottom[1]);
+
+  // Refine the interpolated point with the camera model.
+  bool success = false;
+  switch (type_) {
+    case CameraIntrinsicsModelType::PINHOLE:
+      success = RefineUndistortedPoint<PinholeCameraModel>(
+          parameters_, pixel, &undistorted_point);
+      break;
+    case CameraIntrinsicsModelType::PINHOLE_RADIAL_TANGENTIAL:
+      success = RefineUndistortedPoint<PinholeRadialTangentialCameraModel>(
+          parameters_, pixel, &undistorted_point);
+      break;
+    case CameraIntrinsicsModelType::FISHEYE:
+      success = RefineUndistortedPoint<FisheyeCameraModel>(
+          parameters_, pixel, &undistorted_point);
+      break;
+    case CameraIntrinsicsModelType::FOV:
+      success = RefineUndistortedPoint<FOVCameraModel>(
+          parameters_, pixel, &undistorted_point);
+      break;
+    case CameraIntrinsicsModelType::DIVISION_UNDISTORTION:
+      success = RefineUndistortedPoint<DivisionUndistortionCameraModel>(
+          parameters_, pixel, &undistorted_point);
+      break;
+    default:
+      break;
+  }
+  if (!success) {
+    return false;
+  }
+
+  *point = undistorted_point.homogeneous();
+  return true;
+}
+
+std::shared_ptr<const UndistortionLookupTable>
+UndistortionLookupTableCache::Get(const CameraIntrinsicsModel& intrinsics,
+                                  const int image_width,
+                                  const int image_height) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& table : tables_) {
+      if (table->IsValidFor(intrinsics, image_width, image_height)) {
+        return table;
+      }
+    }
+  }
+
+  // Build the table without holding the lock so that other threads may use
+  // the cached tables meanwhile. If another thread built the same table in the
+  // meantime, that one is used.
+  std::shared_ptr<UndistortionLookupTable> new_table =
+      std::make_shared<UndistortionLookupTable>();
+  new_table->Build(intrinsics,
+                   image_width,
+                   image_height,
+                   UndistortionLookupTable::kDefaultGridCellSizePixels);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& table : tables_) {
+    if (table->IsValidFor(intrinsics, image_width, image_height)) {
+      return table;
+    }
+  }
+  tables_.emplace_back(new_table);
+  return new_table;
+}
+
+}  // namespace theia
@@ -0,0 +1,124 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+
+#ifndef THEIA_SFM_CAMERA_UNDISTORTION_LOOKUP_TABLE_H_
+#define THEIA_SFM_CAMERA_UNDISTORTION_LOOKUP_TABLE_H_
+
+#include <Eigen/Core>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "theia/sfm/camera/camera_intrinsics_model_type.h"
+
+namespace theia {
+class CameraIntrinsicsModel;
+
+// Converting pixels to normalized camera coordinates requires an iterative
+// undistortion for most camera models, which dominates the cost of normalizing
+// features. This table stores the undistorted coordinates of the pixels on a
+// regular grid over the image. A pixel is undistorted by bilinearly
+// interpolating the grid and applying one Newton step on the projection of the
+// camera model, which is accurate to well below a pixel of the exact
+// undistortion.
+//
+// The table is built for a fixed set of intrinsics and is only valid while the
+// intrinsics are unchanged, which may be checked with IsValidFor.
+class UndistortionLookupTable {
+ public:
+  // The grid cell size used by CameraIntrinsicsModel and
+  // UndistortionLookupTableCache. The interpolation followed by one Newton
+  // step is accurate to well below a pixel for typical lenses at this spacing.
+  static const int kDefaultGridCellSizePixels = 8;
+
+  UndistortionLookupTable() {}
+
+  // Builds the table for the intrinsics over pixels in [0, image_width] x
+  // [0, image_height] with grid cells of the given size in pixels.
+  void Build(const CameraIntrinsicsModel& intrinsics,
+             const int image_width,
+             const int image_height,
+             const int grid_cell_size_pixels);
+
+  // Returns true if the table was built for intrinsics of the same type and
+  // parameters and for the given image size.
+  bool IsValidFor(const CameraIntrinsicsModel& intrinsics) const;
+  bool IsValidFor(const CameraIntrinsicsModel& intrinsics,
+                  const int image_width,
+                  const int image_height) const;
+
+  // Computes the normalized camera coordinates (with z = 1) of the pixel.
+  // Returns false if the pixel is outside of the image or the refinement
+  // failed, in which case the exact undistortion should be used instead.
+  bool ImageToCameraCoordinates(const Eigen::Vector2d& pixel,
+                                Eigen::Vector3d* point) const;
+
+ private:
+  CameraIntrinsicsModelType type_ = CameraIntrinsicsModelType::INVALID;
+  std::vector<double> parameters_;
+  int image_width_ = 0;
+  int image_height_ = 0;
+
+  // The grid of undistorted points stored in row-major order.
+  double grid_cell_size_ = 0.0;
+  double inv_grid_cell_size_ = 0.0;
+  int num_grid_cols_ = 0;
+  int num_grid_rows_ = 0;
+  std::vector<Eigen::Vector2d> undistorted_points_;
+};
+
+// A thread-safe set of lookup tables for cameras that are created repeatedly
+// from the same intrinsics, e.g. the cameras built from the intrinsics priors
+// of each image pair during two-view estimation. Each distinct set of
+// intrinsics and image size gets one table that is shared by all such cameras.
+class UndistortionLookupTableCache {
+ public:
+  UndistortionLookupTableCache() {}
+
+  // Returns a table that is valid for the intrinsics and image size, building
+  // it if none of the cached tables is.
+  std::shared_ptr<const UndistortionLookupTable> Get(
+      const CameraIntrinsicsModel& intrinsics,
+      const int image_width,
+      const int image_height);
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<const UndistortionLookupTable> > tables_;
+};
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_CAMERA_UNDISTORTION_LOOKUP_TABLE_H_
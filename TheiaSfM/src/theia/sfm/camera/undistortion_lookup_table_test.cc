@@ -0,0 +1,190 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+
+#include <Eigen/Core>
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/camera/camera_intrinsics_model.h"
+#include "theia/sfm/camera/division_undistortion_camera_model.h"
+#include "theia/sfm/camera/fisheye_camera_model.h"
+#include "theia/sfm/camera/fov_camera_model.h"
+#include "theia/sfm/camera/pinhole_camera_model.h"
+#include "theia/sfm/camera/pinhole_radial_tangential_camera_model.h"
+#include "theia/sfm/camera/undistortion_lookup_table.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+RandomNumberGenerator rng(63);
+
+static const int kImageWidth = 1200;
+static const int kImageHeight = 800;
+
+// Verifies that undistorting pixels with the lookup table matches the exact
+// undistortion of a copy of the intrinsics without a lookup table.
+void TestUndistortionLookupTable(CameraIntrinsicsModel* intrinsics) {
+  static const double kTolerance = 1e-8;
+  static const int kNumPixels = 1000;
+
+  std::shared_ptr<CameraIntrinsicsModel> exact_intrinsics =
+      CameraIntrinsicsModel::Create(intrinsics->Type());
+  *exact_intrinsics = *intrinsics;
+
+  intrinsics->EnableUndistortionLookupTable(kImageWidth, kImageHeight);
+  for (int i = 0; i < kNumPixels; i++) {
+    const Eigen::Vector2d pixel(rng.RandDouble(0.0, kImageWidth),
+                                rng.RandDouble(0.0, kImageHeight));
+    const Eigen::Vector3d point = intrinsics->ImageToCameraCoordinates(pixel);
+    const Eigen::Vector3d expected_point =
+        exact_intrinsics->ImageToCameraCoordinates(pixel);
+    EXPECT_LT((point - expected_point).norm(), kTolerance)
+        << "Pixel: " << pixel.transpose();
+  }
+
+  // Pixels outside of the image are undistorted exactly.
+  const Eigen::Vector2d outside_pixel(-10.0, kImageHeight + 10.0);
+  EXPECT_EQ(intrinsics->ImageToCameraCoordinates(outside_pixel),
+            exact_intrinsics->ImageToCameraCoordinates(outside_pixel));
+}
+
+}  // namespace
+
+TEST(UndistortionLookupTable, Pinhole) {
+  PinholeCameraModel intrinsics;
+  intrinsics.SetFocalLength(1000.0);
+  intrinsics.SetPrincipalPoint(600.0, 400.0);
+  intrinsics.SetRadialDistortion(-0.1, 0.01);
+  TestUndistortionLookupTable(&intrinsics);
+}
+
+TEST(UndistortionLookupTable, PinholeRadialTangential) {
+  PinholeRadialTangentialCameraModel intrinsics;
+  intrinsics.SetFocalLength(1000.0);
+  intrinsics.SetPrincipalPoint(600.0, 400.0);
+  intrinsics.SetRadialDistortion(-0.1, 0.01, 0.001);
+  intrinsics.SetTangentialDistortion(0.001, -0.001);
+  TestUndistortionLookupTable(&intrinsics);
+}
+
+TEST(UndistortionLookupTable, Fisheye) {
+  FisheyeCameraModel intrinsics;
+  intrinsics.SetFocalLength(600.0);
+  intrinsics.SetPrincipalPoint(600.0, 400.0);
+  intrinsics.SetRadialDistortion(0.01, 0.001, 0.0, 0.0);
+  TestUndistortionLookupTable(&intrinsics);
+}
+
+TEST(UndistortionLookupTable, FOV) {
+  FOVCameraModel intrinsics;
+  intrinsics.SetFocalLength(1000.0);
+  intrinsics.SetPrincipalPoint(600.0, 400.0);
+  intrinsics.SetRadialDistortion(0.5);
+  TestUndistortionLookupTable(&intrinsics);
+}
+
+TEST(UndistortionLookupTable, DivisionUndistortion) {
+  DivisionUndistortionCameraModel intrinsics;
+  intrinsics.SetFocalLength(1000.0);
+  intrinsics.SetPrincipalPoint(600.0, 400.0);
+  intrinsics.SetRadialDistortion(-1e-7);
+  TestUndistortionLookupTable(&intrinsics);
+}
+
+TEST(UndistortionLookupTable, InvalidAfterIntrinsicsChange) {
+  FisheyeCameraModel intrinsics;
+  intrinsics.SetFocalLength(600.0);
+  intrinsics.SetPrincipalPoint(600.0, 400.0);
+  intrinsics.SetRadialDistortion(0.01, 0.001, 0.0, 0.0);
+
+  UndistortionLookupTable lookup_table;
+  lookup_table.Build(intrinsics, kImageWidth, kImageHeight, 8);
+  EXPECT_TRUE(lookup_table.IsValidFor(intrinsics));
+  EXPECT_TRUE(lookup_table.IsValidFor(intrinsics, kImageWidth, kImageHeight));
+  EXPECT_FALSE(
+      lookup_table.IsValidFor(intrinsics, kImageWidth, 2 * kImageHeight));
+
+  // Changing the intrinsics invalidates the table, so that the intrinsics fall
+  // back to the exact undistortion until the table is built again.
+  intrinsics.EnableUndistortionLookupTable(kImageWidth, kImageHeight);
+  intrinsics.SetFocalLength(700.0);
+  EXPECT_FALSE(lookup_table.IsValidFor(intrinsics));
+
+  FisheyeCameraModel exact_intrinsics;
+  exact_intrinsics = intrinsics;
+  const Eigen::Vector2d pixel(300.0, 200.0);
+  EXPECT_EQ(intrinsics.ImageToCameraCoordinates(pixel),
+            exact_intrinsics.ImageToCameraCoordinates(pixel));
+
+  // Enabling the table again rebuilds it for the new intrinsics.
+  TestUndistortionLookupTable(&intrinsics);
+}
+
+TEST(UndistortionLookupTableCache, SharesTablesForEqualIntrinsics) {
+  FisheyeCameraModel intrinsics1;
+  intrinsics1.SetFocalLength(600.0);
+  intrinsics1.SetPrincipalPoint(600.0, 400.0);
+  intrinsics1.SetRadialDistortion(0.01, 0.001, 0.0, 0.0);
+  FisheyeCameraModel intrinsics2;
+  intrinsics2 = intrinsics1;
+
+  UndistortionLookupTableCache cache;
+  const std::shared_ptr<const UndistortionLookupTable> table1 =
+      cache.Get(intrinsics1, kImageWidth, kImageHeight);
+  EXPECT_TRUE(table1->IsValidFor(intrinsics1, kImageWidth, kImageHeight));
+  EXPECT_EQ(cache.Get(intrinsics2, kImageWidth, kImageHeight), table1);
+
+  // Other intrinsics or image sizes get their own table.
+  intrinsics2.SetFocalLength(700.0);
+  const std::shared_ptr<const UndistortionLookupTable> table2 =
+      cache.Get(intrinsics2, kImageWidth, kImageHeight);
+  EXPECT_NE(table2, table1);
+  EXPECT_TRUE(table2->IsValidFor(intrinsics2));
+  EXPECT_NE(cache.Get(intrinsics1, kImageWidth, 2 * kImageHeight), table1);
+
+  // A table from the cache is used like one that was built by the intrinsics.
+  FisheyeCameraModel exact_intrinsics;
+  exact_intrinsics = intrinsics1;
+  intrinsics1.SetUndistortionLookupTable(table1);
+  const Eigen::Vector2d pixel(300.0, 200.0);
+  EXPECT_LT((intrinsics1.ImageToCameraCoordinates(pixel) -
+             exact_intrinsics.ImageToCameraCoordinates(pixel))
+                .norm(),
+            1e-8);
+}
+
+}  // namespace theia
@@ -50,6 +50,7 @@
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
 #include "theia/util/threadpool.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 
@@ -135,6 +136,7 @@ TrackEstimator::Summary TrackEstimator::EstimateAllTracks() {
 
 TrackEstimator::Summary TrackEstimator::EstimateTracks(
     const std::unordered_set<TrackId>& track_ids) {
+  ScopedTraceSpan span("EstimateTracks");
   tracks_to_estimate_.clear();
   summary_ = TrackEstimator::Summary();
   num_bad_angles_ = 0;
@@ -178,6 +180,8 @@ TrackEstimator::Summary TrackEstimator::EstimateTracks(
 
   // Wait for all tracks to be estimated.
   pool.reset(nullptr);
+  IncrementTraceCounter("tracks_triangulated",
+                        summary_.estimated_tracks.size());
 
   LOG(INFO) << summary_.estimated_tracks.size() << " tracks were estimated of "
             << summary_.num_triangulation_attempts << " possible tracks. "
@@ -42,6 +42,7 @@
 
 #include "theia/matching/feature_correspondence.h"
 #include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/undistortion_lookup_table.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
 #include "theia/sfm/estimators/estimate_relative_pose.h"
 #include "theia/sfm/estimators/estimate_uncalibrated_relative_pose.h"
@@ -63,8 +64,23 @@ using Eigen::Vector3d;
 
 namespace {
 
+// Uses a cached undistortion lookup table for the camera if a cache is given
+// and the image size is known.
+void SetUndistortionLookupTable(
+    UndistortionLookupTableCache* undistortion_lookup_tables, Camera* camera) {
+  if (undistortion_lookup_tables == nullptr || camera->ImageWidth() <= 0 ||
+      camera->ImageHeight() <= 0) {
+    return;
+  }
+  camera->MutableCameraIntrinsics()->SetUndistortionLookupTable(
+      undistortion_lookup_tables->Get(*camera->CameraIntrinsics(),
+                                      camera->ImageWidth(),
+                                      camera->ImageHeight()));
+}
+
 // Normalizes the image features by the camera intrinsics.
 void NormalizeFeatures(
+    const EstimateTwoViewInfoOptions& options,
     const CameraIntrinsicsPrior& prior1,
     const CameraIntrinsicsPrior& prior2,
     const std::vector<FeatureCorrespondence>& correspondences,
@@ -82,19 +98,32 @@ void NormalizeFeatures(
   if (!prior1.focal_length.is_set || !prior2.focal_length.is_set) {
     camera1.SetFocalLength(1.0);
     camera2.SetFocalLength(1.0);
+  } else {
+    // Lookup tables only pay off for calibrated cameras, which are shared by
+    // many image pairs.
+    SetUndistortionLookupTable(options.undistortion_lookup_tables.get(),
+                               &camera1);
+    SetUndistortionLookupTable(options.undistortion_lookup_tables.get(),
+                               &camera2);
   }
 
-  normalized_correspondences->reserve(correspondences.size());
+  // Normalize the features of each image in one batch.
+  std::vector<Eigen::Vector2d> features1, features2;
+  features1.reserve(correspondences.size());
+  features2.reserve(correspondences.size());
   for (const FeatureCorrespondence& correspondence : correspondences) {
-    FeatureCorrespondence normalized_correspondence;
-    const Eigen::Vector3d normalized_feature1 =
-        camera1.PixelToNormalizedCoordinates(correspondence.feature1);
-    normalized_correspondence.feature1 = normalized_feature1.hnormalized();
-
-    const Eigen::Vector3d normalized_feature2 =
-        camera2.PixelToNormalizedCoordinates(correspondence.feature2);
-    normalized_correspondence.feature2 = normalized_feature2.hnormalized();
+    features1.emplace_back(correspondence.feature1);
+    features2.emplace_back(correspondence.feature2);
+  }
+  std::vector<Eigen::Vector3d> normalized_features1, normalized_features2;
+  camera1.PixelsToNormalizedCoordinates(features1, &normalized_features1);
+  camera2.PixelsToNormalizedCoordinates(features2, &normalized_features2);
 
+  normalized_correspondences->reserve(correspondences.size());
+  for (int i = 0; i < correspondences.size(); i++) {
+    FeatureCorrespondence normalized_correspondence;
+    normalized_correspondence.feature1 = normalized_features1[i].hnormalized();
+    normalized_correspondence.feature2 = normalized_features2[i].hnormalized();
     normalized_correspondences->emplace_back(normalized_correspondence);
   }
 }
@@ -137,8 +166,11 @@ bool EstimateTwoViewInfoCalibrated(
     std::vector<int>* inlier_indices) {
   // Normalize features w.r.t focal length.
   std::vector<FeatureCorrespondence> normalized_correspondences;
-  NormalizeFeatures(
-      intrinsics1, intrinsics2, correspondences, &normalized_correspondences);
+  NormalizeFeatures(options,
+                    intrinsics1,
+                    intrinsics2,
+                    correspondences,
+                    &normalized_correspondences);
 
   // Set the ransac parameters.
   RansacParameters ransac_options;
@@ -197,8 +229,11 @@ bool EstimateTwoViewInfoUncalibrated(
     std::vector<int>* inlier_indices) {
   // Normalize features w.r.t principal point.
   std::vector<FeatureCorrespondence> centered_correspondences;
-  NormalizeFeatures(
-      intrinsics1, intrinsics2, correspondences, &centered_correspondences);
+  NormalizeFeatures(options,
+                    intrinsics1,
+                    intrinsics2,
+                    correspondences,
+                    &centered_correspondences);
 
   // Set the ransac parameters.
   RansacParameters ransac_options;
@@ -44,6 +44,7 @@ namespace theia {
 
 class RandomNumberGenerator;
 class TwoViewInfo;
+class UndistortionLookupTableCache;
 struct CameraIntrinsicsPrior;
 struct FeatureCorrespondence;
 
@@ -70,6 +71,12 @@ struct EstimateTwoViewInfoOptions {
   int min_ransac_iterations = 10;
   int max_ransac_iterations = 1000;
   bool use_mle = true;
+
+  // If set, the features are normalized with undistortion lookup tables from
+  // this cache (see camera/undistortion_lookup_table.h). The cache may be
+  // shared by all image pairs so that a table is built once for each distinct
+  // camera rather than for each pair.
+  std::shared_ptr<UndistortionLookupTableCache> undistortion_lookup_tables;
 };
 
 // Estimates two view info for the given view pair from the correspondences. The
@@ -61,6 +61,23 @@ class EssentialMatrixEstimator
   // Estimates candidate essential matrices from correspondences.
   bool EstimateModel(const std::vector<FeatureCorrespondence>& correspondences,
                      std::vector<Eigen::Matrix3d>* essential_matrices) const {
+    // Minimal samples use the fixed-size solver to avoid heap allocations.
+    if (correspondences.size() == 5) {
+      Eigen::Vector2d image1_points[5], image2_points[5];
+      for (int i = 0; i < 5; i++) {
+        image1_points[i] = correspondences[i].feature1;
+        image2_points[i] = correspondences[i].feature2;
+      }
+
+      Eigen::Matrix3d solutions[kMaxNumFivePointSolutions];
+      const int num_solutions =
+          FivePointRelativePoseMinimal(image1_points, image2_points, solutions);
+      essential_matrices->insert(essential_matrices->end(),
+                                 solutions,
+                                 solutions + num_solutions);
+      return num_solutions > 0;
+    }
+
     std::vector<Eigen::Vector2d> image1_points, image2_points;
     image1_points.reserve(correspondences.size());
     image2_points.reserve(correspondences.size());
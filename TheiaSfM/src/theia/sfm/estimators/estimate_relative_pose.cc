@@ -36,6 +36,7 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <algorithm>
 #include <limits>
 #include <memory>
 #include <vector>
@@ -71,23 +72,41 @@ class RelativePoseEstimator
   // Estimates candidate relative poses from correspondences.
   bool EstimateModel(const std::vector<FeatureCorrespondence>& correspondences,
                      std::vector<RelativePose>* relative_poses) const {
-    std::vector<Eigen::Vector2d> image1_points, image2_points;
-    image1_points.reserve(correspondences.size());
-    image2_points.reserve(correspondences.size());
-    for (int i = 0; i < correspondences.size(); i++) {
-      image1_points.emplace_back(correspondences[i].feature1);
-      image2_points.emplace_back(correspondences[i].feature2);
+    Matrix3d essential_matrices[kMaxNumFivePointSolutions];
+    int num_essential_matrices = 0;
+    if (correspondences.size() == 5) {
+      // Minimal samples use the fixed-size solver to avoid heap allocations.
+      Eigen::Vector2d image1_points[5], image2_points[5];
+      for (int i = 0; i < 5; i++) {
+        image1_points[i] = correspondences[i].feature1;
+        image2_points[i] = correspondences[i].feature2;
+      }
+      num_essential_matrices = FivePointRelativePoseMinimal(
+          image1_points, image2_points, essential_matrices);
+    } else {
+      std::vector<Eigen::Vector2d> image1_points, image2_points;
+      image1_points.reserve(correspondences.size());
+      image2_points.reserve(correspondences.size());
+      for (int i = 0; i < correspondences.size(); i++) {
+        image1_points.emplace_back(correspondences[i].feature1);
+        image2_points.emplace_back(correspondences[i].feature2);
+      }
+      std::vector<Matrix3d> solutions;
+      FivePointRelativePose(image1_points, image2_points, &solutions);
+      num_essential_matrices =
+          std::min<int>(solutions.size(), kMaxNumFivePointSolutions);
+      std::copy(solutions.begin(),
+                solutions.begin() + num_essential_matrices,
+                essential_matrices);
     }
 
-    std::vector<Matrix3d> essential_matrices;
-    if (!FivePointRelativePose(image1_points,
-                               image2_points,
-                               &essential_matrices)) {
+    if (num_essential_matrices == 0) {
       return false;
     }
 
-    relative_poses->reserve(essential_matrices.size() * 4);
-    for (const Eigen::Matrix3d& essential_matrix : essential_matrices) {
+    relative_poses->reserve(num_essential_matrices * 4);
+    for (int i = 0; i < num_essential_matrices; i++) {
+      const Matrix3d& essential_matrix = essential_matrices[i];
       RelativePose relative_pose;
       relative_pose.essential_matrix = essential_matrix;
 
@@ -55,8 +55,10 @@
 #include "theia/sfm/exif_reader.h"
 #include "theia/sfm/two_view_match_geometric_verification.h"
 #include "theia/util/filesystem.h"
+#include "theia/util/progress_reporter.h"
 #include "theia/util/string.h"
 #include "theia/util/threadpool.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 namespace {
@@ -192,6 +194,12 @@ void FeatureExtractorAndMatcher::ExtractAndMatchFeatures(
   CHECK_NOTNULL(matches);
   CHECK_NOTNULL(matcher_.get());
 
+  ProgressReporter* progress_reporter =
+      options_.feature_matcher_options.progress_reporter.get();
+  if (progress_reporter != nullptr) {
+    progress_reporter->BeginStage("ExtractFeatures", image_filepaths_.size());
+  }
+
   // For each image, process the features and add it to the matcher.
   const int num_threads =
       std::min(options_.num_threads, static_cast<int>(image_filepaths_.size()));
@@ -202,11 +210,24 @@ void FeatureExtractorAndMatcher::ExtractAndMatchFeatures(
                  << " because the file cannot be found.";
       continue;
     }
-    thread_pool->Add(&FeatureExtractorAndMatcher::ProcessImage, this, i);
+    thread_pool->Add([this, i, progress_reporter]() {
+      if (progress_reporter != nullptr && progress_reporter->IsCancelled()) {
+        return;
+      }
+      ProcessImage(i);
+      if (progress_reporter != nullptr) {
+        progress_reporter->Increment();
+      }
+    });
   }
   // This forces all tasks to complete before proceeding.
   thread_pool.reset(nullptr);
 
+  if (progress_reporter != nullptr && progress_reporter->IsCancelled()) {
+    LOG(INFO) << "Feature extraction was cancelled.";
+    return;
+  }
+
   // After all threads complete feature extraction, perform matching.
 
   // Perform the matching.
@@ -220,6 +241,7 @@ void FeatureExtractorAndMatcher::ExtractAndMatchFeatures(
 }
 
 void FeatureExtractorAndMatcher::ProcessImage(const int i) {
+  ScopedTraceSpan span("ExtractFeatures");
   const std::string& image_filepath = image_filepaths_[i];
 
   // Get the camera intrinsics prior if it was provided.
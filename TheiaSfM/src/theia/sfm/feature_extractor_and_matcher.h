@@ -79,6 +79,8 @@ class FeatureExtractorAndMatcher {
     MatchingStrategy matching_strategy;
 
     // Matching options for determining which feature matches are good matches.
+    // If feature_matcher_options.progress_reporter is set, it also receives the
+    // progress of feature extraction.
     FeatureMatcherOptions feature_matcher_options;
   };
 
@@ -107,7 +109,8 @@ class FeatureExtractorAndMatcher {
   // filepaths. Features are extracted and matched between the images according
   // to the options passed in. Only matches that have passed geometric
   // verification are kept. EXIF data is parsed to determine the camera
-  // intrinsics if available.
+  // intrinsics if available. If the progress reporter is cancelled, this
+  // returns early and the outputs are incomplete.
   void ExtractAndMatchFeatures(std::vector<CameraIntrinsicsPrior>* intrinsics,
                                std::vector<ImagePairMatch>* matches);
 
@@ -37,9 +37,12 @@
 #include <ceres/rotation.h>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <algorithm>
+#include <future>  // NOLINT
+#include <limits>
 #include <memory>
-#include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "theia/math/util.h"
 #include "theia/util/hash.h"
@@ -194,30 +197,20 @@ void ComputeMeanVariance(
   *variance /= static_cast<double>(relative_translations.size() - 1);
 }
 
-// Performs a single iterations of the translation filtering. This method is
-// thread-safe.
+// Performs a single iterations of the translation filtering and adds the bad
+// weight of each edge to edge_weights. This method is thread-safe.
 void TranslationFilteringIteration(
     const std::unordered_map<ViewIdPair, Vector3d>& relative_translations,
+    const std::vector<ViewIdPair>& edges,
     const Vector3d& direction_mean,
     const Vector3d& direction_variance,
-    const std::shared_ptr<RandomNumberGenerator>& rng,
-    std::mutex* mutex,
-    std::unordered_map<ViewIdPair, double>* bad_edge_weight) {
-  // Create the random number generator within each thread. If the random number
-  // generator is not supplied then create a new one within each thread.
-  std::shared_ptr<RandomNumberGenerator> local_rng;
-  if (rng.get() == nullptr) {
-    local_rng = std::make_shared<RandomNumberGenerator>();
-  } else {
-    local_rng = rng;
-  }
-
+    RandomNumberGenerator* rng,
+    std::vector<double>* edge_weights) {
   // Get a random vector to project all relative translations on to.
   const Vector3d random_axis =
-      Vector3d(
-          local_rng->RandGaussian(direction_mean[0], direction_variance[0]),
-          local_rng->RandGaussian(direction_mean[1], direction_variance[1]),
-          local_rng->RandGaussian(direction_mean[2], direction_variance[2]))
+      Vector3d(rng->RandGaussian(direction_mean[0], direction_variance[0]),
+               rng->RandGaussian(direction_mean[1], direction_variance[1]),
+               rng->RandGaussian(direction_mean[2], direction_variance[2]))
           .normalized();
 
   // Project all vectors.
@@ -230,23 +223,23 @@ void TranslationFilteringIteration(
       OrderTranslationsFromProjections(translation_direction_projections);
 
   // Compute bad edge weights.
-  for (auto& edge : *bad_edge_weight) {
-    const int ordering_diff =
-        FindOrDie(translation_ordering, edge.first.second) -
-        FindOrDie(translation_ordering, edge.first.first);
+  edge_weights->assign(edges.size(), 0.0);
+  for (int i = 0; i < edges.size(); i++) {
+    const ViewIdPair& edge = edges[i];
+    const int ordering_diff = FindOrDie(translation_ordering, edge.second) -
+                              FindOrDie(translation_ordering, edge.first);
     const double& projection_weight_of_edge =
-        FindOrDieNoPrint(translation_direction_projections, edge.first);
+        FindOrDieNoPrint(translation_direction_projections, edge);
 
-    VLOG(3) << "Edge (" << edge.first.first << ", " << edge.first.second
+    VLOG(3) << "Edge (" << edge.first << ", " << edge.second
             << ") has ordering diff of " << ordering_diff
             << " and a projection of " << projection_weight_of_edge << " from "
-            << FindOrDieNoPrint(relative_translations, edge.first).transpose();
+            << FindOrDieNoPrint(relative_translations, edge).transpose();
     // If the ordering is inconsistent, add the absolute value of the bad weight
     // to the aggregate bad weight.
     if ((ordering_diff < 0 && projection_weight_of_edge > 0) ||
         (ordering_diff > 0 && projection_weight_of_edge < 0)) {
-      std::lock_guard<std::mutex> lock(*mutex);
-      edge.second += std::abs(projection_weight_of_edge);
+      (*edge_weights)[i] = std::abs(projection_weight_of_edge);
     }
   }
 }
@@ -261,10 +254,12 @@ void FilterViewPairsFromRelativeTranslation(
 
   // Weights of edges that have been accumulated throughout the iterations. A
   // higher weight means the edge is more likely to be bad.
-  std::unordered_map<ViewIdPair, double> bad_edge_weight;
+  std::vector<ViewIdPair> edges;
+  edges.reserve(view_pairs.size());
   for (const auto& view_pair : view_pairs) {
-    bad_edge_weight[view_pair.first] = 0.0;
+    edges.emplace_back(view_pair.first);
   }
+  std::vector<double> bad_edge_weight(edges.size(), 0.0);
 
   // Compute the adjusted translations so that they are oriented in the global
   // frame.
@@ -276,29 +271,60 @@ void FilterViewPairsFromRelativeTranslation(
                       &translation_mean,
                       &translation_variance);
 
-  std::unique_ptr<ThreadPool> pool(new ThreadPool(options.num_threads));
-  std::mutex mutex;
-  for (int i = 0; i < options.num_iterations; i++) {
-    pool->Add(TranslationFilteringIteration,
-              rotated_translations,
-              translation_mean,
-              translation_variance,
-              options.rng,
-              &mutex,
-              &bad_edge_weight);
+  // If a random number generator is given, each iteration draws its axis from a
+  // stream seeded by the iteration index. The iterations run in batches of
+  // num_threads and their weights are summed in the order of the iterations, so
+  // the result does not depend on the number of threads or on scheduling.
+  const unsigned seed =
+      options.rng == nullptr
+          ? 0
+          : static_cast<unsigned>(
+                options.rng->RandInt(0, std::numeric_limits<int>::max()));
+  const int batch_size = std::max(options.num_threads, 1);
+  std::vector<std::vector<double> > iteration_edge_weights(batch_size);
+  ThreadPool pool(batch_size);
+  for (int i = 0; i < options.num_iterations; i += batch_size) {
+    const int num_iterations_in_batch =
+        std::min(batch_size, options.num_iterations - i);
+    std::vector<std::future<void> > iterations;
+    for (int j = 0; j < num_iterations_in_batch; j++) {
+      const int iteration = i + j;
+      std::vector<double>* edge_weights = &iteration_edge_weights[j];
+      iterations.emplace_back(pool.Add([&, iteration, edge_weights]() {
+        // The generator must be created within the thread that uses it.
+        std::unique_ptr<RandomNumberGenerator> rng(
+            options.rng == nullptr
+                ? new RandomNumberGenerator()
+                : new RandomNumberGenerator(DeriveSeed(seed, iteration)));
+        TranslationFilteringIteration(rotated_translations,
+                                      edges,
+                                      translation_mean,
+                                      translation_variance,
+                                      rng.get(),
+                                      edge_weights);
+      }));
+    }
+    // Wait for the iterations of the batch to finish.
+    for (auto& iteration : iterations) {
+      iteration.get();
+    }
+
+    for (int j = 0; j < num_iterations_in_batch; j++) {
+      for (int k = 0; k < edges.size(); k++) {
+        bad_edge_weight[k] += iteration_edge_weights[j][k];
+      }
+    }
   }
-  // Wait for tasks to finish.
-  pool.reset(nullptr);
 
   // Remove all the bad edges.
   const double max_aggregated_projection_tolerance =
       options.translation_projection_tolerance * options.num_iterations;
   int num_view_pairs_removed = 0;
-  for (const auto& view_pair : bad_edge_weight) {
-    VLOG(3) << "View pair (" << view_pair.first.first << ", "
-            << view_pair.first.second << ") projection = " << view_pair.second;
-    if (view_pair.second > max_aggregated_projection_tolerance) {
-      view_graph->RemoveEdge(view_pair.first.first, view_pair.first.second);
+  for (int i = 0; i < edges.size(); i++) {
+    VLOG(3) << "View pair (" << edges[i].first << ", " << edges[i].second
+            << ") projection = " << bad_edge_weight[i];
+    if (bad_edge_weight[i] > max_aggregated_projection_tolerance) {
+      view_graph->RemoveEdge(edges[i].first, edges[i].second);
       ++num_view_pairs_removed;
     }
   }
@@ -215,4 +215,34 @@ TEST(FilterViewPairsFromRelativeTranslation, ManyBadRotations) {
   TestFilterViewPairsFromRelativeTranslation(30, 100, 30);
 }
 
+TEST(FilterViewPairsFromRelativeTranslation, IndependentOfNumThreads) {
+  std::unordered_map<ViewId, Vector3d> orientations;
+  std::unordered_map<ViewId, Vector3d> positions;
+  CreateViewsWithRandomPoses(30, &orientations, &positions);
+  ViewGraph view_graph;
+  CreateValidViewPairs(100, orientations, positions, &view_graph);
+  CreateInvalidViewPairs(30, orientations, positions, &view_graph);
+
+  ViewGraph multithreaded_view_graph;
+  for (const auto& view_pair : view_graph.GetAllEdges()) {
+    multithreaded_view_graph.AddEdge(
+        view_pair.first.first, view_pair.first.second, view_pair.second);
+  }
+
+  FilterViewPairsFromRelativeTranslationOptions options;
+  options.rng = std::make_shared<RandomNumberGenerator>(233);
+  FilterViewPairsFromRelativeTranslation(options, orientations, &view_graph);
+
+  options.rng = std::make_shared<RandomNumberGenerator>(233);
+  options.num_threads = 4;
+  FilterViewPairsFromRelativeTranslation(
+      options, orientations, &multithreaded_view_graph);
+
+  EXPECT_EQ(view_graph.NumEdges(), multithreaded_view_graph.NumEdges());
+  for (const auto& view_pair : view_graph.GetAllEdges()) {
+    EXPECT_TRUE(multithreaded_view_graph.HasEdge(view_pair.first.first,
+                                                 view_pair.first.second));
+  }
+}
+
 }  // namespace theia
@@ -38,6 +38,7 @@
 #include <Eigen/SparseCore>
 #include <ceres/rotation.h>
 
+#include <algorithm>
 #include <limits>
 #include <unordered_map>
 #include <vector>
@@ -86,6 +87,9 @@ bool LeastUnsquaredDeviationPositionEstimator::EstimatePositions(
   SetupConstraintMatrix(view_pairs, orientations);
   Eigen::VectorXd solution;
   solution.setZero(constraint_matrix_.cols());
+  if (!initial_positions_.empty()) {
+    InitializeSolutionFromInitialPositions(view_pairs, orientations, &solution);
+  }
 
   // Create the lower bound constraint enforcing that all scales are > 1.
   Eigen::SparseMatrix<double> geq_mat(num_view_pairs,
@@ -102,9 +106,13 @@ bool LeastUnsquaredDeviationPositionEstimator::EstimatePositions(
   // Solve for camera positions by solving a constrained L1 problem to enforce
   // all relative translations scales > 1.
   ConstrainedL1Solver::Options l1_options;
+  l1_options.max_num_iterations = options_.max_num_iterations;
+  l1_options.adaptive_penalty = options_.adaptive_penalty;
   ConstrainedL1Solver solver(
       l1_options, constraint_matrix_, b, geq_mat, geq_vec);
-  solver.Solve(&solution);
+  const ConstrainedL1Solver::Summary summary = solver.Solve(&solution);
+  VLOG(2) << "The L1 solver " << (summary.converged ? "converged" : "stopped")
+          << " after " << summary.num_iterations << " iterations.";
 
   // Set the estimated positions.
   for (const auto& view_id_index : view_id_to_index_) {
@@ -120,6 +128,87 @@ bool LeastUnsquaredDeviationPositionEstimator::EstimatePositions(
   return true;
 }
 
+void LeastUnsquaredDeviationPositionEstimator::SetInitialPositions(
+    const std::unordered_map<ViewId, Vector3d>& initial_positions) {
+  initial_positions_ = initial_positions;
+}
+
+void LeastUnsquaredDeviationPositionEstimator::
+    InitializeSolutionFromInitialPositions(
+        const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
+        const std::unordered_map<ViewId, Vector3d>& orientations,
+        Eigen::VectorXd* solution) const {
+  // The constant view is at the origin of the linear system.
+  Vector3d origin = Vector3d::Zero();
+  for (const auto& view_id_index : view_id_to_index_) {
+    if (view_id_index.second == kConstantViewIndex) {
+      const Vector3d* position =
+          FindOrNull(initial_positions_, view_id_index.first);
+      if (position != nullptr) {
+        origin = *position;
+      }
+      break;
+    }
+  }
+
+  // Compute the scale of each relative translation from the initial positions.
+  std::unordered_map<ViewIdPair, double> scales;
+  std::vector<double> positive_scales;
+  scales.reserve(view_id_pair_to_index_.size());
+  positive_scales.reserve(view_id_pair_to_index_.size());
+  for (const auto& view_pair : view_pairs) {
+    if (!ContainsKey(view_id_pair_to_index_, view_pair.first)) {
+      continue;
+    }
+    const Vector3d* position1 =
+        FindOrNull(initial_positions_, view_pair.first.first);
+    const Vector3d* position2 =
+        FindOrNull(initial_positions_, view_pair.first.second);
+    if (position1 == nullptr || position2 == nullptr) {
+      continue;
+    }
+    const Vector3d translation_direction =
+        GetRotatedTranslation(FindOrDie(orientations, view_pair.first.first),
+                              view_pair.second.position_2);
+    const double scale = (*position2 - *position1).dot(translation_direction);
+    scales[view_pair.first] = scale;
+    if (scale > 0.0) {
+      positive_scales.emplace_back(scale);
+    }
+  }
+  if (positive_scales.empty()) {
+    LOG(WARNING) << "The initial positions do not agree with any relative "
+                    "translation. Starting the solver from the origin.";
+    return;
+  }
+
+  // Scale the positions so that most relative translations have a scale of at
+  // least 1. A low quantile is used rather than the minimum so that a few
+  // inconsistent positions do not inflate the scale of the problem.
+  static const double kScaleQuantile = 0.1;
+  std::vector<double>::iterator quantile =
+      positive_scales.begin() + kScaleQuantile * (positive_scales.size() - 1);
+  std::nth_element(positive_scales.begin(), quantile, positive_scales.end());
+  const double position_scale = 1.0 / *quantile;
+
+  for (const auto& view_id_index : view_id_to_index_) {
+    if (view_id_index.second == kConstantViewIndex) {
+      continue;
+    }
+    const Vector3d* position =
+        FindOrNull(initial_positions_, view_id_index.first);
+    if (position != nullptr) {
+      solution->segment<3>(view_id_index.second) =
+          position_scale * (*position - origin);
+    }
+  }
+  for (const auto& view_id_pair_index : view_id_pair_to_index_) {
+    const double* scale = FindOrNull(scales, view_id_pair_index.first);
+    (*solution)(view_id_pair_index.second) =
+        scale == nullptr ? 1.0 : std::max(1.0, position_scale * *scale);
+  }
+}
+
 void LeastUnsquaredDeviationPositionEstimator::InitializeIndexMapping(
     const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
     const std::unordered_map<ViewId, Vector3d>& orientations) {
@@ -134,6 +223,7 @@ void LeastUnsquaredDeviationPositionEstimator::InitializeIndexMapping(
 
   // Create a mapping from the view id to the index of the linear system.
   int index = kConstantViewIndex;
+  view_id_to_index_.clear();
   view_id_to_index_.reserve(views.size());
   for (const ViewId view_id : views) {
     view_id_to_index_[view_id] = index;
@@ -141,6 +231,7 @@ void LeastUnsquaredDeviationPositionEstimator::InitializeIndexMapping(
   }
 
   // Create a mapping from the view id pair to the index of the linear system.
+  view_id_pair_to_index_.clear();
   view_id_pair_to_index_.reserve(view_pairs.size());
   for (const auto& view_pair : view_pairs) {
     if (ContainsKey(view_id_to_index_, view_pair.first.first) &&
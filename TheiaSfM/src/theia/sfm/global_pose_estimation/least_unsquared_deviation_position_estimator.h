@@ -66,6 +66,10 @@ class LeastUnsquaredDeviationPositionEstimator : public PositionEstimator {
 
     // A measurement for convergence criterion.
     double convergence_criterion = 1e-4;
+
+    // If true, the ADMM penalty is adapted to balance the primal and dual
+    // residuals, which typically reduces the number of iterations.
+    bool adaptive_penalty = true;
   };
 
   LeastUnsquaredDeviationPositionEstimator(
@@ -78,6 +82,14 @@ class LeastUnsquaredDeviationPositionEstimator : public PositionEstimator {
       const std::unordered_map<ViewId, Eigen::Vector3d>& orientation,
       std::unordered_map<ViewId, Eigen::Vector3d>* positions);
 
+  // Sets initial positions (e.g. from another position estimator or from GPS
+  // priors) that are used to warm start the solver in subsequent calls to
+  // EstimatePositions. The positions must be in the frame of the global
+  // orientations but may have an arbitrary scale and origin. Views without an
+  // initial position are initialized at the origin.
+  void SetInitialPositions(
+      const std::unordered_map<ViewId, Eigen::Vector3d>& initial_positions);
+
  private:
   void InitializeIndexMapping(
       const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
@@ -88,6 +100,15 @@ class LeastUnsquaredDeviationPositionEstimator : public PositionEstimator {
       const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
       const std::unordered_map<ViewId, Eigen::Vector3d>& orientations);
 
+  // Sets the initial solution of the linear system from the initial positions.
+  // The positions are translated so that the constant view is at the origin
+  // and scaled so that the scales of the relative translations satisfy the
+  // constraints.
+  void InitializeSolutionFromInitialPositions(
+      const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
+      const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
+      Eigen::VectorXd* solution) const;
+
   const LeastUnsquaredDeviationPositionEstimator::Options options_;
 
   std::unordered_map<ViewIdPair, int> view_id_pair_to_index_;
@@ -96,6 +117,8 @@ class LeastUnsquaredDeviationPositionEstimator : public PositionEstimator {
 
   Eigen::SparseMatrix<double> constraint_matrix_;
 
+  std::unordered_map<ViewId, Eigen::Vector3d> initial_positions_;
+
   friend class EstimatePositionsLeastUnsquaredDeviationTest;
 
   DISALLOW_COPY_AND_ASSIGN(LeastUnsquaredDeviationPositionEstimator);
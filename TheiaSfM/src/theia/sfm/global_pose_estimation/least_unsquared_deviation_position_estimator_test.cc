@@ -123,13 +123,23 @@ class EstimatePositionsLeastUnsquaredDeviationTest : public ::testing::Test {
       const int num_views,
       const int num_view_pairs,
       const double pose_noise,
-      const double position_tolerance) {
+      const double position_tolerance,
+      const bool warm_start = false) {
     // Set up the scene.
     SetupScene(num_views);
     GetTwoViewInfos(num_view_pairs, pose_noise);
 
     // Estimate the positions.
     LeastUnsquaredDeviationPositionEstimator position_estimator(options_);
+    if (warm_start) {
+      // Initialize from perturbed positions with a different scale and origin.
+      std::unordered_map<ViewId, Vector3d> initial_positions;
+      for (const auto& position : positions_) {
+        initial_positions[position.first] =
+            0.5 * (position.second + rng.RandVector3d()) + Vector3d(1, 2, 3);
+      }
+      position_estimator.SetInitialPositions(initial_positions);
+    }
     std::unordered_map<ViewId, Vector3d> estimated_positions;
     EXPECT_TRUE(position_estimator.EstimatePositions(view_pairs_,
                                                      orientations_,
@@ -237,4 +247,17 @@ TEST_F(EstimatePositionsLeastUnsquaredDeviationTest, SmallTestWithNoise) {
                                                kTolerance);
 }
 
+TEST_F(EstimatePositionsLeastUnsquaredDeviationTest, WarmStartWithNoise) {
+  static const double kTolerance = 0.1;
+  static const int kNumViews = 4;
+  static const int kNumViewPairs = 6;
+  static const double kPoseNoiseDegrees = 1.0;
+  static const bool kWarmStart = true;
+  TestLeastUnsquaredDeviationPositionEstimator(kNumViews,
+                                               kNumViewPairs,
+                                               kPoseNoiseDegrees,
+                                               kTolerance,
+                                               kWarmStart);
+}
+
 }  // namespace theia
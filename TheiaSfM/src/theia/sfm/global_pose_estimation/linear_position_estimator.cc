@@ -40,6 +40,7 @@
 #include <algorithm>
 #include <ceres/rotation.h>
 #include <glog/logging.h>
+#include <iterator>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -49,7 +50,6 @@
 
 #include "theia/math/graph/triplet_extractor.h"
 #include "theia/math/matrix/spectra_linear_operator.h"
-#include "theia/sfm/find_common_tracks_in_views.h"
 #include "theia/sfm/global_pose_estimation/compute_triplet_baseline_ratios.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/types.h"
@@ -91,41 +91,55 @@ std::vector<ViewIdTriplet> GetLargetConnectedTripletGraph(
 //
 //   A^t * A += Row(i)^t * Row(i)
 //
-// for each triplet constraint i.
+// for each triplet constraint i. If we denote the row as a block matrix:
+//
+//   Row(i) = [A | B | C]
+//
+// then we have:
+//
+//   Row(i)^t * Row(i) = [A | B | C]^t * [A | B | C]
+//                     = [ A^t * A  |  A^t * B  |  A^t * C]
+//                       [ B^t * A  |  B^t * B  |  B^t * C]
+//                       [ C^t * A  |  C^t * B  |  C^t * C]
+//
+// The 9x9 matrix of all constraints of a triplet is accumulated first so that
+// each entry of A^t * A is only added once per triplet.
 void AddTripletConstraintToSymmetricMatrix(
-    const std::vector<Matrix3d>& constraints,
-    const std::vector<int>& view_indices,
-    std::unordered_map<std::pair<int, int>, double>* sparse_matrix_entries) {
-  // Construct Row(i)^t * Row(i). If we denote the row as a block matrix:
-  //
-  //   Row(i) = [A | B | C]
-  //
-  // then we have:
-  //
-  //   Row(i)^t * Row(i) = [A | B | C]^t * [A | B | C]
-  //                     = [ A^t * A  |  A^t * B  |  A^t * C]
-  //                       [ B^t * A  |  B^t * B  |  B^t * C]
-  //                       [ C^t * A  |  C^t * B  |  C^t * C]
-  //
-  // Since A^t * A is symmetric, we only store the upper triangular portion.
+    const Matrix3d& constraint0,
+    const Matrix3d& constraint1,
+    const Matrix3d& constraint2,
+    Eigen::Matrix<double, 9, 9>* symmetric_constraint) {
+  Eigen::Matrix<double, 3, 9> row;
+  row << constraint0, constraint1, constraint2;
+  symmetric_constraint->noalias() += row.transpose() * row;
+}
+
+// Adds the 3x3 blocks of the accumulated triplet constraint to the sparse
+// matrix entries. Since A^t * A is symmetric, we only store the upper
+// triangular portion. Blocks of the constant camera (which has a view index of
+// -1) are skipped.
+void AddSymmetricMatrixToSparseMatrix(
+    const Eigen::Matrix<double, 9, 9>& symmetric_constraint,
+    const int view_indices[3],
+    std::vector<Eigen::Triplet<double> >* sparse_matrix_entries) {
   for (int i = 0; i < 3; i++) {
+    if (view_indices[i] < 0) {
+      continue;
+    }
     for (int j = 0; j < 3; j++) {
       // Skip any block entries that correspond to the lower triangular portion
       // of the matrix.
-      if (view_indices[i] > view_indices[j]) {
+      if (view_indices[j] < 0 || view_indices[i] > view_indices[j]) {
         continue;
       }
 
-      // Compute the A^t * B, etc. matrix.
-      const Eigen::Matrix3d symmetric_constraint =
-          constraints[i].transpose() * constraints[j];
-
       // Add to the 3x3 block corresponding to (i, j)
       for (int r = 0; r < 3; r++) {
         for (int c = 0; c < 3; c++) {
-          const std::pair<int, int> row_col(view_indices[i] + r,
-                                            view_indices[j] + c);
-          (*sparse_matrix_entries)[row_col] += symmetric_constraint(r, c);
+          sparse_matrix_entries->emplace_back(
+              view_indices[i] + r,
+              view_indices[j] + c,
+              symmetric_constraint(3 * i + r, 3 * j + c));
         }
       }
     }
@@ -176,16 +190,21 @@ bool LinearPositionEstimator::EstimatePositions(
   VLOG(2) << "Determining baseline ratios within each triplet...";
   // Baselines where (x, y, z) corresponds to the baseline of the first,
   // second, and third view pair in the triplet.
+  for (int i = 0; i < triplets_.size(); i++) {
+    AddTripletConstraint(triplets_[i]);
+  }
+  SortTrackIdsOfTripletViews();
+
   std::unique_ptr<ThreadPool> pool(new ThreadPool(options_.num_threads));
   baselines_.resize(triplets_.size());
   for (int i = 0; i < triplets_.size(); i++) {
-    AddTripletConstraint(triplets_[i]);
     pool->Add(&LinearPositionEstimator::ComputeBaselineRatioForTriplet,
               this,
               triplets_[i],
               &baselines_[i]);
   }
   pool.reset(nullptr);
+  sorted_track_ids_.clear();
 
   VLOG(2) << "Building the constraint matrix...";
   // Create the linear system based on triplet constraints.
@@ -247,6 +266,16 @@ void LinearPositionEstimator::AddTripletConstraint(
                      linear_system_index_.size() - 1);
 }
 
+void LinearPositionEstimator::SortTrackIdsOfTripletViews() {
+  sorted_track_ids_.clear();
+  sorted_track_ids_.reserve(num_triplets_for_view_.size());
+  for (const auto& num_triplets : num_triplets_for_view_) {
+    std::vector<TrackId>& track_ids = sorted_track_ids_[num_triplets.first];
+    track_ids = reconstruction_.View(num_triplets.first)->TrackIds();
+    std::sort(track_ids.begin(), track_ids.end());
+  }
+}
+
 void LinearPositionEstimator::ComputeBaselineRatioForTriplet(
     const ViewIdTriplet& triplet, Vector3d* baseline) {
   baseline->setZero();
@@ -255,11 +284,23 @@ void LinearPositionEstimator::ComputeBaselineRatioForTriplet(
   const View& view2 = *reconstruction_.View(std::get<1>(triplet));
   const View& view3 = *reconstruction_.View(std::get<2>(triplet));
 
-  // Find common tracks.
-  const std::vector<ViewId> triplet_view_ids = {
-      std::get<0>(triplet), std::get<1>(triplet), std::get<2>(triplet)};
-  const std::vector<TrackId>& common_tracks =
-      FindCommonTracksInViews(reconstruction_, triplet_view_ids);
+  // Find common tracks from the sorted track ids of each view.
+  const std::vector<TrackId>& track_ids1 =
+      FindOrDie(sorted_track_ids_, std::get<0>(triplet));
+  const std::vector<TrackId>& track_ids2 =
+      FindOrDie(sorted_track_ids_, std::get<1>(triplet));
+  const std::vector<TrackId>& track_ids3 =
+      FindOrDie(sorted_track_ids_, std::get<2>(triplet));
+  std::vector<TrackId> common_tracks12;
+  common_tracks12.reserve(std::min(track_ids1.size(), track_ids2.size()));
+  std::set_intersection(track_ids1.begin(), track_ids1.end(),
+                        track_ids2.begin(), track_ids2.end(),
+                        std::back_inserter(common_tracks12));
+  std::vector<TrackId> common_tracks;
+  common_tracks.reserve(common_tracks12.size());
+  std::set_intersection(common_tracks12.begin(), common_tracks12.end(),
+                        track_ids3.begin(), track_ids3.end(),
+                        std::back_inserter(common_tracks));
 
   // Normalize all features.
   std::vector<Feature> feature1, feature2, feature3;
@@ -296,46 +337,68 @@ void LinearPositionEstimator::CreateLinearSystem(
     Eigen::SparseMatrix<double>* constraint_matrix) {
   const int num_views = num_triplets_for_view_.size();
 
-  std::unordered_map<std::pair<int, int>, double> sparse_matrix_entries;
-  sparse_matrix_entries.reserve(27 * num_triplets_for_view_.size());
-  for (int i = 0; i < triplets_.size(); i++) {
-    const ViewId& view_id1 = std::get<0>(triplets_[i]);
-    const ViewId& view_id2 = std::get<1>(triplets_[i]);
-    const ViewId& view_id3 = std::get<2>(triplets_[i]);
-    AddTripletConstraintToSparseMatrix(
-        view_id1, view_id2, view_id3, baselines_[i], &sparse_matrix_entries);
+  // Each thread collects the entries of a contiguous range of triplets.
+  const int num_threads = std::max(
+      1, std::min(options_.num_threads, static_cast<int>(triplets_.size())));
+  const int num_triplets_per_thread =
+      (triplets_.size() + num_threads - 1) / num_threads;
+  std::vector<std::vector<Eigen::Triplet<double> > > thread_entries(
+      num_threads);
+  {
+    ThreadPool pool(num_threads);
+    for (int i = 0; i < num_threads; i++) {
+      const int start = i * num_triplets_per_thread;
+      const int end = std::min(static_cast<int>(triplets_.size()),
+                               start + num_triplets_per_thread);
+      pool.Add(&LinearPositionEstimator::AddTripletConstraintsToSparseMatrix,
+               this,
+               start,
+               end,
+               &thread_entries[i]);
+    }
   }
 
-  // Set the sparse matrix from the container of the accumulated entries.
   std::vector<Eigen::Triplet<double> > triplet_list;
-  triplet_list.reserve(sparse_matrix_entries.size());
-  for (const auto& sparse_matrix_entry : sparse_matrix_entries) {
-    // Skip this entry if the indices are invalid. This only occurs when we
-    // encounter a constraint with the constant camera (which has a view index
-    // of -1).
-    if (sparse_matrix_entry.first.first < 0 ||
-        sparse_matrix_entry.first.second < 0) {
-      continue;
-    }
-    triplet_list.emplace_back(sparse_matrix_entry.first.first,
-                              sparse_matrix_entry.first.second,
-                              sparse_matrix_entry.second);
+  size_t num_entries = 0;
+  for (const auto& entries : thread_entries) {
+    num_entries += entries.size();
+  }
+  triplet_list.reserve(num_entries);
+  for (auto& entries : thread_entries) {
+    triplet_list.insert(triplet_list.end(), entries.begin(), entries.end());
+    std::vector<Eigen::Triplet<double> >().swap(entries);
   }
 
   // We construct the constraint matrix A^t * A directly, which is an
   // N - 1 x N - 1 matrix where N is the number of cameras (and 3 entries per
-  // camera, corresponding to the camera position entries).
+  // camera, corresponding to the camera position entries). Duplicate entries
+  // are summed by setFromTriplets.
   constraint_matrix->resize((num_views - 1) * 3, (num_views - 1) * 3);
   constraint_matrix->setFromTriplets(triplet_list.begin(), triplet_list.end());
 }
 
+void LinearPositionEstimator::AddTripletConstraintsToSparseMatrix(
+    const int start,
+    const int end,
+    std::vector<Eigen::Triplet<double> >* sparse_matrix_entries) const {
+  // Each triplet adds at most 6 upper triangular 3x3 blocks.
+  sparse_matrix_entries->reserve(54 * std::max(0, end - start));
+  for (int i = start; i < end; i++) {
+    AddTripletConstraintToSparseMatrix(std::get<0>(triplets_[i]),
+                                       std::get<1>(triplets_[i]),
+                                       std::get<2>(triplets_[i]),
+                                       baselines_[i],
+                                       sparse_matrix_entries);
+  }
+}
+
 void LinearPositionEstimator::ComputeRotatedRelativeTranslationRotations(
     const ViewId view_id0,
     const ViewId view_id1,
     const ViewId view_id2,
     Eigen::Matrix3d* r012,
     Eigen::Matrix3d* r201,
-    Eigen::Matrix3d* r120) {
+    Eigen::Matrix3d* r120) const {
   // Relative camera positions.
   const Eigen::Vector3d& orientation0_aa =
       FindOrDieNoPrint(*orientations_, view_id0);
@@ -367,16 +430,16 @@ void LinearPositionEstimator::AddTripletConstraintToSparseMatrix(
     const ViewId view_id1,
     const ViewId view_id2,
     const Eigen::Vector3d& baselines,
-    std::unordered_map<std::pair<int, int>, double>* sparse_matrix_entries) {
+    std::vector<Eigen::Triplet<double> >* sparse_matrix_entries) const {
   // Weight each term by the inverse of the # of triplet that the nodes
   // participate in.
   const double w =
-      1.0 / std::sqrt(std::min({num_triplets_for_view_[view_id0],
-                                num_triplets_for_view_[view_id1],
-                                num_triplets_for_view_[view_id2]}));
+      1.0 / std::sqrt(std::min({FindOrDie(num_triplets_for_view_, view_id0),
+                                FindOrDie(num_triplets_for_view_, view_id1),
+                                FindOrDie(num_triplets_for_view_, view_id2)}));
 
   // Get the index of each camera in the sparse matrix.
-  const std::vector<int> view_indices = {
+  const int view_indices[3] = {
       static_cast<int>(3 * FindOrDie(linear_system_index_, view_id0)),
       static_cast<int>(3 * FindOrDie(linear_system_index_, view_id1)),
       static_cast<int>(3 * FindOrDie(linear_system_index_, view_id2))};
@@ -391,33 +454,32 @@ void LinearPositionEstimator::AddTripletConstraintToSparseMatrix(
   const double s_201 = baselines[1] / baselines[0];
   const double s_120 = baselines[2] / baselines[1];
 
+  Eigen::Matrix<double, 9, 9> symmetric_constraint;
+  symmetric_constraint.setZero();
+
   // Assume that t01 is perfect and solve for c2.
-  std::vector<Eigen::Matrix3d> constraints(3);
-  constraints[0] =
-      (-s_201 * r201 + r012.transpose() / s_012 + Matrix3d::Identity()) * w;
-  constraints[1] =
-      (s_201 * r201 - r012.transpose() / s_012 + Matrix3d::Identity()) * w;
-  constraints[2] = -2.0 * w * Matrix3d::Identity();
   AddTripletConstraintToSymmetricMatrix(
-      constraints, view_indices, sparse_matrix_entries);
+      (-s_201 * r201 + r012.transpose() / s_012 + Matrix3d::Identity()) * w,
+      (s_201 * r201 - r012.transpose() / s_012 + Matrix3d::Identity()) * w,
+      -2.0 * w * Matrix3d::Identity(),
+      &symmetric_constraint);
 
   // Assume t02 is perfect and solve for c1.
-  constraints[0] =
-      (-r201.transpose() / s_201 + s_120 * r120 + Matrix3d::Identity()) * w;
-  constraints[1] = -2.0 * w * Matrix3d::Identity();
-  constraints[2] =
-      (r201.transpose() / s_201 - s_120 * r120 + Matrix3d::Identity()) * w;
   AddTripletConstraintToSymmetricMatrix(
-      constraints, view_indices, sparse_matrix_entries);
+      (-r201.transpose() / s_201 + s_120 * r120 + Matrix3d::Identity()) * w,
+      -2.0 * w * Matrix3d::Identity(),
+      (r201.transpose() / s_201 - s_120 * r120 + Matrix3d::Identity()) * w,
+      &symmetric_constraint);
 
   // Assume t12 is perfect and solve for c0.
-  constraints[0] = -2.0 * w * Matrix3d::Identity();
-  constraints[1] =
-      (-s_012 * r012 + r120.transpose() / s_120 + Matrix3d::Identity()) * w;
-  constraints[2] =
-      (s_012 * r012 - r120.transpose() / s_120 + Matrix3d::Identity()) * w;
   AddTripletConstraintToSymmetricMatrix(
-      constraints, view_indices, sparse_matrix_entries);
+      -2.0 * w * Matrix3d::Identity(),
+      (-s_012 * r012 + r120.transpose() / s_120 + Matrix3d::Identity()) * w,
+      (s_012 * r012 - r120.transpose() / s_120 + Matrix3d::Identity()) * w,
+      &symmetric_constraint);
+
+  AddSymmetricMatrixToSparseMatrix(
+      symmetric_constraint, view_indices, sparse_matrix_entries);
 }
 
 Feature LinearPositionEstimator::GetNormalizedFeature(const View& view,
@@ -90,18 +90,29 @@ class LinearPositionEstimator : public PositionEstimator {
   void ComputeBaselineRatioForTriplet(const ViewIdTriplet& triplet,
                                       Eigen::Vector3d* baseline);
 
+  // Sorts the track ids of each view in the triplets once so that the common
+  // tracks of each triplet may be found with a linear intersection.
+  void SortTrackIdsOfTripletViews();
+
   // Store the triplet.
   void AddTripletConstraint(const ViewIdTriplet& view_triplet);
 
   // Sets up the linear system with the constraints that each triplet adds.
   void CreateLinearSystem(Eigen::SparseMatrix<double>* constraint_matrix);
 
+  // Adds the entries of the triplets in [start, end) to the sparse matrix
+  // entries. Duplicate entries are summed when the sparse matrix is set.
+  void AddTripletConstraintsToSparseMatrix(
+      const int start,
+      const int end,
+      std::vector<Eigen::Triplet<double> >* sparse_matrix_entries) const;
+
   void AddTripletConstraintToSparseMatrix(
       const ViewId view_id1,
       const ViewId view_id2,
       const ViewId view_id3,
       const Eigen::Vector3d& baseline,
-      std::unordered_map<std::pair<int, int>, double>* sparse_matrix_entries);
+      std::vector<Eigen::Triplet<double> >* sparse_matrix_entries) const;
 
   // A helper method to compute the relative rotations between translation
   // directions.
@@ -110,7 +121,7 @@ class LinearPositionEstimator : public PositionEstimator {
                                                   const ViewId view_id2,
                                                   Eigen::Matrix3d* r012,
                                                   Eigen::Matrix3d* r201,
-                                                  Eigen::Matrix3d* r120);
+                                                  Eigen::Matrix3d* r120) const;
   // Positions are estimated from an eigenvector that is unit-norm with an
   // ambiguous sign. To ensure that the sign of the camera positions is correct,
   // we measure the relative translations from estimated camera positions and
@@ -134,6 +145,9 @@ class LinearPositionEstimator : public PositionEstimator {
   std::unordered_map<ViewId, int> num_triplets_for_view_;
   std::unordered_map<ViewId, int> linear_system_index_;
 
+  // The sorted track ids of each view in the triplets.
+  std::unordered_map<ViewId, std::vector<TrackId> > sorted_track_ids_;
+
   DISALLOW_COPY_AND_ASSIGN(LinearPositionEstimator);
 };
 
@@ -43,7 +43,9 @@
 #include <utility>
 #include <vector>
 
+#include "theia/sfm/bundle_adjustment/position_prior_error.h"
 #include "theia/sfm/global_pose_estimation/pairwise_translation_error.h"
+#include "theia/sfm/position_priors.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
@@ -91,6 +93,7 @@ NonlinearPositionEstimator::NonlinearPositionEstimator(
   CHECK_GE(options_.min_num_points_per_view, 0);
   CHECK_GT(options_.point_to_camera_weight, 0);
   CHECK_GT(options_.robust_loss_width, 0);
+  CHECK_GE(options_.position_prior_weight, 0);
 
   if (options_.rng.get() == nullptr) {
     rng_ = std::make_shared<RandomNumberGenerator>();
@@ -117,8 +120,20 @@ bool NonlinearPositionEstimator::EstimatePositions(
   // sparse schur is used.
   static const int kMinNumCamerasForIterativeSolve = 1000;
 
-  // Initialize positions to be random.
-  InitializeRandomPositions(orientations, positions);
+  // Initialize positions from the position priors if possible, otherwise
+  // initialize them to be random.
+  std::unordered_map<ViewId, Vector3d> position_priors;
+  if (options_.initialize_positions_from_priors ||
+      options_.position_prior_weight > 0.0) {
+    GetRotatedPositionPriors(orientations, &position_priors);
+  }
+  const bool initialize_from_priors =
+      options_.initialize_positions_from_priors && !position_priors.empty();
+  if (initialize_from_priors) {
+    InitializePositionsFromPriors(orientations, position_priors, positions);
+  } else {
+    InitializeRandomPositions(orientations, positions);
+  }
 
   // Add the constraints to the problem.
   AddCameraToCameraConstraints(orientations, positions);
@@ -127,9 +142,17 @@ bool NonlinearPositionEstimator::EstimatePositions(
     AddCamerasAndPointsToParameterGroups(positions);
   }
 
-  // Set one camera to be at the origin to remove the ambiguity of the origin.
-  positions->begin()->second.setZero();
-  problem_->SetParameterBlockConstant(positions->begin()->second.data());
+  // The position priors remove the ambiguity of the origin and scale.
+  // Otherwise, set one camera to be constant to remove the ambiguity of the
+  // origin. Randomly initialized cameras are set at the origin.
+  if (options_.position_prior_weight > 0.0 && !position_priors.empty()) {
+    AddPositionPriorConstraints(position_priors, positions);
+  } else {
+    if (!initialize_from_priors) {
+      positions->begin()->second.setZero();
+    }
+    problem_->SetParameterBlockConstant(positions->begin()->second.data());
+  }
 
   // Set the solver options.
   ceres::Solver::Summary summary;
@@ -180,6 +203,78 @@ void NonlinearPositionEstimator::InitializeRandomPositions(
   }
 }
 
+void NonlinearPositionEstimator::GetRotatedPositionPriors(
+    const std::unordered_map<ViewId, Vector3d>& orientations,
+    std::unordered_map<ViewId, Vector3d>* position_priors) {
+  std::unordered_map<ViewId, Vector3d> unrotated_position_priors;
+  GetPositionPriors(reconstruction_, &unrotated_position_priors);
+  if (!RotatePositionPriorsToOrientationFrame(*view_pairs_,
+                                              orientations,
+                                              unrotated_position_priors,
+                                              position_priors)) {
+    LOG(WARNING) << "The position priors of "
+                 << unrotated_position_priors.size()
+                 << " views could not be aligned to the orientations and will "
+                    "not be used.";
+    position_priors->clear();
+  }
+}
+
+void NonlinearPositionEstimator::InitializePositionsFromPriors(
+    const std::unordered_map<ViewId, Vector3d>& orientations,
+    const std::unordered_map<ViewId, Vector3d>& position_priors,
+    std::unordered_map<ViewId, Vector3d>* positions) {
+  // Initialize the cameras without priors within the extent of the priors.
+  Vector3d center = Vector3d::Zero();
+  for (const auto& position_prior : position_priors) {
+    center += position_prior.second;
+  }
+  center /= static_cast<double>(position_priors.size());
+  double extent = 0.0;
+  for (const auto& position_prior : position_priors) {
+    extent = std::max(extent, (position_prior.second - center).norm());
+  }
+
+  InitializeRandomPositions(orientations, positions);
+  int num_initialized_positions = 0;
+  for (auto& position : *positions) {
+    const Vector3d* position_prior =
+        FindOrNull(position_priors, position.first);
+    if (position_prior != nullptr) {
+      position.second = *position_prior;
+      ++num_initialized_positions;
+    } else {
+      position.second = center + extent * rng_->RandVector3d();
+    }
+  }
+  VLOG(2) << num_initialized_positions << " of " << positions->size()
+          << " positions were initialized from their priors.";
+}
+
+void NonlinearPositionEstimator::AddPositionPriorConstraints(
+    const std::unordered_map<ViewId, Vector3d>& position_priors,
+    std::unordered_map<ViewId, Vector3d>* positions) {
+  static const int kPositionSize = 3;
+  int num_position_prior_constraints = 0;
+  for (auto& position : *positions) {
+    const Vector3d* position_prior =
+        FindOrNull(position_priors, position.first);
+    if (position_prior == nullptr) {
+      continue;
+    }
+    problem_->AddResidualBlock(
+        PositionPriorError::Create<kPositionSize>(
+            *position_prior, options_.position_prior_weight),
+        nullptr,
+        position.second.data());
+    ++num_position_prior_constraints;
+  }
+
+  VLOG(2) << num_position_prior_constraints << " position prior constraints "
+                                              "were added to the position "
+                                              "estimation problem.";
+}
+
 void NonlinearPositionEstimator::AddCameraToCameraConstraints(
     const std::unordered_map<ViewId, Vector3d>& orientations,
     std::unordered_map<ViewId, Vector3d>* positions) {
@@ -79,6 +79,16 @@ class NonlinearPositionEstimator : public PositionEstimator {
     // The total weight of all point to camera correspondences compared to
     // camera to camera correspondences.
     double point_to_camera_weight = 0.5;
+
+    // Position priors of the views (see CameraIntrinsicsPrior::position, e.g.
+    // as set from GPS by SetPositionPriorsFromGPS) may be used to initialize
+    // the positions instead of random positions. If position_prior_weight is
+    // greater than zero, a residual position_prior_weight * (position - prior)
+    // is also added for each view with a prior, and the priors then fix the
+    // origin and scale of the positions. The priors are first rotated into the
+    // frame of the global orientations; if that fails the priors are ignored.
+    bool initialize_positions_from_priors = false;
+    double position_prior_weight = 0.0;
   };
 
   NonlinearPositionEstimator(
@@ -98,6 +108,24 @@ class NonlinearPositionEstimator : public PositionEstimator {
       const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
       std::unordered_map<ViewId, Eigen::Vector3d>* positions);
 
+  // Returns the position priors of the views rotated into the frame of the
+  // global orientations. The output is empty if the priors cannot be used.
+  void GetRotatedPositionPriors(
+      const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
+      std::unordered_map<ViewId, Eigen::Vector3d>* position_priors);
+
+  // Initialize the cameras at their position priors. Cameras without a prior
+  // are initialized randomly within the extent of the priors.
+  void InitializePositionsFromPriors(
+      const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
+      const std::unordered_map<ViewId, Eigen::Vector3d>& position_priors,
+      std::unordered_map<ViewId, Eigen::Vector3d>* positions);
+
+  // Creates constraints between the cameras and their position priors.
+  void AddPositionPriorConstraints(
+      const std::unordered_map<ViewId, Eigen::Vector3d>& position_priors,
+      std::unordered_map<ViewId, Eigen::Vector3d>* positions);
+
   // Creates camera to camera constraints from relative translations.
   void AddCameraToCameraConstraints(
       const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
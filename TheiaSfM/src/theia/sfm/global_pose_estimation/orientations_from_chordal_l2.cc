@@ -0,0 +1,225 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include "theia/sfm/global_pose_estimation/orientations_from_chordal_l2.h"
+
+#include <ceres/rotation.h>
+#include <Eigen/Core>
+#include <Eigen/SVD>
+#include <Eigen/SparseCore>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "theia/math/matrix/sparse_cholesky_llt.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/util/map_util.h"
+#include "theia/util/threadpool.h"
+
+namespace theia {
+namespace {
+
+// A relative rotation constraint between the dense indices of two views.
+struct RelativeRotationConstraint {
+  int index1;
+  int index2;
+  Eigen::Matrix3d rotation;
+};
+
+// Adds the 3x3 block to the triplets at the block position (row, col) of the
+// normal equations. The view with index 0 is held constant and has no block.
+void AddBlock(const int row,
+              const int col,
+              const Eigen::Matrix3d& block,
+              std::vector<Eigen::Triplet<double> >* triplets) {
+  if (row == 0 || col == 0) {
+    return;
+  }
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      triplets->emplace_back(3 * (row - 1) + r, 3 * (col - 1) + c, block(r, c));
+    }
+  }
+}
+
+// The residual of a constraint for a column x of the rotations is
+// x_j - R_ij * x_i, so it adds I to the diagonal blocks of both views and
+// -R_ij^T and -R_ij to the off-diagonal blocks of the normal equations.
+void AddConstraintsToNormalEquations(
+    const std::vector<RelativeRotationConstraint>& constraints,
+    const int start,
+    const int end,
+    std::vector<Eigen::Triplet<double> >* triplets) {
+  triplets->reserve(36 * (end - start));
+  for (int i = start; i < end; i++) {
+    const RelativeRotationConstraint& constraint = constraints[i];
+    AddBlock(constraint.index1,
+             constraint.index1,
+             Eigen::Matrix3d::Identity(),
+             triplets);
+    AddBlock(constraint.index2,
+             constraint.index2,
+             Eigen::Matrix3d::Identity(),
+             triplets);
+    AddBlock(constraint.index1,
+             constraint.index2,
+             -constraint.rotation.transpose(),
+             triplets);
+    AddBlock(constraint.index2,
+             constraint.index1,
+             -constraint.rotation,
+             triplets);
+  }
+}
+
+}  // namespace
+
+bool OrientationsFromChordalL2(
+    const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
+    const int num_threads,
+    std::unordered_map<ViewId, Eigen::Vector3d>* orientations) {
+  CHECK_NOTNULL(orientations);
+  CHECK_GT(num_threads, 0);
+  if (view_pairs.empty()) {
+    return false;
+  }
+
+  // Give the views dense indices in sorted order so that the view with the
+  // smallest id is held constant.
+  std::vector<ViewId> view_ids;
+  view_ids.reserve(2 * view_pairs.size());
+  for (const auto& view_pair : view_pairs) {
+    view_ids.emplace_back(view_pair.first.first);
+    view_ids.emplace_back(view_pair.first.second);
+  }
+  std::sort(view_ids.begin(), view_ids.end());
+  view_ids.erase(std::unique(view_ids.begin(), view_ids.end()),
+                 view_ids.end());
+  std::unordered_map<ViewId, int> view_id_to_index;
+  view_id_to_index.reserve(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    view_id_to_index[view_ids[i]] = i;
+  }
+
+  std::vector<RelativeRotationConstraint> constraints;
+  constraints.reserve(view_pairs.size());
+  for (const auto& view_pair : view_pairs) {
+    RelativeRotationConstraint constraint;
+    constraint.index1 = FindOrDie(view_id_to_index, view_pair.first.first);
+    constraint.index2 = FindOrDie(view_id_to_index, view_pair.first.second);
+    ceres::AngleAxisToRotationMatrix(
+        view_pair.second.rotation_2.data(),
+        ceres::ColumnMajorAdapter3x3(constraint.rotation.data()));
+    constraints.emplace_back(constraint);
+  }
+
+  // Build the normal equations. Each thread collects the entries of a block of
+  // constraints and duplicate entries are summed by setFromTriplets.
+  const int num_blocks = std::max(
+      1, std::min(num_threads, static_cast<int>(constraints.size())));
+  std::vector<std::vector<Eigen::Triplet<double> > > block_triplets(
+      num_blocks);
+  ParallelFor(num_threads,
+              num_blocks,
+              constraints.size(),
+              [&](const int block, const int start, const int end) {
+                AddConstraintsToNormalEquations(
+                    constraints, start, end, &block_triplets[block]);
+              });
+  std::vector<Eigen::Triplet<double> > triplets;
+  for (auto& block : block_triplets) {
+    triplets.insert(triplets.end(), block.begin(), block.end());
+    std::vector<Eigen::Triplet<double> >().swap(block);
+  }
+
+  const int num_variables = 3 * (view_ids.size() - 1);
+  Eigen::SparseMatrix<double> normal_matrix(num_variables, num_variables);
+  normal_matrix.setFromTriplets(triplets.begin(), triplets.end());
+
+  // Only the constraints of the constant view contribute to the right hand
+  // side. Column c of the constant rotation is the unit vector e_c, so the
+  // right hand sides of the three columns are the columns of R_ij (or R_ij^T).
+  Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(num_variables, 3);
+  for (const RelativeRotationConstraint& constraint : constraints) {
+    if (constraint.index1 == 0) {
+      rhs.middleRows<3>(3 * (constraint.index2 - 1)) += constraint.rotation;
+    } else if (constraint.index2 == 0) {
+      rhs.middleRows<3>(3 * (constraint.index1 - 1)) +=
+          constraint.rotation.transpose();
+    }
+  }
+
+  SparseCholeskyLLt linear_solver(normal_matrix);
+  if (linear_solver.Info() != Eigen::Success) {
+    LOG(ERROR) << "Could not factorize the chordal rotation averaging system. "
+                  "Is the view graph connected?";
+    return false;
+  }
+  Eigen::MatrixXd solution(num_variables, 3);
+  for (int c = 0; c < 3; c++) {
+    solution.col(c) = linear_solver.Solve(rhs.col(c));
+    if (linear_solver.Info() != Eigen::Success) {
+      LOG(ERROR) << "Could not solve the chordal rotation averaging system.";
+      return false;
+    }
+  }
+
+  // Project the solutions onto the closest rotations.
+  orientations->reserve(orientations->size() + view_ids.size());
+  (*orientations)[view_ids[0]] = Eigen::Vector3d::Zero();
+  for (int i = 1; i < view_ids.size(); i++) {
+    const Eigen::Matrix3d matrix = solution.middleRows<3>(3 * (i - 1));
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(
+        matrix, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Eigen::Matrix3d rotation = svd.matrixU() * svd.matrixV().transpose();
+    if (rotation.determinant() < 0) {
+      Eigen::Matrix3d reflection = Eigen::Matrix3d::Identity();
+      reflection(2, 2) = -1.0;
+      rotation = svd.matrixU() * reflection * svd.matrixV().transpose();
+    }
+
+    Eigen::Vector3d orientation;
+    ceres::RotationMatrixToAngleAxis(
+        ceres::ColumnMajorAdapter3x3(rotation.data()), orientation.data());
+    (*orientations)[view_ids[i]] = orientation;
+  }
+  return true;
+}
+
+}  // namespace theia
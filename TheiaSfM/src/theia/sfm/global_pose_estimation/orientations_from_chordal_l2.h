@@ -0,0 +1,65 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#ifndef THEIA_SFM_GLOBAL_POSE_ESTIMATION_ORIENTATIONS_FROM_CHORDAL_L2_H_
+#define THEIA_SFM_GLOBAL_POSE_ESTIMATION_ORIENTATIONS_FROM_CHORDAL_L2_H_
+
+#include <Eigen/Core>
+#include <unordered_map>
+
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/util/hash.h"
+
+namespace theia {
+
+// Computes the orientations of the views from the relative rotations by
+// minimizing the chordal distance sum ||R_j - R_ij * R_i||_F^2 over all view
+// pairs with the orthonormality constraints relaxed. The view with the smallest
+// view id is held at the identity, which turns the problem into a sparse
+// linear least squares problem for each column of the rotations. The normal
+// equations share the same matrix for all three columns, so a single sparse
+// Cholesky factorization is needed. The solutions are then projected onto
+// SO(3). This is a much better initialization for robust rotation averaging
+// than chaining rotations along a spanning tree since every view pair
+// contributes. The view graph of the view pairs must be connected. Returns
+// false if the linear system could not be solved.
+bool OrientationsFromChordalL2(
+    const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
+    const int num_threads,
+    std::unordered_map<ViewId, Eigen::Vector3d>* orientations);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_GLOBAL_POSE_ESTIMATION_ORIENTATIONS_FROM_CHORDAL_L2_H_
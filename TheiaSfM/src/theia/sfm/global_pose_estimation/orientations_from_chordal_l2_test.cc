@@ -0,0 +1,139 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include <ceres/rotation.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/math/util.h"
+#include "theia/sfm/global_pose_estimation/orientations_from_chordal_l2.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/util/map_util.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+using Eigen::Matrix3d;
+using Eigen::Vector3d;
+
+namespace {
+
+RandomNumberGenerator rng(67);
+
+Matrix3d RotationMatrix(const Vector3d& rotation) {
+  Matrix3d rotation_matrix;
+  ceres::AngleAxisToRotationMatrix(
+      rotation.data(), ceres::ColumnMajorAdapter3x3(rotation_matrix.data()));
+  return rotation_matrix;
+}
+
+// Computes R_ij = R_j * R_i^t with a rotation of the given noise (in degrees).
+Vector3d RelativeRotationFromTwoRotations(const Vector3d& rotation1,
+                                          const Vector3d& rotation2,
+                                          const double noise) {
+  const Matrix3d noisy_rotation =
+      Eigen::AngleAxisd(DegToRad(noise), rng.RandVector3d().normalized())
+          .toRotationMatrix();
+  const Eigen::AngleAxisd relative_rotation(
+      noisy_rotation * RotationMatrix(rotation2) *
+      RotationMatrix(rotation1).transpose());
+  return relative_rotation.angle() * relative_rotation.axis();
+}
+
+void TestOrientationsFromChordalL2(const int num_views,
+                                   const int num_view_pairs,
+                                   const double noise_degrees,
+                                   const int num_threads,
+                                   const double tolerance_degrees) {
+  std::unordered_map<ViewId, Vector3d> gt_orientations;
+  for (int i = 0; i < num_views; i++) {
+    gt_orientations[i] = rng.RandVector3d();
+  }
+
+  // Connect all views with a chain, then add random view pairs.
+  std::unordered_map<ViewIdPair, TwoViewInfo> view_pairs;
+  for (int i = 1; i < num_views; i++) {
+    view_pairs[ViewIdPair(i - 1, i)].rotation_2 =
+        RelativeRotationFromTwoRotations(gt_orientations[i - 1],
+                                         gt_orientations[i],
+                                         noise_degrees);
+  }
+  while (view_pairs.size() < num_view_pairs) {
+    const ViewId view_id1 = rng.RandInt(0, num_views - 1);
+    const ViewId view_id2 = rng.RandInt(0, num_views - 1);
+    if (view_id1 >= view_id2) {
+      continue;
+    }
+    view_pairs[ViewIdPair(view_id1, view_id2)].rotation_2 =
+        RelativeRotationFromTwoRotations(gt_orientations[view_id1],
+                                         gt_orientations[view_id2],
+                                         noise_degrees);
+  }
+
+  std::unordered_map<ViewId, Vector3d> orientations;
+  EXPECT_TRUE(OrientationsFromChordalL2(view_pairs, num_threads, &orientations));
+  EXPECT_EQ(orientations.size(), num_views);
+
+  // The view with the smallest id is held at the identity, so the ground truth
+  // is compared relative to that view.
+  const Matrix3d gt_rotation0 = RotationMatrix(gt_orientations[0]);
+  for (const auto& orientation : orientations) {
+    const Matrix3d gt_rotation =
+        RotationMatrix(FindOrDie(gt_orientations, orientation.first)) *
+        gt_rotation0.transpose();
+    const Eigen::AngleAxisd rotation_error(
+        gt_rotation.transpose() * RotationMatrix(orientation.second));
+    EXPECT_LT(RadToDeg(rotation_error.angle()), tolerance_degrees);
+  }
+}
+
+}  // namespace
+
+TEST(OrientationsFromChordalL2, NoNoise) {
+  TestOrientationsFromChordalL2(20, 60, 0.0, 1, 1e-6);
+}
+
+TEST(OrientationsFromChordalL2, Noise) {
+  TestOrientationsFromChordalL2(50, 200, 1.0, 1, 2.0);
+}
+
+TEST(OrientationsFromChordalL2, Multithreaded) {
+  TestOrientationsFromChordalL2(100, 500, 1.0, 4, 2.0);
+}
+
+}  // namespace theia
@@ -37,7 +37,14 @@
 #include <ceres/rotation.h>
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "theia/math/l1_solver.h"
 #include "theia/math/matrix/sparse_cholesky_llt.h"
@@ -46,6 +53,9 @@
 #include "theia/sfm/types.h"
 #include "theia/util/hash.h"
 #include "theia/util/map_util.h"
+#include "theia/util/stringprintf.h"
+#include "theia/util/threadpool.h"
+#include "theia/util/timer.h"
 
 namespace theia {
 
@@ -58,6 +68,11 @@ bool RobustRotationEstimator::EstimateRotations(
   return EstimateRotations(global_orientations);
 }
 
+RobustRotationEstimator::RobustRotationEstimator(const Options& options)
+    : options_(options) {}
+
+RobustRotationEstimator::~RobustRotationEstimator() {}
+
 void RobustRotationEstimator::AddRelativeRotationConstraint(
     const ViewIdPair& view_id_pair, const Eigen::Vector3d& relative_rotation) {
   // Store the relative orientation constraint.
@@ -69,35 +84,72 @@ bool RobustRotationEstimator::EstimateRotations(
   CHECK_GT(relative_rotations_.size(), 0)
       << "Relative rotation constraints must be added to the robust rotation "
          "solver before estimating global rotations.";
+  CHECK_GT(options_.num_threads, 0);
   global_orientations_ = CHECK_NOTNULL(global_orientations);
+  summary_ = Summary();
+  Timer timer;
 
   // Compute a mapping of view ids to indices in the linear system. One rotation
   // will have an index of -1 and will not be added to the linear system. This
   // will remove the gauge freedom (effectively holding one camera as the
   // identity rotation).
   int index = -1;
+  view_id_to_index_.clear();
   view_id_to_index_.reserve(global_orientations->size());
-  for (const auto& orientation : *global_orientations) {
+  orientations_by_index_.clear();
+  orientations_by_index_.reserve(global_orientations->size());
+  for (auto& orientation : *global_orientations) {
     view_id_to_index_[orientation.first] = index;
+    orientations_by_index_.emplace_back(&orientation.second);
     ++index;
   }
 
-  Eigen::SparseMatrix<double> sparse_mat;
+  if (options_.num_threads > 1) {
+    thread_pool_.reset(new ThreadPool(options_.num_threads));
+  }
   SetupLinearSystem();
+  summary_.setup_time = timer.ElapsedTimeInSeconds();
 
-  if (!SolveL1Regression()) {
+  timer.Reset();
+  const bool l1_success = SolveL1Regression();
+  summary_.l1_time = timer.ElapsedTimeInSeconds();
+  if (!l1_success) {
     LOG(ERROR) << "Could not solve the L1 regression step.";
+    thread_pool_.reset();
     return false;
   }
 
-  if (!SolveIRLS()) {
+  timer.Reset();
+  const bool irls_success = SolveIRLS();
+  summary_.irls_time = timer.ElapsedTimeInSeconds();
+  thread_pool_.reset();
+  if (!irls_success) {
     LOG(ERROR) << "Could not solve the least squares error step.";
     return false;
   }
 
+  VLOG(1) << "Robust rotation estimation: setup time = " << summary_.setup_time
+          << "s, L1 time = " << summary_.l1_time << "s ("
+          << summary_.num_l1_iterations << " iterations), IRLS time = "
+          << summary_.irls_time << "s (" << summary_.num_irls_iterations
+          << " iterations).";
   return true;
 }
 
+void RobustRotationEstimator::ParallelFor(
+    const int num_items, const std::function<void(int, int)>& function) {
+  // Small loops are not worth the overhead of the thread pool.
+  const int num_blocks =
+      num_items < 2 * options_.num_threads ? 1 : options_.num_threads;
+  theia::ParallelFor(
+      thread_pool_.get(),
+      num_blocks,
+      num_items,
+      [&function](const int, const int start, const int end) {
+        function(start, end);
+      });
+}
+
 // Set up the sparse linear system.
 void RobustRotationEstimator::SetupLinearSystem() {
   // The rotation change is one less than the number of global rotations because
@@ -113,6 +165,8 @@ void RobustRotationEstimator::SetupLinearSystem() {
   // matrices.
   int rotation_error_index = 0;
   std::vector<Eigen::Triplet<double> > triplet_list;
+  constraint_view_indices_.clear();
+  constraint_view_indices_.reserve(relative_rotations_.size());
   for (const auto& relative_rotation : relative_rotations_) {
     const int view1_index =
         FindOrDie(view_id_to_index_, relative_rotation.first.first);
@@ -130,6 +184,7 @@ void RobustRotationEstimator::SetupLinearSystem() {
 
     const int view2_index =
         FindOrDie(view_id_to_index_, relative_rotation.first.second);
+    constraint_view_indices_.emplace_back(view1_index, view2_index);
     if (view2_index != kConstantRotationIndex) {
       triplet_list.emplace_back(3 * rotation_error_index + 0,
                                 3 * view2_index + 0,
@@ -150,21 +205,21 @@ void RobustRotationEstimator::SetupLinearSystem() {
 // Computes the relative rotation error based on the current global
 // orientation estimates.
 void RobustRotationEstimator::ComputeRotationError() {
-  int rotation_error_index = 0;
-  for (const auto& relative_rotation : relative_rotations_) {
-    const Eigen::Vector3d& relative_rotation_aa = relative_rotation.second;
-    const Eigen::Vector3d& rotation1 =
-        FindOrDie(*global_orientations_, relative_rotation.first.first);
-    const Eigen::Vector3d& rotation2 =
-        FindOrDie(*global_orientations_, relative_rotation.first.second);
-
-    // Compute the relative rotation error as:
-    //   R_err = R2^t * R_12 * R1.
-    relative_rotation_error_.segment<3>(3 * rotation_error_index) =
-        MultiplyRotations(-rotation2,
-                          MultiplyRotations(relative_rotation_aa, rotation1));
-    ++rotation_error_index;
-  }
+  ParallelFor(relative_rotations_.size(), [this](const int start,
+                                                 const int end) {
+    for (int i = start; i < end; i++) {
+      const Eigen::Vector3d& relative_rotation_aa = relative_rotations_[i].second;
+      const Eigen::Vector3d& rotation1 =
+          *orientations_by_index_[constraint_view_indices_[i].first + 1];
+      const Eigen::Vector3d& rotation2 =
+          *orientations_by_index_[constraint_view_indices_[i].second + 1];
+
+      // Compute the relative rotation error as:
+      //   R_err = R2^t * R_12 * R1.
+      relative_rotation_error_.segment<3>(3 * i) = MultiplyRotations(
+          -rotation2, MultiplyRotations(relative_rotation_aa, rotation1));
+    }
+  });
 }
 
 bool RobustRotationEstimator::SolveL1Regression() {
@@ -176,6 +231,7 @@ bool RobustRotationEstimator::SolveL1Regression() {
 
   rotation_change_.setZero();
   for (int i = 0; i < options_.max_num_l1_iterations; i++) {
+    ++summary_.num_l1_iterations;
     ComputeRotationError();
     l1_solver.Solve(relative_rotation_error_, &rotation_change_);
     UpdateGlobalRotations();
@@ -192,17 +248,16 @@ bool RobustRotationEstimator::SolveL1Regression() {
 // Update the global orientations using the current value in the
 // rotation_change.
 void RobustRotationEstimator::UpdateGlobalRotations() {
-  for (auto& rotation : *global_orientations_) {
-    const int view_index = FindOrDie(view_id_to_index_, rotation.first);
-    if (view_index == kConstantRotationIndex) {
-      continue;
+  // The first orientation is held constant.
+  ParallelFor(orientations_by_index_.size() - 1, [this](const int start,
+                                                        const int end) {
+    for (int i = start; i < end; i++) {
+      // Apply the rotation change to the global orientation.
+      Eigen::Vector3d* rotation = orientations_by_index_[i + 1];
+      const Eigen::Vector3d& rotation_change = rotation_change_.segment<3>(3 * i);
+      *rotation = MultiplyRotations(*rotation, rotation_change);
     }
-
-    // Apply the rotation change to the global orientation.
-    const Eigen::Vector3d& rotation_change =
-        rotation_change_.segment<3>(3 * view_index);
-    rotation.second = MultiplyRotations(rotation.second, rotation_change);
-  }
+  });
 }
 
 bool RobustRotationEstimator::SolveIRLS() {
@@ -211,11 +266,85 @@ bool RobustRotationEstimator::SolveIRLS() {
   // L2.
   static const double kSigma = DegToRad(5.0);
 
+  const int num_constraints = relative_rotations_.size();
+  const int num_views = orientations_by_index_.size() - 1;
+
+  // The system matrix A has a -I and a +I block for the two views of each
+  // constraint, so A^T * W * A is the block Laplacian of the view graph
+  // weighted by the residual weights. Each entry of the normal matrix is a
+  // signed sum of weights, so the residuals that contribute to each entry are
+  // found once here and the weighted normal equations are assembled directly
+  // in each iteration.
+  Eigen::SparseMatrix<double> normal_matrix =
+      sparse_matrix_.transpose() * sparse_matrix_;
+  normal_matrix.makeCompressed();
+  const auto value_index = [&normal_matrix](const int row, const int col) {
+    const int* start = normal_matrix.innerIndexPtr() +
+                       normal_matrix.outerIndexPtr()[col];
+    const int* end = normal_matrix.innerIndexPtr() +
+                     normal_matrix.outerIndexPtr()[col + 1];
+    const int* position = std::lower_bound(start, end, row);
+    CHECK(position != end && *position == row);
+    return static_cast<int>(position - normal_matrix.innerIndexPtr());
+  };
+
+  // The contributions of the residuals to the entries of the normal matrix in
+  // compressed form: the residual index plus one, negated for off-diagonal
+  // entries.
+  std::vector<int> entry_offsets(normal_matrix.nonZeros() + 1, 0);
+  std::vector<std::pair<int, int> > residual_entries;
+  residual_entries.reserve(4 * 3 * num_constraints);
+  for (int i = 0; i < num_constraints; i++) {
+    const int view1 = constraint_view_indices_[i].first;
+    const int view2 = constraint_view_indices_[i].second;
+    for (int c = 0; c < 3; c++) {
+      const int residual = 3 * i + c + 1;
+      if (view1 != kConstantRotationIndex) {
+        residual_entries.emplace_back(
+            value_index(3 * view1 + c, 3 * view1 + c), residual);
+      }
+      if (view2 != kConstantRotationIndex) {
+        residual_entries.emplace_back(
+            value_index(3 * view2 + c, 3 * view2 + c), residual);
+      }
+      if (view1 != kConstantRotationIndex &&
+          view2 != kConstantRotationIndex) {
+        residual_entries.emplace_back(
+            value_index(3 * view1 + c, 3 * view2 + c), -residual);
+        residual_entries.emplace_back(
+            value_index(3 * view2 + c, 3 * view1 + c), -residual);
+      }
+    }
+  }
+  std::sort(residual_entries.begin(), residual_entries.end());
+  std::vector<int> entry_residuals(residual_entries.size());
+  for (int i = 0; i < residual_entries.size(); i++) {
+    ++entry_offsets[residual_entries[i].first + 1];
+    entry_residuals[i] = residual_entries[i].second;
+  }
+  for (int i = 0; i < normal_matrix.nonZeros(); i++) {
+    entry_offsets[i + 1] += entry_offsets[i];
+  }
+  std::vector<std::pair<int, int> >().swap(residual_entries);
+
+  // The constraints of each view with the sign of the view in the constraint,
+  // used to compute A^T * W * b.
+  std::vector<std::vector<int> > view_constraints(num_views);
+  for (int i = 0; i < num_constraints; i++) {
+    if (constraint_view_indices_[i].first != kConstantRotationIndex) {
+      view_constraints[constraint_view_indices_[i].first].emplace_back(
+          -(i + 1));
+    }
+    if (constraint_view_indices_[i].second != kConstantRotationIndex) {
+      view_constraints[constraint_view_indices_[i].second].emplace_back(i + 1);
+    }
+  }
+
   // Set up the linear solver and analyze the sparsity pattern of the
   // system. Since the sparsity pattern will not change with each linear solve
   // this can help speed up the solution time.
   SparseCholeskyLLt linear_solver;
-  linear_solver.AnalyzePattern(sparse_matrix_.transpose() * sparse_matrix_);
+  linear_solver.AnalyzePattern(normal_matrix);
   if (linear_solver.Info() != Eigen::Success) {
     LOG(ERROR) << "Cholesky decomposition failed.";
     return false;
@@ -224,29 +353,73 @@ bool RobustRotationEstimator::SolveIRLS() {
   VLOG(2) << "Iteration   Error           Delta";
   const std::string row_format = "  % 4d     % 4.4e     % 4.4e";
 
-  Eigen::ArrayXd errors, weights;
-  Eigen::SparseMatrix<double> at_weight;
+  Eigen::VectorXd sq_errors(num_constraints);
+  Eigen::VectorXd weights(relative_rotation_error_.size());
+  Eigen::VectorXd weighted_rhs(rotation_change_.size());
   for (int i = 0; i < options_.max_num_irls_iterations; i++) {
+    ++summary_.num_irls_iterations;
     const Eigen::VectorXd prev_rotation_change = rotation_change_;
     ComputeRotationError();
 
-    // Compute the weights for each error term.
-    errors =
-        (sparse_matrix_ * rotation_change_ - relative_rotation_error_).array();
-    weights = kSigma / (errors.square() + kSigma * kSigma).square();
+    // Compute the weights for each error term of A * x - b.
+    ParallelFor(num_constraints, [&](const int start, const int end) {
+      for (int j = start; j < end; j++) {
+        const int view1 = constraint_view_indices_[j].first;
+        const int view2 = constraint_view_indices_[j].second;
+        Eigen::Vector3d error = -relative_rotation_error_.segment<3>(3 * j);
+        if (view1 != kConstantRotationIndex) {
+          error -= rotation_change_.segment<3>(3 * view1);
+        }
+        if (view2 != kConstantRotationIndex) {
+          error += rotation_change_.segment<3>(3 * view2);
+        }
+        sq_errors[j] = error.squaredNorm();
+        weights.segment<3>(3 * j) =
+            kSigma /
+            (error.array().square() + kSigma * kSigma).square();
+      }
+    });
+
+    // Assemble the weighted normal equations A^T * W * A and A^T * W * b.
+    ParallelFor(normal_matrix.nonZeros(), [&](const int start, const int end) {
+      double* values = normal_matrix.valuePtr();
+      for (int j = start; j < end; j++) {
+        double value = 0.0;
+        for (int k = entry_offsets[j]; k < entry_offsets[j + 1]; k++) {
+          const int signed_residual = entry_residuals[k];
+          value += signed_residual > 0 ? weights[signed_residual - 1]
+                                       : -weights[-signed_residual - 1];
+        }
+        values[j] = value;
+      }
+    });
+    ParallelFor(num_views, [&](const int start, const int end) {
+      for (int j = start; j < end; j++) {
+        Eigen::Vector3d rhs = Eigen::Vector3d::Zero();
+        for (const int signed_constraint : view_constraints[j]) {
+          const int constraint = std::abs(signed_constraint) - 1;
+          const Eigen::Vector3d weighted_error =
+              weights.segment<3>(3 * constraint).cwiseProduct(
+                  relative_rotation_error_.segment<3>(3 * constraint));
+          if (signed_constraint > 0) {
+            rhs += weighted_error;
+          } else {
+            rhs -= weighted_error;
+          }
+        }
+        weighted_rhs.segment<3>(3 * j) = rhs;
+      }
+    });
 
     // Update the factorization for the weighted values.
-    at_weight =
-        sparse_matrix_.transpose() * weights.matrix().asDiagonal();
-    linear_solver.Factorize(at_weight * sparse_matrix_);
+    linear_solver.Factorize(normal_matrix);
     if (linear_solver.Info() != Eigen::Success) {
       LOG(ERROR) << "Failed to factorize the least squares system.";
       return false;
     }
 
     // Solve the least squares problem..
-    rotation_change_ =
-        linear_solver.Solve(at_weight * relative_rotation_error_);
+    rotation_change_ = linear_solver.Solve(weighted_rhs);
     if (linear_solver.Info() != Eigen::Success) {
       LOG(ERROR) << "Failed to solve the least squares system.";
       return false;
@@ -257,7 +430,7 @@ bool RobustRotationEstimator::SolveIRLS() {
     // Log some statistics for the output.
     const double rotation_change_sq_norm =
         (prev_rotation_change - rotation_change_).squaredNorm();
-    VLOG(2) << StringPrintf(row_format.c_str(), i, errors.square().sum(),
+    VLOG(2) << StringPrintf(row_format.c_str(), i, sq_errors.sum(),
                             rotation_change_sq_norm);
     if (rotation_change_sq_norm < kConvergenceThreshold) {
       VLOG(1) << "IRLS Converged in " << i + 1 << " iterations.";
@@ -37,13 +37,18 @@
 
 #include <Eigen/Core>
 #include <Eigen/SparseCore>
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "theia/sfm/global_pose_estimation/rotation_estimator.h"
 #include "theia/sfm/types.h"
 #include "theia/util/hash.h"
 
 namespace theia {
+class ThreadPool;
 class TwoViewInfo;
 
 // Computes the global rotations given relative rotations and an initial guess
@@ -68,10 +73,24 @@ class RobustRotationEstimator : public RotationEstimator {
 
     // The number of iterative reweighted least squares iterations to perform.
     int max_num_irls_iterations = 100;
+
+    // The number of threads used to compute the rotation errors and weights,
+    // to assemble the reweighted least squares systems and to update the
+    // rotations. The sparse factorizations are not affected.
+    int num_threads = 1;
+  };
+
+  // Timings (in seconds) and iteration counts of the estimation phases.
+  struct Summary {
+    double setup_time = 0.0;
+    double l1_time = 0.0;
+    double irls_time = 0.0;
+    int num_l1_iterations = 0;
+    int num_irls_iterations = 0;
   };
 
-  explicit RobustRotationEstimator(const Options& options)
-      : options_(options) {}
+  explicit RobustRotationEstimator(const Options& options);
+  ~RobustRotationEstimator();
 
   // Estimates the global orientations of all views based on an initial
   // guess. Returns true on successful estimation and false otherwise.
@@ -98,6 +117,9 @@ class RobustRotationEstimator : public RotationEstimator {
   bool EstimateRotations(
       std::unordered_map<ViewId, Eigen::Vector3d>* global_orientations);
 
+  // Returns the summary of the last call to EstimateRotations.
+  const Summary& summary() const { return summary_; }
+
  protected:
   // Sets up the sparse linear system such that dR_ij = dR_j - dR_i. This is the
   // first-order approximation of the angle-axis rotations. This should only be
@@ -111,9 +133,15 @@ class RobustRotationEstimator : public RotationEstimator {
   // Performs the L1 robust loss minimization.
   bool SolveL1Regression();
 
-  // Performs the iteratively reweighted least squares.
+  // Performs the iteratively reweighted least squares. The weighted normal
+  // equations are assembled directly in parallel since A^T * W * A is the
+  // weighted (block) Laplacian of the view graph.
   bool SolveIRLS();
 
+  // Runs function(start, end) on blocks of [0, num_items) in parallel.
+  void ParallelFor(const int num_items,
+                   const std::function<void(int, int)>& function);
+
   // Updates the global rotations based on the current rotation change.
   void UpdateGlobalRotations();
 
@@ -130,6 +158,16 @@ class RobustRotationEstimator : public RotationEstimator {
   // The global orientation estimates for each camera.
   std::unordered_map<ViewId, Eigen::Vector3d>* global_orientations_;
 
+  // The indices in the linear system of the two views of each relative
+  // rotation constraint, and the orientation of each index (offset by one so
+  // that the constant rotation is the first element). These avoid hash lookups
+  // in the inner loops.
+  std::vector<std::pair<int, int> > constraint_view_indices_;
+  std::vector<Eigen::Vector3d*> orientations_by_index_;
+
+  std::unique_ptr<ThreadPool> thread_pool_;
+  Summary summary_;
+
   // The sparse matrix used to maintain the linear system. This is matrix A in
   // Ax = b.
   Eigen::SparseMatrix<double> sparse_matrix_;
@@ -121,13 +121,15 @@ class EstimateRotationsRobustTest : public ::testing::Test {
   void TestRobustRotationEstimator(const int num_views,
                                    const int num_view_pairs,
                                    const double rotation_noise,
-                                   const double rotation_tolerance_degrees) {
+                                   const double rotation_tolerance_degrees,
+                                   const int num_threads = 1) {
     // Set up the camera.
     CreateGTOrientations(num_views);
     GetRelativeRotations(num_view_pairs, rotation_noise);
 
     // Estimate the rotations.
     RobustRotationEstimator::Options options;
+    options.num_threads = num_threads;
     RobustRotationEstimator rotation_estimator(options);
 
     // Set the initial rotation estimations.
@@ -241,4 +243,17 @@ TEST_F(EstimateRotationsRobustTest, LargeTestWithNoise) {
                               kToleranceDegrees);
 }
 
+TEST_F(EstimateRotationsRobustTest, LargeTestWithNoiseMultithreaded) {
+  static const double kToleranceDegrees = 5.0;
+  static const int kNumViews = 100;
+  static const int kNumViewPairs = 800;
+  static const double kPoseNoiseDegrees = 2.0;
+  static const int kNumThreads = 4;
+  TestRobustRotationEstimator(kNumViews,
+                              kNumViewPairs,
+                              kPoseNoiseDegrees,
+                              kToleranceDegrees,
+                              kNumThreads);
+}
+
 }  // namespace theia
@@ -35,8 +35,13 @@
 #include "theia/sfm/global_reconstruction_estimator.h"
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <sstream>  // NOLINT
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/estimate_track.h"
@@ -44,26 +49,37 @@
 #include "theia/sfm/filter_view_graph_cycles_by_rotation.h"
 #include "theia/sfm/filter_view_pairs_from_orientation.h"
 #include "theia/sfm/filter_view_pairs_from_relative_translation.h"
+#include "theia/sfm/find_common_views_by_name.h"
 #include "theia/sfm/global_pose_estimation/least_unsquared_deviation_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/linear_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/linear_rotation_estimator.h"
 #include "theia/sfm/global_pose_estimation/nonlinear_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/nonlinear_rotation_estimator.h"
+#include "theia/sfm/global_pose_estimation/orientations_from_chordal_l2.h"
 #include "theia/sfm/global_pose_estimation/position_estimator.h"
 #include "theia/sfm/global_pose_estimation/robust_rotation_estimator.h"
+#include "theia/sfm/position_priors.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/reconstruction_estimator_options.h"
 #include "theia/sfm/reconstruction_estimator_utils.h"
 #include "theia/sfm/select_good_tracks_for_bundle_adjustment.h"
 #include "theia/sfm/set_camera_intrinsics_from_priors.h"
 #include "theia/sfm/set_outlier_tracks_to_unestimated.h"
+#include "theia/sfm/similarity_transformation.h"
+#include "theia/sfm/transformation/align_reconstructions.h"
+#include "theia/sfm/transformation/transform_reconstruction.h"
 #include "theia/sfm/twoview_info.h"
 #include "theia/sfm/view_graph/orientations_from_maximum_spanning_tree.h"
+#include "theia/sfm/view_graph/partition_view_graph.h"
 #include "theia/sfm/view_graph/remove_disconnected_view_pairs.h"
 #include "theia/sfm/view_graph/view_graph.h"
 #include "theia/solvers/sample_consensus_estimator.h"
+#include "theia/util/map_util.h"
+#include "theia/util/progress_reporter.h"
 #include "theia/util/random.h"
+#include "theia/util/threadpool.h"
 #include "theia/util/timer.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 
@@ -80,12 +96,14 @@ struct GlobalReconstructionEstimatorTimings {
   double relative_translation_optimization_time = 0.0;
   double relative_translation_filtering_time = 0.0;
   double position_estimation_time = 0.0;
+  double partition_estimation_time = 0.0;
 };
 
 FilterViewPairsFromRelativeTranslationOptions
 SetRelativeTranslationFilteringOptions(
     const ReconstructionEstimatorOptions& options) {
   FilterViewPairsFromRelativeTranslationOptions fvpfrt_options;
+  fvpfrt_options.rng = options.rng;
   fvpfrt_options.num_threads = options.num_threads;
   fvpfrt_options.num_iterations = options.translation_filtering_num_iterations;
   fvpfrt_options.translation_projection_tolerance =
@@ -104,11 +122,94 @@ void SetUnderconstrainedAsUnestimated(Reconstruction* reconstruction) {
   }
 }
 
+// Aligns the cameras of a partition to the merged cameras with a similarity
+// transformation that is estimated with RANSAC from the positions of their
+// common views. The scale of the merged cameras is arbitrary, so the inlier
+// threshold is relative to the spread of the common views. Returns false (and
+// leaves the cameras unchanged) if the alignment has too few inliers.
+bool AlignPartitionToMergedCameras(
+    const std::shared_ptr<RandomNumberGenerator>& rng,
+    const Reconstruction& merged_cameras,
+    Reconstruction* cameras) {
+  static const double kInlierThresholdFraction = 0.1;
+  static const double kMinInlierRatio = 0.5;
+  static const int kMinNumInliers = 3;
+
+  const std::vector<std::string> common_view_names =
+      FindCommonViewsByName(merged_cameras, *cameras);
+  std::vector<Vector3d> merged_positions(common_view_names.size());
+  std::vector<Vector3d> positions(common_view_names.size());
+  Vector3d centroid = Vector3d::Zero();
+  for (int i = 0; i < common_view_names.size(); i++) {
+    merged_positions[i] =
+        merged_cameras.View(merged_cameras.ViewIdFromName(common_view_names[i]))
+            ->Camera()
+            .GetPosition();
+    positions[i] = cameras->View(cameras->ViewIdFromName(common_view_names[i]))
+                       ->Camera()
+                       .GetPosition();
+    centroid += merged_positions[i];
+  }
+  centroid /= static_cast<double>(common_view_names.size());
+
+  std::vector<double> distances_to_centroid(merged_positions.size());
+  for (int i = 0; i < merged_positions.size(); i++) {
+    distances_to_centroid[i] = (merged_positions[i] - centroid).norm();
+  }
+  std::nth_element(distances_to_centroid.begin(),
+                   distances_to_centroid.begin() +
+                       distances_to_centroid.size() / 2,
+                   distances_to_centroid.end());
+  const double inlier_threshold =
+      kInlierThresholdFraction *
+      distances_to_centroid[distances_to_centroid.size() / 2];
+  if (inlier_threshold <= 0.0) {
+    return false;
+  }
+
+  RansacParameters params;
+  params.rng = rng;
+  params.max_iterations = 1000;
+  params.use_mle = true;
+  params.error_thresh = inlier_threshold * inlier_threshold;
+  params.failure_probability = 1e-4;
+  SimilarityTransformation sim_transform;
+  RansacSummary summary;
+  if (!EstimateSimilarityTransformationRobust(params,
+                                              merged_positions,
+                                              positions,
+                                              &sim_transform,
+                                              &summary) ||
+      summary.inliers.size() < kMinNumInliers ||
+      summary.inliers.size() < kMinInlierRatio * common_view_names.size()) {
+    return false;
+  }
+  VLOG(2) << "Aligned a partition with " << summary.inliers.size() << " of "
+          << common_view_names.size() << " common views as inliers.";
+
+  TransformReconstruction(sim_transform.rotation,
+                          sim_transform.translation,
+                          sim_transform.scale,
+                          cameras);
+  return true;
+}
+
 }  // namespace
 
 GlobalReconstructionEstimator::GlobalReconstructionEstimator(
-    const ReconstructionEstimatorOptions& options) {
+    const ReconstructionEstimatorOptions& options)
+    : num_steps_started_(0),
+      is_aligned_to_position_priors_(false),
+      triangulate_track_subset_(false) {
   options_ = options;
+  if (options_.max_num_views_per_partition > 0 &&
+      options_.max_num_views_per_partition < kMinNumViewsPerPartition) {
+    LOG(WARNING) << "max_num_views_per_partition must be at least "
+                 << kMinNumViewsPerPartition << ". Using "
+                 << kMinNumViewsPerPartition << " instead of "
+                 << options_.max_num_views_per_partition << ".";
+    options_.max_num_views_per_partition = kMinNumViewsPerPartition;
+  }
   translation_filter_options_ = SetRelativeTranslationFilteringOptions(options);
   options_.nonlinear_position_estimator_options.rng = options.rng;
   options_.nonlinear_position_estimator_options.num_threads =
@@ -136,19 +237,46 @@ GlobalReconstructionEstimator::GlobalReconstructionEstimator(
 // to the largest connected component in the view graph.
 ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
     ViewGraph* view_graph, Reconstruction* reconstruction) {
+  ScopedTraceSpan span("GlobalReconstructionEstimator");
   CHECK_NOTNULL(reconstruction);
   reconstruction_ = reconstruction;
   view_graph_ = view_graph;
   orientations_.clear();
   positions_.clear();
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
 
   ReconstructionEstimatorSummary summary;
   GlobalReconstructionEstimatorTimings global_estimator_timings;
   Timer total_timer;
   Timer timer;
 
+  // Large view graphs may be partitioned to estimate the camera poses.
+  const bool estimate_partitions =
+      options_.max_num_views_per_partition > 0 &&
+      view_graph_->NumViews() > options_.max_num_views_per_partition;
+
+  // Steps 1 - 7 (or 1, 2 and the partitions) plus triangulation and bundle
+  // adjustment for each iteration.
+  num_steps_started_ = 0;
+  if (options_.progress_reporter != nullptr) {
+    const int num_steps =
+        (estimate_partitions ? 3 : 7) +
+        2 * (options_.num_retriangulation_iterations + 1) +
+        (options_.refine_camera_positions_and_points_after_position_estimation
+             ? 1
+             : 0) +
+        (options_.subsample_tracks_before_triangulation ? 1 : 0);
+    options_.progress_reporter->BeginStage("GlobalReconstructionEstimator",
+                                           num_steps);
+  }
+
   // Step 1. Filter the initial view graph and remove any bad two view
   // geometries.
+  if (!BeginStep("Filtering the initial view graph")) {
+    return summary;
+  }
   LOG(INFO) << "Filtering the intial view graph.";
   timer.Reset();
   if (!FilterInitialViewGraph()) {
@@ -159,73 +287,132 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
       timer.ElapsedTimeInSeconds();
 
   // Step 2. Calibrate any uncalibrated cameras.
+  if (!BeginStep("Calibrating cameras")) {
+    return summary;
+  }
   LOG(INFO) << "Calibrating any uncalibrated cameras.";
   timer.Reset();
   CalibrateCameras();
   summary.camera_intrinsics_calibration_time = timer.ElapsedTimeInSeconds();
 
-  // Step 3. Estimate global rotations.
-  LOG(INFO) << "Estimating the global rotations of all cameras.";
-  timer.Reset();
-  if (!EstimateGlobalRotations()) {
-    LOG(WARNING) << "Rotation estimation failed!";
-    summary.success = false;
-    return summary;
+  // Convert any GPS priors to position priors.
+  is_aligned_to_position_priors_ = false;
+  if (options_.use_position_priors) {
+    const int num_gps_priors = SetPositionPriorsFromGPS(reconstruction_);
+    LOG(INFO) << "Set the position priors of " << num_gps_priors
+              << " views from GPS.";
   }
-  global_estimator_timings.rotation_estimation_time =
-      timer.ElapsedTimeInSeconds();
 
-  // Step 4. Filter bad rotations.
-  LOG(INFO) << "Filtering any bad rotation estimations.";
-  timer.Reset();
-  FilterRotations();
-  global_estimator_timings.rotation_filtering_time =
-      timer.ElapsedTimeInSeconds();
+  if (estimate_partitions) {
+    // Steps 3 - 7 are performed for each partition of the view graph.
+    if (!BeginStep("Estimating the poses of the partitions")) {
+      return summary;
+    }
+    LOG(INFO) << "Estimating the camera poses of each partition of the view "
+                 "graph.";
+    timer.Reset();
+    if (!EstimatePosesFromPartitions()) {
+      LOG(WARNING) << "Partitioned pose estimation failed!";
+      summary.success = false;
+      return summary;
+    }
+    global_estimator_timings.partition_estimation_time =
+        timer.ElapsedTimeInSeconds();
+  } else {
+    // Step 3. Estimate global rotations.
+    if (!BeginStep("Estimating global rotations")) {
+      return summary;
+    }
+    LOG(INFO) << "Estimating the global rotations of all cameras.";
+    timer.Reset();
+    if (!EstimateGlobalRotations()) {
+      LOG(WARNING) << "Rotation estimation failed!";
+      summary.success = false;
+      return summary;
+    }
+    global_estimator_timings.rotation_estimation_time =
+        timer.ElapsedTimeInSeconds();
 
-  // Step 5. Optimize relative translations.
-  LOG(INFO) << "Optimizing the pairwise translation estimations.";
-  timer.Reset();
-  OptimizePairwiseTranslations();
-  global_estimator_timings.relative_translation_optimization_time =
-      timer.ElapsedTimeInSeconds();
+    // Step 4. Filter bad rotations.
+    if (!BeginStep("Filtering rotations")) {
+      return summary;
+    }
+    LOG(INFO) << "Filtering any bad rotation estimations.";
+    timer.Reset();
+    FilterRotations();
+    global_estimator_timings.rotation_filtering_time =
+        timer.ElapsedTimeInSeconds();
 
-  // Step 6. Filter bad relative translations.
-  LOG(INFO) << "Filtering any bad relative translations.";
-  timer.Reset();
-  FilterRelativeTranslation();
-  global_estimator_timings.relative_translation_filtering_time =
-      timer.ElapsedTimeInSeconds();
+    // Step 5. Optimize relative translations.
+    if (!BeginStep("Optimizing relative translations")) {
+      return summary;
+    }
+    LOG(INFO) << "Optimizing the pairwise translation estimations.";
+    timer.Reset();
+    OptimizePairwiseTranslations();
+    global_estimator_timings.relative_translation_optimization_time =
+        timer.ElapsedTimeInSeconds();
 
-  // Step 7. Estimate global positions.
-  LOG(INFO) << "Estimating the positions of all cameras.";
-  timer.Reset();
-  if (!EstimatePosition()) {
-    LOG(WARNING) << "Position estimation failed!";
-    summary.success = false;
-    return summary;
+    // Step 6. Filter bad relative translations.
+    if (!BeginStep("Filtering relative translations")) {
+      return summary;
+    }
+    LOG(INFO) << "Filtering any bad relative translations.";
+    timer.Reset();
+    FilterRelativeTranslation();
+    global_estimator_timings.relative_translation_filtering_time =
+        timer.ElapsedTimeInSeconds();
+
+    // Step 7. Estimate global positions.
+    if (!BeginStep("Estimating global positions")) {
+      return summary;
+    }
+    LOG(INFO) << "Estimating the positions of all cameras.";
+    timer.Reset();
+    if (!EstimatePosition()) {
+      LOG(WARNING) << "Position estimation failed!";
+      summary.success = false;
+      return summary;
+    }
+    LOG(INFO) << positions_.size()
+              << " camera positions were estimated successfully.";
+    global_estimator_timings.position_estimation_time =
+        timer.ElapsedTimeInSeconds();
   }
-  LOG(INFO) << positions_.size()
-            << " camera positions were estimated successfully.";
-  global_estimator_timings.position_estimation_time =
-      timer.ElapsedTimeInSeconds();
 
   summary.pose_estimation_time =
       global_estimator_timings.rotation_estimation_time +
       global_estimator_timings.rotation_filtering_time +
       global_estimator_timings.relative_translation_optimization_time +
       global_estimator_timings.relative_translation_filtering_time +
-      global_estimator_timings.position_estimation_time;
+      global_estimator_timings.position_estimation_time +
+      global_estimator_timings.partition_estimation_time;
 
   // Set the poses in the reconstruction object.
   SetReconstructionFromEstimatedPoses(orientations_,
                                       positions_,
                                       reconstruction_);
+  if (options_.use_position_priors) {
+    is_aligned_to_position_priors_ = AlignReconstructionToPositionPriors();
+    LOG_IF(WARNING, !is_aligned_to_position_priors_)
+        << "Could not align the reconstruction to the position priors.";
+  }
 
+  // Only triangulate and bundle adjust the best connected tracks of each image
+  // region until the camera poses are refined.
+  if (options_.subsample_tracks_before_triangulation) {
+    timer.Reset();
+    SelectTracksToTriangulate();
+    summary.triangulation_time += timer.ElapsedTimeInSeconds();
+  }
 
   // Always triangulate once, then retriangulate and remove outliers depending
   // on the reconstruciton estimator options.
   for (int i = 0; i < options_.num_retriangulation_iterations + 1; i++) {
     // Step 8. Triangulate features.
+    if (!BeginStep("Triangulating features")) {
+      return summary;
+    }
     LOG(INFO) << "Triangulating all features.";
     timer.Reset();
     EstimateStructure();
@@ -238,6 +425,9 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
     // adjustment iteration.
     if (i == 0 &&
         options_.refine_camera_positions_and_points_after_position_estimation) {
+      if (!BeginStep("Bundle adjusting camera positions and points")) {
+        return summary;
+      }
       LOG(INFO) << "Performing partial bundle adjustment to optimize only the "
                    "camera positions and 3d points.";
       timer.Reset();
@@ -247,6 +437,9 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
 
 
     // Step 9. Bundle Adjustment.
+    if (!BeginStep("Bundle adjustment")) {
+      return summary;
+    }
     LOG(INFO) << "Performing bundle adjustment.";
     timer.Reset();
     if (!BundleAdjustment()) {
@@ -259,10 +452,21 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
     int num_points_removed = SetOutlierTracksToUnestimated(
         options_.max_reprojection_error_in_pixels,
         options_.min_triangulation_angle_degrees,
+        options_.num_threads,
         reconstruction_);
     LOG(INFO) << num_points_removed << " outlier points were removed.";
   }
 
+  // Step 10. Triangulate the remaining tracks with the refined camera poses.
+  if (options_.subsample_tracks_before_triangulation) {
+    if (!BeginStep("Triangulating deferred features")) {
+      return summary;
+    }
+    timer.Reset();
+    EstimateDeferredStructure();
+    summary.triangulation_time += timer.ElapsedTimeInSeconds();
+  }
+
   // Set the output parameters.
   GetEstimatedViewsFromReconstruction(*reconstruction_,
                                       &summary.estimated_views);
@@ -270,6 +474,9 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
                                        &summary.estimated_tracks);
   summary.success = true;
   summary.total_time = total_timer.ElapsedTimeInSeconds();
+  if (options_.progress_reporter != nullptr) {
+    options_.progress_reporter->Increment();
+  }
 
   // Output some timing statistics.
   std::ostringstream string_stream;
@@ -288,13 +495,35 @@ ReconstructionEstimatorSummary GlobalReconstructionEstimator::Estimate(
       << "\n\tRelative translation filtering time = "
       << global_estimator_timings.relative_translation_filtering_time
       << "\n\tPosition estimation time = "
-      << global_estimator_timings.position_estimation_time;
+      << global_estimator_timings.position_estimation_time
+      << "\n\tPartition estimation time = "
+      << global_estimator_timings.partition_estimation_time;
   summary.message = string_stream.str();
 
   return summary;
 }
 
+bool GlobalReconstructionEstimator::BeginStep(const std::string& step) {
+  ProgressReporter* progress_reporter = options_.progress_reporter.get();
+  if (progress_reporter == nullptr) {
+    return true;
+  }
+  if (progress_reporter->IsCancelled()) {
+    LOG(INFO) << "Global reconstruction estimation was cancelled.";
+    return false;
+  }
+
+  // The previous step has completed.
+  if (num_steps_started_ > 0) {
+    progress_reporter->Increment();
+  }
+  ++num_steps_started_;
+  progress_reporter->SetStep(step);
+  return true;
+}
+
 bool GlobalReconstructionEstimator::FilterInitialViewGraph() {
+  ScopedTraceSpan span("FilterInitialViewGraph");
   // Remove any view pairs that do not have a sufficient number of inliers.
   std::unordered_set<ViewIdPair> view_pairs_to_remove;
   const auto& view_pairs = view_graph_->GetAllEdges();
@@ -309,33 +538,32 @@ bool GlobalReconstructionEstimator::FilterInitialViewGraph() {
   }
 
   // Only reconstruct the largest connected component.
-  RemoveDisconnectedViewPairs(view_graph_);
+  RemoveDisconnectedViewPairs(options_.num_threads, view_graph_);
   return view_graph_->NumEdges() >= 1;
 }
 
 void GlobalReconstructionEstimator::CalibrateCameras() {
+  ScopedTraceSpan span("CalibrateCameras");
   SetCameraIntrinsicsFromPriors(reconstruction_);
 }
 
 bool GlobalReconstructionEstimator::EstimateGlobalRotations() {
+  ScopedTraceSpan span("EstimateGlobalRotations");
   const auto& view_pairs = view_graph_->GetAllEdges();
 
   // Choose the global rotation estimation type.
   std::unique_ptr<RotationEstimator> rotation_estimator;
   switch (options_.global_rotation_estimator_type) {
     case GlobalRotationEstimatorType::ROBUST_L1L2: {
-      // Initialize the orientation estimations by walking along the maximum
-      // spanning tree.
-      OrientationsFromMaximumSpanningTree(*view_graph_, &orientations_);
+      InitializeGlobalRotations();
       RobustRotationEstimator::Options robust_rotation_estimator_options;
+      robust_rotation_estimator_options.num_threads = options_.num_threads;
       rotation_estimator.reset(
           new RobustRotationEstimator(robust_rotation_estimator_options));
       break;
     }
     case GlobalRotationEstimatorType::NONLINEAR: {
-      // Initialize the orientation estimations by walking along the maximum
-      // spanning tree.
-      OrientationsFromMaximumSpanningTree(*view_graph_, &orientations_);
+      InitializeGlobalRotations();
       rotation_estimator.reset(new NonlinearRotationEstimator());
       break;
     }
@@ -351,10 +579,32 @@ bool GlobalReconstructionEstimator::EstimateGlobalRotations() {
     }
   }
 
+  ScopedTraceSpan estimation_span("AverageRotations");
   return rotation_estimator->EstimateRotations(view_pairs, &orientations_);
 }
 
+void GlobalReconstructionEstimator::InitializeGlobalRotations() {
+  ScopedTraceSpan span("InitializeGlobalRotations");
+  Timer timer;
+  if (options_.initialize_rotations_with_chordal_l2 &&
+      OrientationsFromChordalL2(
+          view_graph_->GetAllEdges(), options_.num_threads, &orientations_)) {
+    VLOG(1) << "Initialized the orientations with chordal L2 rotation "
+               "averaging in "
+            << timer.ElapsedTimeInSeconds() << " seconds.";
+    return;
+  }
+
+  // Initialize the orientation estimations by walking along the maximum
+  // spanning tree.
+  OrientationsFromMaximumSpanningTree(
+      *view_graph_, options_.num_threads, &orientations_);
+  VLOG(1) << "Initialized the orientations from the maximum spanning tree in "
+          << timer.ElapsedTimeInSeconds() << " seconds.";
+}
+
 void GlobalReconstructionEstimator::FilterRotations() {
+  ScopedTraceSpan span("FilterRotations");
   // Filter view pairs based on the relative rotation and the estimated global
   // orientations.
   FilterViewPairsFromOrientation(
@@ -363,13 +613,14 @@ void GlobalReconstructionEstimator::FilterRotations() {
       view_graph_);
   // Remove any disconnected views from the estimation.
   const std::unordered_set<ViewId> removed_views =
-      RemoveDisconnectedViewPairs(view_graph_);
+      RemoveDisconnectedViewPairs(options_.num_threads, view_graph_);
   for (const ViewId removed_view : removed_views) {
     orientations_.erase(removed_view);
   }
 }
 
 void GlobalReconstructionEstimator::OptimizePairwiseTranslations() {
+  ScopedTraceSpan span("OptimizePairwiseTranslations");
   if (options_.refine_relative_translations_after_rotation_estimation) {
     RefineRelativeTranslationsWithKnownRotations(*reconstruction_,
                                                  orientations_,
@@ -379,6 +630,7 @@ void GlobalReconstructionEstimator::OptimizePairwiseTranslations() {
 }
 
 void GlobalReconstructionEstimator::FilterRelativeTranslation() {
+  ScopedTraceSpan span("FilterRelativeTranslation");
   if (options_.extract_maximal_rigid_subgraph) {
     LOG(INFO) << "Extracting maximal rigid component of viewing graph to "
                  "determine which cameras are well-constrained for position "
@@ -395,13 +647,14 @@ void GlobalReconstructionEstimator::FilterRelativeTranslation() {
   }
   // Remove any disconnected views from the estimation.
   const std::unordered_set<ViewId> removed_views =
-      RemoveDisconnectedViewPairs(view_graph_);
+      RemoveDisconnectedViewPairs(options_.num_threads, view_graph_);
   for (const ViewId removed_view : removed_views) {
     orientations_.erase(removed_view);
   }
 }
 
 bool GlobalReconstructionEstimator::EstimatePosition() {
+  ScopedTraceSpan span("EstimatePositions");
   // Estimate position.
   const auto& view_pairs = view_graph_->GetAllEdges();
   std::unique_ptr<PositionEstimator> position_estimator;
@@ -409,13 +662,34 @@ bool GlobalReconstructionEstimator::EstimatePosition() {
   // Choose the global position estimation type.
   switch (options_.global_position_estimator_type) {
     case GlobalPositionEstimatorType::LEAST_UNSQUARED_DEVIATION: {
-      position_estimator.reset(new LeastUnsquaredDeviationPositionEstimator(
-          options_.least_unsquared_deviation_position_estimator_options));
+      LeastUnsquaredDeviationPositionEstimator* lud_position_estimator =
+          new LeastUnsquaredDeviationPositionEstimator(
+              options_.least_unsquared_deviation_position_estimator_options);
+      position_estimator.reset(lud_position_estimator);
+
+      // Warm start the solver from the position priors.
+      std::unordered_map<ViewId, Eigen::Vector3d> position_priors,
+          rotated_position_priors;
+      if (options_.use_position_priors) {
+        GetPositionPriors(*reconstruction_, &position_priors);
+      }
+      if (!position_priors.empty() &&
+          RotatePositionPriorsToOrientationFrame(view_pairs,
+                                                 orientations_,
+                                                 position_priors,
+                                                 &rotated_position_priors)) {
+        lud_position_estimator->SetInitialPositions(rotated_position_priors);
+      }
       break;
     }
     case GlobalPositionEstimatorType::NONLINEAR: {
-      position_estimator.reset(new NonlinearPositionEstimator(
-          options_.nonlinear_position_estimator_options, *reconstruction_));
+      NonlinearPositionEstimator::Options nonlinear_options =
+          options_.nonlinear_position_estimator_options;
+      if (options_.use_position_priors) {
+        nonlinear_options.initialize_positions_from_priors = true;
+      }
+      position_estimator.reset(
+          new NonlinearPositionEstimator(nonlinear_options, *reconstruction_));
       break;
     }
     case GlobalPositionEstimatorType::LINEAR_TRIPLET: {
@@ -435,7 +709,237 @@ bool GlobalReconstructionEstimator::EstimatePosition() {
                                                &positions_);
 }
 
+bool GlobalReconstructionEstimator::EstimatePosesOfPartition(
+    ViewGraph* view_graph, Reconstruction* reconstruction) {
+  view_graph_ = view_graph;
+  reconstruction_ = reconstruction;
+  orientations_.clear();
+  positions_.clear();
+  if (!FilterInitialViewGraph() || !EstimateGlobalRotations()) {
+    return false;
+  }
+  FilterRotations();
+  OptimizePairwiseTranslations();
+  FilterRelativeTranslation();
+  return EstimatePosition();
+}
+
+bool GlobalReconstructionEstimator::EstimatePosesFromPartitions() {
+  ScopedTraceSpan span("EstimatePosesFromPartitions");
+  // The minimum number of estimated views that a partition must share with
+  // the merged partitions to be aligned to them.
+  static const int kMinNumCommonViews = 4;
+
+  std::vector<std::unordered_set<ViewId> > partitions;
+  PartitionViewGraph(*view_graph_,
+                     options_.max_num_views_per_partition,
+                     options_.num_overlapping_views_per_partition,
+                     &partitions);
+  LOG(INFO) << "Partitioned the view graph into " << partitions.size()
+            << " partitions.";
+
+  // The partitions are reconstructed in parallel and share the threads. They
+  // are not partitioned again and do not report their progress. Each partition
+  // has its own random number generator so that the result does not depend on
+  // the scheduling of the partitions.
+  const int num_parallel_partitions = std::max(
+      1, std::min(options_.num_threads, static_cast<int>(partitions.size())));
+  ReconstructionEstimatorOptions partition_options = options_;
+  partition_options.max_num_views_per_partition = 0;
+  partition_options.progress_reporter = nullptr;
+  partition_options.num_threads =
+      std::max(1, options_.num_threads / num_parallel_partitions);
+  const unsigned base_seed =
+      options_.rng == nullptr
+          ? 0
+          : static_cast<unsigned>(
+                options_.rng->RandInt(0, std::numeric_limits<int>::max()));
+
+  // Only the camera poses of each partition are estimated (steps 3 - 7 of the
+  // pipeline), since the structure is estimated once all partitions have been
+  // merged. Only the poses are kept so that the memory of all partition
+  // reconstructions is not held at once.
+  std::vector<Reconstruction> partition_cameras(partitions.size());
+  {
+    ThreadPool pool(num_parallel_partitions);
+    for (int i = 0; i < partitions.size(); i++) {
+      pool.Add([&, i]() {
+        if (options_.progress_reporter != nullptr &&
+            options_.progress_reporter->IsCancelled()) {
+          return;
+        }
+
+        ViewGraph view_graph;
+        view_graph_->ExtractSubgraph(partitions[i], &view_graph);
+        Reconstruction reconstruction;
+        reconstruction_->GetSubReconstruction(partitions[i], &reconstruction);
+
+        ReconstructionEstimatorOptions estimator_options = partition_options;
+        if (options_.rng != nullptr) {
+          estimator_options.rng = std::make_shared<RandomNumberGenerator>(
+              DeriveSeed(base_seed, i));
+        }
+        GlobalReconstructionEstimator estimator(estimator_options);
+        if (!estimator.EstimatePosesOfPartition(&view_graph, &reconstruction)) {
+          LOG(WARNING) << "Could not estimate the poses of a partition of "
+                       << partitions[i].size() << " views.";
+          return;
+        }
+
+        for (const auto& position : estimator.positions_) {
+          const Vector3d* orientation =
+              FindOrNull(estimator.orientations_, position.first);
+          if (orientation == nullptr) {
+            continue;
+          }
+          const ViewId camera_id = partition_cameras[i].AddView(
+              reconstruction.View(position.first)->Name());
+          View* camera_view = partition_cameras[i].MutableView(camera_id);
+          camera_view->MutableCamera()->SetOrientationFromAngleAxis(
+              *orientation);
+          camera_view->MutableCamera()->SetPosition(position.second);
+          camera_view->SetEstimated(true);
+        }
+      });
+    }
+  }
+  if (options_.progress_reporter != nullptr &&
+      options_.progress_reporter->IsCancelled()) {
+    return false;
+  }
+
+  // Merge the partitions greedily: start with the partition with the most
+  // estimated views, then repeatedly align the partition that shares the most
+  // estimated views with the merged partitions. A partition is only merged if
+  // most of its shared views are inliers to a robust alignment. Views that are
+  // in several partitions keep the pose of the first merged partition.
+  Reconstruction merged_cameras;
+  std::vector<bool> is_merged(partitions.size(), false);
+  int num_merged_partitions = 0;
+  int partition_to_merge = 0;
+  for (int i = 1; i < partition_cameras.size(); i++) {
+    if (partition_cameras[i].NumViews() >
+        partition_cameras[partition_to_merge].NumViews()) {
+      partition_to_merge = i;
+    }
+  }
+  while (partition_to_merge >= 0) {
+    Reconstruction* cameras = &partition_cameras[partition_to_merge];
+    is_merged[partition_to_merge] = true;
+    if (merged_cameras.NumViews() == 0 ||
+        AlignPartitionToMergedCameras(options_.rng, merged_cameras, cameras)) {
+      for (const ViewId view_id : cameras->ViewIds()) {
+        const View* view = cameras->View(view_id);
+        if (merged_cameras.ViewIdFromName(view->Name()) != kInvalidViewId) {
+          continue;
+        }
+        const ViewId merged_view_id = merged_cameras.AddView(view->Name());
+        View* merged_view = merged_cameras.MutableView(merged_view_id);
+        merged_view->MutableCamera()->SetOrientationFromAngleAxis(
+            view->Camera().GetOrientationAsAngleAxis());
+        merged_view->MutableCamera()->SetPosition(
+            view->Camera().GetPosition());
+        merged_view->SetEstimated(true);
+      }
+      ++num_merged_partitions;
+    } else {
+      LOG(WARNING) << "Could not robustly align a partition of "
+                   << cameras->NumViews()
+                   << " estimated views to the merged partitions.";
+    }
+
+    partition_to_merge = -1;
+    int max_num_common_views = kMinNumCommonViews - 1;
+    for (int i = 0; i < partition_cameras.size(); i++) {
+      if (is_merged[i]) {
+        continue;
+      }
+      const int num_common_views =
+          FindCommonViewsByName(merged_cameras, partition_cameras[i]).size();
+      if (num_common_views > max_num_common_views) {
+        max_num_common_views = num_common_views;
+        partition_to_merge = i;
+      }
+    }
+  }
+  LOG(INFO) << "Merged " << num_merged_partitions << " of "
+            << partitions.size() << " partitions with "
+            << merged_cameras.NumViews() << " estimated views.";
+
+  for (const ViewId merged_view_id : merged_cameras.ViewIds()) {
+    const View* merged_view = merged_cameras.View(merged_view_id);
+    const ViewId view_id = reconstruction_->ViewIdFromName(merged_view->Name());
+    orientations_[view_id] = merged_view->Camera().GetOrientationAsAngleAxis();
+    positions_[view_id] = merged_view->Camera().GetPosition();
+  }
+  return positions_.size() >= 2;
+}
+
+bool GlobalReconstructionEstimator::AlignReconstructionToPositionPriors() {
+  // At least 4 priors are needed to estimate the alignment robustly.
+  static const int kMinNumPositionPriors = 4;
+
+  std::vector<Eigen::Vector3d> positions, position_priors;
+  for (const ViewId view_id : reconstruction_->ViewIds()) {
+    const View* view = reconstruction_->View(view_id);
+    const Prior<3>& position_prior = view->CameraIntrinsicsPrior().position;
+    if (!view->IsEstimated() || !position_prior.is_set) {
+      continue;
+    }
+    positions.emplace_back(view->Camera().GetPosition());
+    position_priors.emplace_back(
+        Eigen::Map<const Eigen::Vector3d>(position_prior.value));
+  }
+  if (positions.size() < kMinNumPositionPriors) {
+    return false;
+  }
+
+  // Bad GPS fixes are rejected with RANSAC so that they do not skew the
+  // alignment of the whole reconstruction.
+  RansacParameters params;
+  params.rng = options_.rng;
+  params.max_iterations = 1000;
+  params.use_mle = true;
+  params.error_thresh = options_.position_prior_alignment_threshold_meters *
+                        options_.position_prior_alignment_threshold_meters;
+  params.failure_probability = 1e-4;
+  SimilarityTransformation sim_transform;
+  RansacSummary summary;
+  if (!EstimateSimilarityTransformationRobust(params,
+                                              position_priors,
+                                              positions,
+                                              &sim_transform,
+                                              &summary)) {
+    return false;
+  }
+  TransformReconstruction(sim_transform.rotation,
+                          sim_transform.translation,
+                          sim_transform.scale,
+                          reconstruction_);
+  VLOG(2) << "Aligned the reconstruction to " << summary.inliers.size()
+          << " of " << positions.size()
+          << " position priors with a scale of " << sim_transform.scale
+          << ".";
+  return true;
+}
+
+void GlobalReconstructionEstimator::SelectTracksToTriangulate() {
+  ScopedTraceSpan span("SelectTracksToTriangulate");
+  tracks_to_triangulate_.clear();
+  triangulate_track_subset_ = SelectGoodTracksForTriangulation(
+      *reconstruction_,
+      options_.track_subset_selection_long_track_length_threshold,
+      options_.track_selection_image_grid_cell_size_pixels,
+      options_.max_num_tracks_per_grid_cell_before_triangulation,
+      options_.min_num_optimized_tracks_per_view,
+      &tracks_to_triangulate_);
+  LOG(INFO) << "Selected " << tracks_to_triangulate_.size() << " of "
+            << reconstruction_->NumTracks()
+            << " tracks to triangulate before bundle adjustment.";
+}
+
 void GlobalReconstructionEstimator::EstimateStructure() {
+  ScopedTraceSpan span("EstimateStructure");
   // Estimate all tracks.
   TrackEstimator::Options triangulation_options;
   triangulation_options.max_acceptable_reprojection_error_pixels =
@@ -448,13 +952,55 @@ void GlobalReconstructionEstimator::EstimateStructure() {
   triangulation_options.ba_options.verbose = false;
   triangulation_options.num_threads = options_.num_threads;
   TrackEstimator track_estimator(triangulation_options, reconstruction_);
-  const TrackEstimator::Summary summary = track_estimator.EstimateAllTracks();
+  const TrackEstimator::Summary summary =
+      triangulate_track_subset_
+          ? track_estimator.EstimateTracks(tracks_to_triangulate_)
+          : track_estimator.EstimateAllTracks();
+}
+
+void GlobalReconstructionEstimator::EstimateDeferredStructure() {
+  ScopedTraceSpan span("EstimateDeferredStructure");
+  if (!triangulate_track_subset_) {
+    return;
+  }
+
+  std::unordered_set<TrackId> deferred_tracks;
+  for (const TrackId track_id : reconstruction_->TrackIds()) {
+    if (!ContainsKey(tracks_to_triangulate_, track_id)) {
+      deferred_tracks.emplace(track_id);
+    }
+  }
+
+  // The camera poses are already refined, so the deferred tracks are only
+  // triangulated. They are not filtered again after this, so they must also
+  // pass the outlier threshold.
+  TrackEstimator::Options triangulation_options;
+  triangulation_options.max_acceptable_reprojection_error_pixels =
+      std::min(options_.triangulation_max_reprojection_error_in_pixels,
+               options_.max_reprojection_error_in_pixels);
+  triangulation_options.min_triangulation_angle_degrees =
+      options_.min_triangulation_angle_degrees;
+  triangulation_options.bundle_adjustment = false;
+  triangulation_options.num_threads = options_.num_threads;
+  TrackEstimator track_estimator(triangulation_options, reconstruction_);
+  const TrackEstimator::Summary summary =
+      track_estimator.EstimateTracks(deferred_tracks);
+  LOG(INFO) << summary.estimated_tracks.size() << " of "
+            << deferred_tracks.size() << " deferred tracks were triangulated.";
+
+  triangulate_track_subset_ = false;
+  tracks_to_triangulate_.clear();
 }
 
 bool GlobalReconstructionEstimator::BundleAdjustment() {
+  ScopedTraceSpan span("BundleAdjustment");
   // Bundle adjustment.
   bundle_adjustment_options_ =
       SetBundleAdjustmentOptions(options_, positions_.size());
+  if (is_aligned_to_position_priors_) {
+    bundle_adjustment_options_.position_prior_weight =
+        options_.position_prior_weight;
+  }
 
   // If desired, select good tracks to optimize for BA. This dramatically
   // reduces the number of parameters in bundle adjustment, and does a decent
@@ -467,6 +1013,7 @@ bool GlobalReconstructionEstimator::BundleAdjustment() {
           options_.track_subset_selection_long_track_length_threshold,
           options_.track_selection_image_grid_cell_size_pixels,
           options_.min_num_optimized_tracks_per_view,
+          options_.num_threads,
           &tracks_to_optimize)) {
     // Set all tracks that were not chosen for BA to be unestimated so that they
     // do not affect the bundle adjustment optimization.
@@ -488,14 +1035,23 @@ bool GlobalReconstructionEstimator::BundleAdjustment() {
                                         views_to_optimize,
                                         tracks_to_optimize,
                                         reconstruction_);
+  // Rebuild the undistortion lookup tables for the refined intrinsics.
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
   return bundle_adjustment_summary.success;
 }
 
 bool GlobalReconstructionEstimator::BundleAdjustCameraPositionsAndPoints() {
+  ScopedTraceSpan span("BundleAdjustCameraPositionsAndPoints");
   bundle_adjustment_options_ =
       SetBundleAdjustmentOptions(options_, positions_.size());
   bundle_adjustment_options_.constant_camera_orientation = true;
   bundle_adjustment_options_.constant_camera_position = false;
+  if (is_aligned_to_position_priors_) {
+    bundle_adjustment_options_.position_prior_weight =
+        options_.position_prior_weight;
+  }
   bundle_adjustment_options_.intrinsics_to_optimize =
       OptimizeIntrinsicsType::NONE;
   std::unordered_set<TrackId> tracks_to_optimize;
@@ -509,6 +1065,7 @@ bool GlobalReconstructionEstimator::BundleAdjustCameraPositionsAndPoints() {
           options_.track_subset_selection_long_track_length_threshold,
           options_.track_selection_image_grid_cell_size_pixels,
           options_.min_num_optimized_tracks_per_view,
+          options_.num_threads,
           &tracks_to_optimize)) {
     GetEstimatedTracksFromReconstruction(*reconstruction_, &tracks_to_optimize);
   }
@@ -35,6 +35,9 @@
 #ifndef THEIA_SFM_GLOBAL_RECONSTRUCTION_ESTIMATOR_H_
 #define THEIA_SFM_GLOBAL_RECONSTRUCTION_ESTIMATOR_H_
 
+#include <string>
+#include <unordered_set>
+
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/filter_view_pairs_from_relative_translation.h"
 #include "theia/sfm/reconstruction_estimator.h"
@@ -77,14 +80,40 @@ class GlobalReconstructionEstimator : public ReconstructionEstimator {
                                           Reconstruction* reconstruction);
 
  private:
+  // Reports the start of a step of the pipeline to the progress reporter (if
+  // any). Returns false if the estimation has been cancelled.
+  bool BeginStep(const std::string& step);
+
   bool FilterInitialViewGraph();
   void CalibrateCameras();
   bool EstimateGlobalRotations();
+  void InitializeGlobalRotations();
   void FilterRotations();
   void OptimizePairwiseTranslations();
   void FilterRelativeTranslation();
   bool EstimatePosition();
+  // Estimates the camera poses by reconstructing overlapping partitions of the
+  // view graph in parallel and aligning them robustly with similarity
+  // transformations. This replaces the rotation and position estimation steps
+  // for large view graphs.
+  bool EstimatePosesFromPartitions();
+  // Runs steps 3 - 7 of the pipeline (after filtering the view graph) on a
+  // partition, without triangulation or bundle adjustment. The estimated poses
+  // are left in orientations_ and positions_.
+  bool EstimatePosesOfPartition(ViewGraph* view_graph,
+                                Reconstruction* reconstruction);
+  // Transforms the estimated camera poses of the reconstruction to the frame of
+  // the position priors with a similarity transformation estimated with
+  // RANSAC. Returns false if fewer than 4 estimated views have position priors
+  // or if the priors do not agree on a transformation.
+  bool AlignReconstructionToPositionPriors();
+  // Chooses the subset of tracks that is triangulated and bundle adjusted when
+  // subsample_tracks_before_triangulation is set.
+  void SelectTracksToTriangulate();
   void EstimateStructure();
+  // Triangulates the tracks that were deferred by SelectTracksToTriangulate
+  // without bundle adjustment.
+  void EstimateDeferredStructure();
   bool BundleAdjustment();
   // Bundle adjust only the camera positions and points. The camera orientations
   // and intrinsics are held constant.
@@ -101,6 +130,17 @@ class GlobalReconstructionEstimator : public ReconstructionEstimator {
   std::unordered_map<ViewId, Eigen::Vector3d> orientations_;
   std::unordered_map<ViewId, Eigen::Vector3d> positions_;
 
+  int num_steps_started_;
+
+  // True if the reconstruction is in the frame of the position priors so that
+  // bundle adjustment may use them.
+  bool is_aligned_to_position_priors_;
+
+  // The tracks to triangulate before the final bundle adjustment. All tracks
+  // are triangulated if triangulate_track_subset_ is false.
+  bool triangulate_track_subset_;
+  std::unordered_set<TrackId> tracks_to_triangulate_;
+
   DISALLOW_COPY_AND_ASSIGN(GlobalReconstructionEstimator);
 };
 
@@ -124,4 +124,24 @@ Eigen::Vector3d GPSConverter::LLAToECEF(const Eigen::Vector3d& lla) {
   return ecef;
 }
 
+// Converts GPS latitude, longitude, and altitude to local ENU coordinates.
+Eigen::Vector3d GPSConverter::LLAToENU(const Eigen::Vector3d& lla,
+                                       const Eigen::Vector3d& reference_lla) {
+  const Eigen::Vector3d ecef_offset =
+      LLAToECEF(lla) - LLAToECEF(reference_lla);
+  const double lat = theia::DegToRad(reference_lla[0]);
+  const double lon = theia::DegToRad(reference_lla[1]);
+  const double sin_lat = std::sin(lat);
+  const double cos_lat = std::cos(lat);
+  const double sin_lon = std::sin(lon);
+  const double cos_lon = std::cos(lon);
+
+  // Rotate the ECEF offset into the tangent plane at the reference.
+  Eigen::Matrix3d ecef_to_enu;
+  ecef_to_enu << -sin_lon, cos_lon, 0.0,
+                 -sin_lat * cos_lon, -sin_lat * sin_lon, cos_lat,
+                 cos_lat * cos_lon, cos_lat * sin_lon, sin_lat;
+  return ecef_to_enu * ecef_offset;
+}
+
 }  // namespace theia
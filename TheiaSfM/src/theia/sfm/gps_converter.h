@@ -64,6 +64,12 @@ class GPSConverter {
   // latitude and longitude should be in degrees and the altitude in meters. The
   // returned ECEF coordinates will be in meters.
   static Eigen::Vector3d LLAToECEF(const Eigen::Vector3d& lla);
+
+  // Converts GPS latitude, longitude, and altitude to local East-North-Up
+  // (ENU) coordinates in meters with the origin at reference_lla. Latitudes
+  // and longitudes should be in degrees and altitudes in meters.
+  static Eigen::Vector3d LLAToENU(const Eigen::Vector3d& lla,
+                                  const Eigen::Vector3d& reference_lla);
 };
 
 }  // namespace theia
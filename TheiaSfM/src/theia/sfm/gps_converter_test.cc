@@ -88,4 +88,35 @@ TEST(GPSConverter, RoundTrip) {
   }
 }
 
+TEST(GPSConverter, LLAToENU) {
+  static const double kTolerance = 1e-6;
+  const Eigen::Vector3d reference_lla(27.173891, 78.042068, 168.0);
+
+  // The reference is at the origin and the altitude points up.
+  EXPECT_NEAR(GPSConverter::LLAToENU(reference_lla, reference_lla).norm(), 0.0,
+              kTolerance);
+  const Eigen::Vector3d up = GPSConverter::LLAToENU(
+      reference_lla + Eigen::Vector3d(0.0, 0.0, 10.0), reference_lla);
+  EXPECT_NEAR(up[0], 0.0, kTolerance);
+  EXPECT_NEAR(up[1], 0.0, kTolerance);
+  EXPECT_NEAR(up[2], 10.0, kTolerance);
+
+  // Small increases in latitude and longitude move north and east.
+  const Eigen::Vector3d north = GPSConverter::LLAToENU(
+      reference_lla + Eigen::Vector3d(1e-4, 0.0, 0.0), reference_lla);
+  EXPECT_GT(north[1], 10.0);
+  EXPECT_NEAR(north[0], 0.0, kTolerance);
+  const Eigen::Vector3d east = GPSConverter::LLAToENU(
+      reference_lla + Eigen::Vector3d(0.0, 1e-4, 0.0), reference_lla);
+  EXPECT_GT(east[0], 8.0);
+  EXPECT_LT(std::abs(east[1]), 1e-3);
+
+  // The distance is preserved.
+  const Eigen::Vector3d lla(27.174891, 78.041068, 180.0);
+  EXPECT_NEAR(GPSConverter::LLAToENU(lla, reference_lla).norm(),
+              (GPSConverter::LLAToECEF(lla) -
+               GPSConverter::LLAToECEF(reference_lla)).norm(),
+              kTolerance);
+}
+
 }  // namespace theia
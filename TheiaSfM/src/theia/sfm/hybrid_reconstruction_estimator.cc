@@ -39,6 +39,8 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <sstream>  // NOLINT
 #include <unordered_map>
 #include <utility>
@@ -52,6 +54,7 @@
 #include "theia/sfm/find_common_tracks_in_views.h"
 #include "theia/sfm/global_pose_estimation/linear_rotation_estimator.h"
 #include "theia/sfm/global_pose_estimation/nonlinear_rotation_estimator.h"
+#include "theia/sfm/global_pose_estimation/orientations_from_chordal_l2.h"
 #include "theia/sfm/global_pose_estimation/robust_rotation_estimator.h"
 #include "theia/sfm/global_pose_estimation/rotation_estimator.h"
 #include "theia/sfm/localize_view_to_reconstruction.h"
@@ -69,8 +72,12 @@
 #include "theia/sfm/visibility_pyramid.h"
 #include "theia/solvers/sample_consensus_estimator.h"
 #include "theia/util/map_util.h"
+#include "theia/util/progress_reporter.h"
+#include "theia/util/random.h"
 #include "theia/util/stringprintf.h"
+#include "theia/util/threadpool.h"
 #include "theia/util/timer.h"
+#include "theia/util/trace.h"
 #include "theia/util/util.h"
 
 namespace theia {
@@ -139,8 +146,12 @@ HybridReconstructionEstimator::HybridReconstructionEstimator(
 
 ReconstructionEstimatorSummary HybridReconstructionEstimator::Estimate(
     ViewGraph* view_graph, Reconstruction* reconstruction) {
+  ScopedTraceSpan span("HybridReconstructionEstimator");
   reconstruction_ = reconstruction;
   view_graph_ = view_graph;
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
 
   // Initialize the unlocalized_views_ variable.
   const auto& view_ids = reconstruction_->ViewIds();
@@ -156,12 +167,23 @@ ReconstructionEstimatorSummary HybridReconstructionEstimator::Estimate(
   Timer timer;
   double time_to_find_initial_seed = 0;
 
+  // Progress is measured by the number of localized views.
+  ProgressReporter* progress_reporter = options_.progress_reporter.get();
+  const int num_unlocalized_views = unlocalized_views_.size();
+  if (progress_reporter != nullptr) {
+    progress_reporter->BeginStage("HybridReconstructionEstimator",
+                                  num_unlocalized_views);
+  }
+
   // Set the known camera intrinsics.
   timer.Reset();
   SetCameraIntrinsicsFromPriors(reconstruction_);
   summary_.camera_intrinsics_calibration_time = timer.ElapsedTimeInSeconds();
 
   // Step 1: Estimate camera orientations using a global rotation estimator.
+  if (progress_reporter != nullptr) {
+    progress_reporter->SetStep("Estimating camera orientations");
+  }
   if (!EstimateCameraOrientations()) {
     LOG(ERROR) << "Could not estimate camera rotations for Hybrid SfM.";
     summary_.success = false;
@@ -182,6 +204,12 @@ ReconstructionEstimatorSummary HybridReconstructionEstimator::Estimate(
   }
   time_to_find_initial_seed = timer.ElapsedTimeInSeconds();
 
+  if (progress_reporter != nullptr) {
+    progress_reporter->Increment(num_unlocalized_views -
+                                 unlocalized_views_.size());
+    progress_reporter->SetStep("Localizing views");
+  }
+
   // Try to add as many views as possible to the reconstruction until no more
   // views can be localized.
   std::vector<ViewId> views_to_localize;
@@ -198,10 +226,43 @@ ReconstructionEstimatorSummary HybridReconstructionEstimator::Estimate(
     FindViewsToLocalize(&views_to_localize);
     summary_.pose_estimation_time += timer.ElapsedTimeInSeconds();
 
+    if (progress_reporter != nullptr && progress_reporter->IsCancelled()) {
+      LOG(INFO) << "Hybrid reconstruction estimation was cancelled.";
+      summary_.success = false;
+      return summary_;
+    }
+
+    // Localize all candidate views at once with their known orientations. If
+    // none of them could be localized, fall back to localizing the views one
+    // at a time below.
+    if (options_.localize_views_in_parallel_with_known_orientation &&
+        views_to_localize.size() > 1) {
+      int num_localized_views = 0;
+      if (!LocalizeViewsInParallel(views_to_localize, &num_localized_views)) {
+        LOG(WARNING) << "Bundle adjustment failed!";
+        summary_.success = false;
+        return summary_;
+      }
+      if (progress_reporter != nullptr) {
+        progress_reporter->Increment(num_localized_views);
+      }
+      if (num_localized_views > 0) {
+        failed_localization_attempts =
+            views_to_localize.size() - num_localized_views;
+        continue;
+      }
+    }
+
     // Attempt to localize all candidate views and estimate new 3D
     // points. Bundle Adjustment is run as either partial or full BA depending
     // on the current state of the reconstruction.
     for (int i = 0; i < views_to_localize.size(); i++) {
+      if (progress_reporter != nullptr && progress_reporter->IsCancelled()) {
+        LOG(INFO) << "Hybrid reconstruction estimation was cancelled.";
+        summary_.success = false;
+        return summary_;
+      }
+
       timer.Reset();
 
       // Localize the view to the reconstruciton. If the orientation was
@@ -216,6 +277,9 @@ ReconstructionEstimatorSummary HybridReconstructionEstimator::Estimate(
 
       reconstructed_views_.push_back(views_to_localize[i]);
       unlocalized_views_.erase(views_to_localize[i]);
+      if (progress_reporter != nullptr) {
+        progress_reporter->Increment();
+      }
 
       // Remove any tracks that have very bad 3D point reprojections after the
       // new view has been merged. This can happen when a new observation of a
@@ -240,7 +304,8 @@ ReconstructionEstimatorSummary HybridReconstructionEstimator::Estimate(
 
         // Step 6: Then perform partial Bundle Adjustment.
         timer.Reset();
-        ba_success = PartialBundleAdjustment();
+        ba_success = PartialBundleAdjustment(
+            options_.partial_bundle_adjustment_num_views);
         summary_.bundle_adjustment_time += timer.ElapsedTimeInSeconds();
       } else {
         // Step 5: Perform triangulation on all views.
@@ -284,6 +349,7 @@ ReconstructionEstimatorSummary HybridReconstructionEstimator::Estimate(
 }
 
 bool HybridReconstructionEstimator::LocalizeView(const ViewId view_id) {
+  ScopedTraceSpan span("LocalizeView");
   if (ContainsKey(orientations_, view_id)) {
     localization_options_.assume_known_orientation = true;
     RansacSummary unused_ransac_summary;
@@ -306,7 +372,136 @@ bool HybridReconstructionEstimator::LocalizeView(const ViewId view_id) {
                                       &unused_ransac_summary);
 }
 
+bool HybridReconstructionEstimator::LocalizeViewsInParallel(
+    const std::vector<ViewId>& views_to_localize,
+    int* num_localized_views) {
+  ScopedTraceSpan span("LocalizeViewsInParallel");
+  Timer timer;
+
+  // Only the views with known orientations can be localized in parallel.
+  std::vector<ViewId> candidate_views;
+  candidate_views.reserve(views_to_localize.size());
+  for (const ViewId view_id : views_to_localize) {
+    if (ContainsKey(orientations_, view_id)) {
+      candidate_views.emplace_back(view_id);
+    }
+  }
+
+  // Each view draws its RANSAC samples from a stream seeded by its view id so
+  // that the result does not depend on the number of threads.
+  const unsigned base_seed =
+      options_.rng != nullptr
+          ? static_cast<unsigned>(
+                options_.rng->RandInt(0, std::numeric_limits<int>::max()))
+          : static_cast<unsigned>(reconstructed_views_.size());
+
+  // The positions are estimated against the current 3D points, which are not
+  // modified until all views are localized.
+  std::vector<Eigen::Vector3d> positions(candidate_views.size());
+  std::vector<char> is_localized(candidate_views.size(), 0);
+  {
+    ThreadPool pool(std::max(1, options_.num_threads));
+    for (int i = 0; i < candidate_views.size(); i++) {
+      pool.Add([&, i]() {
+        LocalizeViewToReconstructionOptions localization_options =
+            localization_options_;
+        localization_options.assume_known_orientation = true;
+        localization_options.ransac_params.rng =
+            std::make_shared<RandomNumberGenerator>(
+                DeriveSeed(base_seed, candidate_views[i]));
+        RansacSummary unused_ransac_summary;
+        is_localized[i] = EstimateViewPositionWithKnownOrientation(
+            candidate_views[i],
+            localization_options,
+            *reconstruction_,
+            &positions[i],
+            &unused_ransac_summary);
+      });
+    }
+  }
+
+  // Add the localized views to the reconstruction.
+  std::vector<ViewId> new_views;
+  std::unordered_set<TrackId> tracks_in_new_views;
+  for (int i = 0; i < candidate_views.size(); i++) {
+    if (!is_localized[i]) {
+      continue;
+    }
+    View* view = reconstruction_->MutableView(candidate_views[i]);
+    view->MutableCamera()->SetPosition(positions[i]);
+    view->SetEstimated(true);
+    reconstructed_views_.push_back(candidate_views[i]);
+    unlocalized_views_.erase(candidate_views[i]);
+    new_views.emplace_back(candidate_views[i]);
+    const auto& track_ids = view->TrackIds();
+    tracks_in_new_views.insert(track_ids.begin(), track_ids.end());
+  }
+  summary_.pose_estimation_time += timer.ElapsedTimeInSeconds();
+  *num_localized_views = new_views.size();
+  VLOG(1) << "Localized " << new_views.size() << " of "
+          << views_to_localize.size() << " views in parallel.";
+  if (new_views.empty()) {
+    return true;
+  }
+
+  // Remove the tracks that have bad reprojections in the new views.
+  RemoveOutlierTracks(
+      tracks_in_new_views,
+      triangulation_options_.max_acceptable_reprojection_error_pixels);
+
+  // Triangulate the new views together and run a single bundle adjustment for
+  // all of them. Partial BA optimizes at least all of the new views.
+  bool ba_success = false;
+  if (UnoptimizedGrowthPercentage() <
+      options_.full_bundle_adjustment_growth_percent) {
+    timer.Reset();
+    TrackEstimator track_estimator(triangulation_options_, reconstruction_);
+    track_estimator.EstimateTracks(tracks_in_new_views);
+    summary_.triangulation_time += timer.ElapsedTimeInSeconds();
+
+    timer.Reset();
+    ba_success = PartialBundleAdjustment(
+        std::max(options_.partial_bundle_adjustment_num_views,
+                 static_cast<int>(new_views.size())));
+    summary_.bundle_adjustment_time += timer.ElapsedTimeInSeconds();
+  } else {
+    timer.Reset();
+    TrackEstimator track_estimator(triangulation_options_, reconstruction_);
+    track_estimator.EstimateAllTracks();
+    summary_.triangulation_time += timer.ElapsedTimeInSeconds();
+
+    timer.Reset();
+    ba_success = FullBundleAdjustment();
+    summary_.bundle_adjustment_time += timer.ElapsedTimeInSeconds();
+  }
+
+  SetUnderconstrainedAsUnestimated();
+  return ba_success;
+}
+
+void HybridReconstructionEstimator::InitializeCameraOrientations() {
+  ScopedTraceSpan span("InitializeCameraOrientations");
+  Timer timer;
+  if (options_.initialize_rotations_with_chordal_l2 &&
+      OrientationsFromChordalL2(
+          view_graph_->GetAllEdges(), options_.num_threads, &orientations_)) {
+    VLOG(1) << "Initialized the orientations with chordal L2 rotation "
+               "averaging in "
+            << timer.ElapsedTimeInSeconds() << " seconds.";
+    return;
+  }
+
+  // Initialize the orientation estimations by walking along the maximum
+  // spanning tree.
+  CHECK(OrientationsFromMaximumSpanningTree(
+      *view_graph_, options_.num_threads, &orientations_))
+      << "Could not estimate orientations from a spanning tree.";
+  VLOG(1) << "Initialized the orientations from the maximum spanning tree in "
+          << timer.ElapsedTimeInSeconds() << " seconds.";
+}
+
 bool HybridReconstructionEstimator::EstimateCameraOrientations() {
+  ScopedTraceSpan span("EstimateCameraOrientations");
   // TODO(csweeney): Currently we use all view pairs to estimate the orientation
   // for all possible cameras. This ignores any information about views that are
   // already estimated, which should instead be exposed to improve the
@@ -317,20 +512,15 @@ bool HybridReconstructionEstimator::EstimateCameraOrientations() {
   std::unique_ptr<RotationEstimator> rotation_estimator;
   switch (options_.global_rotation_estimator_type) {
     case GlobalRotationEstimatorType::ROBUST_L1L2: {
-      // Initialize the orientation estimations by walking along the maximum
-      // spanning tree.
-      CHECK(OrientationsFromMaximumSpanningTree(*view_graph_, &orientations_))
-          << "Could not estimate orientations from a spanning tree.";
+      InitializeCameraOrientations();
       RobustRotationEstimator::Options robust_rotation_estimator_options;
+      robust_rotation_estimator_options.num_threads = options_.num_threads;
       rotation_estimator.reset(
           new RobustRotationEstimator(robust_rotation_estimator_options));
       break;
     }
     case GlobalRotationEstimatorType::NONLINEAR: {
-      // Initialize the orientation estimations by walking along the maximum
-      // spanning tree.
-      CHECK(OrientationsFromMaximumSpanningTree(*view_graph_, &orientations_))
-          << "Could not estimate orientations from a spanning tree.";
+      InitializeCameraOrientations();
       rotation_estimator.reset(new NonlinearRotationEstimator());
       break;
     }
@@ -347,6 +537,7 @@ bool HybridReconstructionEstimator::EstimateCameraOrientations() {
   }
 
   // Return false if the rotation estimation does not succeed.
+  ScopedTraceSpan estimation_span("AverageRotations");
   if (!rotation_estimator->EstimateRotations(view_pairs, &orientations_)) {
     return false;
   }
@@ -466,15 +657,24 @@ bool HybridReconstructionEstimator::InitializeCamerasWithKnownOrientation(
   const std::vector<ViewId> view_pair = {view_ids.first, view_ids.second};
   const std::vector<TrackId> common_tracks =
       FindCommonTracksInViews(*reconstruction_, view_pair);
+  std::vector<Eigen::Vector2d> features1, features2;
+  features1.reserve(common_tracks.size());
+  features2.reserve(common_tracks.size());
+  for (const TrackId track_id : common_tracks) {
+    features1.emplace_back(*view1->GetFeature(track_id));
+    features2.emplace_back(*view2->GetFeature(track_id));
+  }
+  std::vector<Eigen::Vector3d> rays1, rays2;
+  camera1.PixelsToUnitDepthRays(features1, &rays1);
+  camera2->PixelsToUnitDepthRays(features2, &rays2);
+
+  // Retrieve the rotated and normalized correspondences.
   std::vector<FeatureCorrespondence> rotated_correspondences;
   rotated_correspondences.reserve(common_tracks.size());
-  for (const TrackId track_id : common_tracks) {
-    // Retrieve the rotated and normalized correspondences.
+  for (int i = 0; i < common_tracks.size(); i++) {
     FeatureCorrespondence match;
-    match.feature1 =
-        camera1.PixelToUnitDepthRay(*view1->GetFeature(track_id)).hnormalized();
-    match.feature2 = camera2->PixelToUnitDepthRay(*view2->GetFeature(track_id))
-                         .hnormalized();
+    match.feature1 = rays1[i].hnormalized();
+    match.feature2 = rays2[i].hnormalized();
     rotated_correspondences.emplace_back(match);
   }
 
@@ -517,6 +717,7 @@ bool HybridReconstructionEstimator::InitializeCamerasWithKnownOrientation(
 }
 
 bool HybridReconstructionEstimator::ChooseInitialViewPair() {
+  ScopedTraceSpan span("ChooseInitialViewPair");
   static const int kMinNumInitialTracks = 100;
 
   // Sort the view pairs by the number of geometrically verified matches.
@@ -642,6 +843,7 @@ void HybridReconstructionEstimator::
 
 void HybridReconstructionEstimator::FindViewsToLocalize(
     std::vector<ViewId>* views_to_localize) {
+  ScopedTraceSpan span("FindViewsToLocalize");
   // We localize all views that observe 75% or more of the best visibility
   // score.
   static const int kMinNumObserved3dPoints = 30;
@@ -685,6 +887,7 @@ void HybridReconstructionEstimator::FindViewsToLocalize(
 
 void HybridReconstructionEstimator::EstimateStructure(
     const ViewId view_id) {
+  ScopedTraceSpan span("EstimateStructure");
   // Estimate all tracks.
   TrackEstimator track_estimator(triangulation_options_, reconstruction_);
   const std::vector<TrackId>& tracks_in_view =
@@ -701,6 +904,7 @@ double HybridReconstructionEstimator::UnoptimizedGrowthPercentage() {
 }
 
 bool HybridReconstructionEstimator::FullBundleAdjustment() {
+  ScopedTraceSpan span("FullBundleAdjustment");
   // Full bundle adjustment.
   LOG(INFO) << "Running full bundle adjustment on the entire reconstruction.";
 
@@ -728,6 +932,7 @@ bool HybridReconstructionEstimator::FullBundleAdjustment() {
           options_.track_subset_selection_long_track_length_threshold,
           options_.track_selection_image_grid_cell_size_pixels,
           options_.min_num_optimized_tracks_per_view,
+          options_.num_threads,
           &tracks_to_optimize)) {
     SetTracksInViewsToUnestimated(reconstructed_views_,
                                   tracks_to_optimize,
@@ -747,6 +952,10 @@ bool HybridReconstructionEstimator::FullBundleAdjustment() {
                                         tracks_to_optimize,
                                         reconstruction_);
   num_optimized_views_ = reconstructed_views_.size();
+  // Rebuild the undistortion lookup tables for the refined intrinsics.
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
 
   const auto& track_ids = reconstruction_->TrackIds();
   const std::unordered_set<TrackId> all_tracks(track_ids.begin(),
@@ -756,12 +965,14 @@ bool HybridReconstructionEstimator::FullBundleAdjustment() {
   return ba_summary.success;
 }
 
-bool HybridReconstructionEstimator::PartialBundleAdjustment() {
+bool HybridReconstructionEstimator::PartialBundleAdjustment(
+    const int num_views_to_optimize) {
+  ScopedTraceSpan span("PartialBundleAdjustment");
 // Partial bundle adjustment only only the k most recently added views that
   // have not been optimized by full BA.
   const int partial_ba_size =
     std::min(static_cast<int>(reconstructed_views_.size()),
-             options_.partial_bundle_adjustment_num_views);
+             num_views_to_optimize);
   LOG(INFO) << "Running partial bundle adjustment on " << partial_ba_size
             << " views.";
 
@@ -800,6 +1011,7 @@ bool HybridReconstructionEstimator::PartialBundleAdjustment() {
           options_.track_subset_selection_long_track_length_threshold,
           options_.track_selection_image_grid_cell_size_pixels,
           options_.min_num_optimized_tracks_per_view,
+          options_.num_threads,
           &tracks_to_optimize)) {
     SetTracksInViewsToUnestimated(views_to_optimize,
                                   tracks_to_optimize,
@@ -826,6 +1038,9 @@ bool HybridReconstructionEstimator::PartialBundleAdjustment() {
                                                  views_to_optimize,
                                                  tracks_to_optimize,
                                                  reconstruction_);
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
 
   RemoveOutlierTracks(tracks_to_optimize,
                       options_.max_reprojection_error_in_pixels);
@@ -835,12 +1050,14 @@ bool HybridReconstructionEstimator::PartialBundleAdjustment() {
 void HybridReconstructionEstimator::RemoveOutlierTracks(
     const std::unordered_set<TrackId>& tracks_to_check,
     const double max_reprojection_error_in_pixels) {
+  ScopedTraceSpan span("RemoveOutlierTracks");
   // Remove the outlier points based on the reprojection error and how
   // well-constrained the 3D points are.
   int num_points_removed = SetOutlierTracksToUnestimated(
       tracks_to_check,
       max_reprojection_error_in_pixels,
       options_.min_triangulation_angle_degrees,
+      options_.num_threads,
       reconstruction_);
   LOG(INFO) << num_points_removed << " outlier points were removed.";
 }
@@ -100,10 +100,20 @@ class HybridReconstructionEstimator : public ReconstructionEstimator {
   // orientation is not known use standard localization.
   bool LocalizeView(const ViewId view_id);
 
+  // Localizes the views with known orientations in parallel by estimating only
+  // their positions, then triangulates the new views and runs a single bundle
+  // adjustment. Returns false if bundle adjustment fails.
+  bool LocalizeViewsInParallel(const std::vector<ViewId>& views_to_localize,
+                               int* num_localized_views);
+
   // Estimate the camera orientations from the relative rotations using a global
   // rotation estimation algorithm.
   bool EstimateCameraOrientations();
 
+  // Initializes the camera orientations for the iterative rotation estimators
+  // with chordal L2 rotation averaging or the maximum spanning tree.
+  void InitializeCameraOrientations();
+
   // Choose two cameras to use as the seed for incremental reconstruction. These
   // cameras should observe 3D points that are well-conditioned. We determine
   // the conditioning of 3D points by examining the median viewing angle of the
@@ -144,7 +154,7 @@ class HybridReconstructionEstimator : public ReconstructionEstimator {
 
   // Performs partial bundle adjustment on the model. Only the k most recent
   // cameras (and the tracks observed in those views) are optimized.
-  bool PartialBundleAdjustment();
+  bool PartialBundleAdjustment(const int num_views_to_optimize);
 
   // Performs full bundle adjustment on the model.
   bool FullBundleAdjustment();
@@ -186,4 +186,16 @@ TEST(HybridReconstructionEstimator, VariableIntrinsics) {
   BuildAndVerifyReconstruction(kPositionToleranceMeters, options);
 }
 
+TEST(HybridReconstructionEstimator, ParallelLocalization) {
+  static const double kPositionToleranceMeters = 1e-2;
+
+  ReconstructionEstimatorOptions options;
+  options.reconstruction_estimator_type =
+      ReconstructionEstimatorType::HYBRID;
+  options.intrinsics_to_optimize = OptimizeIntrinsicsType::NONE;
+  options.localize_views_in_parallel_with_known_orientation = true;
+  options.num_threads = 4;
+  BuildAndVerifyReconstruction(kPositionToleranceMeters, options);
+}
+
 }  // namespace theia
@@ -64,8 +64,10 @@
 #include "theia/sfm/visibility_pyramid.h"
 #include "theia/solvers/sample_consensus_estimator.h"
 #include "theia/util/map_util.h"
+#include "theia/util/progress_reporter.h"
 #include "theia/util/stringprintf.h"
 #include "theia/util/timer.h"
+#include "theia/util/trace.h"
 #include "theia/util/util.h"
 
 namespace theia {
@@ -159,8 +161,12 @@ IncrementalReconstructionEstimator::IncrementalReconstructionEstimator(
 // is very costly) and so incremental SfM is not as efficient or scalable.
 ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
     ViewGraph* view_graph, Reconstruction* reconstruction) {
+  ScopedTraceSpan span("IncrementalReconstructionEstimator");
   reconstruction_ = reconstruction;
   view_graph_ = view_graph;
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
 
   // Initialize the unlocalized_views_ variable.
   const auto& view_ids = view_graph_->ViewIds();
@@ -176,6 +182,14 @@ ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
   Timer timer;
   double time_to_find_initial_seed = 0;
 
+  // Progress is measured by the number of localized views.
+  ProgressReporter* progress_reporter = options_.progress_reporter.get();
+  const int num_unlocalized_views = unlocalized_views_.size();
+  if (progress_reporter != nullptr) {
+    progress_reporter->BeginStage("IncrementalReconstructionEstimator",
+                                  num_unlocalized_views);
+  }
+
   // Set the known camera intrinsics.
   timer.Reset();
   SetCameraIntrinsicsFromPriors(reconstruction_);
@@ -197,6 +211,12 @@ ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
     time_to_find_initial_seed = timer.ElapsedTimeInSeconds();
   }
 
+  if (progress_reporter != nullptr) {
+    progress_reporter->Increment(num_unlocalized_views -
+                                 unlocalized_views_.size());
+    progress_reporter->SetStep("Localizing views");
+  }
+
   // Try to add as many views as possible to the reconstruction until no more
   // views can be localized.
   std::vector<ViewId> views_to_localize;
@@ -217,6 +237,12 @@ ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
     // points. Bundle Adjustment is run as either partial or full BA depending
     // on the current state of the reconstruction.
     for (int i = 0; i < views_to_localize.size(); i++) {
+      if (progress_reporter != nullptr && progress_reporter->IsCancelled()) {
+        LOG(INFO) << "Incremental reconstruction estimation was cancelled.";
+        summary_.success = false;
+        return summary_;
+      }
+
       timer.Reset();
       RansacSummary unused_ransac_summary;
       if (!LocalizeViewToReconstruction(views_to_localize[i],
@@ -230,6 +256,9 @@ ReconstructionEstimatorSummary IncrementalReconstructionEstimator::Estimate(
 
       reconstructed_views_.push_back(views_to_localize[i]);
       unlocalized_views_.erase(views_to_localize[i]);
+      if (progress_reporter != nullptr) {
+        progress_reporter->Increment();
+      }
 
       // Remove any tracks that have very bad 3D point reprojections after the
       // new view has been merged. This can happen when a new observation of a
@@ -321,6 +350,7 @@ void IncrementalReconstructionEstimator::InitializeCamerasFromTwoViewInfo(
 }
 
 bool IncrementalReconstructionEstimator::ChooseInitialViewPair() {
+  ScopedTraceSpan span("ChooseInitialViewPair");
   static const int kMinNumInitialTracks = 100;
 
   // Sort the view pairs by the number of geometrically verified matches.
@@ -419,6 +449,7 @@ void IncrementalReconstructionEstimator::
 
 void IncrementalReconstructionEstimator::FindViewsToLocalize(
     std::vector<ViewId>* views_to_localize) {
+  ScopedTraceSpan span("FindViewsToLocalize");
   // We localize all views that observe 75% or more of the best visibility
   // score.
   static const int kMinNumObserved3dPoints = 30;
@@ -462,6 +493,7 @@ void IncrementalReconstructionEstimator::FindViewsToLocalize(
 
 void IncrementalReconstructionEstimator::EstimateStructure(
     const ViewId view_id) {
+  ScopedTraceSpan span("EstimateStructure");
   // Estimate all tracks.
   TrackEstimator track_estimator(triangulation_options_, reconstruction_);
   const std::vector<TrackId>& tracks_in_view =
@@ -478,6 +510,7 @@ double IncrementalReconstructionEstimator::UnoptimizedGrowthPercentage() {
 }
 
 bool IncrementalReconstructionEstimator::FullBundleAdjustment() {
+  ScopedTraceSpan span("FullBundleAdjustment");
   // Full bundle adjustment.
   LOG(INFO) << "Running full bundle adjustment on the entire reconstruction.";
 
@@ -501,6 +534,7 @@ bool IncrementalReconstructionEstimator::FullBundleAdjustment() {
           options_.track_subset_selection_long_track_length_threshold,
           options_.track_selection_image_grid_cell_size_pixels,
           options_.min_num_optimized_tracks_per_view,
+          options_.num_threads,
           &tracks_to_optimize)) {
     SetTracksInViewsToUnestimated(
         reconstructed_views_, tracks_to_optimize, reconstruction_);
@@ -518,6 +552,10 @@ bool IncrementalReconstructionEstimator::FullBundleAdjustment() {
                                         tracks_to_optimize,
                                         reconstruction_);
   num_optimized_views_ = reconstructed_views_.size();
+  // Rebuild the undistortion lookup tables for the refined intrinsics.
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
 
   const auto& track_ids = reconstruction_->TrackIds();
   const std::unordered_set<TrackId> all_tracks(track_ids.begin(),
@@ -528,6 +566,7 @@ bool IncrementalReconstructionEstimator::FullBundleAdjustment() {
 }
 
 bool IncrementalReconstructionEstimator::PartialBundleAdjustment() {
+  ScopedTraceSpan span("PartialBundleAdjustment");
   // Partial bundle adjustment only only the k most recently added views that
   // have not been optimized by full BA.
   const int partial_ba_size =
@@ -566,6 +605,7 @@ bool IncrementalReconstructionEstimator::PartialBundleAdjustment() {
           options_.track_subset_selection_long_track_length_threshold,
           options_.track_selection_image_grid_cell_size_pixels,
           options_.min_num_optimized_tracks_per_view,
+          options_.num_threads,
           &tracks_to_optimize)) {
     SetTracksInViewsToUnestimated(
         views_to_optimize, tracks_to_optimize, reconstruction_);
@@ -588,6 +628,9 @@ bool IncrementalReconstructionEstimator::PartialBundleAdjustment() {
                                                  views_to_optimize,
                                                  tracks_to_optimize,
                                                  reconstruction_);
+  if (options_.use_undistortion_lookup_tables) {
+    UpdateUndistortionLookupTables(options_.num_threads, reconstruction_);
+  }
 
   RemoveOutlierTracks(tracks_to_optimize,
                       options_.max_reprojection_error_in_pixels);
@@ -597,12 +640,14 @@ bool IncrementalReconstructionEstimator::PartialBundleAdjustment() {
 void IncrementalReconstructionEstimator::RemoveOutlierTracks(
     const std::unordered_set<TrackId>& tracks_to_check,
     const double max_reprojection_error_in_pixels) {
+  ScopedTraceSpan span("RemoveOutlierTracks");
   // Remove the outlier points based on the reprojection error and how
   // well-constrained the 3D points are.
   int num_points_removed =
       SetOutlierTracksToUnestimated(tracks_to_check,
                                     max_reprojection_error_in_pixels,
                                     options_.min_triangulation_angle_degrees,
+                                    options_.num_threads,
                                     reconstruction_);
   LOG(INFO) << num_points_removed << " outlier points were removed.";
 }
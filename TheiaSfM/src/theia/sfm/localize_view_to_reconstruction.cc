@@ -34,6 +34,7 @@
 
 #include "theia/sfm/localize_view_to_reconstruction.h"
 
+#include <Eigen/Core>
 #include <glog/logging.h>
 #include <vector>
 
@@ -47,6 +48,7 @@
 #include "theia/sfm/reconstruction_estimator_utils.h"
 #include "theia/sfm/types.h"
 #include "theia/solvers/sample_consensus_estimator.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 namespace {
@@ -104,7 +106,10 @@ void GetIntrinsicsNormalized2D3DMatches(
     std::vector<FeatureCorrespondence2D3D>* matches) {
   const Camera& camera = view.Camera();
   const auto& tracks_in_view = view.TrackIds();
-  matches->reserve(tracks_in_view.size());
+  const int num_previous_matches = matches->size();
+  std::vector<Eigen::Vector2d> features;
+  features.reserve(tracks_in_view.size());
+  matches->reserve(num_previous_matches + tracks_in_view.size());
   for (const TrackId track_id : tracks_in_view) {
     const Track* track = reconstruction.Track(track_id);
     // We only use 3D points that have been estimated.
@@ -113,15 +118,52 @@ void GetIntrinsicsNormalized2D3DMatches(
     }
 
     FeatureCorrespondence2D3D correspondence;
-    const Feature& feature = *view.GetFeature(track_id);
-    // Remove the camera intrinsics from the feature.
-    correspondence.feature =
-        camera.PixelToNormalizedCoordinates(feature).hnormalized();
     correspondence.world_point = track->Point().hnormalized();
     matches->emplace_back(correspondence);
+    features.emplace_back(*view.GetFeature(track_id));
+  }
+
+  // Remove the camera intrinsics from all features at once.
+  std::vector<Eigen::Vector3d> normalized_features;
+  camera.PixelsToNormalizedCoordinates(features, &normalized_features);
+  for (int i = 0; i < features.size(); i++) {
+    (*matches)[num_previous_matches + i].feature =
+        normalized_features[i].hnormalized();
   }
 }
 
+// Estimates the camera position with RANSAC assuming that the orientation of
+// the camera is known. The matches must be normalized by the intrinsics.
+bool EstimateCameraPositionWithKnownOrientation(
+    const LocalizeViewToReconstructionOptions& options,
+    const std::vector<FeatureCorrespondence2D3D>& matches,
+    const Camera& camera,
+    Eigen::Vector3d* camera_position,
+    RansacSummary* summary) {
+  // Compute the reprojection error threshold scaled to account for the image
+  // resolution.
+  const double resolution_scaled_reprojection_error_threshold_pixels =
+      ComputeResolutionScaledThreshold(
+          options.reprojection_error_threshold_pixels,
+          camera.ImageWidth(),
+          camera.ImageHeight());
+
+  RansacParameters ransac_parameters = options.ransac_params;
+  ransac_parameters.error_thresh =
+      resolution_scaled_reprojection_error_threshold_pixels *
+      resolution_scaled_reprojection_error_threshold_pixels /
+      (camera.FocalLength() * camera.FocalLength());
+
+  const Eigen::Vector3d camera_orientation = camera.GetOrientationAsAngleAxis();
+  return EstimateAbsolutePoseWithKnownOrientation(ransac_parameters,
+                                                  RansacType::RANSAC,
+                                                  camera_orientation,
+                                                  matches,
+                                                  camera_position,
+                                                  summary) &&
+         summary->inliers.size() > options.min_num_inliers;
+}
+
 bool EstimateCameraPose(const bool known_intrinsics,
                         const LocalizeViewToReconstructionOptions& options,
                         const Reconstruction& reconstruction,
@@ -158,23 +200,9 @@ bool EstimateCameraPose(const bool known_intrinsics,
   // If we are assuming that the orientation is known then first try to use
   // the simplified camera positions solver.
   if (options.assume_known_orientation) {
-    ransac_parameters.error_thresh =
-        resolution_scaled_reprojection_error_threshold_pixels *
-        resolution_scaled_reprojection_error_threshold_pixels /
-        (camera->FocalLength() * camera->FocalLength());
-
-    // Return true if position estimation is successful. Otherwise the method
-    // will proceed to estimate the full pose.
-    const Eigen::Vector3d camera_orientation =
-        camera->GetOrientationAsAngleAxis();
     Eigen::Vector3d camera_position;
-    if (EstimateAbsolutePoseWithKnownOrientation(ransac_parameters,
-                                                 RansacType::RANSAC,
-                                                 camera_orientation,
-                                                 matches,
-                                                 &camera_position,
-                                                 summary) &&
-        summary->inliers.size() > options.min_num_inliers) {
+    if (EstimateCameraPositionWithKnownOrientation(
+            options, matches, *camera, &camera_position, summary)) {
       camera->SetPosition(camera_position);
       return true;
     } else {
@@ -223,6 +251,7 @@ bool LocalizeViewToReconstruction(
     const LocalizeViewToReconstructionOptions options,
     Reconstruction* reconstruction,
     RansacSummary* summary) {
+  ScopedTraceSpan span("LocalizeViewToReconstruction");
   CHECK_NOTNULL(reconstruction);
   CHECK_NOTNULL(summary);
 
@@ -257,4 +286,27 @@ bool LocalizeViewToReconstruction(
   return success;
 }
 
+bool EstimateViewPositionWithKnownOrientation(
+    const ViewId view_id,
+    const LocalizeViewToReconstructionOptions& options,
+    const Reconstruction& reconstruction,
+    Eigen::Vector3d* position,
+    RansacSummary* summary) {
+  ScopedTraceSpan span("EstimateViewPositionWithKnownOrientation");
+  CHECK_NOTNULL(position);
+  CHECK_NOTNULL(summary);
+
+  const View* view = CHECK_NOTNULL(reconstruction.View(view_id));
+  std::vector<FeatureCorrespondence2D3D> matches;
+  GetIntrinsicsNormalized2D3DMatches(reconstruction, *view, &matches);
+  if (matches.size() < options.min_num_inliers) {
+    VLOG(2) << "Not enough 2D-3D correspondences to localize view "
+            << view->Name();
+    return false;
+  }
+
+  return EstimateCameraPositionWithKnownOrientation(
+      options, matches, view->Camera(), position, summary);
+}
+
 }  // namespace theia
@@ -35,6 +35,8 @@
 #ifndef THEIA_SFM_LOCALIZE_VIEW_TO_RECONSTRUCTION_H_
 #define THEIA_SFM_LOCALIZE_VIEW_TO_RECONSTRUCTION_H_
 
+#include <Eigen/Core>
+
 #include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
 #include "theia/sfm/types.h"
 #include "theia/solvers/sample_consensus_estimator.h"
@@ -84,6 +86,18 @@ bool LocalizeViewToReconstruction(
     Reconstruction* reconstruction,
     RansacSummary* summary);
 
+// Estimates the position of the view from its 2D-3D correspondences assuming
+// that the orientation and intrinsics of its camera are known. Unlike
+// LocalizeViewToReconstruction, the reconstruction is not modified, so several
+// views may be localized in parallel. Returns true if more than
+// options.min_num_inliers inliers were found.
+bool EstimateViewPositionWithKnownOrientation(
+    const ViewId view_id,
+    const LocalizeViewToReconstructionOptions& options,
+    const Reconstruction& reconstruction,
+    Eigen::Vector3d* position,
+    RansacSummary* summary);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_LOCALIZE_VIEW_TO_RECONSTRUCTION_H_
@@ -0,0 +1,186 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/sfm/memory_accounting.h"
+
+#include <Eigen/Core>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/math/graph/connected_components.h"
+#include "theia/matching/feature_correspondence.h"
+#include "theia/matching/image_pair_match.h"
+#include "theia/matching/keypoints_and_descriptors.h"
+#include "theia/sfm/camera/camera_intrinsics_model.h"
+#include "theia/sfm/feature.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/track_builder.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/sfm/view_graph/view_graph.h"
+
+namespace theia {
+
+namespace {
+
+// Heap memory of a string that does not fit in the small string buffer.
+int64_t EstimateMemoryUsage(const std::string& str) {
+  return str.capacity() > sizeof(std::string) ? str.capacity() + 1 : 0;
+}
+
+int64_t EstimateMemoryUsage(const View& view) {
+  int64_t size_in_bytes = EstimateMemoryUsage(view.Name());
+
+  // The features are stored in a hash map from track id to feature. Assume a
+  // load factor of 1 since the bucket count is not accessible.
+  size_in_bytes += view.NumFeatures() *
+                   (HashNodeSizeInBytes<std::pair<const TrackId, Feature> >() +
+                    sizeof(void*));
+
+  // NOTE: Views in the same camera intrinsics group share the intrinsics so
+  // this overestimates the memory for shared calibration.
+  const auto& intrinsics = view.Camera().CameraIntrinsics();
+  if (intrinsics != nullptr) {
+    size_in_bytes += sizeof(CameraIntrinsicsModel) +
+                     intrinsics->NumParameters() * sizeof(double);
+  }
+  return size_in_bytes;
+}
+
+}  // namespace
+
+int64_t EstimateMemoryUsage(const KeypointsAndDescriptors& features) {
+  int64_t size_in_bytes = EstimateMemoryUsage(features.image_name) +
+                          features.keypoints.capacity() * sizeof(Keypoint) +
+                          features.descriptors.capacity() *
+                              sizeof(Eigen::VectorXf);
+  for (const Eigen::VectorXf& descriptor : features.descriptors) {
+    size_in_bytes += descriptor.size() * sizeof(float);
+  }
+  return size_in_bytes;
+}
+
+int64_t EstimateMemoryUsage(const ImagePairMatch& match) {
+  return EstimateMemoryUsage(match.image1) + EstimateMemoryUsage(match.image2) +
+         match.correspondences.capacity() * sizeof(FeatureCorrespondence);
+}
+
+int64_t EstimateMemoryUsage(const std::vector<ImagePairMatch>& matches) {
+  int64_t size_in_bytes = matches.capacity() * sizeof(ImagePairMatch);
+  for (const ImagePairMatch& match : matches) {
+    size_in_bytes += EstimateMemoryUsage(match);
+  }
+  return size_in_bytes;
+}
+
+int64_t EstimateMemoryUsage(const ViewGraph& view_graph) {
+  // Each edge is stored once in the edge map and twice in the adjacency sets of
+  // the vertices.
+  const auto& edges = view_graph.GetAllEdges();
+  return EstimateHashContainerMemoryUsage(edges) +
+         view_graph.NumViews() *
+             (HashNodeSizeInBytes<
+                  std::pair<const ViewId, std::unordered_set<ViewId> > >() +
+              2 * sizeof(void*)) +
+         2 * edges.size() * (HashNodeSizeInBytes<ViewId>() + sizeof(void*));
+}
+
+int64_t EstimateMemoryUsage(const Reconstruction& reconstruction) {
+  int64_t size_in_bytes = 0;
+
+  // Views, the view name lookup (which holds a second copy of the name), and
+  // the camera intrinsics group lookups.
+  const std::vector<ViewId> view_ids = reconstruction.ViewIds();
+  for (const ViewId view_id : view_ids) {
+    const View* view = reconstruction.View(view_id);
+    size_in_bytes +=
+        HashNodeSizeInBytes<std::pair<const ViewId, View> >() +
+        HashNodeSizeInBytes<std::pair<const std::string, ViewId> >() +
+        2 * HashNodeSizeInBytes<std::pair<const ViewId, ViewId> >() +
+        4 * sizeof(void*) + EstimateMemoryUsage(*view) +
+        EstimateMemoryUsage(view->Name());
+  }
+
+  // Tracks.
+  const std::vector<TrackId> track_ids = reconstruction.TrackIds();
+  for (const TrackId track_id : track_ids) {
+    const Track* track = reconstruction.Track(track_id);
+    size_in_bytes += HashNodeSizeInBytes<std::pair<const TrackId, Track> >() +
+                     sizeof(void*) +
+                     EstimateHashContainerMemoryUsage(track->ViewIds());
+  }
+  return size_in_bytes;
+}
+
+int64_t EstimateMemoryUsage(const TrackBuilder& track_builder) {
+  // Each feature is stored in the map from features to feature ids and in the
+  // disjoint set of the connected components.
+  typedef std::pair<const std::pair<ViewId, Feature>, uint64_t> FeatureIdEntry;
+  typedef std::pair<const uint64_t, ConnectedComponents<uint64_t>::Root>
+      DisjointSetEntry;
+  return static_cast<int64_t>(track_builder.NumFeatures()) *
+         (HashNodeSizeInBytes<FeatureIdEntry>() +
+          HashNodeSizeInBytes<DisjointSetEntry>() + 2 * sizeof(void*));
+}
+
+int64_t EstimateBundleAdjustmentMemoryUsage(const int num_residual_blocks,
+                                            const int num_residuals,
+                                            const int num_parameters) {
+  // Ceres allocates a residual block, a cost function, and the parameter block
+  // pointers for each observation. This is roughly 256 bytes in total.
+  static const int64_t kResidualBlockSizeInBytes = 256;
+  // Each residual depends on one camera (extrinsics and intrinsics) and one 3D
+  // point, which is at most 6 + 10 + 4 parameters for the camera models in
+  // Theia. The Jacobian is stored in the block sparse matrix and once more by
+  // the Schur eliminator.
+  static const int64_t kParametersPerResidual = 20;
+  static const int64_t kNumJacobianCopies = 2;
+
+  return num_residual_blocks * kResidualBlockSizeInBytes +
+         kNumJacobianCopies * num_residuals * kParametersPerResidual *
+             sizeof(double) +
+         // Parameters, gradients, and the trust region step and scaling.
+         4 * num_parameters * sizeof(double) +
+         // Residuals and the residuals at the candidate step.
+         2 * num_residuals * sizeof(double);
+}
+
+}  // namespace theia
@@ -0,0 +1,90 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#ifndef THEIA_SFM_MEMORY_ACCOUNTING_H_
+#define THEIA_SFM_MEMORY_ACCOUNTING_H_
+
+#include <stdint.h>
+#include <vector>
+
+namespace theia {
+
+class Reconstruction;
+class TrackBuilder;
+class ViewGraph;
+struct ImagePairMatch;
+struct KeypointsAndDescriptors;
+
+// Estimates of the number of heap bytes held by the main data structures of the
+// SfM pipeline. The estimates account for the sizes of the elements and the
+// per-node and per-bucket overhead of the standard containers, but not for
+// allocator overhead, so they slightly underestimate the true usage. They are
+// cheap enough to be computed at each stage of the pipeline for logging and for
+// enforcing memory budgets.
+int64_t EstimateMemoryUsage(const KeypointsAndDescriptors& features);
+int64_t EstimateMemoryUsage(const ImagePairMatch& match);
+int64_t EstimateMemoryUsage(const std::vector<ImagePairMatch>& matches);
+int64_t EstimateMemoryUsage(const ViewGraph& view_graph);
+int64_t EstimateMemoryUsage(const Reconstruction& reconstruction);
+int64_t EstimateMemoryUsage(const TrackBuilder& track_builder);
+
+// A coarse estimate of the memory that Ceres requires to solve a bundle
+// adjustment problem with the given number of residual blocks (i.e.,
+// observations) and parameters. This accounts for the residual blocks, cost
+// functions, and Jacobians but not for the fill-in of the Schur complement,
+// which depends on the co-visibility of the cameras.
+int64_t EstimateBundleAdjustmentMemoryUsage(const int num_residual_blocks,
+                                            const int num_residuals,
+                                            const int num_parameters);
+
+// The size of a hash map or set node with the given value type. Each node
+// stores the value, a pointer to the next node, and the cached hash.
+template <typename ValueType>
+constexpr int64_t HashNodeSizeInBytes() {
+  return sizeof(ValueType) + 2 * sizeof(void*);
+}
+
+// Estimates the heap memory held by an unordered map or set, excluding any
+// memory owned by the elements themselves.
+template <class HashContainer>
+int64_t EstimateHashContainerMemoryUsage(const HashContainer& container) {
+  return container.size() *
+             HashNodeSizeInBytes<typename HashContainer::value_type>() +
+         container.bucket_count() * sizeof(void*);
+}
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_MEMORY_ACCOUNTING_H_
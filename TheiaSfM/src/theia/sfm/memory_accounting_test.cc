@@ -0,0 +1,114 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/sfm/memory_accounting.h"
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/matching/feature_correspondence.h"
+#include "theia/matching/image_pair_match.h"
+#include "theia/matching/keypoints_and_descriptors.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track_builder.h"
+#include "theia/sfm/view_graph/view_graph.h"
+
+namespace theia {
+
+TEST(MemoryAccounting, KeypointsAndDescriptors) {
+  static const int kNumFeatures = 1000;
+  static const int kDescriptorDimension = 128;
+
+  KeypointsAndDescriptors features;
+  features.keypoints.resize(kNumFeatures);
+  features.descriptors.resize(kNumFeatures,
+                              Eigen::VectorXf::Zero(kDescriptorDimension));
+  // The descriptors dominate the memory usage.
+  EXPECT_GE(EstimateMemoryUsage(features),
+            kNumFeatures * kDescriptorDimension * sizeof(float));
+  EXPECT_LT(EstimateMemoryUsage(features),
+            2 * kNumFeatures * kDescriptorDimension * sizeof(float));
+}
+
+TEST(MemoryAccounting, Matches) {
+  static const int kNumCorrespondences = 100;
+
+  std::vector<ImagePairMatch> matches(2);
+  matches[0].correspondences.resize(kNumCorrespondences);
+  EXPECT_GE(EstimateMemoryUsage(matches[0]),
+            kNumCorrespondences * sizeof(FeatureCorrespondence));
+  EXPECT_EQ(EstimateMemoryUsage(matches),
+            2 * sizeof(ImagePairMatch) + EstimateMemoryUsage(matches[0]) +
+                EstimateMemoryUsage(matches[1]));
+}
+
+TEST(MemoryAccounting, GrowsWithTheSizeOfTheStructures) {
+  TrackBuilder track_builder(2, 10);
+  Reconstruction reconstruction;
+  ViewGraph view_graph;
+  EXPECT_EQ(EstimateMemoryUsage(track_builder), 0);
+
+  const ViewId view_id1 = reconstruction.AddView("1");
+  const ViewId view_id2 = reconstruction.AddView("2");
+  view_graph.AddEdge(view_id1, view_id2, TwoViewInfo());
+  const int64_t reconstruction_size = EstimateMemoryUsage(reconstruction);
+  const int64_t view_graph_size = EstimateMemoryUsage(view_graph);
+  EXPECT_GT(reconstruction_size, 0);
+  EXPECT_GT(view_graph_size, 0);
+
+  for (int i = 0; i < 10; i++) {
+    track_builder.AddFeatureCorrespondence(
+        view_id1, Feature(i, i), view_id2, Feature(i, i));
+  }
+  EXPECT_GT(EstimateMemoryUsage(track_builder), 0);
+  track_builder.BuildTracks(&reconstruction);
+  EXPECT_GT(EstimateMemoryUsage(reconstruction), reconstruction_size);
+
+  reconstruction.AddView("3");
+  view_graph.AddEdge(view_id1, 2, TwoViewInfo());
+  EXPECT_GT(EstimateMemoryUsage(view_graph), view_graph_size);
+}
+
+TEST(MemoryAccounting, BundleAdjustment) {
+  // The memory grows linearly with the number of observations.
+  const int64_t size = EstimateBundleAdjustmentMemoryUsage(1000, 2000, 3000);
+  EXPECT_GT(size, 0);
+  EXPECT_EQ(EstimateBundleAdjustmentMemoryUsage(2000, 4000, 6000), 2 * size);
+}
+
+}  // namespace theia
@@ -35,13 +35,349 @@
 #include "theia/sfm/pose/dls_impl.h"
 
 #include <Eigen/Core>
+#include <Eigen/LU>
 #include <glog/logging.h>
+#include <algorithm>
 
 namespace theia {
 using Eigen::Matrix;
 using Eigen::MatrixXd;
 using Eigen::Vector3d;
 
+namespace {
+
+// The number of non-zero entries of the 120x120 Macaulay matrix.
+static const int kNumMacaulayNonZeros = 1968;
+
+// The Macaulay matrix is built from the 20 coefficients of each of the three
+// jacobian polynomials followed by the 4 random terms.
+static const int kNumMacaulayCoefficients = 64;
+
+// The number of non-zero entries in the top-right 27x93 block of the Macaulay
+// matrix.
+static const int kNumTopRightNonZeros = 27;
+
+// The matrix is very large (14400 elements!) and sparse (1968 non-zero
+// elements) so we load it from pre-computed values calculated in matlab. The
+// column-major linear index of each non-zero entry is given along with the
+// index of its value in the coefficient array built by
+// GatherMacaulayCoefficients.
+static const int kMacaulayIndices[1968] = {
+  0, 35, 83, 118, 120, 121, 154, 155, 174, 203, 219, 238, 241, 242, 274, 275,
+  291, 294, 305, 323, 329, 339, 358, 360, 363, 395, 409, 436, 443, 478, 479,
+  481, 483, 484, 514, 515, 523, 529, 534, 551, 556, 563, 579, 580, 598, 599,
+  602, 604, 605, 634, 635, 641, 643, 649, 651, 654, 662, 665, 671, 676, 683,
+  689, 699, 700, 711, 718, 719, 723, 726, 750, 755, 769, 795, 796, 803, 827,
+  838, 839, 844, 846, 847, 870, 874, 875, 883, 885, 889, 894, 903, 911, 915,
+  916, 923, 939, 940, 947, 952, 958, 959, 965, 967, 968, 990, 994, 1001, 1003,
+  1005, 1006, 1009, 1011, 1014, 1022, 1023, 1025, 1026, 1031, 1035, 1036, 1049,
+  1059, 1060, 1062, 1067, 1071, 1072, 1079, 1080, 1089, 1115, 1116, 1163, 1164,
+  1168, 1198, 1201, 1209, 1210, 1233, 1234, 1235, 1236, 1254, 1259, 1283, 1284,
+  1288, 1299, 1317, 1318, 1322, 1330, 1331, 1348, 1353, 1354, 1355, 1356, 1371,
+  1374, 1377, 1379, 1385, 1403, 1404, 1408, 1409, 1419, 1434, 1437, 1438, 1443,
+  1449, 1452, 1475, 1476, 1479, 1489, 1516, 1519, 1523, 1524, 1528, 1536, 1558,
+  1559, 1564, 1570, 1572, 1573, 1593, 1594, 1595, 1596, 1599, 1603, 1607, 1609,
+  1614, 1619, 1620, 1631, 1636, 1639, 1643, 1644, 1648, 1650, 1656, 1659, 1660,
+  1677, 1678, 1679, 1685, 1691, 1693, 1694, 1708, 1713, 1714, 1716, 1719, 1721,
+  1722, 1723, 1727, 1729, 1731, 1734, 1736, 1737, 1739, 1740, 1742, 1745, 1751,
+  1756, 1759, 1764, 1768, 1769, 1770, 1776, 1779, 1780, 1786, 1791, 1794, 1797,
+  1799, 1806, 1812, 1815, 1829, 1830, 1835, 1836, 1839, 1849, 1874, 1875, 1876,
+  1879, 1883, 1884, 1888, 1894, 1896, 1907, 1918, 1919, 1927, 1933, 1935, 1936,
+  1949, 1950, 1953, 1954, 1956, 1959, 1963, 1964, 1965, 1967, 1969, 1974, 1979,
+  1980, 1983, 1988, 1991, 1994, 1995, 1996, 1999, 2004, 2008, 2010, 2014, 2016,
+  2017, 2019, 2020, 2027, 2032, 2037, 2039, 2048, 2054, 2056, 2057, 2068, 2069,
+  2070, 2073, 2079, 2081, 2082, 2083, 2084, 2085, 2086, 2087, 2091, 2096, 2097,
+  2099, 2100, 2102, 2103, 2105, 2106, 2108, 2111, 2114, 2115, 2119, 2129, 2130,
+  2134, 2136, 2137, 2140, 2142, 2146, 2147, 2151, 2152, 2154, 2157, 2169, 2178,
+  2195, 2196, 2213, 2242, 2243, 2244, 2247, 2248, 2278, 2290, 2298, 2299, 2312,
+  2313, 2314, 2315, 2316, 2333, 2334, 2339, 2341, 2362, 2363, 2364, 2367, 2368,
+  2379, 2396, 2397, 2398, 2411, 2419, 2420, 2427, 2428, 2432, 2433, 2434, 2436,
+  2451, 2453, 2454, 2455, 2457, 2459, 2461, 2465, 2482, 2484, 2487, 2488, 2489,
+  2499, 2513, 2514, 2516, 2517, 2532, 2538, 2541, 2555, 2556, 2558, 2559, 2569,
+  2573, 2596, 2598, 2599, 2602, 2603, 2604, 2607, 2608, 2612, 2616, 2638, 2639,
+  2653, 2659, 2661, 2662, 2672, 2673, 2674, 2676, 2678, 2679, 2680, 2683, 2687,
+  2689, 2693, 2694, 2699, 2700, 2701, 2711, 2712, 2716, 2718, 2719, 2722, 2724,
+  2727, 2728, 2730, 2732, 2735, 2736, 2739, 2740, 2756, 2757, 2759, 2774, 2780,
+  2782, 2783, 2787, 2788, 2792, 2793, 2798, 2799, 2800, 2801, 2802, 2803, 2807,
+  2811, 2813, 2815, 2816, 2817, 2819, 2820, 2821, 2822, 2825, 2831, 2832, 2838,
+  2839, 2842, 2847, 2849, 2850, 2852, 2855, 2856, 2860, 2866, 2871, 2873, 2874,
+  2876, 2877, 2895, 2901, 2904, 2909, 2910, 2916, 2918, 2919, 2929, 2932, 2933,
+  2953, 2954, 2955, 2956, 2958, 2959, 2962, 2964, 2967, 2968, 2972, 2973, 2974,
+  2976, 2987, 2999, 3016, 3022, 3024, 3025, 3029, 3030, 3032, 3033, 3038, 3039,
+  3040, 3043, 3044, 3045, 3047, 3052, 3053, 3059, 3060, 3061, 3063, 3068, 3071,
+  3072, 3073, 3074, 3075, 3078, 3079, 3082, 3087, 3090, 3092, 3093, 3094, 3095,
+  3096, 3097, 3100, 3107, 3112, 3116, 3117, 3137, 3143, 3145, 3146, 3147, 3148,
+  3149, 3152, 3158, 3160, 3161, 3162, 3164, 3165, 3166, 3167, 3172, 3175, 3176,
+  3177, 3180, 3181, 3182, 3183, 3186, 3188, 3192, 3193, 3194, 3198, 3210, 3212,
+  3213, 3214, 3215, 3217, 3222, 3226, 3231, 3232, 3233, 3234, 3236, 3255, 3269,
+  3270, 3276, 3279, 3289, 3309, 3310, 3314, 3315, 3316, 3319, 3324, 3328, 3331,
+  3334, 3336, 3347, 3350, 3359, 3366, 3390, 3395, 3409, 3429, 3435, 3436, 3443,
+  3467, 3470, 3478, 3479, 3504, 3509, 3510, 3518, 3519, 3532, 3533, 3549, 3550,
+  3553, 3554, 3555, 3558, 3559, 3562, 3567, 3571, 3572, 3573, 3574, 3576, 3587,
+  3590, 3637, 3648, 3652, 3670, 3673, 3677, 3681, 3685, 3691, 3693, 3698, 3749,
+  3757, 3758, 3770, 3772, 3789, 3790, 3793, 3794, 3797, 3798, 3800, 3806, 3811,
+  3812, 3813, 3814, 3818, 3830, 3888, 3890, 3893, 3920, 3921, 3922, 3925, 3926,
+  3927, 3989, 3990, 3999, 4024, 4029, 4030, 4034, 4035, 4039, 4051, 4054, 4056,
+  4063, 4067, 4070, 4109, 4118, 4132, 4144, 4149, 4150, 4153, 4154, 4158, 4171,
+  4172, 4173, 4174, 4183, 4190, 4237, 4252, 4264, 4270, 4273, 4277, 4291, 4293,
+  4298, 4303, 4325, 4354, 4361, 4363, 4369, 4371, 4374, 4382, 4385, 4391, 4396,
+  4409, 4419, 4420, 4421, 4429, 4431, 4439, 4442, 4474, 4475, 4491, 4494, 4505,
+  4523, 4529, 4539, 4549, 4558, 4590, 4609, 4624, 4629, 4635, 4636, 4663, 4667,
+  4670, 4679, 4708, 4713, 4731, 4737, 4739, 4745, 4769, 4785, 4788, 4789, 4794,
+  4797, 4827, 4828, 4832, 4855, 4857, 4861, 4905, 4908, 4909, 4913, 4914, 4916,
+  4950, 4984, 4989, 4995, 5023, 5027, 5030, 5067, 5071, 5095, 5098, 5145, 5148,
+  5153, 5155, 5189, 5224, 5229, 5230, 5234, 5251, 5254, 5263, 5270, 5308, 5337,
+  5385, 5388, 5389, 5394, 5427, 5455, 5505, 5508, 5513, 5572, 5584, 5590, 5593,
+  5611, 5613, 5623, 5680, 5684, 5692, 5704, 5707, 5708, 5710, 5712, 5713, 5731,
+  5733, 5735, 5737, 5743, 5744, 5790, 5803, 5805, 5823, 5824, 5827, 5829, 5831,
+  5835, 5860, 5863, 5864, 5867, 5870, 5872, 5921, 5925, 5926, 5942, 5943, 5946,
+  5981, 5982, 5985, 5989, 5991, 5992, 6041, 6062, 6101, 6105, 6109, 6111, 6184,
+  6190, 6211, 6223, 6281, 6285, 6286, 6302, 6303, 6306, 6307, 6309, 6341, 6342,
+  6344, 6349, 6350, 6351, 6352, 6424, 6429, 6463, 6470, 6585, 6589, 6644, 6664,
+  6667, 6668, 6670, 6691, 6697, 6703, 6704, 6825, 6828, 6904, 6907, 6943, 6944,
+  7006, 7024, 7026, 7027, 7062, 7063, 7064, 7088, 7110, 7121, 7123, 7125, 7126,
+  7131, 7142, 7143, 7145, 7146, 7151, 7155, 7169, 7180, 7181, 7182, 7187, 7189,
+  7191, 7192, 7208, 7230, 7241, 7243, 7245, 7246, 7251, 7262, 7263, 7265, 7266,
+  7267, 7269, 7271, 7275, 7289, 7300, 7302, 7304, 7307, 7310, 7311, 7312, 7362,
+  7376, 7421, 7425, 7426, 7428, 7504, 7543, 7665, 7726, 7746, 7747, 7781, 7782,
+  7784, 7785, 7846, 7864, 7866, 7867, 7901, 7902, 7903, 7904, 7966, 7986, 8021,
+  8022, 8025, 8141, 8145, 8201, 8203, 8211, 8222, 8225, 8231, 8249, 8260, 8261,
+  8265, 8269, 8271, 8317, 8328, 8332, 8353, 8357, 8361, 8365, 8373, 8378, 8420,
+  8427, 8428, 8431, 8432, 8433, 8450, 8451, 8453, 8455, 8457, 8458, 8459, 8461,
+  8465, 8480, 8482, 8486, 8487, 8489, 8513, 8514, 8515, 8516, 8517, 8565, 8583,
+  8584, 8587, 8589, 8623, 8624, 8630, 8632, 8681, 8685, 8686, 8702, 8703, 8704,
+  8706, 8707, 8709, 8742, 8743, 8744, 8750, 8751, 8752, 8808, 8810, 8840, 8841,
+  8845, 8846, 8905, 8909, 8912, 8918, 8920, 8924, 8925, 8927, 8932, 8940, 8941,
+  8943, 8947, 8948, 8949, 8950, 8952, 8953, 8954, 8958, 8970, 8971, 8972, 8973,
+  8974, 8975, 8977, 8984, 8990, 8992, 8996, 9021, 9036, 9037, 9038, 9039, 9049,
+  9050, 9053, 9076, 9077, 9078, 9079, 9080, 9082, 9084, 9086, 9087, 9088, 9092,
+  9096, 9098, 9119, 9168, 9201, 9205, 9274, 9291, 9294, 9305, 9329, 9339, 9345,
+  9349, 9387, 9391, 9397, 9400, 9402, 9415, 9416, 9418, 9432, 9437, 9455, 9458,
+  9461, 9466, 9468, 9473, 9475, 9522, 9524, 9526, 9536, 9546, 9548, 9577, 9581,
+  9582, 9585, 9586, 9588, 9614, 9628, 9633, 9639, 9641, 9642, 9643, 9647, 9651,
+  9656, 9657, 9659, 9660, 9662, 9665, 9671, 9679, 9689, 9690, 9696, 9700, 9701,
+  9706, 9708, 9709, 9711, 9714, 9717, 9751, 9752, 9757, 9758, 9760, 9767, 9768,
+  9770, 9778, 9780, 9781, 9792, 9797, 9798, 9800, 9801, 9805, 9806, 9810, 9812,
+  9815, 9818, 9835, 9836, 9869, 9884, 9885, 9887, 9900, 9903, 9904, 9907, 9908,
+  9909, 9910, 9914, 9930, 9931, 9934, 9937, 9943, 9944, 9950, 9952, 9986, 9987,
+  9991, 9997, 10000, 10002, 10004, 10006, 10012, 10015, 10016, 10018, 10026,
+  10028, 10032, 10033, 10037, 10053, 10055, 10057, 10058, 10062, 10066, 10073,
+  10075, 10096, 10109, 10110, 10113, 10119, 10123, 10124, 10125, 10127, 10139,
+  10140, 10143, 10147, 10148, 10149, 10150, 10151, 10154, 10155, 10159, 10170,
+  10171, 10174, 10176, 10177, 10180, 10184, 10187, 10190, 10192, 10197, 10225,
+  10229, 10231, 10232, 10237, 10238, 10240, 10244, 10245, 10247, 10250, 10252,
+  10258, 10260, 10261, 10263, 10268, 10272, 10273, 10274, 10277, 10278, 10280,
+  10286, 10290, 10292, 10293, 10294, 10295, 10297, 10298, 10312, 10315, 10316,
+  10351, 10357, 10360, 10364, 10368, 10372, 10378, 10388, 10392, 10393, 10397,
+  10401, 10405, 10413, 10415, 10417, 10418, 10435, 10462, 10471, 10472, 10473,
+  10477, 10478, 10479, 10480, 10483, 10487, 10490, 10493, 10498, 10499, 10500,
+  10501, 10511, 10512, 10517, 10518, 10519, 10520, 10522, 10526, 10527, 10530,
+  10532, 10535, 10536, 10538, 10540, 10555, 10556, 10557, 10587, 10591, 10597,
+  10600, 10602, 10608, 10615, 10616, 10618, 10632, 10637, 10641, 10645, 10655,
+  10658, 10666, 10673, 10675, 10711, 10717, 10720, 10724, 10732, 10738, 10747,
+  10748, 10750, 10752, 10753, 10757, 10771, 10773, 10775, 10777, 10778, 10784,
+  10795, 10827, 10840, 10842, 10855, 10856, 10872, 10895, 10901, 10905, 10906,
+  10908, 10913, 10943, 10947, 10948, 10951, 10952, 10957, 10958, 10960, 10961,
+  10962, 10967, 10970, 10975, 10976, 10977, 10978, 10980, 10981, 10982, 10992,
+  10997, 10998, 11000, 11006, 11010, 11012, 11015, 11018, 11026, 11031, 11033,
+  11034, 11035, 11036, 11057, 11068, 11069, 11081, 11082, 11084, 11085, 11086,
+  11087, 11096, 11097, 11100, 11102, 11103, 11106, 11108, 11114, 11130, 11134,
+  11137, 11141, 11142, 11146, 11148, 11149, 11151, 11152, 11154, 11177, 11188,
+  11189, 11201, 11202, 11204, 11205, 11206, 11207, 11216, 11217, 11220, 11222,
+  11223, 11226, 11227, 11228, 11229, 11230, 11234, 11250, 11251, 11254, 11257,
+  11262, 11264, 11266, 11270, 11271, 11272, 11274, 11311, 11317, 11320, 11328,
+  11338, 11352, 11357, 11361, 11365, 11375, 11378, 11395, 11426, 11427, 11440,
+  11442, 11444, 11446, 11452, 11455, 11456, 11466, 11468, 11472, 11473, 11493,
+  11495, 11497, 11501, 11502, 11506, 11508, 11513, 11543, 11547, 11548, 11552,
+  11558, 11560, 11561, 11562, 11567, 11575, 11576, 11577, 11580, 11581, 11582,
+  11592, 11598, 11610, 11612, 11615, 11621, 11626, 11628, 11629, 11631, 11633,
+  11634, 11636, 11682, 11684, 11686, 11696, 11706, 11707, 11708, 11710, 11731,
+  11737, 11741, 11742, 11744, 11746, 11748, 11788, 11801, 11802, 11807, 11816,
+  11817, 11820, 11822, 11850, 11861, 11865, 11866, 11868, 11869, 11871, 11874,
+  11922, 11924, 11926, 11936, 11944, 11946, 11947, 11948, 11950, 11971, 11977,
+  11982, 11983, 11984, 11986, 12051, 12065, 12089, 12105, 12109, 12157, 12158,
+  12159, 12168, 12170, 12173, 12197, 12198, 12199, 12200, 12201, 12202, 12205,
+  12206, 12207, 12212, 12216, 12218, 12277, 12278, 12288, 12290, 12317, 12318,
+  12320, 12321, 12325, 12326, 12332, 12338, 12397, 12408, 12437, 12441, 12445,
+  12458, 12491, 12508, 12513, 12514, 12516, 12531, 12534, 12537, 12539, 12545,
+  12564, 12568, 12569, 12579, 12588, 12589, 12594, 12597, 12620, 12627, 12628,
+  12632, 12633, 12651, 12653, 12655, 12657, 12659, 12661, 12665, 12682, 12687,
+  12689, 12708, 12709, 12713, 12714, 12716, 12717, 12747, 12748, 12751, 12752,
+  12770, 12775, 12777, 12778, 12781, 12800, 12806, 12828, 12829, 12833, 12834,
+  12835, 12836, 12867, 12871, 12888, 12895, 12898, 12921, 12925, 12948, 12953,
+  12955, 12996, 13008, 13010, 13013, 13040, 13041, 13042, 13044, 13045, 13046,
+  13047, 13048, 13106, 13107, 13120, 13122, 13124, 13126, 13132, 13135, 13136,
+  13146, 13147, 13148, 13150, 13152, 13153, 13171, 13173, 13175, 13177, 13182,
+  13184, 13186, 13193, 13207, 13230, 13234, 13243, 13245, 13249, 13254, 13263,
+  13267, 13269, 13271, 13275, 13276, 13299, 13300, 13304, 13307, 13310, 13312,
+  13319, 13338, 13355, 13356, 13370, 13373, 13400, 13402, 13403, 13404, 13406,
+  13407, 13408, 13438, 13459, 13471, 13472, 13473, 13474, 13476, 13490, 13493,
+  13494, 13498, 13499, 13501, 13520, 13522, 13524, 13526, 13527, 13528, 13539,
+  13555, 13556, 13557, 13591, 13592, 13593, 13608, 13610, 13613, 13618, 13619,
+  13621, 13640, 13641, 13642, 13645, 13646, 13647, 13675, 13676, 13677, 13711,
+  13712, 13728, 13730, 13738, 13741, 13760, 13761, 13765, 13766, 13795, 13796,
+  13831, 13848, 13858, 13881, 13885, 13915, 13944, 13949, 13950, 13957, 13958,
+  13959, 13970, 13972, 13973, 13993, 13994, 13995, 13997, 13998, 13999, 14000,
+  14002, 14006, 14007, 14012, 14013, 14014, 14016, 14018, 14027, 14069, 14077,
+  14078, 14088, 14090, 14092, 14113, 14114, 14117, 14118, 14120, 14121, 14125,
+  14126, 14132, 14133, 14134, 14138, 14187, 14188, 14191, 14192, 14208, 14210,
+  14215, 14217, 14218, 14221, 14240, 14241, 14245, 14246, 14273, 14274, 14275,
+  14276, 14307, 14311, 14328, 14335, 14338, 14361, 14365, 14393, 14395
+};
+
+static const int kMacaulayCoefficientIds[1968] = {
+  60, 0, 20, 40, 63, 60, 0, 9, 20, 29, 40, 49, 63, 60, 9, 13, 0, 29, 20, 33,
+  40, 49, 53, 62, 60, 10, 0, 20, 30, 50, 40, 62, 63, 60, 10, 4, 0, 9, 30, 20,
+  29, 24, 50, 40, 44, 49, 62, 63, 60, 4, 11, 0, 9, 13, 10, 24, 20, 30, 29, 33,
+  31, 50, 44, 49, 40, 51, 53, 62, 60, 0, 14, 10, 20, 30, 34, 40, 54, 50, 62,
+  63, 60, 9, 14, 5, 10, 0, 4, 34, 20, 30, 29, 24, 25, 54, 50, 49, 40, 45, 44,
+  62, 63, 60, 13, 5, 10, 4, 9, 0, 11, 14, 25, 30, 29, 34, 20, 24, 33, 31, 54,
+  45, 44, 40, 53, 50, 49, 51, 61, 60, 8, 0, 28, 20, 40, 48, 61, 63, 60, 0, 8,
+  3, 9, 28, 20, 23, 29, 49, 48, 40, 43, 61, 63, 60, 0, 9, 3, 7, 13, 8, 23, 20,
+  29, 28, 27, 33, 53, 48, 43, 40, 49, 47, 61, 62, 60, 2, 10, 0, 8, 28, 20, 22,
+  30, 50, 40, 42, 48, 61, 62, 63, 60, 10, 2, 16, 4, 9, 8, 0, 3, 22, 30, 20, 28,
+  23, 29, 36, 24, 44, 40, 49, 42, 48, 50, 56, 43, 61, 62, 63, 60, 10, 4, 16,
+  11, 13, 8, 0, 3, 9, 7, 2, 36, 20, 30, 24, 29, 28, 22, 23, 27, 33, 31, 51, 42,
+  49, 53, 56, 43, 40, 48, 50, 44, 47, 61, 62, 60, 0, 8, 17, 14, 10, 2, 20, 28,
+  22, 30, 37, 34, 54, 40, 50, 48, 57, 42, 61, 62, 63, 60, 9, 3, 14, 17, 5, 4,
+  2, 0, 8, 10, 16, 37, 34, 30, 28, 20, 22, 29, 23, 36, 24, 25, 45, 50, 49, 44,
+  40, 57, 42, 43, 48, 54, 56, 61, 62, 63, 60, 14, 13, 7, 5, 11, 2, 10, 16, 9,
+  3, 8, 4, 17, 30, 34, 25, 24, 22, 23, 37, 28, 29, 36, 33, 27, 31, 57, 44, 53,
+  51, 49, 56, 48, 50, 47, 42, 43, 54, 45, 61, 60, 12, 8, 0, 20, 32, 28, 40, 48,
+  52, 61, 63, 60, 0, 8, 12, 18, 3, 9, 32, 28, 20, 29, 38, 23, 49, 43, 52, 40,
+  48, 58, 61, 63, 60, 0, 8, 9, 3, 18, 7, 12, 13, 38, 20, 28, 23, 29, 32, 33,
+  27, 53, 47, 52, 58, 40, 48, 49, 43, 61, 62, 60, 1, 2, 0, 8, 12, 10, 32, 20,
+  28, 30, 21, 22, 50, 42, 40, 48, 41, 52, 61, 62, 63, 60, 10, 2, 1, 16, 9, 3,
+  0, 12, 8, 18, 4, 21, 22, 28, 30, 32, 20, 38, 29, 23, 24, 36, 44, 56, 48, 49,
+  40, 43, 41, 52, 50, 42, 58, 61, 62, 63, 60, 10, 2, 4, 16, 13, 7, 9, 12, 8,
+  18, 3, 1, 11, 30, 28, 22, 36, 23, 24, 32, 21, 38, 29, 33, 27, 31, 51, 41, 43,
+  53, 49, 47, 58, 48, 52, 50, 42, 44, 56, 61, 62, 60, 8, 12, 17, 10, 2, 1, 0,
+  14, 20, 28, 32, 21, 30, 22, 34, 37, 54, 57, 50, 40, 48, 42, 52, 41, 61, 62,
+  63, 60, 3, 18, 14, 17, 4, 16, 10, 1, 8, 12, 2, 9, 5, 37, 22, 34, 32, 28, 21,
+  30, 29, 23, 38, 24, 36, 25, 45, 42, 44, 49, 43, 50, 56, 48, 41, 58, 52, 54,
+  57, 61, 62, 63, 60, 14, 17, 7, 5, 11, 4, 1, 2, 3, 18, 12, 16, 13, 34, 22, 37,
+  36, 25, 21, 38, 32, 23, 24, 33, 27, 31, 56, 51, 53, 47, 44, 43, 52, 42, 41,
+  58, 54, 57, 45, 62, 10, 2, 6, 14, 17, 28, 20, 30, 22, 37, 34, 26, 46, 40, 50,
+  54, 42, 48, 57, 62, 10, 6, 14, 20, 30, 34, 26, 50, 40, 46, 54, 62, 2, 1, 14,
+  17, 10, 6, 32, 28, 30, 22, 21, 34, 37, 26, 46, 48, 54, 50, 42, 57, 41, 52,
+  17, 6, 1, 39, 21, 37, 26, 46, 59, 41, 57, 1, 14, 17, 6, 2, 39, 32, 22, 21,
+  34, 37, 26, 46, 52, 57, 42, 41, 54, 59, 8, 12, 19, 32, 28, 39, 48, 52, 59,
+  14, 17, 6, 28, 22, 30, 34, 37, 26, 50, 54, 46, 48, 57, 42, 17, 6, 14, 32, 21,
+  22, 34, 37, 26, 42, 46, 54, 57, 52, 41, 6, 17, 39, 21, 37, 26, 41, 57, 46,
+  59, 63, 11, 9, 13, 15, 4, 31, 29, 24, 33, 35, 44, 51, 53, 40, 50, 49, 55, 63,
+  13, 15, 9, 33, 29, 35, 49, 53, 40, 55, 14, 6, 20, 30, 34, 26, 40, 54, 50, 46,
+  13, 15, 7, 33, 35, 27, 47, 48, 49, 43, 53, 55, 13, 7, 15, 33, 27, 35, 52, 43,
+  58, 53, 47, 55, 6, 30, 34, 26, 50, 46, 54, 7, 15, 27, 35, 59, 58, 47, 55, 6,
+  22, 37, 34, 26, 54, 46, 42, 57, 15, 35, 43, 53, 47, 55, 15, 35, 58, 47, 55,
+  6, 21, 37, 26, 57, 46, 41, 6, 17, 5, 38, 21, 37, 36, 26, 25, 56, 45, 46, 57,
+  58, 41, 5, 6, 14, 34, 29, 30, 24, 26, 25, 46, 49, 50, 45, 44, 54, 11, 15, 13,
+  31, 35, 33, 44, 53, 54, 45, 51, 55, 15, 35, 53, 44, 51, 55, 37, 26, 46, 57,
+  5, 11, 4, 25, 31, 24, 33, 35, 54, 44, 53, 46, 55, 45, 51, 34, 26, 54, 46, 53,
+  55, 6, 36, 37, 26, 25, 45, 46, 56, 57, 47, 55, 25, 26, 45, 46, 6, 31, 26, 25,
+  46, 51, 45, 63, 15, 4, 11, 13, 9, 5, 24, 33, 25, 29, 31, 35, 45, 51, 50, 49,
+  55, 54, 44, 53, 62, 11, 14, 5, 4, 10, 6, 34, 24, 26, 30, 29, 33, 25, 31, 46,
+  45, 50, 49, 51, 53, 54, 44, 15, 35, 47, 56, 55, 51, 26, 46, 55, 11, 31, 35,
+  45, 51, 55, 46, 5, 35, 25, 31, 46, 45, 55, 51, 15, 35, 51, 55, 45, 55, 51,
+  13, 15, 11, 33, 31, 35, 51, 55, 49, 50, 44, 53, 1, 17, 19, 39, 21, 37, 57,
+  59, 41, 61, 8, 12, 9, 3, 18, 13, 19, 7, 28, 32, 29, 38, 23, 39, 33, 27, 53,
+  47, 59, 48, 52, 49, 43, 58, 6, 26, 24, 34, 25, 44, 54, 45, 46, 6, 5, 14, 26,
+  25, 33, 34, 24, 31, 54, 53, 44, 51, 46, 45, 12, 19, 39, 32, 52, 59, 62, 16,
+  6, 5, 14, 2, 1, 17, 4, 37, 26, 21, 32, 22, 38, 23, 34, 24, 36, 25, 57, 43,
+  45, 44, 56, 54, 42, 52, 58, 41, 46, 61, 1, 0, 8, 12, 19, 10, 2, 39, 20, 28,
+  32, 30, 22, 21, 50, 42, 41, 48, 52, 40, 59, 19, 39, 59, 15, 13, 35, 33, 53,
+  55, 40, 49, 16, 11, 15, 7, 18, 36, 38, 31, 27, 35, 47, 55, 59, 58, 41, 56,
+  51, 11, 15, 7, 31, 27, 35, 55, 56, 47, 57, 51, 45, 63, 4, 11, 15, 3, 9, 7,
+  13, 16, 29, 24, 31, 33, 23, 36, 27, 35, 56, 53, 55, 47, 48, 49, 50, 42, 43,
+  44, 51, 2, 1, 3, 18, 12, 19, 4, 16, 22, 39, 21, 32, 23, 38, 36, 24, 44, 56,
+  59, 58, 52, 43, 42, 41, 5, 14, 17, 6, 26, 37, 23, 22, 34, 36, 24, 25, 46, 44,
+  45, 54, 43, 42, 56, 57, 61, 17, 5, 11, 16, 1, 18, 19, 7, 37, 21, 25, 39, 38,
+  36, 27, 31, 47, 56, 58, 51, 59, 41, 57, 45, 62, 4, 16, 6, 5, 17, 10, 2, 14,
+  26, 34, 22, 28, 30, 23, 29, 37, 24, 36, 25, 54, 49, 44, 45, 50, 57, 48, 56,
+  43, 42, 46, 61, 18, 14, 17, 4, 16, 2, 12, 19, 1, 5, 3, 34, 21, 37, 39, 32,
+  22, 23, 38, 24, 36, 25, 45, 41, 56, 43, 58, 42, 52, 44, 59, 54, 57, 17, 16,
+  1, 19, 5, 18, 37, 39, 21, 38, 36, 25, 45, 58, 41, 59, 56, 57, 61, 10, 2, 1,
+  9, 3, 18, 8, 19, 12, 4, 16, 30, 21, 32, 22, 39, 28, 29, 23, 38, 24, 36, 44,
+  56, 52, 43, 48, 58, 49, 59, 50, 42, 41, 1, 16, 7, 18, 19, 11, 21, 39, 36, 38,
+  27, 31, 51, 58, 47, 59, 41, 56, 6, 5, 17, 1, 16, 26, 39, 21, 38, 37, 36, 25,
+  58, 56, 57, 41, 45, 59, 46, 11, 15, 7, 31, 27, 35, 55, 58, 41, 47, 56, 51,
+  61, 2, 1, 4, 16, 13, 7, 3, 19, 12, 18, 11, 22, 32, 21, 24, 38, 36, 39, 23,
+  33, 27, 31, 51, 58, 47, 43, 53, 52, 59, 42, 41, 44, 56, 63, 5, 15, 16, 4, 13,
+  7, 3, 11, 24, 25, 31, 36, 27, 23, 33, 35, 51, 55, 53, 42, 43, 44, 54, 57, 56,
+  47, 45, 62, 6, 11, 17, 14, 4, 16, 2, 5, 34, 26, 25, 37, 36, 22, 23, 24, 27,
+  33, 31, 45, 53, 51, 44, 42, 43, 54, 47, 57, 56, 46, 1, 18, 19, 16, 21, 39,
+  38, 36, 56, 59, 58, 41, 63, 5, 11, 16, 7, 18, 15, 25, 36, 38, 27, 31, 35, 55,
+  51, 47, 41, 58, 56, 57, 45, 63, 4, 16, 11, 15, 13, 18, 3, 7, 24, 23, 36, 27,
+  31, 38, 33, 35, 47, 55, 53, 52, 43, 42, 41, 58, 44, 56, 51, 5, 11, 16, 25,
+  36, 27, 31, 35, 55, 51, 57, 56, 47, 45, 46, 11, 7, 13, 15, 33, 31, 35, 27,
+  55, 43, 42, 53, 44, 56, 47, 51, 6, 5, 17, 26, 27, 37, 36, 25, 31, 51, 45, 57,
+  47, 56, 46, 15, 35, 55, 49, 53, 8, 12, 19, 10, 2, 1, 28, 32, 39, 22, 30, 21,
+  50, 42, 41, 52, 59, 48, 12, 19, 2, 1, 32, 39, 21, 22, 42, 41, 59, 52, 19, 1,
+  39, 21, 41, 59, 63, 9, 13, 7, 15, 3, 27, 29, 33, 23, 35, 55, 43, 47, 40, 48,
+  49, 53, 63, 9, 3, 13, 7, 18, 15, 29, 23, 27, 33, 38, 35, 55, 58, 48, 52, 49,
+  43, 53, 47, 3, 18, 13, 7, 15, 23, 38, 33, 27, 35, 55, 52, 59, 43, 58, 53, 47,
+  18, 7, 15, 38, 27, 35, 55, 59, 58, 47, 19, 0, 8, 12, 28, 20, 32, 39, 40, 48,
+  52, 59, 62, 6, 5, 17, 16, 1, 11, 26, 37, 21, 38, 36, 27, 25, 31, 47, 51, 45,
+  56, 41, 58, 57, 46, 62, 4, 6, 14, 10, 5, 26, 30, 20, 29, 34, 24, 25, 46, 54,
+  40, 44, 49, 50, 45, 61, 19, 12, 0, 8, 20, 28, 39, 32, 40, 48, 52, 59, 61, 0,
+  8, 12, 19, 18, 9, 3, 39, 20, 32, 28, 29, 23, 38, 49, 43, 58, 59, 40, 48, 52,
+  8, 12, 19, 9, 3, 18, 28, 39, 32, 23, 29, 38, 49, 43, 58, 48, 52, 59, 12, 19,
+  3, 18, 32, 39, 38, 23, 43, 58, 52, 59, 19, 18, 39, 38, 58, 59, 61, 12, 19,
+  10, 2, 1, 14, 8, 17, 28, 32, 39, 30, 22, 21, 34, 37, 54, 57, 42, 48, 52, 41,
+  50, 59, 19, 2, 1, 14, 17, 12, 32, 39, 22, 21, 37, 34, 54, 57, 41, 52, 59, 42,
+  12, 19, 3, 18, 13, 7, 32, 39, 23, 38, 27, 33, 53, 47, 52, 59, 43, 58, 19, 18,
+  7, 39, 38, 27, 47, 59, 58
+};
+
+// The bottom-right 93x93 block of the Macaulay matrix becomes block lower
+// triangular with diagonal blocks of size 3, 9, 18, 26, 33, 1, 1, 1, 1 when its
+// rows and columns are permuted. These tables map each row and column of the
+// block (offset by 27) to its position in the permuted matrix.
+static const int kEliminationRowPosition[93] = {
+  80, 35, 52, 19, 66, 50, 23, 7, 0, 4, 85, 39, 16, 72, 30, 78, 18, 62, 34, 57,
+  41, 67, 10, 42, 27, 86, 14, 5, 82, 77, 36, 83, 24, 40, 44, 46, 47, 56, 12,
+  58, 60, 76, 31, 88, 17, 65, 87, 55, 20, 9, 70, 51, 21, 37, 68, 15, 1, 3, 69,
+  43, 13, 8, 26, 54, 64, 38, 74, 32, 71, 22, 63, 73, 6, 28, 91, 59, 75, 61, 92,
+  79, 29, 90, 89, 33, 53, 48, 81, 45, 84, 49, 25, 2, 11
+};
+
+static const int kEliminationColumnPosition[93] = {
+  11, 2, 29, 88, 55, 14, 20, 51, 87, 10, 1, 9, 25, 49, 19, 83, 32, 35, 80, 74,
+  75, 18, 34, 30, 64, 33, 31, 89, 63, 90, 61, 60, 28, 27, 78, 56, 92, 59, 58,
+  57, 91, 26, 85, 24, 47, 46, 42, 48, 8, 68, 6, 84, 62, 22, 43, 40, 82, 17, 41,
+  73, 16, 72, 70, 65, 53, 54, 52, 71, 86, 50, 77, 45, 76, 12, 15, 39, 69, 7,
+  23, 44, 81, 3, 79, 5, 0, 4, 13, 37, 67, 21, 38, 36, 66
+};
+
+void GatherMacaulayCoefficients(const double a[20],
+                                const double b[20],
+                                const double c[20],
+                                const double u[4],
+                                double coefficients[kNumMacaulayCoefficients]) {
+  std::copy(a, a + 20, coefficients);
+  std::copy(b, b + 20, coefficients + 20);
+  std::copy(c, c + 20, coefficients + 40);
+  std::copy(u, u + 4, coefficients + 60);
+}
+
+// Solves for the rows [kOffset, kOffset + kSize) of x in the block lower
+// triangular system lhs * x = rhs, where the rows before kOffset have already
+// been solved for and x initially holds rhs.
+template <int kOffset, int kSize>
+void SolveDiagonalBlock(const Matrix<double, 93, 93>& lhs,
+                        Matrix<double, 93, 27>* x) {
+  Matrix<double, kSize, 27> block_rhs = x->template middleRows<kSize>(kOffset);
+  if (kOffset > 0) {
+    block_rhs.noalias() -=
+        lhs.template block<kSize, kOffset>(kOffset, 0) *
+        x->template topRows<kOffset>();
+  }
+  const Eigen::PartialPivLU<Matrix<double, kSize, kSize> > lu(
+      lhs.template block<kSize, kSize>(kOffset, kOffset));
+  x->template middleRows<kSize>(kOffset) = lu.solve(block_rhs);
+}
+
+}  // namespace
+
 // Put these methods in a nested namespace so that they are not part of the
 // common public theia namespace.
 namespace dls_impl {
@@ -343,363 +679,77 @@ MatrixXd CreateMacaulayMatrix(const double a[20],
   MatrixXd macaulay_matrix(120, 120);
   macaulay_matrix.setZero();
 
-  // The matrix is very large (14400 elements!) and sparse (1968 non-zero
-  // elements) so we load it from pre-computed values calculated in matlab.
-
-  const int indices[1968] = {
-    0, 35, 83, 118, 120, 121, 154, 155, 174, 203, 219, 238, 241, 242, 274, 275,
-    291, 294, 305, 323, 329, 339, 358, 360, 363, 395, 409, 436, 443, 478, 479,
-    481, 483, 484, 514, 515, 523, 529, 534, 551, 556, 563, 579, 580, 598, 599,
-    602, 604, 605, 634, 635, 641, 643, 649, 651, 654, 662, 665, 671, 676, 683,
-    689, 699, 700, 711, 718, 719, 723, 726, 750, 755, 769, 795, 796, 803, 827,
-    838, 839, 844, 846, 847, 870, 874, 875, 883, 885, 889, 894, 903, 911, 915,
-    916, 923, 939, 940, 947, 952, 958, 959, 965, 967, 968, 990, 994, 1001, 1003,
-    1005, 1006, 1009, 1011, 1014, 1022, 1023, 1025, 1026, 1031, 1035, 1036,
-    1049, 1059, 1060, 1062, 1067, 1071, 1072, 1079, 1080, 1089, 1115, 1116,
-    1163, 1164, 1168, 1198, 1201, 1209, 1210, 1233, 1234, 1235, 1236, 1254,
-    1259, 1283, 1284, 1288, 1299, 1317, 1318, 1322, 1330, 1331, 1348, 1353,
-    1354, 1355, 1356, 1371, 1374, 1377, 1379, 1385, 1403, 1404, 1408, 1409,
-    1419, 1434, 1437, 1438, 1443, 1449, 1452, 1475, 1476, 1479, 1489, 1516,
-    1519, 1523, 1524, 1528, 1536, 1558, 1559, 1564, 1570, 1572, 1573, 1593,
-    1594, 1595, 1596, 1599, 1603, 1607, 1609, 1614, 1619, 1620, 1631, 1636,
-    1639, 1643, 1644, 1648, 1650, 1656, 1659, 1660, 1677, 1678, 1679, 1685,
-    1691, 1693, 1694, 1708, 1713, 1714, 1716, 1719, 1721, 1722, 1723, 1727,
-    1729, 1731, 1734, 1736, 1737, 1739, 1740, 1742, 1745, 1751, 1756, 1759,
-    1764, 1768, 1769, 1770, 1776, 1779, 1780, 1786, 1791, 1794, 1797, 1799,
-    1806, 1812, 1815, 1829, 1830, 1835, 1836, 1839, 1849, 1874, 1875, 1876,
-    1879, 1883, 1884, 1888, 1894, 1896, 1907, 1918, 1919, 1927, 1933, 1935,
-    1936, 1949, 1950, 1953, 1954, 1956, 1959, 1963, 1964, 1965, 1967, 1969,
-    1974, 1979, 1980, 1983, 1988, 1991, 1994, 1995, 1996, 1999, 2004, 2008,
-    2010, 2014, 2016, 2017, 2019, 2020, 2027, 2032, 2037, 2039, 2048, 2054,
-    2056, 2057, 2068, 2069, 2070, 2073, 2079, 2081, 2082, 2083, 2084, 2085,
-    2086, 2087, 2091, 2096, 2097, 2099, 2100, 2102, 2103, 2105, 2106, 2108,
-    2111, 2114, 2115, 2119, 2129, 2130, 2134, 2136, 2137, 2140, 2142, 2146,
-    2147, 2151, 2152, 2154, 2157, 2169, 2178, 2195, 2196, 2213, 2242, 2243,
-    2244, 2247, 2248, 2278, 2290, 2298, 2299, 2312, 2313, 2314, 2315, 2316,
-    2333, 2334, 2339, 2341, 2362, 2363, 2364, 2367, 2368, 2379, 2396, 2397,
-    2398, 2411, 2419, 2420, 2427, 2428, 2432, 2433, 2434, 2436, 2451, 2453,
-    2454, 2455, 2457, 2459, 2461, 2465, 2482, 2484, 2487, 2488, 2489, 2499,
-    2513, 2514, 2516, 2517, 2532, 2538, 2541, 2555, 2556, 2558, 2559, 2569,
-    2573, 2596, 2598, 2599, 2602, 2603, 2604, 2607, 2608, 2612, 2616, 2638,
-    2639, 2653, 2659, 2661, 2662, 2672, 2673, 2674, 2676, 2678, 2679, 2680,
-    2683, 2687, 2689, 2693, 2694, 2699, 2700, 2701, 2711, 2712, 2716, 2718,
-    2719, 2722, 2724, 2727, 2728, 2730, 2732, 2735, 2736, 2739, 2740, 2756,
-    2757, 2759, 2774, 2780, 2782, 2783, 2787, 2788, 2792, 2793, 2798, 2799,
-    2800, 2801, 2802, 2803, 2807, 2811, 2813, 2815, 2816, 2817, 2819, 2820,
-    2821, 2822, 2825, 2831, 2832, 2838, 2839, 2842, 2847, 2849, 2850, 2852,
-    2855, 2856, 2860, 2866, 2871, 2873, 2874, 2876, 2877, 2895, 2901, 2904,
-    2909, 2910, 2916, 2918, 2919, 2929, 2932, 2933, 2953, 2954, 2955, 2956,
-    2958, 2959, 2962, 2964, 2967, 2968, 2972, 2973, 2974, 2976, 2987, 2999,
-    3016, 3022, 3024, 3025, 3029, 3030, 3032, 3033, 3038, 3039, 3040, 3043,
-    3044, 3045, 3047, 3052, 3053, 3059, 3060, 3061, 3063, 3068, 3071, 3072,
-    3073, 3074, 3075, 3078, 3079, 3082, 3087, 3090, 3092, 3093, 3094, 3095,
-    3096, 3097, 3100, 3107, 3112, 3116, 3117, 3137, 3143, 3145, 3146, 3147,
-    3148, 3149, 3152, 3158, 3160, 3161, 3162, 3164, 3165, 3166, 3167, 3172,
-    3175, 3176, 3177, 3180, 3181, 3182, 3183, 3186, 3188, 3192, 3193, 3194,
-    3198, 3210, 3212, 3213, 3214, 3215, 3217, 3222, 3226, 3231, 3232, 3233,
-    3234, 3236, 3255, 3269, 3270, 3276, 3279, 3289, 3309, 3310, 3314, 3315,
-    3316, 3319, 3324, 3328, 3331, 3334, 3336, 3347, 3350, 3359, 3366, 3390,
-    3395, 3409, 3429, 3435, 3436, 3443, 3467, 3470, 3478, 3479, 3504, 3509,
-    3510, 3518, 3519, 3532, 3533, 3549, 3550, 3553, 3554, 3555, 3558, 3559,
-    3562, 3567, 3571, 3572, 3573, 3574, 3576, 3587, 3590, 3637, 3648, 3652,
-    3670, 3673, 3677, 3681, 3685, 3691, 3693, 3698, 3749, 3757, 3758, 3770,
-    3772, 3789, 3790, 3793, 3794, 3797, 3798, 3800, 3806, 3811, 3812, 3813,
-    3814, 3818, 3830, 3888, 3890, 3893, 3920, 3921, 3922, 3925, 3926, 3927,
-    3989, 3990, 3999, 4024, 4029, 4030, 4034, 4035, 4039, 4051, 4054, 4056,
-    4063, 4067, 4070, 4109, 4118, 4132, 4144, 4149, 4150, 4153, 4154, 4158,
-    4171, 4172, 4173, 4174, 4183, 4190, 4237, 4252, 4264, 4270, 4273, 4277,
-    4291, 4293, 4298, 4303, 4325, 4354, 4361, 4363, 4369, 4371, 4374, 4382,
-    4385, 4391, 4396, 4409, 4419, 4420, 4421, 4429, 4431, 4439, 4442, 4474,
-    4475, 4491, 4494, 4505, 4523, 4529, 4539, 4549, 4558, 4590, 4609, 4624,
-    4629, 4635, 4636, 4663, 4667, 4670, 4679, 4708, 4713, 4731, 4737, 4739,
-    4745, 4769, 4785, 4788, 4789, 4794, 4797, 4827, 4828, 4832, 4855, 4857,
-    4861, 4905, 4908, 4909, 4913, 4914, 4916, 4950, 4984, 4989, 4995, 5023,
-    5027, 5030, 5067, 5071, 5095, 5098, 5145, 5148, 5153, 5155, 5189, 5224,
-    5229, 5230, 5234, 5251, 5254, 5263, 5270, 5308, 5337, 5385, 5388, 5389,
-    5394, 5427, 5455, 5505, 5508, 5513, 5572, 5584, 5590, 5593, 5611, 5613,
-    5623, 5680, 5684, 5692, 5704, 5707, 5708, 5710, 5712, 5713, 5731, 5733,
-    5735, 5737, 5743, 5744, 5790, 5803, 5805, 5823, 5824, 5827, 5829, 5831,
-    5835, 5860, 5863, 5864, 5867, 5870, 5872, 5921, 5925, 5926, 5942, 5943,
-    5946, 5981, 5982, 5985, 5989, 5991, 5992, 6041, 6062, 6101, 6105, 6109,
-    6111, 6184, 6190, 6211, 6223, 6281, 6285, 6286, 6302, 6303, 6306, 6307,
-    6309, 6341, 6342, 6344, 6349, 6350, 6351, 6352, 6424, 6429, 6463, 6470,
-    6585, 6589, 6644, 6664, 6667, 6668, 6670, 6691, 6697, 6703, 6704, 6825,
-    6828, 6904, 6907, 6943, 6944, 7006, 7024, 7026, 7027, 7062, 7063, 7064,
-    7088, 7110, 7121, 7123, 7125, 7126, 7131, 7142, 7143, 7145, 7146, 7151,
-    7155, 7169, 7180, 7181, 7182, 7187, 7189, 7191, 7192, 7208, 7230, 7241,
-    7243, 7245, 7246, 7251, 7262, 7263, 7265, 7266, 7267, 7269, 7271, 7275,
-    7289, 7300, 7302, 7304, 7307, 7310, 7311, 7312, 7362, 7376, 7421, 7425,
-    7426, 7428, 7504, 7543, 7665, 7726, 7746, 7747, 7781, 7782, 7784, 7785,
-    7846, 7864, 7866, 7867, 7901, 7902, 7903, 7904, 7966, 7986, 8021, 8022,
-    8025, 8141, 8145, 8201, 8203, 8211, 8222, 8225, 8231, 8249, 8260, 8261,
-    8265, 8269, 8271, 8317, 8328, 8332, 8353, 8357, 8361, 8365, 8373, 8378,
-    8420, 8427, 8428, 8431, 8432, 8433, 8450, 8451, 8453, 8455, 8457, 8458,
-    8459, 8461, 8465, 8480, 8482, 8486, 8487, 8489, 8513, 8514, 8515, 8516,
-    8517, 8565, 8583, 8584, 8587, 8589, 8623, 8624, 8630, 8632, 8681, 8685,
-    8686, 8702, 8703, 8704, 8706, 8707, 8709, 8742, 8743, 8744, 8750, 8751,
-    8752, 8808, 8810, 8840, 8841, 8845, 8846, 8905, 8909, 8912, 8918, 8920,
-    8924, 8925, 8927, 8932, 8940, 8941, 8943, 8947, 8948, 8949, 8950, 8952,
-    8953, 8954, 8958, 8970, 8971, 8972, 8973, 8974, 8975, 8977, 8984, 8990,
-    8992, 8996, 9021, 9036, 9037, 9038, 9039, 9049, 9050, 9053, 9076, 9077,
-    9078, 9079, 9080, 9082, 9084, 9086, 9087, 9088, 9092, 9096, 9098, 9119,
-    9168, 9201, 9205, 9274, 9291, 9294, 9305, 9329, 9339, 9345, 9349, 9387,
-    9391, 9397, 9400, 9402, 9415, 9416, 9418, 9432, 9437, 9455, 9458, 9461,
-    9466, 9468, 9473, 9475, 9522, 9524, 9526, 9536, 9546, 9548, 9577, 9581,
-    9582, 9585, 9586, 9588, 9614, 9628, 9633, 9639, 9641, 9642, 9643, 9647,
-    9651, 9656, 9657, 9659, 9660, 9662, 9665, 9671, 9679, 9689, 9690, 9696,
-    9700, 9701, 9706, 9708, 9709, 9711, 9714, 9717, 9751, 9752, 9757, 9758,
-    9760, 9767, 9768, 9770, 9778, 9780, 9781, 9792, 9797, 9798, 9800, 9801,
-    9805, 9806, 9810, 9812, 9815, 9818, 9835, 9836, 9869, 9884, 9885, 9887,
-    9900, 9903, 9904, 9907, 9908, 9909, 9910, 9914, 9930, 9931, 9934, 9937,
-    9943, 9944, 9950, 9952, 9986, 9987, 9991, 9997, 10000, 10002, 10004, 10006,
-    10012, 10015, 10016, 10018, 10026, 10028, 10032, 10033, 10037, 10053, 10055,
-    10057, 10058, 10062, 10066, 10073, 10075, 10096, 10109, 10110, 10113, 10119,
-    10123, 10124, 10125, 10127, 10139, 10140, 10143, 10147, 10148, 10149, 10150,
-    10151, 10154, 10155, 10159, 10170, 10171, 10174, 10176, 10177, 10180, 10184,
-    10187, 10190, 10192, 10197, 10225, 10229, 10231, 10232, 10237, 10238, 10240,
-    10244, 10245, 10247, 10250, 10252, 10258, 10260, 10261, 10263, 10268, 10272,
-    10273, 10274, 10277, 10278, 10280, 10286, 10290, 10292, 10293, 10294, 10295,
-    10297, 10298, 10312, 10315, 10316, 10351, 10357, 10360, 10364, 10368, 10372,
-    10378, 10388, 10392, 10393, 10397, 10401, 10405, 10413, 10415, 10417, 10418,
-    10435, 10462, 10471, 10472, 10473, 10477, 10478, 10479, 10480, 10483, 10487,
-    10490, 10493, 10498, 10499, 10500, 10501, 10511, 10512, 10517, 10518, 10519,
-    10520, 10522, 10526, 10527, 10530, 10532, 10535, 10536, 10538, 10540, 10555,
-    10556, 10557, 10587, 10591, 10597, 10600, 10602, 10608, 10615, 10616, 10618,
-    10632, 10637, 10641, 10645, 10655, 10658, 10666, 10673, 10675, 10711, 10717,
-    10720, 10724, 10732, 10738, 10747, 10748, 10750, 10752, 10753, 10757, 10771,
-    10773, 10775, 10777, 10778, 10784, 10795, 10827, 10840, 10842, 10855, 10856,
-    10872, 10895, 10901, 10905, 10906, 10908, 10913, 10943, 10947, 10948, 10951,
-    10952, 10957, 10958, 10960, 10961, 10962, 10967, 10970, 10975, 10976, 10977,
-    10978, 10980, 10981, 10982, 10992, 10997, 10998, 11000, 11006, 11010, 11012,
-    11015, 11018, 11026, 11031, 11033, 11034, 11035, 11036, 11057, 11068, 11069,
-    11081, 11082, 11084, 11085, 11086, 11087, 11096, 11097, 11100, 11102, 11103,
-    11106, 11108, 11114, 11130, 11134, 11137, 11141, 11142, 11146, 11148, 11149,
-    11151, 11152, 11154, 11177, 11188, 11189, 11201, 11202, 11204, 11205, 11206,
-    11207, 11216, 11217, 11220, 11222, 11223, 11226, 11227, 11228, 11229, 11230,
-    11234, 11250, 11251, 11254, 11257, 11262, 11264, 11266, 11270, 11271, 11272,
-    11274, 11311, 11317, 11320, 11328, 11338, 11352, 11357, 11361, 11365, 11375,
-    11378, 11395, 11426, 11427, 11440, 11442, 11444, 11446, 11452, 11455, 11456,
-    11466, 11468, 11472, 11473, 11493, 11495, 11497, 11501, 11502, 11506, 11508,
-    11513, 11543, 11547, 11548, 11552, 11558, 11560, 11561, 11562, 11567, 11575,
-    11576, 11577, 11580, 11581, 11582, 11592, 11598, 11610, 11612, 11615, 11621,
-    11626, 11628, 11629, 11631, 11633, 11634, 11636, 11682, 11684, 11686, 11696,
-    11706, 11707, 11708, 11710, 11731, 11737, 11741, 11742, 11744, 11746, 11748,
-    11788, 11801, 11802, 11807, 11816, 11817, 11820, 11822, 11850, 11861, 11865,
-    11866, 11868, 11869, 11871, 11874, 11922, 11924, 11926, 11936, 11944, 11946,
-    11947, 11948, 11950, 11971, 11977, 11982, 11983, 11984, 11986, 12051, 12065,
-    12089, 12105, 12109, 12157, 12158, 12159, 12168, 12170, 12173, 12197, 12198,
-    12199, 12200, 12201, 12202, 12205, 12206, 12207, 12212, 12216, 12218, 12277,
-    12278, 12288, 12290, 12317, 12318, 12320, 12321, 12325, 12326, 12332, 12338,
-    12397, 12408, 12437, 12441, 12445, 12458, 12491, 12508, 12513, 12514, 12516,
-    12531, 12534, 12537, 12539, 12545, 12564, 12568, 12569, 12579, 12588, 12589,
-    12594, 12597, 12620, 12627, 12628, 12632, 12633, 12651, 12653, 12655, 12657,
-    12659, 12661, 12665, 12682, 12687, 12689, 12708, 12709, 12713, 12714, 12716,
-    12717, 12747, 12748, 12751, 12752, 12770, 12775, 12777, 12778, 12781, 12800,
-    12806, 12828, 12829, 12833, 12834, 12835, 12836, 12867, 12871, 12888, 12895,
-    12898, 12921, 12925, 12948, 12953, 12955, 12996, 13008, 13010, 13013, 13040,
-    13041, 13042, 13044, 13045, 13046, 13047, 13048, 13106, 13107, 13120, 13122,
-    13124, 13126, 13132, 13135, 13136, 13146, 13147, 13148, 13150, 13152, 13153,
-    13171, 13173, 13175, 13177, 13182, 13184, 13186, 13193, 13207, 13230, 13234,
-    13243, 13245, 13249, 13254, 13263, 13267, 13269, 13271, 13275, 13276, 13299,
-    13300, 13304, 13307, 13310, 13312, 13319, 13338, 13355, 13356, 13370, 13373,
-    13400, 13402, 13403, 13404, 13406, 13407, 13408, 13438, 13459, 13471, 13472,
-    13473, 13474, 13476, 13490, 13493, 13494, 13498, 13499, 13501, 13520, 13522,
-    13524, 13526, 13527, 13528, 13539, 13555, 13556, 13557, 13591, 13592, 13593,
-    13608, 13610, 13613, 13618, 13619, 13621, 13640, 13641, 13642, 13645, 13646,
-    13647, 13675, 13676, 13677, 13711, 13712, 13728, 13730, 13738, 13741, 13760,
-    13761, 13765, 13766, 13795, 13796, 13831, 13848, 13858, 13881, 13885, 13915,
-    13944, 13949, 13950, 13957, 13958, 13959, 13970, 13972, 13973, 13993, 13994,
-    13995, 13997, 13998, 13999, 14000, 14002, 14006, 14007, 14012, 14013, 14014,
-    14016, 14018, 14027, 14069, 14077, 14078, 14088, 14090, 14092, 14113, 14114,
-    14117, 14118, 14120, 14121, 14125, 14126, 14132, 14133, 14134, 14138, 14187,
-    14188, 14191, 14192, 14208, 14210, 14215, 14217, 14218, 14221, 14240, 14241,
-    14245, 14246, 14273, 14274, 14275, 14276, 14307, 14311, 14328, 14335, 14338,
-    14361, 14365, 14393, 14395
-  };
-
-  const double values[1968] = {
-    u[0], a[0], b[0], c[0], u[3], u[0], a[0], a[9], b[0], b[9], c[0], c[9],
-    u[3], u[0], a[9], a[13], a[0], b[9], b[0], b[13], c[0], c[9], c[13], u[2],
-    u[0], a[10], a[0], b[0], b[10], c[10], c[0], u[2], u[3], u[0], a[10], a[4],
-    a[0], a[9], b[10], b[0], b[9], b[4], c[10], c[0], c[4], c[9], u[2], u[3],
-    u[0], a[4], a[11], a[0], a[9], a[13], a[10], b[4], b[0], b[10], b[9], b[13],
-    b[11], c[10], c[4], c[9], c[0], c[11], c[13], u[2], u[0], a[0], a[14],
-    a[10], b[0], b[10], b[14], c[0], c[14], c[10], u[2], u[3], u[0], a[9],
-    a[14], a[5], a[10], a[0], a[4], b[14], b[0], b[10], b[9], b[4], b[5], c[14],
-    c[10], c[9], c[0], c[5], c[4], u[2], u[3], u[0], a[13], a[5], a[10], a[4],
-    a[9], a[0], a[11], a[14], b[5], b[10], b[9], b[14], b[0], b[4], b[13],
-    b[11], c[14], c[5], c[4], c[0], c[13], c[10], c[9], c[11], u[1], u[0], a[8],
-    a[0], b[8], b[0], c[0], c[8], u[1], u[3], u[0], a[0], a[8], a[3], a[9],
-    b[8], b[0], b[3], b[9], c[9], c[8], c[0], c[3], u[1], u[3], u[0], a[0],
-    a[9], a[3], a[7], a[13], a[8], b[3], b[0], b[9], b[8], b[7], b[13], c[13],
-    c[8], c[3], c[0], c[9], c[7], u[1], u[2], u[0], a[2], a[10], a[0], a[8],
-    b[8], b[0], b[2], b[10], c[10], c[0], c[2], c[8], u[1], u[2], u[3], u[0],
-    a[10], a[2], a[16], a[4], a[9], a[8], a[0], a[3], b[2], b[10], b[0], b[8],
-    b[3], b[9], b[16], b[4], c[4], c[0], c[9], c[2], c[8], c[10], c[16], c[3],
-    u[1], u[2], u[3], u[0], a[10], a[4], a[16], a[11], a[13], a[8], a[0], a[3],
-    a[9], a[7], a[2], b[16], b[0], b[10], b[4], b[9], b[8], b[2], b[3], b[7],
-    b[13], b[11], c[11], c[2], c[9], c[13], c[16], c[3], c[0], c[8], c[10],
-    c[4], c[7], u[1], u[2], u[0], a[0], a[8], a[17], a[14], a[10], a[2], b[0],
-    b[8], b[2], b[10], b[17], b[14], c[14], c[0], c[10], c[8], c[17], c[2],
-    u[1], u[2], u[3], u[0], a[9], a[3], a[14], a[17], a[5], a[4], a[2], a[0],
-    a[8], a[10], a[16], b[17], b[14], b[10], b[8], b[0], b[2], b[9], b[3],
-    b[16], b[4], b[5], c[5], c[10], c[9], c[4], c[0], c[17], c[2], c[3], c[8],
-    c[14], c[16], u[1], u[2], u[3], u[0], a[14], a[13], a[7], a[5], a[11], a[2],
-    a[10], a[16], a[9], a[3], a[8], a[4], a[17], b[10], b[14], b[5], b[4], b[2],
-    b[3], b[17], b[8], b[9], b[16], b[13], b[7], b[11], c[17], c[4], c[13],
-    c[11], c[9], c[16], c[8], c[10], c[7], c[2], c[3], c[14], c[5], u[1], u[0],
-    a[12], a[8], a[0], b[0], b[12], b[8], c[0], c[8], c[12], u[1], u[3], u[0],
-    a[0], a[8], a[12], a[18], a[3], a[9], b[12], b[8], b[0], b[9], b[18], b[3],
-    c[9], c[3], c[12], c[0], c[8], c[18], u[1], u[3], u[0], a[0], a[8], a[9],
-    a[3], a[18], a[7], a[12], a[13], b[18], b[0], b[8], b[3], b[9], b[12],
-    b[13], b[7], c[13], c[7], c[12], c[18], c[0], c[8], c[9], c[3], u[1], u[2],
-    u[0], a[1], a[2], a[0], a[8], a[12], a[10], b[12], b[0], b[8], b[10], b[1],
-    b[2], c[10], c[2], c[0], c[8], c[1], c[12], u[1], u[2], u[3], u[0], a[10],
-    a[2], a[1], a[16], a[9], a[3], a[0], a[12], a[8], a[18], a[4], b[1], b[2],
-    b[8], b[10], b[12], b[0], b[18], b[9], b[3], b[4], b[16], c[4], c[16], c[8],
-    c[9], c[0], c[3], c[1], c[12], c[10], c[2], c[18], u[1], u[2], u[3], u[0],
-    a[10], a[2], a[4], a[16], a[13], a[7], a[9], a[12], a[8], a[18], a[3], a[1],
-    a[11], b[10], b[8], b[2], b[16], b[3], b[4], b[12], b[1], b[18], b[9],
-    b[13], b[7], b[11], c[11], c[1], c[3], c[13], c[9], c[7], c[18], c[8],
-    c[12], c[10], c[2], c[4], c[16], u[1], u[2], u[0], a[8], a[12], a[17],
-    a[10], a[2], a[1], a[0], a[14], b[0], b[8], b[12], b[1], b[10], b[2], b[14],
-    b[17], c[14], c[17], c[10], c[0], c[8], c[2], c[12], c[1], u[1], u[2], u[3],
-    u[0], a[3], a[18], a[14], a[17], a[4], a[16], a[10], a[1], a[8], a[12],
-    a[2], a[9], a[5], b[17], b[2], b[14], b[12], b[8], b[1], b[10], b[9], b[3],
-    b[18], b[4], b[16], b[5], c[5], c[2], c[4], c[9], c[3], c[10], c[16], c[8],
-    c[1], c[18], c[12], c[14], c[17], u[1], u[2], u[3], u[0], a[14], a[17],
-    a[7], a[5], a[11], a[4], a[1], a[2], a[3], a[18], a[12], a[16], a[13],
-    b[14], b[2], b[17], b[16], b[5], b[1], b[18], b[12], b[3], b[4], b[13],
-    b[7], b[11], c[16], c[11], c[13], c[7], c[4], c[3], c[12], c[2], c[1],
-    c[18], c[14], c[17], c[5], u[2], a[10], a[2], a[6], a[14], a[17], b[8],
-    b[0], b[10], b[2], b[17], b[14], b[6], c[6], c[0], c[10], c[14], c[2], c[8],
-    c[17], u[2], a[10], a[6], a[14], b[0], b[10], b[14], b[6], c[10], c[0],
-    c[6], c[14], u[2], a[2], a[1], a[14], a[17], a[10], a[6], b[12], b[8],
-    b[10], b[2], b[1], b[14], b[17], b[6], c[6], c[8], c[14], c[10], c[2],
-    c[17], c[1], c[12], a[17], a[6], a[1], b[19], b[1], b[17], b[6], c[6],
-    c[19], c[1], c[17], a[1], a[14], a[17], a[6], a[2], b[19], b[12], b[2],
-    b[1], b[14], b[17], b[6], c[6], c[12], c[17], c[2], c[1], c[14], c[19],
-    a[8], a[12], a[19], b[12], b[8], b[19], c[8], c[12], c[19], a[14], a[17],
-    a[6], b[8], b[2], b[10], b[14], b[17], b[6], c[10], c[14], c[6], c[8],
-    c[17], c[2], a[17], a[6], a[14], b[12], b[1], b[2], b[14], b[17], b[6],
-    c[2], c[6], c[14], c[17], c[12], c[1], a[6], a[17], b[19], b[1], b[17],
-    b[6], c[1], c[17], c[6], c[19], u[3], a[11], a[9], a[13], a[15], a[4],
-    b[11], b[9], b[4], b[13], b[15], c[4], c[11], c[13], c[0], c[10], c[9],
-    c[15], u[3], a[13], a[15], a[9], b[13], b[9], b[15], c[9], c[13], c[0],
-    c[15], a[14], a[6], b[0], b[10], b[14], b[6], c[0], c[14], c[10], c[6],
-    a[13], a[15], a[7], b[13], b[15], b[7], c[7], c[8], c[9], c[3], c[13],
-    c[15], a[13], a[7], a[15], b[13], b[7], b[15], c[12], c[3], c[18], c[13],
-    c[7], c[15], a[6], b[10], b[14], b[6], c[10], c[6], c[14], a[7], a[15],
-    b[7], b[15], c[19], c[18], c[7], c[15], a[6], b[2], b[17], b[14], b[6],
-    c[14], c[6], c[2], c[17], a[15], b[15], c[3], c[13], c[7], c[15], a[15],
-    b[15], c[18], c[7], c[15], a[6], b[1], b[17], b[6], c[17], c[6], c[1], a[6],
-    a[17], a[5], b[18], b[1], b[17], b[16], b[6], b[5], c[16], c[5], c[6],
-    c[17], c[18], c[1], a[5], a[6], a[14], b[14], b[9], b[10], b[4], b[6], b[5],
-    c[6], c[9], c[10], c[5], c[4], c[14], a[11], a[15], a[13], b[11], b[15],
-    b[13], c[4], c[13], c[14], c[5], c[11], c[15], a[15], b[15], c[13], c[4],
-    c[11], c[15], b[17], b[6], c[6], c[17], a[5], a[11], a[4], b[5], b[11],
-    b[4], b[13], b[15], c[14], c[4], c[13], c[6], c[15], c[5], c[11], b[14],
-    b[6], c[14], c[6], c[13], c[15], a[6], b[16], b[17], b[6], b[5], c[5], c[6],
-    c[16], c[17], c[7], c[15], b[5], b[6], c[5], c[6], a[6], b[11], b[6], b[5],
-    c[6], c[11], c[5], u[3], a[15], a[4], a[11], a[13], a[9], a[5], b[4], b[13],
-    b[5], b[9], b[11], b[15], c[5], c[11], c[10], c[9], c[15], c[14], c[4],
-    c[13], u[2], a[11], a[14], a[5], a[4], a[10], a[6], b[14], b[4], b[6],
-    b[10], b[9], b[13], b[5], b[11], c[6], c[5], c[10], c[9], c[11], c[13],
-    c[14], c[4], a[15], b[15], c[7], c[16], c[15], c[11], b[6], c[6], c[15],
-    a[11], b[11], b[15], c[5], c[11], c[15], c[6], a[5], b[15], b[5], b[11],
-    c[6], c[5], c[15], c[11], a[15], b[15], c[11], c[15], c[5], c[15], c[11],
-    a[13], a[15], a[11], b[13], b[11], b[15], c[11], c[15], c[9], c[10], c[4],
-    c[13], a[1], a[17], a[19], b[19], b[1], b[17], c[17], c[19], c[1], u[1],
-    a[8], a[12], a[9], a[3], a[18], a[13], a[19], a[7], b[8], b[12], b[9],
-    b[18], b[3], b[19], b[13], b[7], c[13], c[7], c[19], c[8], c[12], c[9],
-    c[3], c[18], a[6], b[6], b[4], b[14], b[5], c[4], c[14], c[5], c[6], a[6],
-    a[5], a[14], b[6], b[5], b[13], b[14], b[4], b[11], c[14], c[13], c[4],
-    c[11], c[6], c[5], a[12], a[19], b[19], b[12], c[12], c[19], u[2], a[16],
-    a[6], a[5], a[14], a[2], a[1], a[17], a[4], b[17], b[6], b[1], b[12], b[2],
-    b[18], b[3], b[14], b[4], b[16], b[5], c[17], c[3], c[5], c[4], c[16],
-    c[14], c[2], c[12], c[18], c[1], c[6], u[1], a[1], a[0], a[8], a[12], a[19],
-    a[10], a[2], b[19], b[0], b[8], b[12], b[10], b[2], b[1], c[10], c[2], c[1],
-    c[8], c[12], c[0], c[19], a[19], b[19], c[19], a[15], a[13], b[15], b[13],
-    c[13], c[15], c[0], c[9], a[16], a[11], a[15], a[7], a[18], b[16], b[18],
-    b[11], b[7], b[15], c[7], c[15], c[19], c[18], c[1], c[16], c[11], a[11],
-    a[15], a[7], b[11], b[7], b[15], c[15], c[16], c[7], c[17], c[11], c[5],
-    u[3], a[4], a[11], a[15], a[3], a[9], a[7], a[13], a[16], b[9], b[4], b[11],
-    b[13], b[3], b[16], b[7], b[15], c[16], c[13], c[15], c[7], c[8], c[9],
-    c[10], c[2], c[3], c[4], c[11], a[2], a[1], a[3], a[18], a[12], a[19], a[4],
-    a[16], b[2], b[19], b[1], b[12], b[3], b[18], b[16], b[4], c[4], c[16],
-    c[19], c[18], c[12], c[3], c[2], c[1], a[5], a[14], a[17], a[6], b[6],
-    b[17], b[3], b[2], b[14], b[16], b[4], b[5], c[6], c[4], c[5], c[14], c[3],
-    c[2], c[16], c[17], u[1], a[17], a[5], a[11], a[16], a[1], a[18], a[19],
-    a[7], b[17], b[1], b[5], b[19], b[18], b[16], b[7], b[11], c[7], c[16],
-    c[18], c[11], c[19], c[1], c[17], c[5], u[2], a[4], a[16], a[6], a[5],
-    a[17], a[10], a[2], a[14], b[6], b[14], b[2], b[8], b[10], b[3], b[9],
-    b[17], b[4], b[16], b[5], c[14], c[9], c[4], c[5], c[10], c[17], c[8],
-    c[16], c[3], c[2], c[6], u[1], a[18], a[14], a[17], a[4], a[16], a[2],
-    a[12], a[19], a[1], a[5], a[3], b[14], b[1], b[17], b[19], b[12], b[2],
-    b[3], b[18], b[4], b[16], b[5], c[5], c[1], c[16], c[3], c[18], c[2], c[12],
-    c[4], c[19], c[14], c[17], a[17], a[16], a[1], a[19], a[5], a[18], b[17],
-    b[19], b[1], b[18], b[16], b[5], c[5], c[18], c[1], c[19], c[16], c[17],
-    u[1], a[10], a[2], a[1], a[9], a[3], a[18], a[8], a[19], a[12], a[4], a[16],
-    b[10], b[1], b[12], b[2], b[19], b[8], b[9], b[3], b[18], b[4], b[16], c[4],
-    c[16], c[12], c[3], c[8], c[18], c[9], c[19], c[10], c[2], c[1], a[1],
-    a[16], a[7], a[18], a[19], a[11], b[1], b[19], b[16], b[18], b[7], b[11],
-    c[11], c[18], c[7], c[19], c[1], c[16], a[6], a[5], a[17], a[1], a[16],
-    b[6], b[19], b[1], b[18], b[17], b[16], b[5], c[18], c[16], c[17], c[1],
-    c[5], c[19], c[6], a[11], a[15], a[7], b[11], b[7], b[15], c[15], c[18],
-    c[1], c[7], c[16], c[11], u[1], a[2], a[1], a[4], a[16], a[13], a[7], a[3],
-    a[19], a[12], a[18], a[11], b[2], b[12], b[1], b[4], b[18], b[16], b[19],
-    b[3], b[13], b[7], b[11], c[11], c[18], c[7], c[3], c[13], c[12], c[19],
-    c[2], c[1], c[4], c[16], u[3], a[5], a[15], a[16], a[4], a[13], a[7], a[3],
-    a[11], b[4], b[5], b[11], b[16], b[7], b[3], b[13], b[15], c[11], c[15],
-    c[13], c[2], c[3], c[4], c[14], c[17], c[16], c[7], c[5], u[2], a[6], a[11],
-    a[17], a[14], a[4], a[16], a[2], a[5], b[14], b[6], b[5], b[17], b[16],
-    b[2], b[3], b[4], b[7], b[13], b[11], c[5], c[13], c[11], c[4], c[2], c[3],
-    c[14], c[7], c[17], c[16], c[6], a[1], a[18], a[19], a[16], b[1], b[19],
-    b[18], b[16], c[16], c[19], c[18], c[1], u[3], a[5], a[11], a[16], a[7],
-    a[18], a[15], b[5], b[16], b[18], b[7], b[11], b[15], c[15], c[11], c[7],
-    c[1], c[18], c[16], c[17], c[5], u[3], a[4], a[16], a[11], a[15], a[13],
-    a[18], a[3], a[7], b[4], b[3], b[16], b[7], b[11], b[18], b[13], b[15],
-    c[7], c[15], c[13], c[12], c[3], c[2], c[1], c[18], c[4], c[16], c[11],
-    a[5], a[11], a[16], b[5], b[16], b[7], b[11], b[15], c[15], c[11], c[17],
-    c[16], c[7], c[5], c[6], a[11], a[7], a[13], a[15], b[13], b[11], b[15],
-    b[7], c[15], c[3], c[2], c[13], c[4], c[16], c[7], c[11], a[6], a[5], a[17],
-    b[6], b[7], b[17], b[16], b[5], b[11], c[11], c[5], c[17], c[7], c[16],
-    c[6], a[15], b[15], c[15], c[9], c[13], a[8], a[12], a[19], a[10], a[2],
-    a[1], b[8], b[12], b[19], b[2], b[10], b[1], c[10], c[2], c[1], c[12],
-    c[19], c[8], a[12], a[19], a[2], a[1], b[12], b[19], b[1], b[2], c[2], c[1],
-    c[19], c[12], a[19], a[1], b[19], b[1], c[1], c[19], u[3], a[9], a[13],
-    a[7], a[15], a[3], b[7], b[9], b[13], b[3], b[15], c[15], c[3], c[7], c[0],
-    c[8], c[9], c[13], u[3], a[9], a[3], a[13], a[7], a[18], a[15], b[9], b[3],
-    b[7], b[13], b[18], b[15], c[15], c[18], c[8], c[12], c[9], c[3], c[13],
-    c[7], a[3], a[18], a[13], a[7], a[15], b[3], b[18], b[13], b[7], b[15],
-    c[15], c[12], c[19], c[3], c[18], c[13], c[7], a[18], a[7], a[15], b[18],
-    b[7], b[15], c[15], c[19], c[18], c[7], a[19], a[0], a[8], a[12], b[8],
-    b[0], b[12], b[19], c[0], c[8], c[12], c[19], u[2], a[6], a[5], a[17],
-    a[16], a[1], a[11], b[6], b[17], b[1], b[18], b[16], b[7], b[5], b[11],
-    c[7], c[11], c[5], c[16], c[1], c[18], c[17], c[6], u[2], a[4], a[6], a[14],
-    a[10], a[5], b[6], b[10], b[0], b[9], b[14], b[4], b[5], c[6], c[14], c[0],
-    c[4], c[9], c[10], c[5], u[1], a[19], a[12], a[0], a[8], b[0], b[8], b[19],
-    b[12], c[0], c[8], c[12], c[19], u[1], a[0], a[8], a[12], a[19], a[18],
-    a[9], a[3], b[19], b[0], b[12], b[8], b[9], b[3], b[18], c[9], c[3], c[18],
-    c[19], c[0], c[8], c[12], a[8], a[12], a[19], a[9], a[3], a[18], b[8],
-    b[19], b[12], b[3], b[9], b[18], c[9], c[3], c[18], c[8], c[12], c[19],
-    a[12], a[19], a[3], a[18], b[12], b[19], b[18], b[3], c[3], c[18], c[12],
-    c[19], a[19], a[18], b[19], b[18], c[18], c[19], u[1], a[12], a[19], a[10],
-    a[2], a[1], a[14], a[8], a[17], b[8], b[12], b[19], b[10], b[2], b[1],
-    b[14], b[17], c[14], c[17], c[2], c[8], c[12], c[1], c[10], c[19], a[19],
-    a[2], a[1], a[14], a[17], a[12], b[12], b[19], b[2], b[1], b[17], b[14],
-    c[14], c[17], c[1], c[12], c[19], c[2], a[12], a[19], a[3], a[18], a[13],
-    a[7], b[12], b[19], b[3], b[18], b[7], b[13], c[13], c[7], c[12], c[19],
-    c[3], c[18], a[19], a[18], a[7], b[19], b[18], b[7], c[7], c[19], c[18]
-  };
+  double coefficients[kNumMacaulayCoefficients];
+  GatherMacaulayCoefficients(a, b, c, u, coefficients);
 
   Eigen::Map<Matrix<double, 14400, 1> > macaulay_vec(macaulay_matrix.data());
-  for (int i = 0; i < 1968; i++) {
-    macaulay_vec(indices[i]) = values[i];
+  for (int i = 0; i < kNumMacaulayNonZeros; i++) {
+    macaulay_vec(kMacaulayIndices[i]) =
+        coefficients[kMacaulayCoefficientIds[i]];
   }
 
   return macaulay_matrix;
 }
 
+void ComputeMultiplicationMatrix(const double a[20],
+                                 const double b[20],
+                                 const double c[20],
+                                 const double u[4],
+                                 Matrix<double, 27, 27>* multiplication_matrix) {
+  double coefficients[kNumMacaulayCoefficients];
+  GatherMacaulayCoefficients(a, b, c, u, coefficients);
+
+  // Scatter the Macaulay matrix directly into its four Schur complement blocks.
+  // The rows and columns of the bottom-right block are permuted so that it is
+  // block lower triangular, and the top-right block only has one non-zero
+  // entry per column so it is stored sparsely.
+  Matrix<double, 27, 27>& top_left = *multiplication_matrix;
+  top_left.setZero();
+  int top_right_rows[kNumTopRightNonZeros];
+  int top_right_cols[kNumTopRightNonZeros];
+  double top_right_values[kNumTopRightNonZeros];
+  int num_top_right = 0;
+  Matrix<double, 93, 27> bottom_left = Matrix<double, 93, 27>::Zero();
+  Matrix<double, 93, 93> bottom_right = Matrix<double, 93, 93>::Zero();
+  for (int i = 0; i < kNumMacaulayNonZeros; i++) {
+    const int row = kMacaulayIndices[i] % 120;
+    const int col = kMacaulayIndices[i] / 120;
+    const double value = coefficients[kMacaulayCoefficientIds[i]];
+    if (row < 27 && col < 27) {
+      top_left(row, col) = value;
+    } else if (row < 27) {
+      DCHECK_LT(num_top_right, kNumTopRightNonZeros);
+      top_right_rows[num_top_right] = row;
+      top_right_cols[num_top_right] = kEliminationColumnPosition[col - 27];
+      top_right_values[num_top_right] = value;
+      ++num_top_right;
+    } else if (col < 27) {
+      bottom_left(kEliminationRowPosition[row - 27], col) = value;
+    } else {
+      bottom_right(kEliminationRowPosition[row - 27],
+                   kEliminationColumnPosition[col - 27]) = value;
+    }
+  }
+
+  // Solve bottom_right * x = bottom_left by block forward substitution. The
+  // diagonal block sizes are fixed by the structure of the Macaulay matrix.
+  SolveDiagonalBlock<0, 3>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<3, 9>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<12, 18>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<30, 26>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<56, 33>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<89, 1>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<90, 1>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<91, 1>(bottom_right, &bottom_left);
+  SolveDiagonalBlock<92, 1>(bottom_right, &bottom_left);
+
+  // The multiplication matrix is the Schur complement of the bottom-right
+  // block: top_left - top_right * inverse(bottom_right) * bottom_left.
+  for (int i = 0; i < num_top_right; i++) {
+    top_left.row(top_right_rows[i]) -=
+        top_right_values[i] * bottom_left.row(top_right_cols[i]);
+  }
+}
+
 }  // namespace dls_impl
 }  // namespace theia
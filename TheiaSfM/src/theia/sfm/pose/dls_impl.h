@@ -60,6 +60,15 @@ Eigen::MatrixXd CreateMacaulayMatrix(
     const double f1_coeff[20], const double f2_coeff[20],
     const double f3_coeff[20], const double rand_term[4]);
 
+// Computes the 27x27 multiplication matrix (i.e., the Schur complement of the
+// bottom-right 93x93 block of the Macaulay matrix) without forming the
+// Macaulay matrix. The bottom-right block is eliminated with fixed-size block
+// forward substitution so that no memory is allocated.
+void ComputeMultiplicationMatrix(
+    const double f1_coeff[20], const double f2_coeff[20],
+    const double f3_coeff[20], const double rand_term[4],
+    Eigen::Matrix<double, 27, 27>* multiplication_matrix);
+
 }  // namespace dls_impl
 }  // namespace theia
 
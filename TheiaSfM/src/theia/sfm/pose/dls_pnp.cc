@@ -37,8 +37,11 @@
 #include <Eigen/Core>
 #include <Eigen/Eigenvalues>
 #include <Eigen/Geometry>
+#include <Eigen/LU>
 #include <glog/logging.h>
+#include <algorithm>
 #include <cmath>
+#include <complex>
 #include <vector>
 
 #include "theia/util/random.h"
@@ -52,71 +55,129 @@ using Eigen::MatrixXd;
 using Eigen::Quaterniond;
 using Eigen::Vector2d;
 using Eigen::Vector3d;
+using dls_impl::ComputeMultiplicationMatrix;
 using dls_impl::CreateMacaulayMatrix;
 using dls_impl::ExtractJacobianCoefficients;
 using dls_impl::LeftMultiplyMatrix;
 
-// This implementation is ported from the Matlab version provided by the authors
-// of "A Direct Least-Squares (DLS) Method for PnP". The general approach is to
-// first rewrite the reprojection constraint (i.e., cost function) such that all
-// unknowns appear linearly in terms of the rotation parameters (which are 3
-// parameters in the Cayley-Gibss-Rodriguez formulation). Then we create a
-// system of equations from the jacobian of the cost function, and solve these
-// equations via a Macaulay matrix to obtain the roots (i.e., the 3 parameters
-// of rotation). The translation can then be obtained through back-substitution.
-void DlsPnp(const std::vector<Vector2d>& feature_position,
-            const std::vector<Vector3d>& world_point,
-            std::vector<Quaterniond>* solution_rotation,
-            std::vector<Vector3d>* solution_translation) {
-  CHECK_GE(feature_position.size(), 3);
-  CHECK_EQ(feature_position.size(), world_point.size());
+namespace {
 
-  const int num_correspondences = feature_position.size();
-
-  // Holds the normalized feature positions cross multiplied with itself
-  // i.e. n * n^t. This value is used multiple times so it is efficient to
-  // pre-compute it.
-  std::vector<Matrix3d> normalized_feature_cross;
-  normalized_feature_cross.reserve(num_correspondences);
-  for (int i = 0; i < num_correspondences; i++) {
+// Computes the translation parameterized by the 9 entries of the rotation
+// matrix and the coefficients of the LS cost function (Eq. 17 in the DLS
+// paper) from the 2D-3D correspondences.
+void ComputeCostCoefficients(const Vector2d* feature_position,
+                             const Vector3d* world_point,
+                             const int num_correspondences,
+                             Matrix<double, 3, 9>* translation_factor,
+                             Matrix<double, 9, 9>* ls_cost_coefficients) {
+  // The normalized feature positions cross multiplied with itself i.e. n * n^t
+  // are used multiple times. They are cheap to compute, so we recompute them
+  // instead of storing them.
+  const auto normalized_feature_cross = [&](const int i) {
     const Vector3d normalized_feature_pos =
         feature_position[i].homogeneous().normalized();
-    normalized_feature_cross.push_back(normalized_feature_pos *
-                                       normalized_feature_pos.transpose());
-  }
+    return Matrix3d(normalized_feature_pos *
+                    normalized_feature_pos.transpose());
+  };
 
   // The bottom-right symmetric block matrix of inverse(A^T * A). Matrix H from
   // Eq. 25 in the Appendix of the DLS paper.
   Matrix3d h_inverse = num_correspondences * Matrix3d::Identity();
   for (int i = 0; i < num_correspondences; i++) {
-    h_inverse = h_inverse - normalized_feature_cross[i];
+    h_inverse = h_inverse - normalized_feature_cross(i);
   }
   const Matrix3d h_matrix = h_inverse.inverse();
 
   // Compute V*W*b with the rotation parameters factored out. This is the
   // translation parameterized by the 9 entries of the rotation matrix.
-  Matrix<double, 3, 9> translation_factor = Matrix<double, 3, 9>::Zero();
+  translation_factor->setZero();
   for (int i = 0; i < num_correspondences; i++) {
-    translation_factor = translation_factor +
-                         (normalized_feature_cross[i] - Matrix3d::Identity()) *
-                             LeftMultiplyMatrix(world_point[i]);
+    *translation_factor = *translation_factor +
+                          (normalized_feature_cross(i) - Matrix3d::Identity()) *
+                              LeftMultiplyMatrix(world_point[i]);
   }
 
-  translation_factor = h_matrix * translation_factor;
+  *translation_factor = h_matrix * (*translation_factor);
 
   // Compute the cost function J' of Eq. 17 in DLS paper. This is a factorized
   // version where the rotation matrix parameters have been pulled out. The
   // entries to this equation are the coefficients to the cost function which is
   // a quartic in the rotation parameters.
-  Matrix<double, 9, 9> ls_cost_coefficients = Matrix<double, 9, 9>::Zero();
+  ls_cost_coefficients->setZero();
   for (int i = 0; i < num_correspondences; i++) {
-    ls_cost_coefficients =
-        ls_cost_coefficients +
-        (LeftMultiplyMatrix(world_point[i]) + translation_factor).transpose() *
-            (Matrix3d::Identity() - normalized_feature_cross[i]) *
-            (LeftMultiplyMatrix(world_point[i]) + translation_factor);
+    *ls_cost_coefficients =
+        *ls_cost_coefficients +
+        (LeftMultiplyMatrix(world_point[i]) + *translation_factor).transpose() *
+            (Matrix3d::Identity() - normalized_feature_cross(i)) *
+            (LeftMultiplyMatrix(world_point[i]) + *translation_factor);
+  }
+}
+
+// Recovers the rotation and translation from the rotation parameters s1, s2,
+// s3. Returns false if the pose does not place all points in front of the
+// camera.
+bool RecoverPose(const double s1,
+                 const double s2,
+                 const double s3,
+                 const Matrix<double, 3, 9>& translation_factor,
+                 const Vector3d* world_point,
+                 const int num_correspondences,
+                 Quaterniond* solution_rotation,
+                 Vector3d* solution_translation) {
+  // Compute the rotation (which is the transpose rotation of our solution)
+  // and translation.
+  Quaterniond soln_rotation(1.0, s1, s2, s3);
+  soln_rotation = soln_rotation.inverse().normalized();
+
+  const Matrix3d rot_mat = soln_rotation.inverse().toRotationMatrix();
+  const Eigen::Map<const Matrix<double, 9, 1> > rot_vec(rot_mat.data());
+  const Vector3d soln_translation = translation_factor * rot_vec;
+
+  // TODO(cmsweeney): evaluate cost function and return it as an output
+  // variable.
+
+  // Check that all points are in front of the camera. Discard the solution
+  // if this is not the case.
+  for (int j = 0; j < num_correspondences; j++) {
+    const Vector3d transformed_point =
+        soln_rotation * world_point[j] + soln_translation;
+    if (transformed_point.z() < 0) {
+      return false;
+    }
   }
 
+  *solution_rotation = soln_rotation;
+  *solution_translation = soln_translation;
+  return true;
+}
+
+}  // namespace
+
+// This implementation is ported from the Matlab version provided by the authors
+// of "A Direct Least-Squares (DLS) Method for PnP". The general approach is to
+// first rewrite the reprojection constraint (i.e., cost function) such that all
+// unknowns appear linearly in terms of the rotation parameters (which are 3
+// parameters in the Cayley-Gibss-Rodriguez formulation). Then we create a
+// system of equations from the jacobian of the cost function, and solve these
+// equations via a Macaulay matrix to obtain the roots (i.e., the 3 parameters
+// of rotation). The translation can then be obtained through back-substitution.
+void DlsPnp(const std::vector<Vector2d>& feature_position,
+            const std::vector<Vector3d>& world_point,
+            std::vector<Quaterniond>* solution_rotation,
+            std::vector<Vector3d>* solution_translation) {
+  CHECK_GE(feature_position.size(), 3);
+  CHECK_EQ(feature_position.size(), world_point.size());
+
+  const int num_correspondences = feature_position.size();
+
+  Matrix<double, 3, 9> translation_factor;
+  Matrix<double, 9, 9> ls_cost_coefficients;
+  ComputeCostCoefficients(feature_position.data(),
+                          world_point.data(),
+                          num_correspondences,
+                          &translation_factor,
+                          &ls_cost_coefficients);
+
   // Extract the coefficients of the jacobian (Eq. 18) from the
   // ls_cost_coefficients matrix. The jacobian represent 3 monomials in the
   // rotation parameters. Each entry of the jacobian will be 0 at the roots of
@@ -168,31 +229,11 @@ void DlsPnp(const std::vector<Vector2d>& feature_position,
     const double kEpsilon = 1e-6;
     if (fabs(s1.imag()) < kEpsilon && fabs(s2.imag()) < kEpsilon &&
         fabs(s3.imag()) < kEpsilon) {
-      // Compute the rotation (which is the transpose rotation of our solution)
-      // and translation.
-      Quaterniond soln_rotation(1.0, s1.real(), s2.real(), s3.real());
-      soln_rotation = soln_rotation.inverse().normalized();
-
-      const Matrix3d rot_mat = soln_rotation.inverse().toRotationMatrix();
-      const Eigen::Map<const Matrix<double, 9, 1> > rot_vec(rot_mat.data());
-      const Vector3d soln_translation = translation_factor * rot_vec;
-
-      // TODO(cmsweeney): evaluate cost function and return it as an output
-      // variable.
-
-      // Check that all points are in front of the camera. Discard the solution
-      // if this is not the case.
-      bool all_points_in_front_of_camera = true;
-      for (int j = 0; j < num_correspondences; j++) {
-        const Vector3d transformed_point =
-            soln_rotation * world_point[j] + soln_translation;
-        if (transformed_point.z() < 0) {
-          all_points_in_front_of_camera = false;
-          break;
-        }
-      }
-
-      if (all_points_in_front_of_camera) {
+      Quaterniond soln_rotation;
+      Vector3d soln_translation;
+      if (RecoverPose(s1.real(), s2.real(), s3.real(), translation_factor,
+                      world_point.data(), num_correspondences, &soln_rotation,
+                      &soln_translation)) {
         solution_rotation->push_back(soln_rotation);
         solution_translation->push_back(soln_translation);
       }
@@ -200,4 +241,88 @@ void DlsPnp(const std::vector<Vector2d>& feature_position,
   }
 }
 
+int DlsPnpFixedSize(const Vector2d* feature_positions,
+                    const Vector3d* world_points,
+                    const int num_correspondences,
+                    Quaterniond solution_rotations[kMaxNumDlsPnpSolutions],
+                    Vector3d solution_translations[kMaxNumDlsPnpSolutions]) {
+  CHECK_GE(num_correspondences, 3);
+
+  Matrix<double, 3, 9> translation_factor;
+  Matrix<double, 9, 9> ls_cost_coefficients;
+  ComputeCostCoefficients(feature_positions,
+                          world_points,
+                          num_correspondences,
+                          &translation_factor,
+                          &ls_cost_coefficients);
+
+  double f1_coeff[20];
+  double f2_coeff[20];
+  double f3_coeff[20];
+  ExtractJacobianCoefficients(ls_cost_coefficients, f1_coeff, f2_coeff,
+                              f3_coeff);
+
+  const Eigen::Vector4d rand_vec = 100.0 * Eigen::Vector4d::Random();
+  const double macaulay_term[4] = {rand_vec(0),
+                                   rand_vec(1),
+                                   rand_vec(2),
+                                   rand_vec(3)};
+
+  // Eliminate the Macaulay matrix with the precomputed template. This yields
+  // the same multiplication matrix as the dense Schur complement in DlsPnp.
+  Matrix<double, 27, 27> solution_polynomial;
+  ComputeMultiplicationMatrix(f1_coeff, f2_coeff, f3_coeff, macaulay_term,
+                              &solution_polynomial);
+
+  // Only the eigenvectors of real eigenvalues correspond to real solutions,
+  // and there are typically only a few of them. Computing the eigenvalues
+  // alone and recovering those eigenvectors with inverse iteration is much
+  // cheaper than computing all 27 complex eigenvectors.
+  const Eigen::EigenSolver<Matrix<double, 27, 27> > eigen_solver(
+      solution_polynomial, false);
+  const auto& eigen_values = eigen_solver.eigenvalues();
+  int num_solutions = 0;
+  for (int i = 0; i < 27; i++) {
+    // Complex conjugate pairs with a tiny imaginary part are considered real
+    // as in DlsPnp, but only one of the two is kept.
+    const double kEpsilon = 1e-6;
+    if (fabs(eigen_values(i).imag()) >= kEpsilon ||
+        eigen_values(i).imag() < 0.0) {
+      continue;
+    }
+
+    // Shift the eigenvalue slightly so that the shifted matrix is not exactly
+    // singular.
+    const double kShift = 1e-10;
+    const double eigen_value = eigen_values(i).real() +
+                               kShift * std::max(1.0, fabs(eigen_values(i)));
+    Matrix<double, 27, 27> shifted_polynomial = solution_polynomial;
+    shifted_polynomial.diagonal().array() -= eigen_value;
+    const Eigen::PartialPivLU<Matrix<double, 27, 27> > lu(shifted_polynomial);
+    Matrix<double, 27, 1> eigen_vector = Matrix<double, 27, 1>::Ones();
+    const int kNumInverseIterations = 2;
+    for (int j = 0; j < kNumInverseIterations; j++) {
+      eigen_vector = lu.solve(eigen_vector);
+      eigen_vector.normalize();
+    }
+    if (!eigen_vector.allFinite() || eigen_vector(0) == 0.0) {
+      continue;
+    }
+
+    // The first entry of the eigenvector should equal 1 according to our
+    // polynomial, so we must divide each solution by the first entry.
+    if (RecoverPose(eigen_vector(9) / eigen_vector(0),
+                    eigen_vector(3) / eigen_vector(0),
+                    eigen_vector(1) / eigen_vector(0),
+                    translation_factor,
+                    world_points,
+                    num_correspondences,
+                    &solution_rotations[num_solutions],
+                    &solution_translations[num_solutions])) {
+      ++num_solutions;
+    }
+  }
+  return num_solutions;
+}
+
 }  // namespace theia
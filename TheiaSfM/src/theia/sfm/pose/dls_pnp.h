@@ -63,6 +63,23 @@ void DlsPnp(const std::vector<Eigen::Vector2d>& feature_positions,
             const std::vector<Eigen::Vector3d>& world_point,
             std::vector<Eigen::Quaterniond>* solution_rotation,
             std::vector<Eigen::Vector3d>* solution_translation);
+
+// The maximum number of solutions returned by DlsPnpFixedSize.
+static const int kMaxNumDlsPnpSolutions = 27;
+
+// An allocation-free variant of DlsPnp intended for use inside of RANSAC
+// loops. The multiplication matrix is computed from a precomputed elimination
+// template that exploits the block triangular structure of the Macaulay matrix
+// instead of factorizing the dense 93x93 block, and all intermediate values are
+// fixed-size. The solutions are written to the output arrays and the number of
+// solutions is returned.
+int DlsPnpFixedSize(
+    const Eigen::Vector2d* feature_positions,
+    const Eigen::Vector3d* world_points,
+    const int num_correspondences,
+    Eigen::Quaterniond solution_rotations[kMaxNumDlsPnpSolutions],
+    Eigen::Vector3d solution_translations[kMaxNumDlsPnpSolutions]);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_POSE_DLS_PNP_H_
@@ -0,0 +1,212 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "theia/math/util.h"
+#include "theia/sfm/pose/dls_pnp.h"
+#include "theia/sfm/pose/perspective_three_point.h"
+#include "theia/test/benchmark.h"
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+namespace {
+
+using Eigen::AngleAxisd;
+using Eigen::Matrix3d;
+using Eigen::Quaterniond;
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+
+static const int kNumProblems = 256;
+
+// Noise added to the normalized image coordinates, roughly 1 pixel for a
+// camera with a focal length of 1000 pixels.
+static const double kProjectionNoise = 1e-3;
+
+// An absolute pose problem with a known ground truth pose.
+struct PnPProblem {
+  Quaterniond rotation;
+  Vector3d translation;
+  std::vector<Vector2d> feature_positions;
+  std::vector<Vector3d> world_points;
+};
+
+// Generates random problems with noisy observations using a fixed seed so that
+// every run of the benchmark uses the same data.
+std::vector<PnPProblem> GeneratePnPProblems(const int num_points) {
+  RandomNumberGenerator rng(59);
+  std::vector<PnPProblem> problems(kNumProblems);
+  for (PnPProblem& problem : problems) {
+    problem.rotation = Quaterniond(AngleAxisd(
+        rng.RandDouble(-0.5, 0.5), rng.RandVector3d().normalized()));
+    problem.translation = rng.RandVector3d();
+    for (int i = 0; i < num_points; i++) {
+      const Vector3d camera_point(rng.RandDouble(-2.0, 2.0),
+                                  rng.RandDouble(-2.0, 2.0),
+                                  rng.RandDouble(4.0, 8.0));
+      problem.world_points.emplace_back(
+          problem.rotation.inverse() * (camera_point - problem.translation));
+      problem.feature_positions.emplace_back(
+          camera_point.hnormalized() +
+          kProjectionNoise * Vector2d(rng.RandGaussian(0.0, 1.0),
+                                      rng.RandGaussian(0.0, 1.0)));
+    }
+  }
+  return problems;
+}
+
+// Returns the angular distance in degrees between the ground truth rotation
+// and the closest of the candidate solutions.
+double MinRotationError(const Quaterniond& rotation,
+                        const Quaterniond* solutions,
+                        const int num_solutions) {
+  double min_error = std::numeric_limits<double>::max();
+  for (int i = 0; i < num_solutions; i++) {
+    min_error = std::min(min_error, rotation.angularDistance(solutions[i]));
+  }
+  return RadToDeg(min_error);
+}
+
+// Labels the benchmark with the median rotation error of the best solution
+// so that speed and accuracy may be compared at the same time.
+void SetAccuracyLabel(std::vector<double>* rotation_errors,
+                      benchmark::State* state) {
+  std::nth_element(rotation_errors->begin(),
+                   rotation_errors->begin() + rotation_errors->size() / 2,
+                   rotation_errors->end());
+  state->SetLabel(StringPrintf("median rotation error %.4f deg",
+                               (*rotation_errors)[rotation_errors->size() / 2]));
+}
+
+// The dynamically sized implementation that forms the dense Macaulay matrix.
+void BM_DlsPnp(benchmark::State& state) {
+  const std::vector<PnPProblem> problems = GeneratePnPProblems(state.range(0));
+  std::vector<double> rotation_errors;
+  for (const PnPProblem& problem : problems) {
+    std::vector<Quaterniond> rotations;
+    std::vector<Vector3d> translations;
+    DlsPnp(problem.feature_positions, problem.world_points, &rotations,
+           &translations);
+    rotation_errors.emplace_back(MinRotationError(
+        problem.rotation, rotations.data(), rotations.size()));
+  }
+
+  int i = 0;
+  while (state.KeepRunning()) {
+    const PnPProblem& problem = problems[i++ % kNumProblems];
+    std::vector<Quaterniond> rotations;
+    std::vector<Vector3d> translations;
+    DlsPnp(problem.feature_positions, problem.world_points, &rotations,
+           &translations);
+    benchmark::DoNotOptimize(rotations.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+  SetAccuracyLabel(&rotation_errors, &state);
+}
+BENCHMARK(BM_DlsPnp)->Arg(4)->Arg(10)->Arg(100);
+
+// The allocation-free implementation using the elimination template.
+void BM_DlsPnpFixedSize(benchmark::State& state) {
+  const std::vector<PnPProblem> problems = GeneratePnPProblems(state.range(0));
+  Quaterniond rotations[kMaxNumDlsPnpSolutions];
+  Vector3d translations[kMaxNumDlsPnpSolutions];
+  std::vector<double> rotation_errors;
+  for (const PnPProblem& problem : problems) {
+    const int num_solutions = DlsPnpFixedSize(problem.feature_positions.data(),
+                                              problem.world_points.data(),
+                                              problem.world_points.size(),
+                                              rotations,
+                                              translations);
+    rotation_errors.emplace_back(
+        MinRotationError(problem.rotation, rotations, num_solutions));
+  }
+
+  int i = 0;
+  while (state.KeepRunning()) {
+    const PnPProblem& problem = problems[i++ % kNumProblems];
+    const int num_solutions = DlsPnpFixedSize(problem.feature_positions.data(),
+                                              problem.world_points.data(),
+                                              problem.world_points.size(),
+                                              rotations,
+                                              translations);
+    benchmark::DoNotOptimize(num_solutions);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+  SetAccuracyLabel(&rotation_errors, &state);
+}
+BENCHMARK(BM_DlsPnpFixedSize)->Arg(4)->Arg(10)->Arg(100);
+
+// The minimal P3P solver, which is the usual choice inside of RANSAC. Only the
+// first three correspondences of each problem are used.
+void BM_PerspectiveThreePoint(benchmark::State& state) {
+  const std::vector<PnPProblem> problems = GeneratePnPProblems(3);
+  std::vector<double> rotation_errors;
+  for (const PnPProblem& problem : problems) {
+    std::vector<Matrix3d> rotations;
+    std::vector<Vector3d> translations;
+    PoseFromThreePoints(problem.feature_positions.data(),
+                        problem.world_points.data(),
+                        &rotations,
+                        &translations);
+    std::vector<Quaterniond> quaternions(rotations.begin(), rotations.end());
+    rotation_errors.emplace_back(MinRotationError(
+        problem.rotation, quaternions.data(), quaternions.size()));
+  }
+
+  int i = 0;
+  while (state.KeepRunning()) {
+    const PnPProblem& problem = problems[i++ % kNumProblems];
+    std::vector<Matrix3d> rotations;
+    std::vector<Vector3d> translations;
+    PoseFromThreePoints(problem.feature_positions.data(),
+                        problem.world_points.data(),
+                        &rotations,
+                        &translations);
+    benchmark::DoNotOptimize(rotations.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+  SetAccuracyLabel(&rotation_errors, &state);
+}
+BENCHMARK(BM_PerspectiveThreePoint);
+
+}  // namespace
+}  // namespace theia
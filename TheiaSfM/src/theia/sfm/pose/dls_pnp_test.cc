@@ -43,6 +43,7 @@
 #include "theia/math/util.h"
 #include "theia/util/random.h"
 #include "theia/util/util.h"
+#include "theia/sfm/pose/dls_impl.h"
 #include "theia/sfm/pose/dls_pnp.h"
 #include "theia/sfm/pose/test_util.h"
 #include "theia/sfm/types.h"
@@ -51,47 +52,28 @@ namespace theia {
 namespace {
 using Eigen::AngleAxisd;
 using Eigen::Map;
+using Eigen::Matrix;
 using Eigen::Matrix3d;
+using Eigen::MatrixXd;
 using Eigen::Quaterniond;
 using Eigen::Vector2d;
 using Eigen::Vector3d;
 
 RandomNumberGenerator rng(59);
 
-void TestDlsPnpWithNoise(const std::vector<Vector3d>& world_points,
-                         const double projection_noise_std_dev,
-                         const Quaterniond& expected_rotation,
-                         const Vector3d& expected_translation,
-                         const double max_reprojection_error,
-                         const double max_rotation_difference,
-                         const double max_translation_difference) {
+// Verifies that the solutions reproject the features accurately and that at
+// least one of them is close to the expected pose.
+void CheckSolutions(const std::vector<Vector3d>& world_points,
+                    const std::vector<Vector2d>& feature_points,
+                    const std::vector<Quaterniond>& soln_rotation,
+                    const std::vector<Vector3d>& soln_translation,
+                    const Quaterniond& expected_rotation,
+                    const Vector3d& expected_translation,
+                    const double max_reprojection_error,
+                    const double max_rotation_difference,
+                    const double max_translation_difference) {
   const int num_points = world_points.size();
 
-  Matrix3x4d expected_transform;
-  expected_transform << expected_rotation.toRotationMatrix(),
-      expected_translation;
-
-  std::vector<Vector2d> feature_points;
-  feature_points.reserve(num_points);
-  for (int i = 0; i < num_points; i++) {
-    // Reproject 3D points into camera frame.
-    feature_points.push_back(
-        (expected_transform * world_points[i].homogeneous())
-            .eval().hnormalized());
-  }
-
-  if (projection_noise_std_dev) {
-    // Adds noise to both of the rays.
-    for (int i = 0; i < num_points; i++) {
-      AddNoiseToProjection(projection_noise_std_dev, &rng, &feature_points[i]);
-    }
-  }
-
-  // Run DLS PnP.
-  std::vector<Quaterniond> soln_rotation;
-  std::vector<Vector3d> soln_translation;
-  DlsPnp(feature_points, world_points, &soln_rotation, &soln_translation);
-
   // Check solutions and verify at least one is close to the actual solution.
   const int num_solutions = soln_rotation.size();
   EXPECT_GT(num_solutions, 0);
@@ -127,6 +109,64 @@ void TestDlsPnpWithNoise(const std::vector<Vector3d>& world_points,
   EXPECT_TRUE(matched_transform);
 }
 
+void TestDlsPnpWithNoise(const std::vector<Vector3d>& world_points,
+                         const double projection_noise_std_dev,
+                         const Quaterniond& expected_rotation,
+                         const Vector3d& expected_translation,
+                         const double max_reprojection_error,
+                         const double max_rotation_difference,
+                         const double max_translation_difference) {
+  const int num_points = world_points.size();
+
+  Matrix3x4d expected_transform;
+  expected_transform << expected_rotation.toRotationMatrix(),
+      expected_translation;
+
+  std::vector<Vector2d> feature_points;
+  feature_points.reserve(num_points);
+  for (int i = 0; i < num_points; i++) {
+    // Reproject 3D points into camera frame.
+    feature_points.push_back(
+        (expected_transform * world_points[i].homogeneous())
+            .eval().hnormalized());
+  }
+
+  if (projection_noise_std_dev) {
+    // Adds noise to both of the rays.
+    for (int i = 0; i < num_points; i++) {
+      AddNoiseToProjection(projection_noise_std_dev, &rng, &feature_points[i]);
+    }
+  }
+
+  // Run DLS PnP.
+  std::vector<Quaterniond> soln_rotation;
+  std::vector<Vector3d> soln_translation;
+  DlsPnp(feature_points, world_points, &soln_rotation, &soln_translation);
+  CheckSolutions(world_points, feature_points, soln_rotation, soln_translation,
+                 expected_rotation, expected_translation,
+                 max_reprojection_error, max_rotation_difference,
+                 max_translation_difference);
+
+  // Run the allocation-free DLS PnP.
+  Quaterniond fixed_size_rotations[kMaxNumDlsPnpSolutions];
+  Vector3d fixed_size_translations[kMaxNumDlsPnpSolutions];
+  const int num_fixed_size_solutions = DlsPnpFixedSize(feature_points.data(),
+                                                       world_points.data(),
+                                                       num_points,
+                                                       fixed_size_rotations,
+                                                       fixed_size_translations);
+  CheckSolutions(world_points, feature_points,
+                 std::vector<Quaterniond>(
+                     fixed_size_rotations,
+                     fixed_size_rotations + num_fixed_size_solutions),
+                 std::vector<Vector3d>(
+                     fixed_size_translations,
+                     fixed_size_translations + num_fixed_size_solutions),
+                 expected_rotation, expected_translation,
+                 max_reprojection_error, max_rotation_difference,
+                 max_translation_difference);
+}
+
 void BasicTest() {
   const std::vector<Vector3d> points_3d = { Vector3d(-1.0, 3.0, 3.0),
                                             Vector3d(1.0, -1.0, 2.0),
@@ -324,5 +364,34 @@ TEST(DlsPnp, OrthogonalRotation) {
                       kMaxAllowedTranslationDifference);
 }
 
+TEST(DlsPnp, MultiplicationMatrixMatchesDenseSchurComplement) {
+  for (int trial = 0; trial < 10; trial++) {
+    double f1_coeff[20], f2_coeff[20], f3_coeff[20], macaulay_term[4];
+    for (int i = 0; i < 20; i++) {
+      f1_coeff[i] = rng.RandDouble(-1.0, 1.0);
+      f2_coeff[i] = rng.RandDouble(-1.0, 1.0);
+      f3_coeff[i] = rng.RandDouble(-1.0, 1.0);
+    }
+    for (int i = 0; i < 4; i++) {
+      macaulay_term[i] = rng.RandDouble(-100.0, 100.0);
+    }
+
+    const MatrixXd macaulay_matrix = dls_impl::CreateMacaulayMatrix(
+        f1_coeff, f2_coeff, f3_coeff, macaulay_term);
+    const MatrixXd expected_multiplication_matrix =
+        macaulay_matrix.block<27, 27>(0, 0) -
+        (macaulay_matrix.block<27, 93>(0, 27) *
+         macaulay_matrix.block<93, 93>(27, 27).partialPivLu().solve(
+             macaulay_matrix.block<93, 27>(27, 0)));
+
+    Matrix<double, 27, 27> multiplication_matrix;
+    dls_impl::ComputeMultiplicationMatrix(f1_coeff, f2_coeff, f3_coeff,
+                                          macaulay_term,
+                                          &multiplication_matrix);
+    EXPECT_LT((multiplication_matrix - expected_multiplication_matrix).norm(),
+              1e-8 * expected_multiplication_matrix.norm());
+  }
+}
+
 }  // namespace
 }  // namespace theia
@@ -39,7 +39,7 @@
 #include <vector>
 
 #include "theia/alignment/alignment.h"
-#include "theia/math/polynomial.h"
+#include "theia/math/find_polynomial_roots_fixed_degree.h"
 
 namespace theia {
 using Eigen::Matrix;
@@ -47,16 +47,15 @@ using Eigen::Map;
 using Eigen::Vector2d;
 using Eigen::Vector3d;
 using Eigen::Vector4d;
-using Eigen::VectorXd;
 
 namespace {
 // Helper function which takes in the null basis (three 8-dimension vectors)
 // which has two unknowns and solves for one of them using Sylvester matrix
 // computed from the orthonormal constraint on rows 1 and 2 of the projection
 // matrix. See Eq 10, 11 in the paper for details. This has been precomputed
-// with matlab for optimal runtime.
-void SetupAndSolveSylvesterMatrix(const Matrix<double, 8, 3>& n,
-                                  double* y1_soln, double* y2_soln) {
+// with matlab for optimal runtime. Returns the number of solutions.
+int SetupAndSolveSylvesterMatrix(const Matrix<double, 8, 3>& n,
+                                 double* y1_soln, double* y2_soln) {
   static const double kTolerance = 1e-12;
 
   // The Sylvester matrix will help us solve for one of the two unknown
@@ -101,13 +100,13 @@ void SetupAndSolveSylvesterMatrix(const Matrix<double, 8, 3>& n,
 
   // Setting the determinant of the Sylvester matrix to 0 will create a quartic
   // polynomial in y2. The roots of this polynomial are the solutions to y2.
-  VectorXd coeffs(5);
-  coeffs(0) =
+  double coeffs[5];
+  coeffs[0] =
       (s11_1 * s11_1) * (s23_3 * s23_3) + (s13_3 * s13_3) * (s21_1 * s21_1) +
       s11_1 * s13_3 * (s22_2 * s22_2) + (s12_2 * s12_2) * s21_1 * s23_3 -
       s11_1 * s12_2 * s22_2 * s23_3 - s11_1 * s13_3 * s21_1 * s23_3 * 2.0 -
       s12_2 * s13_3 * s21_1 * s22_2;
-  coeffs(1) =
+  coeffs[1] =
       s11_1 * s13_2 * (s22_2 * s22_2) + s13_2 * s13_3 * (s21_1 * s21_1) * 2.0 +
       (s12_2 * s12_2) * s21_1 * s23_2 + (s11_1 * s11_1) * s23_2 * s23_3 * 2.0 -
       s11_1 * s12_1 * s22_2 * s23_3 - s11_1 * s12_2 * s22_1 * s23_3 -
@@ -116,7 +115,7 @@ void SetupAndSolveSylvesterMatrix(const Matrix<double, 8, 3>& n,
       s11_1 * s13_3 * s22_1 * s22_2 * 2.0 +
       s12_1 * s12_2 * s21_1 * s23_3 * 2.0 - s12_1 * s13_3 * s21_1 * s22_2 -
       s12_2 * s13_2 * s21_1 * s22_2 - s12_2 * s13_3 * s21_1 * s22_1;
-  coeffs(2) =
+  coeffs[2] =
       (s11_1 * s11_1) * (s23_2 * s23_2) + (s13_2 * s13_2) * (s21_1 * s21_1) +
       s11_1 * s13_1 * (s22_2 * s22_2) + s11_1 * s13_3 * (s22_1 * s22_1) +
       s13_1 * s13_3 * (s21_1 * s21_1) * 2.0 + (s12_2 * s12_2) * s21_1 * s23_1 +
@@ -130,7 +129,7 @@ void SetupAndSolveSylvesterMatrix(const Matrix<double, 8, 3>& n,
       s12_1 * s12_2 * s21_1 * s23_2 * 2.0 - s12_1 * s13_2 * s21_1 * s22_2 -
       s12_1 * s13_3 * s21_1 * s22_1 - s12_2 * s13_1 * s21_1 * s22_2 -
       s12_2 * s13_2 * s21_1 * s22_1;
-  coeffs(3) =
+  coeffs[3] =
       s11_1 * s13_2 * (s22_1 * s22_1) + s13_1 * s13_2 * (s21_1 * s21_1) * 2.0 +
       (s12_1 * s12_1) * s21_1 * s23_2 + (s11_1 * s11_1) * s23_1 * s23_2 * 2.0 -
       s11_1 * s12_1 * s22_1 * s23_2 - s11_1 * s12_1 * s22_2 * s23_1 -
@@ -139,19 +138,18 @@ void SetupAndSolveSylvesterMatrix(const Matrix<double, 8, 3>& n,
       s11_1 * s13_2 * s21_1 * s23_1 * 2.0 +
       s12_1 * s12_2 * s21_1 * s23_1 * 2.0 - s12_1 * s13_1 * s21_1 * s22_2 -
       s12_1 * s13_2 * s21_1 * s22_1 - s12_2 * s13_1 * s21_1 * s22_1;
-  coeffs(4) =
+  coeffs[4] =
       (s11_1 * s11_1) * (s23_1 * s23_1) + (s13_1 * s13_1) * (s21_1 * s21_1) +
       s11_1 * s13_1 * (s22_1 * s22_1) + (s12_1 * s12_1) * s21_1 * s23_1 -
       s11_1 * s12_1 * s22_1 * s23_1 - s11_1 * s13_1 * s21_1 * s23_1 * 2.0 -
       s12_1 * s13_1 * s21_1 * s22_1;
 
   // Solve Quartic
-  VectorXd roots;
-  CHECK(FindPolynomialRoots(coeffs, &roots, NULL))
-      << "Quartic could not be solved for p5pfr.";
+  double roots[4];
+  const int num_roots = FindPolynomialRootsFixedDegree<4>(coeffs, roots, NULL);
 
   // Solve for y1 by substituting y2 solutions back into Eq 10, 11.
-  for (int i = 0; i < 4; i++) {
+  for (int i = 0; i < num_roots; i++) {
     // Substituting solutions for y2 yields a linear equation of the form
     // ax + b = 0.
     double a = (s22_2 - (s12_2 * s21_1) / s11_1) * roots[i] + s22_1 -
@@ -174,6 +172,7 @@ void SetupAndSolveSylvesterMatrix(const Matrix<double, 8, 3>& n,
     y1_soln[i] = -b / a;
     y2_soln[i] = roots[i];
   }
+  return num_roots;
 }
 }  // namespace
 
@@ -204,10 +203,11 @@ bool FivePointFocalLengthRadialDistortion(
   // Create Sylvester matrix and solve for one of the unknowns.
   double y1_solution[4];
   double y2_solution[4];
-  SetupAndSolveSylvesterMatrix(projrow12_basis, y1_solution, y2_solution);
+  const int num_solutions =
+      SetupAndSolveSylvesterMatrix(projrow12_basis, y1_solution, y2_solution);
 
   // Loop over all possible value of y1, y2.
-  for (int i = 0; i < 4; i++) {
+  for (int i = 0; i < num_solutions; i++) {
     // y1 and y2 specify a candidate solution to the first two rows of the
     // projection matrix (up to scale). Set those rows here.
     Matrix<double, 3, 4, Eigen::RowMajor> candidate_proj =
@@ -37,10 +37,12 @@
 #include <Eigen/Dense>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <cmath>
 #include <ctime>
 #include <vector>
 
+#include "theia/math/find_polynomial_roots_sturm.h"
 #include "theia/math/polynomial.h"
 #include "theia/sfm/pose/util.h"
 
@@ -205,6 +207,176 @@ Matrix<double, 10, 20> BuildConstraintMatrix(
   return constraint_matrix;
 }
 
+// Builds the 10x20 constraint matrix directly from the 9x4 null space basis.
+Matrix<double, 10, 20> BuildConstraintMatrix(
+    const Matrix<double, 9, 4>& null_space) {
+  const Matrix<double, 1, 4> null_space_matrix[3][3] = {
+    { null_space.row(0), null_space.row(3), null_space.row(6) },
+    { null_space.row(1), null_space.row(4), null_space.row(7) },
+    { null_space.row(2), null_space.row(5), null_space.row(8) }
+  };
+  return BuildConstraintMatrix(null_space_matrix);
+}
+
+// The row of the epipolar constraint q'_t*E*q = 0 where q is from the first
+// image and q' is from the second.
+Matrix<double, 1, 9> EpipolarConstraint(const Vector2d& image1_point,
+                                        const Vector2d& image2_point) {
+  Matrix<double, 1, 9> constraint;
+  constraint <<
+      image2_point.x() * image1_point.x(),
+      image2_point.y() * image1_point.x(),
+      image1_point.x(),
+      image2_point.x() * image1_point.y(),
+      image2_point.y() * image1_point.y(),
+      image1_point.y(),
+      image2_point.x(),
+      image2_point.y(),
+      1.0;
+  return constraint;
+}
+
+// Column permutation from the GrevLex order of the constraint matrix to the
+// monomial order used by Nister:
+//   x^3 y^3 x^2y xy^2 x^2z x^2 y^2z y^2 xyz xy | xz^2 xz x yz^2 yz y z^3 z^2 z 1
+// After Gauss-Jordan elimination of the first 10 columns, the rows for x^2z,
+// x^2, y^2z, y^2, xyz and xy may be combined to eliminate x and y.
+static const int kNisterMonomialOrder[20] = {
+  0, 3, 1, 2, 4, 10, 6, 12, 5, 11, 7, 13, 16, 8, 14, 17, 9, 15, 18, 19
+};
+
+// Multiplies two polynomials given in decreasing degree order.
+template <int kDegree1, int kDegree2>
+void MultiplyFixedPolynomials(const double* poly1,
+                              const double* poly2,
+                              double* product) {
+  std::fill(product, product + kDegree1 + kDegree2 + 1, 0.0);
+  for (int i = 0; i <= kDegree1; ++i) {
+    for (int j = 0; j <= kDegree2; ++j) {
+      product[i + j] += poly1[i] * poly2[j];
+    }
+  }
+}
+
+// Evaluates a polynomial given in decreasing degree order.
+template <int kDegree>
+double EvaluateFixedPolynomial(const double* polynomial, const double x) {
+  double value = polynomial[0];
+  for (int i = 1; i <= kDegree; ++i) {
+    value = value * x + polynomial[i];
+  }
+  return value;
+}
+
+// The 3x3 matrix B(z) such that B(z) * [x y 1]^T = 0 at every solution. The x
+// and y columns are cubic in z and the last column is quartic in z. All
+// polynomials are stored in decreasing degree order.
+struct NisterBMatrix {
+  double xy[3][2][4];
+  double constant[3][5];
+};
+
+// Forms one row of B(z) from the Gauss-Jordan reduced rows that correspond to
+// the monomials m * z and m, i.e. row(m * z) - z * row(m).
+void ComputeBMatrixRow(const Matrix10d& reduced,
+                       const int mz_row,
+                       const int m_row,
+                       double xy[2][4],
+                       double constant[5]) {
+  for (int k = 0; k < 2; ++k) {
+    const int c = 3 * k;
+    xy[k][0] = -reduced(m_row, c);
+    xy[k][1] = reduced(mz_row, c) - reduced(m_row, c + 1);
+    xy[k][2] = reduced(mz_row, c + 1) - reduced(m_row, c + 2);
+    xy[k][3] = reduced(mz_row, c + 2);
+  }
+  constant[0] = -reduced(m_row, 6);
+  constant[1] = reduced(mz_row, 6) - reduced(m_row, 7);
+  constant[2] = reduced(mz_row, 7) - reduced(m_row, 8);
+  constant[3] = reduced(mz_row, 8) - reduced(m_row, 9);
+  constant[4] = reduced(mz_row, 9);
+}
+
+// Computes the determinant of B(z), a degree 10 polynomial in z.
+void ComputeBMatrixDeterminant(const NisterBMatrix& b, double determinant[11]) {
+  // Cofactors of the constant column are degree 6 polynomials.
+  double cofactors[3][7];
+  for (int i = 0; i < 3; ++i) {
+    const int r1 = (i + 1) % 3;
+    const int r2 = (i + 2) % 3;
+    double lhs[7], rhs[7];
+    MultiplyFixedPolynomials<3, 3>(b.xy[r1][0], b.xy[r2][1], lhs);
+    MultiplyFixedPolynomials<3, 3>(b.xy[r1][1], b.xy[r2][0], rhs);
+    for (int j = 0; j < 7; ++j) {
+      cofactors[i][j] = lhs[j] - rhs[j];
+    }
+  }
+
+  std::fill(determinant, determinant + 11, 0.0);
+  for (int i = 0; i < 3; ++i) {
+    double term[11];
+    MultiplyFixedPolynomials<6, 4>(cofactors[i], b.constant[i], term);
+    for (int j = 0; j < 11; ++j) {
+      determinant[j] += term[j];
+    }
+  }
+}
+
+// Recovers x and y for a root z of the determinant of B(z) by intersecting two
+// rows of B(z). The pair of rows with the best conditioned intersection is
+// used. Returns false if x and y cannot be recovered.
+bool RecoverXYFromBMatrix(const NisterBMatrix& b,
+                          const double z,
+                          double* x,
+                          double* y) {
+  Matrix3d b_at_z;
+  for (int i = 0; i < 3; ++i) {
+    b_at_z(i, 0) = EvaluateFixedPolynomial<3>(b.xy[i][0], z);
+    b_at_z(i, 1) = EvaluateFixedPolynomial<3>(b.xy[i][1], z);
+    b_at_z(i, 2) = EvaluateFixedPolynomial<4>(b.constant[i], z);
+  }
+
+  Vector3d best_xy1 = b_at_z.row(0).cross(b_at_z.row(1));
+  for (int i = 1; i < 3; ++i) {
+    const Vector3d xy1 = b_at_z.row(i).cross(b_at_z.row((i + 1) % 3));
+    if (std::abs(xy1.z()) > std::abs(best_xy1.z())) {
+      best_xy1 = xy1;
+    }
+  }
+
+  if (best_xy1.z() == 0.0) {
+    return false;
+  }
+  *x = best_xy1.x() / best_xy1.z();
+  *y = best_xy1.y() / best_xy1.z();
+  return true;
+}
+
+// Finds the real roots of the degree 10 polynomial with the fixed-size
+// companion matrix.
+int FindRealRootsCompanionMatrix(const double polynomial[11],
+                                 double roots[10]) {
+  if (polynomial[0] == 0.0) {
+    return 0;
+  }
+
+  Matrix10d companion_matrix = Matrix10d::Zero();
+  companion_matrix.block<9, 9>(1, 0).setIdentity();
+  for (int i = 0; i < 10; ++i) {
+    companion_matrix(0, i) = -polynomial[i + 1] / polynomial[0];
+  }
+
+  const Eigen::EigenSolver<Matrix10d> eigensolver(companion_matrix, false);
+  const auto& eigenvalues = eigensolver.eigenvalues();
+  int num_roots = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (eigenvalues(i).imag() == 0) {
+      roots[num_roots++] = eigenvalues(i).real();
+    }
+  }
+  return num_roots;
+}
+
 }  // namespace
 
 // Implementation of Nister from "An Efficient Solution to the Five-Point
@@ -217,51 +389,40 @@ bool FivePointRelativePose(const std::vector<Vector2d>& image1_points,
                                        "correspondences for the 5 point "
                                        "essential matrix algorithm.";
 
-  // Step 1. Create the nx9 matrix containing epipolar constraints.
+  // Step 1. Extract the null space of the nx9 epipolar constraint matrix.
   //   Essential matrix is a linear combination of the 4 vectors spanning the
-  //   null space of this matrix.
-  MatrixXd epipolar_constraint(image1_points.size(), 9);
-  for (int i = 0; i < image1_points.size(); i++) {
-    // Fill matrix with the epipolar constraint from q'_t*E*q = 0. Where q is
-    // from the first image, and q' is from the second.
-    epipolar_constraint.row(i) <<
-        image2_points[i].x() * image1_points[i].x(),
-        image2_points[i].y() * image1_points[i].x(),
-        image1_points[i].x(),
-        image2_points[i].x() * image1_points[i].y(),
-        image2_points[i].y() * image1_points[i].y(),
-        image1_points[i].y(),
-        image2_points[i].x(),
-        image2_points[i].y(),
-        1.0;
-  }
-
+  //   null space of this matrix. The null space is computed from a minimal
+  //   sampling (using LU) or non-minimal sampling (using SVD).
   Matrix<double, 9, 4> null_space;
-
-  // Extract the null space from a minimal sampling (using LU) or non-minimal
-  // sampling (using SVD).
   if (image1_points.size() == 5) {
-    const Eigen::FullPivLU<MatrixXd> lu(epipolar_constraint);
+    Matrix<double, 5, 9> epipolar_constraint;
+    for (int i = 0; i < 5; i++) {
+      epipolar_constraint.row(i) =
+          EpipolarConstraint(image1_points[i], image2_points[i]);
+    }
+
+    const Eigen::FullPivLU<Matrix<double, 5, 9> > lu(epipolar_constraint);
     if (lu.dimensionOfKernel() != 4) {
       return false;
     }
     null_space = lu.kernel();
   } else {
-    const Eigen::JacobiSVD<MatrixXd> svd(
-        epipolar_constraint.transpose() * epipolar_constraint,
-        Eigen::ComputeFullV);
+    // Accumulate the normal equations directly so that the size of the
+    // decomposition does not depend on the number of correspondences.
+    Matrix<double, 9, 9> normal_matrix = Matrix<double, 9, 9>::Zero();
+    for (int i = 0; i < image1_points.size(); i++) {
+      const Matrix<double, 1, 9> constraint =
+          EpipolarConstraint(image1_points[i], image2_points[i]);
+      normal_matrix.noalias() += constraint.transpose() * constraint;
+    }
+    const Eigen::JacobiSVD<Matrix<double, 9, 9> > svd(normal_matrix,
+                                                      Eigen::ComputeFullV);
     null_space = svd.matrixV().rightCols<4>();
   }
 
-  const Matrix<double, 1, 4> null_space_matrix[3][3] = {
-    { null_space.row(0), null_space.row(3), null_space.row(6) },
-    { null_space.row(1), null_space.row(4), null_space.row(7) },
-    { null_space.row(2), null_space.row(5), null_space.row(8) }
-  };
-
   // Step 2. Expansion of the epipolar constraints on the determinant and trace.
   const Matrix<double, 10, 20> constraint_matrix =
-      BuildConstraintMatrix(null_space_matrix);
+      BuildConstraintMatrix(null_space);
 
   // Step 3. Eliminate part of the matrix to isolate polynomials in z.
   Eigen::FullPivLU<Matrix10d> c_lu(constraint_matrix.block<10, 10>(0, 0));
@@ -298,4 +459,76 @@ bool FivePointRelativePose(const std::vector<Vector2d>& image1_points,
   return essential_matrices->size() > 0;
 }
 
+int FivePointRelativePoseMinimal(
+    const Vector2d image1_points[5],
+    const Vector2d image2_points[5],
+    Matrix3d essential_matrices[kMaxNumFivePointSolutions],
+    const FivePointPolynomialSolver polynomial_solver) {
+  // Step 1. The null space of the 5x9 epipolar constraint matrix is spanned by
+  //   the last 4 columns of Q in the QR decomposition of its transpose.
+  Matrix<double, 9, 5> epipolar_constraint_transpose;
+  for (int i = 0; i < 5; i++) {
+    epipolar_constraint_transpose.col(i) =
+        EpipolarConstraint(image1_points[i], image2_points[i]).transpose();
+  }
+  const Eigen::ColPivHouseholderQR<Matrix<double, 9, 5> > qr(
+      epipolar_constraint_transpose);
+  if (qr.rank() != 5) {
+    return 0;
+  }
+  const Matrix<double, 9, 9> q = qr.householderQ();
+  const Matrix<double, 9, 4> null_space = q.rightCols<4>();
+
+  // Step 2. Expansion of the epipolar constraints on the determinant and trace,
+  //   with the columns reordered for Nister's elimination.
+  const Matrix<double, 10, 20> grevlex_constraint_matrix =
+      BuildConstraintMatrix(null_space);
+  Matrix<double, 10, 20> constraint_matrix;
+  for (int i = 0; i < 20; i++) {
+    constraint_matrix.col(i) =
+        grevlex_constraint_matrix.col(kNisterMonomialOrder[i]);
+  }
+
+  // Step 3. Gauss-Jordan elimination of the first 10 monomials.
+  const Eigen::PartialPivLU<Matrix10d> lu(
+      constraint_matrix.block<10, 10>(0, 0));
+  const Matrix10d reduced = lu.solve(constraint_matrix.block<10, 10>(0, 10));
+
+  // Step 4. Eliminate x and y to obtain the 3x3 polynomial matrix B(z) and its
+  //   degree 10 determinant.
+  NisterBMatrix b;
+  ComputeBMatrixRow(reduced, 4, 5, b.xy[0], b.constant[0]);
+  ComputeBMatrixRow(reduced, 6, 7, b.xy[1], b.constant[1]);
+  ComputeBMatrixRow(reduced, 8, 9, b.xy[2], b.constant[2]);
+  double determinant[11];
+  ComputeBMatrixDeterminant(b, determinant);
+
+  // Step 5. Find the real roots z of the determinant.
+  double roots[10];
+  int num_roots = 0;
+  if (polynomial_solver == FivePointPolynomialSolver::STURM_SEQUENCE) {
+    num_roots = FindRealPolynomialRootsSturm<10>(determinant, roots);
+  } else {
+    num_roots = FindRealRootsCompanionMatrix(determinant, roots);
+  }
+
+  // Step 6. Back-substitute x, y and z into the null space to form the
+  //   essential matrices.
+  int num_solutions = 0;
+  for (int i = 0; i < num_roots; i++) {
+    const double z = roots[i];
+    double x, y;
+    if (!RecoverXYFromBMatrix(b, z, &x, &y)) {
+      continue;
+    }
+
+    Map<Matrix<double, 9, 1> >(essential_matrices[num_solutions].data()) =
+        null_space * Vector4d(x, y, z, 1.0);
+    essential_matrices[num_solutions].normalize();
+    ++num_solutions;
+  }
+
+  return num_solutions;
+}
+
 }  // namespace theia
@@ -60,6 +60,38 @@ namespace theia {
 bool FivePointRelativePose(const std::vector<Eigen::Vector2d>& image1_points,
                            const std::vector<Eigen::Vector2d>& image2_points,
                            std::vector<Eigen::Matrix3d>* essential_matrices);
+
+// The method used to find the roots of the degree 10 polynomial in the
+// minimal five point solver.
+enum class FivePointPolynomialSolver {
+  // Isolates the real roots with a Sturm sequence and refines them with a
+  // safeguarded Newton iteration. This is typically the fastest option.
+  STURM_SEQUENCE = 0,
+
+  // Computes the eigenvalues of the (fixed-size) companion matrix.
+  COMPANION_MATRIX = 1,
+};
+
+// The maximum number of essential matrices returned by the minimal solver.
+static const int kMaxNumFivePointSolutions = 10;
+
+// Minimal five point solver that uses only fixed-size types and performs no
+// heap allocation, intended for use inside of RANSAC loops. The null space of
+// the 5x9 epipolar constraint matrix is computed with a fixed-size QR
+// decomposition and the remaining constraints are reduced to a single degree 10
+// polynomial in z as described in "D. Nistér. An Efficient Solution to the
+// Five-Point Relative Pose Problem". PAMI, 2004.
+//
+// Up to kMaxNumFivePointSolutions essential matrices are written to the caller
+// provided array and the number of solutions is returned. Zero is returned if
+// the correspondences are degenerate.
+int FivePointRelativePoseMinimal(
+    const Eigen::Vector2d image1_points[5],
+    const Eigen::Vector2d image2_points[5],
+    Eigen::Matrix3d essential_matrices[kMaxNumFivePointSolutions],
+    const FivePointPolynomialSolver polynomial_solver =
+        FivePointPolynomialSolver::STURM_SEQUENCE);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_POSE_FIVE_POINT_RELATIVE_POSE_H_
@@ -0,0 +1,131 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <vector>
+
+#include "theia/alignment/alignment.h"
+#include "theia/sfm/pose/five_point_relative_pose.h"
+#include "theia/test/benchmark.h"
+#include "theia/util/random.h"
+
+namespace theia {
+namespace {
+
+using Eigen::AngleAxisd;
+using Eigen::Matrix3d;
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+
+static const int kNumProblems = 1024;
+
+// A minimal five point problem with image points in both views.
+struct FivePointProblem {
+  Vector2d image1_points[5];
+  Vector2d image2_points[5];
+};
+
+// Generates random, noise-free problems with a fixed seed so that every run of
+// the benchmark uses the same data.
+std::vector<FivePointProblem> GenerateFivePointProblems() {
+  RandomNumberGenerator rng(59);
+  std::vector<FivePointProblem> problems(kNumProblems);
+  for (FivePointProblem& problem : problems) {
+    const Matrix3d rotation =
+        AngleAxisd(rng.RandDouble(-0.5, 0.5), rng.RandVector3d().normalized())
+            .toRotationMatrix();
+    const Vector3d translation = rng.RandVector3d().normalized();
+    for (int i = 0; i < 5; i++) {
+      const Vector3d point(rng.RandDouble(-2.0, 2.0),
+                           rng.RandDouble(-2.0, 2.0),
+                           rng.RandDouble(4.0, 8.0));
+      problem.image1_points[i] = point.hnormalized();
+      problem.image2_points[i] = (rotation * point + translation).hnormalized();
+    }
+  }
+  return problems;
+}
+
+// The dynamically sized implementation that returns solutions in a vector.
+void BM_FivePointRelativePose(benchmark::State& state) {
+  const std::vector<FivePointProblem> problems = GenerateFivePointProblems();
+  int i = 0;
+  while (state.KeepRunning()) {
+    const FivePointProblem& problem = problems[i++ % kNumProblems];
+    const std::vector<Vector2d> image1_points(problem.image1_points,
+                                              problem.image1_points + 5);
+    const std::vector<Vector2d> image2_points(problem.image2_points,
+                                              problem.image2_points + 5);
+    std::vector<Matrix3d> essential_matrices;
+    FivePointRelativePose(image1_points, image2_points, &essential_matrices);
+    benchmark::DoNotOptimize(essential_matrices.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FivePointRelativePose);
+
+void RunFivePointRelativePoseMinimal(
+    const FivePointPolynomialSolver polynomial_solver,
+    benchmark::State* state) {
+  const std::vector<FivePointProblem> problems = GenerateFivePointProblems();
+  Matrix3d essential_matrices[kMaxNumFivePointSolutions];
+  int i = 0;
+  while (state->KeepRunning()) {
+    const FivePointProblem& problem = problems[i++ % kNumProblems];
+    const int num_solutions =
+        FivePointRelativePoseMinimal(problem.image1_points,
+                                     problem.image2_points,
+                                     essential_matrices,
+                                     polynomial_solver);
+    benchmark::DoNotOptimize(num_solutions);
+    benchmark::ClobberMemory();
+  }
+  state->SetItemsProcessed(state->iterations());
+}
+
+void BM_FivePointRelativePoseMinimalSturm(benchmark::State& state) {
+  RunFivePointRelativePoseMinimal(FivePointPolynomialSolver::STURM_SEQUENCE,
+                                  &state);
+}
+BENCHMARK(BM_FivePointRelativePoseMinimalSturm);
+
+void BM_FivePointRelativePoseMinimalCompanion(benchmark::State& state) {
+  RunFivePointRelativePoseMinimal(FivePointPolynomialSolver::COMPANION_MATRIX,
+                                  &state);
+}
+BENCHMARK(BM_FivePointRelativePoseMinimalCompanion);
+
+}  // namespace
+}  // namespace theia
@@ -112,6 +112,59 @@ void TestFivePointResultWithNoise(const std::vector<Vector3d> points_3d,
   EXPECT_TRUE(matched_transform);
 }
 
+// Same as above but for the allocation-free minimal solver with each of the
+// polynomial solvers.
+void TestFivePointMinimalResultWithNoise(
+    const std::vector<Vector3d> points_3d,
+    const double projection_noise_std_dev,
+    const Matrix3d& expected_rotation,
+    const Vector3d& expected_translation,
+    const double ematrix_tolerance) {
+  CHECK_EQ(points_3d.size(), 5);
+  Vector2d view_one_points[5];
+  Vector2d view_two_points[5];
+  for (int i = 0; i < 5; ++i) {
+    const Vector3d proj_3d =
+        expected_rotation * points_3d[i] + expected_translation;
+    view_one_points[i] = points_3d[i].hnormalized();
+    view_two_points[i] = proj_3d.hnormalized();
+    if (projection_noise_std_dev) {
+      AddNoiseToProjection(projection_noise_std_dev, &rng, &view_one_points[i]);
+      AddNoiseToProjection(projection_noise_std_dev, &rng, &view_two_points[i]);
+    }
+  }
+
+  const Matrix3d gt_ematrix =
+      CrossProductMatrix(expected_translation) * expected_rotation;
+  const FivePointPolynomialSolver polynomial_solvers[2] = {
+    FivePointPolynomialSolver::STURM_SEQUENCE,
+    FivePointPolynomialSolver::COMPANION_MATRIX
+  };
+  for (const FivePointPolynomialSolver polynomial_solver : polynomial_solvers) {
+    Matrix3d soln_ematrices[kMaxNumFivePointSolutions];
+    const int num_solutions = FivePointRelativePoseMinimal(view_one_points,
+                                                           view_two_points,
+                                                           soln_ematrices,
+                                                           polynomial_solver);
+    EXPECT_GT(num_solutions, 0);
+
+    bool matched_transform = false;
+    for (int n = 0; n < num_solutions; ++n) {
+      for (int i = 0; i < 5; i++) {
+        EXPECT_LT(SquaredSampsonDistance(soln_ematrices[n],
+                                         view_one_points[i],
+                                         view_two_points[i]),
+                  1e-8);
+      }
+      if (test::ArraysEqualUpToScale(9, soln_ematrices[n].data(),
+                                     gt_ematrix.data(), ematrix_tolerance)) {
+        matched_transform = true;
+      }
+    }
+    EXPECT_TRUE(matched_transform);
+  }
+}
+
 TEST(FivePointRelativePose, BasicMinimal) {
   // Ground truth essential matrix.
   const std::vector<Vector3d> points_3d = { Vector3d(-1.0, 3.0, 3.0),
@@ -272,5 +325,99 @@ TEST(FivePointRelativePose, NoRotationNonminimal) {
                                kEMatrixTolerance);
 }
 
+TEST(FivePointRelativePose, BasicMinimalFixedSize) {
+  const std::vector<Vector3d> points_3d = { Vector3d(-1.0, 3.0, 3.0),
+                                            Vector3d(1.0, -1.0, 2.0),
+                                            Vector3d(3.0, 1.0, 2.5),
+                                            Vector3d(-1.0, 1.0, 2.0),
+                                            Vector3d(2.0, 1.0, 3.0) };
+  const Matrix3d soln_rotation = Quaterniond(
+      AngleAxisd(DegToRad(13.0), Vector3d(0.0, 0.0, 1.0))).toRotationMatrix();
+  const Vector3d soln_translation(1.0, 1.0, 1.0);
+  const double kNoise = 0.0 / 512.0;
+  const double kEMatrixTolerance = 1e-4;
+  TestFivePointMinimalResultWithNoise(points_3d,
+                                      kNoise,
+                                      soln_rotation,
+                                      soln_translation,
+                                      kEMatrixTolerance);
+}
+
+TEST(FivePointRelativePose, NoiseTestMinimalFixedSize) {
+  const std::vector<Vector3d> points_3d = { Vector3d(-1.0, 3.0, 3.0),
+                                            Vector3d(1.0, -1.0, 2.0),
+                                            Vector3d(3.0, 1.0, 2.5),
+                                            Vector3d(-1.0, 1.0, 2.0),
+                                            Vector3d(2.0, 1.0, 3.0) };
+  const Matrix3d soln_rotation = Quaterniond(
+      AngleAxisd(DegToRad(13.0), Vector3d(0.0, 0.0, 1.0))).toRotationMatrix();
+  const Vector3d soln_translation(1.0, 1.0, 1.0);
+  const double kNoise = 1.0 / 512.0;
+  const double kEMatrixTolerance = 1e-2;
+  TestFivePointMinimalResultWithNoise(points_3d,
+                                      kNoise,
+                                      soln_rotation,
+                                      soln_translation,
+                                      kEMatrixTolerance);
+}
+
+TEST(FivePointRelativePose, ForwardMotionMinimalFixedSize) {
+  const std::vector<Vector3d> points_3d = { Vector3d(-1.0, 3.0, 3.0),
+                                            Vector3d(1.0, -1.0, 2.0),
+                                            Vector3d(3.0, 1.0, 2.0),
+                                            Vector3d(-1.0, 1.0, 2.0),
+                                            Vector3d(2.0, 1.0, 3.0) };
+  const Matrix3d soln_rotation = Quaterniond(
+      AngleAxisd(DegToRad(13.0), Vector3d(0.0, 0.0, 1.0))).toRotationMatrix();
+  const Vector3d soln_translation(0.0, 0.0, 1.0);
+  const double kNoise = 1.0 / 512.0;
+  const double kEMatrixTolerance = 0.15;
+  TestFivePointMinimalResultWithNoise(points_3d,
+                                      kNoise,
+                                      soln_rotation,
+                                      soln_translation,
+                                      kEMatrixTolerance);
+}
+
+TEST(FivePointRelativePose, NoRotationMinimalFixedSize) {
+  const std::vector<Vector3d> points_3d = { Vector3d(-1.0, 3.0, 3.0),
+                                            Vector3d(1.0, -1.0, 2.0),
+                                            Vector3d(3.0, 1.0, 2.0),
+                                            Vector3d(-1.0, 1.0, 2.0),
+                                            Vector3d(2.0, 1.0, 3.0) };
+  const Matrix3d soln_rotation = Matrix3d::Identity();
+  const Vector3d soln_translation(1.0, 1.0, 1.0);
+  const double kNoise = 1.0 / 512.0;
+  const double kEMatrixTolerance = 0.01;
+  TestFivePointMinimalResultWithNoise(points_3d,
+                                      kNoise,
+                                      soln_rotation,
+                                      soln_translation,
+                                      kEMatrixTolerance);
+}
+
+TEST(FivePointRelativePose, RandomMinimalFixedSize) {
+  static const int kNumTrials = 100;
+  for (int i = 0; i < kNumTrials; ++i) {
+    std::vector<Vector3d> points_3d(5);
+    for (int j = 0; j < 5; ++j) {
+      points_3d[j] = Vector3d(rng.RandDouble(-2.0, 2.0),
+                              rng.RandDouble(-2.0, 2.0),
+                              rng.RandDouble(2.0, 6.0));
+    }
+    const Matrix3d soln_rotation = Quaterniond(
+        AngleAxisd(DegToRad(rng.RandDouble(-30.0, 30.0)),
+                   rng.RandVector3d().normalized())).toRotationMatrix();
+    const Vector3d soln_translation = rng.RandVector3d();
+    const double kNoise = 0.0;
+    const double kEMatrixTolerance = 1e-4;
+    TestFivePointMinimalResultWithNoise(points_3d,
+                                        kNoise,
+                                        soln_rotation,
+                                        soln_translation,
+                                        kEMatrixTolerance);
+  }
+}
+
 }  // namespace
 }  // namespace theia
@@ -0,0 +1,193 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include "theia/sfm/position_priors.h"
+
+#include <ceres/rotation.h>
+#include <Eigen/Core>
+#include <Eigen/SVD>
+#include <glog/logging.h>
+#include <limits>
+#include <unordered_map>
+
+#include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/gps_converter.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/map_util.h"
+
+namespace theia {
+
+namespace {
+
+bool HasGPSPrior(const CameraIntrinsicsPrior& prior) {
+  return prior.latitude.is_set && prior.longitude.is_set;
+}
+
+Eigen::Vector3d GetLLA(const CameraIntrinsicsPrior& prior) {
+  return Eigen::Vector3d(prior.latitude.value[0],
+                         prior.longitude.value[0],
+                         prior.altitude.is_set ? prior.altitude.value[0] : 0.0);
+}
+
+}  // namespace
+
+int SetPositionPriorsFromGPS(Reconstruction* reconstruction) {
+  CHECK_NOTNULL(reconstruction);
+
+  // Use the GPS position of the view with the smallest id as the origin so that
+  // the ENU frame does not depend on the order of the views.
+  ViewId reference_view_id = std::numeric_limits<ViewId>::max();
+  for (const ViewId view_id : reconstruction->ViewIds()) {
+    const View* view = reconstruction->View(view_id);
+    if (HasGPSPrior(view->CameraIntrinsicsPrior()) &&
+        view_id < reference_view_id) {
+      reference_view_id = view_id;
+    }
+  }
+  if (reference_view_id == std::numeric_limits<ViewId>::max()) {
+    return 0;
+  }
+  const Eigen::Vector3d reference_lla =
+      GetLLA(reconstruction->View(reference_view_id)->CameraIntrinsicsPrior());
+
+  int num_position_priors_set = 0;
+  for (const ViewId view_id : reconstruction->ViewIds()) {
+    CameraIntrinsicsPrior* prior =
+        reconstruction->MutableView(view_id)->MutableCameraIntrinsicsPrior();
+    if (!HasGPSPrior(*prior) || prior->position.is_set) {
+      continue;
+    }
+
+    const Eigen::Vector3d enu =
+        GPSConverter::LLAToENU(GetLLA(*prior), reference_lla);
+    prior->position.is_set = true;
+    prior->position.value[0] = enu[0];
+    prior->position.value[1] = enu[1];
+    prior->position.value[2] = enu[2];
+    ++num_position_priors_set;
+  }
+  return num_position_priors_set;
+}
+
+void GetPositionPriors(const Reconstruction& reconstruction,
+                       std::unordered_map<ViewId, Eigen::Vector3d>* priors) {
+  CHECK_NOTNULL(priors)->clear();
+  for (const ViewId view_id : reconstruction.ViewIds()) {
+    const CameraIntrinsicsPrior& prior =
+        reconstruction.View(view_id)->CameraIntrinsicsPrior();
+    if (prior.position.is_set) {
+      (*priors)[view_id] = Eigen::Map<const Eigen::Vector3d>(
+          prior.position.value);
+    }
+  }
+}
+
+bool RotatePositionPriorsToOrientationFrame(
+    const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
+    const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
+    const std::unordered_map<ViewId, Eigen::Vector3d>& position_priors,
+    std::unordered_map<ViewId, Eigen::Vector3d>* rotated_position_priors) {
+  CHECK_NOTNULL(rotated_position_priors)->clear();
+  static const int kMinNumViewPairs = 3;
+  // The directions are degenerate if the second largest singular value is
+  // this much smaller than the largest one.
+  static const double kMinSingularValueRatio = 1e-2;
+  static const double kMinBaseline = 1e-6;
+
+  // Accumulate the correlation between the directions of the relative
+  // translations in the orientation frame and the directions between the
+  // position priors. Each pair is weighted by its baseline since the direction
+  // of short baselines is dominated by the noise of the priors.
+  Eigen::Matrix3d correlation = Eigen::Matrix3d::Zero();
+  int num_view_pairs = 0;
+  for (const auto& view_pair : view_pairs) {
+    const Eigen::Vector3d* prior1 =
+        FindOrNull(position_priors, view_pair.first.first);
+    const Eigen::Vector3d* prior2 =
+        FindOrNull(position_priors, view_pair.first.second);
+    const Eigen::Vector3d* orientation1 =
+        FindOrNull(orientations, view_pair.first.first);
+    if (prior1 == nullptr || prior2 == nullptr || orientation1 == nullptr ||
+        !ContainsKey(orientations, view_pair.first.second)) {
+      continue;
+    }
+    const Eigen::Vector3d prior_direction = *prior2 - *prior1;
+    const double baseline = prior_direction.norm();
+    if (baseline < kMinBaseline) {
+      continue;
+    }
+
+    // Rotate the relative translation into the global orientation frame.
+    Eigen::Matrix3d rotation1;
+    ceres::AngleAxisToRotationMatrix(
+        orientation1->data(), ceres::ColumnMajorAdapter3x3(rotation1.data()));
+    const Eigen::Vector3d translation_direction =
+        rotation1.transpose() * view_pair.second.position_2.normalized();
+
+    correlation += translation_direction * prior_direction.transpose();
+    ++num_view_pairs;
+  }
+  if (num_view_pairs < kMinNumViewPairs) {
+    VLOG(2) << "Only " << num_view_pairs
+            << " view pairs have position priors.";
+    return false;
+  }
+
+  // The rotation that maximizes the correlation is given by the SVD.
+  Eigen::JacobiSVD<Eigen::Matrix3d> svd(
+      correlation, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  const Eigen::Vector3d& singular_values = svd.singularValues();
+  if (singular_values[1] < kMinSingularValueRatio * singular_values[0]) {
+    VLOG(2) << "The directions between the position priors are degenerate.";
+    return false;
+  }
+  Eigen::Matrix3d rotation = svd.matrixU() * svd.matrixV().transpose();
+  if (rotation.determinant() < 0.0) {
+    Eigen::Matrix3d u = svd.matrixU();
+    u.col(2) *= -1.0;
+    rotation = u * svd.matrixV().transpose();
+  }
+
+  rotated_position_priors->reserve(position_priors.size());
+  for (const auto& position_prior : position_priors) {
+    (*rotated_position_priors)[position_prior.first] =
+        rotation * position_prior.second;
+  }
+  return true;
+}
+
+}  // namespace theia
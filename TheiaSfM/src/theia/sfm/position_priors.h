@@ -0,0 +1,76 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#ifndef THEIA_SFM_POSITION_PRIORS_H_
+#define THEIA_SFM_POSITION_PRIORS_H_
+
+#include <Eigen/Core>
+#include <unordered_map>
+
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/util/hash.h"
+
+namespace theia {
+
+class Reconstruction;
+
+// Sets the position prior of every view that has a GPS latitude and longitude
+// prior but no position prior to the East-North-Up (ENU) coordinates of its GPS
+// position in meters. The origin of the ENU frame is the GPS position of the
+// view with the smallest view id that has a GPS prior. Missing altitudes are
+// treated as 0. Returns the number of views whose position prior was set.
+int SetPositionPriorsFromGPS(Reconstruction* reconstruction);
+
+// Returns the position priors of all views in the reconstruction that have one.
+void GetPositionPriors(const Reconstruction& reconstruction,
+                       std::unordered_map<ViewId, Eigen::Vector3d>* priors);
+
+// Global positions are estimated in the frame of the global orientations, which
+// is only known up to a rotation of the frame of the position priors. This
+// function estimates that rotation by aligning the directions between the
+// position priors of each view pair with the relative translation directions
+// rotated into the global orientation frame (pairs with longer baselines are
+// weighted more), and returns the rotated position priors. Returns false if
+// there are too few view pairs with position priors or if their directions are
+// degenerate (e.g., all views lie on a line).
+bool RotatePositionPriorsToOrientationFrame(
+    const std::unordered_map<ViewIdPair, TwoViewInfo>& view_pairs,
+    const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
+    const std::unordered_map<ViewId, Eigen::Vector3d>& position_priors,
+    std::unordered_map<ViewId, Eigen::Vector3d>* rotated_position_priors);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_POSITION_PRIORS_H_
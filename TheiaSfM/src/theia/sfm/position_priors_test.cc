@@ -0,0 +1,175 @@
+// Copyright (C) 2016 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <ceres/rotation.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <unordered_map>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/gps_converter.h"
+#include "theia/sfm/position_priors.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/map_util.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+void SetGPSPrior(const double latitude,
+                 const double longitude,
+                 const double altitude,
+                 CameraIntrinsicsPrior* prior) {
+  prior->latitude.is_set = true;
+  prior->latitude.value[0] = latitude;
+  prior->longitude.is_set = true;
+  prior->longitude.value[0] = longitude;
+  prior->altitude.is_set = true;
+  prior->altitude.value[0] = altitude;
+}
+
+// Creates view pairs between all views whose relative translations are given
+// by the positions and orientations.
+void CreateViewPairs(
+    const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
+    const std::unordered_map<ViewId, Eigen::Vector3d>& positions,
+    std::unordered_map<ViewIdPair, TwoViewInfo>* view_pairs) {
+  for (const auto& position1 : positions) {
+    for (const auto& position2 : positions) {
+      if (position1.first >= position2.first) {
+        continue;
+      }
+      Eigen::Matrix3d rotation1;
+      ceres::AngleAxisToRotationMatrix(
+          FindOrDie(orientations, position1.first).data(),
+          ceres::ColumnMajorAdapter3x3(rotation1.data()));
+      TwoViewInfo info;
+      info.position_2 =
+          rotation1 * (position2.second - position1.second).normalized();
+      (*view_pairs)[ViewIdPair(position1.first, position2.first)] = info;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(PositionPriors, SetPositionPriorsFromGPS) {
+  static const double kTolerance = 1e-6;
+  Reconstruction reconstruction;
+  const ViewId view_id1 = reconstruction.AddView("1");
+  const ViewId view_id2 = reconstruction.AddView("2");
+  const ViewId view_id3 = reconstruction.AddView("3");
+  const ViewId view_id4 = reconstruction.AddView("4");
+  SetGPSPrior(27.173891, 78.042068, 168.0,
+              reconstruction.MutableView(view_id1)
+                  ->MutableCameraIntrinsicsPrior());
+  SetGPSPrior(27.174891, 78.042068, 170.0,
+              reconstruction.MutableView(view_id2)
+                  ->MutableCameraIntrinsicsPrior());
+
+  // Existing position priors are not replaced.
+  CameraIntrinsicsPrior* prior3 =
+      reconstruction.MutableView(view_id3)->MutableCameraIntrinsicsPrior();
+  SetGPSPrior(27.173891, 78.043068, 168.0, prior3);
+  prior3->position.is_set = true;
+  prior3->position.value[0] = 1.0;
+
+  EXPECT_EQ(SetPositionPriorsFromGPS(&reconstruction), 2);
+  std::unordered_map<ViewId, Eigen::Vector3d> priors;
+  GetPositionPriors(reconstruction, &priors);
+  EXPECT_EQ(priors.size(), 3);
+  EXPECT_FALSE(ContainsKey(priors, view_id4));
+
+  // The first view is the origin of the ENU frame.
+  EXPECT_NEAR(FindOrDie(priors, view_id1).norm(), 0.0, kTolerance);
+  const Eigen::Vector3d enu2 = GPSConverter::LLAToENU(
+      Eigen::Vector3d(27.174891, 78.042068, 170.0),
+      Eigen::Vector3d(27.173891, 78.042068, 168.0));
+  EXPECT_NEAR((FindOrDie(priors, view_id2) - enu2).norm(), 0.0, kTolerance);
+  EXPECT_EQ(FindOrDie(priors, view_id3).x(), 1.0);
+}
+
+TEST(PositionPriors, RotatePositionPriorsToOrientationFrame) {
+  static const double kTolerance = 1e-6;
+  static const int kNumViews = 10;
+  RandomNumberGenerator rng(52);
+
+  // The priors are in a frame that is rotated w.r.t. the orientation frame.
+  const Eigen::Matrix3d prior_rotation =
+      Eigen::AngleAxisd(0.7, Eigen::Vector3d(1.0, 2.0, 3.0).normalized())
+          .toRotationMatrix();
+  std::unordered_map<ViewId, Eigen::Vector3d> orientations, positions, priors;
+  for (int i = 0; i < kNumViews; i++) {
+    orientations[i] = 0.3 * rng.RandVector3d();
+    positions[i] = 10.0 * rng.RandVector3d();
+    priors[i] = prior_rotation.transpose() * positions[i];
+  }
+  std::unordered_map<ViewIdPair, TwoViewInfo> view_pairs;
+  CreateViewPairs(orientations, positions, &view_pairs);
+
+  std::unordered_map<ViewId, Eigen::Vector3d> rotated_priors;
+  EXPECT_TRUE(RotatePositionPriorsToOrientationFrame(
+      view_pairs, orientations, priors, &rotated_priors));
+  EXPECT_EQ(rotated_priors.size(), kNumViews);
+  for (const auto& position : positions) {
+    EXPECT_NEAR(
+        (FindOrDie(rotated_priors, position.first) - position.second).norm(),
+        0.0,
+        kTolerance);
+  }
+}
+
+TEST(PositionPriors, CollinearPositionPriorsAreDegenerate) {
+  static const int kNumViews = 10;
+  RandomNumberGenerator rng(52);
+
+  std::unordered_map<ViewId, Eigen::Vector3d> orientations, positions;
+  for (int i = 0; i < kNumViews; i++) {
+    orientations[i] = 0.3 * rng.RandVector3d();
+    positions[i] = Eigen::Vector3d(i, 0.0, 0.0);
+  }
+  std::unordered_map<ViewIdPair, TwoViewInfo> view_pairs;
+  CreateViewPairs(orientations, positions, &view_pairs);
+
+  std::unordered_map<ViewId, Eigen::Vector3d> rotated_priors;
+  EXPECT_FALSE(RotatePositionPriorsToOrientationFrame(
+      view_pairs, orientations, positions, &rotated_priors));
+}
+
+}  // namespace theia
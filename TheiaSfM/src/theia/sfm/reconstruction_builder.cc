@@ -35,14 +35,23 @@
 #include "theia/sfm/reconstruction_builder.h"
 
 #include <glog/logging.h>
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "theia/io/write_matches.h"
 #include "theia/matching/image_pair_match.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/camera_intrinsics_model.h"
+#include "theia/sfm/camera/undistortion_lookup_table.h"
 #include "theia/sfm/camera_intrinsics_prior.h"
 #include "theia/sfm/feature_extractor_and_matcher.h"
+#include "theia/sfm/memory_accounting.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/reconstruction_estimator.h"
 #include "theia/sfm/track_builder.h"
@@ -50,6 +59,11 @@
 #include "theia/sfm/view.h"
 #include "theia/sfm/view_graph/view_graph.h"
 #include "theia/util/filesystem.h"
+#include "theia/util/memory_usage.h"
+#include "theia/util/progress_reporter.h"
+#include "theia/util/random.h"
+#include "theia/util/threadpool.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 
@@ -117,6 +131,48 @@ Reconstruction* CreateEstimatedSubreconstruction(
   return subreconstruction.release();
 }
 
+// Replaces the camera intrinsics of the views with deep copies. Views that
+// shared their intrinsics (e.g. views of the same intrinsics group) share the
+// copy. GetSubReconstruction copies the cameras shallowly, so this keeps the
+// estimation of a subreconstruction from modifying the intrinsics of other
+// reconstructions.
+void DeepCopyCameraIntrinsics(Reconstruction* reconstruction) {
+  std::unordered_map<const CameraIntrinsicsModel*,
+                     std::shared_ptr<CameraIntrinsicsModel> >
+      copied_intrinsics;
+  for (const ViewId view_id : reconstruction->ViewIds()) {
+    Camera* camera = reconstruction->MutableView(view_id)->MutableCamera();
+    std::shared_ptr<CameraIntrinsicsModel>& intrinsics =
+        copied_intrinsics[camera->CameraIntrinsics().get()];
+    if (intrinsics == nullptr) {
+      Camera copied_camera;
+      copied_camera.DeepCopy(*camera);
+      intrinsics = copied_camera.MutableCameraIntrinsics();
+    }
+    camera->MutableCameraIntrinsics() = intrinsics;
+  }
+}
+
+void LogReconstructionEstimatorSummary(
+    const ReconstructionEstimatorSummary& summary,
+    const Reconstruction& reconstruction) {
+  LOG(INFO) << "\nReconstruction estimation statistics: "
+            << "\n\tNum estimated views = " << summary.estimated_views.size()
+            << "\n\tNum input views = " << reconstruction.NumViews()
+            << "\n\tNum estimated tracks = " << summary.estimated_tracks.size()
+            << "\n\tNum input tracks = " << reconstruction.NumTracks()
+            << "\n\tPose estimation time = " << summary.pose_estimation_time
+            << "\n\tTriangulation time = " << summary.triangulation_time
+            << "\n\tBundle Adjustment time = "
+            << summary.bundle_adjustment_time
+            << "\n\tTotal time = " << summary.total_time << "\n\n"
+            << summary.message;
+}
+
+double BytesToMegabytes(const int64_t size_in_bytes) {
+  return size_in_bytes / (1024.0 * 1024.0);
+}
+
 void RemoveEstimatedViewsAndTracks(Reconstruction* reconstruction,
                                    ViewGraph* view_graph) {
   const auto& view_ids = reconstruction->ViewIds();
@@ -149,10 +205,25 @@ void RemoveEstimatedViewsAndTracks(Reconstruction* reconstruction,
 
 ReconstructionBuilder::ReconstructionBuilder(
     const ReconstructionBuilderOptions& options)
-    : options_(options) {
+    : options_(options), num_matches_without_tracks_(0) {
   CHECK_GT(options.num_threads, 0);
 
-  options_.reconstruction_estimator_options.rng = options.rng;
+  if (options_.deterministic && options_.rng == nullptr) {
+    options_.rng = std::make_shared<RandomNumberGenerator>(0);
+  }
+  options_.reconstruction_estimator_options.rng = options_.rng;
+  options_.reconstruction_estimator_options.progress_reporter =
+      options.progress_reporter;
+  if (options_.use_undistortion_lookup_tables) {
+    options_.reconstruction_estimator_options.use_undistortion_lookup_tables =
+        true;
+  }
+
+  // Start tracing here so that feature extraction and matching are traced.
+  if (options_.enable_tracing) {
+    ClearTrace();
+    EnableTracing(true);
+  }
 
   reconstruction_.reset(new Reconstruction());
   view_graph_.reset(new ViewGraph());
@@ -173,6 +244,29 @@ ReconstructionBuilder::ReconstructionBuilder(
       .min_num_inlier_matches = options_.min_num_inlier_matches;
   feam_options.feature_matcher_options.geometric_verification_options
       .estimate_twoview_info_options.rng = options_.rng;
+  feam_options.feature_matcher_options.progress_reporter =
+      options_.progress_reporter;
+  feam_options.feature_matcher_options.deterministic = options_.deterministic;
+  if (options_.use_undistortion_lookup_tables) {
+    feam_options.feature_matcher_options.geometric_verification_options
+        .estimate_twoview_info_options.undistortion_lookup_tables =
+        std::make_shared<UndistortionLookupTableCache>();
+  }
+
+  // Split the memory budget between the feature cache and the matches. The
+  // budget can only be enforced when features may be read back from disk.
+  FeatureMatcherOptions& matcher_options = feam_options.feature_matcher_options;
+  if (options_.max_memory_usage_in_bytes > 0 &&
+      matcher_options.match_out_of_core) {
+    if (matcher_options.max_cache_size_in_bytes == 0) {
+      matcher_options.max_cache_size_in_bytes =
+          options_.max_memory_usage_in_bytes / 4;
+    }
+    if (matcher_options.max_matches_size_in_bytes == 0) {
+      matcher_options.max_matches_size_in_bytes =
+          options_.max_memory_usage_in_bytes / 4;
+    }
+  }
 
   feature_extractor_and_matcher_.reset(
       new FeatureExtractorAndMatcher(feam_options));
@@ -238,6 +332,7 @@ bool ReconstructionBuilder::AddMaskForFeaturesExtraction(
 }
 
 bool ReconstructionBuilder::ExtractAndMatchFeatures() {
+  ScopedTraceSpan span("ExtractAndMatchFeatures");
   CHECK_EQ(view_graph_->NumViews(), 0) << "Cannot call ExtractAndMatchFeatures "
                                           "after TwoViewMatches has been "
                                           "called.";
@@ -247,6 +342,10 @@ bool ReconstructionBuilder::ExtractAndMatchFeatures() {
   std::vector<CameraIntrinsicsPrior> camera_intrinsics_priors;
   feature_extractor_and_matcher_->ExtractAndMatchFeatures(
       &camera_intrinsics_priors, &matches);
+  if (IsCancelled()) {
+    LOG(INFO) << "Feature extraction and matching was cancelled.";
+    return false;
+  }
 
   // If we only want calibrated views remove them from the reconstruction so
   // that they no features are detected and matched between them.
@@ -289,9 +388,27 @@ bool ReconstructionBuilder::ExtractAndMatchFeatures() {
         << "Could not write the matches to " << options_.output_matches_file;
   }
 
-  // Add the matches to the view graph and reconstruction.
-  for (const auto& match : matches) {
+  LOG(INFO) << "Memory usage after matching: matches = "
+            << BytesToMegabytes(EstimateMemoryUsage(matches))
+            << " MB, peak RSS = "
+            << BytesToMegabytes(PeakResidentSetSizeInBytes()) << " MB";
+
+  // If the track builder has a memory budget then add the view pairs with the
+  // most matches first so that the strongest view pairs form tracks.
+  if (options_.max_memory_usage_in_bytes > 0) {
+    std::sort(matches.begin(),
+              matches.end(),
+              [](const ImagePairMatch& lhs, const ImagePairMatch& rhs) {
+                return lhs.correspondences.size() > rhs.correspondences.size();
+              });
+  }
+
+  // Add the matches to the view graph and reconstruction. Each match is
+  // released once it has been added so that the matches and the tracks built
+  // from them are not both held in memory in full.
+  for (auto& match : matches) {
     AddTwoViewMatch(match.image1, match.image2, match);
+    std::vector<FeatureCorrespondence>().swap(match.correspondences);
   }
 
   return true;
@@ -338,13 +455,65 @@ void ReconstructionBuilder::InitializeReconstructionAndViewGraph(
 
 bool ReconstructionBuilder::BuildReconstruction(
     std::vector<Reconstruction*>* reconstructions) {
+  std::vector<ReconstructionEstimatorSummary> summaries;
+  return BuildReconstruction(reconstructions, &summaries);
+}
+
+bool ReconstructionBuilder::BuildReconstruction(
+    std::vector<Reconstruction*>* reconstructions,
+    std::vector<ReconstructionEstimatorSummary>* summaries) {
+  bool success;
+  {
+    ScopedTraceSpan span("BuildReconstruction");
+    success = EstimateReconstructions(reconstructions, summaries);
+  }
+
+  if (options_.enable_tracing) {
+    LOG(INFO) << TraceSummary();
+    if (!options_.output_trace_file.empty()) {
+      LOG(INFO) << "Writing trace to file: " << options_.output_trace_file;
+      if (!WriteChromeTrace(options_.output_trace_file)) {
+        LOG(ERROR) << "Could not write the trace to "
+                   << options_.output_trace_file;
+      }
+    }
+  }
+  return success;
+}
+
+bool ReconstructionBuilder::EstimateReconstructions(
+    std::vector<Reconstruction*>* reconstructions,
+    std::vector<ReconstructionEstimatorSummary>* summaries) {
+  CHECK_NOTNULL(summaries)->clear();
   CHECK_GE(view_graph_->NumViews(), 2) << "At least 2 images must be provided "
                                           "in order to create a "
                                           "reconstruction.";
+  if (IsCancelled()) {
+    return false;
+  }
 
   // Build tracks if they were not explicitly specified.
   if (reconstruction_->NumTracks() == 0) {
+    if (num_matches_without_tracks_ > 0) {
+      LOG(WARNING) << "The correspondences of " << num_matches_without_tracks_
+                   << " view pairs were not used to build tracks because the "
+                      "track builder exceeded the memory budget.";
+    }
+    const int64_t track_builder_size_in_bytes =
+        EstimateMemoryUsage(*track_builder_);
     track_builder_->BuildTracks(reconstruction_.get());
+    // The features and connected components are no longer needed once the
+    // tracks are in the reconstruction, so release them before estimation.
+    track_builder_.reset(
+        new TrackBuilder(options_.min_track_length, options_.max_track_length));
+    LOG(INFO) << "Memory usage after building tracks: track builder = "
+              << BytesToMegabytes(track_builder_size_in_bytes)
+              << " MB, reconstruction = "
+              << BytesToMegabytes(EstimateMemoryUsage(*reconstruction_))
+              << " MB, view graph = "
+              << BytesToMegabytes(EstimateMemoryUsage(*view_graph_))
+              << " MB, peak RSS = "
+              << BytesToMegabytes(PeakResidentSetSizeInBytes()) << " MB";
   }
 
   // Remove uncalibrated views from the reconstruction and view graph.
@@ -353,6 +522,18 @@ bool ReconstructionBuilder::BuildReconstruction(
     RemoveUncalibratedViews();
   }
 
+  if (options_.reconstruct_components_in_parallel &&
+      !options_.reconstruct_largest_connected_component) {
+    if (!EstimateConnectedComponentsInParallel(reconstructions, summaries)) {
+      LOG(INFO) << "Reconstruction estimation was cancelled.";
+      return false;
+    }
+    if (reconstructions->size() > 0 && reconstruction_->NumViews() < 3) {
+      LOG(INFO) << "No more reconstructions can be estimated.";
+      return true;
+    }
+  }
+
   while (reconstruction_->NumViews() > 1) {
     LOG(INFO) << "Attempting to reconstruct " << reconstruction_->NumViews()
               << " images from " << view_graph_->NumEdges()
@@ -364,29 +545,23 @@ bool ReconstructionBuilder::BuildReconstruction(
 
     const auto& summary = reconstruction_estimator->Estimate(
         view_graph_.get(), reconstruction_.get());
+    if (IsCancelled()) {
+      LOG(INFO) << "Reconstruction estimation was cancelled.";
+      return false;
+    }
 
     // If a reconstruction can no longer be estimated, return.
     if (!summary.success) {
       return reconstructions->size() > 0;
     }
 
-    LOG(INFO) << "\nReconstruction estimation statistics: "
-              << "\n\tNum estimated views = " << summary.estimated_views.size()
-              << "\n\tNum input views = " << reconstruction_->NumViews()
-              << "\n\tNum estimated tracks = "
-              << summary.estimated_tracks.size()
-              << "\n\tNum input tracks = " << reconstruction_->NumTracks()
-              << "\n\tPose estimation time = " << summary.pose_estimation_time
-              << "\n\tTriangulation time = " << summary.triangulation_time
-              << "\n\tBundle Adjustment time = "
-              << summary.bundle_adjustment_time
-              << "\n\tTotal time = " << summary.total_time << "\n\n"
-              << summary.message;
+    LogReconstructionEstimatorSummary(summary, *reconstruction_);
 
     // Remove estimated views and tracks and attempt to create a reconstruction
     // from the remaining unestimated parts.
-    reconstructions->emplace_back(
-        CreateEstimatedSubreconstruction(*reconstruction_));
+    summaries->emplace_back(summary);
+    OutputReconstruction(CreateEstimatedSubreconstruction(*reconstruction_),
+                         reconstructions);
     RemoveEstimatedViewsAndTracks(reconstruction_.get(), view_graph_.get());
 
     // Exit after the first reconstruction estimation if only the single largest
@@ -403,6 +578,160 @@ bool ReconstructionBuilder::BuildReconstruction(
   return true;
 }
 
+bool ReconstructionBuilder::EstimateConnectedComponentsInParallel(
+    std::vector<Reconstruction*>* reconstructions,
+    std::vector<ReconstructionEstimatorSummary>* summaries) {
+  ScopedTraceSpan span("EstimateConnectedComponentsInParallel");
+  std::vector<std::unordered_set<ViewId> > components;
+  view_graph_->GetConnectedComponents(options_.num_threads, &components);
+  // A single component is reconstructed by the sequential loop.
+  if (components.size() < 2) {
+    return true;
+  }
+  LOG(INFO) << "Reconstructing " << components.size()
+            << " connected components of the view graph in parallel.";
+
+  // The components share the threads of the estimator, and each one has its
+  // own random number generator so that the result does not depend on the
+  // scheduling of the components. Each component has a child progress reporter
+  // so that cancellation reaches the running estimators, while only the number
+  // of finished components is reported.
+  const int num_parallel_components = std::max(
+      1, std::min(options_.num_threads, static_cast<int>(components.size())));
+  ReconstructionEstimatorOptions component_options =
+      options_.reconstruction_estimator_options;
+  component_options.num_threads =
+      std::max(1, component_options.num_threads / num_parallel_components);
+  const unsigned base_seed =
+      options_.rng == nullptr
+          ? 0
+          : static_cast<unsigned>(
+                options_.rng->RandInt(0, std::numeric_limits<int>::max()));
+
+  std::vector<std::unique_ptr<Reconstruction> > component_reconstructions(
+      components.size());
+  std::vector<ReconstructionEstimatorSummary> component_summaries(
+      components.size());
+  // Each component is handed to the reconstruction callback as soon as it has
+  // been estimated. The calls are serialized so that the callback does not
+  // need to be thread-safe.
+  std::vector<Reconstruction*> estimated_reconstructions(components.size(),
+                                                         nullptr);
+  std::mutex callback_mutex;
+  if (options_.progress_reporter != nullptr) {
+    options_.progress_reporter->BeginStage("Reconstructing components",
+                                           components.size());
+  }
+  // Views of different components may share their intrinsics, e.g. when all
+  // views are in one intrinsics group. Each component therefore estimates its
+  // own copy of the intrinsics, and the copies are made before any component
+  // is estimated. The intrinsics do not need to be merged back: the estimated
+  // views are removed from the input below, and the views of components that
+  // failed keep their original intrinsics for the sequential reconstruction.
+  for (int i = 0; i < components.size(); i++) {
+    component_reconstructions[i].reset(new Reconstruction());
+    reconstruction_->GetSubReconstruction(components[i],
+                                          component_reconstructions[i].get());
+    DeepCopyCameraIntrinsics(component_reconstructions[i].get());
+  }
+  {
+    ThreadPool pool(num_parallel_components);
+    for (int i = 0; i < components.size(); i++) {
+      pool.Add([&, i]() {
+        if (IsCancelled()) {
+          return;
+        }
+
+        ViewGraph view_graph;
+        view_graph_->ExtractSubgraph(components[i], &view_graph);
+
+        ReconstructionEstimatorOptions estimator_options = component_options;
+        if (options_.rng != nullptr) {
+          estimator_options.rng = std::make_shared<RandomNumberGenerator>(
+              DeriveSeed(base_seed, i));
+        }
+        if (options_.progress_reporter != nullptr) {
+          estimator_options.progress_reporter =
+              std::make_shared<ProgressReporter>(options_.progress_reporter);
+        }
+        std::unique_ptr<ReconstructionEstimator> reconstruction_estimator(
+            ReconstructionEstimator::Create(estimator_options));
+        component_summaries[i] = reconstruction_estimator->Estimate(
+            &view_graph, component_reconstructions[i].get());
+        if (component_summaries[i].success && !IsCancelled()) {
+          estimated_reconstructions[i] =
+              CreateEstimatedSubreconstruction(*component_reconstructions[i]);
+          if (options_.reconstruction_callback) {
+            std::lock_guard<std::mutex> lock(callback_mutex);
+            options_.reconstruction_callback(estimated_reconstructions[i]);
+          }
+        }
+        if (options_.progress_reporter != nullptr) {
+          options_.progress_reporter->Increment();
+        }
+      });
+    }
+  }
+  // Reconstructions that were already handed to the callback are returned even
+  // if the builder was cancelled afterwards.
+  if (IsCancelled()) {
+    for (Reconstruction* reconstruction : estimated_reconstructions) {
+      if (reconstruction != nullptr) {
+        reconstructions->emplace_back(reconstruction);
+      }
+    }
+    return false;
+  }
+
+  // Output the reconstructions in order of decreasing component size and
+  // remove the views and tracks that were estimated from the input. The views
+  // of components that could not be estimated are left in place for the
+  // sequential reconstruction.
+  for (int i = 0; i < components.size(); i++) {
+    const Reconstruction& component_reconstruction =
+        *component_reconstructions[i];
+    if (estimated_reconstructions[i] == nullptr) {
+      LOG(WARNING) << "Could not reconstruct a connected component of "
+                   << components[i].size()
+                   << " views in parallel. It is reconstructed sequentially.";
+      component_reconstructions[i].reset();
+      continue;
+    }
+
+    LogReconstructionEstimatorSummary(component_summaries[i],
+                                      component_reconstruction);
+    summaries->emplace_back(component_summaries[i]);
+    reconstructions->emplace_back(estimated_reconstructions[i]);
+    for (const ViewId view_id : component_reconstruction.ViewIds()) {
+      if (component_reconstruction.View(view_id)->IsEstimated()) {
+        reconstruction_->RemoveView(view_id);
+        view_graph_->RemoveView(view_id);
+      }
+    }
+    for (const TrackId track_id : component_reconstruction.TrackIds()) {
+      if (component_reconstruction.Track(track_id)->IsEstimated()) {
+        reconstruction_->RemoveTrack(track_id);
+      }
+    }
+    component_reconstructions[i].reset();
+  }
+  return true;
+}
+
+void ReconstructionBuilder::OutputReconstruction(
+    Reconstruction* reconstruction,
+    std::vector<Reconstruction*>* reconstructions) {
+  reconstructions->emplace_back(reconstruction);
+  if (options_.reconstruction_callback) {
+    options_.reconstruction_callback(reconstruction);
+  }
+}
+
+bool ReconstructionBuilder::IsCancelled() const {
+  return options_.progress_reporter != nullptr &&
+         options_.progress_reporter->IsCancelled();
+}
+
 void ReconstructionBuilder::AddMatchToViewGraph(
     const ViewId view_id1,
     const ViewId view_id2,
@@ -421,6 +750,13 @@ void ReconstructionBuilder::AddMatchToViewGraph(
 void ReconstructionBuilder::AddTracksForMatch(const ViewId view_id1,
                                               const ViewId view_id2,
                                               const ImagePairMatch& matches) {
+  if (options_.max_memory_usage_in_bytes > 0 &&
+      EstimateMemoryUsage(*track_builder_) >
+          options_.max_memory_usage_in_bytes / 2) {
+    ++num_matches_without_tracks_;
+    return;
+  }
+
   for (const auto& match : matches.correspondences) {
     track_builder_->AddFeatureCorrespondence(
         view_id1, match.feature1, view_id2, match.feature2);
@@ -35,6 +35,8 @@
 #ifndef THEIA_SFM_RECONSTRUCTION_BUILDER_H_
 #define THEIA_SFM_RECONSTRUCTION_BUILDER_H_
 
+#include <stdint.h>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -48,12 +50,14 @@
 
 namespace theia {
 class FeatureExtractorAndMatcher;
+class ProgressReporter;
 class RandomNumberGenerator;
 class Reconstruction;
 class TrackBuilder;
 class ViewGraph;
 struct CameraIntrinsicsPrior;
 struct ImagePairMatch;
+struct ReconstructionEstimatorSummary;
 
 struct ReconstructionBuilderOptions {
   // The random number generator used to generate random numbers through the
@@ -61,6 +65,30 @@ struct ReconstructionBuilderOptions {
   // generator will be initialized based on the current time.
   std::shared_ptr<RandomNumberGenerator> rng;
 
+  // If true, feature matching and the filtering of relative translations do
+  // not depend on the number of threads or on thread scheduling: their parallel
+  // tasks draw random numbers from streams seeded by their index and their
+  // outputs are ordered by key. If rng is not set, a generator with a fixed
+  // seed is used so that runs are also reproducible. The other stages of the
+  // reconstruction estimator (e.g., bundle adjustment with multithreaded Ceres)
+  // are not covered, so the final reconstruction is only reproducible when
+  // num_threads is 1.
+  bool deterministic = false;
+
+  // If set, the progress of feature extraction, matching, reconstruction
+  // estimation and bundle adjustment is reported to it. Calling Cancel() on
+  // the reporter (e.g. from another thread) stops the current stage early and
+  // ExtractAndMatchFeatures or BuildReconstruction then returns false. See
+  // //theia/util/progress_reporter.h.
+  std::shared_ptr<ProgressReporter> progress_reporter;
+
+  // If set, it is called with each reconstruction as soon as it has been
+  // estimated, before the remaining views are reconstructed. The builder does
+  // not modify the reconstruction afterwards and it is also returned by
+  // BuildReconstruction. With reconstruct_connected_components_in_parallel the
+  // callback may be invoked from the worker threads, but never concurrently.
+  std::function<void(Reconstruction* reconstruction)> reconstruction_callback;
+
   // Number of threads used. Each stage of the pipeline (feature extraction,
   // matching, estimation, etc.) will use this number of threads.
   int num_threads = 1;
@@ -70,11 +98,32 @@ struct ReconstructionBuilderOptions {
   // connected component is reconstructed.
   bool reconstruct_largest_connected_component = false;
 
+  // If true (and reconstruct_largest_connected_component is false), the
+  // connected components of the view graph are computed once and each
+  // component is reconstructed concurrently with its own slice of the
+  // reconstruction and view graph. The threads of the reconstruction estimator
+  // are shared between the components, and each component estimates its own
+  // copy of the camera intrinsics. Views that could not be estimated,
+  // including all views of a component whose estimation failed, are then
+  // reconstructed sequentially as usual. This is useful when the input contains
+  // several disconnected sets of images, e.g. separate flights of an aerial
+  // survey.
+  bool reconstruct_components_in_parallel = false;
+
   // Set to true to only accept calibrated views (from EXIF or elsewhere) as
   // valid inputs to the reconstruction process. When uncalibrated views are
   // added to the reconstruction builder they are ignored with a LOG warning.
   bool only_calibrated_views = false;
 
+  // If true, pixels are undistorted with lookup tables (see
+  // //theia/sfm/camera/undistortion_lookup_table.h) instead of iteratively.
+  // During two-view estimation a table is built once for each distinct camera
+  // and shared by all image pairs, and the reconstruction estimator keeps a
+  // table for each camera intrinsics group that is rebuilt after bundle
+  // adjustment changes the intrinsics. This speeds up feature normalization
+  // for camera models with an iterative undistortion, e.g. fisheye lenses.
+  bool use_undistortion_lookup_tables = false;
+
   // Minimum allowable track length. Tracks that are too short are often not
   // well-constrained for triangulation and bundle adjustment.
   int min_track_length = 2;
@@ -114,6 +163,29 @@ struct ReconstructionBuilderOptions {
   // view metadata so that the view graph and tracks may be exactly
   // recreated.
   std::string output_matches_file;
+
+  // If greater than 0, the ReconstructionBuilder attempts to keep the memory
+  // used by feature matching and track building within this many bytes. During
+  // out-of-core matching, the feature cache and the verified matches held in
+  // memory may each use a quarter of the budget unless the corresponding byte
+  // limits are set explicitly in matching_options; matches beyond the budget
+  // are spilled to disk. The matches are released as they are added to the
+  // view graph and track builder. The track builder may use half of the budget.
+  // Once it is exceeded, the correspondences of further view pairs are not
+  // added to tracks (the view pairs are still added to the view graph). When
+  // features are matched by the ReconstructionBuilder, the view pairs with the
+  // most matches are added first.
+  int64_t max_memory_usage_in_bytes = 0;
+
+  // Set to true to record nested timing spans and counters (e.g., RANSAC
+  // iterations, feature cache hits) for each stage of the pipeline. See
+  // //theia/util/trace.h. A per-stage summary is logged at the end of
+  // BuildReconstruction.
+  bool enable_tracing = false;
+
+  // If tracing is enabled and this is set, the trace is written to this file in
+  // the Chrome trace event format at the end of BuildReconstruction.
+  std::string output_trace_file;
 };
 
 // Base class for building SfM reconstructions. This class will manage the
@@ -152,6 +224,7 @@ class ReconstructionBuilder {
                                     const std::string& mask_filepath);
 
   // Extracts features and performs matching with geometric verification.
+  // Returns false if it was cancelled through the progress reporter.
   bool ExtractAndMatchFeatures();
 
   // Initializes the reconstruction and view graph explicitly. This method
@@ -171,7 +244,34 @@ class ReconstructionBuilder {
   // successfully estimated.
   bool BuildReconstruction(std::vector<Reconstruction*>* reconstructions);
 
+  // Same as above, but also returns the summary of the estimation of each
+  // reconstruction (e.g., the time spent in each stage of the estimator).
+  bool BuildReconstruction(
+      std::vector<Reconstruction*>* reconstructions,
+      std::vector<ReconstructionEstimatorSummary>* summaries);
+
  private:
+  // Estimates reconstructions until no more views can be estimated. See
+  // BuildReconstruction.
+  bool EstimateReconstructions(
+      std::vector<Reconstruction*>* reconstructions,
+      std::vector<ReconstructionEstimatorSummary>* summaries);
+
+  // Reconstructs the connected components of the view graph in parallel and
+  // removes their estimated views and tracks (and all views of components that
+  // could not be reconstructed) from the input. Returns false if cancelled.
+  bool EstimateConnectedComponentsInParallel(
+      std::vector<Reconstruction*>* reconstructions,
+      std::vector<ReconstructionEstimatorSummary>* summaries);
+
+  // Appends the estimated reconstruction to the output and hands it to the
+  // reconstruction callback, if any.
+  void OutputReconstruction(Reconstruction* reconstruction,
+                            std::vector<Reconstruction*>* reconstructions);
+
+  // Returns true if the progress reporter has been cancelled.
+  bool IsCancelled() const;
+
   // Adds the given matches as edges in the view graph.
   void AddMatchToViewGraph(const ViewId view_id1,
                            const ViewId view_id2,
@@ -196,6 +296,10 @@ class ReconstructionBuilder {
   // Container of image information.
   std::vector<std::string> image_filepaths_;
 
+  // The number of view pairs whose correspondences were not added to the track
+  // builder because of the memory budget.
+  int num_matches_without_tracks_;
+
   // Module for performing feature extraction and matching.
   std::unique_ptr<FeatureExtractorAndMatcher> feature_extractor_and_matcher_;
 
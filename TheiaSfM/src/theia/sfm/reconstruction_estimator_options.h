@@ -41,6 +41,7 @@
 #include "theia/sfm/global_pose_estimation/least_unsquared_deviation_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/linear_position_estimator.h"
 #include "theia/sfm/global_pose_estimation/nonlinear_position_estimator.h"
+#include "theia/util/progress_reporter.h"
 #include "theia/util/random.h"
 
 namespace theia {
@@ -98,6 +99,18 @@ struct ReconstructionEstimatorOptions {
   // Number of threads to use.
   int num_threads = 1;
 
+  // If set, the estimators report their progress (and that of bundle
+  // adjustment) to it and stop early with a failure when it is cancelled.
+  std::shared_ptr<ProgressReporter> progress_reporter;
+
+  // If true, the shared intrinsics of each camera intrinsics group get an
+  // undistortion lookup table (see camera/undistortion_lookup_table.h) at the
+  // start of the estimation, and the table is rebuilt after bundle adjustment
+  // has changed the intrinsics. This speeds up feature normalization for
+  // localization, triangulation and relative translation refinement with
+  // models that undistort iteratively (e.g. fisheye).
+  bool use_undistortion_lookup_tables = false;
+
   // Maximum reprojection error. This is the threshold used for filtering
   // outliers after bundle adjustment.
   double max_reprojection_error_in_pixels = 5.0;
@@ -153,17 +166,62 @@ struct ReconstructionEstimatorOptions {
   // Robust loss function scales for nonlinear estimation.
   double rotation_estimation_robust_loss_scale = 0.1;
 
+  // If true, the ROBUST_L1L2 and NONLINEAR rotation estimators are initialized
+  // with the chordal L2 rotation averaging of all view pairs (see
+  // theia/sfm/global_pose_estimation/orientations_from_chordal_l2.h) instead of
+  // chaining the relative rotations along the maximum spanning tree. This is a
+  // more accurate initialization at the cost of one sparse linear solve.
+  bool initialize_rotations_with_chordal_l2 = false;
+
   // --------------- Global Position Estimation Options --------------- //
   NonlinearPositionEstimator::Options nonlinear_position_estimator_options;
   LinearPositionEstimator::Options linear_triplet_position_estimator_options;
   LeastUnsquaredDeviationPositionEstimator::Options
       least_unsquared_deviation_position_estimator_options;
 
+  // If true, global SfM uses the position priors of the views. GPS priors are
+  // converted to East-North-Up position priors in meters with
+  // SetPositionPriorsFromGPS. The priors initialize the nonlinear and least
+  // unsquared deviation position estimators, the estimated camera poses are
+  // aligned to the priors with a robust similarity transformation, and bundle
+  // adjustment then adds a residual position_prior_weight * (position - prior)
+  // for each view with a prior. The weight is relative to reprojection errors
+  // in pixels, so it is roughly the inverse of the prior noise in meters. Use
+  // NonlinearPositionEstimator::Options::position_prior_weight to also add the
+  // priors as residuals to nonlinear position estimation.
+  bool use_position_priors = false;
+  double position_prior_weight = 0.1;
+
+  // The estimated camera positions are aligned to the position priors with
+  // RANSAC. A prior is an inlier if its distance to the aligned position is
+  // below this threshold in meters.
+  double position_prior_alignment_threshold_meters = 10.0;
+
   // For global SfM it may be advantageous to run a partial bundle adjustment
   // optimizing only the camera positions and 3d points while holding camera
   // orientation and intrinsics constant.
   bool refine_camera_positions_and_points_after_position_estimation = true;
 
+  // --------------- Partitioned Global SfM Options --------------- //
+
+  // If greater than 0 and the view graph has more views than this, global SfM
+  // partitions the view graph into overlapping clusters of at most this many
+  // views (not counting the overlapping views) with PartitionViewGraph. The
+  // camera poses of each cluster are estimated in parallel with its own global
+  // SfM estimator (without triangulation or bundle adjustment), and the
+  // clusters are aligned with robust similarity transformations to obtain the
+  // initial camera poses. All views are then triangulated and bundle adjusted
+  // together. This bounds the size (and memory) of rotation and position
+  // estimation for very large view graphs. Values between 1 and 9 are raised to
+  // 10.
+  int max_num_views_per_partition = 0;
+
+  // Each cluster is extended with up to this many views of each neighboring
+  // cluster. Clusters that share fewer than 4 estimated views with the others,
+  // or whose shared views do not agree on a similarity transformation, cannot
+  // be aligned and their views are left unestimated.
+  int num_overlapping_views_per_partition = 10;
+
   // --------------------- Incremental SfM Options --------------------- //
 
   // If M is the maximum number of 3D points observed by any view, we want to
@@ -208,6 +266,14 @@ struct ReconstructionEstimatorOptions {
   // parameter.
   double relative_position_estimation_max_sampson_error_pixels = 4.0;
 
+  // If true, hybrid SfM localizes all candidate views of each round in
+  // parallel by estimating only their positions with the known global
+  // orientations. The new views are then triangulated together and a single
+  // (partial or full) bundle adjustment is run per round. Views that cannot be
+  // localized this way are retried in later rounds, and if no view of a round
+  // can be localized the views are localized one at a time as usual.
+  bool localize_views_in_parallel_with_known_orientation = false;
+
   // --------------- Triangulation Options --------------- //
 
   // Minimum angle required between a 3D point and 2 viewing rays in order to
@@ -298,6 +364,17 @@ struct ReconstructionEstimatorOptions {
   // track subsampling. If the view does not observe this many tracks, then all
   // tracks in the view are optimized.
   int min_num_optimized_tracks_per_view = 200;
+
+  // If true, global SfM only triangulates and bundle adjusts a subset of the
+  // tracks that is chosen before triangulation with the image grid above: the
+  // best connected tracks of each grid cell are kept, up to
+  // max_num_tracks_per_grid_cell_before_triangulation per cell, and each view
+  // keeps at least min_num_optimized_tracks_per_view tracks. The remaining
+  // tracks are triangulated without bundle adjustment once the camera poses
+  // have been refined. For dense features this greatly reduces the size of
+  // the bundle adjustment problems.
+  bool subsample_tracks_before_triangulation = false;
+  int max_num_tracks_per_grid_cell_before_triangulation = 2;
 };
 
 }  // namespace theia
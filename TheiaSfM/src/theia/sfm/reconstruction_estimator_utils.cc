@@ -40,6 +40,7 @@
 
 #include <algorithm>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "theia/matching/feature_correspondence.h"
@@ -117,6 +118,7 @@ BundleAdjustmentOptions SetBundleAdjustmentOptions(
   ba_options.robust_loss_width = options.bundle_adjustment_robust_loss_width;
   ba_options.use_inner_iterations = true;
   ba_options.intrinsics_to_optimize = options.intrinsics_to_optimize;
+  ba_options.progress_reporter = options.progress_reporter;
 
   if (num_views >= options.min_cameras_for_iterative_solver) {
     ba_options.linear_solver_type = ceres::ITERATIVE_SCHUR;
@@ -246,26 +248,51 @@ void RefineRelativeTranslationsWithKnownRotations(
     const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
     const int num_threads,
     ViewGraph* view_graph) {
+  // Split the edges into a few chunks per thread so that the load stays
+  // balanced when the number of correspondences varies between view pairs.
+  static const int kNumChunksPerThread = 4;
   CHECK_GE(num_threads, 1);
-  const auto& view_pairs = view_graph->GetAllEdges();
 
-  ThreadPool pool(num_threads);
-  // Refine the translation estimation for each view pair.
+  // Collect the edges up front so that the threads only read the view graph.
+  const auto& view_pairs = view_graph->GetAllEdges();
+  std::vector<std::pair<ViewIdPair, TwoViewInfo*> > edges;
+  edges.reserve(view_pairs.size());
   for (const auto& view_pair : view_pairs) {
-    // Get all feature correspondences common to both views.
-    std::vector<FeatureCorrespondence> matches;
-    const View* view1 = reconstruction.View(view_pair.first.first);
-    const View* view2 = reconstruction.View(view_pair.first.second);
-    GetNormalizedFeatureCorrespondences(*view1, *view2, &matches);
-
-    TwoViewInfo* info = view_graph->GetMutableEdge(view_pair.first.first,
-                                                   view_pair.first.second);
-    pool.Add(OptimizeRelativePositionWithKnownRotation,
-             matches,
-             FindOrDie(orientations, view_pair.first.first),
-             FindOrDie(orientations, view_pair.first.second),
-             &info->position_2);
+    edges.emplace_back(view_pair.first,
+                       view_graph->GetMutableEdge(view_pair.first.first,
+                                                  view_pair.first.second));
+  }
+  if (edges.empty()) {
+    return;
   }
+
+  // Refine the translation estimation for each batch of view pairs. The
+  // correspondences and solver buffers are reused across the edges of a batch.
+  const auto refine_edges = [&](const int, const int begin, const int end) {
+    std::vector<FeatureCorrespondence> matches;
+    RelativePositionOptimizationWorkspace workspace;
+    for (int i = begin; i < end; i++) {
+      const ViewIdPair& view_id_pair = edges[i].first;
+      const View* view1 = reconstruction.View(view_id_pair.first);
+      const View* view2 = reconstruction.View(view_id_pair.second);
+
+      // Get all feature correspondences common to both views.
+      matches.clear();
+      GetNormalizedFeatureCorrespondences(*view1, *view2, &matches);
+
+      OptimizeRelativePositionWithKnownRotation(
+          matches,
+          FindOrDie(orientations, view_id_pair.first),
+          FindOrDie(orientations, view_id_pair.second),
+          &workspace,
+          &edges[i].second->position_2);
+    }
+  };
+
+  const int num_edges = edges.size();
+  const int num_chunks =
+      std::min(num_edges, num_threads * kNumChunksPerThread);
+  ParallelFor(num_threads, num_chunks, num_edges, refine_edges);
 }
 
 int SetUnderconstrainedTracksToUnestimated(Reconstruction* reconstruction) {
@@ -329,6 +356,34 @@ int SetUnderconstrainedViewsToUnestimated(Reconstruction* reconstruction) {
   return num_underconstrained_views;
 }
 
+void UpdateUndistortionLookupTables(const int num_threads,
+                                    Reconstruction* reconstruction) {
+  // The views of a group share their intrinsics, so one camera per group is
+  // enough.
+  std::vector<Camera*> cameras;
+  for (const CameraIntrinsicsGroupId group_id :
+       reconstruction->CameraIntrinsicsGroupIds()) {
+    for (const ViewId view_id :
+         reconstruction->GetViewsInCameraIntrinsicGroup(group_id)) {
+      Camera* camera = reconstruction->MutableView(view_id)->MutableCamera();
+      if (camera->ImageWidth() > 0 && camera->ImageHeight() > 0) {
+        cameras.emplace_back(camera);
+        break;
+      }
+    }
+  }
+
+  if (cameras.empty()) {
+    return;
+  }
+  ParallelFor(std::max(1, num_threads),
+              cameras.size(),
+              cameras.size(),
+              [&cameras](const int camera, const int, const int) {
+                cameras[camera]->EnableUndistortionLookupTable();
+              });
+}
+
 int NumEstimatedViews(const Reconstruction& reconstruction) {
   int num_estimated_views = 0;
   for (const ViewId view_id : reconstruction.ViewIds()) {
@@ -110,6 +110,13 @@ int SetUnderconstrainedTracksToUnestimated(Reconstruction* reconstruction);
 // Returns the number of views set to unestimated.
 int SetUnderconstrainedViewsToUnestimated(Reconstruction* reconstruction);
 
+// Builds or rebuilds the undistortion lookup table of the shared intrinsics of
+// each camera intrinsics group whose views have a known image size. Tables
+// that are still valid for the intrinsics are kept, so this is cheap when the
+// intrinsics did not change. The groups are processed with num_threads.
+void UpdateUndistortionLookupTables(const int num_threads,
+                                    Reconstruction* reconstruction);
+
 // Return the number of estimated views or tracks in the reconstruction.
 int NumEstimatedViews(const Reconstruction& reconstruction);
 int NumEstimatedTracks(const Reconstruction& reconstruction);
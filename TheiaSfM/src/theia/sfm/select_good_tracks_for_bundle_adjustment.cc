@@ -40,10 +40,14 @@
 #include <utility>
 #include <vector>
 
+#include <Eigen/Core>
+#include <glog/logging.h>
+
 #include "theia/sfm/camera/camera.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/reconstruction_estimator_utils.h"
 #include "theia/sfm/track.h"
+#include "theia/sfm/track_reprojection_statistics.h"
 #include "theia/sfm/types.h"
 #include "theia/sfm/view.h"
 #include "theia/util/hash.h"
@@ -65,48 +69,6 @@ bool CompareGridCellElements(
   return element1.second < element2.second;
 }
 
-// Return the squared reprojection error of the track in the view.
-inline double ComputeSqReprojectionError(const View& view,
-                                         const Feature& feature,
-                                         const Track& track) {
-  Eigen::Vector2d reprojected_feature;
-  view.Camera().ProjectPoint(track.Point(), &reprojected_feature);
-  return (reprojected_feature - feature).squaredNorm();
-}
-
-// Compute the reprojection error and truncated track length for this specific
-// track.
-TrackStatistics ComputeStatisticsForTrack(
-    const Reconstruction& reconstruction,
-    const TrackId track_id,
-    const int long_track_length_threshold) {
-  // Any tracks that reach this function are guaranteed to exist and be
-  // estimated, so no need to check for that here.
-  const Track* track = reconstruction.Track(track_id);
-  const auto& views_observing_track = track->ViewIds();
-
-  double sq_reprojection_error_sum = 0.0;
-  int num_valid_reprojections = 0;
-  // Compute the sq reprojection error for each view that observes the track
-  // and it it to the accumulating sum.
-  for (const ViewId view_id : views_observing_track) {
-    const View* view = reconstruction.View(view_id);
-    if (view == nullptr || !view->IsEstimated()) {
-      continue;
-    }
-    sq_reprojection_error_sum +=
-        ComputeSqReprojectionError(*view, *view->GetFeature(track_id), *track);
-    ++num_valid_reprojections;
-  }
-
-  // Compute and return the track statistics.
-  const int truncated_track_length =
-      std::min(num_valid_reprojections, long_track_length_threshold);
-  const double mean_sq_reprojection_error =
-      sq_reprojection_error_sum / static_cast<double>(num_valid_reprojections);
-  return TrackStatistics(truncated_track_length, mean_sq_reprojection_error);
-}
-
 // Compute the mean reprojection error and the truncated track length of each
 // track. We truncate the track length based on the observation that while
 // larger track lengths provide better constraints for bundle adjustment, larger
@@ -114,85 +76,158 @@ TrackStatistics ComputeStatisticsForTrack(
 // the track lengths enforces that the long tracks with the lowest reprojection
 // error are chosen.
 void ComputeTrackStatistics(
+    const Reconstruction& reconstruction,
+    const std::unordered_set<ViewId>& view_ids,
+    const int long_track_length_threshold,
+    const int num_threads,
+    std::unordered_map<TrackId, TrackStatistics>* track_statistics) {
+  // Collect the estimated tracks observed by the views.
+  std::unordered_set<TrackId> visited_tracks;
+  std::vector<TrackId> track_ids;
+  for (const ViewId view_id : view_ids) {
+    const View* view = reconstruction.View(view_id);
+    for (const TrackId track_id : view->TrackIds()) {
+      const Track* track = reconstruction.Track(track_id);
+      if (track == nullptr || !track->IsEstimated() ||
+          !visited_tracks.emplace(track_id).second) {
+        continue;
+      }
+      track_ids.emplace_back(track_id);
+    }
+  }
+
+  // Compute the reprojection errors of all tracks in parallel.
+  TrackReprojectionStatisticsOptions options;
+  options.num_threads = num_threads;
+  std::vector<TrackReprojectionStatistics> reprojection_statistics;
+  ComputeTrackReprojectionStatistics(options,
+                                     reconstruction,
+                                     track_ids,
+                                     &reprojection_statistics,
+                                     nullptr);
+
+  track_statistics->reserve(track_ids.size());
+  for (int i = 0; i < track_ids.size(); i++) {
+    const int truncated_track_length =
+        std::min(reprojection_statistics[i].num_observations,
+                 long_track_length_threshold);
+    track_statistics->emplace(
+        track_ids[i],
+        TrackStatistics(truncated_track_length,
+                        reprojection_statistics[i].mean_sq_reprojection_error));
+  }
+}
+
+// Computes the statistics used to rank tracks that have not been triangulated
+// yet. Such tracks are ranked by their (truncated) number of estimated views
+// first, and then by the largest angle between the viewing ray of the first
+// observation and the others. Since the smallest statistics are selected first,
+// the track length is negated so that tracks with more estimated views come
+// first, and the cosine of the angle is kept so that wider angles come first.
+// Unlike in ComputeTrackStatistics, the track length is negated here. Tracks
+// that are observed by fewer than 2 estimated views are skipped.
+void ComputeStatisticsForUnestimatedTracks(
     const Reconstruction& reconstruction,
     const std::unordered_set<ViewId>& view_ids,
     const int long_track_length_threshold,
     std::unordered_map<TrackId, TrackStatistics>* track_statistics) {
-  // Iterate over all views and compute the track statistics for each track we
-  // encounter.
+  std::unordered_set<TrackId> visited_tracks;
   for (const ViewId view_id : view_ids) {
     const View* view = reconstruction.View(view_id);
-    const auto& tracks_in_view = view->TrackIds();
-    // Compute statistics for each track in this view that we have not already
-    // computed statistics for.
-    for (const TrackId track_id : tracks_in_view) {
+    for (const TrackId track_id : view->TrackIds()) {
       const Track* track = reconstruction.Track(track_id);
-      // Skip this track if the statistics were already computed, or if the
-      // track has not been estimated.
-      if (ContainsKey(*track_statistics, track_id) || track == nullptr ||
-          !track->IsEstimated()) {
+      if (track == nullptr || track->IsEstimated() ||
+          !visited_tracks.emplace(track_id).second) {
         continue;
       }
 
-      // Compute the track statistics and add it to the output map.
-      const TrackStatistics& statistics_for_this_track =
-          ComputeStatisticsForTrack(reconstruction,
-                                    track_id,
-                                    long_track_length_threshold);
-      track_statistics->emplace(track_id, statistics_for_this_track);
+      int num_estimated_views = 0;
+      double min_cos_angle = 1.0;
+      Eigen::Vector3d first_ray;
+      for (const ViewId observing_view_id : track->ViewIds()) {
+        const View* observing_view = reconstruction.View(observing_view_id);
+        if (observing_view == nullptr || !observing_view->IsEstimated()) {
+          continue;
+        }
+        const Eigen::Vector3d ray =
+            observing_view->Camera()
+                .PixelToUnitDepthRay(*observing_view->GetFeature(track_id))
+                .normalized();
+        if (num_estimated_views == 0) {
+          first_ray = ray;
+        } else {
+          min_cos_angle = std::min(min_cos_angle, first_ray.dot(ray));
+        }
+        ++num_estimated_views;
+      }
+
+      if (num_estimated_views < 2) {
+        continue;
+      }
+      const int truncated_track_length =
+          std::min(num_estimated_views, long_track_length_threshold);
+      track_statistics->emplace(
+          track_id, TrackStatistics(-truncated_track_length, min_cos_angle));
     }
   }
 }
 
-// Select tracks from the image to ensure good spatial coverage of the image. To
-// do this, we first bin the tracks into grid cells in an image grid. Then
-// within each cell we find the best ranked track and add it to the list of
-// tracks to optimize.
+// Select tracks from the image to ensure good spatial coverage. To do this, we
+// first bin the tracks into grid cells in an image grid. Then within each cell
+// we find the best ranked tracks and add them to the list of selected tracks.
+// Only tracks with statistics are considered.
 void SelectBestTracksFromEachImageGridCell(
-    const Reconstruction& reconstruction,
     const View& view,
     const int grid_cell_size,
+    const int max_num_tracks_per_grid_cell,
     const std::unordered_map<TrackId, TrackStatistics>& track_statistics,
     std::unordered_set<TrackId>* tracks_to_optimize) {
-  static const double inv_grid_cell_size =  1.0 / grid_cell_size;
+  const double inv_grid_cell_size =  1.0 / grid_cell_size;
 
   // Hash each feature into a grid cell.
   ImageGrid image_grid;
   const auto& track_ids = view.TrackIds();
   for (const TrackId track_id : track_ids) {
-    const Track* track = reconstruction.Track(track_id);
-    if (track == nullptr || !track->IsEstimated()) {
+    const TrackStatistics* current_track_statistics =
+        FindOrNull(track_statistics, track_id);
+    if (current_track_statistics == nullptr) {
       continue;
     }
 
     const Feature& feature = *view.GetFeature(track_id);
-    const TrackStatistics& current_track_statistics =
-        FindOrDieNoPrint(track_statistics, track_id);
     const Eigen::Vector2i grid_cell =
         (feature * inv_grid_cell_size).cast<int>();
 
-    image_grid[grid_cell].emplace_back(track_id, current_track_statistics);
+    image_grid[grid_cell].emplace_back(track_id, *current_track_statistics);
   }
 
-  // Select the best feature from each grid cell and add it to the tracks to
+  // Select the best features from each grid cell and add them to the tracks to
   // optimize.
   for (auto& grid_cell : image_grid) {
-    // Order the features in each cell by track length first, then mean
-    // reprojection error.
-    const GridCellElement& grid_cell_element =
-        *std::min_element(grid_cell.second.begin(),
-                          grid_cell.second.end(),
-                          CompareGridCellElements);
-
-    // Insert the track id in to the tracks to optimize.
-    tracks_to_optimize->emplace(grid_cell_element.first);
+    auto& elements = grid_cell.second;
+    // Order the features in each cell by their track statistics.
+    const int num_selected_tracks = std::min(
+        max_num_tracks_per_grid_cell, static_cast<int>(elements.size()));
+    if (num_selected_tracks == 1) {
+      tracks_to_optimize->emplace(
+          std::min_element(elements.begin(), elements.end(),
+                           CompareGridCellElements)->first);
+      continue;
+    }
+
+    std::partial_sort(elements.begin(),
+                      elements.begin() + num_selected_tracks,
+                      elements.end(),
+                      CompareGridCellElements);
+    for (int i = 0; i < num_selected_tracks; i++) {
+      tracks_to_optimize->emplace(elements[i].first);
+    }
   }
 }
 
 // Selects the top ranked tracks that have not already been chosen until the
 // view observes the minimum number of optimized tracks.
 void SelectTopRankedTracksInView(
-    const Reconstruction& reconstruction,
     const std::unordered_map<TrackId, TrackStatistics>& track_statistics,
     const View& view,
     const int min_num_optimized_tracks_per_view,
@@ -203,11 +238,11 @@ void SelectTopRankedTracksInView(
   const auto& tracks_in_view = view.TrackIds();
   std::vector<GridCellElement> ranked_candidate_tracks;
   for (const TrackId track_id : tracks_in_view) {
-    const Track* track = reconstruction.Track(track_id);
-    if (track == nullptr || !track->IsEstimated()) {
+    const TrackStatistics* statistics = FindOrNull(track_statistics, track_id);
+    if (statistics == nullptr) {
       continue;
     }
-    // We only reach this point if the track is estimated.
+    // We only reach this point if the track is a candidate.
     ++num_estimated_tracks;
 
     // If the track is already slated for optimization, increase the count of
@@ -223,8 +258,7 @@ void SelectTopRankedTracksInView(
     } else {
       // If the track is not already set to be optimized then add it to the list
       // of candidate tracks.
-      ranked_candidate_tracks.emplace_back(
-          track_id, FindOrDieNoPrint(track_statistics, track_id));
+      ranked_candidate_tracks.emplace_back(track_id, *statistics);
     }
   }
 
@@ -240,7 +274,8 @@ void SelectTopRankedTracksInView(
     std::partial_sort(
         ranked_candidate_tracks.begin(),
         ranked_candidate_tracks.begin() + num_optimized_tracks_needed,
-        ranked_candidate_tracks.end());
+        ranked_candidate_tracks.end(),
+        CompareGridCellElements);
     // Add the candidate tracks to the list of tracks to be optimized.
     for (int i = 0; i < num_optimized_tracks_needed; i++) {
       tracks_to_optimize->emplace(ranked_candidate_tracks[i].first);
@@ -266,6 +301,7 @@ bool SelectGoodTracksForBundleAdjustment(
     const int long_track_length_threshold,
     const int image_grid_cell_size_pixels,
     const int min_num_optimized_tracks_per_view,
+    const int num_threads,
     std::unordered_set<TrackId>* tracks_to_optimize) {
   std::unordered_set<ViewId> view_ids;
   GetEstimatedViewsFromReconstruction(reconstruction, &view_ids);
@@ -274,6 +310,7 @@ bool SelectGoodTracksForBundleAdjustment(
                                              long_track_length_threshold,
                                              image_grid_cell_size_pixels,
                                              min_num_optimized_tracks_per_view,
+                                             num_threads,
                                              tracks_to_optimize);
 }
 
@@ -283,12 +320,14 @@ bool SelectGoodTracksForBundleAdjustment(
     const int long_track_length_threshold,
     const int image_grid_cell_size_pixels,
     const int min_num_optimized_tracks_per_view,
+    const int num_threads,
     std::unordered_set<TrackId>* tracks_to_optimize) {
   // Compute the track mean reprojection errors.
   std::unordered_map<TrackId, TrackStatistics> track_statistics;
   ComputeTrackStatistics(reconstruction,
                          view_ids,
                          long_track_length_threshold,
+                         num_threads,
                          &track_statistics);
 
   // For each image, divide the image into a grid and choose the highest quality
@@ -299,9 +338,9 @@ bool SelectGoodTracksForBundleAdjustment(
 
     // Select the best tracks from each grid cell in the image and add them to
     // the container of tracks to be optimized.
-    SelectBestTracksFromEachImageGridCell(reconstruction,
-                                          *view,
+    SelectBestTracksFromEachImageGridCell(*view,
                                           image_grid_cell_size_pixels,
+                                          1,
                                           track_statistics,
                                           tracks_to_optimize);
   }
@@ -315,8 +354,7 @@ bool SelectGoodTracksForBundleAdjustment(
 
     // If this view is not constrained by enough optimized tracks, add the top
     // ranked features until there are enough tracks constraining the view.
-    SelectTopRankedTracksInView(reconstruction,
-                                track_statistics,
+    SelectTopRankedTracksInView(track_statistics,
                                 *view,
                                 min_num_optimized_tracks_per_view,
                                 tracks_to_optimize);
@@ -325,4 +363,44 @@ bool SelectGoodTracksForBundleAdjustment(
   return true;
 }
 
+bool SelectGoodTracksForTriangulation(
+    const Reconstruction& reconstruction,
+    const int long_track_length_threshold,
+    const int image_grid_cell_size_pixels,
+    const int max_num_tracks_per_grid_cell,
+    const int min_num_tracks_per_view,
+    std::unordered_set<TrackId>* tracks_to_triangulate) {
+  CHECK_GT(image_grid_cell_size_pixels, 0);
+  CHECK_GT(max_num_tracks_per_grid_cell, 0);
+  std::unordered_set<ViewId> view_ids;
+  GetEstimatedViewsFromReconstruction(reconstruction, &view_ids);
+
+  std::unordered_map<TrackId, TrackStatistics> track_statistics;
+  ComputeStatisticsForUnestimatedTracks(reconstruction,
+                                        view_ids,
+                                        long_track_length_threshold,
+                                        &track_statistics);
+  if (track_statistics.empty()) {
+    return false;
+  }
+
+  // Choose the best connected tracks from each grid cell of each image for
+  // good spatial coverage, then make sure each view observes enough tracks.
+  for (const ViewId view_id : view_ids) {
+    SelectBestTracksFromEachImageGridCell(*reconstruction.View(view_id),
+                                          image_grid_cell_size_pixels,
+                                          max_num_tracks_per_grid_cell,
+                                          track_statistics,
+                                          tracks_to_triangulate);
+  }
+  for (const ViewId view_id : view_ids) {
+    SelectTopRankedTracksInView(track_statistics,
+                                *reconstruction.View(view_id),
+                                min_num_tracks_per_view,
+                                tracks_to_triangulate);
+  }
+
+  return true;
+}
+
 }  // namespace theia
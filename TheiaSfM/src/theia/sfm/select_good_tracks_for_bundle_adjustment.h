@@ -64,12 +64,14 @@ class Reconstruction;
 //
 // We recommend the grid cell size is set to 100 pixels, the long track length
 // threshold is set to 10, and the min num optimized tracks per view is set to
-// 100.
+// 100. The reprojection errors of the tracks are computed with num_threads
+// threads.
 bool SelectGoodTracksForBundleAdjustment(
     const Reconstruction& reconstruction,
     const int long_track_length_threshold,
     const int image_grid_cell_size_pixels,
     const int min_num_optimized_tracks_per_view,
+    const int num_threads,
     std::unordered_set<TrackId>* tracks_to_optimize);
 
 // Same as above, but only selecting tracks from the set of views provided.
@@ -79,8 +81,25 @@ bool SelectGoodTracksForBundleAdjustment(
     const int long_track_length_threshold,
     const int image_grid_cell_size_pixels,
     const int min_num_optimized_tracks_per_view,
+    const int num_threads,
     std::unordered_set<TrackId>* tracks_to_optimize);
 
+// Selects the tracks to triangulate before the camera poses are refined. Tracks
+// that are not triangulated yet are ranked by the number of estimated views
+// observing them (truncated to long_track_length_threshold) and then by their
+// triangulation angle. Up to max_num_tracks_per_grid_cell of the best tracks
+// of each image grid cell are chosen, and top ranked tracks are added to views
+// that observe fewer than min_num_tracks_per_view chosen tracks. The remaining
+// tracks can be triangulated once the camera poses are refined. Returns false
+// if there are no tracks to select from.
+bool SelectGoodTracksForTriangulation(
+    const Reconstruction& reconstruction,
+    const int long_track_length_threshold,
+    const int image_grid_cell_size_pixels,
+    const int max_num_tracks_per_grid_cell,
+    const int min_num_tracks_per_view,
+    std::unordered_set<TrackId>* tracks_to_triangulate);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_SELECT_GOOD_TRACKS_FOR_BUNDLE_ADJUSTMENT_H_
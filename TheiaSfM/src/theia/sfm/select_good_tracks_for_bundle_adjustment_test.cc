@@ -0,0 +1,150 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include <Eigen/Core>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/select_good_tracks_for_bundle_adjustment.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/map_util.h"
+
+namespace theia {
+
+namespace {
+
+// Adds estimated views on a line that look down the z-axis.
+void AddViews(const int num_views, Reconstruction* reconstruction) {
+  for (int i = 0; i < num_views; i++) {
+    const ViewId view_id = reconstruction->AddView(std::to_string(i));
+    View* view = reconstruction->MutableView(view_id);
+    Camera* camera = view->MutableCamera();
+    camera->SetPosition(Eigen::Vector3d(i, 0, 0));
+    camera->SetFocalLength(500);
+    camera->SetPrincipalPoint(500, 500);
+    camera->SetImageSize(1000, 1000);
+    view->SetEstimated(true);
+  }
+}
+
+// Adds a track that is observed at the given pixel in the first num_views
+// views.
+TrackId AddTrack(const int num_views,
+                 const Eigen::Vector2d& pixel,
+                 Reconstruction* reconstruction) {
+  std::vector<std::pair<ViewId, Feature> > features;
+  for (int i = 0; i < num_views; i++) {
+    const Eigen::Vector2d offset(10.0 * i, 0.0);
+    features.emplace_back(reconstruction->ViewIdFromName(std::to_string(i)),
+                          pixel - offset);
+  }
+  return reconstruction->AddTrack(features);
+}
+
+}  // namespace
+
+TEST(SelectGoodTracksForTriangulation, PrefersLongTracksInEachGridCell) {
+  Reconstruction reconstruction;
+  AddViews(3, &reconstruction);
+
+  // All tracks fall into the same grid cell of each view.
+  std::unordered_set<TrackId> long_tracks;
+  for (int i = 0; i < 10; i++) {
+    AddTrack(2, Eigen::Vector2d(150.0 + i, 150.0), &reconstruction);
+  }
+  for (int i = 0; i < 3; i++) {
+    long_tracks.emplace(
+        AddTrack(3, Eigen::Vector2d(160.0 + i, 160.0), &reconstruction));
+  }
+
+  static const int kMaxNumTracksPerGridCell = 2;
+  std::unordered_set<TrackId> tracks_to_triangulate;
+  EXPECT_TRUE(SelectGoodTracksForTriangulation(reconstruction,
+                                               10,
+                                               100,
+                                               kMaxNumTracksPerGridCell,
+                                               0,
+                                               &tracks_to_triangulate));
+  EXPECT_EQ(tracks_to_triangulate.size(), kMaxNumTracksPerGridCell);
+  for (const TrackId track_id : tracks_to_triangulate) {
+    EXPECT_TRUE(ContainsKey(long_tracks, track_id));
+  }
+}
+
+TEST(SelectGoodTracksForTriangulation, MinNumTracksPerView) {
+  Reconstruction reconstruction;
+  AddViews(2, &reconstruction);
+  for (int i = 0; i < 20; i++) {
+    AddTrack(2, Eigen::Vector2d(150.0 + i, 150.0), &reconstruction);
+  }
+  // Tracks in other grid cells are always selected.
+  AddTrack(2, Eigen::Vector2d(550.0, 550.0), &reconstruction);
+  AddTrack(2, Eigen::Vector2d(750.0, 550.0), &reconstruction);
+
+  static const int kMinNumTracksPerView = 8;
+  std::unordered_set<TrackId> tracks_to_triangulate;
+  EXPECT_TRUE(SelectGoodTracksForTriangulation(reconstruction,
+                                               10,
+                                               100,
+                                               1,
+                                               kMinNumTracksPerView,
+                                               &tracks_to_triangulate));
+  EXPECT_EQ(tracks_to_triangulate.size(), kMinNumTracksPerView);
+}
+
+TEST(SelectGoodTracksForTriangulation, SkipsEstimatedTracks) {
+  Reconstruction reconstruction;
+  AddViews(2, &reconstruction);
+  const TrackId estimated_track_id =
+      AddTrack(2, Eigen::Vector2d(150.0, 150.0), &reconstruction);
+  reconstruction.MutableTrack(estimated_track_id)->SetEstimated(true);
+
+  std::unordered_set<TrackId> tracks_to_triangulate;
+  EXPECT_FALSE(SelectGoodTracksForTriangulation(
+      reconstruction, 10, 100, 1, 10, &tracks_to_triangulate));
+
+  const TrackId track_id =
+      AddTrack(2, Eigen::Vector2d(160.0, 150.0), &reconstruction);
+  EXPECT_TRUE(SelectGoodTracksForTriangulation(
+      reconstruction, 10, 100, 1, 10, &tracks_to_triangulate));
+  EXPECT_EQ(tracks_to_triangulate.size(), 1);
+  EXPECT_TRUE(ContainsKey(tracks_to_triangulate, track_id));
+}
+
+}  // namespace theia
@@ -34,21 +34,20 @@
 
 #include "theia/sfm/set_outlier_tracks_to_unestimated.h"
 
-#include <Eigen/Core>
 #include <glog/logging.h>
 #include <unordered_set>
+#include <vector>
 
-#include "theia/sfm/camera/camera.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/track.h"
+#include "theia/sfm/track_reprojection_statistics.h"
 #include "theia/sfm/types.h"
-#include "theia/sfm/view.h"
-#include "theia/sfm/triangulation/triangulation.h"
 
 namespace theia {
 
 int SetOutlierTracksToUnestimated(const double max_inlier_reprojection_error,
                                   const double min_triangulation_angle_degrees,
+                                  const int num_threads,
                                   Reconstruction* reconstruction) {
   const auto& track_ids = reconstruction->TrackIds();
   const std::unordered_set<TrackId> all_tracks(track_ids.begin(),
@@ -56,70 +55,61 @@ int SetOutlierTracksToUnestimated(const double max_inlier_reprojection_error,
   return SetOutlierTracksToUnestimated(all_tracks,
                                        max_inlier_reprojection_error,
                                        min_triangulation_angle_degrees,
+                                       num_threads,
                                        reconstruction);
 }
 
 int SetOutlierTracksToUnestimated(const std::unordered_set<TrackId>& track_ids,
                                   const double max_inlier_reprojection_error,
                                   const double min_triangulation_angle_degrees,
+                                  const int num_threads,
                                   Reconstruction* reconstruction) {
   const double max_sq_reprojection_error =
       max_inlier_reprojection_error * max_inlier_reprojection_error;
 
-  int num_estimated_tracks = 0;
-  int num_bad_reprojections = 0;
-  int num_insufficient_viewing_angles = 0;
-
+  // Only the estimated tracks are checked.
+  std::vector<TrackId> estimated_track_ids;
+  estimated_track_ids.reserve(track_ids.size());
   for (const TrackId track_id : track_ids) {
-    Track* track = reconstruction->MutableTrack(track_id);
-    if (!track->IsEstimated()) {
-      continue;
+    const Track* track = CHECK_NOTNULL(reconstruction->Track(track_id));
+    if (track->IsEstimated()) {
+      estimated_track_ids.emplace_back(track_id);
     }
-    ++num_estimated_tracks;
-
-    std::vector<Eigen::Vector3d> ray_directions;
-    const auto& view_ids = track->ViewIds();
-    int num_projections = 0;
-    double mean_sq_reprojection_error = 0;
-    for (const ViewId view_id : view_ids) {
-      const View* view = CHECK_NOTNULL(reconstruction->View(view_id));
-      if (!view->IsEstimated()) {
-        continue;
-      }
-
-      const Camera& camera = view->Camera();
-      const Eigen::Vector3d ray_direction =
-          track->Point().hnormalized() - camera.GetPosition();
-      ray_directions.push_back(ray_direction.normalized());
+  }
 
-      // Check the reprojection error.
-      const Feature* feature = view->GetFeature(track_id);
-      // Reproject the observations.
-      Eigen::Vector2d projection;
-      const double depth = camera.ProjectPoint(track->Point(), &projection);
-      // Remove the feature if the reprojection is behind the camera.
-      if (depth < 0) {
-        ++num_bad_reprojections;
-        track->SetEstimated(false);
-        break;
-      }
-      mean_sq_reprojection_error += (projection - *feature).squaredNorm();
-      ++num_projections;
-    }
+  // Compute the reprojection errors and viewing angles of all tracks in
+  // parallel.
+  TrackReprojectionStatisticsOptions options;
+  options.num_threads = num_threads;
+  options.check_triangulation_angle = true;
+  options.min_triangulation_angle_degrees = min_triangulation_angle_degrees;
+  std::vector<TrackReprojectionStatistics> statistics;
+  ComputeTrackReprojectionStatistics(options,
+                                     *reconstruction,
+                                     estimated_track_ids,
+                                     &statistics,
+                                     nullptr);
 
-    mean_sq_reprojection_error /= static_cast<double>(num_projections);
-    if (track->IsEstimated() &&
-        mean_sq_reprojection_error > max_sq_reprojection_error) {
+  int num_bad_reprojections = 0;
+  int num_insufficient_viewing_angles = 0;
+  for (int i = 0; i < estimated_track_ids.size(); i++) {
+    const TrackReprojectionStatistics& track_statistics = statistics[i];
+    Track* track = reconstruction->MutableTrack(estimated_track_ids[i]);
+
+    // Remove the track if it reprojects behind any of the cameras or if the
+    // reprojection errors are too large.
+    if (track_statistics.num_observations_behind_camera > 0 ||
+        track_statistics.mean_sq_reprojection_error >
+            max_sq_reprojection_error) {
       ++num_bad_reprojections;
       track->SetEstimated(false);
+      continue;
     }
 
     // The track will remain estimated if the reprojection errors were all
     // good. We then test that the track is properly constrained by having at
     // least two cameras view it with a sufficient viewing angle.
-    if (track->IsEstimated() &&
-        !SufficientTriangulationAngle(ray_directions,
-                                      min_triangulation_angle_degrees)) {
+    if (!track_statistics.sufficient_triangulation_angle) {
       ++num_insufficient_viewing_angles;
       track->SetEstimated(false);
     }
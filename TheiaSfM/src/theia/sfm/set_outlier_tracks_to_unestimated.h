@@ -44,14 +44,17 @@ class Reconstruction;
 // Removes features that have a reprojection error larger than the
 // reprojection error threshold. Additionally, any features that are poorly
 // constrained because of a small viewing angle are removed. Returns the number
-// of features removed. Only the input tracks are checked.
+// of features removed. Only the input tracks are checked. The tracks are
+// checked in parallel with num_threads threads.
 int SetOutlierTracksToUnestimated(const std::unordered_set<TrackId>& tracks,
                                   const double max_inlier_reprojection_error,
                                   const double min_triangulation_angle_degrees,
+                                  const int num_threads,
                                   Reconstruction* reconstruction);
 // Same as above, but checks all tracks.
 int SetOutlierTracksToUnestimated(const double max_inlier_reprojection_error,
                                   const double min_triangulation_angle_degrees,
+                                  const int num_threads,
                                   Reconstruction* reconstruction);
 
 }  // namespace theia
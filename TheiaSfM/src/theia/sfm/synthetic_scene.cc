@@ -0,0 +1,675 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/sfm/synthetic_scene.h"
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <ceres/rotation.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "theia/matching/feature_correspondence.h"
+#include "theia/matching/image_pair_match.h"
+#include "theia/math/rotation.h"
+#include "theia/math/util.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/util/hash.h"
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+namespace {
+
+using Eigen::Matrix3d;
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+
+// The size of a city block (including the streets around it) and the width of
+// the streets in meters for the CITY_GRID layout.
+static const double kCityBlockSize = 40.0;
+static const double kStreetWidth = 10.0;
+
+// Fraction of the points of the CITY_GRID layout that lie on the walls of the
+// buildings. The rest lie on the ground or on the roofs.
+static const double kCityWallPointRatio = 0.6;
+
+// Standard deviation of the random perturbation of the camera poses along the
+// trajectory, relative to the view spacing and in degrees respectively.
+static const double kPositionJitter = 0.05;
+static const double kOrientationJitterDegrees = 2.0;
+
+// Matches with less parallax than this w.r.t. the dominant plane of the
+// shared points are counted as homography inliers.
+static const double kHomographyInlierThresholdPixels = 4.0;
+
+// An axis aligned rectangle on the ground plane.
+struct Rectangle {
+  Vector2d min;
+  Vector2d max;
+
+  void Extend(const Vector2d& point) {
+    min = min.cwiseMin(point);
+    max = max.cwiseMax(point);
+  }
+};
+
+// Returns the world-to-camera rotation of a camera that looks in the forward
+// direction such that the up direction points towards the top of the image.
+Matrix3d LookAtRotation(const Vector3d& forward, const Vector3d& up) {
+  const Vector3d z_axis = forward.normalized();
+  const Vector3d x_axis = z_axis.cross(up).normalized();
+  Matrix3d rotation;
+  rotation.row(0) = x_axis.transpose();
+  rotation.row(1) = z_axis.cross(x_axis).transpose();
+  rotation.row(2) = z_axis.transpose();
+  return rotation;
+}
+
+// Returns a rotation about a random axis with an angle that is normally
+// distributed with the given standard deviation.
+Vector3d RandomRotation(const double std_dev_degrees,
+                        RandomNumberGenerator* rng) {
+  const double angle = DegToRad(rng->RandGaussian(0.0, std_dev_degrees));
+  return angle * rng->RandVector3d().normalized();
+}
+
+void CreateCameras(const SyntheticSceneOptions& options,
+                   RandomNumberGenerator* rng,
+                   std::vector<Camera>* cameras,
+                   Rectangle* scene_bounds) {
+  cameras->resize(options.num_views);
+  if (options.trajectory == SyntheticSceneTrajectory::LAWNMOWER) {
+    const int num_rows = std::ceil(std::sqrt(options.num_views));
+    const int num_views_per_row = (options.num_views + num_rows - 1) / num_rows;
+    for (int i = 0; i < options.num_views; i++) {
+      const int row = i / num_views_per_row;
+      // Every other row is flown in the opposite direction.
+      const bool is_reversed = row % 2 == 1;
+      const int column = is_reversed ? num_views_per_row - 1 -
+                                           i % num_views_per_row
+                                     : i % num_views_per_row;
+      const Vector3d heading(is_reversed ? -1.0 : 1.0, 0.0, 0.0);
+      const Vector3d position(column * options.view_spacing,
+                              row * options.view_spacing,
+                              options.altitude);
+      (*cameras)[i].SetPosition(
+          position + kPositionJitter * options.view_spacing *
+                         Vector3d(rng->RandGaussian(0.0, 1.0),
+                                  rng->RandGaussian(0.0, 1.0),
+                                  rng->RandGaussian(0.0, 1.0)));
+      (*cameras)[i].SetOrientationFromRotationMatrix(
+          LookAtRotation(Vector3d(0.0, 0.0, -1.0), heading));
+    }
+  } else {
+    // The views are spaced evenly on a circle around the scene, and the scene
+    // covers the area that the views look at.
+    const double radius =
+        std::max(options.num_views * options.view_spacing / (2.0 * M_PI),
+                 options.altitude);
+    for (int i = 0; i < options.num_views; i++) {
+      const double angle = 2.0 * M_PI * i / options.num_views;
+      const Vector3d position(radius * std::cos(angle),
+                              radius * std::sin(angle),
+                              options.altitude);
+      (*cameras)[i].SetPosition(position);
+      (*cameras)[i].SetOrientationFromRotationMatrix(LookAtRotation(
+          Vector3d(0.0, 0.0, 0.0) - position, Vector3d(0.0, 0.0, 1.0)));
+    }
+  }
+
+  for (Camera& camera : *cameras) {
+    camera.SetOrientationFromAngleAxis(MultiplyRotations(
+        RandomRotation(kOrientationJitterDegrees, rng),
+        camera.GetOrientationAsAngleAxis()));
+    camera.SetFocalLength(options.focal_length);
+    camera.SetPrincipalPoint(options.image_width / 2.0,
+                             options.image_height / 2.0);
+    camera.SetImageSize(options.image_width, options.image_height);
+  }
+
+  // The scene covers the area below the trajectory plus the ground footprint
+  // of the views at its boundary.
+  if (options.trajectory == SyntheticSceneTrajectory::LAWNMOWER) {
+    const double footprint_radius =
+        0.5 * options.altitude *
+        std::hypot(options.image_width, options.image_height) /
+        options.focal_length;
+    scene_bounds->min = (*cameras)[0].GetPosition().head<2>();
+    scene_bounds->max = scene_bounds->min;
+    for (const Camera& camera : *cameras) {
+      scene_bounds->Extend(camera.GetPosition().head<2>());
+    }
+    scene_bounds->min -= Vector2d::Constant(footprint_radius);
+    scene_bounds->max += Vector2d::Constant(footprint_radius);
+  } else {
+    const double half_size =
+        0.5 * (*cameras)[0].GetPosition().head<2>().norm();
+    scene_bounds->min = Vector2d::Constant(-half_size);
+    scene_bounds->max = Vector2d::Constant(half_size);
+  }
+}
+
+// Samples a point on the ground, on a roof, or on the walls of the buildings of
+// a city grid. Each block contains a single building in its center that is
+// surrounded by streets.
+Vector3d SampleCityGridPoint(const Rectangle& scene_bounds,
+                             const int num_blocks_x,
+                             const std::vector<double>& building_heights,
+                             RandomNumberGenerator* rng) {
+  const double building_size = kCityBlockSize - kStreetWidth;
+  if (rng->RandDouble(0.0, 1.0) < kCityWallPointRatio) {
+    const int block = rng->RandInt(0, building_heights.size() - 1);
+    const Vector2d building_min =
+        scene_bounds.min +
+        kCityBlockSize * Vector2d(block % num_blocks_x, block / num_blocks_x) +
+        Vector2d::Constant(0.5 * kStreetWidth);
+    const double offset = rng->RandDouble(0.0, building_size);
+    const double height = rng->RandDouble(0.0, building_heights[block]);
+    switch (rng->RandInt(0, 3)) {
+      case 0:
+        return Vector3d(building_min.x() + offset, building_min.y(), height);
+      case 1:
+        return Vector3d(building_min.x() + offset,
+                        building_min.y() + building_size,
+                        height);
+      case 2:
+        return Vector3d(building_min.x(), building_min.y() + offset, height);
+      default:
+        return Vector3d(building_min.x() + building_size,
+                        building_min.y() + offset,
+                        height);
+    }
+  }
+
+  // Points on the ground are moved onto the roof if they lie within the
+  // footprint of a building.
+  const Vector2d ground(rng->RandDouble(scene_bounds.min.x(),
+                                        scene_bounds.max.x()),
+                        rng->RandDouble(scene_bounds.min.y(),
+                                        scene_bounds.max.y()));
+  const Vector2d block_position = (ground - scene_bounds.min) / kCityBlockSize;
+  const int block_x = std::floor(block_position.x());
+  const int block_y = std::floor(block_position.y());
+  const Vector2d position_in_block =
+      kCityBlockSize * (block_position - Vector2d(block_x, block_y));
+  const int block = block_y * num_blocks_x + block_x;
+  if (block_x < num_blocks_x && block < building_heights.size() &&
+      position_in_block.minCoeff() > 0.5 * kStreetWidth &&
+      position_in_block.maxCoeff() < kCityBlockSize - 0.5 * kStreetWidth) {
+    return Vector3d(ground.x(), ground.y(), building_heights[block]);
+  }
+  return Vector3d(ground.x(), ground.y(), 0.0);
+}
+
+void CreatePoints(const SyntheticSceneOptions& options,
+                  const Rectangle& scene_bounds,
+                  RandomNumberGenerator* rng,
+                  std::vector<Vector3d>* points) {
+  points->resize(options.num_points);
+  if (options.point_layout == SyntheticScenePointLayout::RANDOM) {
+    for (Vector3d& point : *points) {
+      point = Vector3d(
+          rng->RandDouble(scene_bounds.min.x(), scene_bounds.max.x()),
+          rng->RandDouble(scene_bounds.min.y(), scene_bounds.max.y()),
+          rng->RandDouble(0.0, options.max_point_height));
+    }
+    return;
+  }
+
+  const Vector2d scene_size = scene_bounds.max - scene_bounds.min;
+  const int num_blocks_x = std::ceil(scene_size.x() / kCityBlockSize);
+  const int num_blocks_y = std::ceil(scene_size.y() / kCityBlockSize);
+  std::vector<double> building_heights(num_blocks_x * num_blocks_y);
+  for (double& height : building_heights) {
+    height = rng->RandDouble(0.3, 1.0) * options.max_point_height;
+  }
+  for (Vector3d& point : *points) {
+    point = SampleCityGridPoint(scene_bounds, num_blocks_x, building_heights,
+                                rng);
+  }
+}
+
+// A uniform grid over the ground plane that stores the indices of the points
+// in each cell so that the points that may be visible in a view can be found
+// without projecting all points into all views.
+class PointGrid {
+ public:
+  PointGrid(const Rectangle& bounds,
+            const double cell_size,
+            const std::vector<Vector3d>& points)
+      : bounds_(bounds), cell_size_(cell_size) {
+    num_cells_x_ =
+        std::max(1, static_cast<int>(std::ceil(
+                        (bounds_.max.x() - bounds_.min.x()) / cell_size_)));
+    num_cells_y_ =
+        std::max(1, static_cast<int>(std::ceil(
+                        (bounds_.max.y() - bounds_.min.y()) / cell_size_)));
+    cells_.resize(num_cells_x_ * num_cells_y_);
+    for (int i = 0; i < points.size(); i++) {
+      int x, y;
+      CellIndex(points[i].head<2>(), &x, &y);
+      cells_[y * num_cells_x_ + x].emplace_back(i);
+    }
+  }
+
+  // Appends the points in all cells that overlap with the rectangle.
+  void PointsInRectangle(const Rectangle& rectangle,
+                         std::vector<int>* point_indices) const {
+    int min_x, min_y, max_x, max_y;
+    CellIndex(rectangle.min, &min_x, &min_y);
+    CellIndex(rectangle.max, &max_x, &max_y);
+    for (int y = min_y; y <= max_y; y++) {
+      for (int x = min_x; x <= max_x; x++) {
+        const std::vector<int>& cell = cells_[y * num_cells_x_ + x];
+        point_indices->insert(point_indices->end(), cell.begin(), cell.end());
+      }
+    }
+  }
+
+ private:
+  void CellIndex(const Vector2d& position, int* x, int* y) const {
+    const Vector2d cell = (position - bounds_.min) / cell_size_;
+    *x = std::min(std::max(static_cast<int>(cell.x()), 0), num_cells_x_ - 1);
+    *y = std::min(std::max(static_cast<int>(cell.y()), 0), num_cells_y_ - 1);
+  }
+
+  const Rectangle bounds_;
+  const double cell_size_;
+  int num_cells_x_;
+  int num_cells_y_;
+  std::vector<std::vector<int> > cells_;
+};
+
+// Returns a conservative bound of the area of the scene that the camera can
+// see, based on where the rays through the image corners intersect the lowest
+// and highest planes of the scene.
+Rectangle ComputeViewFootprint(const Camera& camera,
+                               const double max_point_height,
+                               const double max_viewing_distance) {
+  const Vector3d position = camera.GetPosition();
+  Rectangle footprint;
+  footprint.min = position.head<2>();
+  footprint.max = position.head<2>();
+
+  const Vector2d corners[4] = {
+    Vector2d(0.0, 0.0),
+    Vector2d(camera.ImageWidth(), 0.0),
+    Vector2d(0.0, camera.ImageHeight()),
+    Vector2d(camera.ImageWidth(), camera.ImageHeight())
+  };
+  const double plane_heights[2] = { 0.0, max_point_height };
+  for (const Vector2d& corner : corners) {
+    const Vector3d ray = camera.PixelToUnitDepthRay(corner).normalized();
+    for (const double plane_height : plane_heights) {
+      double distance = max_viewing_distance;
+      if (ray.z() != 0.0) {
+        const double plane_distance = (plane_height - position.z()) / ray.z();
+        if (plane_distance > 0.0) {
+          distance = std::min(distance, plane_distance);
+        }
+      }
+      footprint.Extend((position + distance * ray).head<2>());
+    }
+  }
+  return footprint;
+}
+
+// Projects the point into the camera and returns true if it is in front of the
+// camera and within the image. All cameras share the intrinsics given by the
+// options.
+bool ProjectIntoImage(const SyntheticSceneOptions& options,
+                      const Matrix3d& rotation,
+                      const Vector3d& position,
+                      const Vector3d& point,
+                      Vector2d* pixel) {
+  const Vector3d point_in_camera = rotation * (point - position);
+  if (point_in_camera.z() <= 0.0) {
+    return false;
+  }
+  *pixel = options.focal_length * point_in_camera.hnormalized() +
+           0.5 * Vector2d(options.image_width, options.image_height);
+  return pixel->x() >= 0.0 && pixel->x() < options.image_width &&
+         pixel->y() >= 0.0 && pixel->y() < options.image_height;
+}
+
+// Finds the views that each point is visible in. Each point keeps at most
+// max_track_length of them, which are chosen at random.
+void FindObservations(const SyntheticSceneOptions& options,
+                      const std::vector<Camera>& cameras,
+                      const std::vector<Matrix3d>& rotations,
+                      const std::vector<Vector3d>& points,
+                      const Rectangle& scene_bounds,
+                      RandomNumberGenerator* rng,
+                      std::vector<std::vector<int> >* views_of_point) {
+  // Limit the viewing distance so that the footprint of views that look at the
+  // horizon remains bounded.
+  const double max_viewing_distance =
+      options.trajectory == SyntheticSceneTrajectory::ORBIT
+          ? 2.0 * cameras[0].GetPosition().norm()
+          : 4.0 * std::max(options.altitude, options.view_spacing);
+  const PointGrid grid(scene_bounds,
+                       std::max(options.view_spacing, options.altitude),
+                       points);
+
+  views_of_point->resize(points.size());
+  std::vector<int> candidates;
+  for (int i = 0; i < cameras.size(); i++) {
+    const Camera& camera = cameras[i];
+    const Vector3d position = camera.GetPosition();
+    candidates.clear();
+    grid.PointsInRectangle(ComputeViewFootprint(camera,
+                                                options.max_point_height,
+                                                max_viewing_distance),
+                           &candidates);
+    for (const int point_index : candidates) {
+      Vector2d pixel;
+      if ((points[point_index] - position).norm() <= max_viewing_distance &&
+          ProjectIntoImage(options, rotations[i], position,
+                           points[point_index], &pixel)) {
+        (*views_of_point)[point_index].emplace_back(i);
+      }
+    }
+  }
+
+  for (std::vector<int>& views : *views_of_point) {
+    if (views.size() <= options.max_track_length) {
+      continue;
+    }
+    for (int i = 0; i < options.max_track_length; i++) {
+      std::swap(views[i], views[rng->RandInt(i, views.size() - 1)]);
+    }
+    views.resize(options.max_track_length);
+    std::sort(views.begin(), views.end());
+  }
+}
+
+// Chooses the view pairs to match. Each view is matched to the views that it
+// shares the most points with.
+std::vector<ViewIdPair> ChooseViewPairs(
+    const SyntheticSceneOptions& options,
+    const std::vector<std::vector<int> >& views_of_point) {
+  std::unordered_map<ViewIdPair, int> num_shared_points;
+  for (const std::vector<int>& views : views_of_point) {
+    for (int i = 0; i < views.size(); i++) {
+      for (int j = i + 1; j < views.size(); j++) {
+        ++num_shared_points[ViewIdPair(views[i], views[j])];
+      }
+    }
+  }
+
+  std::vector<std::vector<std::pair<int, ViewId> > > candidates(
+      options.num_views);
+  for (const auto& view_pair : num_shared_points) {
+    if (view_pair.second < options.min_num_correspondences) {
+      continue;
+    }
+    candidates[view_pair.first.first].emplace_back(view_pair.second,
+                                                   view_pair.first.second);
+    candidates[view_pair.first.second].emplace_back(view_pair.second,
+                                                    view_pair.first.first);
+  }
+
+  std::vector<ViewIdPair> view_pairs;
+  for (ViewId view_id = 0; view_id < candidates.size(); view_id++) {
+    std::vector<std::pair<int, ViewId> >& view_candidates =
+        candidates[view_id];
+    const int num_matched_views = std::min<int>(options.max_num_matched_views,
+                                                view_candidates.size());
+    std::partial_sort(view_candidates.begin(),
+                      view_candidates.begin() + num_matched_views,
+                      view_candidates.end(),
+                      std::greater<std::pair<int, ViewId> >());
+    for (int i = 0; i < num_matched_views; i++) {
+      const ViewId other_view_id = view_candidates[i].second;
+      view_pairs.emplace_back(std::min(view_id, other_view_id),
+                              std::max(view_id, other_view_id));
+    }
+  }
+  std::sort(view_pairs.begin(), view_pairs.end());
+  view_pairs.erase(std::unique(view_pairs.begin(), view_pairs.end()),
+                   view_pairs.end());
+  return view_pairs;
+}
+
+// Counts the correspondences with little parallax w.r.t. the plane at the
+// median depth of the points, which would be inliers to a homography.
+int CountHomographyInliers(const Camera& camera1,
+                           const Camera& camera2,
+                           const std::vector<Vector3d>& points,
+                           const std::vector<int>& shared_points) {
+  const Matrix3d rotation = camera1.GetOrientationAsRotationMatrix();
+  const double baseline =
+      (camera2.GetPosition() - camera1.GetPosition()).norm();
+  std::vector<double> depths(shared_points.size());
+  for (int i = 0; i < shared_points.size(); i++) {
+    depths[i] =
+        (rotation * (points[shared_points[i]] - camera1.GetPosition())).z();
+  }
+  std::vector<double> sorted_depths = depths;
+  std::nth_element(sorted_depths.begin(),
+                   sorted_depths.begin() + sorted_depths.size() / 2,
+                   sorted_depths.end());
+  const double median_depth = sorted_depths[sorted_depths.size() / 2];
+
+  int num_inliers = 0;
+  for (const double depth : depths) {
+    const double parallax = camera1.FocalLength() * baseline *
+                            std::abs(depth - median_depth) / (depth * depth);
+    if (parallax < kHomographyInlierThresholdPixels) {
+      ++num_inliers;
+    }
+  }
+  return num_inliers;
+}
+
+}  // namespace
+
+void GenerateSyntheticScene(
+    const SyntheticSceneOptions& options,
+    std::vector<std::string>* view_names,
+    std::vector<CameraIntrinsicsPrior>* camera_intrinsics_priors,
+    std::vector<ImagePairMatch>* matches,
+    Reconstruction* ground_truth) {
+  CHECK_NOTNULL(view_names)->clear();
+  CHECK_NOTNULL(camera_intrinsics_priors)->clear();
+  CHECK_NOTNULL(matches)->clear();
+  CHECK_NOTNULL(ground_truth);
+  CHECK_GE(options.num_views, 2);
+  CHECK_GE(options.max_track_length, 2);
+  CHECK_GE(options.outlier_ratio, 0.0);
+  CHECK_LT(options.outlier_ratio, 1.0);
+
+  std::shared_ptr<RandomNumberGenerator> rng = options.rng;
+  if (!rng) {
+    rng = std::make_shared<RandomNumberGenerator>();
+  }
+
+  std::vector<Camera> cameras;
+  Rectangle scene_bounds;
+  CreateCameras(options, rng.get(), &cameras, &scene_bounds);
+
+  std::vector<Matrix3d> rotations(cameras.size());
+  std::vector<Vector3d> positions(cameras.size());
+  for (int i = 0; i < cameras.size(); i++) {
+    rotations[i] = cameras[i].GetOrientationAsRotationMatrix();
+    positions[i] = cameras[i].GetPosition();
+  }
+
+  std::vector<Vector3d> points;
+  CreatePoints(options, scene_bounds, rng.get(), &points);
+
+  std::vector<std::vector<int> > views_of_point;
+  FindObservations(options, cameras, rotations, points, scene_bounds,
+                   rng.get(), &views_of_point);
+
+  // Add the views to the ground truth reconstruction.
+  CameraIntrinsicsPrior prior;
+  prior.image_width = options.image_width;
+  prior.image_height = options.image_height;
+  prior.focal_length.is_set = true;
+  prior.focal_length.value[0] = options.focal_length;
+  prior.principal_point.is_set = true;
+  prior.principal_point.value[0] = options.image_width / 2.0;
+  prior.principal_point.value[1] = options.image_height / 2.0;
+
+  view_names->reserve(options.num_views);
+  camera_intrinsics_priors->resize(options.num_views, prior);
+  std::vector<ViewId> view_ids(options.num_views);
+  for (int i = 0; i < options.num_views; i++) {
+    view_names->emplace_back(StringPrintf("%06d.jpg", i));
+    const ViewId view_id = ground_truth->AddView(view_names->back());
+    CHECK_NE(view_id, kInvalidViewId);
+    view_ids[i] = view_id;
+    View* view = ground_truth->MutableView(view_id);
+    *view->MutableCamera() = cameras[i];
+    *view->MutableCameraIntrinsicsPrior() = prior;
+    view->SetEstimated(true);
+  }
+
+  // Add the tracks with noisy observations. The observations of each view are
+  // also kept in the order of the point indices so that the correspondences
+  // between two views are simply the intersection of their observations.
+  std::vector<std::vector<std::pair<int, Feature> > > observations(
+      options.num_views);
+  std::vector<std::pair<ViewId, Feature> > track;
+  for (int i = 0; i < points.size(); i++) {
+    if (views_of_point[i].size() < 2) {
+      continue;
+    }
+
+    track.clear();
+    for (const int view_index : views_of_point[i]) {
+      Vector2d pixel;
+      CHECK(ProjectIntoImage(options, rotations[view_index],
+                             positions[view_index], points[i], &pixel));
+      const Feature feature =
+          pixel + options.pixel_noise * Vector2d(rng->RandGaussian(0.0, 1.0),
+                                                 rng->RandGaussian(0.0, 1.0));
+      observations[view_index].emplace_back(i, feature);
+      track.emplace_back(view_ids[view_index], feature);
+    }
+
+    const TrackId track_id = ground_truth->AddTrack(track);
+    CHECK_NE(track_id, kInvalidTrackId);
+    Track* ground_truth_track = ground_truth->MutableTrack(track_id);
+    *ground_truth_track->MutablePoint() = points[i].homogeneous();
+    ground_truth_track->SetEstimated(true);
+  }
+
+  // Create the matches from the shared observations of each view pair.
+  const std::vector<ViewIdPair> view_pairs =
+      ChooseViewPairs(options, views_of_point);
+  matches->reserve(view_pairs.size());
+  std::vector<int> shared_points;
+  for (const ViewIdPair& view_pair : view_pairs) {
+    const std::vector<std::pair<int, Feature> >& observations1 =
+        observations[view_pair.first];
+    const std::vector<std::pair<int, Feature> >& observations2 =
+        observations[view_pair.second];
+
+    matches->emplace_back();
+    ImagePairMatch& match = matches->back();
+    match.image1 = (*view_names)[view_pair.first];
+    match.image2 = (*view_names)[view_pair.second];
+
+    shared_points.clear();
+    auto it1 = observations1.begin();
+    auto it2 = observations2.begin();
+    while (it1 != observations1.end() && it2 != observations2.end()) {
+      if (it1->first < it2->first) {
+        ++it1;
+      } else if (it2->first < it1->first) {
+        ++it2;
+      } else {
+        match.correspondences.emplace_back(it1->second, it2->second);
+        shared_points.emplace_back(it1->first);
+        ++it1;
+        ++it2;
+      }
+    }
+
+    // Outliers match the features of two different points.
+    const int num_outliers = std::round(options.outlier_ratio /
+                                        (1.0 - options.outlier_ratio) *
+                                        match.correspondences.size());
+    for (int i = 0; i < num_outliers; i++) {
+      const auto& observation1 =
+          observations1[rng->RandInt(0, observations1.size() - 1)];
+      const auto& observation2 =
+          observations2[rng->RandInt(0, observations2.size() - 1)];
+      if (observation1.first != observation2.first) {
+        match.correspondences.emplace_back(observation1.second,
+                                           observation2.second);
+      }
+    }
+
+    // The relative pose is the ground truth perturbed by noise, as if it had
+    // been estimated from the correspondences.
+    const Camera& camera1 = cameras[view_pair.first];
+    const Camera& camera2 = cameras[view_pair.second];
+    TwoViewInfo& info = match.twoview_info;
+    TwoViewInfoFromTwoCameras(camera1, camera2, &info);
+    info.rotation_2 = MultiplyRotations(
+        RandomRotation(options.relative_rotation_noise_degrees, rng.get()),
+        info.rotation_2);
+    const Vector3d translation_noise =
+        RandomRotation(options.relative_translation_noise_degrees, rng.get());
+    const Vector3d position_2 = info.position_2;
+    ceres::AngleAxisRotatePoint(translation_noise.data(),
+                                position_2.data(),
+                                info.position_2.data());
+    info.num_verified_matches = match.correspondences.size();
+    info.num_homography_inliers =
+        CountHomographyInliers(camera1, camera2, points, shared_points);
+    info.visibility_score = info.num_verified_matches;
+  }
+
+  VLOG(1) << "Generated a synthetic scene with " << options.num_views
+          << " views, " << ground_truth->NumTracks() << " tracks and "
+          << matches->size() << " view pairs.";
+}
+
+}  // namespace theia
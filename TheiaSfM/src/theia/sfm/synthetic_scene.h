@@ -0,0 +1,146 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#ifndef THEIA_SFM_SYNTHETIC_SCENE_H_
+#define THEIA_SFM_SYNTHETIC_SCENE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "theia/sfm/camera_intrinsics_prior.h"
+
+namespace theia {
+
+class RandomNumberGenerator;
+class Reconstruction;
+struct ImagePairMatch;
+
+// The distribution of the 3D points in a synthetic scene.
+enum class SyntheticScenePointLayout {
+  // Points are sampled uniformly within the bounding box of the scene.
+  RANDOM = 0,
+  // Points are sampled on the ground, walls, and roofs of buildings that are
+  // placed on a regular grid of city blocks.
+  CITY_GRID = 1,
+};
+
+// The camera trajectory used to capture a synthetic scene.
+enum class SyntheticSceneTrajectory {
+  // Nadir looking cameras flown in a serpentine "lawnmower" pattern over the
+  // scene, as is typical of a survey drone flight. The size of the scene grows
+  // with the number of views so that the number of points seen per view stays
+  // constant.
+  LAWNMOWER = 0,
+  // Cameras on a circle around the scene looking at its center. All views
+  // overlap so this trajectory is only intended for small scenes.
+  ORBIT = 1,
+};
+
+struct SyntheticSceneOptions {
+  // The random number generator used to generate the scene. If this is a
+  // nullptr then the random generator will be initialized based on the current
+  // time.
+  std::shared_ptr<RandomNumberGenerator> rng;
+
+  SyntheticScenePointLayout point_layout = SyntheticScenePointLayout::RANDOM;
+  SyntheticSceneTrajectory trajectory = SyntheticSceneTrajectory::LAWNMOWER;
+
+  int num_views = 100;
+
+  // Total number of 3D points in the scene.
+  int num_points = 20000;
+
+  // The distance in meters between consecutive views of the trajectory (and
+  // between the rows of the lawnmower pattern).
+  double view_spacing = 20.0;
+
+  // Altitude of the cameras in meters above the ground plane.
+  double altitude = 50.0;
+
+  // Maximum height in meters of the points (or buildings) above the ground.
+  double max_point_height = 10.0;
+
+  // Camera intrinsics of all views.
+  double focal_length = 1000.0;
+  int image_width = 1920;
+  int image_height = 1080;
+
+  // Standard deviation of the gaussian noise that is added to the feature
+  // positions in pixels.
+  double pixel_noise = 0.5;
+
+  // Standard deviation of the noise that is added to the relative rotations
+  // and to the direction of the relative translations of the two view
+  // geometries in degrees.
+  double relative_rotation_noise_degrees = 0.5;
+  double relative_translation_noise_degrees = 1.0;
+
+  // Fraction of the correspondences of each view pair that are outliers, i.e.,
+  // that match features of two different 3D points.
+  double outlier_ratio = 0.05;
+
+  // Each point is observed by at most this many of the views it is visible in,
+  // which mimics the limited repeatability of feature detection and bounds the
+  // cost of generating the matches.
+  int max_track_length = 12;
+
+  // Each view is matched to at most this many of the views that it shares the
+  // most points with, and only if they share at least min_num_correspondences
+  // points.
+  int max_num_matched_views = 10;
+  int min_num_correspondences = 30;
+};
+
+// Generates a synthetic scene and returns the verified two view matches that
+// would be obtained from images of the scene, such that the matches can be
+// input to the ReconstructionBuilder (or written to a matches file) exactly as
+// if they had been extracted from real imagery. The view names, camera
+// intrinsics priors, and two view matches are returned along with the ground
+// truth reconstruction that contains the true camera poses and 3D points.
+//
+// The relative poses of the matches are computed from the ground truth and
+// perturbed according to the options so that the (costly) geometric
+// verification does not need to be run.
+void GenerateSyntheticScene(
+    const SyntheticSceneOptions& options,
+    std::vector<std::string>* view_names,
+    std::vector<CameraIntrinsicsPrior>* camera_intrinsics_priors,
+    std::vector<ImagePairMatch>* matches,
+    Reconstruction* ground_truth);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_SYNTHETIC_SCENE_H_
@@ -0,0 +1,231 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include <Eigen/Core>
+#include <ceres/rotation.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "theia/matching/feature_correspondence.h"
+#include "theia/matching/image_pair_match.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/synthetic_scene.h"
+#include "theia/sfm/track.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+using Eigen::Matrix3d;
+using Eigen::Vector3d;
+
+namespace {
+
+// Returns the algebraic epipolar error of the correspondence in normalized
+// image coordinates, which is zero for noise-free correspondences.
+double EpipolarError(const CameraIntrinsicsPrior& prior1,
+                     const CameraIntrinsicsPrior& prior2,
+                     const TwoViewInfo& info,
+                     const FeatureCorrespondence& correspondence) {
+  Matrix3d rotation;
+  ceres::AngleAxisToRotationMatrix(
+      info.rotation_2.data(), ceres::ColumnMajorAdapter3x3(rotation.data()));
+  const Vector3d translation = -rotation * info.position_2;
+  Matrix3d translation_cross;
+  translation_cross << 0.0, -translation.z(), translation.y(),
+      translation.z(), 0.0, -translation.x(),
+      -translation.y(), translation.x(), 0.0;
+  const Matrix3d essential_matrix = translation_cross * rotation;
+
+  const Vector3d point1(
+      (correspondence.feature1.x() - prior1.principal_point.value[0]) /
+          prior1.focal_length.value[0],
+      (correspondence.feature1.y() - prior1.principal_point.value[1]) /
+          prior1.focal_length.value[0],
+      1.0);
+  const Vector3d point2(
+      (correspondence.feature2.x() - prior2.principal_point.value[0]) /
+          prior2.focal_length.value[0],
+      (correspondence.feature2.y() - prior2.principal_point.value[1]) /
+          prior2.focal_length.value[0],
+      1.0);
+  return std::abs(point2.dot(essential_matrix * point1));
+}
+
+void GenerateScene(const SyntheticSceneOptions& options,
+                   std::vector<std::string>* view_names,
+                   std::vector<CameraIntrinsicsPrior>* priors,
+                   std::vector<ImagePairMatch>* matches,
+                   Reconstruction* ground_truth) {
+  GenerateSyntheticScene(options, view_names, priors, matches, ground_truth);
+  ASSERT_EQ(view_names->size(), options.num_views);
+  ASSERT_EQ(priors->size(), options.num_views);
+  ASSERT_EQ(ground_truth->NumViews(), options.num_views);
+  ASSERT_GT(ground_truth->NumTracks(), 0);
+  ASSERT_GT(matches->size(), 0);
+}
+
+// Counts the correspondences that do not satisfy the epipolar constraint.
+int CountEpipolarOutliers(const std::vector<CameraIntrinsicsPrior>& priors,
+                          const ImagePairMatch& match) {
+  static const double kTolerance = 1e-8;
+  int num_outliers = 0;
+  for (const FeatureCorrespondence& correspondence : match.correspondences) {
+    if (EpipolarError(priors[0], priors[0], match.twoview_info,
+                      correspondence) > kTolerance) {
+      ++num_outliers;
+    }
+  }
+  return num_outliers;
+}
+
+}  // namespace
+
+TEST(SyntheticScene, NoiseFreeLawnmowerScene) {
+  SyntheticSceneOptions options;
+  options.rng = std::make_shared<RandomNumberGenerator>(59);
+  options.num_views = 25;
+  options.num_points = 5000;
+  options.pixel_noise = 0.0;
+  options.relative_rotation_noise_degrees = 0.0;
+  options.relative_translation_noise_degrees = 0.0;
+  options.outlier_ratio = 0.0;
+
+  std::vector<std::string> view_names;
+  std::vector<CameraIntrinsicsPrior> priors;
+  std::vector<ImagePairMatch> matches;
+  Reconstruction ground_truth;
+  GenerateScene(options, &view_names, &priors, &matches, &ground_truth);
+
+  for (const ImagePairMatch& match : matches) {
+    EXPECT_GE(match.correspondences.size(), options.min_num_correspondences);
+    EXPECT_EQ(match.twoview_info.num_verified_matches,
+              match.correspondences.size());
+    EXPECT_EQ(CountEpipolarOutliers(priors, match), 0);
+  }
+
+  for (const TrackId track_id : ground_truth.TrackIds()) {
+    const Track* track = ground_truth.Track(track_id);
+    EXPECT_GE(track->NumViews(), 2);
+    EXPECT_LE(track->NumViews(), options.max_track_length);
+  }
+}
+
+TEST(SyntheticScene, OutlierRatio) {
+  SyntheticSceneOptions options;
+  options.rng = std::make_shared<RandomNumberGenerator>(59);
+  options.num_views = 25;
+  options.num_points = 5000;
+  options.pixel_noise = 0.0;
+  options.relative_rotation_noise_degrees = 0.0;
+  options.relative_translation_noise_degrees = 0.0;
+  options.outlier_ratio = 0.2;
+
+  std::vector<std::string> view_names;
+  std::vector<CameraIntrinsicsPrior> priors;
+  std::vector<ImagePairMatch> matches;
+  Reconstruction ground_truth;
+  GenerateScene(options, &view_names, &priors, &matches, &ground_truth);
+
+  int num_correspondences = 0;
+  int num_outliers = 0;
+  for (const ImagePairMatch& match : matches) {
+    num_correspondences += match.correspondences.size();
+    num_outliers += CountEpipolarOutliers(priors, match);
+  }
+  EXPECT_NEAR(static_cast<double>(num_outliers) / num_correspondences,
+              options.outlier_ratio,
+              0.02);
+}
+
+TEST(SyntheticScene, CityGridOrbitScene) {
+  SyntheticSceneOptions options;
+  options.rng = std::make_shared<RandomNumberGenerator>(59);
+  options.point_layout = SyntheticScenePointLayout::CITY_GRID;
+  options.trajectory = SyntheticSceneTrajectory::ORBIT;
+  options.num_views = 20;
+  options.num_points = 5000;
+
+  std::vector<std::string> view_names;
+  std::vector<CameraIntrinsicsPrior> priors;
+  std::vector<ImagePairMatch> matches;
+  Reconstruction ground_truth;
+  GenerateScene(options, &view_names, &priors, &matches, &ground_truth);
+
+  // Each view should be matched to other views.
+  std::vector<int> num_matches_per_view(options.num_views, 0);
+  for (const ImagePairMatch& match : matches) {
+    ++num_matches_per_view[ground_truth.ViewIdFromName(match.image1)];
+    ++num_matches_per_view[ground_truth.ViewIdFromName(match.image2)];
+  }
+  for (const int num_matches : num_matches_per_view) {
+    EXPECT_GT(num_matches, 0);
+    EXPECT_LE(num_matches, 2 * options.max_num_matched_views);
+  }
+}
+
+TEST(SyntheticScene, Deterministic) {
+  SyntheticSceneOptions options;
+  options.num_views = 16;
+  options.num_points = 2000;
+
+  std::vector<std::string> view_names1, view_names2;
+  std::vector<CameraIntrinsicsPrior> priors1, priors2;
+  std::vector<ImagePairMatch> matches1, matches2;
+  Reconstruction ground_truth1, ground_truth2;
+  options.rng = std::make_shared<RandomNumberGenerator>(59);
+  GenerateScene(options, &view_names1, &priors1, &matches1, &ground_truth1);
+  options.rng = std::make_shared<RandomNumberGenerator>(59);
+  GenerateScene(options, &view_names2, &priors2, &matches2, &ground_truth2);
+
+  EXPECT_EQ(view_names1, view_names2);
+  ASSERT_EQ(matches1.size(), matches2.size());
+  for (int i = 0; i < matches1.size(); i++) {
+    EXPECT_EQ(matches1[i].image1, matches2[i].image1);
+    EXPECT_EQ(matches1[i].image2, matches2[i].image2);
+    ASSERT_EQ(matches1[i].correspondences.size(),
+              matches2[i].correspondences.size());
+    for (int j = 0; j < matches1[i].correspondences.size(); j++) {
+      EXPECT_EQ(matches1[i].correspondences[j].feature1,
+                matches2[i].correspondences[j].feature1);
+      EXPECT_EQ(matches1[i].correspondences[j].feature2,
+                matches2[i].correspondences[j].feature2);
+    }
+  }
+}
+
+}  // namespace theia
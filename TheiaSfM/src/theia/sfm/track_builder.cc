@@ -47,6 +47,7 @@
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/types.h"
 #include "theia/util/map_util.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 
@@ -77,6 +78,7 @@ void TrackBuilder::AddFeatureCorrespondence(const ViewId view_id1,
 }
 
 void TrackBuilder::BuildTracks(Reconstruction* reconstruction) {
+  ScopedTraceSpan span("BuildTracks");
   CHECK_NOTNULL(reconstruction);
 
   // Build a reverse map mapping feature ids to ImageNameFeaturePairs.
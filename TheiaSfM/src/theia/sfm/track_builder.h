@@ -68,6 +68,9 @@ class TrackBuilder {
   // Generates all tracks and adds them to the reconstruction.
   void BuildTracks(Reconstruction* reconstruction);
 
+  // The number of unique features that have been added.
+  int NumFeatures() const { return features_.size(); }
+
  private:
   uint64_t FindOrInsert(const std::pair<ViewId, Feature>& image_feature);
 
@@ -0,0 +1,249 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+
+#include "theia/sfm/track_reprojection_statistics.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/triangulation/triangulation.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/threadpool.h"
+
+namespace theia {
+namespace {
+
+// The observations of a block of tracks in one estimated view. They are
+// projected together so that the view is looked up and its rotation matrix is
+// computed once per block rather than once per observation.
+struct ViewObservations {
+  const View* view;
+  Eigen::Vector3d position;
+  std::vector<Eigen::Vector4d> points;
+  std::vector<Eigen::Vector2d> projections;
+  std::vector<double> depths;
+};
+
+// An observation of a track in a block, given by the index of the view in the
+// block and the index of the observation among those of the view.
+struct BlockObservation {
+  int view_index;
+  int point_index;
+};
+
+// Computes the statistics of the tracks [start, end). The squared reprojection
+// errors are appended to sq_reprojection_errors in track order if it is not
+// NULL.
+void ComputeStatisticsForBlock(
+    const TrackReprojectionStatisticsOptions& options,
+    const Reconstruction& reconstruction,
+    const std::vector<TrackId>& track_ids,
+    const int start,
+    const int end,
+    std::vector<double>* sq_reprojection_errors,
+    std::vector<TrackReprojectionStatistics>* statistics) {
+  // Gather the observations of the tracks by view. Views that are missing or
+  // not estimated are stored with index -1.
+  std::unordered_map<ViewId, int> view_indices;
+  std::vector<ViewObservations> views;
+  std::vector<BlockObservation> observations;
+  std::vector<const Track*> tracks(end - start);
+  std::vector<int> first_observation(end - start + 1);
+  for (int i = start; i < end; i++) {
+    first_observation[i - start] = observations.size();
+    const Track* track = reconstruction.Track(track_ids[i]);
+    tracks[i - start] = track;
+    if (track == nullptr) {
+      continue;
+    }
+    for (const ViewId view_id : track->ViewIds()) {
+      auto view_index = view_indices.emplace(view_id, views.size());
+      if (view_index.second) {
+        const View* view = reconstruction.View(view_id);
+        if (view == nullptr || !view->IsEstimated()) {
+          view_index.first->second = -1;
+        } else {
+          views.emplace_back();
+          views.back().view = view;
+          views.back().position = view->Camera().GetPosition();
+        }
+      }
+      if (view_index.first->second < 0) {
+        continue;
+      }
+      ViewObservations& view_observations = views[view_index.first->second];
+      const BlockObservation observation = {
+          view_index.first->second,
+          static_cast<int>(view_observations.points.size())};
+      observations.push_back(observation);
+      view_observations.points.emplace_back(track->Point());
+    }
+  }
+  first_observation[end - start] = observations.size();
+
+  for (ViewObservations& view_observations : views) {
+    view_observations.view->Camera().ProjectPoints(
+        view_observations.points,
+        &view_observations.projections,
+        &view_observations.depths);
+  }
+
+  std::vector<Eigen::Vector3d> ray_directions;
+  for (int i = start; i < end; i++) {
+    TrackReprojectionStatistics& track_statistics = (*statistics)[i];
+    track_statistics = TrackReprojectionStatistics();
+    const Track* track = tracks[i - start];
+    if (track == nullptr) {
+      continue;
+    }
+
+    ray_directions.clear();
+    const Eigen::Vector3d point = track->Point().hnormalized();
+    double sq_reprojection_error_sum = 0.0;
+    for (int j = first_observation[i - start];
+         j < first_observation[i - start + 1];
+         j++) {
+      const ViewObservations& view_observations =
+          views[observations[j].view_index];
+      const int point_index = observations[j].point_index;
+      if (view_observations.depths[point_index] < 0) {
+        ++track_statistics.num_observations_behind_camera;
+      }
+      const double sq_reprojection_error =
+          (view_observations.projections[point_index] -
+           *view_observations.view->GetFeature(track_ids[i]))
+              .squaredNorm();
+      sq_reprojection_error_sum += sq_reprojection_error;
+      track_statistics.max_sq_reprojection_error = std::max(
+          track_statistics.max_sq_reprojection_error, sq_reprojection_error);
+      if (sq_reprojection_errors != nullptr) {
+        sq_reprojection_errors->emplace_back(sq_reprojection_error);
+      }
+
+      if (options.check_triangulation_angle) {
+        ray_directions.emplace_back(
+            (point - view_observations.position).normalized());
+      }
+      ++track_statistics.num_observations;
+    }
+
+    if (track_statistics.num_observations > 0) {
+      track_statistics.mean_sq_reprojection_error =
+          sq_reprojection_error_sum / track_statistics.num_observations;
+    }
+
+    if (options.check_triangulation_angle) {
+      track_statistics.sufficient_triangulation_angle =
+          SufficientTriangulationAngle(ray_directions,
+                                       options.min_triangulation_angle_degrees);
+    }
+  }
+}
+
+}  // namespace
+
+void ComputeTrackReprojectionStatistics(
+    const TrackReprojectionStatisticsOptions& options,
+    const Reconstruction& reconstruction,
+    const std::vector<TrackId>& track_ids,
+    std::vector<TrackReprojectionStatistics>* statistics,
+    std::vector<double>* sq_reprojection_errors) {
+  // Split the tracks into a few blocks per thread so that the load stays
+  // balanced when the track lengths vary.
+  static const int kNumBlocksPerThread = 4;
+  CHECK_GE(options.num_threads, 1);
+  CHECK_NOTNULL(statistics)->resize(track_ids.size());
+  if (sq_reprojection_errors != nullptr) {
+    sq_reprojection_errors->clear();
+  }
+
+  const int num_tracks = track_ids.size();
+  if (num_tracks == 0) {
+    return;
+  }
+  const int num_blocks =
+      options.num_threads == 1
+          ? 1
+          : std::min(num_tracks, options.num_threads * kNumBlocksPerThread);
+
+  // The squared reprojection errors of each block are collected separately and
+  // concatenated in block order so that the output does not depend on the
+  // number of threads.
+  std::vector<std::vector<double> > block_sq_reprojection_errors(
+      sq_reprojection_errors != nullptr ? num_blocks : 0);
+  const auto compute_block = [&](const int block,
+                                  const int start,
+                                  const int end) {
+    std::vector<double>* block_errors =
+        sq_reprojection_errors != nullptr ? &block_sq_reprojection_errors[block]
+                                          : nullptr;
+    ComputeStatisticsForBlock(options,
+                              reconstruction,
+                              track_ids,
+                              start,
+                              end,
+                              block_errors,
+                              statistics);
+  };
+
+  ParallelFor(options.num_threads, num_blocks, num_tracks, compute_block);
+
+  if (sq_reprojection_errors == nullptr) {
+    return;
+  }
+  if (num_blocks == 1) {
+    sq_reprojection_errors->swap(block_sq_reprojection_errors[0]);
+    return;
+  }
+  int num_observations = 0;
+  for (const auto& block_errors : block_sq_reprojection_errors) {
+    num_observations += block_errors.size();
+  }
+  sq_reprojection_errors->reserve(num_observations);
+  for (const auto& block_errors : block_sq_reprojection_errors) {
+    sq_reprojection_errors->insert(sq_reprojection_errors->end(),
+                                   block_errors.begin(),
+                                   block_errors.end());
+  }
+}
+
+}  // namespace theia
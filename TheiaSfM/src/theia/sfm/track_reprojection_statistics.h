@@ -0,0 +1,91 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+
+#ifndef THEIA_SFM_TRACK_REPROJECTION_STATISTICS_H_
+#define THEIA_SFM_TRACK_REPROJECTION_STATISTICS_H_
+
+#include <vector>
+
+#include "theia/sfm/types.h"
+
+namespace theia {
+class Reconstruction;
+
+struct TrackReprojectionStatisticsOptions {
+  // Number of threads used to compute the statistics. The tracks are split into
+  // blocks, and the observations of a block are projected view by view.
+  int num_threads = 1;
+
+  // If true, each track is tested for having a triangulation angle of at least
+  // min_triangulation_angle_degrees between any two of its observations.
+  bool check_triangulation_angle = false;
+  double min_triangulation_angle_degrees = 0.0;
+};
+
+// The statistics of a track computed from its observations in estimated
+// views. Tracks that do not exist or are not observed by any estimated view
+// have zero observations.
+struct TrackReprojectionStatistics {
+  // Number of estimated views that observe the track.
+  int num_observations = 0;
+
+  // Number of observations for which the track is behind the camera.
+  int num_observations_behind_camera = 0;
+
+  // The mean and max squared reprojection errors over all observations.
+  double mean_sq_reprojection_error = 0.0;
+  double max_sq_reprojection_error = 0.0;
+
+  // Only set if options.check_triangulation_angle is true.
+  bool sufficient_triangulation_angle = false;
+};
+
+// Computes the reprojection statistics of each of the given tracks in
+// parallel. The statistics are output in the same order as track_ids. If
+// sq_reprojection_errors is not NULL, the squared reprojection error of every
+// observation in an estimated view is also output, grouped by track in the
+// order of track_ids. This is shared by the outlier filtering, the track
+// selection for bundle adjustment and the reconstruction statistics so that
+// each pass over the observations of a reconstruction is done in parallel.
+void ComputeTrackReprojectionStatistics(
+    const TrackReprojectionStatisticsOptions& options,
+    const Reconstruction& reconstruction,
+    const std::vector<TrackId>& track_ids,
+    std::vector<TrackReprojectionStatistics>* statistics,
+    std::vector<double>* sq_reprojection_errors);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_TRACK_REPROJECTION_STATISTICS_H_
@@ -0,0 +1,203 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+
+#include <Eigen/Core>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/track_reprojection_statistics.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/util/random.h"
+
+namespace theia {
+
+namespace {
+
+RandomNumberGenerator rng(61);
+
+// Adds estimated views on a line that look down the z-axis.
+void AddViews(const int num_views, Reconstruction* reconstruction) {
+  for (int i = 0; i < num_views; i++) {
+    const ViewId view_id = reconstruction->AddView(std::to_string(i));
+    View* view = reconstruction->MutableView(view_id);
+    Camera* camera = view->MutableCamera();
+    camera->SetPosition(Eigen::Vector3d(i, 0, 0));
+    camera->SetFocalLength(500);
+    camera->SetPrincipalPoint(500, 500);
+    camera->SetImageSize(1000, 1000);
+    view->SetEstimated(true);
+  }
+}
+
+// Adds an estimated track at the point that is observed by all views. The
+// observation in the first view is offset by the given number of pixels.
+TrackId AddTrack(const Eigen::Vector3d& point,
+                 const double offset,
+                 Reconstruction* reconstruction) {
+  std::vector<std::pair<ViewId, Feature> > features;
+  for (const ViewId view_id : reconstruction->ViewIds()) {
+    Feature feature;
+    reconstruction->View(view_id)->Camera().ProjectPoint(point.homogeneous(),
+                                                         &feature);
+    if (view_id == 0) {
+      feature.x() += offset;
+    }
+    features.emplace_back(view_id, feature);
+  }
+  const TrackId track_id = reconstruction->AddTrack(features);
+  Track* track = reconstruction->MutableTrack(track_id);
+  *track->MutablePoint() = point.homogeneous();
+  track->SetEstimated(true);
+  return track_id;
+}
+
+}  // namespace
+
+TEST(TrackReprojectionStatistics, ReprojectionErrors) {
+  static const int kNumViews = 4;
+  static const double kOffset = 2.0;
+  static const double kTolerance = 1e-8;
+  Reconstruction reconstruction;
+  AddViews(kNumViews, &reconstruction);
+  const TrackId good_track_id =
+      AddTrack(Eigen::Vector3d(1.0, 0.5, 10.0), 0.0, &reconstruction);
+  const TrackId bad_track_id =
+      AddTrack(Eigen::Vector3d(1.0, -0.5, 10.0), kOffset, &reconstruction);
+
+  // Move the last view so that the good track is behind it.
+  const ViewId behind_view_id = kNumViews - 1;
+  reconstruction.MutableView(behind_view_id)
+      ->MutableCamera()
+      ->SetPosition(Eigen::Vector3d(0, 0, 20.0));
+
+  TrackReprojectionStatisticsOptions options;
+  options.check_triangulation_angle = true;
+  options.min_triangulation_angle_degrees = 2.0;
+  std::vector<TrackReprojectionStatistics> statistics;
+  std::vector<double> sq_reprojection_errors;
+  ComputeTrackReprojectionStatistics(options,
+                                     reconstruction,
+                                     {good_track_id, bad_track_id},
+                                     &statistics,
+                                     &sq_reprojection_errors);
+  ASSERT_EQ(statistics.size(), 2);
+  EXPECT_EQ(sq_reprojection_errors.size(), 2 * kNumViews);
+  for (const TrackReprojectionStatistics& track_statistics : statistics) {
+    EXPECT_EQ(track_statistics.num_observations, kNumViews);
+    EXPECT_EQ(track_statistics.num_observations_behind_camera, 1);
+    EXPECT_TRUE(track_statistics.sufficient_triangulation_angle);
+  }
+
+  // Unestimated views are not considered.
+  reconstruction.MutableView(behind_view_id)->SetEstimated(false);
+  ComputeTrackReprojectionStatistics(options,
+                                     reconstruction,
+                                     {good_track_id, bad_track_id},
+                                     &statistics,
+                                     &sq_reprojection_errors);
+  EXPECT_EQ(sq_reprojection_errors.size(), 2 * (kNumViews - 1));
+  EXPECT_EQ(statistics[0].num_observations, kNumViews - 1);
+  EXPECT_EQ(statistics[0].num_observations_behind_camera, 0);
+  EXPECT_NEAR(statistics[0].mean_sq_reprojection_error, 0.0, kTolerance);
+  EXPECT_NEAR(statistics[0].max_sq_reprojection_error, 0.0, kTolerance);
+
+  EXPECT_EQ(statistics[1].num_observations, kNumViews - 1);
+  EXPECT_NEAR(statistics[1].mean_sq_reprojection_error,
+              kOffset * kOffset / (kNumViews - 1),
+              kTolerance);
+  EXPECT_NEAR(statistics[1].max_sq_reprojection_error,
+              kOffset * kOffset,
+              kTolerance);
+}
+
+TEST(TrackReprojectionStatistics, MultithreadedMatchesSingleThreaded) {
+  static const int kNumViews = 5;
+  static const int kNumTracks = 1000;
+  Reconstruction reconstruction;
+  AddViews(kNumViews, &reconstruction);
+  std::vector<TrackId> track_ids;
+  for (int i = 0; i < kNumTracks; i++) {
+    const Eigen::Vector3d point(rng.RandDouble(-2.0, 2.0),
+                                rng.RandDouble(-2.0, 2.0),
+                                rng.RandDouble(5.0, 10.0));
+    track_ids.emplace_back(
+        AddTrack(point, rng.RandDouble(0.0, 5.0), &reconstruction));
+  }
+  // Tracks that do not exist have no observations.
+  track_ids.emplace_back(kInvalidTrackId);
+
+  TrackReprojectionStatisticsOptions options;
+  options.check_triangulation_angle = true;
+  options.min_triangulation_angle_degrees = 10.0;
+  std::vector<TrackReprojectionStatistics> expected_statistics;
+  std::vector<double> expected_sq_reprojection_errors;
+  ComputeTrackReprojectionStatistics(options,
+                                     reconstruction,
+                                     track_ids,
+                                     &expected_statistics,
+                                     &expected_sq_reprojection_errors);
+  EXPECT_EQ(expected_statistics.back().num_observations, 0);
+
+  options.num_threads = 4;
+  std::vector<TrackReprojectionStatistics> statistics;
+  std::vector<double> sq_reprojection_errors;
+  ComputeTrackReprojectionStatistics(options,
+                                     reconstruction,
+                                     track_ids,
+                                     &statistics,
+                                     &sq_reprojection_errors);
+
+  EXPECT_EQ(sq_reprojection_errors, expected_sq_reprojection_errors);
+  ASSERT_EQ(statistics.size(), expected_statistics.size());
+  for (int i = 0; i < statistics.size(); i++) {
+    EXPECT_EQ(statistics[i].num_observations,
+              expected_statistics[i].num_observations);
+    EXPECT_EQ(statistics[i].num_observations_behind_camera,
+              expected_statistics[i].num_observations_behind_camera);
+    EXPECT_EQ(statistics[i].mean_sq_reprojection_error,
+              expected_statistics[i].mean_sq_reprojection_error);
+    EXPECT_EQ(statistics[i].max_sq_reprojection_error,
+              expected_statistics[i].max_sq_reprojection_error);
+    EXPECT_EQ(statistics[i].sufficient_triangulation_angle,
+              expected_statistics[i].sufficient_triangulation_angle);
+  }
+}
+
+}  // namespace theia
@@ -43,9 +43,9 @@ void AlignPointCloudsUmeyama(const std::vector<Eigen::Vector3d>& left,
                              const std::vector<Eigen::Vector3d>& right,
                              Eigen::Matrix3d* rotation,
                              Eigen::Vector3d* translation, double* scale) {
-  std::vector<double> weights(left.size(), 1.0);
-  AlignPointCloudsUmeyamaWithWeights(left, right, weights, rotation,
-                                     translation, scale);
+  CHECK_EQ(left.size(), right.size());
+  AlignPointCloudsUmeyamaWithWeights(left.size(), left.data(), right.data(),
+                                     nullptr, rotation, translation, scale);
 }
 
 void AlignPointCloudsUmeyamaWithWeights(
@@ -55,6 +55,18 @@ void AlignPointCloudsUmeyamaWithWeights(
     Eigen::Vector3d* translation, double* scale) {
   CHECK_EQ(left.size(), right.size());
   CHECK_EQ(left.size(), weights.size());
+  AlignPointCloudsUmeyamaWithWeights(left.size(), left.data(), right.data(),
+                                     weights.data(), rotation, translation,
+                                     scale);
+}
+
+void AlignPointCloudsUmeyamaWithWeights(const int num_points,
+                                        const Eigen::Vector3d* left,
+                                        const Eigen::Vector3d* right,
+                                        const double* weights,
+                                        Eigen::Matrix3d* rotation,
+                                        Eigen::Vector3d* translation,
+                                        double* scale) {
   CHECK_NOTNULL(rotation);
   CHECK_NOTNULL(translation);
   CHECK_NOTNULL(scale);
@@ -64,22 +76,20 @@ void AlignPointCloudsUmeyamaWithWeights(
   *translation = Eigen::Vector3d::Zero();
   *rotation = Eigen::Matrix3d::Identity();
 
-  const size_t num_points = left.size();
-  Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic> > left_points(
-      left[0].data(), 3, num_points);
-  Eigen::Map<const Eigen::Matrix<double, 3, Eigen::Dynamic> > right_points(
-      right[0].data(), 3, num_points);
+  const auto weight = [weights](const int i) {
+    return weights == nullptr ? 1.0 : weights[i];
+  };
 
   Eigen::Vector3d left_centroid, right_centroid;
   left_centroid.setZero();
   right_centroid.setZero();
   double weights_sum = 0.0;
-  for (size_t i = 0; i < num_points; i++) {
-    CHECK_GE(weights[i], 0)
+  for (int i = 0; i < num_points; i++) {
+    CHECK_GE(weight(i), 0)
         << "The point weight must be greater or equal to zero.";
-    weights_sum += weights[i];
-    left_centroid += left[i] * weights[i];
-    right_centroid += right[i] * weights[i];
+    weights_sum += weight(i);
+    left_centroid += left[i] * weight(i);
+    right_centroid += right[i] * weight(i);
   }
   // Check if the sum is valid
   CHECK_GT(weights_sum, 0) << "The sum of weights must be greater than zero.";
@@ -88,8 +98,8 @@ void AlignPointCloudsUmeyamaWithWeights(
   right_centroid /= weights_sum;
 
   double sigma = 0.0;
-  for (size_t i = 0; i < num_points; i++) {
-    sigma += (left[i] - left_centroid).squaredNorm() * weights[i];
+  for (int i = 0; i < num_points; i++) {
+    sigma += (left[i] - left_centroid).squaredNorm() * weight(i);
   }
   sigma /= weights_sum;
 
@@ -97,8 +107,8 @@ void AlignPointCloudsUmeyamaWithWeights(
   // centroid.
   Eigen::Matrix3d cross_correlation = Eigen::Matrix3d::Zero();
   for (int i = 0; i < num_points; i++) {
-    cross_correlation += weights[i] * (left_points.col(i) - left_centroid) *
-                         (right_points.col(i) - right_centroid).transpose();
+    cross_correlation += weight(i) * (left[i] - left_centroid) *
+                         (right[i] - right_centroid).transpose();
   }
   cross_correlation /= weights_sum;
 
@@ -63,6 +63,17 @@ void AlignPointCloudsUmeyamaWithWeights(
     const std::vector<double>& weights, Eigen::Matrix3d* rotation,
     Eigen::Vector3d* translation, double* scale);
 
+// Same as above for num_points contiguous points. The weights may be nullptr,
+// in which case all points have a weight of 1. This does not allocate any
+// memory so it is suitable for the minimal solver of RANSAC.
+void AlignPointCloudsUmeyamaWithWeights(const int num_points,
+                                        const Eigen::Vector3d* left,
+                                        const Eigen::Vector3d* right,
+                                        const double* weights,
+                                        Eigen::Matrix3d* rotation,
+                                        Eigen::Vector3d* translation,
+                                        double* scale);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_TRANSFORMATION_ALIGN_POINT_CLOUDS_H_
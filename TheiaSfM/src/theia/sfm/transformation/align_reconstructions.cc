@@ -51,44 +51,63 @@
 namespace theia {
 namespace {
 
-struct CameraCorrespondence {
-  Eigen::Vector3d camera1;
-  Eigen::Vector3d camera2;
+struct PointCorrespondence {
+  Eigen::Vector3d point1;
+  Eigen::Vector3d point2;
 };
 
-class CameraAlignmentEstimator
-    : public Estimator<CameraCorrespondence, SimilarityTransformation> {
+class PointAlignmentEstimator
+    : public Estimator<PointCorrespondence, SimilarityTransformation> {
  public:
-  CameraAlignmentEstimator() {}
+  static const int kSampleSize = 4;
 
-  double SampleSize() const { return 4; }
+  PointAlignmentEstimator() {}
+
+  double SampleSize() const { return kSampleSize; }
 
   bool EstimateModel(
-      const std::vector<CameraCorrespondence>& correspondences,
+      const std::vector<PointCorrespondence>& correspondences,
       std::vector<SimilarityTransformation>* sim_transforms) const {
+    // The minimal samples are aligned from stack arrays so that no memory is
+    // allocated in the RANSAC iterations.
     SimilarityTransformation sim_transform;
-    std::vector<Eigen::Vector3d> positions1(correspondences.size());
-    std::vector<Eigen::Vector3d> positions2(correspondences.size());
-    for (int i = 0; i < correspondences.size(); i++) {
-      positions1[i] = correspondences[i].camera1;
-      positions2[i] = correspondences[i].camera2;
+    if (correspondences.size() <= kSampleSize) {
+      Eigen::Vector3d points1[kSampleSize];
+      Eigen::Vector3d points2[kSampleSize];
+      for (int i = 0; i < correspondences.size(); i++) {
+        points1[i] = correspondences[i].point1;
+        points2[i] = correspondences[i].point2;
+      }
+      AlignPointCloudsUmeyamaWithWeights(correspondences.size(),
+                                         points2,
+                                         points1,
+                                         nullptr,
+                                         &sim_transform.rotation,
+                                         &sim_transform.translation,
+                                         &sim_transform.scale);
+    } else {
+      std::vector<Eigen::Vector3d> points1(correspondences.size());
+      std::vector<Eigen::Vector3d> points2(correspondences.size());
+      for (int i = 0; i < correspondences.size(); i++) {
+        points1[i] = correspondences[i].point1;
+        points2[i] = correspondences[i].point2;
+      }
+      AlignPointCloudsUmeyama(points2,
+                              points1,
+                              &sim_transform.rotation,
+                              &sim_transform.translation,
+                              &sim_transform.scale);
     }
-
-    AlignPointCloudsUmeyama(positions2,
-                            positions1,
-                            &sim_transform.rotation,
-                            &sim_transform.translation,
-                            &sim_transform.scale);
     sim_transforms->emplace_back(sim_transform);
     return true;
   }
 
-  double Error(const CameraCorrespondence& cameras,
+  double Error(const PointCorrespondence& correspondence,
                const SimilarityTransformation& sim_transform) const {
-    const Eigen::Vector3d transformed_camera =
-        sim_transform.scale * sim_transform.rotation * cameras.camera2 +
+    const Eigen::Vector3d transformed_point =
+        sim_transform.scale * sim_transform.rotation * correspondence.point2 +
         sim_transform.translation;
-    return (cameras.camera1 - transformed_camera).squaredNorm();
+    return (correspondence.point1 - transformed_point).squaredNorm();
   }
 };
 
@@ -139,15 +158,16 @@ void AlignReconstructionsRobust(
       FindCommonViewsByName(reconstruction1, *reconstruction2);
 
   // Collect the positions of all common views.
-  std::vector<CameraCorrespondence> correspondences(common_view_names.size());
+  std::vector<Eigen::Vector3d> positions1(common_view_names.size());
+  std::vector<Eigen::Vector3d> positions2(common_view_names.size());
   for (int i = 0; i < common_view_names.size(); i++) {
     const ViewId view_id1 =
         reconstruction1.ViewIdFromName(common_view_names[i]);
     const ViewId view_id2 =
         reconstruction2->ViewIdFromName(common_view_names[i]);
-    correspondences[i].camera1 =
+    positions1[i] =
         reconstruction1.View(view_id1)->Camera().GetPosition();
-    correspondences[i].camera2 =
+    positions2[i] =
         reconstruction2->View(view_id2)->Camera().GetPosition();
   }
 
@@ -158,38 +178,62 @@ void AlignReconstructionsRobust(
   params.error_thresh = robust_error_threshold * robust_error_threshold;
   params.failure_probability = 1e-4;
 
-  CameraAlignmentEstimator estimator;
-  Ransac<CameraAlignmentEstimator> ransac(params, estimator);
-  CHECK(ransac.Initialize()) << "Could not initialize RANSAC for similarity "
-                                "transformation estimation.";
   SimilarityTransformation sim_transform;
   RansacSummary summary;
-  CHECK(ransac.Estimate(correspondences, &sim_transform, &summary))
-      << "Could not align models with RANSAC";
-  CHECK_GT(summary.inliers.size(), 0)
-      << "No inliers could be found for estimating the similarity "
-         "transformation. Try using a higher error threshold.";
-
-  // Align the reconstructions using the inliers.
-  std::vector<Eigen::Vector3d> positions1(summary.inliers.size());
-  std::vector<Eigen::Vector3d> positions2(summary.inliers.size());
-  for (int i = 0; i < summary.inliers.size(); i++) {
-    positions1[i] = correspondences[summary.inliers[i]].camera1;
-    positions2[i] = correspondences[summary.inliers[i]].camera2;
+  CHECK(EstimateSimilarityTransformationRobust(
+      params, positions1, positions2, &sim_transform, &summary))
+      << "Could not align models with RANSAC. Not enough inliers could be "
+         "found for estimating the similarity transformation. Try using a "
+         "higher error threshold.";
+
+  // Apply the similarity transformation to the reconstruction.
+  TransformReconstruction(sim_transform.rotation,
+                          sim_transform.translation,
+                          sim_transform.scale,
+                          reconstruction2);
+}
+
+bool EstimateSimilarityTransformationRobust(
+    const RansacParameters& params,
+    const std::vector<Eigen::Vector3d>& points1,
+    const std::vector<Eigen::Vector3d>& points2,
+    SimilarityTransformation* sim_transform,
+    RansacSummary* summary) {
+  CHECK_EQ(points1.size(), points2.size());
+  CHECK_NOTNULL(sim_transform);
+  CHECK_NOTNULL(summary);
+  if (points1.size() < PointAlignmentEstimator::kSampleSize) {
+    return false;
   }
 
-  // Align the positions.
-  Eigen::Matrix3d rotation;
-  Eigen::Vector3d translation;
-  double scale;
-  AlignPointCloudsUmeyama(positions2,
-                          positions1,
-                          &rotation,
-                          &translation,
-                          &scale);
+  std::vector<PointCorrespondence> correspondences(points1.size());
+  for (int i = 0; i < points1.size(); i++) {
+    correspondences[i].point1 = points1[i];
+    correspondences[i].point2 = points2[i];
+  }
 
-  // Apply the similarity transformation to the reconstruction.
-  TransformReconstruction(rotation, translation, scale, reconstruction2);
+  PointAlignmentEstimator estimator;
+  Ransac<PointAlignmentEstimator> ransac(params, estimator);
+  CHECK(ransac.Initialize()) << "Could not initialize RANSAC for similarity "
+                                "transformation estimation.";
+  if (!ransac.Estimate(correspondences, sim_transform, summary) ||
+      summary->inliers.size() < PointAlignmentEstimator::kSampleSize - 1) {
+    return false;
+  }
+
+  // Refine the transformation with all inliers.
+  std::vector<Eigen::Vector3d> inliers1(summary->inliers.size());
+  std::vector<Eigen::Vector3d> inliers2(summary->inliers.size());
+  for (int i = 0; i < summary->inliers.size(); i++) {
+    inliers1[i] = points1[summary->inliers[i]];
+    inliers2[i] = points2[summary->inliers[i]];
+  }
+  AlignPointCloudsUmeyama(inliers2,
+                          inliers1,
+                          &sim_transform->rotation,
+                          &sim_transform->translation,
+                          &sim_transform->scale);
+  return true;
 }
 
 }  // namespace theia
@@ -35,6 +35,12 @@
 #ifndef THEIA_SFM_TRANSFORMATION_ALIGN_RECONSTRUCTIONS_H_
 #define THEIA_SFM_TRANSFORMATION_ALIGN_RECONSTRUCTIONS_H_
 
+#include <Eigen/Core>
+#include <vector>
+
+#include "theia/sfm/similarity_transformation.h"
+#include "theia/solvers/sample_consensus_estimator.h"
+
 namespace theia {
 class Reconstruction;
 
@@ -53,6 +59,18 @@ void AlignReconstructionsRobust(
     const Reconstruction& reconstruction1,
     Reconstruction* reconstruction2);
 
+// Estimates the similarity transformation such that points1 = s * R * points2
+// + t with RANSAC, and refines it on all inliers. The error threshold of the
+// parameters is the squared distance between the aligned points. The minimal
+// samples are aligned without allocating memory. Returns false if there are
+// fewer than 4 correspondences or fewer than 3 inliers.
+bool EstimateSimilarityTransformationRobust(
+    const RansacParameters& params,
+    const std::vector<Eigen::Vector3d>& points1,
+    const std::vector<Eigen::Vector3d>& points2,
+    SimilarityTransformation* sim_transform,
+    RansacSummary* summary);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_TRANSFORMATION_ALIGN_RECONSTRUCTIONS_H_
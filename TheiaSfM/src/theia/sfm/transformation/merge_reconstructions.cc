@@ -0,0 +1,302 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include "theia/sfm/transformation/merge_reconstructions.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera/camera_intrinsics_model.h"
+#include "theia/sfm/feature.h"
+#include "theia/sfm/find_common_views_by_name.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/similarity_transformation.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/transformation/align_reconstructions.h"
+#include "theia/sfm/transformation/transform_reconstruction.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view.h"
+#include "theia/solvers/sample_consensus_estimator.h"
+#include "theia/util/hash.h"
+#include "theia/util/map_util.h"
+
+namespace theia {
+namespace {
+
+// Finds the tracks of reconstruction2 that observe the same feature as a track
+// of reconstruction1 in one of the common views. Each track of reconstruction2
+// is mapped to the first such track of reconstruction1.
+void FindCommonTracks(
+    const Reconstruction& reconstruction1,
+    const Reconstruction& reconstruction2,
+    const std::vector<std::pair<ViewId, ViewId> >& common_views,
+    std::unordered_map<TrackId, TrackId>* track2_to_track1) {
+  for (const auto& common_view : common_views) {
+    const View* view1 = reconstruction1.View(common_view.first);
+    const View* view2 = reconstruction2.View(common_view.second);
+
+    std::unordered_map<std::pair<double, double>, TrackId> feature_to_track1;
+    feature_to_track1.reserve(view1->NumFeatures());
+    for (const TrackId track_id1 : view1->TrackIds()) {
+      const Feature& feature = *view1->GetFeature(track_id1);
+      feature_to_track1.emplace(std::make_pair(feature.x(), feature.y()),
+                                track_id1);
+    }
+
+    for (const TrackId track_id2 : view2->TrackIds()) {
+      const Feature& feature = *view2->GetFeature(track_id2);
+      const TrackId* track_id1 = FindOrNull(
+          feature_to_track1, std::make_pair(feature.x(), feature.y()));
+      if (track_id1 != nullptr) {
+        track2_to_track1->emplace(track_id2, *track_id1);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+bool MergeReconstructions(const MergeReconstructionsOptions& options,
+                          const Reconstruction& reconstruction2,
+                          Reconstruction* reconstruction1,
+                          MergeReconstructionsSummary* summary) {
+  CHECK_NOTNULL(reconstruction1);
+  CHECK_NOTNULL(summary);
+  CHECK_GT(options.robust_error_threshold, 0.0);
+  *summary = MergeReconstructionsSummary();
+
+  const std::vector<std::string> common_view_names =
+      FindCommonViewsByName(*reconstruction1, reconstruction2);
+  std::vector<std::pair<ViewId, ViewId> > common_views;
+  common_views.reserve(common_view_names.size());
+  for (const std::string& view_name : common_view_names) {
+    common_views.emplace_back(reconstruction1->ViewIdFromName(view_name),
+                              reconstruction2.ViewIdFromName(view_name));
+  }
+  summary->num_common_views = common_views.size();
+
+  std::unordered_map<TrackId, TrackId> track2_to_track1;
+  if (options.use_common_tracks) {
+    FindCommonTracks(
+        *reconstruction1, reconstruction2, common_views, &track2_to_track1);
+  }
+  summary->num_common_tracks = track2_to_track1.size();
+
+  // Collect the corresponding camera positions and 3D points.
+  std::vector<Eigen::Vector3d> points1, points2;
+  points1.reserve(common_views.size() + track2_to_track1.size());
+  points2.reserve(common_views.size() + track2_to_track1.size());
+  for (const auto& common_view : common_views) {
+    const View* view1 = reconstruction1->View(common_view.first);
+    const View* view2 = reconstruction2.View(common_view.second);
+    if (view1->IsEstimated() && view2->IsEstimated()) {
+      points1.emplace_back(view1->Camera().GetPosition());
+      points2.emplace_back(view2->Camera().GetPosition());
+    }
+  }
+  for (const auto& common_track : track2_to_track1) {
+    const Track* track1 = reconstruction1->Track(common_track.second);
+    const Track* track2 = reconstruction2.Track(common_track.first);
+    if (track1->IsEstimated() && track2->IsEstimated() &&
+        track1->Point()[3] != 0.0 && track2->Point()[3] != 0.0) {
+      points1.emplace_back(track1->Point().hnormalized());
+      points2.emplace_back(track2->Point().hnormalized());
+    }
+  }
+
+  RansacParameters params;
+  params.rng = options.rng;
+  params.max_iterations = options.max_ransac_iterations;
+  params.use_mle = true;
+  params.error_thresh =
+      options.robust_error_threshold * options.robust_error_threshold;
+  params.failure_probability = 1e-4;
+  RansacSummary ransac_summary;
+  if (!EstimateSimilarityTransformationRobust(params,
+                                              points1,
+                                              points2,
+                                              &summary->transformation,
+                                              &ransac_summary)) {
+    VLOG(2) << "Could not align the reconstructions from "
+            << points1.size() << " correspondences.";
+    return false;
+  }
+  summary->num_inliers = ransac_summary.inliers.size();
+
+  // Add the views of reconstruction2 that are not in reconstruction1. The
+  // cameras are transformed after all views and tracks have been added.
+  //
+  // The camera intrinsics groups of reconstruction2 are mapped to groups of
+  // reconstruction1. A group with a common view is mapped to the group of that
+  // view in reconstruction1, and its added views share the intrinsics of that
+  // group. Every other group becomes a new group whose intrinsics are a copy of
+  // the intrinsics in reconstruction2, so that reconstruction1 never shares
+  // intrinsics with reconstruction2. The new group ids are chosen explicitly
+  // since groups may have been added with ids beyond the ones that
+  // Reconstruction::AddView assigns.
+  std::unordered_map<ViewId, ViewId> view2_to_view1;
+  view2_to_view1.reserve(reconstruction2.NumViews());
+  std::unordered_map<CameraIntrinsicsGroupId, CameraIntrinsicsGroupId>
+      group2_to_group1;
+  for (const auto& common_view : common_views) {
+    view2_to_view1.emplace(common_view.second, common_view.first);
+    group2_to_group1.emplace(
+        reconstruction2.CameraIntrinsicsGroupIdFromViewId(common_view.second),
+        reconstruction1->CameraIntrinsicsGroupIdFromViewId(common_view.first));
+  }
+  CameraIntrinsicsGroupId next_group_id1 = 0;
+  for (const CameraIntrinsicsGroupId group_id1 :
+       reconstruction1->CameraIntrinsicsGroupIds()) {
+    if (group_id1 != kInvalidCameraIntrinsicsGroupId) {
+      next_group_id1 = std::max(next_group_id1, group_id1 + 1);
+    }
+  }
+  std::vector<ViewId> added_view_ids;
+  for (const ViewId view_id2 : reconstruction2.ViewIds()) {
+    if (ContainsKey(view2_to_view1, view_id2)) {
+      continue;
+    }
+    const View* view2 = reconstruction2.View(view_id2);
+    const auto group = group2_to_group1.emplace(
+        reconstruction2.CameraIntrinsicsGroupIdFromViewId(view_id2),
+        next_group_id1);
+    const bool is_new_group = group.second;
+    if (is_new_group) {
+      ++next_group_id1;
+    }
+    const ViewId view_id1 =
+        reconstruction1->AddView(view2->Name(), group.first->second);
+    View* view1 = reconstruction1->MutableView(view_id1);
+    *view1->MutableCameraIntrinsicsPrior() = view2->CameraIntrinsicsPrior();
+
+    // AddView points the camera of a view in an existing group to the shared
+    // intrinsics of the group, which must be kept after the deep copy.
+    const std::shared_ptr<CameraIntrinsicsModel> group_intrinsics =
+        view1->Camera().CameraIntrinsics();
+    view1->MutableCamera()->DeepCopy(view2->Camera());
+    if (!is_new_group) {
+      view1->MutableCamera()->MutableCameraIntrinsics() = group_intrinsics;
+    }
+    view1->SetEstimated(view2->IsEstimated());
+    view2_to_view1.emplace(view_id2, view_id1);
+    added_view_ids.emplace_back(view_id1);
+  }
+  summary->num_added_views = added_view_ids.size();
+
+  // Fuse the shared tracks and add the other tracks.
+  std::vector<TrackId> added_track_ids;
+  for (const TrackId track_id2 : reconstruction2.TrackIds()) {
+    const Track* track2 = reconstruction2.Track(track_id2);
+    const TrackId* track_id1 = FindOrNull(track2_to_track1, track_id2);
+    if (track_id1 != nullptr) {
+      const Track* track1 = reconstruction1->Track(*track_id1);
+      bool is_fused = false;
+      for (const ViewId view_id2 : track2->ViewIds()) {
+        const ViewId view_id1 = FindOrDie(view2_to_view1, view_id2);
+        if (ContainsKey(track1->ViewIds(), view_id1) ||
+            reconstruction1->View(view_id1)->GetFeature(*track_id1) !=
+                nullptr) {
+          continue;
+        }
+        const Feature& feature =
+            *reconstruction2.View(view_id2)->GetFeature(track_id2);
+        is_fused |=
+            reconstruction1->AddObservation(view_id1, *track_id1, feature);
+      }
+      if (is_fused) {
+        ++summary->num_fused_tracks;
+      }
+      continue;
+    }
+
+    std::vector<std::pair<ViewId, Feature> > observations;
+    observations.reserve(track2->NumViews());
+    for (const ViewId view_id2 : track2->ViewIds()) {
+      observations.emplace_back(
+          FindOrDie(view2_to_view1, view_id2),
+          *reconstruction2.View(view_id2)->GetFeature(track_id2));
+    }
+    const TrackId new_track_id = reconstruction1->AddTrack(observations);
+    if (new_track_id == kInvalidTrackId) {
+      continue;
+    }
+    Track* track1 = reconstruction1->MutableTrack(new_track_id);
+    *track1->MutablePoint() = track2->Point();
+    *track1->MutableColor() = track2->Color();
+    track1->SetEstimated(track2->IsEstimated());
+    added_track_ids.emplace_back(new_track_id);
+  }
+  summary->num_added_tracks = added_track_ids.size();
+
+  // Transform the added cameras and points to reconstruction1 in parallel.
+  std::vector<Camera*> cameras;
+  cameras.reserve(added_view_ids.size());
+  for (const ViewId view_id : added_view_ids) {
+    View* view = reconstruction1->MutableView(view_id);
+    if (view->IsEstimated()) {
+      cameras.emplace_back(view->MutableCamera());
+    }
+  }
+  std::vector<Eigen::Vector4d*> points;
+  points.reserve(added_track_ids.size());
+  for (const TrackId track_id : added_track_ids) {
+    Track* track = reconstruction1->MutableTrack(track_id);
+    if (track->IsEstimated()) {
+      points.emplace_back(track->MutablePoint());
+    }
+  }
+  TransformCamerasAndPoints(summary->transformation.rotation,
+                            summary->transformation.translation,
+                            summary->transformation.scale,
+                            options.num_threads,
+                            &cameras,
+                            &points);
+
+  VLOG(1) << "Merged reconstructions with " << summary->num_inliers
+          << " inliers of " << points1.size()
+          << " correspondences: added " << summary->num_added_views
+          << " views and " << summary->num_added_tracks
+          << " tracks, and fused " << summary->num_fused_tracks << " tracks.";
+  return true;
+}
+
+}  // namespace theia
@@ -0,0 +1,97 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#ifndef THEIA_SFM_TRANSFORMATION_MERGE_RECONSTRUCTIONS_H_
+#define THEIA_SFM_TRANSFORMATION_MERGE_RECONSTRUCTIONS_H_
+
+#include <memory>
+
+#include "theia/sfm/similarity_transformation.h"
+
+namespace theia {
+class RandomNumberGenerator;
+class Reconstruction;
+
+struct MergeReconstructionsOptions {
+  // Camera positions and 3D points are RANSAC inliers of the similarity
+  // transformation if their distance after alignment is less than this
+  // threshold, in the units of the reconstruction that is merged into.
+  double robust_error_threshold = 1.0;
+
+  // If true, the 3D points of the tracks shared by both reconstructions are
+  // used as correspondences in addition to the positions of the common views.
+  // Two tracks are shared if they observe the same feature in a common view.
+  bool use_common_tracks = true;
+
+  int max_ransac_iterations = 1000;
+  std::shared_ptr<RandomNumberGenerator> rng;
+
+  // Number of threads used to transform the cameras and points.
+  int num_threads = 1;
+};
+
+struct MergeReconstructionsSummary {
+  // The transformation from the merged reconstruction to the reference one.
+  SimilarityTransformation transformation;
+
+  int num_common_views = 0;
+  int num_common_tracks = 0;
+  int num_inliers = 0;
+  int num_added_views = 0;
+  int num_added_tracks = 0;
+
+  // The number of shared tracks that the observations of the merged
+  // reconstruction were added to.
+  int num_fused_tracks = 0;
+};
+
+// Merges reconstruction2 into reconstruction1. A similarity transformation
+// from reconstruction2 to reconstruction1 is estimated with RANSAC from the
+// positions of the common views (matched by name) and, optionally, the points
+// of the shared tracks. The views of reconstruction2 that are not in
+// reconstruction1 are then added with their aligned cameras. Their intrinsics
+// are copied, and each camera intrinsics group of reconstruction2 joins the
+// group of its common views in reconstruction1 or becomes a new group if it has
+// no common views. Shared tracks are fused by adding the new observations to
+// the track of reconstruction1, and all other tracks are added with their
+// aligned points. Returns false and leaves reconstruction1 unchanged if the
+// reconstructions could not be aligned.
+bool MergeReconstructions(const MergeReconstructionsOptions& options,
+                          const Reconstruction& reconstruction2,
+                          Reconstruction* reconstruction1,
+                          MergeReconstructionsSummary* summary);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_TRANSFORMATION_MERGE_RECONSTRUCTIONS_H_
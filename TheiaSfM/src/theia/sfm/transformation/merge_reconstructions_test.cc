@@ -0,0 +1,295 @@
+// Copyright (C) 2015 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (cmsweeney@cs.ucsb.edu)
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/transformation/merge_reconstructions.h"
+#include "theia/sfm/transformation/transform_reconstruction.h"
+#include "theia/sfm/types.h"
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace {
+
+RandomNumberGenerator rng(69);
+
+static const int kNumViews = 20;
+static const int kNumPoints = 200;
+
+void CreateScene(std::vector<Camera>* cameras,
+                 std::vector<Eigen::Vector3d>* points) {
+  cameras->resize(kNumViews);
+  for (int i = 0; i < kNumViews; i++) {
+    (*cameras)[i].SetPosition(10.0 * rng.RandVector3d());
+    (*cameras)[i].SetOrientationFromAngleAxis(0.2 * rng.RandVector3d());
+  }
+  points->resize(kNumPoints);
+  for (int i = 0; i < kNumPoints; i++) {
+    (*points)[i] = 10.0 * rng.RandVector3d();
+  }
+}
+
+// Builds a reconstruction of the views in [first_view, last_view) and of all
+// tracks that are observed by at least two of these views. Point i is observed
+// by four consecutive views at the features (i, view). If group_ids is not
+// empty, view i is added to the camera intrinsics group group_ids[i] and only
+// the pose of its camera is set. Otherwise each view has its own group.
+void BuildReconstruction(const std::vector<Camera>& cameras,
+                         const std::vector<Eigen::Vector3d>& points,
+                         const int first_view,
+                         const int last_view,
+                         const std::vector<CameraIntrinsicsGroupId>& group_ids,
+                         Reconstruction* reconstruction) {
+  std::vector<ViewId> view_ids(cameras.size(), kInvalidViewId);
+  for (int i = first_view; i < last_view; i++) {
+    const std::string name = StringPrintf("%d", i);
+    if (group_ids.empty()) {
+      view_ids[i] = reconstruction->AddView(name);
+      *reconstruction->MutableView(view_ids[i])->MutableCamera() = cameras[i];
+    } else {
+      view_ids[i] = reconstruction->AddView(name, group_ids[i]);
+      Camera* camera =
+          reconstruction->MutableView(view_ids[i])->MutableCamera();
+      camera->SetPosition(cameras[i].GetPosition());
+      camera->SetOrientationFromRotationMatrix(
+          cameras[i].GetOrientationAsRotationMatrix());
+    }
+    reconstruction->MutableView(view_ids[i])->SetEstimated(true);
+  }
+
+  for (int i = 0; i < points.size(); i++) {
+    std::vector<std::pair<ViewId, Feature> > track;
+    for (int j = 0; j < 4; j++) {
+      const int view = i % (cameras.size() - 3) + j;
+      if (view_ids[view] != kInvalidViewId) {
+        track.emplace_back(view_ids[view], Feature(i, view));
+      }
+    }
+    if (track.size() < 2) {
+      continue;
+    }
+    const TrackId track_id = reconstruction->AddTrack(track);
+    *reconstruction->MutableTrack(track_id)->MutablePoint() =
+        points[i].homogeneous();
+    reconstruction->MutableTrack(track_id)->SetEstimated(true);
+  }
+}
+
+void TestMergeReconstructions(const bool use_common_tracks,
+                              const int num_threads) {
+  static const double kTolerance = 1e-6;
+
+  std::vector<Camera> cameras;
+  std::vector<Eigen::Vector3d> points;
+  CreateScene(&cameras, &points);
+
+  // The reconstructions share views 8 to 11. The second reconstruction is in a
+  // different coordinate system.
+  Reconstruction reconstruction1, reconstruction2;
+  BuildReconstruction(cameras, points, 0, 12, {}, &reconstruction1);
+  BuildReconstruction(cameras, points, 8, kNumViews, {}, &reconstruction2);
+  const Eigen::Matrix3d rotation =
+      Eigen::AngleAxisd(0.7, Eigen::Vector3d(1.0, 2.0, 3.0).normalized())
+          .toRotationMatrix();
+  TransformReconstruction(
+      rotation, Eigen::Vector3d(1.0, -2.0, 3.0), 2.5, &reconstruction2);
+
+  MergeReconstructionsOptions options;
+  options.robust_error_threshold = 0.1;
+  options.use_common_tracks = use_common_tracks;
+  options.num_threads = num_threads;
+  MergeReconstructionsSummary summary;
+  EXPECT_TRUE(MergeReconstructions(
+      options, reconstruction2, &reconstruction1, &summary));
+  EXPECT_EQ(summary.num_common_views, 4);
+  EXPECT_EQ(summary.num_added_views, kNumViews - 12);
+  EXPECT_EQ(reconstruction1.NumViews(), kNumViews);
+  if (use_common_tracks) {
+    EXPECT_GT(summary.num_common_tracks, 0);
+    EXPECT_GT(summary.num_inliers, summary.num_common_views);
+  } else {
+    EXPECT_EQ(summary.num_common_tracks, 0);
+  }
+
+  // All cameras and points are in the original coordinate system.
+  for (int i = 0; i < kNumViews; i++) {
+    const ViewId view_id =
+        reconstruction1.ViewIdFromName(StringPrintf("%d", i));
+    ASSERT_NE(view_id, kInvalidViewId);
+    const Camera& camera = reconstruction1.View(view_id)->Camera();
+    EXPECT_LT((camera.GetPosition() - cameras[i].GetPosition()).norm(),
+              kTolerance);
+    EXPECT_LT((camera.GetOrientationAsRotationMatrix() -
+               cameras[i].GetOrientationAsRotationMatrix())
+                  .norm(),
+              kTolerance);
+  }
+  for (const TrackId track_id : reconstruction1.TrackIds()) {
+    const View* view = reconstruction1.View(
+        *reconstruction1.Track(track_id)->ViewIds().begin());
+    const int point_index = view->GetFeature(track_id)->x();
+    EXPECT_LT((reconstruction1.Track(track_id)->Point().hnormalized() -
+               points[point_index])
+                  .norm(),
+              kTolerance);
+  }
+
+  // Shared tracks are fused, so each point has a single track with all of
+  // its observations.
+  if (use_common_tracks) {
+    EXPECT_EQ(reconstruction1.NumTracks(), kNumPoints);
+    for (const TrackId track_id : reconstruction1.TrackIds()) {
+      EXPECT_EQ(reconstruction1.Track(track_id)->NumViews(), 4);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(MergeReconstructions, CommonViews) {
+  TestMergeReconstructions(false, 1);
+}
+
+TEST(MergeReconstructions, CommonViewsAndTracks) {
+  TestMergeReconstructions(true, 1);
+}
+
+TEST(MergeReconstructions, Multithreaded) {
+  TestMergeReconstructions(true, 4);
+}
+
+TEST(MergeReconstructions, CameraIntrinsicsGroups) {
+  std::vector<Camera> cameras;
+  std::vector<Eigen::Vector3d> points;
+  CreateScene(&cameras, &points);
+
+  // All views of the first reconstruction are in one intrinsics group. In the
+  // second reconstruction, views 8 to 15 are in a group with the common views
+  // 8 to 11 and views 16 to 19 are in a group without common views.
+  std::vector<CameraIntrinsicsGroupId> group_ids1(kNumViews, 0);
+  std::vector<CameraIntrinsicsGroupId> group_ids2(kNumViews, 0);
+  for (int i = 16; i < kNumViews; i++) {
+    group_ids2[i] = 1;
+  }
+  Reconstruction reconstruction1, reconstruction2;
+  BuildReconstruction(cameras, points, 0, 12, group_ids1, &reconstruction1);
+  BuildReconstruction(
+      cameras, points, 8, kNumViews, group_ids2, &reconstruction2);
+  const auto view = [](const Reconstruction& reconstruction, const int i) {
+    return reconstruction.View(
+        reconstruction.ViewIdFromName(StringPrintf("%d", i)));
+  };
+  reconstruction1.MutableView(reconstruction1.ViewIdFromName("0"))
+      ->MutableCamera()
+      ->SetFocalLength(1000.0);
+  reconstruction2.MutableView(reconstruction2.ViewIdFromName("8"))
+      ->MutableCamera()
+      ->SetFocalLength(2000.0);
+  reconstruction2.MutableView(reconstruction2.ViewIdFromName("16"))
+      ->MutableCamera()
+      ->SetFocalLength(3000.0);
+
+  MergeReconstructionsOptions options;
+  options.robust_error_threshold = 0.1;
+  MergeReconstructionsSummary summary;
+  EXPECT_TRUE(MergeReconstructions(
+      options, reconstruction2, &reconstruction1, &summary));
+  EXPECT_EQ(reconstruction1.NumViews(), kNumViews);
+  EXPECT_EQ(reconstruction1.NumCameraIntrinsicGroups(), 2);
+
+  // The added views of the group with common views share the intrinsics of
+  // that group in the first reconstruction.
+  const Camera& camera1 = view(reconstruction1, 0)->Camera();
+  const CameraIntrinsicsGroupId group_id1 =
+      reconstruction1.CameraIntrinsicsGroupIdFromViewId(
+          reconstruction1.ViewIdFromName("0"));
+  for (int i = 12; i < 16; i++) {
+    EXPECT_EQ(reconstruction1.CameraIntrinsicsGroupIdFromViewId(
+                  reconstruction1.ViewIdFromName(StringPrintf("%d", i))),
+              group_id1);
+    EXPECT_EQ(view(reconstruction1, i)->Camera().CameraIntrinsics(),
+              camera1.CameraIntrinsics());
+  }
+
+  // The other group is added as a new group with a copy of its intrinsics.
+  const Camera& camera16 = view(reconstruction1, 16)->Camera();
+  const CameraIntrinsicsGroupId group_id16 =
+      reconstruction1.CameraIntrinsicsGroupIdFromViewId(
+          reconstruction1.ViewIdFromName("16"));
+  EXPECT_NE(group_id16, group_id1);
+  EXPECT_EQ(camera16.FocalLength(), 3000.0);
+  EXPECT_NE(camera16.CameraIntrinsics(),
+            view(reconstruction2, 16)->Camera().CameraIntrinsics());
+  for (int i = 17; i < kNumViews; i++) {
+    EXPECT_EQ(reconstruction1.CameraIntrinsicsGroupIdFromViewId(
+                  reconstruction1.ViewIdFromName(StringPrintf("%d", i))),
+              group_id16);
+    EXPECT_EQ(view(reconstruction1, i)->Camera().CameraIntrinsics(),
+              camera16.CameraIntrinsics());
+  }
+
+  // Changing the merged intrinsics does not change the second reconstruction.
+  reconstruction1.MutableView(reconstruction1.ViewIdFromName("16"))
+      ->MutableCamera()
+      ->SetFocalLength(4000.0);
+  EXPECT_EQ(camera1.FocalLength(), 1000.0);
+  EXPECT_EQ(view(reconstruction2, 8)->Camera().FocalLength(), 2000.0);
+  EXPECT_EQ(view(reconstruction2, 16)->Camera().FocalLength(), 3000.0);
+}
+
+TEST(MergeReconstructions, NotEnoughCommonViews) {
+  Reconstruction reconstruction1, reconstruction2;
+  for (int i = 0; i < 3; i++) {
+    reconstruction1.AddView(StringPrintf("%d", i));
+    reconstruction2.AddView(StringPrintf("%d", i + 2));
+  }
+
+  MergeReconstructionsOptions options;
+  MergeReconstructionsSummary summary;
+  EXPECT_FALSE(MergeReconstructions(
+      options, reconstruction2, &reconstruction1, &summary));
+  EXPECT_EQ(reconstruction1.NumViews(), 3);
+}
+
+}  // namespace theia
@@ -35,12 +35,18 @@
 #include "theia/sfm/transformation/transform_reconstruction.h"
 
 #include <Eigen/Core>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 #include "theia/sfm/camera/camera.h"
 #include "theia/sfm/reconstruction.h"
 #include "theia/sfm/track.h"
 #include "theia/sfm/types.h"
 #include "theia/sfm/view.h"
+#include "theia/util/threadpool.h"
 
 namespace theia {
 namespace {
@@ -74,23 +80,78 @@ void TransformReconstruction(const Eigen::Matrix3d& rotation,
                              const Eigen::Vector3d& translation,
                              const double scale,
                              Reconstruction* reconstruction) {
+  TransformReconstruction(rotation, translation, scale, 1, reconstruction);
+}
+
+void TransformReconstruction(const Eigen::Matrix3d& rotation,
+                             const Eigen::Vector3d& translation,
+                             const double scale,
+                             const int num_threads,
+                             Reconstruction* reconstruction) {
+  // Gather the estimated cameras and points so that they can be transformed
+  // without hash lookups.
   const auto& view_ids = reconstruction->ViewIds();
+  std::vector<Camera*> cameras;
+  cameras.reserve(view_ids.size());
   for (const ViewId view_id : view_ids) {
     View* view = reconstruction->MutableView(view_id);
     if (view->IsEstimated()) {
-      TransformCamera(rotation, translation, scale, view->MutableCamera());
+      cameras.emplace_back(view->MutableCamera());
     }
   }
 
   const auto& track_ids = reconstruction->TrackIds();
+  std::vector<Eigen::Vector4d*> points;
+  points.reserve(track_ids.size());
   for (const TrackId track_id : track_ids) {
     Track* track = reconstruction->MutableTrack(track_id);
     if (track->IsEstimated()) {
-      Eigen::Vector3d point = track->Point().hnormalized();
-      TransformPoint(rotation, translation, scale, &point);
-      *track->MutablePoint() = point.homogeneous();
+      points.emplace_back(track->MutablePoint());
     }
   }
+
+  TransformCamerasAndPoints(
+      rotation, translation, scale, num_threads, &cameras, &points);
+}
+
+void TransformCamerasAndPoints(
+    const Eigen::Matrix3d& rotation,
+    const Eigen::Vector3d& translation,
+    const double scale,
+    const int num_threads,
+    std::vector<Camera*>* cameras,
+    std::vector<Eigen::Vector4d*>* points) {
+  CHECK_GT(num_threads, 0);
+  const int num_items = (cameras == nullptr ? 0 : cameras->size()) +
+                        (points == nullptr ? 0 : points->size());
+  std::unique_ptr<ThreadPool> pool;
+  if (num_threads > 1 && num_items > num_threads) {
+    pool.reset(new ThreadPool(num_threads));
+  }
+
+  if (cameras != nullptr) {
+    ParallelFor(pool.get(),
+                num_threads,
+                cameras->size(),
+                [&](const int, const int start, const int end) {
+                  for (int i = start; i < end; i++) {
+                    TransformCamera(
+                        rotation, translation, scale, (*cameras)[i]);
+                  }
+                });
+  }
+  if (points != nullptr) {
+    ParallelFor(pool.get(),
+                num_threads,
+                points->size(),
+                [&](const int, const int start, const int end) {
+                  for (int i = start; i < end; i++) {
+                    Eigen::Vector3d point = (*points)[i]->hnormalized();
+                    TransformPoint(rotation, translation, scale, &point);
+                    *(*points)[i] = point.homogeneous();
+                  }
+                });
+  }
 }
 
 }  // namespace theia
@@ -36,8 +36,10 @@
 #define THEIA_SFM_TRANSFORMATION_TRANSFORM_RECONSTRUCTION_H_
 
 #include <Eigen/Core>
+#include <vector>
 
 namespace theia {
+class Camera;
 class Reconstruction;
 
 // Applies the similarity transformation to the reconstruction, transforming the
@@ -47,6 +49,24 @@ void TransformReconstruction(const Eigen::Matrix3d& rotation,
                              const double scale,
                              Reconstruction* reconstruction);
 
+// Same as above, but the cameras and points are transformed in parallel with
+// num_threads threads.
+void TransformReconstruction(const Eigen::Matrix3d& rotation,
+                             const Eigen::Vector3d& translation,
+                             const double scale,
+                             const int num_threads,
+                             Reconstruction* reconstruction);
+
+// Applies the similarity transformation to the cameras and homogeneous points
+// with num_threads threads. Either of the arrays may be nullptr.
+void TransformCamerasAndPoints(
+    const Eigen::Matrix3d& rotation,
+    const Eigen::Vector3d& translation,
+    const double scale,
+    const int num_threads,
+    std::vector<Camera*>* cameras,
+    std::vector<Eigen::Vector4d*>* points);
+
 }  // namespace theia
 
 #endif  // THEIA_SFM_TRANSFORMATION_TRANSFORM_RECONSTRUCTION_H_
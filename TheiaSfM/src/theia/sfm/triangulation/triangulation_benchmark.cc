@@ -0,0 +1,144 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <vector>
+
+#include "theia/sfm/pose/test_util.h"
+#include "theia/sfm/triangulation/triangulation.h"
+#include "theia/sfm/types.h"
+#include "theia/test/benchmark.h"
+#include "theia/util/random.h"
+
+namespace theia {
+namespace {
+
+using Eigen::AngleAxisd;
+using Eigen::Matrix3d;
+using Eigen::Vector2d;
+using Eigen::Vector3d;
+using Eigen::Vector4d;
+
+static const int kNumProblems = 256;
+static const double kProjectionNoise = 1e-3;
+
+// A single 3D point observed by several cameras.
+struct TriangulationProblem {
+  std::vector<Matrix3x4d> poses;
+  std::vector<Vector2d> points;
+};
+
+// Generates points observed by num_views cameras that are scattered around the
+// origin and look roughly towards the point. A fixed seed is used so that every
+// run of the benchmark uses the same data.
+std::vector<TriangulationProblem> GenerateTriangulationProblems(
+    const int num_views) {
+  RandomNumberGenerator rng(59);
+  std::vector<TriangulationProblem> problems(kNumProblems);
+  for (TriangulationProblem& problem : problems) {
+    const Vector3d point(rng.RandDouble(-1.0, 1.0),
+                         rng.RandDouble(-1.0, 1.0),
+                         rng.RandDouble(4.0, 8.0));
+    problem.poses.resize(num_views);
+    problem.points.resize(num_views);
+    for (int i = 0; i < num_views; i++) {
+      const Matrix3d rotation =
+          AngleAxisd(rng.RandDouble(-0.2, 0.2), rng.RandVector3d().normalized())
+              .toRotationMatrix();
+      const Vector3d position(rng.RandDouble(-2.0, 2.0),
+                              rng.RandDouble(-2.0, 2.0),
+                              rng.RandDouble(-1.0, 1.0));
+      problem.poses[i] << rotation, -rotation * position;
+      problem.points[i] =
+          (problem.poses[i] * point.homogeneous()).hnormalized();
+      AddNoiseToProjection(kProjectionNoise, &rng, &problem.points[i]);
+    }
+  }
+  return problems;
+}
+
+void BM_TriangulateNView(benchmark::State& state) {
+  const std::vector<TriangulationProblem> problems =
+      GenerateTriangulationProblems(state.range(0));
+  Vector4d triangulated_point;
+  int i = 0;
+  while (state.KeepRunning()) {
+    const TriangulationProblem& problem = problems[i++ % kNumProblems];
+    const bool success =
+        TriangulateNView(problem.poses, problem.points, &triangulated_point);
+    benchmark::DoNotOptimize(success);
+    benchmark::DoNotOptimize(triangulated_point);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TriangulateNView)->Arg(2)->Arg(8)->Arg(32);
+
+void BM_TriangulateNViewSVD(benchmark::State& state) {
+  const std::vector<TriangulationProblem> problems =
+      GenerateTriangulationProblems(state.range(0));
+  Vector4d triangulated_point;
+  int i = 0;
+  while (state.KeepRunning()) {
+    const TriangulationProblem& problem = problems[i++ % kNumProblems];
+    const bool success = TriangulateNViewSVD(problem.poses, problem.points,
+                                             &triangulated_point);
+    benchmark::DoNotOptimize(success);
+    benchmark::DoNotOptimize(triangulated_point);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TriangulateNViewSVD)->Arg(2)->Arg(8)->Arg(32);
+
+// The optimal two view triangulation for reference.
+void BM_Triangulate(benchmark::State& state) {
+  const std::vector<TriangulationProblem> problems =
+      GenerateTriangulationProblems(2);
+  Vector4d triangulated_point;
+  int i = 0;
+  while (state.KeepRunning()) {
+    const TriangulationProblem& problem = problems[i++ % kNumProblems];
+    const bool success = Triangulate(problem.poses[0], problem.poses[1],
+                                     problem.points[0], problem.points[1],
+                                     &triangulated_point);
+    benchmark::DoNotOptimize(success);
+    benchmark::DoNotOptimize(triangulated_point);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Triangulate);
+
+}  // namespace
+}  // namespace theia
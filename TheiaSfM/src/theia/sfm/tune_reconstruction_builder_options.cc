@@ -0,0 +1,622 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/sfm/tune_reconstruction_builder_options.h"
+
+#include <Eigen/Core>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "theia/image/keypoint_detector/keypoint.h"
+#include "theia/matching/create_feature_matcher.h"
+#include "theia/matching/feature_matcher.h"
+#include "theia/matching/image_pair_match.h"
+#include "theia/matching/keypoints_and_descriptors.h"
+#include "theia/sfm/bundle_adjustment/bundle_adjustment.h"
+#include "theia/sfm/camera/camera.h"
+#include "theia/sfm/camera_intrinsics_prior.h"
+#include "theia/sfm/exif_reader.h"
+#include "theia/sfm/feature_extractor.h"
+#include "theia/sfm/memory_accounting.h"
+#include "theia/sfm/reconstruction.h"
+#include "theia/sfm/reconstruction_builder.h"
+#include "theia/sfm/reconstruction_estimator_options.h"
+#include "theia/sfm/reconstruction_estimator_utils.h"
+#include "theia/sfm/synthetic_scene.h"
+#include "theia/sfm/track.h"
+#include "theia/sfm/view.h"
+#include "theia/util/filesystem.h"
+#include "theia/util/random.h"
+#include "theia/util/stringprintf.h"
+#include "theia/util/timer.h"
+
+namespace theia {
+
+namespace {
+
+// The options that make up the bundle adjustment schedule of a reconstruction.
+struct BundleAdjustmentSchedule {
+  int num_retriangulation_iterations;
+  double full_bundle_adjustment_growth_percent;
+  int partial_bundle_adjustment_num_views;
+  bool subsample_tracks_for_bundle_adjustment;
+};
+
+// Chooses the images used to calibrate feature extraction and matching: pairs
+// of consecutive images that are evenly spread over the image collection.
+std::vector<std::string> ChooseCalibrationImages(
+    const int num_calibration_images,
+    const std::vector<std::string>& image_filepaths) {
+  const int num_images = image_filepaths.size();
+  const int num_anchors =
+      std::max(1, std::min(num_calibration_images, num_images) / 2);
+  std::vector<int> indices;
+  for (int i = 0; i < num_anchors; i++) {
+    const int anchor = (num_images - 1) * i / num_anchors;
+    indices.emplace_back(anchor);
+    indices.emplace_back(anchor + 1);
+  }
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+  std::vector<std::string> calibration_images;
+  calibration_images.reserve(indices.size());
+  for (const int index : indices) {
+    calibration_images.emplace_back(image_filepaths[index]);
+  }
+  return calibration_images;
+}
+
+// Matches the calibration images with a single thread and returns the elapsed
+// time in seconds.
+double TimeFeatureMatching(
+    const ReconstructionBuilderOptions& options,
+    const bool perform_geometric_verification,
+    const bool bundle_adjust_two_view_geometry,
+    const std::vector<std::string>& image_names,
+    const std::vector<std::vector<Keypoint> >& keypoints,
+    const std::vector<std::vector<Eigen::VectorXf> >& descriptors,
+    const std::vector<CameraIntrinsicsPrior>& intrinsics,
+    std::vector<ImagePairMatch>* matches) {
+  FeatureMatcherOptions matcher_options = options.matching_options;
+  matcher_options.num_threads = 1;
+  matcher_options.match_out_of_core = false;
+  matcher_options.max_matches_size_in_bytes = 0;
+  matcher_options.progress_reporter = nullptr;
+  matcher_options.perform_geometric_verification =
+      perform_geometric_verification;
+  matcher_options.geometric_verification_options.min_num_inlier_matches =
+      options.min_num_inlier_matches;
+  matcher_options.geometric_verification_options.bundle_adjustment =
+      bundle_adjust_two_view_geometry;
+  matcher_options.geometric_verification_options.estimate_twoview_info_options
+      .rng = options.rng;
+
+  Timer timer;
+  std::unique_ptr<FeatureMatcher> matcher =
+      CreateFeatureMatcher(options.matching_strategy, matcher_options);
+  for (int i = 0; i < image_names.size(); i++) {
+    matcher->AddImage(image_names[i], keypoints[i], descriptors[i],
+                      intrinsics[i]);
+  }
+  matches->clear();
+  matcher->MatchImages(matches);
+  return timer.ElapsedTimeInSeconds();
+}
+
+// Extracts and matches the features of a sample of the images to measure the
+// cost of each stage, the memory of the features, and the number of
+// observations per view.
+bool CalibrateFeatureExtractionAndMatching(
+    const TuneReconstructionBuilderOptionsOptions& tuning_options,
+    const std::vector<std::string>& image_filepaths,
+    const ReconstructionBuilderOptions& options,
+    TuneReconstructionBuilderOptionsSummary* summary) {
+  const std::vector<std::string> calibration_images = ChooseCalibrationImages(
+      tuning_options.num_calibration_images, image_filepaths);
+  const int num_calibration_images = calibration_images.size();
+  if (num_calibration_images < 2) {
+    LOG(ERROR) << "At least 2 images are needed to tune the options.";
+    return false;
+  }
+
+  FeatureExtractor::Options extractor_options;
+  extractor_options.num_threads = 1;
+  extractor_options.descriptor_extractor_type = options.descriptor_type;
+  extractor_options.feature_density = options.feature_density;
+  FeatureExtractor extractor(extractor_options);
+
+  std::vector<std::vector<Keypoint> > keypoints;
+  std::vector<std::vector<Eigen::VectorXf> > descriptors;
+  Timer timer;
+  if (!extractor.Extract(calibration_images, &keypoints, &descriptors)) {
+    LOG(ERROR) << "Could not extract the features of the calibration images.";
+    return false;
+  }
+  summary->extraction_time_per_image =
+      timer.ElapsedTimeInSeconds() / num_calibration_images;
+
+  const ExifReader exif_reader;
+  std::vector<std::string> image_names(num_calibration_images);
+  std::vector<CameraIntrinsicsPrior> intrinsics(num_calibration_images);
+  for (int i = 0; i < num_calibration_images; i++) {
+    CHECK(GetFilenameFromFilepath(calibration_images[i], true,
+                                  &image_names[i]));
+    exif_reader.ExtractEXIFMetadata(calibration_images[i], &intrinsics[i]);
+  }
+
+  const double num_pairs =
+      num_calibration_images * (num_calibration_images - 1) / 2.0;
+  const bool bundle_adjustment =
+      options.matching_options.geometric_verification_options.bundle_adjustment;
+  std::vector<ImagePairMatch> matches;
+  const double matching_time =
+      TimeFeatureMatching(options, false, bundle_adjustment, image_names,
+                          keypoints, descriptors, intrinsics, &matches);
+  summary->matching_time_per_pair = matching_time / num_pairs;
+
+  std::vector<ImagePairMatch> verified_matches;
+  const double verification_time =
+      TimeFeatureMatching(options, true, bundle_adjustment, image_names,
+                          keypoints, descriptors, intrinsics,
+                          &verified_matches) -
+      matching_time;
+  summary->verification_time_per_pair =
+      std::max(verification_time, 0.0) / num_pairs;
+
+  if (bundle_adjustment) {
+    const double verification_time_without_bundle_adjustment =
+        TimeFeatureMatching(options, true, false, image_names, keypoints,
+                            descriptors, intrinsics, &matches) -
+        matching_time;
+    summary->verification_time_per_pair_without_bundle_adjustment =
+        std::max(verification_time_without_bundle_adjustment, 0.0) / num_pairs;
+  }
+
+  // Each view typically overlaps with at least the previous and the next view
+  // in the collection, so the number of observations per view is estimated
+  // as twice the number of verified matches of an overlapping pair.
+  int64_t num_features = 0;
+  for (int i = 0; i < num_calibration_images; i++) {
+    KeypointsAndDescriptors features;
+    features.image_name = image_names[i];
+    features.keypoints.swap(keypoints[i]);
+    features.descriptors.swap(descriptors[i]);
+    summary->feature_memory_per_image_in_bytes += EstimateMemoryUsage(features);
+    num_features += features.keypoints.size();
+  }
+  summary->feature_memory_per_image_in_bytes /= num_calibration_images;
+
+  int64_t num_verified_correspondences = 0;
+  for (const ImagePairMatch& match : verified_matches) {
+    num_verified_correspondences += match.correspondences.size();
+  }
+  const int num_features_per_view = num_features / num_calibration_images;
+  if (verified_matches.empty()) {
+    summary->num_observations_per_view =
+        std::min(2 * options.min_num_inlier_matches, num_features_per_view);
+  } else {
+    summary->num_observations_per_view = std::min<int64_t>(
+        2 * num_verified_correspondences / verified_matches.size(),
+        num_features_per_view);
+  }
+  return true;
+}
+
+// Returns the time of a full bundle adjustment of a perturbed synthetic scene
+// with the given number of views and the number of observations in the scene.
+double TimeSyntheticBundleAdjustment(
+    const int num_views,
+    const int num_observations_per_view,
+    const BundleAdjustmentOptions& ba_options,
+    const std::shared_ptr<RandomNumberGenerator>& rng,
+    int* num_observations) {
+  // Each point of the synthetic scene is observed by up to max_track_length
+  // views.
+  SyntheticSceneOptions scene_options;
+  scene_options.rng = rng;
+  scene_options.num_views = num_views;
+  scene_options.num_points = std::max(
+      1, num_views * num_observations_per_view / scene_options.max_track_length);
+  std::vector<std::string> view_names;
+  std::vector<CameraIntrinsicsPrior> camera_intrinsics_priors;
+  std::vector<ImagePairMatch> matches;
+  Reconstruction reconstruction;
+  GenerateSyntheticScene(scene_options, &view_names, &camera_intrinsics_priors,
+                         &matches, &reconstruction);
+
+  // Perturb the cameras and points so that the optimization takes a typical
+  // number of iterations.
+  static const double kPositionNoise = 0.5;
+  *num_observations = 0;
+  for (const ViewId view_id : reconstruction.ViewIds()) {
+    Camera* camera = reconstruction.MutableView(view_id)->MutableCamera();
+    camera->SetPosition(camera->GetPosition() +
+                        kPositionNoise * rng->RandVector3d());
+    *num_observations += reconstruction.View(view_id)->NumFeatures();
+  }
+  for (const TrackId track_id : reconstruction.TrackIds()) {
+    Eigen::Vector4d* point = reconstruction.MutableTrack(track_id)
+                                 ->MutablePoint();
+    point->head<3>() += kPositionNoise * rng->RandVector3d();
+  }
+
+  const BundleAdjustmentSummary ba_summary =
+      BundleAdjustReconstruction(ba_options, &reconstruction);
+  return ba_summary.setup_time_in_seconds + ba_summary.solve_time_in_seconds;
+}
+
+// Fits the cost model of full bundle adjustment to two synthetic
+// sub-reconstructions of different sizes.
+void CalibrateBundleAdjustment(
+    const TuneReconstructionBuilderOptionsOptions& tuning_options,
+    const int num_images,
+    const ReconstructionBuilderOptions& options,
+    TuneReconstructionBuilderOptionsSummary* summary) {
+  static const double kMinTimeInSeconds = 1e-6;
+
+  std::shared_ptr<RandomNumberGenerator> rng = tuning_options.rng;
+  if (rng == nullptr) {
+    rng = std::make_shared<RandomNumberGenerator>();
+  }
+
+  // The solver is chosen for the size of the full reconstruction.
+  BundleAdjustmentOptions ba_options = SetBundleAdjustmentOptions(
+      options.reconstruction_estimator_options, num_images);
+  ba_options.progress_reporter = nullptr;
+  ba_options.verbose = false;
+
+  const int num_views = std::max(2, tuning_options.num_calibration_views);
+  int num_observations1 = 0, num_observations2 = 0;
+  const double time1 = std::max(
+      kMinTimeInSeconds,
+      TimeSyntheticBundleAdjustment(num_views,
+                                    summary->num_observations_per_view,
+                                    ba_options, rng, &num_observations1));
+  const double time2 = std::max(
+      kMinTimeInSeconds,
+      TimeSyntheticBundleAdjustment(2 * num_views,
+                                    summary->num_observations_per_view,
+                                    ba_options, rng, &num_observations2));
+
+  // Bundle adjustment is at least linear in the number of observations. The
+  // exponent is clamped since small problems are dominated by noise and
+  // overhead.
+  double exponent = 1.0;
+  if (num_observations1 > 0 && num_observations2 > num_observations1) {
+    exponent = std::log(time2 / time1) /
+               std::log(static_cast<double>(num_observations2) /
+                        num_observations1);
+  }
+  summary->bundle_adjustment_cost_exponent =
+      std::min(std::max(exponent, 1.0), 3.0);
+  summary->bundle_adjustment_cost_scale =
+      time2 / std::pow(std::max(num_observations2, 1),
+                       summary->bundle_adjustment_cost_exponent);
+}
+
+BundleAdjustmentSchedule GetSchedule(
+    const ReconstructionEstimatorOptions& options) {
+  BundleAdjustmentSchedule schedule;
+  schedule.num_retriangulation_iterations =
+      options.num_retriangulation_iterations;
+  schedule.full_bundle_adjustment_growth_percent =
+      options.full_bundle_adjustment_growth_percent;
+  schedule.partial_bundle_adjustment_num_views =
+      options.partial_bundle_adjustment_num_views;
+  schedule.subsample_tracks_for_bundle_adjustment =
+      options.subsample_tracks_for_bundle_adjustment;
+  return schedule;
+}
+
+void SetSchedule(const BundleAdjustmentSchedule& schedule,
+                 ReconstructionEstimatorOptions* options) {
+  options->num_retriangulation_iterations =
+      schedule.num_retriangulation_iterations;
+  options->full_bundle_adjustment_growth_percent =
+      schedule.full_bundle_adjustment_growth_percent;
+  options->partial_bundle_adjustment_num_views =
+      schedule.partial_bundle_adjustment_num_views;
+  options->subsample_tracks_for_bundle_adjustment =
+      schedule.subsample_tracks_for_bundle_adjustment;
+}
+
+// Returns the candidate schedules, from the most to the least accurate. The
+// first candidate is the schedule of the options.
+std::vector<BundleAdjustmentSchedule> GetCandidateSchedules(
+    const ReconstructionEstimatorOptions& options) {
+  static const double kGrowthPercents[] = {10.0, 20.0, 40.0, 80.0};
+  static const int kPartialNumViews[] = {10, 5};
+
+  const BundleAdjustmentSchedule initial_schedule = GetSchedule(options);
+  std::vector<BundleAdjustmentSchedule> schedules;
+  if (options.reconstruction_estimator_type ==
+      ReconstructionEstimatorType::GLOBAL) {
+    BundleAdjustmentSchedule schedule = initial_schedule;
+    for (int i = initial_schedule.num_retriangulation_iterations; i >= 0; i--) {
+      schedule.num_retriangulation_iterations = i;
+      schedules.emplace_back(schedule);
+    }
+  } else {
+    std::vector<double> growth_percents(
+        1, initial_schedule.full_bundle_adjustment_growth_percent);
+    for (const double growth_percent : kGrowthPercents) {
+      if (growth_percent > growth_percents.front()) {
+        growth_percents.emplace_back(growth_percent);
+      }
+    }
+    std::vector<int> partial_num_views(
+        1, initial_schedule.partial_bundle_adjustment_num_views);
+    for (const int num_views : kPartialNumViews) {
+      if (num_views < partial_num_views.front()) {
+        partial_num_views.emplace_back(num_views);
+      }
+    }
+
+    BundleAdjustmentSchedule schedule = initial_schedule;
+    for (const double growth_percent : growth_percents) {
+      schedule.full_bundle_adjustment_growth_percent = growth_percent;
+      for (const int num_views : partial_num_views) {
+        schedule.partial_bundle_adjustment_num_views = num_views;
+        schedules.emplace_back(schedule);
+      }
+    }
+  }
+
+  if (!initial_schedule.subsample_tracks_for_bundle_adjustment) {
+    BundleAdjustmentSchedule schedule = schedules.back();
+    schedule.subsample_tracks_for_bundle_adjustment = true;
+    schedules.emplace_back(schedule);
+  }
+  return schedules;
+}
+
+// Predicts the total time spent in bundle adjustment with the schedule.
+double PredictBundleAdjustmentTime(
+    const ReconstructionEstimatorOptions& options,
+    const BundleAdjustmentSchedule& schedule,
+    const TuneReconstructionBuilderOptionsSummary& summary) {
+  // Subsampling keeps roughly min_num_optimized_tracks_per_view observations
+  // in each view.
+  int num_observations_per_view = summary.num_observations_per_view;
+  if (schedule.subsample_tracks_for_bundle_adjustment) {
+    num_observations_per_view = std::min(
+        num_observations_per_view, options.min_num_optimized_tracks_per_view);
+  }
+  const auto cost = [&](const double num_views) {
+    return summary.bundle_adjustment_cost_scale *
+           std::pow(num_views * num_observations_per_view,
+                    summary.bundle_adjustment_cost_exponent);
+  };
+
+  const int num_views = summary.num_images;
+  if (options.reconstruction_estimator_type ==
+      ReconstructionEstimatorType::GLOBAL) {
+    // The global pipeline optimizes all views once after each retriangulation
+    // and optionally once after position estimation.
+    const int num_full_bundle_adjustments =
+        schedule.num_retriangulation_iterations + 1 +
+        (options.refine_camera_positions_and_points_after_position_estimation
+             ? 1
+             : 0);
+    return num_full_bundle_adjustments * cost(num_views);
+  }
+
+  // The incremental pipelines optimize all views whenever the reconstruction
+  // has grown by the growth percent and optimize the most recent views after
+  // every other localized view.
+  const double growth =
+      1.0 + std::max(schedule.full_bundle_adjustment_growth_percent, 1.0) /
+                100.0;
+  double time = 0.0;
+  for (double n = num_views; n >= 2.0; n /= growth) {
+    time += cost(n);
+  }
+  time += num_views *
+          cost(std::min(schedule.partial_bundle_adjustment_num_views,
+                        num_views));
+  return time;
+}
+
+}  // namespace
+
+std::string TuneReconstructionBuilderOptionsSummary::ToString() const {
+  std::string str;
+  str += StringPrintf("num_images: %d\n", num_images);
+  str += StringPrintf("extraction_time_per_image: %f\n",
+                      extraction_time_per_image);
+  str += StringPrintf("matching_time_per_pair: %f\n", matching_time_per_pair);
+  str += StringPrintf("verification_time_per_pair: %f\n",
+                      verification_time_per_pair);
+  str += StringPrintf("verification_time_per_pair_without_bundle_adjustment: "
+                      "%f\n",
+                      verification_time_per_pair_without_bundle_adjustment);
+  str += StringPrintf("feature_memory_per_image_in_bytes: %lld\n",
+                      static_cast<long long>(feature_memory_per_image_in_bytes));
+  str += StringPrintf("num_observations_per_view: %d\n",
+                      num_observations_per_view);
+  str += StringPrintf("bundle_adjustment_cost_scale: %g\n",
+                      bundle_adjustment_cost_scale);
+  str += StringPrintf("bundle_adjustment_cost_exponent: %f\n",
+                      bundle_adjustment_cost_exponent);
+  str += StringPrintf("predicted_extraction_time: %f\n",
+                      predicted_extraction_time);
+  str += StringPrintf("predicted_matching_time: %f\n", predicted_matching_time);
+  str += StringPrintf("predicted_bundle_adjustment_time: %f\n",
+                      predicted_bundle_adjustment_time);
+  str += StringPrintf("predicted_total_time: %f\n", predicted_total_time);
+  str += StringPrintf("cache_capacity: %d\n", cache_capacity);
+  str += StringPrintf("bundle_adjust_two_view_geometry: %d\n",
+                      bundle_adjust_two_view_geometry);
+  str += StringPrintf("num_retriangulation_iterations: %d\n",
+                      num_retriangulation_iterations);
+  str += StringPrintf("subsample_tracks_for_bundle_adjustment: %d\n",
+                      subsample_tracks_for_bundle_adjustment);
+  str += StringPrintf("full_bundle_adjustment_growth_percent: %f\n",
+                      full_bundle_adjustment_growth_percent);
+  str += StringPrintf("partial_bundle_adjustment_num_views: %d\n",
+                      partial_bundle_adjustment_num_views);
+  return str;
+}
+
+bool TuneReconstructionBuilderOptions(
+    const TuneReconstructionBuilderOptionsOptions& tuning_options,
+    const std::vector<std::string>& image_filepaths,
+    ReconstructionBuilderOptions* options,
+    TuneReconstructionBuilderOptionsSummary* summary) {
+  CHECK_NOTNULL(options);
+  CHECK_NOTNULL(summary);
+
+  *summary = TuneReconstructionBuilderOptionsSummary();
+  summary->num_images = image_filepaths.size();
+  if (!CalibrateFeatureExtractionAndMatching(tuning_options, image_filepaths,
+                                             *options, summary)) {
+    return false;
+  }
+  CalibrateBundleAdjustment(tuning_options, summary->num_images, *options,
+                            summary);
+
+  ChooseReconstructionBuilderOptions(tuning_options, options, summary);
+  return true;
+}
+
+void ChooseReconstructionBuilderOptions(
+    const TuneReconstructionBuilderOptionsOptions& tuning_options,
+    ReconstructionBuilderOptions* options,
+    TuneReconstructionBuilderOptionsSummary* summary) {
+  CHECK_NOTNULL(options);
+  CHECK_NOTNULL(summary);
+
+  const int num_images = summary->num_images;
+  const int num_threads = std::max(options->num_threads, 1);
+  const double num_pairs = num_images * (num_images - 1) / 2.0;
+  FeatureMatcherOptions& matching_options = options->matching_options;
+  ReconstructionEstimatorOptions& estimator_options =
+      options->reconstruction_estimator_options;
+
+  // The reconstruction builder gives a quarter of the memory budget to the
+  // feature cache unless the cache size is set explicitly.
+  int64_t max_cache_size_in_bytes = matching_options.max_cache_size_in_bytes;
+  if (max_cache_size_in_bytes == 0) {
+    max_cache_size_in_bytes = options->max_memory_usage_in_bytes / 4;
+  }
+  if (max_cache_size_in_bytes > 0 &&
+      summary->feature_memory_per_image_in_bytes > 0) {
+    matching_options.cache_capacity = static_cast<int>(std::min<int64_t>(
+        max_cache_size_in_bytes / summary->feature_memory_per_image_in_bytes,
+        num_images));
+  }
+  // Out of core matching requires room for more than the two images of a pair.
+  const int min_cache_capacity = matching_options.match_out_of_core ? 3 : 2;
+  matching_options.cache_capacity = std::max(
+      std::min(matching_options.cache_capacity, num_images),
+      min_cache_capacity);
+
+  // Predict the time of feature extraction and matching.
+  bool& bundle_adjust_two_view_geometry =
+      matching_options.geometric_verification_options.bundle_adjustment;
+  const auto predict_matching_time = [&]() {
+    const double verification_time_per_pair =
+        bundle_adjust_two_view_geometry
+            ? summary->verification_time_per_pair
+            : summary->verification_time_per_pair_without_bundle_adjustment;
+    return num_pairs *
+           (summary->matching_time_per_pair + verification_time_per_pair) /
+           num_threads;
+  };
+  summary->predicted_extraction_time =
+      num_images * summary->extraction_time_per_image / num_threads;
+  summary->predicted_matching_time = predict_matching_time();
+
+  const double target_time = tuning_options.target_wall_time_in_seconds;
+  if (target_time > 0.0 && bundle_adjust_two_view_geometry &&
+      summary->verification_time_per_pair_without_bundle_adjustment >= 0.0 &&
+      summary->verification_time_per_pair_without_bundle_adjustment <
+          summary->verification_time_per_pair &&
+      summary->predicted_extraction_time + summary->predicted_matching_time >
+          target_time / 2.0) {
+    bundle_adjust_two_view_geometry = false;
+    summary->predicted_matching_time = predict_matching_time();
+  }
+
+  // Choose the most accurate bundle adjustment schedule that fits in the time
+  // that remains after feature extraction and matching.
+  if (target_time > 0.0) {
+    const double bundle_adjustment_time = target_time -
+                                          summary->predicted_extraction_time -
+                                          summary->predicted_matching_time;
+    const std::vector<BundleAdjustmentSchedule> schedules =
+        GetCandidateSchedules(estimator_options);
+    int best_schedule = -1;
+    double min_time = 0.0;
+    for (int i = 0; i < schedules.size(); i++) {
+      const double time =
+          PredictBundleAdjustmentTime(estimator_options, schedules[i], *summary);
+      if (time <= bundle_adjustment_time) {
+        best_schedule = i;
+        break;
+      }
+      if (best_schedule < 0 || time < min_time) {
+        best_schedule = i;
+        min_time = time;
+      }
+    }
+    SetSchedule(schedules[best_schedule], &estimator_options);
+  }
+
+  summary->predicted_bundle_adjustment_time = PredictBundleAdjustmentTime(
+      estimator_options, GetSchedule(estimator_options), *summary);
+  summary->predicted_total_time = summary->predicted_extraction_time +
+                                  summary->predicted_matching_time +
+                                  summary->predicted_bundle_adjustment_time;
+
+  summary->cache_capacity = matching_options.cache_capacity;
+  summary->bundle_adjust_two_view_geometry = bundle_adjust_two_view_geometry;
+  summary->num_retriangulation_iterations =
+      estimator_options.num_retriangulation_iterations;
+  summary->subsample_tracks_for_bundle_adjustment =
+      estimator_options.subsample_tracks_for_bundle_adjustment;
+  summary->full_bundle_adjustment_growth_percent =
+      estimator_options.full_bundle_adjustment_growth_percent;
+  summary->partial_bundle_adjustment_num_views =
+      estimator_options.partial_bundle_adjustment_num_views;
+}
+
+}  // namespace theia
@@ -0,0 +1,148 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#ifndef THEIA_SFM_TUNE_RECONSTRUCTION_BUILDER_OPTIONS_H_
+#define THEIA_SFM_TUNE_RECONSTRUCTION_BUILDER_OPTIONS_H_
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace theia {
+
+class RandomNumberGenerator;
+struct ReconstructionBuilderOptions;
+
+struct TuneReconstructionBuilderOptionsOptions {
+  // The desired wall time in seconds of the entire reconstruction, including
+  // feature extraction and matching. If this is 0, the costs are measured and
+  // the running time is predicted but only the memory related options are
+  // changed.
+  double target_wall_time_in_seconds = 0.0;
+
+  // Number of images used to measure the cost of feature extraction, matching,
+  // and geometric verification. Half of them are consecutive to the other half
+  // so that the sample contains overlapping image pairs (assuming that the
+  // images are ordered by capture time).
+  int num_calibration_images = 8;
+
+  // Bundle adjustment is calibrated on two synthetic sub-reconstructions with
+  // this many and twice this many views that have the same number of
+  // observations per view as the measured image pairs.
+  int num_calibration_views = 16;
+
+  // Used to sample the synthetic sub-reconstructions. If this is a nullptr then
+  // the random generator will be initialized based on the current time.
+  std::shared_ptr<RandomNumberGenerator> rng;
+};
+
+// The measured costs, the predicted running time, and the chosen values of a
+// call to TuneReconstructionBuilderOptions. All times are in seconds.
+struct TuneReconstructionBuilderOptionsSummary {
+  int num_images = 0;
+
+  // ----------------- Calibration measurements ----------------- //
+  // The single threaded cost of each stage.
+  double extraction_time_per_image = 0.0;
+  double matching_time_per_pair = 0.0;
+  double verification_time_per_pair = 0.0;
+  // The verification time with two view bundle adjustment disabled, or a
+  // negative value if it was not measured.
+  double verification_time_per_pair_without_bundle_adjustment = -1.0;
+
+  int64_t feature_memory_per_image_in_bytes = 0;
+  int num_observations_per_view = 0;
+
+  // The time of a full bundle adjustment with n observations is modelled as
+  // scale * n^exponent, which is fitted to the two calibration runs.
+  double bundle_adjustment_cost_scale = 0.0;
+  double bundle_adjustment_cost_exponent = 1.0;
+
+  // ----------------- Predicted running time ----------------- //
+  double predicted_extraction_time = 0.0;
+  double predicted_matching_time = 0.0;
+  double predicted_bundle_adjustment_time = 0.0;
+  double predicted_total_time = 0.0;
+
+  // ----------------- Chosen values ----------------- //
+  int cache_capacity = 0;
+  bool bundle_adjust_two_view_geometry = true;
+  int num_retriangulation_iterations = 0;
+  bool subsample_tracks_for_bundle_adjustment = false;
+  double full_bundle_adjustment_growth_percent = 0.0;
+  int partial_bundle_adjustment_num_views = 0;
+
+  // Returns the summary as one "name: value" line per field.
+  std::string ToString() const;
+};
+
+// Tunes the reconstruction builder options for the given images by running
+// short calibration passes: features are extracted and matched for a small
+// sample of the images, and bundle adjustment is timed on synthetic
+// sub-reconstructions with the same density of observations. The costs are
+// extrapolated to all images assuming perfect scaling with the number of
+// threads, and ChooseReconstructionBuilderOptions picks the options. Returns
+// false and leaves the options unchanged if the calibration fails (e.g., if
+// fewer than 2 images could be processed).
+bool TuneReconstructionBuilderOptions(
+    const TuneReconstructionBuilderOptionsOptions& tuning_options,
+    const std::vector<std::string>& image_filepaths,
+    ReconstructionBuilderOptions* options,
+    TuneReconstructionBuilderOptionsSummary* summary);
+
+// Chooses the options from the calibration measurements in the summary (which
+// must be set) and fills in the predicted running time and the chosen values:
+//
+//   - The feature cache holds as many images as fit in its share of
+//     max_memory_usage_in_bytes (and never more than the number of images).
+//   - If the target wall time is set and feature extraction and matching take
+//     more than half of it, two view bundle adjustment is disabled during
+//     geometric verification (provided that this was measured to be faster).
+//   - The bundle adjustment schedule is then made cheaper step by step until
+//     the predicted time fits in the remaining time: for the global pipeline
+//     the retriangulation iterations are reduced, for the incremental and
+//     hybrid pipelines full bundle adjustment happens less often and partial
+//     bundle adjustment optimizes fewer views. Finally, the tracks are
+//     subsampled for bundle adjustment. The most accurate schedule that fits is
+//     kept, or the cheapest one if none fits.
+void ChooseReconstructionBuilderOptions(
+    const TuneReconstructionBuilderOptionsOptions& tuning_options,
+    ReconstructionBuilderOptions* options,
+    TuneReconstructionBuilderOptionsSummary* summary);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_TUNE_RECONSTRUCTION_BUILDER_OPTIONS_H_
@@ -0,0 +1,210 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/sfm/tune_reconstruction_builder_options.h"
+
+#include "gtest/gtest.h"
+
+#include "theia/sfm/reconstruction_builder.h"
+#include "theia/sfm/reconstruction_estimator_options.h"
+
+namespace theia {
+
+namespace {
+
+// Calibration measurements in which feature extraction and matching are free
+// and a full bundle adjustment of all views takes 0.01 seconds.
+TuneReconstructionBuilderOptionsSummary CalibrationSummary() {
+  TuneReconstructionBuilderOptionsSummary summary;
+  summary.num_images = 100;
+  summary.feature_memory_per_image_in_bytes = 100;
+  summary.num_observations_per_view = 100;
+  summary.bundle_adjustment_cost_scale = 1e-6;
+  summary.bundle_adjustment_cost_exponent = 1.0;
+  return summary;
+}
+
+}  // namespace
+
+TEST(TuneReconstructionBuilderOptions, NoTargetTimeOnlySetsCacheCapacity) {
+  ReconstructionBuilderOptions options;
+  options.max_memory_usage_in_bytes = 4000;
+  options.reconstruction_estimator_options.num_retriangulation_iterations = 3;
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+  ChooseReconstructionBuilderOptions(TuneReconstructionBuilderOptionsOptions(),
+                                     &options, &summary);
+
+  // A quarter of the budget holds 10 images.
+  EXPECT_EQ(options.matching_options.cache_capacity, 10);
+  EXPECT_EQ(summary.cache_capacity, 10);
+  EXPECT_EQ(
+      options.reconstruction_estimator_options.num_retriangulation_iterations,
+      3);
+  EXPECT_EQ(summary.num_retriangulation_iterations, 3);
+  // Five full bundle adjustments of 0.01 seconds each.
+  EXPECT_NEAR(summary.predicted_bundle_adjustment_time, 0.05, 1e-12);
+  EXPECT_NEAR(summary.predicted_total_time, 0.05, 1e-12);
+}
+
+TEST(TuneReconstructionBuilderOptions, CacheCapacityIsAtMostNumImages) {
+  ReconstructionBuilderOptions options;
+  options.matching_options.cache_capacity = 1000;
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+  ChooseReconstructionBuilderOptions(TuneReconstructionBuilderOptionsOptions(),
+                                     &options, &summary);
+  EXPECT_EQ(options.matching_options.cache_capacity, summary.num_images);
+}
+
+TEST(TuneReconstructionBuilderOptions, OutOfCoreCacheHoldsThreeImages) {
+  ReconstructionBuilderOptions options;
+  options.matching_options.match_out_of_core = true;
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+  summary.num_images = 2;
+  ChooseReconstructionBuilderOptions(TuneReconstructionBuilderOptionsOptions(),
+                                     &options, &summary);
+  EXPECT_EQ(options.matching_options.cache_capacity, 3);
+
+  // Without out of core matching two images are enough.
+  options.matching_options.match_out_of_core = false;
+  ChooseReconstructionBuilderOptions(TuneReconstructionBuilderOptionsOptions(),
+                                     &options, &summary);
+  EXPECT_EQ(options.matching_options.cache_capacity, 2);
+}
+
+TEST(TuneReconstructionBuilderOptions, OutOfCoreCacheWithTinyMemoryBudget) {
+  ReconstructionBuilderOptions options;
+  options.matching_options.match_out_of_core = true;
+  // A quarter of the budget does not hold a single image.
+  options.max_memory_usage_in_bytes = 100;
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+  ChooseReconstructionBuilderOptions(TuneReconstructionBuilderOptionsOptions(),
+                                     &options, &summary);
+  EXPECT_EQ(options.matching_options.cache_capacity, 3);
+  EXPECT_EQ(summary.cache_capacity, 3);
+}
+
+TEST(TuneReconstructionBuilderOptions, GlobalReducesRetriangulation) {
+  ReconstructionBuilderOptions options;
+  options.reconstruction_estimator_options.reconstruction_estimator_type =
+      ReconstructionEstimatorType::GLOBAL;
+  options.reconstruction_estimator_options.num_retriangulation_iterations = 3;
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+
+  // Only two full bundle adjustments fit in the target time.
+  TuneReconstructionBuilderOptionsOptions tuning_options;
+  tuning_options.target_wall_time_in_seconds = 0.025;
+  ChooseReconstructionBuilderOptions(tuning_options, &options, &summary);
+  EXPECT_EQ(
+      options.reconstruction_estimator_options.num_retriangulation_iterations,
+      0);
+  EXPECT_FALSE(options.reconstruction_estimator_options
+                   .subsample_tracks_for_bundle_adjustment);
+  EXPECT_LE(summary.predicted_total_time,
+            tuning_options.target_wall_time_in_seconds);
+}
+
+TEST(TuneReconstructionBuilderOptions, IncrementalBundleAdjustsLessOften) {
+  ReconstructionBuilderOptions options;
+  ReconstructionEstimatorOptions& estimator_options =
+      options.reconstruction_estimator_options;
+  estimator_options.reconstruction_estimator_type =
+      ReconstructionEstimatorType::INCREMENTAL;
+  estimator_options.full_bundle_adjustment_growth_percent = 5.0;
+  estimator_options.partial_bundle_adjustment_num_views = 20;
+
+  // Without a target time the schedule is kept.
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+  TuneReconstructionBuilderOptionsOptions tuning_options;
+  ChooseReconstructionBuilderOptions(tuning_options, &options, &summary);
+  const double initial_time = summary.predicted_total_time;
+  EXPECT_EQ(estimator_options.full_bundle_adjustment_growth_percent, 5.0);
+
+  tuning_options.target_wall_time_in_seconds = initial_time / 2.0;
+  ChooseReconstructionBuilderOptions(tuning_options, &options, &summary);
+  EXPECT_LE(summary.predicted_total_time,
+            tuning_options.target_wall_time_in_seconds);
+  EXPECT_GE(estimator_options.full_bundle_adjustment_growth_percent, 5.0);
+  EXPECT_LE(estimator_options.partial_bundle_adjustment_num_views, 20);
+  EXPECT_FALSE(estimator_options.subsample_tracks_for_bundle_adjustment);
+  EXPECT_EQ(summary.full_bundle_adjustment_growth_percent,
+            estimator_options.full_bundle_adjustment_growth_percent);
+}
+
+TEST(TuneReconstructionBuilderOptions, CheapestScheduleIfNothingFits) {
+  ReconstructionBuilderOptions options;
+  options.reconstruction_estimator_options.reconstruction_estimator_type =
+      ReconstructionEstimatorType::GLOBAL;
+  // Subsampling the tracks keeps 200 of the 1000 observations per view.
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+  summary.num_observations_per_view = 1000;
+  TuneReconstructionBuilderOptionsOptions tuning_options;
+  tuning_options.target_wall_time_in_seconds = 1e-6;
+  ChooseReconstructionBuilderOptions(tuning_options, &options, &summary);
+  EXPECT_EQ(
+      options.reconstruction_estimator_options.num_retriangulation_iterations,
+      0);
+  EXPECT_TRUE(options.reconstruction_estimator_options
+                  .subsample_tracks_for_bundle_adjustment);
+}
+
+TEST(TuneReconstructionBuilderOptions, DisablesTwoViewBundleAdjustment) {
+  ReconstructionBuilderOptions options;
+  options.num_threads = 2;
+  TuneReconstructionBuilderOptionsSummary summary = CalibrationSummary();
+  summary.matching_time_per_pair = 0.001;
+  summary.verification_time_per_pair = 0.003;
+  summary.verification_time_per_pair_without_bundle_adjustment = 0.001;
+
+  // Matching the 4950 pairs takes 9.9 seconds with two threads, or 4.95
+  // seconds without two view bundle adjustment.
+  TuneReconstructionBuilderOptionsOptions tuning_options;
+  tuning_options.target_wall_time_in_seconds = 10.0;
+  ChooseReconstructionBuilderOptions(tuning_options, &options, &summary);
+  EXPECT_FALSE(options.matching_options.geometric_verification_options
+                   .bundle_adjustment);
+  EXPECT_FALSE(summary.bundle_adjust_two_view_geometry);
+  EXPECT_NEAR(summary.predicted_matching_time, 4.95, 1e-9);
+
+  // Verification is kept as is when there is enough time.
+  options = ReconstructionBuilderOptions();
+  options.num_threads = 2;
+  tuning_options.target_wall_time_in_seconds = 100.0;
+  ChooseReconstructionBuilderOptions(tuning_options, &options, &summary);
+  EXPECT_TRUE(options.matching_options.geometric_verification_options
+                  .bundle_adjustment);
+  EXPECT_NEAR(summary.predicted_matching_time, 9.9, 1e-9);
+}
+
+}  // namespace theia
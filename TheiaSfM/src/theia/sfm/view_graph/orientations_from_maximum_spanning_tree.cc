@@ -36,25 +36,153 @@
 
 #include <Eigen/Core>
 #include <ceres/rotation.h>
+#include <glog/logging.h>
 
 #include <algorithm>
+#include <memory>
+#include <queue>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
-#include "theia/math/graph/minimum_spanning_tree.h"
 #include "theia/sfm/twoview_info.h"
 #include "theia/sfm/types.h"
 #include "theia/sfm/view_graph/view_graph.h"
 #include "theia/util/map_util.h"
+#include "theia/util/threadpool.h"
 
 namespace theia {
 namespace {
-typedef std::pair<TwoViewInfo, ViewIdPair> HeapElement;
 
-bool SortHeapElement(const HeapElement& h1, const HeapElement& h2) {
-  return h1.first.num_verified_matches > h2.first.num_verified_matches;
+// An edge of the view graph between the dense node indices of its views.
+struct IndexedEdge {
+  int node1;
+  int node2;
+  int weight;
+  const TwoViewInfo* info;
+};
+
+// Returns true if edge1 is a better edge than edge2 for the maximum spanning
+// tree. Ties are broken by the edge index so that all edge weights are
+// distinct, which guarantees that Boruvka's algorithm does not create cycles.
+inline bool IsBetterEdge(const std::vector<IndexedEdge>& edges,
+                         const int edge1,
+                         const int edge2) {
+  if (edge2 < 0) {
+    return true;
+  }
+  if (edges[edge1].weight != edges[edge2].weight) {
+    return edges[edge1].weight > edges[edge2].weight;
+  }
+  return edge1 < edge2;
+}
+
+// Returns the root of the node in the disjoint set with path halving.
+inline int FindRoot(std::vector<int>* parents, int node) {
+  while ((*parents)[node] != node) {
+    (*parents)[node] = (*parents)[(*parents)[node]];
+    node = (*parents)[node];
+  }
+  return node;
+}
+
+// For each component, finds the best edge in [start, end) that connects it to
+// another component. The components of the nodes are given by their roots.
+void FindBestEdgesOfComponents(const std::vector<IndexedEdge>& edges,
+                               const std::vector<int>& roots,
+                               const int start,
+                               const int end,
+                               std::vector<int>* best_edges) {
+  for (int i = start; i < end; i++) {
+    const int root1 = roots[edges[i].node1];
+    const int root2 = roots[edges[i].node2];
+    if (root1 == root2) {
+      continue;
+    }
+    if (IsBetterEdge(edges, i, (*best_edges)[root1])) {
+      (*best_edges)[root1] = i;
+    }
+    if (IsBetterEdge(edges, i, (*best_edges)[root2])) {
+      (*best_edges)[root2] = i;
+    }
+  }
+}
+
+// Computes the maximum spanning tree of the graph with Boruvka's algorithm. In
+// each round, every component selects its best outgoing edge in parallel and
+// the components are merged along the selected edges. There are at most
+// log(num_nodes) rounds. Returns the indices of the tree edges.
+std::vector<int> ComputeMaximumSpanningTree(
+    const int num_nodes,
+    const std::vector<IndexedEdge>& edges,
+    const int num_threads) {
+  std::vector<int> parents(num_nodes);
+  for (int i = 0; i < num_nodes; i++) {
+    parents[i] = i;
+  }
+
+  const int num_edge_blocks =
+      std::max(1, std::min(num_threads, static_cast<int>(edges.size())));
+  std::unique_ptr<ThreadPool> pool;
+  if (num_edge_blocks > 1) {
+    pool.reset(new ThreadPool(num_edge_blocks));
+  }
+
+  std::vector<int> roots(num_nodes);
+  std::vector<std::vector<int> > best_edges_of_blocks(num_edge_blocks);
+  std::vector<int> tree_edges;
+  tree_edges.reserve(num_nodes - 1);
+  while (tree_edges.size() < num_nodes - 1) {
+    for (int i = 0; i < num_nodes; i++) {
+      roots[i] = FindRoot(&parents, i);
+    }
+
+    // Find the best edge of each component within each block of edges.
+    ParallelFor(pool.get(),
+                num_edge_blocks,
+                edges.size(),
+                [&](const int block, const int start, const int end) {
+                  best_edges_of_blocks[block].assign(num_nodes, -1);
+                  FindBestEdgesOfComponents(edges,
+                                            roots,
+                                            start,
+                                            end,
+                                            &best_edges_of_blocks[block]);
+                });
+
+    // Merge the best edges of all blocks and join the components.
+    std::vector<int>& best_edges = best_edges_of_blocks[0];
+    for (int i = 1; i < num_edge_blocks; i++) {
+      for (int j = 0; j < num_nodes; j++) {
+        const int edge = best_edges_of_blocks[i][j];
+        if (edge >= 0 && IsBetterEdge(edges, edge, best_edges[j])) {
+          best_edges[j] = edge;
+        }
+      }
+    }
+
+    const int num_tree_edges = tree_edges.size();
+    for (int i = 0; i < num_nodes; i++) {
+      const int edge = best_edges[i];
+      if (edge < 0) {
+        continue;
+      }
+      const int root1 = FindRoot(&parents, edges[edge].node1);
+      const int root2 = FindRoot(&parents, edges[edge].node2);
+      if (root1 == root2) {
+        continue;
+      }
+      parents[root1] = root2;
+      tree_edges.emplace_back(edge);
+    }
+
+    // The graph is disconnected if no components could be merged.
+    if (tree_edges.size() == num_tree_edges) {
+      break;
+    }
+  }
+  return tree_edges;
 }
 
 // Computes the orientation of the neighbor camera based on the orientation of
@@ -83,98 +211,117 @@ Eigen::Vector3d ComputeOrientation(const Eigen::Vector3d& source_orientation,
   return orientation;
 }
 
-// Adds all the edges of view_id to the heap. Only edges that do not already
-// have an orientation estimation are added.
-void AddEdgesToHeap(
-    const ViewGraph& view_graph,
-    const std::unordered_map<ViewId, Eigen::Vector3d>& orientations,
-    const ViewId view_id,
-    std::vector<HeapElement>* heap) {
-  const std::unordered_set<ViewId>* edge_ids =
-      view_graph.GetNeighborIdsForView(view_id);
-  for (const ViewId edge_id : *edge_ids) {
-    // Only add edges to the heap that contain a vertex that has not been seen.
-    if (ContainsKey(orientations, edge_id)) {
-      continue;
-    }
+}  // namespace
 
-    heap->emplace_back(*view_graph.GetEdge(view_id, edge_id),
-                       ViewIdPair(view_id, edge_id));
-    std::push_heap(heap->begin(), heap->end(), SortHeapElement);
-  }
+bool OrientationsFromMaximumSpanningTree(
+    const ViewGraph& view_graph,
+    std::unordered_map<ViewId, Eigen::Vector3d>* orientations) {
+  return OrientationsFromMaximumSpanningTree(view_graph, 1, orientations);
 }
 
-}  // namespace
-
 bool OrientationsFromMaximumSpanningTree(
     const ViewGraph& view_graph,
+    const int num_threads,
     std::unordered_map<ViewId, Eigen::Vector3d>* orientations) {
   CHECK_NOTNULL(orientations);
+  CHECK_GT(num_threads, 0);
 
   // Compute the largest connected component of the input view graph since the
-  // MST is only valid on a single connected component.
-  std::unordered_set<theia::ViewId> largest_cc;
+  // MST is only valid on a single connected component. The views are given
+  // dense indices in sorted order so that the result does not depend on the
+  // hash order.
+  std::unordered_set<ViewId> largest_cc;
   view_graph.GetLargestConnectedComponentIds(&largest_cc);
-  ViewGraph largest_cc_subgraph;
-  view_graph.ExtractSubgraph(largest_cc, &largest_cc_subgraph);
-
-  // Compute maximum spanning tree.
-  const auto& all_edges = largest_cc_subgraph.GetAllEdges();
-  MinimumSpanningTree<ViewId, int> mst_extractor;
-  for (const auto& edge : all_edges) {
-    // Since we want the *maximum* spanning tree, we negate all of the edge
-    // weights in the *minimum* spanning tree extractor.
-    mst_extractor.AddEdge(
-        edge.first.first, edge.first.second, -edge.second.num_verified_matches);
+  std::vector<ViewId> view_ids(largest_cc.begin(), largest_cc.end());
+  std::sort(view_ids.begin(), view_ids.end());
+  std::unordered_map<ViewId, int> view_id_to_index;
+  view_id_to_index.reserve(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    view_id_to_index[view_ids[i]] = i;
   }
 
-  std::unordered_set<ViewIdPair> mst;
-  if (!mst_extractor.Extract(&mst)) {
+  std::vector<IndexedEdge> edges;
+  edges.reserve(view_graph.NumEdges());
+  for (const auto& edge : view_graph.GetAllEdges()) {
+    const int* index1 = FindOrNull(view_id_to_index, edge.first.first);
+    const int* index2 = FindOrNull(view_id_to_index, edge.first.second);
+    if (index1 == nullptr || index2 == nullptr) {
+      continue;
+    }
+    edges.push_back(IndexedEdge{
+        *index1, *index2, edge.second.num_verified_matches, &edge.second});
+  }
+  // Sort the edges so that ties between edge weights are broken the same way
+  // regardless of the hash order of the view graph.
+  std::sort(edges.begin(),
+            edges.end(),
+            [](const IndexedEdge& edge1, const IndexedEdge& edge2) {
+              return std::make_pair(edge1.node1, edge1.node2) <
+                     std::make_pair(edge2.node1, edge2.node2);
+            });
+  if (edges.empty()) {
     VLOG(2)
         << "Could not extract the maximum spanning tree from the view graph";
     return false;
   }
 
-  // Create an MST view graph.
-  ViewGraph mst_view_graph;
-  for (const ViewIdPair& edge : mst) {
-    mst_view_graph.AddEdge(
-        edge.first,
-        edge.second,
-        *largest_cc_subgraph.GetEdge(edge.first, edge.second));
+  // Compute maximum spanning tree.
+  const int num_views = view_ids.size();
+  const std::vector<int> tree_edges =
+      ComputeMaximumSpanningTree(num_views, edges, num_threads);
+  if (tree_edges.size() != num_views - 1) {
+    VLOG(2)
+        << "Could not extract the maximum spanning tree from the view graph";
+    return false;
   }
 
-  // Chain the relative rotations together to compute orientations.  We use a
-  // heap to determine the next edges to add to the minimum spanning tree.
-  std::vector<HeapElement> heap;
-
-  // Set the root value.
-  const ViewId root_view_id = mst.begin()->first;
-  (*orientations)[root_view_id] = Eigen::Vector3d::Zero();
-  AddEdgesToHeap(mst_view_graph, *orientations, root_view_id, &heap);
-
-  while (!heap.empty()) {
-    const HeapElement next_edge = heap.front();
-    // Remove the best edge.
-    std::pop_heap(heap.begin(), heap.end(), SortHeapElement);
-    heap.pop_back();
+  // Build the adjacency of the tree in compressed form.
+  std::vector<int> adjacency_offsets(num_views + 1, 0);
+  for (const int edge : tree_edges) {
+    ++adjacency_offsets[edges[edge].node1 + 1];
+    ++adjacency_offsets[edges[edge].node2 + 1];
+  }
+  for (int i = 0; i < num_views; i++) {
+    adjacency_offsets[i + 1] += adjacency_offsets[i];
+  }
+  std::vector<int> adjacent_edges(2 * tree_edges.size());
+  std::vector<int> insert_positions(adjacency_offsets.begin(),
+                                    adjacency_offsets.end() - 1);
+  for (const int edge : tree_edges) {
+    adjacent_edges[insert_positions[edges[edge].node1]++] = edge;
+    adjacent_edges[insert_positions[edges[edge].node2]++] = edge;
+  }
 
-    // If the edge contains two vertices that have already been added then do
-    // nothing.
-    if (ContainsKey(*orientations, next_edge.second.second)) {
-      continue;
+  // Chain the relative rotations together along the tree, starting at the view
+  // with the smallest view id.
+  std::vector<Eigen::Vector3d> tree_orientations(num_views);
+  std::vector<bool> is_visited(num_views, false);
+  std::queue<int> nodes_to_visit;
+  tree_orientations[0].setZero();
+  is_visited[0] = true;
+  nodes_to_visit.push(0);
+  while (!nodes_to_visit.empty()) {
+    const int node = nodes_to_visit.front();
+    nodes_to_visit.pop();
+    for (int i = adjacency_offsets[node]; i < adjacency_offsets[node + 1];
+         i++) {
+      const IndexedEdge& edge = edges[adjacent_edges[i]];
+      const int neighbor = edge.node1 == node ? edge.node2 : edge.node1;
+      if (is_visited[neighbor]) {
+        continue;
+      }
+      tree_orientations[neighbor] = ComputeOrientation(tree_orientations[node],
+                                                       *edge.info,
+                                                       view_ids[node],
+                                                       view_ids[neighbor]);
+      is_visited[neighbor] = true;
+      nodes_to_visit.push(neighbor);
     }
+  }
 
-    // Compute the orientation for the vertex.
-    (*orientations)[next_edge.second.second] =
-        ComputeOrientation(FindOrDie(*orientations, next_edge.second.first),
-                           next_edge.first,
-                           next_edge.second.first,
-                           next_edge.second.second);
-
-    // Add all edges to the heap.
-    AddEdgesToHeap(
-        mst_view_graph, *orientations, next_edge.second.second, &heap);
+  orientations->reserve(orientations->size() + num_views);
+  for (int i = 0; i < num_views; i++) {
+    (*orientations)[view_ids[i]] = tree_orientations[i];
   }
   return true;
 }
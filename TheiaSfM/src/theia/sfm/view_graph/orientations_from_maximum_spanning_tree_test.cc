@@ -153,6 +153,31 @@ void TestOrientationsFromViewGraph(const int num_views,
   VerifyOrientations(view_graph, orientations, estimated_orientations);
 }
 
+void TestMultithreadedOrientationsFromViewGraph(const int num_views,
+                                                const int num_edges,
+                                                const int num_threads) {
+  std::unordered_map<ViewId, Vector3d> orientations;
+  CreateViewsWithRandomOrientations(num_views, &orientations);
+  ViewGraph view_graph;
+  CreateViewGraph(num_edges, orientations, &view_graph);
+
+  std::unordered_map<ViewId, Vector3d> estimated_orientations;
+  EXPECT_TRUE(OrientationsFromMaximumSpanningTree(
+      view_graph, num_threads, &estimated_orientations));
+  VerifyOrientations(view_graph, orientations, estimated_orientations);
+
+  // The spanning tree does not depend on the number of threads.
+  std::unordered_map<ViewId, Vector3d> single_threaded_orientations;
+  EXPECT_TRUE(OrientationsFromMaximumSpanningTree(
+      view_graph, &single_threaded_orientations));
+  EXPECT_EQ(estimated_orientations.size(),
+            single_threaded_orientations.size());
+  for (const auto& orientation : single_threaded_orientations) {
+    EXPECT_EQ(orientation.second,
+              FindOrDie(estimated_orientations, orientation.first));
+  }
+}
+
 TEST(OrientationsFromViewGraph, SmallTest) {
   const int kNumViews = 4;
   const int kNumEdges = 6;
@@ -165,4 +190,30 @@ TEST(OrientationsFromViewGraph, LargeTest) {
   TestOrientationsFromViewGraph(kNumViews, kNumEdges);
 }
 
+TEST(OrientationsFromViewGraph, Multithreaded) {
+  const int kNumViews = 200;
+  const int kNumEdges = 1000;
+  const int kNumThreads = 4;
+  TestMultithreadedOrientationsFromViewGraph(kNumViews, kNumEdges, kNumThreads);
+}
+
+TEST(OrientationsFromViewGraph, DisconnectedViewGraph) {
+  std::unordered_map<ViewId, Vector3d> orientations;
+  CreateViewsWithRandomOrientations(6, &orientations);
+  ViewGraph view_graph;
+  view_graph.AddEdge(0, 1, CreateTwoViewInfo(orientations, 0, 1));
+  view_graph.AddEdge(1, 2, CreateTwoViewInfo(orientations, 1, 2));
+  view_graph.AddEdge(0, 2, CreateTwoViewInfo(orientations, 0, 2));
+  view_graph.AddEdge(4, 5, CreateTwoViewInfo(orientations, 4, 5));
+
+  // Only the largest connected component is estimated.
+  std::unordered_map<ViewId, Vector3d> estimated_orientations;
+  EXPECT_TRUE(OrientationsFromMaximumSpanningTree(
+      view_graph, 2, &estimated_orientations));
+  EXPECT_EQ(estimated_orientations.size(), 3);
+  EXPECT_TRUE(ContainsKey(estimated_orientations, 0));
+  EXPECT_TRUE(ContainsKey(estimated_orientations, 1));
+  EXPECT_TRUE(ContainsKey(estimated_orientations, 2));
+}
+
 }  // namespace theia
@@ -0,0 +1,203 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/sfm/view_graph/partition_view_graph.h"
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "theia/math/graph/connected_components.h"
+#include "theia/math/graph/normalized_graph_cut.h"
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view_graph/view_graph.h"
+#include "theia/util/hash.h"
+#include "theia/util/map_util.h"
+
+namespace theia {
+
+namespace {
+
+// Returns the edges between the views, weighted by their number of verified
+// matches.
+std::unordered_map<ViewIdPair, double> GetEdgeWeights(
+    const ViewGraph& view_graph, const std::unordered_set<ViewId>& view_ids) {
+  std::unordered_map<ViewIdPair, double> edge_weights;
+  for (const ViewId view_id : view_ids) {
+    const std::unordered_set<ViewId>* neighbor_ids =
+        view_graph.GetNeighborIdsForView(view_id);
+    if (neighbor_ids == nullptr) {
+      continue;
+    }
+    for (const ViewId neighbor_id : *neighbor_ids) {
+      if (neighbor_id < view_id || !ContainsKey(view_ids, neighbor_id)) {
+        continue;
+      }
+      const TwoViewInfo* info = view_graph.GetEdge(view_id, neighbor_id);
+      edge_weights[ViewIdPair(view_id, neighbor_id)] =
+          std::max(info->num_verified_matches, 1);
+    }
+  }
+  return edge_weights;
+}
+
+// Splits the views into clusters of at most max_num_views_per_partition views.
+void SplitViews(const ViewGraph& view_graph,
+                const int max_num_views_per_partition,
+                std::vector<std::unordered_set<ViewId> >* clusters) {
+  NormalizedGraphCut<ViewId>::Options ncut_options;
+  NormalizedGraphCut<ViewId> ncut(ncut_options);
+
+  std::vector<std::unordered_set<ViewId> > views_to_split(
+      1, view_graph.ViewIds());
+  while (!views_to_split.empty()) {
+    std::unordered_set<ViewId> view_ids;
+    view_ids.swap(views_to_split.back());
+    views_to_split.pop_back();
+    if (view_ids.size() <= max_num_views_per_partition) {
+      clusters->emplace_back(std::move(view_ids));
+      continue;
+    }
+
+    // The normalized cut of a disconnected graph is its connected components,
+    // which are much cheaper to compute. Views without any edges in the
+    // cluster form their own component.
+    const std::unordered_map<ViewIdPair, double> edge_weights =
+        GetEdgeWeights(view_graph, view_ids);
+    ConnectedComponents<ViewId> connected_components;
+    std::unordered_set<ViewId> connected_view_ids;
+    for (const auto& edge : edge_weights) {
+      connected_components.AddEdge(edge.first.first, edge.first.second);
+      connected_view_ids.emplace(edge.first.first);
+      connected_view_ids.emplace(edge.first.second);
+    }
+    std::unordered_map<ViewId, std::unordered_set<ViewId> > components;
+    connected_components.Extract(&components);
+    if (components.size() > 1 || connected_view_ids.size() < view_ids.size()) {
+      for (const ViewId view_id : view_ids) {
+        if (!ContainsKey(connected_view_ids, view_id)) {
+          clusters->emplace_back(std::unordered_set<ViewId>{view_id});
+        }
+      }
+      for (auto& component : components) {
+        views_to_split.emplace_back(std::move(component.second));
+      }
+      continue;
+    }
+
+    std::unordered_set<ViewId> subgraph1, subgraph2;
+    if (!ncut.ComputeCut(edge_weights, &subgraph1, &subgraph2, nullptr) ||
+        subgraph1.empty() || subgraph2.empty()) {
+      LOG(WARNING) << "Could not split a cluster of " << view_ids.size()
+                   << " views. It is kept as a single partition.";
+      clusters->emplace_back(std::move(view_ids));
+      continue;
+    }
+    views_to_split.emplace_back(std::move(subgraph1));
+    views_to_split.emplace_back(std::move(subgraph2));
+  }
+}
+
+}  // namespace
+
+void PartitionViewGraph(const ViewGraph& view_graph,
+                        const int max_num_views_per_partition,
+                        const int num_overlapping_views,
+                        std::vector<std::unordered_set<ViewId> >* partitions) {
+  CHECK_NOTNULL(partitions)->clear();
+  // The eigen solver of the normalized graph cut requires graphs of more than
+  // 10 nodes.
+  CHECK_GE(max_num_views_per_partition, kMinNumViewsPerPartition);
+  CHECK_GE(num_overlapping_views, 0);
+
+  SplitViews(view_graph, max_num_views_per_partition, partitions);
+  std::sort(partitions->begin(), partitions->end(),
+            [](const std::unordered_set<ViewId>& lhs,
+               const std::unordered_set<ViewId>& rhs) {
+              return lhs.size() > rhs.size();
+            });
+  if (num_overlapping_views == 0) {
+    return;
+  }
+
+  std::unordered_map<ViewId, int> partition_of_view;
+  for (int i = 0; i < partitions->size(); i++) {
+    for (const ViewId view_id : (*partitions)[i]) {
+      partition_of_view[view_id] = i;
+    }
+  }
+
+  // For each partition, accumulate the verified matches of the views of the
+  // other partitions to it, grouped by the partition of the view.
+  std::vector<std::unordered_map<int, std::unordered_map<ViewId, int> > >
+      num_matches_to_partition(partitions->size());
+  for (const auto& edge : view_graph.GetAllEdges()) {
+    const int partition1 = FindOrDie(partition_of_view, edge.first.first);
+    const int partition2 = FindOrDie(partition_of_view, edge.first.second);
+    if (partition1 == partition2) {
+      continue;
+    }
+    num_matches_to_partition[partition1][partition2][edge.first.second] +=
+        edge.second.num_verified_matches;
+    num_matches_to_partition[partition2][partition1][edge.first.first] +=
+        edge.second.num_verified_matches;
+  }
+
+  // Extend each partition with the best connected views of its neighbors.
+  std::vector<std::pair<int, ViewId> > candidates;
+  for (int i = 0; i < partitions->size(); i++) {
+    for (const auto& neighbor : num_matches_to_partition[i]) {
+      candidates.clear();
+      for (const auto& view : neighbor.second) {
+        candidates.emplace_back(view.second, view.first);
+      }
+      const int num_views =
+          std::min<int>(num_overlapping_views, candidates.size());
+      std::partial_sort(candidates.begin(), candidates.begin() + num_views,
+                        candidates.end(),
+                        std::greater<std::pair<int, ViewId> >());
+      for (int j = 0; j < num_views; j++) {
+        (*partitions)[i].emplace(candidates[j].second);
+      }
+    }
+  }
+}
+
+}  // namespace theia
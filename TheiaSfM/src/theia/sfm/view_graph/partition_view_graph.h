@@ -0,0 +1,69 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#ifndef THEIA_SFM_VIEW_GRAPH_PARTITION_VIEW_GRAPH_H_
+#define THEIA_SFM_VIEW_GRAPH_PARTITION_VIEW_GRAPH_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "theia/sfm/types.h"
+
+namespace theia {
+
+class ViewGraph;
+
+// The smallest allowed value of max_num_views_per_partition.
+static const int kMinNumViewsPerPartition = 10;
+
+// Partitions the views of the view graph into clusters of at most
+// max_num_views_per_partition views so that large view graphs may be
+// reconstructed by parts. Disconnected parts of the view graph are separated
+// first, and the remaining clusters that are too large are recursively split
+// with a normalized graph cut where each edge is weighted by its number of
+// verified matches. Each cluster is then extended with up to
+// num_overlapping_views views of each neighboring cluster (the views with the
+// most verified matches to the cluster) so that the reconstructions of
+// neighboring clusters share views and may be aligned to each other. The
+// partitions are returned from the largest to the smallest.
+// max_num_views_per_partition must be at least kMinNumViewsPerPartition.
+void PartitionViewGraph(const ViewGraph& view_graph,
+                        const int max_num_views_per_partition,
+                        const int num_overlapping_views,
+                        std::vector<std::unordered_set<ViewId> >* partitions);
+
+}  // namespace theia
+
+#endif  // THEIA_SFM_VIEW_GRAPH_PARTITION_VIEW_GRAPH_H_
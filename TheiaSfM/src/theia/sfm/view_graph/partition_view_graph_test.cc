@@ -0,0 +1,176 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "theia/sfm/twoview_info.h"
+#include "theia/sfm/types.h"
+#include "theia/sfm/view_graph/partition_view_graph.h"
+#include "theia/sfm/view_graph/view_graph.h"
+#include "theia/util/map_util.h"
+
+namespace theia {
+
+namespace {
+
+// Creates a view graph of num_clusters fully connected clusters of
+// num_views_per_cluster views each. Consecutive clusters are connected by three
+// weak edges, the strongest of which connects the last view of a cluster to the
+// first view of the next one.
+void CreateClusteredViewGraph(const int num_clusters,
+                              const int num_views_per_cluster,
+                              ViewGraph* view_graph) {
+  TwoViewInfo strong_info, weak_info;
+  strong_info.num_verified_matches = 100;
+  for (int c = 0; c < num_clusters; c++) {
+    const ViewId first_view_id = c * num_views_per_cluster;
+    for (int i = 0; i < num_views_per_cluster; i++) {
+      for (int j = i + 1; j < num_views_per_cluster; j++) {
+        view_graph->AddEdge(first_view_id + i, first_view_id + j, strong_info);
+      }
+    }
+    if (c > 0) {
+      for (int i = 0; i < 3; i++) {
+        weak_info.num_verified_matches = 3 - i;
+        view_graph->AddEdge(first_view_id - 1 - i, first_view_id + i,
+                            weak_info);
+      }
+    }
+  }
+}
+
+int PartitionOfView(const std::vector<std::unordered_set<ViewId> >& partitions,
+                    const ViewId view_id) {
+  for (int i = 0; i < partitions.size(); i++) {
+    if (ContainsKey(partitions[i], view_id)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+TEST(PartitionViewGraph, SmallViewGraphIsNotPartitioned) {
+  ViewGraph view_graph;
+  CreateClusteredViewGraph(2, 5, &view_graph);
+
+  std::vector<std::unordered_set<ViewId> > partitions;
+  PartitionViewGraph(view_graph, 10, 2, &partitions);
+  ASSERT_EQ(partitions.size(), 1);
+  EXPECT_EQ(partitions[0].size(), 10);
+}
+
+TEST(PartitionViewGraph, PartitionsFollowClusters) {
+  static const int kNumClusters = 3;
+  static const int kNumViewsPerCluster = 8;
+  ViewGraph view_graph;
+  CreateClusteredViewGraph(kNumClusters, kNumViewsPerCluster, &view_graph);
+
+  std::vector<std::unordered_set<ViewId> > partitions;
+  PartitionViewGraph(view_graph, 10, 0, &partitions);
+  ASSERT_EQ(partitions.size(), kNumClusters);
+
+  // Each cluster is a partition.
+  int num_views = 0;
+  for (int c = 0; c < kNumClusters; c++) {
+    const ViewId first_view_id = c * kNumViewsPerCluster;
+    const int partition = PartitionOfView(partitions, first_view_id);
+    ASSERT_GE(partition, 0);
+    EXPECT_EQ(partitions[partition].size(), kNumViewsPerCluster);
+    for (int i = 0; i < kNumViewsPerCluster; i++) {
+      EXPECT_TRUE(ContainsKey(partitions[partition], first_view_id + i));
+    }
+    num_views += partitions[partition].size();
+  }
+  EXPECT_EQ(num_views, view_graph.NumViews());
+}
+
+TEST(PartitionViewGraph, NeighboringPartitionsOverlap) {
+  static const int kNumClusters = 3;
+  static const int kNumViewsPerCluster = 8;
+  static const int kNumOverlappingViews = 2;
+  ViewGraph view_graph;
+  CreateClusteredViewGraph(kNumClusters, kNumViewsPerCluster, &view_graph);
+
+  std::vector<std::unordered_set<ViewId> > partitions;
+  PartitionViewGraph(view_graph, 10, kNumOverlappingViews, &partitions);
+  ASSERT_EQ(partitions.size(), kNumClusters);
+
+  // The middle cluster has two neighbors and the others one.
+  std::vector<int> partition_sizes;
+  for (const auto& partition : partitions) {
+    partition_sizes.emplace_back(partition.size());
+  }
+  std::sort(partition_sizes.begin(), partition_sizes.end());
+  EXPECT_EQ(partition_sizes[0], kNumViewsPerCluster + kNumOverlappingViews);
+  EXPECT_EQ(partition_sizes[1], kNumViewsPerCluster + kNumOverlappingViews);
+  EXPECT_EQ(partition_sizes[2],
+            kNumViewsPerCluster + 2 * kNumOverlappingViews);
+
+  // The last view of the first cluster and the first view of the second cluster
+  // are the best connected views between the clusters, so both partitions
+  // contain them.
+  int num_partitions_with_shared_views = 0;
+  for (const auto& partition : partitions) {
+    if (ContainsKey(partition, kNumViewsPerCluster - 1) &&
+        ContainsKey(partition, kNumViewsPerCluster)) {
+      ++num_partitions_with_shared_views;
+    }
+  }
+  EXPECT_EQ(num_partitions_with_shared_views, 2);
+}
+
+TEST(PartitionViewGraph, DisconnectedViewGraph) {
+  ViewGraph view_graph;
+  TwoViewInfo info;
+  info.num_verified_matches = 100;
+  for (int i = 0; i < 8; i++) {
+    view_graph.AddEdge(2 * i, 2 * i + 1, info);
+  }
+
+  std::vector<std::unordered_set<ViewId> > partitions;
+  PartitionViewGraph(view_graph, 10, 1, &partitions);
+  ASSERT_EQ(partitions.size(), 8);
+  for (const auto& partition : partitions) {
+    EXPECT_EQ(partition.size(), 2);
+  }
+}
+
+}  // namespace theia
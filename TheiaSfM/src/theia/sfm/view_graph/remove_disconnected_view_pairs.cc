@@ -35,10 +35,9 @@
 #include "theia/sfm/view_graph/remove_disconnected_view_pairs.h"
 
 #include <glog/logging.h>
-#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
-#include "theia/math/graph/connected_components.h"
 #include "theia/sfm/types.h"
 #include "theia/sfm/view_graph/view_graph.h"
 
@@ -46,42 +45,25 @@ namespace theia {
 
 // Removes all view pairs that are not part of the largest connected component.
 std::unordered_set<ViewId> RemoveDisconnectedViewPairs(ViewGraph* view_graph) {
+  return RemoveDisconnectedViewPairs(1, view_graph);
+}
+
+std::unordered_set<ViewId> RemoveDisconnectedViewPairs(const int num_threads,
+                                                       ViewGraph* view_graph) {
   CHECK_NOTNULL(view_graph);
   std::unordered_set<ViewId> removed_views;
 
-  // Extract all connected components.
-  ConnectedComponents<ViewId> cc_extractor;
-  const auto& view_pairs = view_graph->GetAllEdges();
-  for (const auto& view_pair : view_pairs) {
-    cc_extractor.AddEdge(view_pair.first.first, view_pair.first.second);
-  }
-  std::unordered_map<ViewId, std::unordered_set<ViewId> > connected_components;
-  cc_extractor.Extract(&connected_components);
-
-  // Find the largest connected component.
-  int max_cc_size = 0;
-  ViewId largest_cc_root_id = kInvalidViewId;
-  for (const auto& connected_component : connected_components) {
-    if (connected_component.second.size() > max_cc_size) {
-      max_cc_size = connected_component.second.size();
-      largest_cc_root_id = connected_component.first;
-    }
-  }
+  // Extract all connected components. The first one is the largest.
+  std::vector<std::unordered_set<ViewId> > connected_components;
+  view_graph->GetConnectedComponents(num_threads, &connected_components);
 
   // Remove all view pairs containing a view to remove (i.e. the ones that are
-  // not in the largest connectedcomponent).
+  // not in the largest connected component).
   const int num_view_pairs_before_filtering = view_graph->NumEdges();
-  for (const auto& connected_component : connected_components) {
-    if (connected_component.first == largest_cc_root_id) {
-      continue;
-    }
-
-    // NOTE: The connected component will contain the root id as well, so we do
-    // not explicity have to remove connected_component.first since it will
-    // exist in connected_components.second
-    for (const ViewId view_id2 : connected_component.second) {
-      view_graph->RemoveView(view_id2);
-      removed_views.insert(view_id2);
+  for (int i = 1; i < connected_components.size(); i++) {
+    for (const ViewId view_id : connected_components[i]) {
+      view_graph->RemoveView(view_id);
+      removed_views.insert(view_id);
     }
   }
 
@@ -35,18 +35,24 @@
 #include "theia/sfm/view_graph/view_graph.h"
 
 #include <cereal/archives/portable_binary.hpp>
+#include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>   // NOLINT
 #include <iostream>  // NOLINT
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
-#include "theia/math/graph/connected_components.h"
 #include "theia/sfm/twoview_info.h"
 #include "theia/sfm/types.h"
 #include "theia/util/hash.h"
 #include "theia/util/map_util.h"
+#include "theia/util/threadpool.h"
 
 namespace theia {
 
@@ -239,29 +245,109 @@ void ViewGraph::ExtractSubgraph(
 
 void ViewGraph::GetLargestConnectedComponentIds(
     std::unordered_set<ViewId>* largest_cc) const {
-  ConnectedComponents<ViewId> cc_extractor;
-  // Add all edges to the connected components extractor.
+  std::vector<std::unordered_set<ViewId> > connected_components;
+  GetConnectedComponents(1, &connected_components);
+  CHECK(!connected_components.empty());
+
+  // Swap the largest connected component to the output.
+  std::swap(*largest_cc, connected_components[0]);
+}
+
+void ViewGraph::GetConnectedComponents(
+    const int num_threads,
+    std::vector<std::unordered_set<ViewId> >* connected_components) const {
+  CHECK_GT(num_threads, 0);
+  CHECK_NOTNULL(connected_components)->clear();
+
+  // Give the views dense indices in sorted order so that the components do not
+  // depend on the hash order.
+  std::vector<ViewId> view_ids;
+  view_ids.reserve(vertices_.size());
+  for (const auto& vertex : vertices_) {
+    view_ids.emplace_back(vertex.first);
+  }
+  std::sort(view_ids.begin(), view_ids.end());
+  std::unordered_map<ViewId, int> view_id_to_index;
+  view_id_to_index.reserve(view_ids.size());
+  for (int i = 0; i < view_ids.size(); i++) {
+    view_id_to_index[view_ids[i]] = i;
+  }
+
+  std::vector<const ViewIdPair*> edges;
+  edges.reserve(edges_.size());
   for (const auto& edge : edges_) {
-    cc_extractor.AddEdge(edge.first.first, edge.first.second);
+    edges.emplace_back(&edge.first);
   }
 
-  // Extract all connected components.
-  std::unordered_map<ViewId, std::unordered_set<ViewId> > connected_components;
-  cc_extractor.Extract(&connected_components);
-
-  // Search for the largest CC in the viewing graph.
-  ViewId largest_cc_id = kInvalidViewId;
-  int largest_cc_size = 0;
-  for (const auto& connected_component : connected_components) {
-    if (connected_component.second.size() > largest_cc_size) {
-      largest_cc_size = connected_component.second.size();
-      largest_cc_id = connected_component.first;
+  // A concurrent union-find: the root with the larger index is always linked
+  // to the root with the smaller index with a compare-and-swap, and a failed
+  // link is retried with the new roots. Paths are halved during the search.
+  std::vector<std::atomic<int> > parents(view_ids.size());
+  for (int i = 0; i < parents.size(); i++) {
+    parents[i].store(i);
+  }
+  const auto find_root = [&parents](int node) {
+    while (true) {
+      int parent = parents[node].load();
+      if (parent == node) {
+        return node;
+      }
+      const int grandparent = parents[parent].load();
+      if (grandparent != parent) {
+        parents[node].compare_exchange_weak(parent, grandparent);
+      }
+      node = grandparent;
     }
+  };
+  const auto join_edges = [&](const int, const int start, const int end) {
+    for (int i = start; i < end; i++) {
+      int root1 = find_root(FindOrDie(view_id_to_index, edges[i]->first));
+      int root2 = find_root(FindOrDie(view_id_to_index, edges[i]->second));
+      while (root1 != root2) {
+        if (root1 < root2) {
+          std::swap(root1, root2);
+        }
+        int expected_parent = root1;
+        if (parents[root1].compare_exchange_strong(expected_parent, root2)) {
+          break;
+        }
+        root1 = find_root(root1);
+        root2 = find_root(root2);
+      }
+    }
+  };
+
+  const int num_blocks = std::max(
+      1, std::min(num_threads, static_cast<int>(edges.size())));
+  ParallelFor(num_threads, num_blocks, edges.size(), join_edges);
+  std::vector<bool> has_edge(view_ids.size(), false);
+  for (const ViewIdPair* edge : edges) {
+    has_edge[FindOrDie(view_id_to_index, edge->first)] = true;
+    has_edge[FindOrDie(view_id_to_index, edge->second)] = true;
   }
-  CHECK_NE(largest_cc_id, kInvalidViewId);
 
-  // Swap the largest connected component to the output.
-  std::swap(*largest_cc, connected_components[largest_cc_id]);
+  // Group the views by their root. Since roots always have the smallest index
+  // of their component, the components are created in order of their smallest
+  // view id.
+  std::vector<int> component_of_root(view_ids.size(), -1);
+  for (int i = 0; i < view_ids.size(); i++) {
+    if (!has_edge[i]) {
+      continue;
+    }
+    const int root = find_root(i);
+    if (component_of_root[root] < 0) {
+      component_of_root[root] = connected_components->size();
+      connected_components->emplace_back();
+    }
+    (*connected_components)[component_of_root[root]].emplace(view_ids[i]);
+  }
+
+  std::stable_sort(connected_components->begin(),
+                   connected_components->end(),
+                   [](const std::unordered_set<ViewId>& component1,
+                      const std::unordered_set<ViewId>& component2) {
+                     return component1.size() > component2.size();
+                   });
 }
 
 }  // namespace theia
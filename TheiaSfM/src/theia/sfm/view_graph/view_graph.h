@@ -43,6 +43,7 @@
 #include <cereal/types/utility.hpp>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "theia/sfm/twoview_info.h"
 #include "theia/sfm/types.h"
@@ -121,6 +122,15 @@ class ViewGraph {
   void GetLargestConnectedComponentIds(
       std::unordered_set<ViewId>* largest_cc) const;
 
+  // Computes all connected components of the view graph with a union-find over
+  // the edge list. The edges are split into num_threads blocks that are joined
+  // concurrently. The components are sorted by decreasing size, with ties
+  // broken by the smallest view id, so that the first component is the
+  // largest. Views without any edges are not part of a component.
+  void GetConnectedComponents(
+      const int num_threads,
+      std::vector<std::unordered_set<ViewId> >* connected_components) const;
+
  private:
   // Templated method for disk I/O with cereal. This method tells cereal which
   // data members should be used when reading/writing to/from disk.
@@ -223,4 +223,63 @@ TEST(ViewGraph, ExtractSubgraphLarge) {
   }
 }
 
+TEST(ViewGraph, GetConnectedComponents) {
+  ViewGraph graph;
+  const TwoViewInfo info;
+  graph.AddEdge(0, 1, info);
+  graph.AddEdge(1, 2, info);
+  graph.AddEdge(3, 4, info);
+  graph.AddEdge(5, 6, info);
+  graph.AddEdge(6, 7, info);
+  graph.AddEdge(7, 8, info);
+
+  std::vector<std::unordered_set<ViewId> > components;
+  graph.GetConnectedComponents(1, &components);
+  ASSERT_EQ(components.size(), 3);
+  EXPECT_EQ(components[0], std::unordered_set<ViewId>({5, 6, 7, 8}));
+  EXPECT_EQ(components[1], std::unordered_set<ViewId>({0, 1, 2}));
+  EXPECT_EQ(components[2], std::unordered_set<ViewId>({3, 4}));
+
+  std::unordered_set<ViewId> largest_cc;
+  graph.GetLargestConnectedComponentIds(&largest_cc);
+  EXPECT_EQ(largest_cc, components[0]);
+}
+
+TEST(ViewGraph, GetConnectedComponentsMultithreaded) {
+  static const int kNumComponents = 20;
+  static const int kNumViewsPerComponent = 50;
+  static const int kNumEdgesPerComponent = 200;
+  static const int kNumThreads = 4;
+
+  // Create components of random edges over interleaved view ids. Each component
+  // is connected by a chain.
+  RandomNumberGenerator rng(68);
+  ViewGraph graph;
+  const TwoViewInfo info;
+  for (int c = 0; c < kNumComponents; c++) {
+    for (int i = 1; i < kNumViewsPerComponent; i++) {
+      graph.AddEdge((i - 1) * kNumComponents + c, i * kNumComponents + c, info);
+    }
+    for (int i = 0; i < kNumEdgesPerComponent; i++) {
+      const int view1 = rng.RandInt(0, kNumViewsPerComponent - 1);
+      const int view2 = rng.RandInt(0, kNumViewsPerComponent - 1);
+      if (view1 != view2) {
+        graph.AddEdge(
+            view1 * kNumComponents + c, view2 * kNumComponents + c, info);
+      }
+    }
+  }
+
+  std::vector<std::unordered_set<ViewId> > components;
+  graph.GetConnectedComponents(kNumThreads, &components);
+  ASSERT_EQ(components.size(), kNumComponents);
+  for (int c = 0; c < kNumComponents; c++) {
+    // Components of equal size are ordered by their smallest view id.
+    EXPECT_EQ(components[c].size(), kNumViewsPerComponent);
+    for (const ViewId view_id : components[c]) {
+      EXPECT_EQ(view_id % kNumComponents, c);
+    }
+  }
+}
+
 }  // namespace theia
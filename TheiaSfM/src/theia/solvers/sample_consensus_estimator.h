@@ -47,6 +47,7 @@
 #include "theia/solvers/mle_quality_measurement.h"
 #include "theia/solvers/quality_measurement.h"
 #include "theia/solvers/sampler.h"
+#include "theia/util/trace.h"
 
 namespace theia {
 
@@ -341,6 +342,8 @@ bool SampleConsensusEstimator<ModelEstimator>::Estimate(
       1.0 - pow(1.0 - pow(inlier_ratio, estimator_.SampleSize()),
                 summary->num_iterations);
 
+  IncrementTraceCounter("ransac_estimations");
+  IncrementTraceCounter("ransac_iterations", summary->num_iterations);
   return true;
 }
 
@@ -0,0 +1,225 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#ifndef THEIA_TEST_BENCHMARK_H_
+#define THEIA_TEST_BENCHMARK_H_
+
+#include <stdint.h>
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+
+// A small micro-benchmarking harness that follows the interface of Google
+// Benchmark so that benchmarks may be written in the familiar style:
+//
+//   void BM_MyKernel(theia::benchmark::State& state) {
+//     const Data data = GenerateData(state.range(0));
+//     while (state.KeepRunning()) {
+//       theia::benchmark::DoNotOptimize(MyKernel(data));
+//     }
+//     state.SetItemsProcessed(state.iterations());
+//   }
+//   BENCHMARK(BM_MyKernel)->Arg(100)->Arg(1000);
+//
+// Benchmarks are compiled into executables named <module>_benchmark with the
+// runner in theia/test/benchmark_main.cc, in the same manner as unit tests.
+// The runner reports the time and number of heap allocations per iteration as
+// well as the throughput if SetItemsProcessed is called.
+namespace theia {
+namespace benchmark {
+
+// The total number of heap allocations made through operator new so far. The
+// counter is maintained by the replacement operator new in benchmark_main.cc.
+int64_t NumAllocations();
+
+class State {
+ public:
+  State(const int64_t max_iterations, const std::vector<int64_t>& args)
+      : max_iterations_(max_iterations),
+        args_(args),
+        num_iterations_(0),
+        items_processed_(0),
+        started_(false),
+        timer_running_(false),
+        elapsed_(0),
+        allocations_at_start_(0),
+        num_allocations_(0) {}
+
+  // Returns true as long as the benchmark loop should continue. Timing starts
+  // with the first call, so any setup before the loop is not measured.
+  bool KeepRunning() {
+    if (!started_) {
+      started_ = true;
+      ResumeTiming();
+    }
+    if (num_iterations_ < max_iterations_) {
+      ++num_iterations_;
+      return true;
+    }
+    PauseTiming();
+    return false;
+  }
+
+  // Excludes the code between PauseTiming() and ResumeTiming() from the
+  // measurement, e.g. to regenerate input data inside of the loop.
+  void PauseTiming() {
+    if (timer_running_) {
+      elapsed_ += Clock::now() - start_;
+      num_allocations_ += NumAllocations() - allocations_at_start_;
+      timer_running_ = false;
+    }
+  }
+
+  void ResumeTiming() {
+    if (!timer_running_) {
+      allocations_at_start_ = NumAllocations();
+      start_ = Clock::now();
+      timer_running_ = true;
+    }
+  }
+
+  // The i-th argument passed with Benchmark::Arg or Benchmark::Args.
+  int64_t range(const int i = 0) const { return args_[i]; }
+
+  // The number of iterations that have been run so far.
+  int64_t iterations() const { return num_iterations_; }
+
+  // The number of items (e.g. solver calls, image pairs, residuals) processed
+  // by the benchmark. This is reported as throughput.
+  void SetItemsProcessed(const int64_t items) { items_processed_ = items; }
+  int64_t items_processed() const { return items_processed_; }
+
+  // An additional label that is printed next to the results.
+  void SetLabel(const std::string& label) { label_ = label; }
+  const std::string& label() const { return label_; }
+
+  double ElapsedTimeInSeconds() const {
+    return std::chrono::duration<double>(elapsed_).count();
+  }
+
+  // The number of heap allocations made while the timer was running.
+  int64_t num_allocations() const { return num_allocations_; }
+
+ private:
+  typedef std::chrono::high_resolution_clock Clock;
+
+  const int64_t max_iterations_;
+  const std::vector<int64_t> args_;
+  int64_t num_iterations_;
+  int64_t items_processed_;
+  std::string label_;
+
+  bool started_;
+  bool timer_running_;
+  Clock::time_point start_;
+  Clock::duration elapsed_;
+  int64_t allocations_at_start_;
+  int64_t num_allocations_;
+};
+
+typedef void (*BenchmarkFunction)(State&);
+
+// A registered benchmark and the list of argument sets it is run with.
+class Benchmark {
+ public:
+  Benchmark(const std::string& name, BenchmarkFunction function)
+      : name_(name), function_(function) {}
+
+  // Runs the benchmark with the single argument.
+  Benchmark* Arg(const int64_t arg) {
+    args_.emplace_back(1, arg);
+    return this;
+  }
+
+  // Runs the benchmark with multiple arguments.
+  Benchmark* Args(const std::vector<int64_t>& args) {
+    args_.emplace_back(args);
+    return this;
+  }
+
+  const std::string& name() const { return name_; }
+  BenchmarkFunction function() const { return function_; }
+  const std::vector<std::vector<int64_t> >& args() const { return args_; }
+
+ private:
+  const std::string name_;
+  const BenchmarkFunction function_;
+  std::vector<std::vector<int64_t> > args_;
+};
+
+// All benchmarks registered with the BENCHMARK macro.
+inline std::vector<Benchmark*>* RegisteredBenchmarks() {
+  static std::vector<Benchmark*> benchmarks;
+  return &benchmarks;
+}
+
+inline Benchmark* RegisterBenchmark(const char* name,
+                                    BenchmarkFunction function) {
+  Benchmark* benchmark = new Benchmark(name, function);
+  RegisteredBenchmarks()->push_back(benchmark);
+  return benchmark;
+}
+
+// Prevents the compiler from optimizing away the computation of value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T* sink;
+  sink = &value;
+#endif
+}
+
+// Forces all pending writes to memory.
+inline void ClobberMemory() {
+#if defined(__GNUC__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+}  // namespace benchmark
+}  // namespace theia
+
+#define THEIA_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define THEIA_BENCHMARK_CONCAT(a, b) THEIA_BENCHMARK_CONCAT_IMPL(a, b)
+
+// Registers a benchmark function. The returned Benchmark may be used to add
+// arguments.
+#define BENCHMARK(function)                                            \
+  static ::theia::benchmark::Benchmark* THEIA_BENCHMARK_CONCAT(        \
+      theia_benchmark_, __LINE__) =                                    \
+      ::theia::benchmark::RegisterBenchmark(#function, function)
+
+#endif  // THEIA_TEST_BENCHMARK_H_
@@ -0,0 +1,189 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "theia/test/benchmark.h"
+
+DEFINE_string(benchmark_filter, "",
+              "Only run benchmarks whose name contains this string.");
+DEFINE_double(benchmark_min_time, 0.5,
+              "Minimum time in seconds that each benchmark is run for.");
+
+namespace {
+
+std::atomic<int64_t> num_allocations(0);
+
+}  // namespace
+
+// Interposing the allocation functions lets the runner report the number of
+// heap allocations per iteration, which is often as telling as the time for
+// the small kernels that are benchmarked. With glibc the C allocation functions
+// are replaced so that allocations made by Eigen, which bypasses operator new,
+// are counted as well. Otherwise only operator new is counted (the array and
+// nothrow forms forward to it by default).
+#if defined(__GLIBC__)
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) __THROW {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size) __THROW {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size) __THROW {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+}  // extern "C"
+#else
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+#endif  // __GLIBC__
+
+namespace theia {
+namespace benchmark {
+
+int64_t NumAllocations() {
+  return num_allocations.load(std::memory_order_relaxed);
+}
+
+namespace {
+
+static const int64_t kMaxIterations = 1000000000;
+
+std::string BenchmarkName(const Benchmark& benchmark,
+                          const std::vector<int64_t>& args) {
+  std::string name = benchmark.name();
+  for (const int64_t arg : args) {
+    name += "/" + std::to_string(arg);
+  }
+  return name;
+}
+
+// Runs the benchmark with an increasing number of iterations until it runs for
+// at least the minimum time, similar to Google Benchmark.
+void RunBenchmark(const Benchmark& benchmark,
+                  const std::vector<int64_t>& args) {
+  int64_t num_iterations = 1;
+  while (true) {
+    State state(num_iterations, args);
+    benchmark.function()(state);
+    const double elapsed = state.ElapsedTimeInSeconds();
+
+    if (elapsed >= FLAGS_benchmark_min_time ||
+        num_iterations >= kMaxIterations) {
+      const double ns_per_iteration =
+          1e9 * elapsed / static_cast<double>(state.iterations());
+      const double allocations_per_iteration =
+          static_cast<double>(state.num_allocations()) /
+          static_cast<double>(state.iterations());
+      printf("%-56s %14.0f ns %12lld %12.4g",
+             BenchmarkName(benchmark, args).c_str(), ns_per_iteration,
+             static_cast<long long>(state.iterations()),
+             allocations_per_iteration);
+      if (state.items_processed() > 0) {
+        printf(" %14.4g items/s",
+               static_cast<double>(state.items_processed()) / elapsed);
+      }
+      if (!state.label().empty()) {
+        printf(" %s", state.label().c_str());
+      }
+      printf("\n");
+      fflush(stdout);
+      return;
+    }
+
+    // Predict the number of iterations needed to reach the minimum time with
+    // some margin, but do not grow by more than 10x at once.
+    const double multiplier =
+        elapsed > 0 ? 1.4 * FLAGS_benchmark_min_time / elapsed : 10.0;
+    num_iterations = std::min(
+        kMaxIterations,
+        std::max(num_iterations + 1,
+                 static_cast<int64_t>(num_iterations *
+                                      std::min(multiplier, 10.0))));
+  }
+}
+
+}  // namespace
+}  // namespace benchmark
+}  // namespace theia
+
+int main(int argc, char *argv[]) {
+  google::InitGoogleLogging(argv[0]);
+  THEIA_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+
+  printf("%-56s %17s %12s %12s\n", "Benchmark", "Time", "Iterations",
+         "Allocs/iter");
+  for (const theia::benchmark::Benchmark* benchmark :
+       *theia::benchmark::RegisteredBenchmarks()) {
+    if (benchmark->name().find(FLAGS_benchmark_filter) == std::string::npos) {
+      continue;
+    }
+
+    if (benchmark->args().empty()) {
+      theia::benchmark::RunBenchmark(*benchmark, std::vector<int64_t>());
+    }
+    for (const std::vector<int64_t>& args : benchmark->args()) {
+      theia::benchmark::RunBenchmark(*benchmark, args);
+    }
+  }
+  return 0;
+}
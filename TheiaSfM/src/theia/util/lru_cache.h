@@ -36,6 +36,7 @@
 #define THEIA_UTIL_LRU_CACHE_H_
 
 #include <glog/logging.h>
+#include <stdint.h>
 
 #include <limits>
 #include <list>
@@ -51,7 +52,8 @@ namespace theia {
 
 template <class KeyType, class ValueType>
 class LRUCache {
-  typedef std::list<KeyType> CacheList;
+  // Each entry of the list holds the key and the size in bytes of the entry.
+  typedef std::list<std::pair<KeyType, int64_t> > CacheList;
   typedef typename CacheList::iterator CacheListIterator;
 
  public:
@@ -71,13 +73,31 @@ class LRUCache {
   LRUCache(const std::function<ValueType(const KeyType&)>& fetch_entry,
            const int max_cache_entries)
       : fetch_entry_(fetch_entry),
-        max_cache_entries_(max_cache_entries) {
+        max_cache_entries_(max_cache_entries),
+        max_cache_size_in_bytes_(std::numeric_limits<int64_t>::max()),
+        cache_size_in_bytes_(0) {
     CHECK_GT(max_cache_entries_, 0)
         << "The maximum number of cache entries must be greater than 0.";
     cache_misses_ = 0;
     cache_hits_ = 0;
   }
 
+  // Same as above, but the cache additionally holds at most
+  // max_cache_size_in_bytes as measured by the entry_size_in_bytes function.
+  // Entries are evicted in least recently used order until the cache fits in
+  // the byte budget, except for the most recently inserted entry so that an
+  // entry larger than the budget is still cached on its own.
+  LRUCache(const std::function<ValueType(const KeyType&)>& fetch_entry,
+           const int max_cache_entries,
+           const std::function<int64_t(const ValueType&)>& entry_size_in_bytes,
+           const int64_t max_cache_size_in_bytes)
+      : LRUCache(fetch_entry, max_cache_entries) {
+    CHECK_GT(max_cache_size_in_bytes, 0)
+        << "The maximum cache size must be greater than 0.";
+    entry_size_in_bytes_ = entry_size_in_bytes;
+    max_cache_size_in_bytes_ = max_cache_size_in_bytes;
+  }
+
   // Fetch the entry and return the value. If the entry is in the cache then it
   // will be returned efficiently.
   virtual ValueType Fetch(const KeyType& key) {
@@ -113,6 +133,15 @@ class LRUCache {
     InsertIntoCache(key, value);
   }
 
+  // Removes all entries from the cache. Entries that are still referenced
+  // elsewhere (e.g., through a shared_ptr) remain valid.
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_entries_.clear();
+    cache_entries_map_.clear();
+    cache_size_in_bytes_ = 0;
+  }
+
   // Return if the key exists in the cache.
   virtual bool ExistsInCache(const KeyType& key) {
     return ContainsKey(cache_entries_map_, key);
@@ -123,6 +152,10 @@ class LRUCache {
   int Size() const { return cache_entries_map_.size(); }
   int NumCacheMisses() const { return cache_misses_; }
   int NumCacheHits() const { return cache_hits_; }
+  int64_t MaxCacheSizeInBytes() const { return max_cache_size_in_bytes_; }
+  // The size of all entries in the cache. This is only tracked if the entry
+  // size function was given to the constructor, otherwise it is 0.
+  int64_t CacheSizeInBytes() const { return cache_size_in_bytes_; }
 
  private:
   // Insert the key/value pair into the cache, evicting the oldest entry if
@@ -140,10 +173,20 @@ class LRUCache {
 
     // Insert the entry into the end of the accessor list (i.e. as the most
     // recently used).
-    CacheListIterator it = cache_entries_.insert(cache_entries_.end(), key);
+    const int64_t entry_size_in_bytes =
+        entry_size_in_bytes_ ? entry_size_in_bytes_(value) : 0;
+    CacheListIterator it = cache_entries_.insert(
+        cache_entries_.end(), std::make_pair(key, entry_size_in_bytes));
+    cache_size_in_bytes_ += entry_size_in_bytes;
 
     // Add the entry to the map.
     cache_entries_map_.insert(std::make_pair(key, std::make_pair(value, it)));
+
+    // Evict the oldest entries until the cache fits in the byte budget.
+    while (cache_size_in_bytes_ > max_cache_size_in_bytes_ &&
+           cache_entries_map_.size() > 1) {
+      EvictOldestEntry();
+    }
   }
 
   // Evicts the oldest entry from the cache.
@@ -155,7 +198,8 @@ class LRUCache {
     CHECK_GT(cache_entries_.size(), 0);
     CHECK_GT(cache_entries_map_.size(), 0);
 
-    const KeyType& evicted_key = *cache_entries_.begin();
+    const KeyType& evicted_key = cache_entries_.begin()->first;
+    cache_size_in_bytes_ -= cache_entries_.begin()->second;
     cache_entries_map_.erase(evicted_key);
     cache_entries_.pop_front();
   }
@@ -178,6 +222,12 @@ class LRUCache {
   // Maximum cache size.
   const int max_cache_entries_;
 
+  // Optional function that computes the size in bytes of a cache entry, and the
+  // maximum total size of all entries in the cache.
+  std::function<int64_t(const ValueType&)> entry_size_in_bytes_;
+  int64_t max_cache_size_in_bytes_;
+  int64_t cache_size_in_bytes_;
+
   // Some cache statistics.
   int cache_misses_, cache_hits_;
 
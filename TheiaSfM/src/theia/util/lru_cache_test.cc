@@ -134,4 +134,50 @@ TEST(LRUCache, FetchWithCacheMiss) {
   EXPECT_EQ(lru_cache.NumCacheHits(), 0);
 }
 
+// Uses the value itself as the size of the entry in bytes.
+int64_t EntrySize(const int& value) { return value; }
+
+TEST(LRUCache, EvictsEntriesToFitByteBudget) {
+  const int kMaxCacheSize = 5;
+  const int64_t kMaxCacheSizeInBytes = 40;
+  LRUCache<int, int> lru_cache(
+      CacheMissLookup, kMaxCacheSize, EntrySize, kMaxCacheSizeInBytes);
+  EXPECT_EQ(lru_cache.MaxCacheSizeInBytes(), kMaxCacheSizeInBytes);
+
+  // Entries 0, 2, and 4 have sizes 1, 14, and 7 which fit in the budget.
+  lru_cache.Fetch(0);
+  lru_cache.Fetch(2);
+  lru_cache.Fetch(4);
+  EXPECT_EQ(lru_cache.Size(), 3);
+  EXPECT_EQ(lru_cache.CacheSizeInBytes(), 22);
+
+  // Entry 5 has size 29 so the oldest entry must be evicted.
+  lru_cache.Fetch(0);
+  lru_cache.Fetch(5);
+  EXPECT_FALSE(lru_cache.ExistsInCache(2));
+  EXPECT_TRUE(lru_cache.ExistsInCache(0));
+  EXPECT_EQ(lru_cache.CacheSizeInBytes(), 37);
+
+  // An entry larger than the budget evicts everything else but is kept.
+  lru_cache.Fetch(3);
+  EXPECT_EQ(lru_cache.Size(), 1);
+  EXPECT_TRUE(lru_cache.ExistsInCache(3));
+  EXPECT_EQ(lru_cache.CacheSizeInBytes(), 101);
+}
+
+TEST(LRUCache, Clear) {
+  const int kMaxCacheSize = 5;
+  LRUCache<int, int> lru_cache(CacheMissLookup, kMaxCacheSize, EntrySize, 100);
+  lru_cache.Fetch(0);
+  lru_cache.Fetch(1);
+  lru_cache.Clear();
+  EXPECT_EQ(lru_cache.Size(), 0);
+  EXPECT_EQ(lru_cache.CacheSizeInBytes(), 0);
+  EXPECT_FALSE(lru_cache.ExistsInCache(0));
+
+  // Fetching after clearing is a cache miss.
+  EXPECT_EQ(lru_cache.Fetch(0), FindOrDie(cache_lookup, 0));
+  EXPECT_EQ(lru_cache.NumCacheMisses(), 3);
+}
+
 }  // namespace theia
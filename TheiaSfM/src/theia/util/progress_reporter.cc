@@ -0,0 +1,157 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/util/progress_reporter.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <mutex>  // NOLINT
+#include <string>
+
+namespace theia {
+
+ProgressReporter::ProgressReporter() : ProgressReporter(nullptr) {}
+
+ProgressReporter::ProgressReporter(
+    const std::shared_ptr<ProgressReporter>& parent)
+    : parent_(parent),
+      cancelled_(false),
+      num_completed_(0),
+      has_callback_(false),
+      next_callback_time_in_ns_(0),
+      min_callback_interval_(0),
+      num_total_(0) {}
+
+void ProgressReporter::SetCallback(const Callback& callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  callback_ = callback;
+  has_callback_ = static_cast<bool>(callback_);
+}
+
+void ProgressReporter::SetMinCallbackIntervalInSeconds(const double interval) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  min_callback_interval_ = interval;
+}
+
+void ProgressReporter::BeginStage(const std::string& stage,
+                                  const int64_t num_total) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stage_ = stage;
+    step_.clear();
+    num_total_ = num_total;
+    num_completed_ = 0;
+    timer_.Reset();
+  }
+  MaybeRunCallback(true);
+}
+
+void ProgressReporter::SetStep(const std::string& step) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    step_ = step;
+  }
+  MaybeRunCallback(true);
+}
+
+void ProgressReporter::Increment(const int64_t num_completed) {
+  num_completed_ += num_completed;
+  if (!has_callback_.load(std::memory_order_relaxed) ||
+      NowInNanoseconds() <
+          next_callback_time_in_ns_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  MaybeRunCallback(false);
+}
+
+ProgressReporter::Progress ProgressReporter::GetProgress() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetProgressLocked();
+}
+
+void ProgressReporter::Cancel() {
+  cancelled_ = true;
+}
+
+void ProgressReporter::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cancelled_ = false;
+  stage_.clear();
+  step_.clear();
+  num_total_ = 0;
+  num_completed_ = 0;
+  next_callback_time_in_ns_ = 0;
+  timer_.Reset();
+}
+
+ProgressReporter::Progress ProgressReporter::GetProgressLocked() {
+  Progress progress;
+  progress.stage = stage_;
+  progress.step = step_;
+  progress.num_completed = num_completed_.load();
+  progress.num_total = num_total_;
+  progress.elapsed_time_in_seconds = timer_.ElapsedTimeInSeconds();
+  if (progress.num_total > 0 && progress.num_completed > 0) {
+    const int64_t num_remaining =
+        std::max<int64_t>(progress.num_total - progress.num_completed, 0);
+    progress.estimated_remaining_time_in_seconds =
+        progress.elapsed_time_in_seconds * num_remaining /
+        progress.num_completed;
+  }
+  return progress;
+}
+
+void ProgressReporter::MaybeRunCallback(const bool force) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!callback_) {
+    return;
+  }
+
+  const int64_t time = NowInNanoseconds();
+  if (!force && time < next_callback_time_in_ns_) {
+    return;
+  }
+  next_callback_time_in_ns_ =
+      time + static_cast<int64_t>(min_callback_interval_ * 1e9);
+  callback_(GetProgressLocked());
+}
+
+int64_t ProgressReporter::NowInNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace theia
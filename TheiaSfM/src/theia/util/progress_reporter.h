@@ -0,0 +1,164 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#ifndef THEIA_UTIL_PROGRESS_REPORTER_H_
+#define THEIA_UTIL_PROGRESS_REPORTER_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "theia/util/timer.h"
+#include "theia/util/util.h"
+
+namespace theia {
+
+// Reports the progress of long-running stages (feature extraction, matching,
+// reconstruction estimation, bundle adjustment) and allows them to be
+// cancelled from another thread. A single reporter is shared by all stages
+// through the std::shared_ptr<ProgressReporter> member of their options, e.g.:
+//
+//   std::shared_ptr<ProgressReporter> reporter(new ProgressReporter);
+//   reporter->SetCallback([](const ProgressReporter::Progress& progress) {
+//     LOG(INFO) << progress.stage << ": " << progress.num_completed << " / "
+//               << progress.num_total;
+//   });
+//   options.progress_reporter = reporter;
+//   ...
+//   // From any thread:
+//   reporter->Cancel();
+//
+// A stage is a sequence of work items (e.g. image pairs to match). Each stage
+// may additionally describe the step it is currently running (e.g. the current
+// bundle adjustment iteration) without affecting the count of work items.
+// Cancellation is cooperative: each stage checks IsCancelled() between work
+// items and returns early with a failure. Stages that run concurrently may use
+// child reporters that keep their own progress but are cancelled together with
+// their parent.
+class ProgressReporter {
+ public:
+  struct Progress {
+    std::string stage;
+    std::string step;
+    int64_t num_completed = 0;
+    // The total number of work items, or 0 if unknown.
+    int64_t num_total = 0;
+    double elapsed_time_in_seconds = 0;
+    // Estimated from the rate at which work items have completed so far. This
+    // is negative if it cannot be estimated yet.
+    double estimated_remaining_time_in_seconds = -1.0;
+  };
+
+  typedef std::function<void(const Progress& progress)> Callback;
+
+  ProgressReporter();
+
+  // Creates a reporter that is also cancelled when the parent is cancelled.
+  // Its progress is not forwarded to the parent.
+  explicit ProgressReporter(const std::shared_ptr<ProgressReporter>& parent);
+
+  // The callback is called from whichever thread reports progress, so it must
+  // be thread-safe. Calls to the callback are serialized. The callback may call
+  // Cancel() but no other methods of the reporter.
+  void SetCallback(const Callback& callback);
+
+  // Progress updates within this many seconds of the last callback are not
+  // reported, except for the start of a new stage or step. This limits the
+  // overhead of very fine-grained stages.
+  void SetMinCallbackIntervalInSeconds(const double interval);
+
+  // Starts a new stage with the given number of work items and resets the
+  // stage timer.
+  void BeginStage(const std::string& stage, const int64_t num_total);
+
+  // Describes the step that is currently running within the stage.
+  void SetStep(const std::string& step);
+
+  // Marks work items of the current stage as completed.
+  void Increment(const int64_t num_completed = 1);
+
+  // Returns a snapshot of the current progress.
+  Progress GetProgress();
+
+  // Requests that all stages stop as soon as possible. This may be called from
+  // any thread. The request stays in effect until Reset() is called.
+  void Cancel();
+
+  // Clears a cancellation request and the current stage so that the reporter
+  // can be reused for another run.
+  void Reset();
+
+  bool IsCancelled() const {
+    return cancelled_.load() || (parent_ != nullptr && parent_->IsCancelled());
+  }
+
+ private:
+  // Fills in the progress of the current stage. Must be called with the mutex
+  // held.
+  Progress GetProgressLocked();
+
+  // Calls the callback if it is set. If force is false the callback is only
+  // called if the minimum interval has elapsed since the last call.
+  void MaybeRunCallback(const bool force);
+
+  // Returns the time of a monotonic clock in nanoseconds.
+  static int64_t NowInNanoseconds();
+
+  const std::shared_ptr<ProgressReporter> parent_;
+  std::atomic<bool> cancelled_;
+  std::atomic<int64_t> num_completed_;
+
+  // Increment() reads these without taking the mutex so that work items that
+  // are not reported do not contend on it.
+  std::atomic<bool> has_callback_;
+  std::atomic<int64_t> next_callback_time_in_ns_;
+
+  std::mutex mutex_;
+  Callback callback_;
+  double min_callback_interval_;
+  std::string stage_;
+  std::string step_;
+  int64_t num_total_;
+  Timer timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProgressReporter);
+};
+
+}  // namespace theia
+
+#endif  // THEIA_UTIL_PROGRESS_REPORTER_H_
@@ -0,0 +1,158 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/util/progress_reporter.h"
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace theia {
+
+TEST(ProgressReporter, CountsWorkItemsOfTheCurrentStage) {
+  ProgressReporter reporter;
+  reporter.BeginStage("Matching", 10);
+  reporter.Increment();
+  reporter.Increment(4);
+
+  ProgressReporter::Progress progress = reporter.GetProgress();
+  EXPECT_EQ(progress.stage, "Matching");
+  EXPECT_EQ(progress.num_completed, 5);
+  EXPECT_EQ(progress.num_total, 10);
+  EXPECT_GE(progress.estimated_remaining_time_in_seconds, 0);
+
+  // Starting a new stage resets the count.
+  reporter.BeginStage("Estimation", 0);
+  reporter.SetStep("Rotations");
+  progress = reporter.GetProgress();
+  EXPECT_EQ(progress.stage, "Estimation");
+  EXPECT_EQ(progress.step, "Rotations");
+  EXPECT_EQ(progress.num_completed, 0);
+  // The remaining time is unknown without a total.
+  EXPECT_LT(progress.estimated_remaining_time_in_seconds, 0);
+}
+
+TEST(ProgressReporter, CallbacksAreThrottled) {
+  ProgressReporter reporter;
+  int num_callbacks = 0;
+  reporter.SetCallback(
+      [&num_callbacks](const ProgressReporter::Progress& progress) {
+        ++num_callbacks;
+      });
+
+  reporter.BeginStage("Matching", 100);
+  EXPECT_EQ(num_callbacks, 1);
+  for (int i = 0; i < 100; i++) {
+    reporter.Increment();
+  }
+  EXPECT_EQ(num_callbacks, 101);
+
+  // With a long interval only the start of stages and steps are reported.
+  reporter.SetMinCallbackIntervalInSeconds(1000.0);
+  reporter.BeginStage("Matching", 100);
+  for (int i = 0; i < 100; i++) {
+    reporter.Increment();
+  }
+  reporter.SetStep("Verification");
+  EXPECT_EQ(num_callbacks, 103);
+}
+
+TEST(ProgressReporter, CancelFromAnotherThread) {
+  static const int kNumThreads = 4;
+  static const int kNumIncrementsPerThread = 1000;
+
+  ProgressReporter reporter;
+  reporter.BeginStage("Matching", kNumThreads * kNumIncrementsPerThread);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&reporter]() {
+      for (int j = 0; j < kNumIncrementsPerThread; j++) {
+        reporter.Increment();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(reporter.GetProgress().num_completed,
+            kNumThreads * kNumIncrementsPerThread);
+
+  EXPECT_FALSE(reporter.IsCancelled());
+  std::thread cancel_thread([&reporter]() { reporter.Cancel(); });
+  cancel_thread.join();
+  EXPECT_TRUE(reporter.IsCancelled());
+}
+
+TEST(ProgressReporter, ChildIsCancelledWithParent) {
+  std::shared_ptr<ProgressReporter> parent(new ProgressReporter);
+  ProgressReporter child(parent);
+  child.BeginStage("Estimation", 10);
+  child.Increment(2);
+  // The progress of the child is its own.
+  EXPECT_EQ(child.GetProgress().num_completed, 2);
+  EXPECT_EQ(parent->GetProgress().num_completed, 0);
+
+  EXPECT_FALSE(child.IsCancelled());
+  parent->Cancel();
+  EXPECT_TRUE(child.IsCancelled());
+
+  // Cancelling a child does not cancel the parent.
+  parent->Reset();
+  ProgressReporter other_child(parent);
+  other_child.Cancel();
+  EXPECT_TRUE(other_child.IsCancelled());
+  EXPECT_FALSE(parent->IsCancelled());
+  EXPECT_FALSE(child.IsCancelled());
+}
+
+TEST(ProgressReporter, ResetClearsCancellation) {
+  ProgressReporter reporter;
+  reporter.BeginStage("Matching", 10);
+  reporter.Increment(3);
+  reporter.Cancel();
+  // Cancellation persists across stages until the reporter is reset.
+  reporter.BeginStage("Estimation", 0);
+  EXPECT_TRUE(reporter.IsCancelled());
+
+  reporter.Reset();
+  EXPECT_FALSE(reporter.IsCancelled());
+  const ProgressReporter::Progress progress = reporter.GetProgress();
+  EXPECT_TRUE(progress.stage.empty());
+  EXPECT_EQ(progress.num_completed, 0);
+}
+
+}  // namespace theia
@@ -122,4 +122,14 @@ Eigen::Vector4d RandomNumberGenerator::RandVector4d() {
   return RandVector4d(-1.0, 1.0);
 }
 
+unsigned DeriveSeed(const unsigned base_seed, const uint64_t task_index) {
+  // The SplitMix64 finalizer decorrelates seeds of consecutive tasks.
+  uint64_t z = (static_cast<uint64_t>(base_seed) << 32) ^ task_index;
+  z += 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z = z ^ (z >> 31);
+  return static_cast<unsigned>(z ^ (z >> 32));
+}
+
 }  // namespace theia
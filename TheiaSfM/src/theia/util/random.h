@@ -36,6 +36,7 @@
 #define THEIA_UTIL_RANDOM_H_
 
 #include <Eigen/Core>
+#include <stdint.h>
 #include <random>
 
 namespace theia {
@@ -43,6 +44,11 @@ namespace theia {
 // A wrapper around the c++11 random generator utilities. This allows for a
 // thread-safe random number generator that may be easily instantiated and
 // passed around as an object.
+//
+// NOTE: All instances draw from a single generator per thread, so constructing
+// or seeding an instance reseeds the generator of the calling thread. A task
+// that creates a seeded instance when it starts (see DeriveSeed below) draws
+// the same sequence regardless of which thread runs it.
 class RandomNumberGenerator {
  public:
   // Creates the random number generator using the current time as the seed.
@@ -97,6 +103,12 @@ class RandomNumberGenerator {
 
 };
 
+// Returns the seed of an independent random stream for a task, derived from a
+// base seed and a stable index of the task (e.g. the index of an image pair or
+// of an iteration). Parallel tasks seeded this way draw random numbers that do
+// not depend on the number of threads or on the order in which tasks run.
+unsigned DeriveSeed(const unsigned base_seed, const uint64_t task_index);
+
 }  // namespace theia
 
 #endif  // THEIA_UTIL_RANDOM_H_
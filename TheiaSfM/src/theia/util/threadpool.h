@@ -63,8 +63,10 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <future>
@@ -132,6 +134,57 @@ auto ThreadPool::Add(F&& f, Args&& ... args)
   return res;
 }
 
+// Splits the items [0, num_items) into num_blocks contiguous blocks of nearly
+// equal size and calls function(block, start, end) for each block, where the
+// block covers the items [start, end). Blocks may be empty if there are more
+// blocks than items. The blocks run on the thread pool if one is given and
+// sequentially in block order otherwise. Returns once all blocks are finished.
+template <typename Function>
+void ParallelFor(ThreadPool* pool,
+                 const int num_blocks,
+                 const int num_items,
+                 const Function& function) {
+  CHECK_GE(num_blocks, 1);
+  CHECK_GE(num_items, 0);
+  const auto block_start = [num_blocks, num_items](const int block) {
+    return static_cast<int>((static_cast<int64_t>(num_items) * block) /
+                            num_blocks);
+  };
+  if (pool == nullptr || num_blocks == 1) {
+    for (int i = 0; i < num_blocks; i++) {
+      function(i, block_start(i), block_start(i + 1));
+    }
+    return;
+  }
+
+  std::vector<std::future<void> > futures;
+  futures.reserve(num_blocks);
+  for (int i = 0; i < num_blocks; i++) {
+    futures.emplace_back(
+        pool->Add(std::cref(function), i, block_start(i), block_start(i + 1)));
+  }
+  for (auto& future : futures) {
+    future.wait();
+  }
+}
+
+// Same as above, but runs the blocks on a temporary thread pool with at most
+// num_threads threads. No threads are created if num_threads or num_blocks is
+// 1.
+template <typename Function>
+void ParallelFor(const int num_threads,
+                 const int num_blocks,
+                 const int num_items,
+                 const Function& function) {
+  CHECK_GE(num_threads, 1);
+  if (num_threads == 1 || num_blocks == 1) {
+    ParallelFor(nullptr, num_blocks, num_items, function);
+    return;
+  }
+  ThreadPool pool(std::min(num_threads, num_blocks));
+  ParallelFor(&pool, num_blocks, num_items, function);
+}
+
 }  // namespace theia
 
 #endif  // THEIA_UTIL_THREADPOOL_H_
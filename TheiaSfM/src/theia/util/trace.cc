@@ -0,0 +1,303 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/util/trace.h"
+
+#include <glog/logging.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "theia/util/map_util.h"
+#include "theia/util/stringprintf.h"
+
+namespace theia {
+
+namespace internal {
+std::atomic<bool> tracing_enabled(false);
+}  // namespace internal
+
+namespace {
+
+struct SpanEvent {
+  const char* name;
+  // The names of all enclosing spans on the same thread and this span,
+  // separated by '/'.
+  std::string path;
+  int thread_id;
+  int64_t start_time_in_microseconds;
+  int64_t duration_in_microseconds;
+};
+
+struct CounterEvent {
+  const char* name;
+  int64_t time_in_microseconds;
+  int64_t value;
+};
+
+struct TraceData {
+  std::mutex mutex;
+  std::vector<SpanEvent> spans;
+  std::vector<CounterEvent> counter_events;
+  std::unordered_map<std::string, int64_t> counters;
+};
+
+// The trace data is intentionally leaked so that spans that end during static
+// destruction remain valid.
+TraceData* GetTraceData() {
+  static TraceData* trace_data = new TraceData();
+  return trace_data;
+}
+
+int64_t SteadyClockInMicroseconds() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// All trace times are relative to the time the trace was last cleared.
+std::atomic<int64_t> trace_start_time(SteadyClockInMicroseconds());
+
+int64_t TraceTimeInMicroseconds() {
+  return SteadyClockInMicroseconds() - trace_start_time.load();
+}
+
+// Small sequential ids are easier to read in trace viewers than the hashes of
+// std::thread::id.
+std::atomic<int> next_thread_id(0);
+thread_local const int thread_id = next_thread_id++;
+
+// The spans that are currently alive on this thread, outermost first.
+thread_local std::vector<const char*> span_stack;
+
+std::string EscapeJsonString(const char* str) {
+  std::string escaped;
+  for (; *str != '\0'; ++str) {
+    if (*str == '"' || *str == '\\') {
+      escaped.push_back('\\');
+    }
+    escaped.push_back(*str);
+  }
+  return escaped;
+}
+
+}  // namespace
+
+void EnableTracing(const bool enable) {
+  internal::tracing_enabled.store(enable);
+}
+
+void ClearTrace() {
+  TraceData* trace_data = GetTraceData();
+  std::lock_guard<std::mutex> lock(trace_data->mutex);
+  trace_data->spans.clear();
+  trace_data->counter_events.clear();
+  trace_data->counters.clear();
+  trace_start_time.store(SteadyClockInMicroseconds());
+}
+
+void ScopedTraceSpan::Begin(const char* name) {
+  name_ = name;
+  span_stack.emplace_back(name);
+  start_time_in_microseconds_ = TraceTimeInMicroseconds();
+}
+
+void ScopedTraceSpan::End() {
+  SpanEvent span;
+  span.duration_in_microseconds =
+      TraceTimeInMicroseconds() - start_time_in_microseconds_;
+  span.name = name_;
+  span.thread_id = thread_id;
+  span.start_time_in_microseconds = start_time_in_microseconds_;
+  for (int i = 0; i < span_stack.size(); i++) {
+    if (i > 0) {
+      span.path.push_back('/');
+    }
+    span.path.append(span_stack[i]);
+  }
+  DCHECK_EQ(span_stack.back(), name_) << "Trace spans must be nested.";
+  span_stack.pop_back();
+
+  TraceData* trace_data = GetTraceData();
+  std::lock_guard<std::mutex> lock(trace_data->mutex);
+  trace_data->spans.emplace_back(std::move(span));
+}
+
+void IncrementTraceCounter(const char* name, const int64_t value) {
+  if (!IsTracingEnabled()) {
+    return;
+  }
+
+  TraceData* trace_data = GetTraceData();
+  const int64_t time = TraceTimeInMicroseconds();
+  std::lock_guard<std::mutex> lock(trace_data->mutex);
+  int64_t& counter = trace_data->counters[name];
+  counter += value;
+  trace_data->counter_events.push_back({name, time, counter});
+}
+
+int64_t GetTraceCounter(const std::string& name) {
+  TraceData* trace_data = GetTraceData();
+  std::lock_guard<std::mutex> lock(trace_data->mutex);
+  return FindWithDefault(trace_data->counters, name, 0);
+}
+
+bool WriteChromeTrace(const std::string& output_file) {
+  FILE* file = fopen(output_file.c_str(), "w");
+  if (file == nullptr) {
+    LOG(ERROR) << "Could not open the trace file " << output_file
+               << " for writing.";
+    return false;
+  }
+
+  TraceData* trace_data = GetTraceData();
+  std::lock_guard<std::mutex> lock(trace_data->mutex);
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first_event = true;
+  for (const SpanEvent& span : trace_data->spans) {
+    fprintf(file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"theia\",\"ph\":\"X\",\"pid\":0,"
+            "\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+            first_event ? "" : ",",
+            EscapeJsonString(span.name).c_str(),
+            span.thread_id,
+            static_cast<long long>(span.start_time_in_microseconds),
+            static_cast<long long>(span.duration_in_microseconds));
+    first_event = false;
+  }
+  for (const CounterEvent& counter : trace_data->counter_events) {
+    const std::string name = EscapeJsonString(counter.name);
+    fprintf(file,
+            "%s\n{\"name\":\"%s\",\"cat\":\"theia\",\"ph\":\"C\",\"pid\":0,"
+            "\"ts\":%lld,\"args\":{\"%s\":%lld}}",
+            first_event ? "" : ",",
+            name.c_str(),
+            static_cast<long long>(counter.time_in_microseconds),
+            name.c_str(),
+            static_cast<long long>(counter.value));
+    first_event = false;
+  }
+  fprintf(file, "\n]}\n");
+  const bool success = ferror(file) == 0;
+  fclose(file);
+  return success;
+}
+
+std::string TraceSummary() {
+  struct SpanStatistics {
+    int64_t first_start_time_in_microseconds;
+    int depth = 0;
+    int count = 0;
+    int64_t total_time_in_microseconds = 0;
+  };
+
+  TraceData* trace_data = GetTraceData();
+  std::lock_guard<std::mutex> lock(trace_data->mutex);
+
+  // Aggregate the spans by their path so that the same stage called from
+  // different parents is reported separately.
+  std::unordered_map<std::string, SpanStatistics> statistics;
+  for (const SpanEvent& span : trace_data->spans) {
+    SpanStatistics& span_statistics = statistics[span.path];
+    if (span_statistics.count == 0) {
+      span_statistics.first_start_time_in_microseconds =
+          span.start_time_in_microseconds;
+      span_statistics.depth =
+          std::count(span.path.begin(), span.path.end(), '/');
+    }
+    span_statistics.first_start_time_in_microseconds =
+        std::min(span_statistics.first_start_time_in_microseconds,
+                 span.start_time_in_microseconds);
+    ++span_statistics.count;
+    span_statistics.total_time_in_microseconds += span.duration_in_microseconds;
+  }
+
+  // Output the paths in the order that they were first entered, which
+  // corresponds to the order of the pipeline stages. Parents always start
+  // before their children so the nesting is preserved.
+  std::vector<std::pair<std::string, SpanStatistics> > sorted_statistics(
+      statistics.begin(), statistics.end());
+  std::sort(sorted_statistics.begin(),
+            sorted_statistics.end(),
+            [](const std::pair<std::string, SpanStatistics>& lhs,
+               const std::pair<std::string, SpanStatistics>& rhs) {
+              if (lhs.second.first_start_time_in_microseconds !=
+                  rhs.second.first_start_time_in_microseconds) {
+                return lhs.second.first_start_time_in_microseconds <
+                       rhs.second.first_start_time_in_microseconds;
+              }
+              return lhs.second.depth < rhs.second.depth;
+            });
+
+  std::string summary = StringPrintf(
+      "Trace summary:\n%-56s %10s %14s %14s\n", "Span", "Count", "Total (s)",
+      "Mean (ms)");
+  for (const auto& entry : sorted_statistics) {
+    const SpanStatistics& span_statistics = entry.second;
+    const std::string::size_type name_start = entry.first.find_last_of('/');
+    const std::string name =
+        std::string(2 * span_statistics.depth, ' ') +
+        (name_start == std::string::npos ? entry.first
+                                         : entry.first.substr(name_start + 1));
+    summary += StringPrintf(
+        "%-56s %10d %14.3f %14.3f\n",
+        name.c_str(),
+        span_statistics.count,
+        span_statistics.total_time_in_microseconds * 1e-6,
+        span_statistics.total_time_in_microseconds * 1e-3 /
+            span_statistics.count);
+  }
+
+  std::vector<std::pair<std::string, int64_t> > sorted_counters(
+      trace_data->counters.begin(), trace_data->counters.end());
+  std::sort(sorted_counters.begin(), sorted_counters.end());
+  if (!sorted_counters.empty()) {
+    summary += StringPrintf("%-56s %10s\n", "Counter", "Value");
+  }
+  for (const auto& counter : sorted_counters) {
+    summary += StringPrintf("%-56s %10lld\n",
+                            counter.first.c_str(),
+                            static_cast<long long>(counter.second));
+  }
+  return summary;
+}
+
+}  // namespace theia
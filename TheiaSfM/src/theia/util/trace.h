@@ -0,0 +1,128 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#ifndef THEIA_UTIL_TRACE_H_
+#define THEIA_UTIL_TRACE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#include "theia/util/util.h"
+
+namespace theia {
+
+// A lightweight facility for tracing where time is spent in the pipeline.
+// Stages are instrumented with nested spans and named counters, e.g.:
+//
+//   void MatchImages() {
+//     ScopedTraceSpan span("MatchImages");
+//     ...
+//     IncrementTraceCounter("image_pairs_matched", num_pairs);
+//   }
+//
+// Tracing is disabled by default. When disabled, spans and counters only cost
+// a single relaxed atomic load so instrumentation may be left in hot code. When
+// enabled, each span records its thread, start time, duration, and the path of
+// the spans that enclose it on the same thread. The recorded data may be
+// written in the Chrome trace event format (viewable with chrome://tracing or
+// Perfetto) or summarized as a flat table of per-stage times and counters.
+//
+// Span and counter names must be string literals (or otherwise outlive the
+// trace) since only the pointers are stored.
+
+namespace internal {
+extern std::atomic<bool> tracing_enabled;
+}  // namespace internal
+
+// Enables or disables the recording of spans and counters. Previously recorded
+// data is kept until ClearTrace() is called.
+void EnableTracing(const bool enable);
+
+inline bool IsTracingEnabled() {
+  return internal::tracing_enabled.load(std::memory_order_relaxed);
+}
+
+// Removes all recorded spans and counters and resets the trace clock.
+void ClearTrace();
+
+// Records the lifetime of the object as a span with the given name. Spans that
+// are created while another span is alive on the same thread are nested inside
+// of it.
+class ScopedTraceSpan {
+ public:
+  explicit ScopedTraceSpan(const char* name) : name_(nullptr) {
+    if (IsTracingEnabled()) {
+      Begin(name);
+    }
+  }
+
+  ~ScopedTraceSpan() {
+    if (name_ != nullptr) {
+      End();
+    }
+  }
+
+ private:
+  void Begin(const char* name);
+  void End();
+
+  // The name is only set if tracing was enabled when the span began.
+  const char* name_;
+  int64_t start_time_in_microseconds_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTraceSpan);
+};
+
+// Adds the value to the named counter, e.g. the number of RANSAC iterations or
+// bundle adjustment residuals.
+void IncrementTraceCounter(const char* name, const int64_t value = 1);
+
+// Returns the current value of the named counter.
+int64_t GetTraceCounter(const std::string& name);
+
+// Writes all recorded spans and counters to the file in the Chrome trace event
+// JSON format. Returns false if the file could not be written.
+bool WriteChromeTrace(const std::string& output_file);
+
+// Returns a human readable table with the number of calls, the total time, and
+// the mean time of each span (aggregated by its nesting path) followed by the
+// final value of every counter. The times of spans that ran concurrently on
+// several threads are summed.
+std::string TraceSummary();
+
+}  // namespace theia
+
+#endif  // THEIA_UTIL_TRACE_H_
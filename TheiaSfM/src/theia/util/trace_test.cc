@@ -0,0 +1,112 @@
+// Copyright (C) 2017 The Regents of the University of California (Regents).
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of The Regents or University of California nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Chris Sweeney (sweeney.chris.m@gmail.com)
+
+
+#include "theia/util/trace.h"
+
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace theia {
+
+TEST(Trace, NothingIsRecordedWhenDisabled) {
+  EnableTracing(false);
+  ClearTrace();
+  {
+    ScopedTraceSpan span("Disabled");
+    IncrementTraceCounter("disabled_counter", 5);
+  }
+  EXPECT_EQ(GetTraceCounter("disabled_counter"), 0);
+  EXPECT_EQ(TraceSummary().find("Disabled"), std::string::npos);
+}
+
+TEST(Trace, NestedSpansAreSummarizedByPath) {
+  EnableTracing(true);
+  ClearTrace();
+  {
+    ScopedTraceSpan outer_span("Outer");
+    for (int i = 0; i < 3; i++) {
+      ScopedTraceSpan inner_span("Inner");
+    }
+  }
+  EnableTracing(false);
+
+  const std::string summary = TraceSummary();
+  const std::string::size_type outer_position = summary.find("\nOuter ");
+  const std::string::size_type inner_position = summary.find("\n  Inner ");
+  ASSERT_NE(outer_position, std::string::npos) << summary;
+  ASSERT_NE(inner_position, std::string::npos) << summary;
+  EXPECT_LT(outer_position, inner_position);
+
+  // The inner span is called 3 times.
+  const std::string inner_line =
+      summary.substr(inner_position + 1,
+                     summary.find('\n', inner_position + 1) - inner_position);
+  EXPECT_NE(inner_line.find(" 3 "), std::string::npos) << inner_line;
+}
+
+TEST(Trace, CountersAreSummedAcrossThreads) {
+  static const int kNumThreads = 4;
+  static const int kNumIncrements = 1000;
+
+  EnableTracing(true);
+  ClearTrace();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([]() {
+      ScopedTraceSpan span("Worker");
+      for (int j = 0; j < kNumIncrements; j++) {
+        IncrementTraceCounter("increments");
+      }
+      IncrementTraceCounter("values", 10);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EnableTracing(false);
+
+  EXPECT_EQ(GetTraceCounter("increments"), kNumThreads * kNumIncrements);
+  EXPECT_EQ(GetTraceCounter("values"), kNumThreads * 10);
+  EXPECT_NE(TraceSummary().find("increments"), std::string::npos);
+
+  // Clearing the trace resets the counters.
+  ClearTrace();
+  EXPECT_EQ(GetTraceCounter("increments"), 0);
+}
+
+}  // namespace theia